@@ -0,0 +1,408 @@
+/*
+	===============================================================
+
+	SHADERMAP PLUGIN HALF BATCH SOURCE FILE
+
+	Converts spans of 16 bit half floats to 32 bit floats and back.
+	Map and filter pixels are stored as half floats. Converting a
+	whole row to floats, working on the floats, then converting
+	the row back is much faster than doing arithmetic on
+	half_float::half values one channel at a time.
+
+	Include this source code file in a map or filter plugin after
+	the plugin core file. #include "../../../common/plugin_half_batch.cpp"
+	It does not require half.hpp. A half_float::half is stored as
+	16 bits and an array of them can be cast to unsigned short*.
+
+	The conversion path is selected the first time a function is
+	called:
+
+	F16C	- 8 values per instruction. Most x86 CPUs since 2012.
+	SSE2	- 4 values per step using integer and float math.
+	Scalar	- Non x86 builds.
+
+	Every path rounds float to half to nearest even and gives the
+	same bits as the others, including denormals and infinity. A
+	float NaN becomes the quiet half NaN 0x7E00 with its sign on
+	every path, so its payload is not kept. A half NaN keeps its
+	payload as a float and is made quiet, as F16C does. half.hpp uses the rounding set by
+	HALF_ROUND_STYLE which defaults to round toward zero; define
+	HALF_ROUND_STYLE 1 before including half.hpp to make it match.
+
+
+	SHADERMAP SDK LICENSE
+
+	The ShaderMap SDK is released under The MIT License (MIT)
+	http://opensource.org/licenses/MIT
+
+	Copyright (c) 2007-2019 Rendering Systems Inc.
+
+	Permission is hereby granted, free of charge, to any person
+	obtaining a copy of this software and associated documentation
+	files (the "Software"), to deal	in the Software without
+	restriction, including without limitation the rights to use,
+	copy, modify, merge, publish, distribute, sublicense, and/or
+	sell copies of the Software, and to permit persons to whom the
+	Software is	furnished to do so, subject to the following
+	conditions:
+
+	The above copyright notice and this permission notice shall be
+	included in	all copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+	OF MERCHANTABILITY,	FITNESS FOR A PARTICULAR PURPOSE AND
+	NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+	OTHER DEALINGS IN THE SOFTWARE.
+
+	Developed by: Neil Kemp at Rendering Systems Inc.
+
+	Online:		http://shadermap.com
+	Corporate:	http://renderingsystems.com
+
+	===============================================================
+*/
+
+#ifndef PLUGIN_HALF_BATCH_CPP
+#define PLUGIN_HALF_BATCH_CPP
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Half batch includes
+
+#include <stddef.h>
+#include <string.h>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+	#define HALF_BATCH_X86
+	#include <emmintrin.h>
+	#include <immintrin.h>
+	#ifdef _MSC_VER
+		#include <intrin.h>
+		#define HALF_BATCH_TARGET_F16C												// MSVC allows the intrinsics in any function.
+	#else
+		#include <cpuid.h>
+		#define HALF_BATCH_TARGET_F16C	__attribute__((target("avx,f16c")))
+	#endif
+#endif
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Half batch defines
+
+// Conversion paths
+#define HALF_BATCH_PATH_AUTO					0					// Select the fastest path the CPU supports.
+#define HALF_BATCH_PATH_SCALAR					1
+#define HALF_BATCH_PATH_SSE2					2
+#define HALF_BATCH_PATH_F16C					3
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Half batch function types
+
+typedef void (*half_batch_to_float_type)(const unsigned short* half_array, float* float_array, size_t count);
+typedef void (*half_batch_from_float_type)(const float* float_array, unsigned short* half_array, size_t count);
+
+static half_batch_to_float_type					half_batch_to_float_function	= 0;
+static half_batch_from_float_type				half_batch_from_float_function	= 0;
+static unsigned int								half_batch_path					= HALF_BATCH_PATH_AUTO;
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Scalar path
+
+// Convert one half to float.
+inline float half_batch_scalar_to_float(unsigned short h)
+{
+	// Local data
+	union { unsigned int u; float f; }			value, magic;
+	unsigned int								exponent_mantissa;
+
+
+	// Rebias the exponent with a multiply. Denormal halves become normal floats.
+	exponent_mantissa	= h & 0x7FFFu;
+	magic.u				= (254u - 15u) << 23;
+	value.u				= exponent_mantissa << 13;
+	value.f				*= magic.f;
+	if(exponent_mantissa > 0x7BFFu)
+	{	value.u |= 255u << 23;												// Infinity or NaN.
+	}
+	if(exponent_mantissa > 0x7C00u)
+	{	value.u |= 0x00400000u;												// NaN is made quiet, the same as F16C.
+	}
+	value.u |= (unsigned int)(h & 0x8000u) << 16;
+	return value.f;
+}
+
+// Convert one float to half rounding to nearest even.
+inline unsigned short half_batch_scalar_from_float(float f)
+{
+	// Local data
+	union { unsigned int u; float f; }			value, denormal_magic;
+	unsigned int								sign, result;
+
+
+	value.f	= f;
+	sign	= value.u & 0x80000000u;
+	value.u	^= sign;
+
+	// Too large for half: infinity, or a quiet NaN.
+	if(value.u >= (127u + 16u) << 23)
+	{	result = (value.u > 0x7F800000u) ? 0x7E00u : 0x7C00u;
+	}
+	// Denormal half: the float add rounds the mantissa to the half denormal step.
+	else if(value.u < (127u - 14u) << 23)
+	{	denormal_magic.u	= ((127u - 15u) + (23u - 10u) + 1u) << 23;
+		value.f				+= denormal_magic.f;
+		result				= value.u - denormal_magic.u;
+	}
+	// Normal half: rebias the exponent by 127 - 15, add the rounding bias and the odd bit for ties to even.
+	else
+	{	result = (value.u - (112u << 23) + 0xFFFu + ((value.u >> 13) & 1u)) >> 13;
+	}
+	return (unsigned short)(result | (sign >> 16));
+}
+
+// Convert a span of halves to floats.
+void half_batch_scalar_to_float_span(const unsigned short* half_array, float* float_array, size_t count)
+{
+	for(size_t i=0; i<count; i++)
+	{	float_array[i] = half_batch_scalar_to_float(half_array[i]);
+	}
+}
+
+// Convert a span of floats to halves.
+void half_batch_scalar_from_float_span(const float* float_array, unsigned short* half_array, size_t count)
+{
+	for(size_t i=0; i<count; i++)
+	{	half_array[i] = half_batch_scalar_from_float(float_array[i]);
+	}
+}
+
+
+#ifdef HALF_BATCH_X86
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// SSE2 path - the same math as the scalar path on 4 values.
+
+// Convert 4 halves, one in the low 16 bits of each lane, to floats.
+inline __m128 half_batch_sse2_to_float(__m128i h)
+{
+	__m128i exponent_mantissa	= _mm_and_si128(h, _mm_set1_epi32(0x7FFF));
+	__m128i sign				= _mm_slli_epi32(_mm_xor_si128(h, exponent_mantissa), 16);
+	__m128	scaled				= _mm_mul_ps(_mm_castsi128_ps(_mm_slli_epi32(exponent_mantissa, 13)), _mm_castsi128_ps(_mm_set1_epi32((254 - 15) << 23)));
+	__m128i is_inf_nan			= _mm_cmpgt_epi32(exponent_mantissa, _mm_set1_epi32(0x7BFF));
+	__m128i is_nan				= _mm_cmpgt_epi32(exponent_mantissa, _mm_set1_epi32(0x7C00));
+	__m128	inf_nan_exponent	= _mm_and_ps(_mm_castsi128_ps(is_inf_nan), _mm_castsi128_ps(_mm_set1_epi32(255 << 23)));
+	__m128	nan_quiet			= _mm_and_ps(_mm_castsi128_ps(is_nan), _mm_castsi128_ps(_mm_set1_epi32(0x00400000)));
+
+	return _mm_or_ps(scaled, _mm_or_ps(_mm_castsi128_ps(sign), _mm_or_ps(inf_nan_exponent, nan_quiet)));
+}
+
+// Convert 4 floats to halves in the low 16 bits of each lane.
+inline __m128i half_batch_sse2_from_float(__m128 f)
+{
+	const __m128i denormal_magic = _mm_set1_epi32(((127 - 15) + (23 - 10) + 1) << 23);
+
+	__m128i sign				= _mm_and_si128(_mm_castps_si128(f), _mm_set1_epi32((int)0x80000000u));
+	__m128i value				= _mm_xor_si128(_mm_castps_si128(f), sign);
+	__m128i is_regular			= _mm_cmpgt_epi32(_mm_set1_epi32((127 + 16) << 23), value);
+	__m128i is_nan				= _mm_cmpgt_epi32(value, _mm_set1_epi32(0x7F800000));
+	__m128i inf_nan				= _mm_or_si128(_mm_and_si128(is_nan, _mm_set1_epi32(0x0200)), _mm_set1_epi32(0x7C00));
+	__m128i is_denormal			= _mm_cmpgt_epi32(_mm_set1_epi32((127 - 14) << 23), value);
+	__m128i denormal			= _mm_sub_epi32(_mm_castps_si128(_mm_add_ps(_mm_castsi128_ps(value), _mm_castsi128_ps(denormal_magic))), denormal_magic);
+	__m128i odd_bit				= _mm_and_si128(_mm_srli_epi32(value, 13), _mm_set1_epi32(1));
+	__m128i normal				= _mm_srli_epi32(_mm_add_epi32(_mm_add_epi32(value, _mm_set1_epi32(0xFFF - (112 << 23))), odd_bit), 13);
+	__m128i finite				= _mm_or_si128(_mm_and_si128(is_denormal, denormal), _mm_andnot_si128(is_denormal, normal));
+	__m128i result				= _mm_or_si128(_mm_and_si128(is_regular, finite), _mm_andnot_si128(is_regular, inf_nan));
+
+	return _mm_or_si128(result, _mm_srli_epi32(sign, 16));
+}
+
+// Convert a span of halves to floats.
+void half_batch_sse2_to_float_span(const unsigned short* half_array, float* float_array, size_t count)
+{
+	// Local data
+	size_t										i;
+	const __m128i								zero = _mm_setzero_si128();
+
+
+	for(i=0; i+8<=count; i+=8)
+	{	__m128i h = _mm_loadu_si128((const __m128i*)&half_array[i]);
+		_mm_storeu_ps(&float_array[i], half_batch_sse2_to_float(_mm_unpacklo_epi16(h, zero)));
+		_mm_storeu_ps(&float_array[i + 4], half_batch_sse2_to_float(_mm_unpackhi_epi16(h, zero)));
+	}
+	half_batch_scalar_to_float_span(&half_array[i], &float_array[i], count - i);
+}
+
+// Convert a span of floats to halves.
+void half_batch_sse2_from_float_span(const float* float_array, unsigned short* half_array, size_t count)
+{
+	// Local data
+	size_t										i;
+	__m128i										low, high;
+
+
+	for(i=0; i+8<=count; i+=8)
+	{	low		= half_batch_sse2_from_float(_mm_loadu_ps(&float_array[i]));
+		high	= half_batch_sse2_from_float(_mm_loadu_ps(&float_array[i + 4]));
+		// Sign extend the 16 bit results so the signed saturating pack keeps them unchanged.
+		low		= _mm_srai_epi32(_mm_slli_epi32(low, 16), 16);
+		high	= _mm_srai_epi32(_mm_slli_epi32(high, 16), 16);
+		_mm_storeu_si128((__m128i*)&half_array[i], _mm_packs_epi32(low, high));
+	}
+	half_batch_scalar_from_float_span(&float_array[i], &half_array[i], count - i);
+}
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// F16C path
+
+// Convert a span of halves to floats.
+HALF_BATCH_TARGET_F16C void half_batch_f16c_to_float_span(const unsigned short* half_array, float* float_array, size_t count)
+{
+	// Local data
+	size_t										i;
+
+
+	for(i=0; i+8<=count; i+=8)
+	{	_mm256_storeu_ps(&float_array[i], _mm256_cvtph_ps(_mm_loadu_si128((const __m128i*)&half_array[i])));
+	}
+	half_batch_scalar_to_float_span(&half_array[i], &float_array[i], count - i);
+}
+
+// Convert a span of floats to halves.
+HALF_BATCH_TARGET_F16C void half_batch_f16c_from_float_span(const float* float_array, unsigned short* half_array, size_t count)
+{
+	// Local data
+	size_t										i;
+	__m128i										half, is_nan;
+
+
+	// F16C keeps the top of a NaN payload, the other paths give the quiet NaN 0x7E00 with the sign.
+	for(i=0; i+8<=count; i+=8)
+	{	half	= _mm256_cvtps_ph(_mm256_loadu_ps(&float_array[i]), 0);		// 0 = round to nearest even.
+		is_nan	= _mm_cmpgt_epi16(_mm_and_si128(half, _mm_set1_epi16(0x7FFF)), _mm_set1_epi16(0x7C00));
+		half	= _mm_or_si128(_mm_andnot_si128(is_nan, half), _mm_and_si128(is_nan, _mm_or_si128(_mm_and_si128(half, _mm_set1_epi16((short)0x8000)), _mm_set1_epi16(0x7E00))));
+		_mm_storeu_si128((__m128i*)&half_array[i], half);
+	}
+	half_batch_scalar_from_float_span(&float_array[i], &half_array[i], count - i);
+}
+
+// Return TRUE if the CPU and the OS support F16C and AVX registers.
+BOOL half_batch_is_f16c_supported(void)
+{
+	// Local data
+	unsigned int								reg[4];
+
+
+#ifdef _MSC_VER
+	__cpuid((int*)reg, 1);
+#else
+	if(!__get_cpuid(1, &reg[0], &reg[1], &reg[2], &reg[3]))
+	{	return FALSE;
+	}
+#endif
+
+	// ECX bit 29 F16C, bit 28 AVX, bit 27 OSXSAVE.
+	if((reg[2] & ((1u << 29) | (1u << 28) | (1u << 27))) != ((1u << 29) | (1u << 28) | (1u << 27)))
+	{	return FALSE;
+	}
+
+	// The OS must save the SSE and AVX registers.
+#ifdef _MSC_VER
+	return ((_xgetbv(0) & 6) == 6) ? TRUE : FALSE;
+#else
+	unsigned int eax, edx;
+	__asm__ __volatile__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+	return ((eax & 6) == 6) ? TRUE : FALSE;
+#endif
+}
+
+#endif // HALF_BATCH_X86
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Half batch functions
+
+// Select the conversion path. HALF_BATCH_PATH_AUTO picks the fastest supported path, a path the CPU
+// does not support falls back to the next fastest. Returns the path selected. Not thread safe, call
+// from on_initialize() or before any conversion when forcing a path.
+unsigned int half_batch_select_path(unsigned int path)
+{
+#ifdef HALF_BATCH_X86
+	if((path == HALF_BATCH_PATH_AUTO || path == HALF_BATCH_PATH_F16C) && half_batch_is_f16c_supported())
+	{	half_batch_to_float_function	= half_batch_f16c_to_float_span;
+		half_batch_from_float_function	= half_batch_f16c_from_float_span;
+		half_batch_path					= HALF_BATCH_PATH_F16C;
+	}
+	else if(path != HALF_BATCH_PATH_SCALAR)
+	{	half_batch_to_float_function	= half_batch_sse2_to_float_span;
+		half_batch_from_float_function	= half_batch_sse2_from_float_span;
+		half_batch_path					= HALF_BATCH_PATH_SSE2;
+	}
+	else
+#endif
+	{	half_batch_to_float_function	= half_batch_scalar_to_float_span;
+		half_batch_from_float_function	= half_batch_scalar_from_float_span;
+		half_batch_path					= HALF_BATCH_PATH_SCALAR;
+	}
+	return half_batch_path;
+}
+
+// Return the name of the selected path.
+const char* half_batch_get_path_name(void)
+{
+	static const char* name_array[4] = { "auto", "scalar", "sse2", "f16c" };
+
+	if(!half_batch_to_float_function)
+	{	half_batch_select_path(HALF_BATCH_PATH_AUTO);
+	}
+	return name_array[half_batch_path];
+}
+
+// Convert count halves to floats. The arrays must not overlap.
+void half_batch_to_float(const unsigned short* half_array, float* float_array, size_t count)
+{
+	// Every thread selects the same path so the first call race is harmless.
+	if(!half_batch_to_float_function)
+	{	half_batch_select_path(HALF_BATCH_PATH_AUTO);
+	}
+	half_batch_to_float_function(half_array, float_array, count);
+}
+
+// Convert count floats to halves rounding to nearest even. The arrays must not overlap.
+void half_batch_from_float(const float* float_array, unsigned short* half_array, size_t count)
+{
+	if(!half_batch_from_float_function)
+	{	half_batch_select_path(HALF_BATCH_PATH_AUTO);
+	}
+	half_batch_from_float_function(float_array, half_array, count);
+}
+
+// Convert row y of a half pixel array to floats. channel_count is 2 for grayscale and 4 for RGBA pixels.
+// row_out must hold width * channel_count floats.
+void half_batch_get_row(const void* pixel_array, unsigned int width, unsigned int channel_count, unsigned int y, float* row_out)
+{
+	size_t row_size = (size_t)width * channel_count;
+	half_batch_to_float((const unsigned short*)pixel_array + row_size * y, row_out, row_size);
+}
+
+// Convert floats to row y of a half pixel array. channel_count is 2 for grayscale and 4 for RGBA pixels.
+void half_batch_set_row(void* pixel_array, unsigned int width, unsigned int channel_count, unsigned int y, const float* row)
+{
+	size_t row_size = (size_t)width * channel_count;
+	half_batch_from_float(row, (unsigned short*)pixel_array + row_size * y, row_size);
+}
+
+#endif // PLUGIN_HALF_BATCH_CPP
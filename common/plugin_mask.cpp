@@ -0,0 +1,497 @@
+/*
+	===============================================================
+
+	SHADERMAP PLUGIN MASK SOURCE FILE
+
+	Gets the mask of a map at the size of the map, inverted if
+	required, from a cache.
+
+	Masks are set on a map in ShaderMap at any size. Every plugin
+	that uses a mask gets it with mp_get_map_mask() or
+	fp_get_map_mask(), copies it, resizes it to the map size and
+	inverts it if the Invert Mask property is set. The cache keeps
+	the result for each map, size and inversion until the mask of
+	the map changes, so a plugin that processes the same map again
+	(for example each time a property is changed) does it once.
+
+	Resizing is done with an area filter when the mask is made
+	smaller and a bilinear filter when it is made larger, in
+	separate passes over rows and columns using SSE2 on x86.
+	Inverting is done while writing the result.
+
+	Include this source code file in a map or filter plugin after
+	the plugin core file. #include "../../../common/plugin_mask.cpp"
+
+	--
+
+	Example:
+
+	mask_pixel_array = plugin_mask_get(map_id, width, height, is_invert_mask);
+	if(mask_pixel_array)
+	{	... one value per map pixel, 0 - 65535 ...
+		plugin_mask_release(mask_pixel_array);
+	}
+
+	Call plugin_mask_clear() from on_shutdown().
+
+	The array returned stays valid until it is released. Each get
+	must be matched by a release. Maps can be processed on several
+	threads at once, the cache is locked while it is searched.
+
+	The mask pixels of a map are hashed on every get to find out
+	if the mask changed. Reading the mask once is much cheaper
+	than copying, resizing and inverting it.
+
+	The cache is part of the plugin, each plugin has its own
+	cache. Plugins do not share cached masks with each other.
+
+
+	SHADERMAP SDK LICENSE
+
+	The ShaderMap SDK is released under The MIT License (MIT)
+	http://opensource.org/licenses/MIT
+
+	Copyright (c) 2007-2019 Rendering Systems Inc.
+
+	Permission is hereby granted, free of charge, to any person
+	obtaining a copy of this software and associated documentation
+	files (the "Software"), to deal	in the Software without
+	restriction, including without limitation the rights to use,
+	copy, modify, merge, publish, distribute, sublicense, and/or
+	sell copies of the Software, and to permit persons to whom the
+	Software is	furnished to do so, subject to the following
+	conditions:
+
+	The above copyright notice and this permission notice shall be
+	included in	all copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+	OF MERCHANTABILITY,	FITNESS FOR A PARTICULAR PURPOSE AND
+	NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+	OTHER DEALINGS IN THE SOFTWARE.
+
+	Developed by: Neil Kemp at Rendering Systems Inc.
+
+	Online:		http://shadermap.com
+	Corporate:	http://renderingsystems.com
+
+	===============================================================
+*/
+
+#ifndef PLUGIN_MASK_CPP
+#define PLUGIN_MASK_CPP
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Mask includes
+
+#include <limits.h>
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+#include <mutex>
+#include <new>
+#include <vector>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+	#define PLUGIN_MASK_SSE2
+	#include <emmintrin.h>
+#endif
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Mask defines
+
+// Resize filters
+#define PLUGIN_MASK_FILTER_AUTO					0					// Area when making smaller, bilinear when making larger. Chosen for each axis.
+#define PLUGIN_MASK_FILTER_BILINEAR				1
+#define PLUGIN_MASK_FILTER_AREA					2
+
+// Cached masks not in use are released, oldest first, when the cache is larger than this.
+#ifndef PLUGIN_MASK_CACHE_BYTE_LIMIT
+#define PLUGIN_MASK_CACHE_BYTE_LIMIT			(256ull * 1024 * 1024)
+#endif
+
+// The mask function of the plugin core this file is included in.
+#if defined(MAP_PLUGIN_TYPE_SOURCE)
+	#define PLUGIN_MASK_GET_MAP_MASK			mp_get_map_mask
+#elif defined(FILTER_NORMAL_NONE)
+	#define PLUGIN_MASK_GET_MAP_MASK			fp_get_map_mask
+#endif
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Mask structs
+
+// The source pixels of one axis that make one resized pixel.
+struct plugin_mask_axis_s
+{
+	std::vector<unsigned int>					start_list;					// First source pixel of each resized pixel.
+	std::vector<float>							weight_list;				// tap_count weights for each resized pixel.
+	unsigned int								tap_count;
+};
+
+// A cached mask.
+struct plugin_mask_entry_s
+{
+	unsigned int								map_id;
+	const unsigned short*						source_pixel_array;			// The mask in ShaderMap and its hash. Used to find out if the mask changed.
+	unsigned int								source_width;
+	unsigned int								source_height;
+	unsigned long long							source_hash;
+	unsigned int								width;
+	unsigned int								height;
+	BOOL										is_invert;
+	std::vector<unsigned short>					pixel_list;
+	unsigned int								use_count;					// Gets not released yet.
+	unsigned long long							last_use;
+};
+
+static std::vector<plugin_mask_entry_s*>		plugin_mask_cache_list;
+static std::mutex								plugin_mask_mutex;
+static unsigned long long						plugin_mask_use_clock = 0;
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Mask resize
+
+// Build the source taps of each resized pixel on one axis.
+void plugin_mask_build_axis(unsigned int source_size, unsigned int size, unsigned int filter, plugin_mask_axis_s& axis_out)
+{
+	// Local data
+	double										scale = (double)source_size / size;
+
+
+	if(filter == PLUGIN_MASK_FILTER_AUTO)
+	{	filter = (size < source_size) ? PLUGIN_MASK_FILTER_AREA : PLUGIN_MASK_FILTER_BILINEAR;
+	}
+	axis_out.start_list.resize(size);
+
+	// Area - the weight of each source pixel is how much of it the resized pixel covers.
+	if(filter == PLUGIN_MASK_FILTER_AREA && size < source_size)
+	{	axis_out.tap_count = (unsigned int)ceil(scale) + 1;
+		axis_out.weight_list.assign((size_t)size * axis_out.tap_count, 0.0f);
+		for(unsigned int i=0; i<size; i++)
+		{	double			start	= i * scale, end = (i + 1) * scale;
+			unsigned int	first	= (unsigned int)floor(start);
+			axis_out.start_list[i] = first;
+			for(unsigned int t=0; t<axis_out.tap_count && first + t < source_size; t++)
+			{	double overlap = std::min<double>(end, first + t + 1.0) - std::max<double>(start, first + t);
+				if(overlap > 0.0)
+				{	axis_out.weight_list[(size_t)i * axis_out.tap_count + t] = (float)(overlap / scale);
+				}
+			}
+		}
+	}
+	// Bilinear - sample at the pixel center, the edge pixel repeats.
+	else
+	{	axis_out.tap_count = 2;
+		axis_out.weight_list.resize((size_t)size * 2);
+		for(unsigned int i=0; i<size; i++)
+		{	double			position	= std::max<double>(0.0, (i + 0.5) * scale - 0.5);
+			unsigned int	first		= std::min<unsigned int>((unsigned int)position, source_size - 1);
+			float			fraction	= (first + 1 < source_size) ? (float)(position - first) : 0.0f;
+			axis_out.start_list[i]			= (first + 1 < source_size) ? first : (source_size > 1 ? source_size - 2 : 0);
+			axis_out.weight_list[i * 2]		= (first + 1 < source_size) ? 1.0f - fraction : (source_size > 1 ? 0.0f : 1.0f);
+			axis_out.weight_list[i * 2 + 1]	= (first + 1 < source_size) ? fraction : (source_size > 1 ? 1.0f : 0.0f);
+		}
+	}
+}
+
+// Add weight * source row to a float row.
+inline void plugin_mask_add_row(const unsigned short* source_row, float weight, float* row_in_out, unsigned int count)
+{
+	unsigned int x = 0;
+
+#ifdef PLUGIN_MASK_SSE2
+	const __m128i	zero	= _mm_setzero_si128();
+	const __m128	w		= _mm_set1_ps(weight);
+	for(; x+8<=count; x+=8)
+	{	__m128i s = _mm_loadu_si128((const __m128i*)&source_row[x]);
+		_mm_storeu_ps(&row_in_out[x],		_mm_add_ps(_mm_loadu_ps(&row_in_out[x]),		_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(s, zero)), w)));
+		_mm_storeu_ps(&row_in_out[x + 4],	_mm_add_ps(_mm_loadu_ps(&row_in_out[x + 4]),	_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(s, zero)), w)));
+	}
+#endif
+	for(; x<count; x++)
+	{	row_in_out[x] += source_row[x] * weight;
+	}
+}
+
+// Round a float row to mask values to nearest even, inverted if is_invert.
+inline void plugin_mask_store_row(const float* row, BOOL is_invert, unsigned short* row_out, unsigned int count)
+{
+	unsigned int x = 0;
+
+#ifdef PLUGIN_MASK_SSE2
+	// Values are offset by 32768 so the signed saturating pack keeps the full unsigned range.
+	const __m128	low		= _mm_setzero_ps(), high = _mm_set1_ps(65535.0f);
+	const __m128i	offset	= _mm_set1_epi32(32768), flip = _mm_set1_epi16((short)0x8000);
+	const __m128i	invert	= _mm_set1_epi16(is_invert ? (short)0xFFFF : 0);
+	for(; x+8<=count; x+=8)
+	{	__m128i a = _mm_sub_epi32(_mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(&row[x]), low), high)), offset);
+		__m128i b = _mm_sub_epi32(_mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(&row[x + 4]), low), high)), offset);
+		_mm_storeu_si128((__m128i*)&row_out[x], _mm_xor_si128(_mm_xor_si128(_mm_packs_epi32(a, b), flip), invert));
+	}
+#endif
+	for(; x<count; x++)
+	{	float			v		= row[x] < 0.0f ? 0.0f : (row[x] > 65535.0f ? 65535.0f : row[x]);
+		unsigned short	value	= (unsigned short)lrintf(v);					// Nearest even, the same as _mm_cvtps_epi32().
+		row_out[x] = is_invert ? (unsigned short)(USHRT_MAX - value) : value;
+	}
+}
+
+// Resize a mask and invert it if is_invert. pixel_array_out must hold width * height values. Returns FALSE if out of memory.
+BOOL plugin_mask_resize(const unsigned short* source_pixel_array, unsigned int source_width, unsigned int source_height,
+						unsigned short* pixel_array_out, unsigned int width, unsigned int height, BOOL is_invert, unsigned int filter)
+{
+	// Local data
+	plugin_mask_axis_s							axis_x, axis_y;
+	std::vector<float>							column_list, row_list;
+
+
+	// Same size - copy or invert only.
+	if(source_width == width && source_height == height)
+	{	size_t count = (size_t)width * height;
+		if(!is_invert)
+		{	memcpy(pixel_array_out, source_pixel_array, sizeof(unsigned short) * count);
+			return TRUE;
+		}
+		for(size_t i=0; i<count; i++)
+		{	pixel_array_out[i] = (unsigned short)(USHRT_MAX - source_pixel_array[i]);
+		}
+		return TRUE;
+	}
+
+	try
+	{	plugin_mask_build_axis(source_width, width, filter, axis_x);
+		plugin_mask_build_axis(source_height, height, filter, axis_y);
+		column_list.resize(source_width);
+		row_list.resize(width);
+	}
+	catch(...)
+	{	return FALSE;
+	}
+
+	for(unsigned int y=0; y<height; y++)
+	{
+		// Rows - blend the source rows of this resized row at the source width.
+		std::fill(column_list.begin(), column_list.end(), 0.0f);
+		for(unsigned int t=0; t<axis_y.tap_count; t++)
+		{	float weight = axis_y.weight_list[(size_t)y * axis_y.tap_count + t];
+			if(weight != 0.0f)
+			{	plugin_mask_add_row(&source_pixel_array[(size_t)(axis_y.start_list[y] + t) * source_width], weight, &column_list[0], source_width);
+			}
+		}
+
+		// Columns - blend the source columns of each resized pixel.
+		if(axis_x.tap_count == 2)
+		{	for(unsigned int x=0; x<width; x++)
+			{	const float* c = &column_list[axis_x.start_list[x]];
+				row_list[x] = c[0] * axis_x.weight_list[x * 2] + c[1] * axis_x.weight_list[x * 2 + 1];
+			}
+		}
+		else
+		{	for(unsigned int x=0; x<width; x++)
+			{	const float*	c	= &column_list[axis_x.start_list[x]];
+				const float*	w	= &axis_x.weight_list[(size_t)x * axis_x.tap_count];
+				unsigned int	end	= std::min<unsigned int>(axis_x.tap_count, source_width - axis_x.start_list[x]);
+				float			sum	= 0.0f;
+				for(unsigned int t=0; t<end; t++)
+				{	sum += c[t] * w[t];
+				}
+				row_list[x] = sum;
+			}
+		}
+
+		plugin_mask_store_row(&row_list[0], is_invert, &pixel_array_out[(size_t)y * width], width);
+	}
+	return TRUE;
+}
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Mask cache
+
+// Return h with every input bit spread over every output bit (the 64 bit finalizer of MurmurHash3).
+inline unsigned long long plugin_mask_mix(unsigned long long h)
+{
+	h ^= h >> 33;
+	h *= 0xFF51AFD7ED558CCDull;
+	h ^= h >> 33;
+	h *= 0xC4CEB9FE1A85EC53ull;
+	h ^= h >> 33;
+	return h;
+}
+
+// Return a hash of the mask pixels.
+unsigned long long plugin_mask_hash(const unsigned short* pixel_array, size_t count)
+{
+	// Local data
+	unsigned long long							lane[4] = { 0x9E3779B97F4A7C15ull, 0xC2B2AE3D27D4EB4Full, 0x165667B19E3779F9ull, 0x27D4EB2F165667C5ull };
+	unsigned long long							word[4];
+	unsigned long long							result;
+	size_t										i;
+	const unsigned long long					prime = 0x100000001B3ull;
+
+
+	// 4 independent lanes of 64 bits keep the multiplies from waiting on each other.
+	for(i=0; i+16<=count; i+=16)
+	{	memcpy(word, &pixel_array[i], sizeof(word));
+		lane[0] = (lane[0] ^ word[0]) * prime;
+		lane[1] = (lane[1] ^ word[1]) * prime;
+		lane[2] = (lane[2] ^ word[2]) * prime;
+		lane[3] = (lane[3] ^ word[3]) * prime;
+	}
+	for(; i<count; i++)
+	{	lane[0] = (lane[0] ^ pixel_array[i]) * prime;
+	}
+
+	// Each lane is mixed before it is combined so no bits of a lane are shifted out. The mix is reversible, a change to
+	// one lane always changes the result.
+	result = count;
+	for(i=0; i<4; i++)
+	{	result = plugin_mask_mix(result ^ plugin_mask_mix(lane[i]));
+	}
+	return result;
+}
+
+// Release cached masks not in use, oldest first, until the cache is under PLUGIN_MASK_CACHE_BYTE_LIMIT. Called with the cache locked.
+void plugin_mask_trim(void)
+{
+	// Local data
+	unsigned long long							byte_count = 0;
+
+
+	for(size_t i=0; i<plugin_mask_cache_list.size(); i++)
+	{	byte_count += plugin_mask_cache_list[i]->pixel_list.size() * sizeof(unsigned short);
+	}
+	while(byte_count > PLUGIN_MASK_CACHE_BYTE_LIMIT)
+	{	size_t oldest = plugin_mask_cache_list.size();
+		for(size_t i=0; i<plugin_mask_cache_list.size(); i++)
+		{	if(!plugin_mask_cache_list[i]->use_count && (oldest == plugin_mask_cache_list.size() || plugin_mask_cache_list[i]->last_use < plugin_mask_cache_list[oldest]->last_use))
+			{	oldest = i;
+			}
+		}
+		if(oldest == plugin_mask_cache_list.size())
+		{	return;
+		}
+		byte_count -= plugin_mask_cache_list[oldest]->pixel_list.size() * sizeof(unsigned short);
+		delete plugin_mask_cache_list[oldest];
+		plugin_mask_cache_list.erase(plugin_mask_cache_list.begin() + oldest);
+	}
+}
+
+// Return the mask of a map at width x height, inverted if is_invert. Returns 0 if the map has no mask or out of memory.
+// Release the array with plugin_mask_release().
+const unsigned short* plugin_mask_get(unsigned int map_id, unsigned int width, unsigned int height, BOOL is_invert)
+{
+	// Local data
+	unsigned int								source_width, source_height;
+	unsigned short*								source_pixel_array;
+	unsigned long long							source_hash;
+	plugin_mask_entry_s*						entry;
+
+
+	source_width		= 0;
+	source_height		= 0;
+	source_pixel_array	= 0;
+	PLUGIN_MASK_GET_MAP_MASK(map_id, source_width, source_height, &source_pixel_array);
+	if(!source_pixel_array || !source_width || !source_height || !width || !height)
+	{	return 0;
+	}
+	source_hash = plugin_mask_hash(source_pixel_array, (size_t)source_width * source_height);
+
+	{	std::lock_guard<std::mutex> lock(plugin_mask_mutex);
+
+		// Drop the masks of this map made from a mask that changed.
+		for(size_t i=0; i<plugin_mask_cache_list.size(); )
+		{	entry = plugin_mask_cache_list[i];
+			if(entry->map_id == map_id && !entry->use_count &&
+			   (entry->source_pixel_array != source_pixel_array || entry->source_width != source_width || entry->source_height != source_height || entry->source_hash != source_hash))
+			{	delete entry;
+				plugin_mask_cache_list.erase(plugin_mask_cache_list.begin() + i);
+				continue;
+			}
+			i++;
+		}
+
+		for(size_t i=0; i<plugin_mask_cache_list.size(); i++)
+		{	entry = plugin_mask_cache_list[i];
+			if(entry->map_id == map_id && entry->width == width && entry->height == height && entry->is_invert == is_invert &&
+			   entry->source_pixel_array == source_pixel_array && entry->source_width == source_width && entry->source_height == source_height && entry->source_hash == source_hash)
+			{	entry->use_count++;
+				entry->last_use = ++plugin_mask_use_clock;
+				return &entry->pixel_list[0];
+			}
+		}
+	}
+
+	// Not cached - resize outside the lock so other maps are not held up.
+	entry = new (std::nothrow) plugin_mask_entry_s;
+	if(!entry)
+	{	return 0;
+	}
+	try
+	{	entry->pixel_list.resize((size_t)width * height);
+	}
+	catch(...)
+	{	delete entry;
+		return 0;
+	}
+	if(!plugin_mask_resize(source_pixel_array, source_width, source_height, &entry->pixel_list[0], width, height, is_invert, PLUGIN_MASK_FILTER_AUTO))
+	{	delete entry;
+		return 0;
+	}
+	entry->map_id				= map_id;
+	entry->source_pixel_array	= source_pixel_array;
+	entry->source_width			= source_width;
+	entry->source_height		= source_height;
+	entry->source_hash			= source_hash;
+	entry->width				= width;
+	entry->height				= height;
+	entry->is_invert			= is_invert;
+	entry->use_count			= 1;
+
+	{	std::lock_guard<std::mutex> lock(plugin_mask_mutex);
+		entry->last_use = ++plugin_mask_use_clock;
+		plugin_mask_cache_list.push_back(entry);
+		plugin_mask_trim();
+	}
+	return &entry->pixel_list[0];
+}
+
+// Release a mask returned by plugin_mask_get(). It stays in the cache.
+void plugin_mask_release(const unsigned short* mask_pixel_array)
+{
+	std::lock_guard<std::mutex> lock(plugin_mask_mutex);
+
+	for(size_t i=0; i<plugin_mask_cache_list.size(); i++)
+	{	if(!plugin_mask_cache_list[i]->pixel_list.empty() && &plugin_mask_cache_list[i]->pixel_list[0] == mask_pixel_array && plugin_mask_cache_list[i]->use_count)
+		{	plugin_mask_cache_list[i]->use_count--;
+			break;
+		}
+	}
+	plugin_mask_trim();
+}
+
+// Release every cached mask. Call from on_shutdown().
+void plugin_mask_clear(void)
+{
+	std::lock_guard<std::mutex> lock(plugin_mask_mutex);
+
+	for(size_t i=0; i<plugin_mask_cache_list.size(); i++)
+	{	delete plugin_mask_cache_list[i];
+	}
+	plugin_mask_cache_list.clear();
+}
+
+#endif // PLUGIN_MASK_CPP
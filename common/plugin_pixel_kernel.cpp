@@ -0,0 +1,468 @@
+/*
+	===============================================================
+
+	SHADERMAP PLUGIN PIXEL KERNEL SOURCE FILE
+
+	Runs a per pixel function over every pixel of a map. The
+	plugin writes the math for one pixel as a kernel struct and
+	this file supplies the loops: half float rows are converted to
+	floats with plugin_half_batch.cpp, the kernel is called for
+	every pixel, then the rows are converted back.
+
+	The loops are templates so a separate loop is compiled for
+	grayscale (2 channels) and color (4 channels) pixels, with and
+	without a mask. The choice is made once per call, never per
+	pixel, and with no mask the mask value is the constant 1.0f
+	which the compiler removes from the kernel math.
+
+	Include this source code file in a map or filter plugin after
+	the plugin core file. #include "../../../common/plugin_pixel_kernel.cpp"
+
+	--
+
+	PIXEL KERNELS
+
+	A pixel kernel works on one pixel at a time in place:
+
+	struct brightness_kernel_s
+	{
+		float amount;
+
+		// pixel is CHANNEL_COUNT floats: (C, A) for grayscale and (R, G, B, A) for color.
+		// mask is 0.0f to 1.0f, always 1.0f when there is no mask.
+		template<unsigned int CHANNEL_COUNT> void process_pixel(float* pixel, float mask) const
+		{	for(unsigned int c=0; c<CHANNEL_COUNT-1; c++)
+			{	pixel[c] += amount * mask;
+			}
+		}
+	};
+
+	pixel_kernel_run(image, mask_pixel_array, kernel);
+
+	--
+
+	AREA KERNELS
+
+	An area kernel reads the pixels around the pixel it writes, for
+	example a blur. RADIUS pixels around the pixel can be read in
+	each direction. Pixels outside the map wrap around on the
+	tiled axes of the image tile type and repeat the edge pixel on
+	the other axes. The tile type is handled when rows are loaded
+	so the kernel never checks it.
+
+	struct box_blur_kernel_s
+	{
+		template<unsigned int CHANNEL_COUNT> void process_area(const pixel_kernel_area_s& area, int x, float* pixel_out, float mask) const
+		{	for(unsigned int c=0; c<CHANNEL_COUNT; c++)
+			{	pixel_out[c] = (area.get_pixel(x - 1, 0)[c] + area.get_pixel(x, 0)[c] + area.get_pixel(x + 1, 0)[c] +
+								area.get_pixel(x, -1)[c] + area.get_pixel(x, 1)[c]) / 5.0f;
+			}
+		}
+	};
+
+	pixel_kernel_run_area<1>(image, mask_pixel_array, kernel);
+
+	pixel_out starts as a copy of the source pixel, so a kernel
+	can blend its result with it using the mask.
+
+	--
+
+	IMAGES
+
+	pixel_kernel_image_s describes the source and destination
+	pixels. They can be the same array (a filter working in place)
+	or separate arrays of the same size and format (a map reading
+	an input and writing the map created by mp_create_map()).
+	pixel_kernel_get_image() fills it from process_data_s in a
+	filter plugin or from map_create_info_s in a map plugin.
+
+	The mask is one unsigned short per pixel at the map size, or 0
+	for no mask. Resize and invert it before the call.
+
+	pixel_kernel_run() runs the rows in bands on the plugin thread
+	pool (see "common/plugin_thread_pool.cpp"), on no more threads
+	than the map thread limit. A kernel is called from several
+	threads at once so it must not change its own members. Pass a
+	progress from parallel_get_progress() to set the map or filter
+	progress as the bands finish.
+
+	pixel_kernel_run_area() runs on the calling thread, rows in
+	order, and is not split into bands.
+
+	The run functions return FALSE if the process was cancelled or
+	memory could not be allocated. Call parallel_shutdown() from
+	on_shutdown() when pixel_kernel_run() is used.
+
+
+	SHADERMAP SDK LICENSE
+
+	The ShaderMap SDK is released under The MIT License (MIT)
+	http://opensource.org/licenses/MIT
+
+	Copyright (c) 2007-2019 Rendering Systems Inc.
+
+	Permission is hereby granted, free of charge, to any person
+	obtaining a copy of this software and associated documentation
+	files (the "Software"), to deal	in the Software without
+	restriction, including without limitation the rights to use,
+	copy, modify, merge, publish, distribute, sublicense, and/or
+	sell copies of the Software, and to permit persons to whom the
+	Software is	furnished to do so, subject to the following
+	conditions:
+
+	The above copyright notice and this permission notice shall be
+	included in	all copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+	OF MERCHANTABILITY,	FITNESS FOR A PARTICULAR PURPOSE AND
+	NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+	OTHER DEALINGS IN THE SOFTWARE.
+
+	Developed by: Neil Kemp at Rendering Systems Inc.
+
+	Online:		http://shadermap.com
+	Corporate:	http://renderingsystems.com
+
+	===============================================================
+*/
+
+#ifndef PLUGIN_PIXEL_KERNEL_CPP
+#define PLUGIN_PIXEL_KERNEL_CPP
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Pixel kernel includes
+
+#include "plugin_half_batch.cpp"
+#include "plugin_thread_pool.cpp"
+#include <new>
+#include <vector>
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Pixel kernel defines
+
+// Rows processed between calls to the plugin cancel function by pixel_kernel_run_area().
+#define PIXEL_KERNEL_CANCEL_ROW_COUNT			64
+
+// Rows in each band pixel_kernel_run() gives to a thread.
+#define PIXEL_KERNEL_BAND_ROW_COUNT				16
+
+// The cancel function of the plugin core this file is included in.
+#if defined(MAP_PLUGIN_TYPE_SOURCE)
+	#define PIXEL_KERNEL_IS_CANCEL()			(mp_is_cancel_process && mp_is_cancel_process())
+#elif defined(FILTER_NORMAL_NONE)
+	#define PIXEL_KERNEL_IS_CANCEL()			(fp_is_cancel_process && fp_is_cancel_process())
+#else
+	#define PIXEL_KERNEL_IS_CANCEL()			(FALSE)
+#endif
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Pixel kernel structs
+
+// The pixels a kernel runs on.
+struct pixel_kernel_image_s
+{
+	const void*									source_pixel_array;			// Half float pixels, origin upper left.
+	void*										destination_pixel_array;	// Can be the same as source_pixel_array.
+	unsigned int								width;
+	unsigned int								height;
+	BOOL										is_grayscale;				// 2 half floats per pixel if TRUE else 4.
+	unsigned int								tile_type;					// One of the MAP_TILE definitions. Used by area kernels.
+
+	// c()
+	pixel_kernel_image_s(void)
+	{	source_pixel_array = 0; destination_pixel_array = 0;
+		width = height = 0; is_grayscale = FALSE; tile_type = MAP_TILE_NONE;
+	}
+};
+
+// The source rows around the row an area kernel is writing.
+struct pixel_kernel_area_s
+{
+	const float* const*							row_array;					// 2 * radius + 1 rows, row_array[radius] is the current row.
+	int											radius;
+	unsigned int								channel_count;
+
+	// Return the source pixel at column x (-radius to width + radius - 1) of the row dy (-radius to radius) from the current row.
+	inline const float* get_pixel(int x, int dy) const
+	{	return row_array[radius + dy] + x * (int)channel_count;
+	}
+};
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Pixel kernel functions
+
+#if defined(FILTER_NORMAL_NONE)
+// Return the image of a filter process call. The filter works in place.
+pixel_kernel_image_s pixel_kernel_get_image(const process_data_s& data)
+{
+	pixel_kernel_image_s image;
+
+	image.source_pixel_array		= data.map_pixel_data;
+	image.destination_pixel_array	= data.map_pixel_data;
+	image.width						= data.map_width;
+	image.height					= data.map_height;
+	image.is_grayscale				= data.is_grayscale;
+	image.tile_type					= data.map_tile_type;
+	return image;
+}
+#endif
+
+#if defined(MAP_PLUGIN_TYPE_SOURCE)
+// Return the image of a map being created. source_pixel_array is usually an input pixel array and destination_pixel_array
+// the pixel array returned by mp_create_map(). The source must have the size and format of create_info.
+pixel_kernel_image_s pixel_kernel_get_image(const map_create_info_s& create_info, const void* source_pixel_array, void* destination_pixel_array)
+{
+	pixel_kernel_image_s image;
+
+	image.source_pixel_array		= source_pixel_array;
+	image.destination_pixel_array	= destination_pixel_array;
+	image.width						= create_info.width;
+	image.height					= create_info.height;
+	image.is_grayscale				= create_info.is_grayscale;
+	image.tile_type					= create_info.tile_type;
+	return image;
+}
+#endif
+
+// Convert a row of mask pixels to 0.0f - 1.0f.
+inline void pixel_kernel_get_mask_row(const unsigned short* mask_row, float* mask_row_out, unsigned int width)
+{
+	for(unsigned int x=0; x<width; x++)
+	{	mask_row_out[x] = mask_row[x] * (1.0f / 65535.0f);
+	}
+}
+
+// Pixel kernel row loop. One instance for each channel count and mask state.
+template<unsigned int CHANNEL_COUNT, bool IS_MASK, class KERNEL_T>
+BOOL pixel_kernel_run_rows(const pixel_kernel_image_s& image, const unsigned short* mask_pixel_array, const KERNEL_T& kernel,
+						   unsigned int y_start, unsigned int y_end)
+{
+	// Local data
+	std::vector<float>							row_list, mask_list;
+	float*										row;
+	float*										mask_row;
+
+
+	try
+	{	row_list.resize((size_t)image.width * CHANNEL_COUNT);
+		mask_list.resize(IS_MASK ? image.width : 1);
+	}
+	catch(...)
+	{	return FALSE;
+	}
+	row			= &row_list[0];
+	mask_row	= &mask_list[0];
+
+	for(unsigned int y=y_start; y<y_end; y++)
+	{
+		half_batch_get_row(image.source_pixel_array, image.width, CHANNEL_COUNT, y, row);
+		if(IS_MASK)
+		{	pixel_kernel_get_mask_row(&mask_pixel_array[(size_t)y * image.width], mask_row, image.width);
+			for(unsigned int x=0; x<image.width; x++)
+			{	kernel.template process_pixel<CHANNEL_COUNT>(&row[x * CHANNEL_COUNT], mask_row[x]);
+			}
+		}
+		else
+		{	for(unsigned int x=0; x<image.width; x++)
+			{	kernel.template process_pixel<CHANNEL_COUNT>(&row[x * CHANNEL_COUNT], 1.0f);
+			}
+		}
+		half_batch_set_row(image.destination_pixel_array, image.width, CHANNEL_COUNT, y, row);
+	}
+	return TRUE;
+}
+
+// Run a pixel kernel on rows y_start to y_end - 1 on the calling thread. Does not check for cancel. Rows can be run in any
+// order and from several threads at once.
+template<class KERNEL_T>
+BOOL pixel_kernel_run(const pixel_kernel_image_s& image, const unsigned short* mask_pixel_array, const KERNEL_T& kernel,
+					  unsigned int y_start, unsigned int y_end)
+{
+	if(image.is_grayscale)
+	{	return mask_pixel_array ? pixel_kernel_run_rows<2, true>(image, mask_pixel_array, kernel, y_start, y_end) :
+								  pixel_kernel_run_rows<2, false>(image, mask_pixel_array, kernel, y_start, y_end);
+	}
+	return mask_pixel_array ? pixel_kernel_run_rows<4, true>(image, mask_pixel_array, kernel, y_start, y_end) :
+							  pixel_kernel_run_rows<4, false>(image, mask_pixel_array, kernel, y_start, y_end);
+}
+
+// Runs a band of rows of pixel_kernel_run() on a pool thread.
+template<class KERNEL_T>
+struct pixel_kernel_band_s
+{
+	const pixel_kernel_image_s*					image;
+	const unsigned short*						mask_pixel_array;
+	const KERNEL_T*								kernel;
+
+	BOOL operator()(unsigned int y_start, unsigned int y_end) const
+	{	return pixel_kernel_run(*image, mask_pixel_array, *kernel, y_start, y_end);
+	}
+};
+
+// Run a pixel kernel on every pixel in bands of rows on the plugin thread pool. Progress is set by progress as bands finish.
+template<class KERNEL_T>
+BOOL pixel_kernel_run(const pixel_kernel_image_s& image, const unsigned short* mask_pixel_array, const KERNEL_T& kernel,
+					  const parallel_progress_s& progress)
+{
+	pixel_kernel_band_s<KERNEL_T> band;
+
+	band.image				= &image;
+	band.mask_pixel_array	= mask_pixel_array;
+	band.kernel				= &kernel;
+	return parallel_for_rows(image.height, PIXEL_KERNEL_BAND_ROW_COUNT, band, progress);
+}
+
+// Run a pixel kernel on every pixel in bands of rows on the plugin thread pool.
+template<class KERNEL_T>
+BOOL pixel_kernel_run(const pixel_kernel_image_s& image, const unsigned short* mask_pixel_array, const KERNEL_T& kernel)
+{
+	return pixel_kernel_run(image, mask_pixel_array, kernel, parallel_progress_s());
+}
+
+// Return the source row of the padded row index y. Wraps if tiled in Y else clamps to the edge row.
+inline unsigned int pixel_kernel_resolve_row(int y, unsigned int height, BOOL is_tile_y)
+{
+	if(is_tile_y)
+	{	return (unsigned int)(((y % (int)height) + (int)height) % (int)height);
+	}
+	return (unsigned int)(y < 0 ? 0 : (y >= (int)height ? (int)height - 1 : y));
+}
+
+// Load source row y into a padded row of width + 2 * radius pixels. The padding wraps if tiled in X else repeats the edge pixel.
+template<unsigned int CHANNEL_COUNT>
+void pixel_kernel_load_padded_row(const float* row, float* padded_row_out, unsigned int width, int radius, BOOL is_tile_x)
+{
+	memcpy(&padded_row_out[radius * CHANNEL_COUNT], row, sizeof(float) * width * CHANNEL_COUNT);
+	for(int p=0; p<radius; p++)
+	{	int left	= is_tile_x ? ((((-radius + p) % (int)width) + (int)width) % (int)width) : 0;
+		int right	= is_tile_x ? ((int)(width + p) % (int)width) : (int)width - 1;
+		for(unsigned int c=0; c<CHANNEL_COUNT; c++)
+		{	padded_row_out[p * CHANNEL_COUNT + c]								= row[left * CHANNEL_COUNT + c];
+			padded_row_out[(radius + width + p) * CHANNEL_COUNT + c]			= row[right * CHANNEL_COUNT + c];
+		}
+	}
+}
+
+// Area kernel row loop. One instance for each radius, channel count and mask state.
+template<int RADIUS, unsigned int CHANNEL_COUNT, bool IS_MASK, class KERNEL_T>
+BOOL pixel_kernel_run_area_rows(const pixel_kernel_image_s& image, const unsigned short* mask_pixel_array, const KERNEL_T& kernel)
+{
+	// Local data
+	const unsigned int							window_count	= 2 * RADIUS + 1;
+	const size_t								padded_size		= ((size_t)image.width + 2 * RADIUS) * CHANNEL_COUNT;
+	const BOOL									is_tile_x		= (image.tile_type & MAP_TILE_X) ? TRUE : FALSE;
+	const BOOL									is_tile_y		= (image.tile_type & MAP_TILE_Y) ? TRUE : FALSE;
+	const BOOL									is_in_place		= (image.source_pixel_array == image.destination_pixel_array) ? TRUE : FALSE;
+	std::vector<float>							ring_list, top_list, row_list, out_list, mask_list;
+	const float*								window_array[window_count];
+	pixel_kernel_area_s							area;
+	unsigned int								top_count;
+
+
+	// Rows written in place are lost, but a tiled map reads the first rows again at the bottom edge. Keep a copy of them.
+	top_count = (is_in_place && is_tile_y) ? (unsigned int)std::min<int>(RADIUS, (int)image.height) : 0;
+	try
+	{	ring_list.resize(padded_size * window_count);
+		top_list.resize(padded_size * (top_count ? top_count : 1));
+		row_list.resize((size_t)image.width * CHANNEL_COUNT);
+		out_list.resize((size_t)image.width * CHANNEL_COUNT);
+		mask_list.resize(IS_MASK ? image.width : 1);
+	}
+	catch(...)
+	{	return FALSE;
+	}
+
+	// A map smaller than the window would need rows already written. Work from a copy.
+	std::vector<unsigned short> source_copy_list;
+	pixel_kernel_image_s source_image = image;
+	if(is_in_place && image.height <= 2 * RADIUS)
+	{	size_t count = (size_t)image.width * image.height * CHANNEL_COUNT;
+		try
+		{	source_copy_list.assign((const unsigned short*)image.source_pixel_array, (const unsigned short*)image.source_pixel_array + count);
+		}
+		catch(...)
+		{	return FALSE;
+		}
+		source_image.source_pixel_array = &source_copy_list[0];
+		top_count = 0;
+	}
+
+	for(unsigned int t=0; t<top_count; t++)
+	{	half_batch_get_row(source_image.source_pixel_array, image.width, CHANNEL_COUNT, t, &row_list[0]);
+		pixel_kernel_load_padded_row<CHANNEL_COUNT>(&row_list[0], &top_list[padded_size * t], image.width, RADIUS, is_tile_x);
+	}
+
+	area.row_array		= window_array;
+	area.radius			= RADIUS;
+	area.channel_count	= CHANNEL_COUNT;
+
+	// The ring holds the padded source rows y - RADIUS to y + RADIUS, slot (y + RADIUS) % window_count is the newest row.
+	for(int j=-RADIUS; j<(int)image.height + RADIUS; j++)
+	{
+		unsigned int	slot	= (unsigned int)(j + RADIUS) % window_count;
+		unsigned int	source	= pixel_kernel_resolve_row(j, image.height, is_tile_y);
+		int				y		= j - RADIUS;
+
+		if(source < top_count && j >= (int)image.height)
+		{	memcpy(&ring_list[padded_size * slot], &top_list[padded_size * source], sizeof(float) * padded_size);
+		}
+		else
+		{	half_batch_get_row(source_image.source_pixel_array, image.width, CHANNEL_COUNT, source, &row_list[0]);
+			pixel_kernel_load_padded_row<CHANNEL_COUNT>(&row_list[0], &ring_list[padded_size * slot], image.width, RADIUS, is_tile_x);
+		}
+
+		// Write row y once rows y - RADIUS to y + RADIUS are loaded.
+		if(y < 0)
+		{	continue;
+		}
+		if(y % PIXEL_KERNEL_CANCEL_ROW_COUNT == PIXEL_KERNEL_CANCEL_ROW_COUNT - 1 && PIXEL_KERNEL_IS_CANCEL())
+		{	return FALSE;
+		}
+		for(unsigned int w=0; w<window_count; w++)
+		{	window_array[w] = &ring_list[padded_size * ((unsigned int)(y + (int)w) % window_count) + RADIUS * CHANNEL_COUNT];
+		}
+		memcpy(&out_list[0], window_array[RADIUS], sizeof(float) * image.width * CHANNEL_COUNT);
+		if(IS_MASK)
+		{	pixel_kernel_get_mask_row(&mask_pixel_array[(size_t)y * image.width], &mask_list[0], image.width);
+			for(unsigned int x=0; x<image.width; x++)
+			{	kernel.template process_area<CHANNEL_COUNT>(area, (int)x, &out_list[x * CHANNEL_COUNT], mask_list[x]);
+			}
+		}
+		else
+		{	for(unsigned int x=0; x<image.width; x++)
+			{	kernel.template process_area<CHANNEL_COUNT>(area, (int)x, &out_list[x * CHANNEL_COUNT], 1.0f);
+			}
+		}
+		half_batch_set_row(image.destination_pixel_array, image.width, CHANNEL_COUNT, (unsigned int)y, &out_list[0]);
+	}
+	return TRUE;
+}
+
+// Run an area kernel that reads RADIUS pixels around each pixel. Rows are processed in order on the calling thread.
+template<int RADIUS, class KERNEL_T>
+BOOL pixel_kernel_run_area(const pixel_kernel_image_s& image, const unsigned short* mask_pixel_array, const KERNEL_T& kernel)
+{
+	if(!image.width || !image.height)
+	{	return TRUE;
+	}
+	if(image.is_grayscale)
+	{	return mask_pixel_array ? pixel_kernel_run_area_rows<RADIUS, 2, true>(image, mask_pixel_array, kernel) :
+								  pixel_kernel_run_area_rows<RADIUS, 2, false>(image, mask_pixel_array, kernel);
+	}
+	return mask_pixel_array ? pixel_kernel_run_area_rows<RADIUS, 4, true>(image, mask_pixel_array, kernel) :
+							  pixel_kernel_run_area_rows<RADIUS, 4, false>(image, mask_pixel_array, kernel);
+}
+
+#endif // PLUGIN_PIXEL_KERNEL_CPP
@@ -0,0 +1,527 @@
+/*
+	===============================================================
+
+	SHADERMAP PLUGIN THREAD POOL SOURCE FILE
+
+	Runs a loop on several threads, no more than the map thread
+	limit set by ShaderMap.
+
+	ShaderMap processes several maps at once and gives each map a
+	thread limit, returned by mp_get_map_thread_limit() or
+	fp_get_map_thread_limit(). A plugin that uses more threads
+	than its limit competes with the other maps for the cores.
+
+	The threads of the pool are created when first needed and kept
+	until parallel_shutdown() is called, so a loop does not pay for
+	creating threads. The thread that calls a parallel_for function
+	works on the loop too. It is the only thread that calls the
+	plugin cancel and progress functions: the cancel function no
+	more than once every PARALLEL_POLL_MS milliseconds and the
+	progress function only when the progress value changes.
+
+	Include this source code file in a map or filter plugin after
+	the plugin core file. #include "../../../common/plugin_thread_pool.cpp"
+	Geometry plugins have no thread limit, loops there run on all
+	cores. Their progress is set with gp_set_progress() and they
+	are cancelled with gp_is_cancel_process() when ShaderMap
+	provides them.
+
+	--
+
+	Example:
+
+	struct brighten_rows_s
+	{
+		...
+
+		// Process rows y_start to y_end - 1. Return FALSE on error.
+		BOOL operator()(unsigned int y_start, unsigned int y_end) const
+		{	...
+			return TRUE;
+		}
+	};
+
+	if(!parallel_for_rows(height, 16, body, parallel_get_progress(map_id, 0, 100)))
+	{	return FALSE;		// Cancelled or a body returned FALSE.
+	}
+
+	parallel_for() runs body(index_start, index_end) over chunks
+	of an index range. parallel_for_rows() does the same for bands
+	of image rows. parallel_for_tiles() runs
+	body(x_start, y_start, x_end, y_end) over square tiles.
+
+	Bodies are called on any thread in any order and must not call
+	ShaderMap functions. Pass a default parallel_progress_s to skip
+	progress updates.
+
+	Call parallel_shutdown() from on_shutdown() to stop the threads.
+
+
+	SHADERMAP SDK LICENSE
+
+	The ShaderMap SDK is released under The MIT License (MIT)
+	http://opensource.org/licenses/MIT
+
+	Copyright (c) 2007-2019 Rendering Systems Inc.
+
+	Permission is hereby granted, free of charge, to any person
+	obtaining a copy of this software and associated documentation
+	files (the "Software"), to deal	in the Software without
+	restriction, including without limitation the rights to use,
+	copy, modify, merge, publish, distribute, sublicense, and/or
+	sell copies of the Software, and to permit persons to whom the
+	Software is	furnished to do so, subject to the following
+	conditions:
+
+	The above copyright notice and this permission notice shall be
+	included in	all copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+	OF MERCHANTABILITY,	FITNESS FOR A PARTICULAR PURPOSE AND
+	NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+	OTHER DEALINGS IN THE SOFTWARE.
+
+	Developed by: Neil Kemp at Rendering Systems Inc.
+
+	Online:		http://shadermap.com
+	Corporate:	http://renderingsystems.com
+
+	===============================================================
+*/
+
+#ifndef PLUGIN_THREAD_POOL_CPP
+#define PLUGIN_THREAD_POOL_CPP
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Thread pool includes
+
+#include <limits.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Thread pool defines
+
+// Most threads a loop runs on, including the calling thread.
+#ifndef PARALLEL_MAX_THREAD_COUNT
+#define PARALLEL_MAX_THREAD_COUNT				256
+#endif
+
+// Least time between calls to the plugin cancel function.
+#ifndef PARALLEL_POLL_MS
+#define PARALLEL_POLL_MS						5
+#endif
+
+// The functions of the plugin core this file is included in.
+#if defined(MAP_PLUGIN_TYPE_SOURCE)
+	#define PARALLEL_GET_THREAD_LIMIT()			(mp_get_map_thread_limit ? mp_get_map_thread_limit() : 0)
+	#define PARALLEL_IS_CANCEL()				(mp_is_cancel_process && mp_is_cancel_process())
+#elif defined(FILTER_NORMAL_NONE)
+	#define PARALLEL_GET_THREAD_LIMIT()			(fp_get_map_thread_limit ? fp_get_map_thread_limit() : 0)
+	#define PARALLEL_IS_CANCEL()				(fp_is_cancel_process && fp_is_cancel_process())
+#elif defined(GP_GEOMETRY_TYPE_RENDER)
+	#define PARALLEL_GET_THREAD_LIMIT()			(0)
+	#define PARALLEL_IS_CANCEL()				(gp_is_cancel_process && gp_is_cancel_process())
+#else
+	#define PARALLEL_GET_THREAD_LIMIT()			(0)
+	#define PARALLEL_IS_CANCEL()				(FALSE)
+#endif
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Thread pool structs
+
+// Where a loop reports progress. Default is no progress.
+struct parallel_progress_s
+{
+	unsigned int								map_id;
+	int											filter_position;			// Filter plugins only.
+	unsigned int								progress_start;				// Progress when the loop starts and ends, 0 - 100.
+	unsigned int								progress_end;
+	BOOL										is_set;
+
+	// c()
+	parallel_progress_s(void)
+	{	map_id = 0; filter_position = 0; progress_start = 0; progress_end = 100; is_set = FALSE;
+	}
+};
+
+// A running loop. Lives on the stack of the calling thread.
+struct parallel_job_s
+{
+	BOOL										(*run_function)(const void* body, unsigned int index_start, unsigned int index_end);
+	const void*									body;
+	unsigned int								count;
+	unsigned int								chunk_size;
+	unsigned int								chunk_count;
+	unsigned int								worker_limit;				// Pool threads allowed to join, the calling thread not included.
+	unsigned int								worker_count;				// Pool threads working on the loop. Guarded by the pool mutex.
+	std::atomic<unsigned int>					next_chunk;
+	std::atomic<unsigned int>					done_chunk_count;
+	std::atomic<bool>							is_stop;					// Cancelled or a body failed.
+};
+
+// The thread pool of the plugin.
+struct parallel_pool_s
+{
+	std::mutex									mutex;
+	std::condition_variable						work_condition;				// Signalled when a loop starts or the pool stops.
+	std::condition_variable						done_condition;				// Signalled when a thread leaves a loop.
+	std::vector<std::thread*>					thread_list;				// Never destroyed without a join, see parallel_shutdown().
+	std::vector<parallel_job_s*>				job_list;
+	bool										is_quit;
+
+	// c()
+	parallel_pool_s(void)
+	{	is_quit = false;
+	}
+};
+
+static parallel_pool_s							parallel_pool;
+
+// Calls a loop body through a pointer without knowing its type.
+template<class BODY_T>
+BOOL parallel_run_body(const void* body, unsigned int index_start, unsigned int index_end)
+{
+	return (*(const BODY_T*)body)(index_start, index_end);
+}
+
+// Runs the tiles of a chunk of tile indices.
+template<class BODY_T>
+struct parallel_tile_body_s
+{
+	const BODY_T*								body;
+	unsigned int								width;
+	unsigned int								height;
+	unsigned int								tile_size;
+	unsigned int								tile_column_count;
+
+	BOOL operator()(unsigned int index_start, unsigned int index_end) const
+	{	for(unsigned int i=index_start; i<index_end; i++)
+		{	unsigned int x = (i % tile_column_count) * tile_size, y = (i / tile_column_count) * tile_size;
+			if(!(*body)(x, y, std::min<unsigned int>(x + tile_size, width), std::min<unsigned int>(y + tile_size, height)))
+			{	return FALSE;
+			}
+		}
+		return TRUE;
+	}
+};
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Thread pool functions
+
+#if defined(MAP_PLUGIN_TYPE_SOURCE)
+// Return a progress that sets the map progress from progress_start to progress_end as a loop runs.
+parallel_progress_s parallel_get_progress(unsigned int map_id, unsigned int progress_start, unsigned int progress_end)
+{
+	parallel_progress_s progress;
+
+	progress.map_id			= map_id;
+	progress.progress_start	= progress_start;
+	progress.progress_end	= progress_end;
+	progress.is_set			= TRUE;
+	return progress;
+}
+#endif
+
+#if defined(GP_GEOMETRY_TYPE_RENDER)
+// Return a progress that sets the import progress from progress_start to progress_end as a loop runs.
+parallel_progress_s parallel_get_progress(unsigned int progress_start, unsigned int progress_end)
+{
+	parallel_progress_s progress;
+
+	progress.progress_start	= progress_start;
+	progress.progress_end	= progress_end;
+	progress.is_set			= TRUE;
+	return progress;
+}
+#endif
+
+#if defined(FILTER_NORMAL_NONE)
+// Return a progress that sets the filter progress from progress_start to progress_end as a loop runs.
+parallel_progress_s parallel_get_progress(unsigned int map_id, int filter_position, unsigned int progress_start, unsigned int progress_end)
+{
+	parallel_progress_s progress;
+
+	progress.map_id				= map_id;
+	progress.filter_position	= filter_position;
+	progress.progress_start		= progress_start;
+	progress.progress_end		= progress_end;
+	progress.is_set				= TRUE;
+	return progress;
+}
+#endif
+
+// Set the progress of a loop with done_count of count chunks done. Called only when the value changes.
+void parallel_set_progress(const parallel_progress_s& progress, unsigned int done_count, unsigned int count, unsigned int& last_value_in_out)
+{
+	// Local data
+	unsigned int								value;
+
+
+	if(!progress.is_set || !count)
+	{	return;
+	}
+	value = progress.progress_start + (unsigned int)((unsigned long long)(progress.progress_end - progress.progress_start) * done_count / count);
+	if(value == last_value_in_out)
+	{	return;
+	}
+	last_value_in_out = value;
+
+#if defined(MAP_PLUGIN_TYPE_SOURCE)
+	if(mp_set_map_progress)
+	{	mp_set_map_progress(progress.map_id, value);
+	}
+#elif defined(FILTER_NORMAL_NONE)
+	if(fp_set_filter_progress)
+	{	fp_set_filter_progress(progress.map_id, progress.filter_position, value);
+	}
+#elif defined(GP_GEOMETRY_TYPE_RENDER)
+	if(gp_set_progress)
+	{	gp_set_progress(value);
+	}
+#endif
+}
+
+// Return the threads a loop may run on: the map thread limit, or the core count if ShaderMap sets no limit.
+unsigned int parallel_get_thread_limit(void)
+{
+	unsigned int thread_limit = PARALLEL_GET_THREAD_LIMIT();
+
+	if(!thread_limit)
+	{	thread_limit = std::thread::hardware_concurrency();
+	}
+	return std::max<unsigned int>(1, std::min<unsigned int>(thread_limit, PARALLEL_MAX_THREAD_COUNT));
+}
+
+// Run chunks of a loop until none are left or the loop is stopped. Returns after each chunk if is_return_each.
+void parallel_run_chunks(parallel_job_s& job, bool is_return_each)
+{
+	// Local data
+	unsigned int								chunk, index_start, index_end;
+	BOOL										is_success;
+
+
+	while(!job.is_stop)
+	{
+		chunk = job.next_chunk++;
+		if(chunk >= job.chunk_count)
+		{	return;
+		}
+		index_start	= chunk * job.chunk_size;
+		index_end	= std::min<unsigned int>(index_start + job.chunk_size, job.count);
+		try
+		{	is_success = job.run_function(job.body, index_start, index_end);
+		}
+		catch(...)
+		{	is_success = FALSE;
+		}
+		if(!is_success)
+		{	job.is_stop = true;
+		}
+		job.done_chunk_count++;
+		if(is_return_each)
+		{	return;
+		}
+	}
+}
+
+// Pool thread - joins loops that want more threads until the pool stops.
+void parallel_worker_thread(void)
+{
+	// Local data
+	std::unique_lock<std::mutex>				lock(parallel_pool.mutex);
+	parallel_job_s*								job;
+
+
+	for(;;)
+	{
+		job = 0;
+		for(size_t i=0; i<parallel_pool.job_list.size(); i++)
+		{	parallel_job_s* candidate = parallel_pool.job_list[i];
+			if(candidate->worker_count < candidate->worker_limit && candidate->next_chunk < candidate->chunk_count && !candidate->is_stop)
+			{	job = candidate;
+				break;
+			}
+		}
+		if(!job)
+		{	if(parallel_pool.is_quit)
+			{	return;
+			}
+			parallel_pool.work_condition.wait(lock);
+			continue;
+		}
+
+		job->worker_count++;
+		lock.unlock();
+		parallel_run_chunks(*job, false);
+		lock.lock();
+		job->worker_count--;
+		parallel_pool.done_condition.notify_all();
+	}
+}
+
+// Start pool threads until there is one for each thread the running loops may use. Called with the pool locked.
+void parallel_grow_pool(void)
+{
+	// Local data
+	size_t										thread_count = 0;
+
+
+	for(size_t i=0; i<parallel_pool.job_list.size(); i++)
+	{	thread_count += parallel_pool.job_list[i]->worker_limit;
+	}
+	thread_count = std::min<size_t>(thread_count, PARALLEL_MAX_THREAD_COUNT - 1);
+
+	while(parallel_pool.thread_list.size() < thread_count)
+	{	try
+		{	parallel_pool.thread_list.push_back(new std::thread(parallel_worker_thread));
+		}
+		catch(...)
+		{	return;			// Run on the threads there are.
+		}
+	}
+}
+
+// Run a loop. Returns FALSE if cancelled or a body returned FALSE.
+BOOL parallel_run(parallel_job_s& job, const parallel_progress_s& progress)
+{
+	// Local data
+	std::chrono::steady_clock::time_point		poll_time;
+	unsigned int								thread_limit, progress_value;
+
+
+	if(!job.chunk_count)
+	{	return TRUE;
+	}
+	progress_value		= UINT_MAX;
+	thread_limit		= parallel_get_thread_limit();
+	job.worker_limit	= std::min<unsigned int>(thread_limit, job.chunk_count) - 1;
+	job.worker_count	= 0;
+	job.next_chunk		= 0;
+	job.done_chunk_count = 0;
+	job.is_stop			= false;
+
+	if(job.worker_limit)
+	{	std::lock_guard<std::mutex> lock(parallel_pool.mutex);
+		parallel_pool.job_list.push_back(&job);
+		parallel_grow_pool();
+		parallel_pool.work_condition.notify_all();
+	}
+
+	// Work on the loop, and be the only thread that polls for cancel and sets progress.
+	poll_time = std::chrono::steady_clock::now();
+	while(!job.is_stop && job.next_chunk < job.chunk_count)
+	{	parallel_run_chunks(job, true);
+		if(std::chrono::steady_clock::now() - poll_time >= std::chrono::milliseconds(PARALLEL_POLL_MS))
+		{	poll_time = std::chrono::steady_clock::now();
+			if(PARALLEL_IS_CANCEL())
+			{	job.is_stop = true;
+			}
+		}
+		parallel_set_progress(progress, job.done_chunk_count, job.chunk_count, progress_value);
+	}
+
+	// Wait for the pool threads to finish their chunks. The job must not be used by them after it returns.
+	if(job.worker_limit)
+	{	std::unique_lock<std::mutex> lock(parallel_pool.mutex);
+		parallel_pool.job_list.erase(std::find(parallel_pool.job_list.begin(), parallel_pool.job_list.end(), &job));
+		while(job.worker_count)
+		{	parallel_pool.done_condition.wait_for(lock, std::chrono::milliseconds(PARALLEL_POLL_MS));
+			if(job.worker_count)
+			{	lock.unlock();
+				if(!job.is_stop && PARALLEL_IS_CANCEL())
+				{	job.is_stop = true;
+				}
+				parallel_set_progress(progress, job.done_chunk_count, job.chunk_count, progress_value);
+				lock.lock();
+			}
+		}
+	}
+
+	if(job.is_stop)
+	{	return FALSE;
+	}
+	parallel_set_progress(progress, job.chunk_count, job.chunk_count, progress_value);
+	return TRUE;
+}
+
+// Run body(index_start, index_end) over 0 to count - 1 in chunks of chunk_size. Returns FALSE if cancelled or a body returned FALSE.
+template<class BODY_T>
+BOOL parallel_for(unsigned int count, unsigned int chunk_size, const BODY_T& body, const parallel_progress_s& progress)
+{
+	parallel_job_s job;
+
+	chunk_size			= std::max<unsigned int>(1, chunk_size);
+	job.run_function	= parallel_run_body<BODY_T>;
+	job.body			= &body;
+	job.count			= count;
+	job.chunk_size		= chunk_size;
+	job.chunk_count		= (unsigned int)(((unsigned long long)count + chunk_size - 1) / chunk_size);
+	return parallel_run(job, progress);
+}
+
+// Run body(y_start, y_end) over rows 0 to height - 1 in bands of band_row_count rows.
+template<class BODY_T>
+BOOL parallel_for_rows(unsigned int height, unsigned int band_row_count, const BODY_T& body, const parallel_progress_s& progress)
+{
+	return parallel_for(height, band_row_count, body, progress);
+}
+
+// Run body(x_start, y_start, x_end, y_end) over tiles of tile_size x tile_size pixels. Tiles on the right and bottom edges
+// can be smaller.
+template<class BODY_T>
+BOOL parallel_for_tiles(unsigned int width, unsigned int height, unsigned int tile_size, const BODY_T& body, const parallel_progress_s& progress)
+{
+	parallel_tile_body_s<BODY_T> tile_body;
+
+	if(!width || !height)
+	{	return TRUE;
+	}
+	tile_body.body				= &body;
+	tile_body.width				= width;
+	tile_body.height			= height;
+	tile_body.tile_size			= std::max<unsigned int>(1, tile_size);
+	tile_body.tile_column_count	= (width + tile_body.tile_size - 1) / tile_body.tile_size;
+	return parallel_for(tile_body.tile_column_count * ((height + tile_body.tile_size - 1) / tile_body.tile_size), 1, tile_body, progress);
+}
+
+// Stop and join the pool threads. Call from on_shutdown() with no loop running.
+void parallel_shutdown(void)
+{
+	// Local data
+	std::vector<std::thread*>					thread_list;
+
+
+	{	std::lock_guard<std::mutex> lock(parallel_pool.mutex);
+		parallel_pool.is_quit = true;
+		thread_list.swap(parallel_pool.thread_list);
+	}
+	parallel_pool.work_condition.notify_all();
+
+	for(size_t i=0; i<thread_list.size(); i++)
+	{	thread_list[i]->join();
+		delete thread_list[i];
+	}
+
+	std::lock_guard<std::mutex> lock(parallel_pool.mutex);
+	parallel_pool.is_quit = false;
+}
+
+#endif // PLUGIN_THREAD_POOL_CPP
@@ -173,7 +173,9 @@
 // ----------------------------------------------------------------
 // Plugin includes
 
-#include "..\..\filter_plugin_core.cpp"
+#include "../../filter_plugin_core.cpp"
+#include "../../../common/plugin_pixel_kernel.cpp"
+#include "../../../common/plugin_mask.cpp"
 #include <string>
 
 // Have to undefine Min and Max macros so they don't interfere with the half.hpp file
@@ -199,8 +201,34 @@
 // Helper function prototypes - defined at bottom of this source code page.
 
 float							clamp_f(float v);
-unsigned short*					resize_mask_pixels(unsigned short* mask_pixel_array, unsigned int mask_width, unsigned int mask_height, 
-												   unsigned int new_width, unsigned int new_height);
+
+
+// ------------------------------------------------------------------
+// ------------------------------------------------------------------
+// Pixel kernel - see "common/plugin_pixel_kernel.cpp".
+
+// Adds the channel modifiers to a pixel.
+struct rgba_kernel_s
+{
+	float						r, g, b, a;
+
+	// Called for every pixel. Grayscale pixels are (C, A) and use red for the color.
+	template<unsigned int CHANNEL_COUNT> void process_pixel(float* pixel, float mask) const
+	{
+		// Multiply the channel modifier by the mask value (1.0f without a mask).
+		// Clamp to range 0.0f to 1.0f.
+		if(CHANNEL_COUNT == 2)
+		{	pixel[0] = clamp_f(pixel[0] + (r * mask));
+			pixel[1] = clamp_f(pixel[1] + (a * mask));
+		}
+		else
+		{	pixel[0] = clamp_f(pixel[0] + (r * mask));
+			pixel[1] = clamp_f(pixel[1] + (g * mask));
+			pixel[2] = clamp_f(pixel[2] + (b * mask));
+			pixel[3] = clamp_f(pixel[3] + (a * mask));
+		}
+	}
+};
 
 
 // ------------------------------------------------------------------
@@ -249,22 +277,11 @@ BOOL on_initialize(void)
 // Process plugin - called when plugin is asked by ShaderMap to apply a filter to Map Pixels.
 BOOL on_process(const process_data_s& data, BOOL* is_sRGB_out)
 {
-	// Local structs
-	struct pixel_32_s
-	{	half_float::half		c, a;
-	};
-
-	struct pixel_64_s
-	{	half_float::half		r, g, b, a;
-	};
-
 	// Local data
 	float						r, g, b, a;
-	unsigned int				i, count_i, thread_limit, mask_width, mask_height;
-	BOOL						is_use_mask, is_invert_mask;
-	unsigned short*				mask_pixel_array, *local_mask_pixel_array;
-	pixel_32_s*					pixel_array_32;
-	pixel_64_s*					pixel_array_64;
+	BOOL						is_use_mask, is_invert_mask, is_success;
+	const unsigned short*		mask_pixel_array;
+	rgba_kernel_s				kernel;
 
 
 	// Set filter progress.
@@ -281,12 +298,6 @@ BOOL on_process(const process_data_s& data, BOOL* is_sRGB_out)
 
 	// -----------------
 
-	// Get Map thread limit from ShaderMap. Would use this if processing map in multiple threads.
-	// This filter does not use multithreading so this line is for demonstration only.
-	thread_limit = fp_get_map_thread_limit();
-
-	// -----------------
-
 	// Get property values - pay special attention to the property index requested.	
 	// Converting red, green, blue, and alpha to floating points with range -1.0f to 1.0f.
 	r						= fp_get_property_slider(data.map_id, data.filter_position, 0) / 100.0f;
@@ -306,145 +317,50 @@ BOOL on_process(const process_data_s& data, BOOL* is_sRGB_out)
 
 	// -----------------
 
-	// The local dynamic pixel array we use to store mask pixels in.
-	local_mask_pixel_array = 0;
-
-	// Get mask data if enabled	
+	// Get the mask at the map size, inverted if required. The mask is resized with an area or bilinear filter and
+	// kept in a cache until it changes. 0 if the mask is disabled or no mask is set.
+	mask_pixel_array = 0;
 	if(is_use_mask)
-	{	
-		// Get mask size and pixels from ShaderMap.
-		fp_get_map_mask(data.map_id, mask_width, mask_height, &mask_pixel_array);
-
-		// If no mask is set then disable mask usage.
-		if(!mask_pixel_array)
-		{	is_use_mask = FALSE;
-		}
-		else
-		{
-			// Create local copy of mask pixels.
-			local_mask_pixel_array = new (std::nothrow) unsigned short[mask_width * mask_height];
-			if(!local_mask_pixel_array)
-			{	LOG_ERROR_MSG(data.map_id, data.filter_position, _T("Memory Allocation Error: Failed to allocate local_mask_pixel_array."));
-				return FALSE;
-			}
-			memcpy(local_mask_pixel_array, mask_pixel_array, sizeof(unsigned short) * mask_width * mask_height);
-
-			// Resize the mask to the map size if not already the same size.
-			// Using a simple nearest neighbor scale.
-			if(mask_width != data.map_width || mask_height != data.map_height)
-			{
-				// Resize mask - local_mask_pixel_array is released by the function and a new array is allocated and returned with scaled pixels.
-				local_mask_pixel_array = resize_mask_pixels(local_mask_pixel_array, mask_width, mask_height, data.map_width, data.map_height);
-				if(!local_mask_pixel_array)
-				{	LOG_ERROR_MSG(data.map_id, data.filter_position, _T("Resize mask pixels failed. Most likely caused by a memory allocation error."));
-					return FALSE;
-				}
-			}
-
-			// Invert local (resized) mask if required.
-			if(is_invert_mask)
-			{	
-				count_i = data.map_width * data.map_height;
-				for(i=0; i<count_i; i++)
-				{	local_mask_pixel_array[i] = USHRT_MAX - local_mask_pixel_array[i];
-				}
-			}
-		}
+	{	mask_pixel_array = plugin_mask_get(data.map_id, data.map_width, data.map_height, is_invert_mask);
 	}
 
 	// -----------------
 
 	// Check for cancel.
 	if(fp_is_cancel_process())
-	{	if(local_mask_pixel_array)
-		{	delete [] local_mask_pixel_array;
+	{	if(mask_pixel_array)
+		{	plugin_mask_release(mask_pixel_array);
 		}
 		return FALSE;
 	}
 
 	// -----------------
 	
-	// If map is grayscale
-	if(data.is_grayscale)
-	{
-		// Cast the map pixel array to pixel_32_s.
-		pixel_array_32 = (pixel_32_s*)data.map_pixel_data;
-
-		// If using mask
-		if(is_use_mask && local_mask_pixel_array)
-		{
-			// For every map pixel
-			count_i = data.map_width * data.map_height;
-			for(i=0; i<count_i; i++)
-			{
-				// Add the channel modifiers to each channel - use red for grayscale color.
-				// Multiply the channel modifier by the mask pixel converted to scalar.
-				// Clamp to range 0.0f to 1.0f.
-				pixel_array_32[i].c = clamp_f(pixel_array_32[i].c + (r * (local_mask_pixel_array[i] / (float)USHRT_MAX)));
-				pixel_array_32[i].a = clamp_f(pixel_array_32[i].a + (a * (local_mask_pixel_array[i] / (float)USHRT_MAX)));
-			}
-		}
-		// Else no mask
-		else
-		{
-			// For every map pixel
-			count_i = data.map_width * data.map_height;
-			for(i=0; i<count_i; i++)
-			{
-				// Add the channel modifiers to each channel - use red for grayscale color.
-				// Clamp to range 0.0f to 1.0f.
-				pixel_array_32[i].c = clamp_f(pixel_array_32[i].c + r);
-				pixel_array_32[i].a = clamp_f(pixel_array_32[i].a + a);
-			}
-		}
+	// Add the channel modifiers to every pixel. The kernel loops convert whole rows of half floats at a time
+	// and are compiled separately for grayscale and color maps with and without a mask. Bands of rows are run
+	// on the plugin thread pool within the map thread limit.
+	kernel.r	= r;
+	kernel.g	= g;
+	kernel.b	= b;
+	kernel.a	= a;
+	is_success	= pixel_kernel_run(pixel_kernel_get_image(data), mask_pixel_array, kernel, parallel_get_progress(data.map_id, data.filter_position, 0, 100));
+
+	if(mask_pixel_array)
+	{	plugin_mask_release(mask_pixel_array);
+		mask_pixel_array = 0;
 	}
-	// Else map is RGBA
-	else
-	{
-		// Cast the map pixel array to pixel_64_s.
-		pixel_array_64 = (pixel_64_s*)data.map_pixel_data;
-
-		// If using mask
-		if(is_use_mask && local_mask_pixel_array)
-		{
-			// For every map pixel
-			count_i = data.map_width * data.map_height;
-			for(i=0; i<count_i; i++)
-			{
-				// Add the channel modifiers to each channel. 
-				// Multiply the channel modifier by the mask pixel converted to scalar.
-				// Clamp to range 0.0f to 1.0f.
-				pixel_array_64[i].r = clamp_f(pixel_array_64[i].r + (r * (local_mask_pixel_array[i] / (float)USHRT_MAX)));
-				pixel_array_64[i].g = clamp_f(pixel_array_64[i].g + (g * (local_mask_pixel_array[i] / (float)USHRT_MAX)));
-				pixel_array_64[i].b = clamp_f(pixel_array_64[i].b + (b * (local_mask_pixel_array[i] / (float)USHRT_MAX)));
-				pixel_array_64[i].a = clamp_f(pixel_array_64[i].a + (a * (local_mask_pixel_array[i] / (float)USHRT_MAX)));
-			}
-		}
-		// Else no mask
-		else
-		{
-			// For every map pixel
-			count_i = data.map_width * data.map_height;
-			for(i=0; i<count_i; i++)
-			{
-				// Add the channel modifiers to each channel.
-				// Clamp to range 0.0f to 1.0f.
-				pixel_array_64[i].r = clamp_f(pixel_array_64[i].r + r);
-				pixel_array_64[i].g = clamp_f(pixel_array_64[i].g + g);
-				pixel_array_64[i].b = clamp_f(pixel_array_64[i].b + b);
-				pixel_array_64[i].a = clamp_f(pixel_array_64[i].a + a);
-			}
+	if(!is_success)
+	{	if(!fp_is_cancel_process())
+		{	LOG_ERROR_MSG(data.map_id, data.filter_position, _T("Memory Allocation Error: Failed to allocate pixel kernel rows."));
 		}
+		return FALSE;
 	}
 
 	// -----------------
 
 	// Check for cancel.
 	if(fp_is_cancel_process())
-	{	if(local_mask_pixel_array)
-		{	delete [] local_mask_pixel_array;
-		}
-		return FALSE;
+	{	return FALSE;
 	}
 	
 	// -----------------
@@ -463,7 +379,9 @@ BOOL on_process(const process_data_s& data, BOOL* is_sRGB_out)
 // Free any local plugin resources allocated - called by ShaderMap before detaching from the plugin.
 BOOL on_shutdown(void)
 {	
-	// Nothing to do.
+	// Release the cached masks and stop the pool threads.
+	plugin_mask_clear();
+	parallel_shutdown();
 
 	return TRUE;
 }
@@ -489,50 +407,4 @@ float clamp_f(float v)
 	{	return 1.0f;
 	}
 	return v;
-}
-
-// Resize the mask pixels using nearest neighbor scaling
-unsigned short* resize_mask_pixels(unsigned short* mask_pixel_array, unsigned int mask_width, unsigned int mask_height, 
-								   unsigned int new_width, unsigned int new_height)
-{
-	// Local data
-	unsigned int					i, j, x, y, x_delta, y_delta, index;;
-	unsigned short*					resized_pixel_array, *source_line;
-
-
-	// Check for same size and early exit.
-	if(mask_width == new_width && mask_height != new_height)
-	{	return mask_pixel_array;
-	}
-
-	// Allocate new size pixel array.
-	resized_pixel_array = new (std::nothrow) unsigned short[new_width * new_height];
-	if(!resized_pixel_array)
-	{	return 0;
-	}
-
-	// Resize using nearest neighbor scaling.
-	x_delta = (mask_width << 16) / new_width;
-    y_delta = (mask_height << 16) / new_height;
-	y		= 0;
-	index	= 0;	
-	for(j=0; j<new_height; j++)
-	{
-		source_line = &mask_pixel_array[(y >> 16) * mask_width];
-		x			= 0;
-		for(i=0; i<new_width; i++)
-		{
-			resized_pixel_array[index] = source_line[(x >> 16)];
-			x += x_delta;
-			index++;
-		}
-		y += y_delta;
-	}
-
-	// Free old mask pixel array.
-	delete [] mask_pixel_array;
-	mask_pixel_array = 0;
-
-	// Return resized pixels.
-	return resized_pixel_array;
 }
\ No newline at end of file
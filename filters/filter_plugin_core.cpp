@@ -99,6 +99,16 @@
 // Example: LOG_ERROR_MSG(map_id, filter_position, _T("Error description");
 #define											LOG_ERROR_MSG(map_id, filter_position, error) fp_log_filter_error(map_id, filter_position, error, _T(__FUNCTION__), _T(__FILE__), __LINE__);
 
+// Function pointers set by "plugin_initialize()". A host that includes this file with SMSDK_HOST defined never sets or
+// calls them, so they are marked unused there to keep the host build free of warnings.
+#ifndef SMSDK_POINTER
+#if defined(SMSDK_HOST) && defined(__GNUC__)
+#define SMSDK_POINTER							static __attribute__((unused))
+#else
+#define SMSDK_POINTER							static
+#endif
+#endif
+
 
 // ----------------------------------------------------------------
 // ----------------------------------------------------------------
@@ -117,7 +127,7 @@ struct filter_plugin_info_s
 	
 
 	// c()
-	filter_plugin_info_s::filter_plugin_info_s(void)
+	filter_plugin_info_s(void)
 	{
 		version									= 0;
 		name									= 0;
@@ -153,7 +163,7 @@ struct process_data_s
 																		// The map_coordinate_system will contain the normal map's coordinate system.
 
 	// c()
-	process_data_s::process_data_s(void)
+	process_data_s(void)
 	{
 		map_id									= 0;
 		filter_position							= 0;
@@ -207,7 +217,7 @@ fp_define_help_file_type						fp_define_help_file = 0;
 // Set the plugin info by passing a "filter_plugin_info_s" struct to ShaderMap.
 // This should be called in "on_initialize()" between "fp_begin_initialize()" and "fp_end_initialize()"
 typedef void									(*fp_set_plugin_info_type)(const filter_plugin_info_s& /*plugin_info*/);
-static fp_set_plugin_info_type					fp_set_plugin_info = 0;
+SMSDK_POINTER fp_set_plugin_info_type			fp_set_plugin_info = 0;
 
 // Get the option for default coord sys - Useful when setting up the initial value when adding a coordinate system property with "fp_add_property_coordsys()"
 typedef unsigned int							(*fp_get_option_default_coord_sys_type)(void);
@@ -237,47 +247,47 @@ fp_get_option_default_coord_sys_type			fp_get_option_default_coord_sys = 0;
 
 // The page list property (if used) must be the first property added, it defines the number of property pages - see above example.
 typedef void									(*fp_add_property_pagelist_type)(const wchar_t* /*caption*/, const wchar_t** /*string_array*/, unsigned int /*string_count*/, unsigned int /*cur_select*/);
-static fp_add_property_pagelist_type			fp_add_property_pagelist = 0;
+SMSDK_POINTER fp_add_property_pagelist_type		fp_add_property_pagelist = 0;
 
 // Add a file property. Set caption, an initial drive path, and extension filter. Allows the user to set a filepath control to the filter.
 typedef void									(*fp_add_property_file_type)(const wchar_t* /*caption*/, const wchar_t* /*initial_path*/, const wchar_t* /*extension_filter_pointer*/, unsigned int /*page_index*/);
-static fp_add_property_file_type				fp_add_property_file = 0;
+SMSDK_POINTER fp_add_property_file_type			fp_add_property_file = 0;
 
 // Add a checkbox property. Set caption and initial check state.
 typedef void									(*fp_add_property_checkbox_type)(const wchar_t* /*caption*/, BOOL /*is_checked*/, unsigned int /*page_index*/);
-static fp_add_property_checkbox_type			fp_add_property_checkbox = 0;
+SMSDK_POINTER fp_add_property_checkbox_type		fp_add_property_checkbox = 0;
 
 // Add a list property. Set caption, string array and count, as well as initial selected item.
 typedef void									(*fp_add_property_list_type)(const wchar_t* /*caption*/, const wchar_t** /*string_array*/, unsigned int /*string_count*/, unsigned int /*cur_select*/, unsigned int /*page_index*/);
-static fp_add_property_list_type				fp_add_property_list = 0;
+SMSDK_POINTER fp_add_property_list_type			fp_add_property_list = 0;
 
 // Add integer numberbox property. Set the caption, min and max integers, and initial value.
 typedef void									(*fp_add_property_numberbox_int_type)(const wchar_t* /*caption*/, int /*min*/, int /*max*/, int /*value*/, unsigned int /*page_index*/);
-static fp_add_property_numberbox_int_type		fp_add_property_numberbox_int = 0;
+SMSDK_POINTER fp_add_property_numberbox_int_type	fp_add_property_numberbox_int = 0;
 
 // Add floating point numberbox property. Set the caption, min and max floats, and initial value.
 typedef void									(*fp_add_property_numberbox_float_type)(const wchar_t* /*caption*/, float /*min*/, float /*max*/, float /*value*/, unsigned int /*page_index*/);
-static fp_add_property_numberbox_float_type		fp_add_property_numberbox_float = 0;
+SMSDK_POINTER fp_add_property_numberbox_float_type	fp_add_property_numberbox_float = 0;
 
 // Add a colorbox property. Set the caption and initial color (use Windows RGB() macro).
 typedef void									(*fp_add_property_colorbox_type)(const wchar_t* /*caption*/, COLORREF /*color*/, unsigned int /*page_index*/);
-static fp_add_property_colorbox_type			fp_add_property_colorbox = 0;
+SMSDK_POINTER fp_add_property_colorbox_type		fp_add_property_colorbox = 0;
 
 // Add a slider property. Set the caption, min and max integers, initial position. Also can enable forced center to be at a set integer.
 // Forced center can be useful, for example, when the min is -10 and the max is 100 but you want the center to be 0.
 typedef void									(*fp_add_property_slider_type)(const wchar_t* /*caption*/, int /*min*/, int /*max*/, int /*position*/, unsigned int /*page_index*/, BOOL /*is_forced_center*/, int /*forced_center*/);
-static fp_add_property_slider_type				fp_add_property_slider = 0;
+SMSDK_POINTER fp_add_property_slider_type		fp_add_property_slider = 0;
 
 // Add a range slider property. Set the 3 optional captions, min and max integers, initial min and max position.
 typedef void									(*fp_add_property_range_slider_type)(const wchar_t* /*caption_low*/, const wchar_t* /*caption_mid*/, const wchar_t* /*caption_high*/,
 																					 int /*min*/, int /*max*/, int /*position_min*/, int /*position_max*/, unsigned int /*page_index*/);
-static fp_add_property_range_slider_type		fp_add_property_range_slider = 0;
+SMSDK_POINTER fp_add_property_range_slider_type	fp_add_property_range_slider = 0;
 
 // Add a coordinate system property. Set the caption and coordinate system.
 // The coordinate system should be defined by OR-ing 3 coordinate system defines found above in this file.
 // An example: (MAP_COORDSYS_X_POS_LEFT | MAP_COORDSYS_Y_POS_UP | MAP_COORDSYS_Z_POS_NEAR)
 typedef void									(*fp_add_property_coordsys_type)(const wchar_t* /*caption*/, unsigned int /*coordinate_system*/, unsigned int /*page_index*/);
-static fp_add_property_coordsys_type			fp_add_property_coordsys = 0;
+SMSDK_POINTER fp_add_property_coordsys_type		fp_add_property_coordsys = 0;
 
 
 // **
@@ -287,43 +297,43 @@ static fp_add_property_coordsys_type			fp_add_property_coordsys = 0;
 														
 // Get page list (if used) will always be at property index 0 (zero)
 typedef unsigned int							(*fp_get_property_pagelist_type)(unsigned int /*map_id*/, int /*filter_position*/, unsigned int /*property_index*/);
-static fp_get_property_pagelist_type			fp_get_property_pagelist = 0;
+SMSDK_POINTER fp_get_property_pagelist_type		fp_get_property_pagelist = 0;
 
 // Get a file path from a file property.
 typedef const wchar_t*							(*fp_get_property_file_type)(unsigned int /*map_id*/, int /*filter_position*/, unsigned int /*property_index*/);
-static fp_get_property_file_type				fp_get_property_file = 0;
+SMSDK_POINTER fp_get_property_file_type			fp_get_property_file = 0;
 
 // Get the state of a checkbox property.
 typedef BOOL									(*fp_get_property_checkbox_type)(unsigned int /*map_id*/, int /*filter_position*/, unsigned int /*property_index*/);
-static fp_get_property_checkbox_type			fp_get_property_checkbox = 0;
+SMSDK_POINTER fp_get_property_checkbox_type		fp_get_property_checkbox = 0;
 
 // Get the selected index of a list property.
 typedef unsigned int							(*fp_get_property_list_type)(unsigned int /*map_id*/, int /*filter_position*/, unsigned int /*property_index*/);
-static fp_get_property_list_type				fp_get_property_list = 0;
+SMSDK_POINTER fp_get_property_list_type			fp_get_property_list = 0;
 
 // Get the integer value of a numberbox property.
 typedef int										(*fp_get_property_numberbox_int_type)(unsigned int /*map_id*/, int /*filter_position*/, unsigned int /*property_index*/);
-static fp_get_property_numberbox_int_type		fp_get_property_numberbox_int = 0;
+SMSDK_POINTER fp_get_property_numberbox_int_type	fp_get_property_numberbox_int = 0;
 
 // Get the floating point value of a numberbox property.
 typedef float									(*fp_get_property_numberbox_float_type)(unsigned int /*map_id*/, int /*filter_position*/, unsigned int /*property_index*/);
-static fp_get_property_numberbox_float_type		fp_get_property_numberbox_float = 0;
+SMSDK_POINTER fp_get_property_numberbox_float_type	fp_get_property_numberbox_float = 0;
 
 // Get the color of a colorbox property.
 typedef COLORREF								(*fp_get_property_colorbox_type)(unsigned int /*map_id*/, int /*filter_position*/, unsigned int /*property_index*/);
-static fp_get_property_colorbox_type			fp_get_property_colorbox = 0;
+SMSDK_POINTER fp_get_property_colorbox_type		fp_get_property_colorbox = 0;
 
 // Get the integer position of a slider property.
 typedef int										(*fp_get_property_slider_type)(unsigned int /*map_id*/, int /*filter_position*/, unsigned int /*property_index*/);
-static fp_get_property_slider_type				fp_get_property_slider = 0;
+SMSDK_POINTER fp_get_property_slider_type		fp_get_property_slider = 0;
 
 // Get the integer positions of a range slider property as parameters.
 typedef void									(*fp_get_property_range_slider_type)(unsigned int /*map_id*/, int /*filter_position*/, unsigned int /*property_index*/, int& /*position_min_out*/, int& /*position_max_out*/);
-static fp_get_property_range_slider_type		fp_get_property_range_slider = 0;
+SMSDK_POINTER fp_get_property_range_slider_type	fp_get_property_range_slider = 0;
 
 // Get the coordinate system of a coordinate system property.
 typedef unsigned int							(*fp_get_property_coordsys_type)(unsigned int /*map_id*/, int /*filter_position*/, unsigned int /*property_index*/);
-static fp_get_property_coordsys_type			fp_get_property_coordsys = 0;
+SMSDK_POINTER fp_get_property_coordsys_type		fp_get_property_coordsys = 0;
 
 
 // **
@@ -333,35 +343,35 @@ static fp_get_property_coordsys_type			fp_get_property_coordsys = 0;
 
 // Set the state of a checkbox property.
 typedef void									(*fp_set_property_checkbox_type)(unsigned int /*map_id*/, int /*filter_position*/, unsigned int /*property_index*/, BOOL /*check_state*/);
-static fp_set_property_checkbox_type			fp_set_property_checkbox = 0;
+SMSDK_POINTER fp_set_property_checkbox_type		fp_set_property_checkbox = 0;
 
 // Set the selected index of a list property.
 typedef void									(*fp_set_property_list_type)(unsigned int /*map_id*/, int /*filter_position*/, unsigned int /*property_index*/, unsigned int /*cur_sel*/);
-static fp_set_property_list_type				fp_set_property_list = 0;
+SMSDK_POINTER fp_set_property_list_type			fp_set_property_list = 0;
 
 // Set an integer to a numberbox property.
 typedef void									(*fp_set_property_numberbox_int_type)(unsigned int /*map_id*/, int /*filter_position*/, unsigned int /*property_index*/, int /*value*/);
-static fp_set_property_numberbox_int_type		fp_set_property_numberbox_int = 0;
+SMSDK_POINTER fp_set_property_numberbox_int_type	fp_set_property_numberbox_int = 0;
 
 // Set a floating point value to a numberbox property.
 typedef void									(*fp_set_property_numberbox_float_type)(unsigned int /*map_id*/, int /*filter_position*/, unsigned int /*property_index*/, float /*value*/);
-static fp_set_property_numberbox_float_type		fp_set_property_numberbox_float = 0;
+SMSDK_POINTER fp_set_property_numberbox_float_type	fp_set_property_numberbox_float = 0;
 
 // Set a color to a colorbox property.
 typedef void									(*fp_set_property_colorbox_type)(unsigned int /*map_id*/, int /*filter_position*/, unsigned int /*property_index*/, COLORREF /*color*/);
-static fp_set_property_colorbox_type			fp_set_property_colorbox = 0;
+SMSDK_POINTER fp_set_property_colorbox_type		fp_set_property_colorbox = 0;
 
 // Set a position to a slider property.
 typedef void									(*fp_set_property_slider_type)(unsigned int /*map_id*/, int /*filter_position*/, unsigned int /*property_index*/, int /*position*/);
-static fp_set_property_slider_type				fp_set_property_slider = 0;
+SMSDK_POINTER fp_set_property_slider_type		fp_set_property_slider = 0;
 
 // Set a positions to a range slider property.
 typedef void									(*fp_set_property_range_slider_type)(unsigned int /*map_id*/, int /*filter_position*/, unsigned int /*property_index*/, int /*position_min*/, int /*position_max*/);
-static fp_set_property_range_slider_type		fp_set_property_range_slider = 0;
+SMSDK_POINTER fp_set_property_range_slider_type	fp_set_property_range_slider = 0;
 
 // Set a coordinate system to a coordinate system property.
 typedef void									(*fp_set_property_coordsys_type)(unsigned int /*map_id*/, int /*filter_position*/, unsigned int /*property_index*/, unsigned int /*coordsys*/);
-static fp_set_property_coordsys_type			fp_set_property_coordsys = 0;
+SMSDK_POINTER fp_set_property_coordsys_type		fp_set_property_coordsys = 0;
 
 
 // **
@@ -369,28 +379,28 @@ static fp_set_property_coordsys_type			fp_set_property_coordsys = 0;
 
 // Determine if map render has been canceled - check often.
 typedef BOOL									(*fp_is_cancel_process_type)(void);
-static fp_is_cancel_process_type				fp_is_cancel_process = 0;
+SMSDK_POINTER fp_is_cancel_process_type			fp_is_cancel_process = 0;
 
 // Set the progress of processing - at minimum should call once at start with 0 and once at end with 100.
 // Requires map id, filter position, and a progress integer between 0-100.
 typedef void									(*fp_set_filter_progress_type)(unsigned int /*map_id*/, int /*filter_position*/, unsigned int /*progress*/);
-static fp_set_filter_progress_type				fp_set_filter_progress = 0;
+SMSDK_POINTER fp_set_filter_progress_type		fp_set_filter_progress = 0;
 
 // Log a filter error to the ShaderMap log file located: "C:\Users\<USERNAME>\AppData\Roaming\SM3\log".
 // Use the "LOG_ERROR_MSG()" macro to simplify calling this function.
 typedef void									(*fp_log_filter_error_type)(unsigned int /*map_id*/, int /*filter_position*/, const wchar_t* /*error_message*/, const wchar_t* /*function*/, const wchar_t* /*source_filepath*/, int /*source_line_number*/);
-static fp_log_filter_error_type					fp_log_filter_error = 0;
+SMSDK_POINTER fp_log_filter_error_type			fp_log_filter_error = 0;
 
 // Get the thread limit imposed by ShaderMap for map usage.
 typedef unsigned int							(*fp_get_map_thread_limit_type)(void);
-static fp_get_map_thread_limit_type				fp_get_map_thread_limit = 0;
+SMSDK_POINTER fp_get_map_thread_limit_type		fp_get_map_thread_limit = 0;
 
 // Get the map's mask data. Requires map id, and returns, as parameters, the width and height of the mask as well as a pixel array with the mask data.
 // pixel_array_out must be allocated by the plugin and be of at least size: sizof(unsigned short) * with * height.
 // pixel_array_out can be set to 0 and only the width and height are returned. In this way the developer can determine the size of the pixel array to allocate before making the second call.
 // Masks are single channel images. Each unsigned short represents a single pixel value. The origin of the Mask image is UPPER LEFT
 typedef void									(*fp_get_map_mask_type)(unsigned int /*map_id*/, unsigned int& /*width_out*/, unsigned int& /*height_out*/, unsigned short** /*pixel_array_out*/);
-static fp_get_map_mask_type						fp_get_map_mask = 0;
+SMSDK_POINTER fp_get_map_mask_type				fp_get_map_mask = 0;
 
 
 // ----------------------------------------------------------------
@@ -460,7 +470,14 @@ void											on_arrange_load_data(unsigned int version, unsigned int index_cou
 // "plugin_initialize()" sets the API function pointers then calls "on_initialize()".
 // "plugin_process()", "plugin_shutdown()", and "plugin_custom_0()" each call the user defined "on_process()", "on_shutdown()", and "on_arrange_load_data()" functions.
 
+#ifdef _WIN32
 #define DLL_EXPORT								__declspec(dllexport)
+#else
+#define DLL_EXPORT								__attribute__((visibility("default")))		// Linux shared object build - see "host/compat/windows.h".
+#endif
+
+// A host that includes this file for the structs and function types defines SMSDK_HOST so the plugin exports are left out.
+#ifndef SMSDK_HOST
 
 extern "C" {
 
@@ -547,3 +564,5 @@ extern "C" {
 		return TRUE;
 	}	
 }
+
+#endif // SMSDK_HOST
@@ -144,11 +144,222 @@
 // ----------------------------------------------------------------
 // Plugin includes
 
-#include "..\..\geo_plugin_core.cpp"
+#include "../../geo_plugin_core.cpp"
+#include "../../geo_import_progress.cpp"
+#include "../../geo_file_map.cpp"
+#include "../../geo_mesh_build.cpp"
+#include "../../geo_subset_sort.cpp"
+#include "../../geo_custom_v2.cpp"
+#include <algorithm>
 #include <string>
 #include <vector>
 
 
+// ------------------------------------------------------------------
+// ------------------------------------------------------------------
+// Local defines
+
+// Faces in each chunk of version 1 NODE geometry sent with "gp_append_node_geometry()".
+#define CUSTOM_APPEND_FACE_COUNT		65536
+
+
+// ------------------------------------------------------------------
+// ------------------------------------------------------------------
+// Local structs and functions called during process
+
+// The geometry of a CUSTOM file. Version 1 arrays point into the mapped file, version 2 arrays into the decoded mesh.
+struct custom_geometry_s
+{
+	const gp_node_vertex_s*			vertex_array;
+	unsigned int					vertex_count;
+	unsigned int					face_count;
+	const unsigned int*				corner_array;		// Vertex indices a, b, c of each face, corner_stride unsigned ints apart.
+	unsigned int					corner_stride;
+	const gp_node_face_s*			face_array;			// Subset of each face, 0 if every face is subset 0.
+	unsigned int					subset_count;
+	const gp_node_uv_s*				uv_array;			// The first uv channel, 0 if there are no uvs.
+	const unsigned int*				uv_index_array;		// UV indices a, b, c of each face, uv_index_stride unsigned ints apart.
+	unsigned int					uv_index_stride;
+};
+
+// Build the render geometry of a CUSTOM file and send it to ShaderMap. Returns FALSE and logs an error on failure.
+BOOL create_custom_render_geometry(unsigned int plugin_index, const custom_geometry_s& geometry)
+{
+	// Local structs
+
+	// The render vertex of the first uv index used with a vertex.
+	struct first_corner_s
+	{	unsigned int				uv_index;
+		unsigned int				render_index;
+
+		first_corner_s(void)
+		{	uv_index = UINT_MAX; render_index = 0;
+		}
+	};
+
+	// Local data
+	unsigned int					i, ui_0, uv_index;
+	const unsigned int*				corner;
+	gp_render_vertex_s				render_vertex;
+	unsigned int					corner_array[3];
+	std::vector<first_corner_s>		first_corner_list;
+	geo_mesh_s						render_mesh;
+
+
+	// Build the render geometry. Corners with the same position, normal and uv share one render vertex and the
+	// triangles are ordered for the vertex cache. See "geo_mesh_build.cpp".
+	// Corners with the same vertex and uv index are the same render vertex, so the render vertex of the first uv
+	// index used with each vertex is kept and only the other corners are welded by value.
+	try
+	{	first_corner_list.assign(geometry.vertex_count, first_corner_s());
+	}
+	catch(...)
+	{	LOG_ERROR_MSG(plugin_index, _T("Memory Allocation Error: Failed to allocate the render geometry lists."));
+		return FALSE;
+	}
+	if(!geo_mesh_reserve(render_mesh, geometry.face_count))
+	{	LOG_ERROR_MSG(plugin_index, _T("Memory Allocation Error: Failed to allocate the render geometry lists."));
+		return FALSE;
+	}
+
+	try
+	{	for(i=0; i<geometry.face_count; i++)
+		{
+			// Face vertices A, B and C
+			corner = geometry.corner_array + (size_t)i * geometry.corner_stride;
+			for(ui_0=0; ui_0<3; ui_0++)
+			{	uv_index = geometry.uv_array ? geometry.uv_index_array[(size_t)i * geometry.uv_index_stride + ui_0] : 0;
+				first_corner_s& first_corner = first_corner_list[corner[ui_0]];
+				if(first_corner.uv_index == uv_index)
+				{	corner_array[ui_0] = first_corner.render_index;
+					continue;
+				}
+
+				render_vertex.x		= geometry.vertex_array[corner[ui_0]].x;
+				render_vertex.nx	= geometry.vertex_array[corner[ui_0]].nx;
+				render_vertex.y		= geometry.vertex_array[corner[ui_0]].y;
+				render_vertex.ny	= geometry.vertex_array[corner[ui_0]].ny;
+				render_vertex.z		= geometry.vertex_array[corner[ui_0]].z;
+				render_vertex.nz	= geometry.vertex_array[corner[ui_0]].nz;
+				render_vertex.u		= geometry.uv_array ? geometry.uv_array[uv_index].u : 0.0f;
+				render_vertex.v		= geometry.uv_array ? -geometry.uv_array[uv_index].v : 0.0f;
+
+				corner_array[ui_0]	= geo_mesh_add_vertex(render_mesh, render_vertex);
+				if(first_corner.uv_index == UINT_MAX)
+				{	first_corner.uv_index		= uv_index;
+					first_corner.render_index	= corner_array[ui_0];
+				}
+			}
+
+			geo_mesh_add_face(render_mesh, corner_array[0], corner_array[1], corner_array[2], geometry.face_array ? geometry.face_array[i].subset_index : 0);
+		}
+	}
+	catch(...)
+	{	LOG_ERROR_MSG(plugin_index, _T("Memory Allocation Error: Failed to allocate the render geometry lists."));
+		return FALSE;
+	}
+	std::vector<first_corner_s>().swap(first_corner_list);
+
+	if(!geo_mesh_optimize(render_mesh))
+	{	LOG_ERROR_MSG(plugin_index, _T("Memory Allocation Error: Failed to optimize the render geometry."));
+		return FALSE;
+	}
+
+	// Send the render lists to ShaderMap. No additional UV arrays.
+	if(!gp_create_render_geometry(render_mesh.vertex_list.data(), (unsigned int)render_mesh.vertex_list.size(), render_mesh.face_list.data(), (unsigned int)render_mesh.face_list.size(), geometry.subset_count, FALSE, 0, 0))
+	{	LOG_ERROR_MSG(plugin_index, _T("Failed to create render geometry with gp_create_render_geometry."));
+		return FALSE;
+	}
+	return TRUE;
+}
+
+// Import a CUSTOM version 2 file. See "geo_custom_v2.cpp". Returns FALSE and logs an error on failure.
+BOOL import_custom_v2(unsigned int plugin_index, const geo_file_map_s& file_map, unsigned int geometry_type)
+{
+	// Local data
+	geo_cv2_mesh_s					mesh;
+	const wchar_t*					error;
+	custom_geometry_s				geometry;
+	geo_subset_material_s			subset_material;
+	std::vector<gp_node_uv_s*>		node_uv_channel_list;
+	std::vector<unsigned int*>		node_uv_index_list;
+	std::vector<unsigned int>		node_uv_count_list;
+	gp_node_uv_data_s				node_uv_data;
+
+
+	// Decode the chunks of the file on all cores. Decoding is most of the import so it is given most of the progress.
+	if(!geo_cv2_decode(file_map.data, file_map.size, mesh, parallel_get_progress(0, 80), error))
+	{	LOG_ERROR_MSG(plugin_index, error);
+		return FALSE;
+	}
+	if(geo_is_cancel())
+	{	return FALSE;
+	}
+	if(mesh.uv_channel_list.empty())
+	{	gp_flag_no_uv_geometry();
+	}
+
+	// GP_GEOMETRY_TYPE_RENDER
+	// Only the first uv channel is used for rendering.
+	if(geometry_type == GP_GEOMETRY_TYPE_RENDER)
+	{	geometry.vertex_array		= mesh.vertex_list.data();
+		geometry.vertex_count		= (unsigned int)mesh.vertex_list.size();
+		geometry.face_count			= (unsigned int)mesh.face_list.size();
+		geometry.corner_array		= &mesh.face_list[0].a;
+		geometry.corner_stride		= sizeof(gp_node_face_s) / sizeof(unsigned int);
+		geometry.face_array			= mesh.face_list.data();
+		geometry.subset_count		= (unsigned int)mesh.subset_material_list.size();
+		geometry.uv_array			= mesh.uv_channel_list.empty() ? 0 : mesh.uv_channel_list[0].data();
+		geometry.uv_index_array		= mesh.uv_channel_list.empty() ? 0 : mesh.uv_index_list[0].data();
+		geometry.uv_index_stride	= 3;
+		return create_custom_render_geometry(plugin_index, geometry);
+	}
+
+	// GP_GEOMETRY_TYPE_NODE
+	else if(geometry_type == GP_GEOMETRY_TYPE_NODE)
+	{
+		// Define a material id for each material of the subset table with the subsets that use it, in the order materials
+		// are first used. See "geo_subset_sort.cpp".
+		if(!geo_list_subset_materials(mesh.subset_material_list.data(), (unsigned int)mesh.subset_material_list.size(), subset_material))
+		{	LOG_ERROR_MSG(plugin_index, _T("Memory Allocation Error: Failed to allocate the node material lists."));
+			return FALSE;
+		}
+		geo_define_subset_materials(subset_material);
+
+		try
+		{	for(unsigned int i=0; i<mesh.uv_channel_list.size(); i++)
+			{	node_uv_channel_list.push_back(mesh.uv_channel_list[i].data());
+				node_uv_index_list.push_back(mesh.uv_index_list[i].data());
+				node_uv_count_list.push_back((unsigned int)mesh.uv_channel_list[i].size());
+			}
+		}
+		catch(...)
+		{	LOG_ERROR_MSG(plugin_index, _T("Memory Allocation Error: Failed to allocate the node uv lists."));
+			return FALSE;
+		}
+
+		// Use the face colors of the file only if the options ask for material colors from the file.
+		if(mesh.is_color && !gp_is_option_material_color_from_file())
+		{	for(unsigned int i=0; i<mesh.face_list.size(); i++)
+			{	mesh.face_list[i].color = gp_node_face_s().color;
+			}
+		}
+
+		node_uv_data.uv_channel_count	= (unsigned int)mesh.uv_channel_list.size();
+		node_uv_data.uv_channels_array	= node_uv_channel_list.data();
+		node_uv_data.uv_indices_array	= node_uv_index_list.data();
+		node_uv_data.uv_count_array		= node_uv_count_list.data();
+
+		if(!gp_create_node_geometry(mesh.vertex_list.data(), (unsigned int)mesh.vertex_list.size(), mesh.face_list.data(), (unsigned int)mesh.face_list.size(),
+									&node_uv_data, (unsigned int)mesh.subset_material_list.size(), FALSE))
+		{	LOG_ERROR_MSG(plugin_index, _T("Failed to create node geometry with gp_create_node_geometry."));
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+
 // ------------------------------------------------------------------
 // ------------------------------------------------------------------
 // Local functions called during init, process, and shutdown
@@ -194,22 +405,29 @@ BOOL on_process(unsigned int plugin_index, const wchar_t* file_path)
 		vector_3_s					normal;
 	};
 
+	// The file records are passed to ShaderMap as these structs without a copy.
+	static_assert(sizeof(vertex_s) == sizeof(gp_node_vertex_s), "vertex_s must have the layout of gp_node_vertex_s.");
+	static_assert(sizeof(vector_2_s) == sizeof(gp_node_uv_s), "vector_2_s must have the layout of gp_node_uv_s.");
+
 	// Local data
-	FILE*							fp;
+	geo_file_map_s					file_map;
 	unsigned int					i, ui_0, ui_1, vertex_count, index_count, uv_count, face_count, geometry_type;
-	unsigned int*					index_array;
+	unsigned int					chunk_face_count, face_start, face_end;
+	BOOL							is_append;
+	const unsigned int*				header_array;
+	const unsigned int*				index_array;
+	unsigned long long				file_size;
 	BOOL							is_success;
 	vector_2_s*						uv_array;
 	vertex_s*						vertex_array;
+	custom_geometry_s				geometry;
 	
-	gp_render_vertex_s				render_vertex;
-	gp_render_face_s				render_face;
-	std::vector<gp_render_vertex_s>	render_vertex_list;
-	std::vector<gp_render_face_s>	render_face_list;
-	
-	std::vector<gp_node_vertex_s>	node_vertex_list;
 	std::vector<gp_node_face_s>		node_face_list;	
+	std::vector<unsigned int>		node_uv_index_list;
 
+	gp_node_uv_s*					node_uv_channel_array[1];
+	unsigned int*					node_uv_index_array[1];
+	unsigned int					node_uv_count_array[1];
 	gp_node_uv_data_s				node_uv_data;
 	
 	
@@ -229,133 +447,97 @@ BOOL on_process(unsigned int plugin_index, const wchar_t* file_path)
 		vector_2_s * uv_count			// An array of vector_2_s structs
 		unsigned int * index_count		// An array of undinged int indices - 7 unsigned int per 1 vertex (3 for vertices, 3 for uv, and 1 for start index).
 	*/
+	// That is version 1 of the format. Version 2 is a compressed container with subsets, uv channels and face colors
+	// that starts with a magic number. See "geo_custom_v2.cpp".
 
 	// Set return value
 	is_success		= TRUE;
 
-	// Null arrays
-	vertex_array	= 0;
-	index_array		= 0;
-	uv_array		= 0;
-
-	// Open binary file for read.
-	_wfopen_s(&fp, file_path, _T("rb"));
-	if(!fp)
+	// Map the file into memory. The arrays are read where they are in the file, no copy of the file is loaded.
+	// See "geo_file_map.cpp".
+	if(!geo_file_map_open(file_path, file_map))
 	{	LOG_ERROR_MSG(plugin_index, _T("Failed to open file at file_path."));
-		is_success = FALSE;
-		goto ON_PROCESS_CLEANUP;
+		return FALSE;
 	}
 
-	// Read vertex count.
-	fread(&vertex_count, sizeof(unsigned int), 1, fp);
-	// Read uv count.
-	fread(&uv_count, sizeof(unsigned int), 1, fp);
-	// Read index count.
-	fread(&index_count, sizeof(unsigned int), 1, fp);
+	// Version 2 files are decoded into memory.
+	if(geo_cv2_is_file(file_map.data, file_map.size))
+	{	is_success = import_custom_v2(plugin_index, file_map, geometry_type);
+		goto ON_PROCESS_CLEANUP;
+	}
 
-	// Ensure none of the counts are zero.
-	if(vertex_count == 0 || uv_count == 0 || index_count == 0)
-	{	LOG_ERROR_MSG(plugin_index, _T("One of the geometry counts was zero."));
-		fclose(fp);
+	// Read the counts.
+	if(file_map.size < 3 * sizeof(unsigned int))
+	{	LOG_ERROR_MSG(plugin_index, _T("The file is too small for its header."));
 		is_success = FALSE;
 		goto ON_PROCESS_CLEANUP;
 	}
+	header_array	= (const unsigned int*)file_map.data;
+	vertex_count	= header_array[0];
+	uv_count		= header_array[1];
+	index_count		= header_array[2];
 
-	// Allocate local arrays to store the geometry data.
-	vertex_array = new (std::nothrow) vertex_s[vertex_count];
-	if(!vertex_array)
-	{	LOG_ERROR_MSG(plugin_index, _T("Memory Allocation Error: Failed to allocate vertex_array."));
-		fclose(fp);
+	// Ensure none of the counts are zero and the indices are whole faces.
+	if(vertex_count == 0 || uv_count == 0 || index_count == 0)
+	{	LOG_ERROR_MSG(plugin_index, _T("One of the geometry counts was zero."));
 		is_success = FALSE;
 		goto ON_PROCESS_CLEANUP;
 	}
-	uv_array = new (std::nothrow) vector_2_s[uv_count];
-	if(!uv_array)
-	{	LOG_ERROR_MSG(plugin_index, _T("Memory Allocation Error: Failed to allocate uv_array."));		
-		fclose(fp);
+	if(index_count % 7)
+	{	LOG_ERROR_MSG(plugin_index, _T("The index count is not a multiple of 7."));
 		is_success = FALSE;
 		goto ON_PROCESS_CLEANUP;
 	}
-	index_array = new (std::nothrow) unsigned int[index_count];
-	if(!index_array)
-	{	LOG_ERROR_MSG(plugin_index, _T("Memory Allocation Error: Failed to allocate index_array."));		
-		fclose(fp);
+
+	// Ensure the file holds the arrays the counts ask for.
+	file_size = 3ull * sizeof(unsigned int) + (unsigned long long)vertex_count * sizeof(vertex_s) + 
+				(unsigned long long)uv_count * sizeof(vector_2_s) + (unsigned long long)index_count * sizeof(unsigned int);
+	if(file_map.size < file_size)
+	{	LOG_ERROR_MSG(plugin_index, _T("The file is smaller than its geometry counts."));
 		is_success = FALSE;
 		goto ON_PROCESS_CLEANUP;
 	}
 
-	// Read in the arrays
-	fread(vertex_array, sizeof(vertex_s), vertex_count, fp);
-	fread(uv_array, sizeof(vector_2_s), uv_count, fp);
-	fread(index_array, sizeof(unsigned int), index_count, fp);
-
-	// Close file.
-	fclose(fp);
+	// Point at the arrays in the file.
+	vertex_array	= (vertex_s*)(file_map.data + 3 * sizeof(unsigned int));
+	uv_array		= (vector_2_s*)(vertex_array + vertex_count);
+	index_array		= (const unsigned int*)(uv_array + uv_count);
 
 	// Get the face count
 	face_count = index_count / 7;
 
+	// Ensure every index is in range so that no face reads outside of the file.
+	for(i=0; i<index_count; i+=7)
+	{	if(index_array[i] >= vertex_count || index_array[i+1] >= vertex_count || index_array[i+2] >= vertex_count ||
+		   index_array[i+3] >= uv_count || index_array[i+4] >= uv_count || index_array[i+5] >= uv_count)
+		{	LOG_ERROR_MSG(plugin_index, _T("A face index is out of range."));
+			is_success = FALSE;
+			goto ON_PROCESS_CLEANUP;
+		}
+	}
+
 	// -----------------
 
-	// Now that the file data is loaded into arrays. Build the arrays that ShaderMap wants the 
+	// Now that the file data is mapped. Build the arrays that ShaderMap wants the 
 	// data in depending on the requested geometry type.
 	
 	// GP_GEOMETRY_TYPE_RENDER
 	// This format for geometry is used for 3d models in the material visualizer.
 	if(geometry_type == GP_GEOMETRY_TYPE_RENDER)
 	{
-		// Build the render geometry lists.
-		ui_0 = 0;
-		for(i=0; i<index_count; i+=7)
-		{
-			// Face vertex A
-			render_vertex.x		= vertex_array[index_array[i]].position.x;
-			render_vertex.nx	= vertex_array[index_array[i]].normal.x;
-			render_vertex.y		= vertex_array[index_array[i]].position.y;
-			render_vertex.ny	= vertex_array[index_array[i]].normal.y;
-			render_vertex.z		= vertex_array[index_array[i]].position.z;
-			render_vertex.nz	= vertex_array[index_array[i]].normal.z;
-			render_vertex.u		= uv_array[index_array[i+3]].x;
-			render_vertex.v		= -uv_array[index_array[i+3]].y;
-
-			render_vertex_list.push_back(render_vertex);
-			render_face.a		= (unsigned int)render_vertex_list.size() - 1;
-
-			// Face vertex B
-			render_vertex.x		= vertex_array[index_array[i+1]].position.x;
-			render_vertex.nx	= vertex_array[index_array[i+1]].normal.x;
-			render_vertex.y		= vertex_array[index_array[i+1]].position.y;
-			render_vertex.ny	= vertex_array[index_array[i+1]].normal.y;
-			render_vertex.z		= vertex_array[index_array[i+1]].position.z;
-			render_vertex.nz	= vertex_array[index_array[i+1]].normal.z;
-			render_vertex.u		= uv_array[index_array[i+4]].x;
-			render_vertex.v		= -uv_array[index_array[i+4]].y;
-
-			render_vertex_list.push_back(render_vertex);
-			render_face.b		= (unsigned int)render_vertex_list.size() - 1;
-
-			// Face vertex C
-			render_vertex.x		= vertex_array[index_array[i+2]].position.x;
-			render_vertex.nx	= vertex_array[index_array[i+2]].normal.x;
-			render_vertex.y		= vertex_array[index_array[i+2]].position.y;
-			render_vertex.ny	= vertex_array[index_array[i+2]].normal.y;
-			render_vertex.z		= vertex_array[index_array[i+2]].position.z;
-			render_vertex.nz	= vertex_array[index_array[i+2]].normal.z;
-			render_vertex.u		= uv_array[index_array[i+5]].x;
-			render_vertex.v		= -uv_array[index_array[i+5]].y;
-
-			render_vertex_list.push_back(render_vertex);
-			render_face.c		= (unsigned int)render_vertex_list.size() - 1;
-			
-			render_face.subset_index	= 0;	// The CUSTOM format does not have subsets so all are subset zero.
-
-			render_face_list.push_back(render_face);
-		}
-
-		// Send the render lists to ShaderMap. No additional UV arrays.
-		if(!gp_create_render_geometry(render_vertex_list.data(), (unsigned int)render_vertex_list.size(), render_face_list.data(), (unsigned int)render_face_list.size(), 1, FALSE, 0, 0))
-		{	LOG_ERROR_MSG(plugin_index, _T("Failed to create render geometry with gp_create_render_geometry."));
-			is_success = FALSE;
+		// The vertex and uv records in the file have the layout of the node vertex and uv structs.
+		geometry.vertex_array		= (const gp_node_vertex_s*)vertex_array;
+		geometry.vertex_count		= vertex_count;
+		geometry.face_count			= face_count;
+		geometry.corner_array		= index_array;
+		geometry.corner_stride		= 7;
+		geometry.face_array			= 0;			// Version 1 does not have subsets so all are subset zero.
+		geometry.subset_count		= 1;
+		geometry.uv_array			= (const gp_node_uv_s*)uv_array;
+		geometry.uv_index_array		= index_array + 3;
+		geometry.uv_index_stride	= 7;
+		if(!create_custom_render_geometry(plugin_index, geometry))
+		{	is_success = FALSE;
 			goto ON_PROCESS_CLEANUP;
 		}
 	}
@@ -363,86 +545,75 @@ BOOL on_process(unsigned int plugin_index, const wchar_t* file_path)
 	// This format for geometry is used for 3d model nodes in the project grid.
 	else if(geometry_type == GP_GEOMETRY_TYPE_NODE)
 	{
-
-		// Create the node uv data struct
-
-		// Allocate an array of gp_node_uv_s arrays - 1 for each uv channel. In this case we have only 1 uv channel.
-		node_uv_data.uv_channels_array = new (std::nothrow) gp_node_uv_s*[1];
-		if(!node_uv_data.uv_channels_array)
-		{	LOG_ERROR_MSG(plugin_index, _T("Memory Allocation Error: Faile to allocate node_uv_data.uv_channels_array."));
-			is_success = FALSE;
-			goto ON_PROCESS_CLEANUP;
+		// The faces and uv indices are interleaved in the file so they are the only lists built. When ShaderMap takes NODE
+		// geometry in chunks only one chunk of them is built at a time. See "geo_import_progress.cpp".
+		is_append			= geo_is_append_node_geometry();
+		chunk_face_count	= is_append ? std::min<unsigned int>(face_count, CUSTOM_APPEND_FACE_COUNT) : face_count;
+		try
+		{	node_face_list.resize(chunk_face_count);
+			node_uv_index_list.resize((size_t)chunk_face_count * 3);
 		}
-
-		// Allocate an single array of gp_node_uv_s for the 1 uv channel.
-		node_uv_data.uv_channels_array[0] = new (std::nothrow) gp_node_uv_s[uv_count];
-		if(!node_uv_data.uv_channels_array[0])
-		{	LOG_ERROR_MSG(plugin_index, _T("Memory Allocation Error: Faile to allocate node_uv_data.uv_channels_array[0]."));
+		catch(...)
+		{	LOG_ERROR_MSG(plugin_index, _T("Memory Allocation Error: Failed to allocate the node face lists."));
 			is_success = FALSE;
 			goto ON_PROCESS_CLEANUP;
 		}
 
-		// Copy in the uv array
-		memcpy(node_uv_data.uv_channels_array[0], uv_array, uv_count * sizeof(gp_node_uv_s));
+		// Create the node uv data struct. There is 1 uv channel, its uvs are the vector_2_s array in the file.
+		node_uv_channel_array[0]		= (gp_node_uv_s*)uv_array;
+		node_uv_index_array[0]			= node_uv_index_list.data();
+		node_uv_count_array[0]			= uv_count;
+		node_uv_data.uv_channel_count	= 1;
+		node_uv_data.uv_channels_array	= node_uv_channel_array;
+		node_uv_data.uv_indices_array	= node_uv_index_array;
+		node_uv_data.uv_count_array		= node_uv_count_array;
 
-		// Allocate an array of unsigned int arrays - 1 for each uv channel. In this case we have only 1 uv channel.
-		node_uv_data.uv_indices_array = new (std::nothrow) unsigned int*[1];
-		if(!node_uv_data.uv_indices_array)
-		{	LOG_ERROR_MSG(plugin_index, _T("Memory Allocation Error: Faile to allocate node_uv_data.uv_indices_array."));
-			is_success = FALSE;
-			goto ON_PROCESS_CLEANUP;
-		}
-
-		// Allocate an single array of gp_node_uv_s for the 1 uv channel.
-		node_uv_data.uv_indices_array[0] = new (std::nothrow) unsigned int[face_count * 3];
-		if(!node_uv_data.uv_indices_array[0])
-		{	LOG_ERROR_MSG(plugin_index, _T("Memory Allocation Error: Faile to allocate node_uv_data.uv_indices_array[0]."));
-			is_success = FALSE;
-			goto ON_PROCESS_CLEANUP;
-		}
-
-		// Allocate an array of unsigned int - 1 for each uv channel. In this case we have only 1 uv channel.
-		node_uv_data.uv_count_array = new (std::nothrow) unsigned int[1];
-		if(!node_uv_data.uv_count_array)
-		{	LOG_ERROR_MSG(plugin_index, _T("Memory Allocation Error: Faile to allocate node_uv_data.uv_count_array."));
-			is_success = FALSE;
-			goto ON_PROCESS_CLEANUP;
-		}
-
-		node_uv_data.uv_count_array[0]	= uv_count;
-		node_uv_data.uv_channel_count	= 1;		
-
-		// Build the node geometry lists
-		node_vertex_list.resize(vertex_count);		
-		for(i=0; i<vertex_count; i++)
-		{	node_vertex_list[i].x		= vertex_array[i].position.x;
-			node_vertex_list[i].y		= vertex_array[i].position.y;
-			node_vertex_list[i].z		= vertex_array[i].position.z;
-			node_vertex_list[i].nx		= vertex_array[i].normal.x;
-			node_vertex_list[i].ny		= vertex_array[i].normal.y;
-			node_vertex_list[i].nz		= vertex_array[i].normal.z;
+		for(face_start=0; face_start<face_count; face_start=face_end)
+		{
+			if(geo_is_cancel())
+			{	is_success = FALSE;
+				goto ON_PROCESS_CLEANUP;
+			}
+			face_end = face_start + std::min<unsigned int>(face_count - face_start, chunk_face_count);
+
+			ui_0	= 0;
+			ui_1	= 0;
+			for(i=face_start*7; i<face_end*7; i+=7)
+			{	
+				// Copy in the face list.
+				node_face_list[ui_0].a		= index_array[i];
+				node_face_list[ui_0].b		= index_array[i+1];
+				node_face_list[ui_0].c		= index_array[i+2];			
+				node_face_list[ui_0].subset_index = 0;			// The CUSTOM format does not have subsets so all are subset zero.
+				ui_0++;
+
+				// Copy in the uv indices
+				node_uv_index_list[ui_1]	= index_array[i+3]; ui_1++;
+				node_uv_index_list[ui_1]	= index_array[i+4]; ui_1++;
+				node_uv_index_list[ui_1]	= index_array[i+5]; ui_1++;
+			}
+
+			// Send the chunk to ShaderMap. The vertices and uvs of the file go with the first chunk.
+			if(is_append)
+			{	node_uv_count_array[0] = face_start ? 0 : uv_count;
+				if(!gp_append_node_geometry(face_start ? 0 : (gp_node_vertex_s*)vertex_array, face_start ? 0 : vertex_count, node_face_list.data(), face_end - face_start, &node_uv_data))
+				{	LOG_ERROR_MSG(plugin_index, _T("Failed to append node geometry with gp_append_node_geometry."));
+					is_success = FALSE;
+					goto ON_PROCESS_CLEANUP;
+				}
+				geo_set_progress(face_end, face_count, 0, 100);
+			}
 		}
 
-		node_face_list.resize(face_count);
-		ui_0	= 0;
-		ui_1	= 0;
-		for(i=0; i<index_count; i+=7)
-		{	
-			// Copy in the face list.
-			node_face_list[ui_0].a		= index_array[i];
-			node_face_list[ui_0].b		= index_array[i+1];
-			node_face_list[ui_0].c		= index_array[i+2];			
-			node_face_list[ui_0].subset_index = 0;			// The CUSTOM format does not have subsets so all are subset zero.
-			ui_0++;
-
-			// Copy in the uv indices
-			node_uv_data.uv_indices_array[0][ui_1]	= index_array[i+3]; ui_1++;
-			node_uv_data.uv_indices_array[0][ui_1]	= index_array[i+4]; ui_1++;
-			node_uv_data.uv_indices_array[0][ui_1]	= index_array[i+5]; ui_1++;
+		// Finish the chunks, or send the node lists to ShaderMap. The vertices are the vertex_s array in the file.
+		if(is_append)
+		{	if(!gp_end_node_geometry(1, FALSE))
+			{	LOG_ERROR_MSG(plugin_index, _T("Failed to end node geometry with gp_end_node_geometry."));
+				is_success = FALSE;
+				goto ON_PROCESS_CLEANUP;
+			}
 		}
-		
-		// Send the node lists to ShaderMap.
-		if(!gp_create_node_geometry(node_vertex_list.data(), vertex_count, node_face_list.data(), face_count, &node_uv_data, 1, FALSE))
+		else if(!gp_create_node_geometry((gp_node_vertex_s*)vertex_array, vertex_count, node_face_list.data(), face_count, &node_uv_data, 1, FALSE))
 		{	LOG_ERROR_MSG(plugin_index, _T("Failed to create node geometry with gp_create_node_geometry."));
 			is_success = FALSE;
 			goto ON_PROCESS_CLEANUP;
@@ -451,17 +622,8 @@ BOOL on_process(unsigned int plugin_index, const wchar_t* file_path)
 
 ON_PROCESS_CLEANUP:
 
-	// Cleanup loaded geometry arrays.
-	delete [] vertex_array;
-	vertex_array	= 0;
-	delete [] uv_array;
-	uv_array		= 0;
-	delete [] index_array;
-	index_array		= 0;
-	
-	// Clear lists.
-	node_vertex_list.clear();
-	node_face_list.clear();
+	// Unmap the file.
+	geo_file_map_close(file_map);
 		
 	return is_success;
 }
@@ -469,7 +631,8 @@ ON_PROCESS_CLEANUP:
 // Free any local plugin resources allocated - called by ShaderMap before detaching from the plugin.
 BOOL on_shutdown(void)
 {
-	// Nothing to do.
+	// Stop the threads that decode CUSTOM version 2 files.
+	parallel_shutdown();
 
 	return TRUE;
 }
\ No newline at end of file
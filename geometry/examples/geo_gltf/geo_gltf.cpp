@@ -0,0 +1,1640 @@
+/*
+	===============================================================
+
+	SHADERMAP SDK LICENSE
+
+	The ShaderMap SDK is released under The MIT License (MIT)
+	http://opensource.org/licenses/MIT
+
+	Copyright (c) 2007-2019 Rendering Systems Inc.
+
+	Permission is hereby granted, free of charge, to any person
+	obtaining a copy of this software and associated documentation
+	files (the "Software"), to deal	in the Software without
+	restriction, including without limitation the rights to use,
+	copy, modify, merge, publish, distribute, sublicense, and/or
+	sell copies of the Software, and to permit persons to whom the
+	Software is	furnished to do so, subject to the following
+	conditions:
+
+	The above copyright notice and this permission notice shall be
+	included in	all copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+	OF MERCHANTABILITY,	FITNESS FOR A PARTICULAR PURPOSE AND
+	NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+	OTHER DEALINGS IN THE SOFTWARE.
+
+	Developed by: Neil Kemp at Rendering Systems Inc.
+
+	Online:		http://shadermap.com
+	Corporate:	http://renderingsystems.com
+
+	===============================================================
+*/
+/*
+	===============================================================
+
+	ABOUT:
+
+	This project builds a geometry import plugin for ShaderMap 4.3.
+	The plugin loads glTF 2.0 files, .gltf and .glb, and sends them
+	to ShaderMap in one of two formats: render or node.
+
+	The file and the external buffers of a .gltf are mapped into
+	memory and the binary chunk of a .glb is used where it is in
+	the mapped file. Accessors are read in place through their
+	buffer views on all cores, strided (interleaved) or not. Only
+	sparse accessors and accessors with no buffer view are
+	expanded into memory first. Positions and normals are copied
+	with memcpy() when the accessors already have the layout of
+	gp_node_vertex_s, 6 floats with positions first, and the node
+	has no transform. Otherwise each component is converted.
+
+	The meshes of the nodes of the scene are placed with the
+	transforms of the nodes. Each triangle primitive of each placed
+	mesh is a subset, primitives with the same material are a
+	material id and the base color of the material is the face
+	color if the options ask for material colors from the file.
+	Points and lines are skipped, strips and fans are split into
+	triangles. TEXCOORD_0, TEXCOORD_1, ... are the uv channels of
+	node geometry and TEXCOORD_0 the uvs of render geometry.
+	Primitives with no normals get smooth normals made from their
+	faces (see "geo_node_normals.cpp").
+
+	Files that require a compression extension such as Draco or
+	meshopt are not loaded.
+
+	All geometry import plugins have the extension .smg and are
+	stored in the ShaderMap installation directory at:
+	"plugins\bin\geometry"
+
+	See "geometry\examples\geo_custom\geo_custom.cpp" to setup
+	your system for development. The steps are the same for this
+	project.
+
+	===============================================================
+*/
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Plugin includes
+
+#include "../../geo_plugin_core.cpp"
+#include "../../geo_file_map.cpp"
+#include "../../geo_mesh_build.cpp"
+#include "../../geo_subset_sort.cpp"
+#include "../../geo_text_parse.cpp"
+#include "../../geo_node_normals.cpp"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+
+// ------------------------------------------------------------------
+// ------------------------------------------------------------------
+// Local defines
+
+// JSON value types
+#define GLTF_JSON_NULL							0
+#define GLTF_JSON_BOOL							1
+#define GLTF_JSON_NUMBER						2
+#define GLTF_JSON_STRING						3
+#define GLTF_JSON_ARRAY							4
+#define GLTF_JSON_OBJECT						5
+
+// Deepest nesting of JSON arrays and objects.
+#define GLTF_JSON_MAX_DEPTH						64
+
+// Accessor component types
+#define GLTF_BYTE								5120
+#define GLTF_UNSIGNED_BYTE						5121
+#define GLTF_SHORT								5122
+#define GLTF_UNSIGNED_SHORT						5123
+#define GLTF_UNSIGNED_INT						5125
+#define GLTF_FLOAT								5126
+
+// Primitive modes
+#define GLTF_MODE_TRIANGLES						4
+#define GLTF_MODE_TRIANGLE_STRIP				5
+#define GLTF_MODE_TRIANGLE_FAN					6
+
+// GLB header and chunk types
+#define GLTF_GLB_MAGIC							0x46546C67		// "glTF"
+#define GLTF_GLB_CHUNK_JSON						0x4E4F534A		// "JSON"
+#define GLTF_GLB_CHUNK_BIN						0x004E4942		// "BIN"
+
+// Most uv channels read, TEXCOORD_0 to TEXCOORD_7.
+#define GLTF_MAX_UV_CHANNEL_COUNT				8
+
+// An index that is not in the file.
+#define GLTF_NONE								UINT_MAX
+
+// Vertices or faces in each chunk given to a thread.
+#define GLTF_CHUNK_SIZE							16384
+
+
+// ------------------------------------------------------------------
+// ------------------------------------------------------------------
+// Local structs
+
+// A JSON value. Arrays and objects hold the indices of their values in the document.
+struct gltf_json_s
+{
+	unsigned int								type;
+	double										number;					// Number, or 1 and 0 for true and false
+	std::string									string;
+	std::vector<unsigned int>					child_list;				// Values of an array or object
+	std::vector<std::string>					key_list;				// Keys of an object
+
+	// c()
+	gltf_json_s(void)
+	{	type = GLTF_JSON_NULL; number = 0.0;
+	}
+};
+
+// A parsed JSON text. The root is value 0.
+struct gltf_document_s
+{
+	std::vector<gltf_json_s>					value_list;
+};
+
+// A buffer of the file. Points into a mapped file or data_list.
+struct gltf_buffer_s
+{
+	const unsigned char*						data;
+	unsigned long long							size;
+	std::vector<unsigned char>					data_list;				// A decoded data: uri
+	geo_file_map_s								file_map;				// An external buffer file
+
+	// c()
+	gltf_buffer_s(void)
+	{	data = 0; size = 0;
+	}
+};
+
+// An accessor ready to read.
+struct gltf_accessor_s
+{
+	const unsigned char*						data;					// The first element
+	size_t										stride;					// Bytes from one element to the next
+	unsigned int								count;
+	unsigned int								component_type;
+	unsigned int								component_count;
+	BOOL										is_normalized;
+	std::vector<unsigned char>					data_list;				// The elements of a sparse accessor or one with no buffer view
+
+	// c()
+	gltf_accessor_s(void)
+	{	data = 0; stride = 0; count = 0; component_type = GLTF_FLOAT; component_count = 0; is_normalized = FALSE;
+	}
+};
+
+// A triangle primitive of a mesh placed by a node. It is a subset.
+struct gltf_instance_s
+{
+	const gltf_json_s*							primitive;
+	double										matrix_array[16];		// Column major node transform
+	unsigned int								material;				// Material index or GLTF_NONE
+	unsigned int								vertex_start, vertex_count;
+	unsigned int								face_start, face_count;
+};
+
+// A node to place and the transform of its parent.
+struct gltf_node_s
+{
+	unsigned int								node;
+	double										matrix_array[16];		// Column major parent transform
+};
+
+// Reads the positions and normals of the vertices of a primitive.
+struct gltf_vertex_body_s
+{
+	const gltf_accessor_s*						position;
+	const gltf_accessor_s*						normal;					// Can be 0
+	float										matrix_array[12];		// Rows of the 3 x 4 position transform
+	float										normal_matrix_array[9];	// Rows of the normal transform
+	BOOL										is_transform;			// Apply the transforms, else the node has none
+	BOOL										is_copy;				// The accessors have the layout of gp_node_vertex_s and there is no transform
+	gp_node_vertex_s*							vertex_array;
+
+	BOOL operator()(unsigned int vertex_start, unsigned int vertex_end) const;
+};
+
+// Reads the uvs of the vertices of a primitive. v is flipped, glTF uvs start at the top.
+struct gltf_uv_body_s
+{
+	const gltf_accessor_s*						uv;						// Can be 0, the uvs are then 0
+	gp_node_uv_s*								uv_array;
+
+	BOOL operator()(unsigned int vertex_start, unsigned int vertex_end) const;
+};
+
+// Reads the triangles of a primitive with indices from 0 to vertex_count - 1.
+struct gltf_face_body_s
+{
+	const gltf_accessor_s*						index;					// Can be 0, the vertices are then used in order
+	unsigned int								vertex_count;
+	unsigned int								mode;					// Triangles, strip or fan
+	unsigned int								subset;
+	unsigned int								color;
+	BOOL										is_flip;				// Reverse the winding, the transform mirrors
+	gp_node_face_s*								face_array;
+
+	BOOL operator()(unsigned int face_start, unsigned int face_end) const;
+};
+
+// Adds the first vertex of a primitive to the indices of its faces.
+struct gltf_offset_body_s
+{
+	unsigned int								vertex_start;
+	gp_node_face_s*								face_array;
+
+	BOOL operator()(unsigned int face_start, unsigned int face_end) const
+	{	for(unsigned int i=face_start; i<face_end; i++)
+		{	face_array[i].a += vertex_start;
+			face_array[i].b += vertex_start;
+			face_array[i].c += vertex_start;
+		}
+		return TRUE;
+	}
+};
+
+
+// ------------------------------------------------------------------
+// ------------------------------------------------------------------
+// Local functions called during process
+
+// Skip JSON white space.
+inline void gltf_skip_json_space(const char*& pointer, const char* end)
+{
+	while(pointer < end && (*pointer == ' ' || *pointer == '\t' || *pointer == '\n' || *pointer == '\r'))
+	{	pointer++;
+	}
+}
+
+// Append code_point to string_in_out as UTF-8.
+void gltf_append_utf8(unsigned int code_point, std::string& string_in_out)
+{
+	if(code_point < 0x80)
+	{	string_in_out += (char)code_point;
+	}
+	else if(code_point < 0x800)
+	{	string_in_out += (char)(0xC0 | code_point >> 6);
+		string_in_out += (char)(0x80 | (code_point & 0x3F));
+	}
+	else if(code_point < 0x10000)
+	{	string_in_out += (char)(0xE0 | code_point >> 12);
+		string_in_out += (char)(0x80 | (code_point >> 6 & 0x3F));
+		string_in_out += (char)(0x80 | (code_point & 0x3F));
+	}
+	else
+	{	string_in_out += (char)(0xF0 | code_point >> 18);
+		string_in_out += (char)(0x80 | (code_point >> 12 & 0x3F));
+		string_in_out += (char)(0x80 | (code_point >> 6 & 0x3F));
+		string_in_out += (char)(0x80 | (code_point & 0x3F));
+	}
+}
+
+// Read the 4 hex digits of a \u escape. Returns FALSE if they are not hex digits.
+BOOL gltf_parse_hex(const char*& pointer, const char* end, unsigned int& value_out)
+{
+	value_out = 0;
+	for(unsigned int i=0; i<4; i++, pointer++)
+	{	if(pointer >= end)
+		{	return FALSE;
+		}
+		if(*pointer >= '0' && *pointer <= '9')
+		{	value_out = value_out * 16 + (unsigned int)(*pointer - '0');
+		}
+		else if((*pointer | 0x20) >= 'a' && (*pointer | 0x20) <= 'f')
+		{	value_out = value_out * 16 + (unsigned int)((*pointer | 0x20) - 'a' + 10);
+		}
+		else
+		{	return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+// Parse the JSON string at pointer, which is at the opening quote, and move pointer past it. Returns FALSE if the
+// string is not valid. Throws std::bad_alloc.
+BOOL gltf_parse_json_string(const char*& pointer, const char* end, std::string& string_out)
+{
+	// Local data
+	unsigned int								code_point, low;
+
+
+	string_out.clear();
+	for(pointer++; pointer<end && *pointer!='"'; )
+	{	if(*pointer != '\\')
+		{	string_out += *pointer++;
+			continue;
+		}
+		if(++pointer >= end)
+		{	return FALSE;
+		}
+		switch(*pointer++)
+		{	case '"':	string_out += '"';	break;
+			case '\\':	string_out += '\\';	break;
+			case '/':	string_out += '/';	break;
+			case 'b':	string_out += '\b';	break;
+			case 'f':	string_out += '\f';	break;
+			case 'n':	string_out += '\n';	break;
+			case 'r':	string_out += '\r';	break;
+			case 't':	string_out += '\t';	break;
+			case 'u':
+				if(!gltf_parse_hex(pointer, end, code_point))
+				{	return FALSE;
+				}
+				// A surrogate pair is one code point.
+				if(code_point >= 0xD800 && code_point < 0xDC00 && end - pointer >= 6 && pointer[0] == '\\' && pointer[1] == 'u')
+				{	pointer += 2;
+					if(!gltf_parse_hex(pointer, end, low) || low < 0xDC00 || low >= 0xE000)
+					{	return FALSE;
+					}
+					code_point = 0x10000 + ((code_point - 0xD800) << 10) + (low - 0xDC00);
+				}
+				gltf_append_utf8(code_point, string_out);
+				break;
+			default:
+				return FALSE;
+		}
+	}
+	if(pointer >= end)
+	{	return FALSE;
+	}
+	pointer++;
+	return TRUE;
+}
+
+// Parse the JSON value at pointer into document_in_out and move pointer past it. Returns the index of the value or
+// GLTF_NONE if the text is not valid JSON. Throws std::bad_alloc.
+unsigned int gltf_parse_json(const char*& pointer, const char* end, gltf_document_s& document_in_out, unsigned int depth)
+{
+	// Local data
+	unsigned int								index, child;
+	std::string									key;
+	char										close;
+
+
+	gltf_skip_json_space(pointer, end);
+	if(pointer >= end || depth > GLTF_JSON_MAX_DEPTH)
+	{	return GLTF_NONE;
+	}
+	index = (unsigned int)document_in_out.value_list.size();
+	document_in_out.value_list.push_back(gltf_json_s());
+
+	// Arrays and objects. The values are added after this one, so it is found by index.
+	if(*pointer == '[' || *pointer == '{')
+	{	document_in_out.value_list[index].type = *pointer == '[' ? GLTF_JSON_ARRAY : GLTF_JSON_OBJECT;
+		close = *pointer == '[' ? ']' : '}';
+		pointer++;
+		gltf_skip_json_space(pointer, end);
+		if(pointer < end && *pointer == close)
+		{	pointer++;
+			return index;
+		}
+		for(;;)
+		{	if(close == '}')
+			{	if(pointer >= end || *pointer != '"' || !gltf_parse_json_string(pointer, end, key))
+				{	return GLTF_NONE;
+				}
+				gltf_skip_json_space(pointer, end);
+				if(pointer >= end || *pointer != ':')
+				{	return GLTF_NONE;
+				}
+				pointer++;
+				document_in_out.value_list[index].key_list.push_back(key);
+			}
+			child = gltf_parse_json(pointer, end, document_in_out, depth + 1);
+			if(child == GLTF_NONE)
+			{	return GLTF_NONE;
+			}
+			document_in_out.value_list[index].child_list.push_back(child);
+			gltf_skip_json_space(pointer, end);
+			if(pointer < end && *pointer == ',')
+			{	pointer++;
+				gltf_skip_json_space(pointer, end);
+				continue;
+			}
+			if(pointer < end && *pointer == close)
+			{	pointer++;
+				return index;
+			}
+			return GLTF_NONE;
+		}
+	}
+
+	gltf_json_s& value = document_in_out.value_list[index];
+	if(*pointer == '"')
+	{	value.type = GLTF_JSON_STRING;
+		return gltf_parse_json_string(pointer, end, value.string) ? index : GLTF_NONE;
+	}
+	if(end - pointer >= 4 && !memcmp(pointer, "true", 4))
+	{	value.type		= GLTF_JSON_BOOL;
+		value.number	= 1.0;
+		pointer			+= 4;
+		return index;
+	}
+	if(end - pointer >= 5 && !memcmp(pointer, "false", 5))
+	{	value.type	= GLTF_JSON_BOOL;
+		pointer		+= 5;
+		return index;
+	}
+	if(end - pointer >= 4 && !memcmp(pointer, "null", 4))
+	{	pointer += 4;
+		return index;
+	}
+	value.type = GLTF_JSON_NUMBER;
+	return geo_text_parse_double(pointer, end, value.number) ? index : GLTF_NONE;
+}
+
+// Return the value of key in object, or 0 if object is 0, not an object or has no key.
+const gltf_json_s* gltf_json_get(const gltf_document_s& document, const gltf_json_s* object, const char* key)
+{
+	if(object && object->type == GLTF_JSON_OBJECT)
+	{	for(size_t i=0; i<object->key_list.size(); i++)
+		{	if(object->key_list[i] == key)
+			{	return &document.value_list[object->child_list[i]];
+			}
+		}
+	}
+	return 0;
+}
+
+// Return the value at index of array, or 0 if array is 0, not an array or too short.
+const gltf_json_s* gltf_json_at(const gltf_document_s& document, const gltf_json_s* array, unsigned int index)
+{
+	if(array && array->type == GLTF_JSON_ARRAY && index < array->child_list.size())
+	{	return &document.value_list[array->child_list[index]];
+	}
+	return 0;
+}
+
+// Return the number of values in array, 0 if it is not an array.
+unsigned int gltf_json_count(const gltf_json_s* array)
+{
+	return array && array->type == GLTF_JSON_ARRAY ? (unsigned int)array->child_list.size() : 0;
+}
+
+// Return the number of key in object, or default_value.
+double gltf_json_get_number(const gltf_document_s& document, const gltf_json_s* object, const char* key, double default_value)
+{
+	const gltf_json_s* value = gltf_json_get(document, object, key);
+
+	return value && (value->type == GLTF_JSON_NUMBER || value->type == GLTF_JSON_BOOL) ? value->number : default_value;
+}
+
+// Return the index or count of key in object, or GLTF_NONE if there is none or it is not a whole number.
+unsigned int gltf_json_get_index(const gltf_document_s& document, const gltf_json_s* object, const char* key)
+{
+	double number = gltf_json_get_number(document, object, key, -1.0);
+
+	return number >= 0.0 && number < (double)GLTF_NONE && number == floor(number) ? (unsigned int)number : GLTF_NONE;
+}
+
+// Return value as an index less than count, or GLTF_NONE if it is not.
+unsigned int gltf_json_to_index(const gltf_json_s* value, unsigned int count)
+{
+	return value && value->type == GLTF_JSON_NUMBER && value->number >= 0.0 && value->number < (double)count && value->number == floor(value->number) ? (unsigned int)value->number : GLTF_NONE;
+}
+
+// Return the string of key in object or an empty string.
+std::string gltf_json_get_string(const gltf_document_s& document, const gltf_json_s* object, const char* key)
+{
+	const gltf_json_s* value = gltf_json_get(document, object, key);
+
+	return value && value->type == GLTF_JSON_STRING ? value->string : std::string();
+}
+
+// Return TRUE if number is a whole number that can be a byte offset or length.
+inline BOOL gltf_is_size(double number)
+{
+	return number >= 0.0 && number <= 9007199254740992.0 && number == floor(number);
+}
+
+// Decode base64 text into data_out. Returns FALSE if the text is not base64. Throws std::bad_alloc.
+BOOL gltf_decode_base64(const char* pointer, const char* end, std::vector<unsigned char>& data_out)
+{
+	// Local data
+	unsigned int								bits, bit_count, value;
+
+
+	data_out.clear();
+	data_out.reserve((size_t)(end - pointer) / 4 * 3);
+	bits		= 0;
+	bit_count	= 0;
+	for(; pointer<end && *pointer!='='; pointer++)
+	{	if(*pointer >= 'A' && *pointer <= 'Z')
+		{	value = (unsigned int)(*pointer - 'A');
+		}
+		else if(*pointer >= 'a' && *pointer <= 'z')
+		{	value = (unsigned int)(*pointer - 'a') + 26;
+		}
+		else if(*pointer >= '0' && *pointer <= '9')
+		{	value = (unsigned int)(*pointer - '0') + 52;
+		}
+		else if(*pointer == '+' || *pointer == '/')
+		{	value = *pointer == '+' ? 62 : 63;
+		}
+		else
+		{	return FALSE;
+		}
+		bits		= (bits << 6 | value) & 0xFFFFFF;
+		bit_count	+= 6;
+		if(bit_count >= 8)
+		{	bit_count -= 8;
+			data_out.push_back((unsigned char)(bits >> bit_count));
+		}
+	}
+	return TRUE;
+}
+
+// Return the file name of a uri with %XX escapes decoded.
+std::string gltf_decode_uri(const std::string& uri)
+{
+	// Local data
+	std::string									name;
+	unsigned int								value;
+
+
+	for(size_t i=0; i<uri.size(); i++)
+	{	if(uri[i] == '%' && i + 2 < uri.size() && sscanf(uri.c_str() + i + 1, "%2x", &value) == 1)
+		{	name += (char)value;
+			i += 2;
+		}
+		else
+		{	name += uri[i];
+		}
+	}
+	return name;
+}
+
+// Widen a UTF-8 file name read from the file. The locale encoding is used on systems other than Windows.
+std::wstring gltf_widen(const std::string& name)
+{
+	// Local data
+	std::vector<wchar_t>						buffer(name.size() + 1);
+
+
+#ifdef _WIN32
+	if(!MultiByteToWideChar(CP_UTF8, 0, name.c_str(), -1, buffer.data(), (int)buffer.size()))
+	{	return std::wstring();
+	}
+#else
+	if(mbstowcs(buffer.data(), name.c_str(), buffer.size()) == (size_t)-1)
+	{	return std::wstring();
+	}
+	buffer.back() = 0;
+#endif
+	return std::wstring(buffer.data());
+}
+
+// Load the buffers of the file. bin_chunk is the binary chunk of a .glb or 0. External buffers are found in directory.
+// Returns 0 or an error message. Throws std::bad_alloc.
+const wchar_t* gltf_load_buffers(const gltf_document_s& document, const std::wstring& directory, const unsigned char* bin_chunk, unsigned long long bin_size, std::vector<gltf_buffer_s>& buffer_list_out)
+{
+	// Local data
+	const gltf_json_s*							buffer_array;
+	std::string									uri;
+	size_t										data_start;
+	double										byte_length;
+
+
+	buffer_array = gltf_json_get(document, &document.value_list[0], "buffers");
+	buffer_list_out.resize(gltf_json_count(buffer_array));
+	for(unsigned int i=0; i<buffer_list_out.size(); i++)
+	{	const gltf_json_s*	buffer_json	= gltf_json_at(document, buffer_array, i);
+		gltf_buffer_s&		buffer		= buffer_list_out[i];
+		byte_length	= gltf_json_get_number(document, buffer_json, "byteLength", -1.0);
+		uri			= gltf_json_get_string(document, buffer_json, "uri");
+		if(!gltf_is_size(byte_length))
+		{	return _T("A buffer has no byteLength.");
+		}
+
+		// The first buffer of a .glb with no uri is the binary chunk.
+		if(uri.empty())
+		{	if(i != 0 || !bin_chunk)
+			{	return _T("A buffer has no uri.");
+			}
+			buffer.data = bin_chunk;
+			buffer.size = bin_size;
+		}
+		else if(!uri.compare(0, 5, "data:"))
+		{	data_start = uri.find(";base64,");
+			if(data_start == std::string::npos || !gltf_decode_base64(uri.c_str() + data_start + 8, uri.c_str() + uri.size(), buffer.data_list))
+			{	return _T("A buffer has a data uri that is not base64.");
+			}
+			buffer.data = buffer.data_list.data();
+			buffer.size = buffer.data_list.size();
+		}
+		else
+		{	if(!geo_file_map_open((directory + gltf_widen(gltf_decode_uri(uri))).c_str(), buffer.file_map))
+			{	return _T("Failed to open the file of a buffer.");
+			}
+			buffer.data = buffer.file_map.data;
+			buffer.size = buffer.file_map.size;
+		}
+		if(buffer.size < byte_length)
+		{	return _T("A buffer is smaller than its byteLength.");
+		}
+		buffer.size = (unsigned long long)byte_length;
+	}
+	return 0;
+}
+
+// Find the data of buffer view view_index. stride_out is 0 if the view has no byteStride. Returns 0 or an error message.
+const wchar_t* gltf_get_buffer_view(const gltf_document_s& document, const std::vector<gltf_buffer_s>& buffer_list, unsigned int view_index,
+									const unsigned char*& data_out, unsigned long long& size_out, size_t& stride_out)
+{
+	// Local data
+	const gltf_json_s*							view;
+	unsigned int								buffer;
+	double										offset, length, stride;
+
+
+	view	= gltf_json_at(document, gltf_json_get(document, &document.value_list[0], "bufferViews"), view_index);
+	buffer	= gltf_json_get_index(document, view, "buffer");
+	offset	= gltf_json_get_number(document, view, "byteOffset", 0.0);
+	length	= gltf_json_get_number(document, view, "byteLength", -1.0);
+	stride	= gltf_json_get_number(document, view, "byteStride", 0.0);
+	if(!view || buffer >= buffer_list.size() || !gltf_is_size(offset) || !gltf_is_size(length) || !gltf_is_size(stride) || stride > 252.0)
+	{	return _T("An accessor has a buffer view that is not valid.");
+	}
+	if(offset + length > (double)buffer_list[buffer].size)
+	{	return _T("A buffer view is outside of its buffer.");
+	}
+	data_out	= buffer_list[buffer].data + (size_t)offset;
+	size_out	= (unsigned long long)length;
+	stride_out	= (size_t)stride;
+	return 0;
+}
+
+// Return the size of a component of component_type, 0 if it is not a component type.
+inline unsigned int gltf_get_component_size(unsigned int component_type)
+{
+	switch(component_type)
+	{	case GLTF_BYTE:
+		case GLTF_UNSIGNED_BYTE:	return 1;
+		case GLTF_SHORT:
+		case GLTF_UNSIGNED_SHORT:	return 2;
+		case GLTF_UNSIGNED_INT:
+		case GLTF_FLOAT:			return 4;
+		default:					return 0;
+	}
+}
+
+// Return the component at pointer as a float. Normalized integers are -1.0 - 1.0 or 0.0 - 1.0.
+inline float gltf_get_component(const unsigned char* pointer, unsigned int component_type, BOOL is_normalized)
+{
+	switch(component_type)
+	{	case GLTF_BYTE:				{ signed char value;	memcpy(&value, pointer, 1); return is_normalized ? std::max(value / 127.0f, -1.0f) : value; }
+		case GLTF_UNSIGNED_BYTE:	{ return is_normalized ? pointer[0] / 255.0f : pointer[0]; }
+		case GLTF_SHORT:			{ short value;			memcpy(&value, pointer, 2); return is_normalized ? std::max(value / 32767.0f, -1.0f) : value; }
+		case GLTF_UNSIGNED_SHORT:	{ unsigned short value;	memcpy(&value, pointer, 2); return is_normalized ? value / 65535.0f : value; }
+		case GLTF_UNSIGNED_INT:		{ unsigned int value;	memcpy(&value, pointer, 4); return is_normalized ? (float)(value / 4294967295.0) : (float)value; }
+		default:					{ float value;			memcpy(&value, pointer, 4); return value; }
+	}
+}
+
+// Return the index at pointer. component_type is an unsigned integer type.
+inline unsigned int gltf_get_index(const unsigned char* pointer, unsigned int component_type)
+{
+	switch(component_type)
+	{	case GLTF_UNSIGNED_BYTE:	{ return pointer[0]; }
+		case GLTF_UNSIGNED_SHORT:	{ unsigned short value;	memcpy(&value, pointer, 2); return value; }
+		default:					{ unsigned int value;	memcpy(&value, pointer, 4); return value; }
+	}
+}
+
+// Prepare accessor accessor_index to be read. Returns 0 or an error message. Throws std::bad_alloc.
+const wchar_t* gltf_get_accessor(const gltf_document_s& document, const std::vector<gltf_buffer_s>& buffer_list, unsigned int accessor_index, gltf_accessor_s& accessor_out)
+{
+	// Local data
+	static const char* const					type_array[] = { "SCALAR", "VEC2", "VEC3", "VEC4", "MAT2", "MAT3", "MAT4" };
+	static const unsigned int					type_count_array[] = { 1, 2, 3, 4, 4, 9, 16 };
+	const gltf_json_s*							accessor;
+	const gltf_json_s*							sparse;
+	const unsigned char*						view_data;
+	const unsigned char*						index_data;
+	const unsigned char*						value_data;
+	unsigned long long							view_size, index_view_size, value_view_size;
+	size_t										view_stride, element_size, index_stride, value_stride;
+	unsigned int								view, sparse_count, index_type, index;
+	double										offset, index_offset, value_offset;
+	std::string									type;
+	const wchar_t*								error;
+
+
+	accessor						= gltf_json_at(document, gltf_json_get(document, &document.value_list[0], "accessors"), accessor_index);
+	accessor_out.component_type		= gltf_json_get_index(document, accessor, "componentType");
+	accessor_out.count				= gltf_json_get_index(document, accessor, "count");
+	accessor_out.is_normalized		= gltf_json_get_number(document, accessor, "normalized", 0.0) != 0.0;
+	accessor_out.component_count	= 0;
+	type							= gltf_json_get_string(document, accessor, "type");
+	for(unsigned int i=0; i<7; i++)
+	{	if(type == type_array[i])
+		{	accessor_out.component_count = type_count_array[i];
+		}
+	}
+	if(!accessor || !gltf_get_component_size(accessor_out.component_type) || accessor_out.count == GLTF_NONE || !accessor_out.component_count)
+	{	return _T("An accessor is not valid.");
+	}
+	element_size		= (size_t)gltf_get_component_size(accessor_out.component_type) * accessor_out.component_count;
+	accessor_out.data	= 0;
+	accessor_out.stride	= element_size;
+
+	// Read the elements in place from the buffer view.
+	view = gltf_json_get_index(document, accessor, "bufferView");
+	if(view != GLTF_NONE)
+	{	if((error = gltf_get_buffer_view(document, buffer_list, view, view_data, view_size, view_stride)) != 0)
+		{	return error;
+		}
+		offset = gltf_json_get_number(document, accessor, "byteOffset", 0.0);
+		if(view_stride)
+		{	accessor_out.stride = view_stride;
+		}
+		if(!gltf_is_size(offset) || accessor_out.stride < element_size ||
+		   (accessor_out.count && offset + (double)(accessor_out.count - 1) * accessor_out.stride + element_size > (double)view_size))
+		{	return _T("An accessor is outside of its buffer view.");
+		}
+		accessor_out.data = view_data + (size_t)offset;
+	}
+
+	// Sparse accessors and accessors with no buffer view are expanded into data_list.
+	sparse = gltf_json_get(document, accessor, "sparse");
+	if(view != GLTF_NONE && !sparse)
+	{	return 0;
+	}
+	if((unsigned long long)accessor_out.count * element_size > (size_t)-1)
+	{	return _T("An accessor is too large.");
+	}
+	accessor_out.data_list.assign((size_t)accessor_out.count * element_size, 0);
+	for(size_t i=0; accessor_out.data && i<accessor_out.count; i++)
+	{	memcpy(&accessor_out.data_list[i * element_size], accessor_out.data + i * accessor_out.stride, element_size);
+	}
+	if(sparse)
+	{	const gltf_json_s* index_json = gltf_json_get(document, sparse, "indices");
+		const gltf_json_s* value_json = gltf_json_get(document, sparse, "values");
+		sparse_count	= gltf_json_get_index(document, sparse, "count");
+		index_type		= gltf_json_get_index(document, index_json, "componentType");
+		index_offset	= gltf_json_get_number(document, index_json, "byteOffset", 0.0);
+		value_offset	= gltf_json_get_number(document, value_json, "byteOffset", 0.0);
+		if(sparse_count == GLTF_NONE || (index_type != GLTF_UNSIGNED_BYTE && index_type != GLTF_UNSIGNED_SHORT && index_type != GLTF_UNSIGNED_INT) ||
+		   !gltf_is_size(index_offset) || !gltf_is_size(value_offset))
+		{	return _T("A sparse accessor is not valid.");
+		}
+		if((error = gltf_get_buffer_view(document, buffer_list, gltf_json_get_index(document, index_json, "bufferView"), index_data, index_view_size, index_stride)) != 0 ||
+		   (error = gltf_get_buffer_view(document, buffer_list, gltf_json_get_index(document, value_json, "bufferView"), value_data, value_view_size, value_stride)) != 0)
+		{	return error;
+		}
+		if(index_offset + (double)sparse_count * gltf_get_component_size(index_type) > (double)index_view_size ||
+		   value_offset + (double)sparse_count * element_size > (double)value_view_size)
+		{	return _T("A sparse accessor is outside of its buffer views.");
+		}
+		index_data	+= (size_t)index_offset;
+		value_data	+= (size_t)value_offset;
+		for(unsigned int i=0; i<sparse_count; i++)
+		{	index = gltf_get_index(index_data + (size_t)i * gltf_get_component_size(index_type), index_type);
+			if(index >= accessor_out.count)
+			{	return _T("A sparse accessor has an index that is out of range.");
+			}
+			memcpy(&accessor_out.data_list[(size_t)index * element_size], value_data + (size_t)i * element_size, element_size);
+		}
+	}
+	accessor_out.data	= accessor_out.data_list.data();
+	accessor_out.stride	= element_size;
+	return 0;
+}
+
+// Set matrix_out to a x b. The matrices are column major.
+void gltf_multiply_matrix(const double* a, const double* b, double* matrix_out)
+{
+	for(unsigned int column=0; column<4; column++)
+	{	for(unsigned int row=0; row<4; row++)
+		{	matrix_out[column*4+row] = a[row] * b[column*4] + a[4+row] * b[column*4+1] + a[8+row] * b[column*4+2] + a[12+row] * b[column*4+3];
+		}
+	}
+}
+
+// Set matrix_out to the local transform of node, its matrix or its translation x rotation x scale.
+void gltf_get_node_matrix(const gltf_document_s& document, const gltf_json_s* node, double* matrix_out)
+{
+	// Local data
+	const gltf_json_s*							matrix;
+	double										t[3], r[4], s[3], length;
+
+
+	matrix = gltf_json_get(document, node, "matrix");
+	if(gltf_json_count(matrix) == 16)
+	{	for(unsigned int i=0; i<16; i++)
+		{	const gltf_json_s* value = gltf_json_at(document, matrix, i);
+			matrix_out[i] = value->type == GLTF_JSON_NUMBER ? value->number : (i % 5 == 0 ? 1.0 : 0.0);
+		}
+		return;
+	}
+
+	for(unsigned int i=0; i<4; i++)
+	{	const gltf_json_s* value;
+		if(i < 3)
+		{	value	= gltf_json_at(document, gltf_json_get(document, node, "translation"), i);
+			t[i]	= value && value->type == GLTF_JSON_NUMBER ? value->number : 0.0;
+			value	= gltf_json_at(document, gltf_json_get(document, node, "scale"), i);
+			s[i]	= value && value->type == GLTF_JSON_NUMBER ? value->number : 1.0;
+		}
+		value	= gltf_json_at(document, gltf_json_get(document, node, "rotation"), i);
+		r[i]	= value && value->type == GLTF_JSON_NUMBER ? value->number : (i == 3 ? 1.0 : 0.0);
+	}
+	length = sqrt(r[0] * r[0] + r[1] * r[1] + r[2] * r[2] + r[3] * r[3]);
+	if(length > 0.0)
+	{	for(unsigned int i=0; i<4; i++)
+		{	r[i] /= length;
+		}
+	}
+	else
+	{	r[0] = r[1] = r[2] = 0.0; r[3] = 1.0;
+	}
+
+	// The columns of the rotation of quaternion x, y, z, w scaled by s.
+	matrix_out[0]	= (1.0 - 2.0 * (r[1] * r[1] + r[2] * r[2])) * s[0];
+	matrix_out[1]	= (2.0 * (r[0] * r[1] + r[2] * r[3])) * s[0];
+	matrix_out[2]	= (2.0 * (r[0] * r[2] - r[1] * r[3])) * s[0];
+	matrix_out[3]	= 0.0;
+	matrix_out[4]	= (2.0 * (r[0] * r[1] - r[2] * r[3])) * s[1];
+	matrix_out[5]	= (1.0 - 2.0 * (r[0] * r[0] + r[2] * r[2])) * s[1];
+	matrix_out[6]	= (2.0 * (r[1] * r[2] + r[0] * r[3])) * s[1];
+	matrix_out[7]	= 0.0;
+	matrix_out[8]	= (2.0 * (r[0] * r[2] + r[1] * r[3])) * s[2];
+	matrix_out[9]	= (2.0 * (r[1] * r[2] - r[0] * r[3])) * s[2];
+	matrix_out[10]	= (1.0 - 2.0 * (r[0] * r[0] + r[1] * r[1])) * s[2];
+	matrix_out[11]	= 0.0;
+	matrix_out[12]	= t[0];
+	matrix_out[13]	= t[1];
+	matrix_out[14]	= t[2];
+	matrix_out[15]	= 1.0;
+}
+
+// Add an instance for each triangle primitive of mesh placed with matrix. Throws std::bad_alloc.
+void gltf_add_mesh(const gltf_document_s& document, unsigned int mesh, const double* matrix, std::vector<gltf_instance_s>& instance_list_in_out)
+{
+	// Local data
+	const gltf_json_s*							primitive_array;
+	gltf_instance_s								instance;
+	unsigned int								mode;
+
+
+	primitive_array = gltf_json_get(document, gltf_json_at(document, gltf_json_get(document, &document.value_list[0], "meshes"), mesh), "primitives");
+	for(unsigned int i=0; i<gltf_json_count(primitive_array); i++)
+	{	instance.primitive	= gltf_json_at(document, primitive_array, i);
+		mode				= gltf_json_get(document, instance.primitive, "mode") ? gltf_json_get_index(document, instance.primitive, "mode") : GLTF_MODE_TRIANGLES;
+		if((mode == GLTF_MODE_TRIANGLES || mode == GLTF_MODE_TRIANGLE_STRIP || mode == GLTF_MODE_TRIANGLE_FAN) &&
+		   gltf_json_get(document, gltf_json_get(document, instance.primitive, "attributes"), "POSITION"))
+		{	memcpy(instance.matrix_array, matrix, sizeof(instance.matrix_array));
+			instance.material		= gltf_json_get_index(document, instance.primitive, "material");
+			instance.vertex_start	= instance.vertex_count = 0;
+			instance.face_start		= instance.face_count = 0;
+			instance_list_in_out.push_back(instance);
+		}
+	}
+}
+
+// Add the triangle primitives of the meshes placed by the nodes of the scene to instance_list_out. Nodes are placed
+// once, in the order of the scene. Throws std::bad_alloc.
+void gltf_get_instances(const gltf_document_s& document, std::vector<gltf_instance_s>& instance_list_out)
+{
+	// Local data
+	static const double							identity_array[16] = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+	const gltf_json_s*							root;
+	const gltf_json_s*							node_array;
+	const gltf_json_s*							scene_array;
+	const gltf_json_s*							child_array;
+	std::vector<unsigned int>					root_list;
+	std::vector<char>							is_placed_list;
+	std::vector<gltf_node_s>					stack_list;
+	gltf_node_s									entry;
+	double										local_array[16], world_array[16];
+	unsigned int								scene, node, node_count, mesh;
+
+
+	root		= &document.value_list[0];
+	node_array	= gltf_json_get(document, root, "nodes");
+	scene_array	= gltf_json_get(document, root, "scenes");
+	node_count	= gltf_json_count(node_array);
+	is_placed_list.assign(node_count, 0);
+
+	// The nodes of the scene, or the nodes that are no child if there are no scenes. With no nodes each mesh is placed
+	// once.
+	if(gltf_json_count(scene_array))
+	{	scene = gltf_json_get(document, root, "scene") ? gltf_json_get_index(document, root, "scene") : 0;
+		const gltf_json_s* scene_node_array = gltf_json_get(document, gltf_json_at(document, scene_array, scene), "nodes");
+		for(unsigned int i=0; i<gltf_json_count(scene_node_array); i++)
+		{	root_list.push_back(gltf_json_to_index(gltf_json_at(document, scene_node_array, i), node_count));
+		}
+	}
+	else if(gltf_json_count(node_array))
+	{	std::vector<char> is_child_list(node_count, 0);
+		for(unsigned int i=0; i<node_count; i++)
+		{	child_array = gltf_json_get(document, gltf_json_at(document, node_array, i), "children");
+			for(unsigned int j=0; j<gltf_json_count(child_array); j++)
+			{	node = gltf_json_to_index(gltf_json_at(document, child_array, j), node_count);
+				if(node != GLTF_NONE)
+				{	is_child_list[node] = 1;
+				}
+			}
+		}
+		for(unsigned int i=0; i<node_count; i++)
+		{	if(!is_child_list[i])
+			{	root_list.push_back(i);
+			}
+		}
+	}
+	else
+	{	for(unsigned int i=0; i<gltf_json_count(gltf_json_get(document, root, "meshes")); i++)
+		{	gltf_add_mesh(document, i, identity_array, instance_list_out);
+		}
+		return;
+	}
+
+	// Place the nodes depth first. The children are pushed last to first so they are placed in order.
+	memcpy(entry.matrix_array, identity_array, sizeof(entry.matrix_array));
+	for(size_t i=root_list.size(); i-->0; )
+	{	entry.node = root_list[i];
+		stack_list.push_back(entry);
+	}
+	while(!stack_list.empty())
+	{	entry = stack_list.back();
+		stack_list.pop_back();
+		if(entry.node == GLTF_NONE || is_placed_list[entry.node])
+		{	continue;
+		}
+		is_placed_list[entry.node] = 1;
+
+		const gltf_json_s* node_json = gltf_json_at(document, node_array, entry.node);
+		gltf_get_node_matrix(document, node_json, local_array);
+		gltf_multiply_matrix(entry.matrix_array, local_array, world_array);
+		mesh = gltf_json_get_index(document, node_json, "mesh");
+		if(mesh != GLTF_NONE)
+		{	gltf_add_mesh(document, mesh, world_array, instance_list_out);
+		}
+
+		child_array = gltf_json_get(document, node_json, "children");
+		memcpy(entry.matrix_array, world_array, sizeof(entry.matrix_array));
+		for(unsigned int j=gltf_json_count(child_array); j-->0; )
+		{	entry.node = gltf_json_to_index(gltf_json_at(document, child_array, j), node_count);
+			stack_list.push_back(entry);
+		}
+	}
+}
+
+// Return the base color of material as a face color, or the default face color if it has none.
+unsigned int gltf_get_material_color(const gltf_document_s& document, unsigned int material)
+{
+	// Local data
+	const gltf_json_s*							factor;
+	unsigned int								channel_array[3];
+	double										value;
+
+
+	factor = gltf_json_get(document, gltf_json_get(document, gltf_json_at(document, gltf_json_get(document, &document.value_list[0], "materials"), material), "pbrMetallicRoughness"), "baseColorFactor");
+	if(gltf_json_count(factor) < 3)
+	{	return gp_node_face_s().color;
+	}
+
+	// The factor is linear, face colors are sRGB.
+	for(unsigned int i=0; i<3; i++)
+	{	const gltf_json_s* channel = gltf_json_at(document, factor, i);
+		value = channel->type == GLTF_JSON_NUMBER ? std::min(std::max(channel->number, 0.0), 1.0) : 1.0;
+		value = value <= 0.0031308 ? value * 12.92 : 1.055 * pow(value, 1.0 / 2.4) - 0.055;
+		channel_array[i] = (unsigned int)(value * 255.0 + 0.5);
+	}
+	return RGB(channel_array[0], channel_array[1], channel_array[2]);
+}
+
+// Return TRUE if value is a finite float.
+inline BOOL gltf_is_finite(float value)
+{
+	return fabsf(value) <= 3.4028234663852886e38f;
+}
+
+BOOL gltf_vertex_body_s::operator()(unsigned int vertex_start, unsigned int vertex_end) const
+{
+	// Local data
+	float										p[3], n[3], length;
+
+
+	// The accessors are the vertex array.
+	if(is_copy)
+	{	memcpy(vertex_array + vertex_start, position->data + (size_t)vertex_start * sizeof(gp_node_vertex_s), (size_t)(vertex_end - vertex_start) * sizeof(gp_node_vertex_s));
+		for(unsigned int i=vertex_start; i<vertex_end; i++)
+		{	const gp_node_vertex_s& vertex = vertex_array[i];
+			if(!gltf_is_finite(vertex.x) || !gltf_is_finite(vertex.y) || !gltf_is_finite(vertex.z) || !gltf_is_finite(vertex.nx) || !gltf_is_finite(vertex.ny) || !gltf_is_finite(vertex.nz))
+			{	return FALSE;
+			}
+		}
+		return TRUE;
+	}
+
+	n[0] = n[1] = n[2] = 0.0f;
+	for(unsigned int i=vertex_start; i<vertex_end; i++)
+	{	const unsigned char* position_element = position->data + (size_t)i * position->stride;
+		for(unsigned int j=0; j<3; j++)
+		{	p[j] = gltf_get_component(position_element + j * gltf_get_component_size(position->component_type), position->component_type, position->is_normalized);
+		}
+		if(normal)
+		{	const unsigned char* normal_element = normal->data + (size_t)i * normal->stride;
+			for(unsigned int j=0; j<3; j++)
+			{	n[j] = gltf_get_component(normal_element + j * gltf_get_component_size(normal->component_type), normal->component_type, normal->is_normalized);
+			}
+		}
+
+		if(is_transform)
+		{	vertex_array[i] = gp_node_vertex_s(matrix_array[0] * p[0] + matrix_array[1] * p[1] + matrix_array[2] * p[2] + matrix_array[3],
+											   matrix_array[4] * p[0] + matrix_array[5] * p[1] + matrix_array[6] * p[2] + matrix_array[7],
+											   matrix_array[8] * p[0] + matrix_array[9] * p[1] + matrix_array[10] * p[2] + matrix_array[11],
+											   normal_matrix_array[0] * n[0] + normal_matrix_array[1] * n[1] + normal_matrix_array[2] * n[2],
+											   normal_matrix_array[3] * n[0] + normal_matrix_array[4] * n[1] + normal_matrix_array[5] * n[2],
+											   normal_matrix_array[6] * n[0] + normal_matrix_array[7] * n[1] + normal_matrix_array[8] * n[2]);
+			gp_node_vertex_s& vertex = vertex_array[i];
+			length = sqrtf(vertex.nx * vertex.nx + vertex.ny * vertex.ny + vertex.nz * vertex.nz);
+			if(length > 0.0f)
+			{	vertex.nx /= length;
+				vertex.ny /= length;
+				vertex.nz /= length;
+			}
+		}
+		else
+		{	vertex_array[i] = gp_node_vertex_s(p[0], p[1], p[2], n[0], n[1], n[2]);
+		}
+
+		const gp_node_vertex_s& vertex = vertex_array[i];
+		if(!gltf_is_finite(vertex.x) || !gltf_is_finite(vertex.y) || !gltf_is_finite(vertex.z) || !gltf_is_finite(vertex.nx) || !gltf_is_finite(vertex.ny) || !gltf_is_finite(vertex.nz))
+		{	return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+BOOL gltf_uv_body_s::operator()(unsigned int vertex_start, unsigned int vertex_end) const
+{
+	// Local data
+	unsigned int								component_size;
+
+
+	if(!uv)
+	{	for(unsigned int i=vertex_start; i<vertex_end; i++)
+		{	uv_array[i] = gp_node_uv_s(0.0f, 0.0f);
+		}
+		return TRUE;
+	}
+
+	component_size = gltf_get_component_size(uv->component_type);
+	for(unsigned int i=vertex_start; i<vertex_end; i++)
+	{	const unsigned char* element = uv->data + (size_t)i * uv->stride;
+		uv_array[i] = gp_node_uv_s(gltf_get_component(element, uv->component_type, uv->is_normalized), 1.0f - gltf_get_component(element + component_size, uv->component_type, uv->is_normalized));
+		if(!gltf_is_finite(uv_array[i].u) || !gltf_is_finite(uv_array[i].v))
+		{	return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+BOOL gltf_face_body_s::operator()(unsigned int face_start, unsigned int face_end) const
+{
+	// Local data
+	unsigned int								corner_array[3], index_array[3];
+
+
+	for(unsigned int i=face_start; i<face_end; i++)
+	{	// Every other triangle of a strip is reversed to keep the winding.
+		if(mode == GLTF_MODE_TRIANGLES)
+		{	corner_array[0] = i * 3; corner_array[1] = i * 3 + 1; corner_array[2] = i * 3 + 2;
+		}
+		else if(mode == GLTF_MODE_TRIANGLE_STRIP)
+		{	corner_array[0] = i + (i & 1); corner_array[1] = i + 1 - (i & 1); corner_array[2] = i + 2;
+		}
+		else
+		{	corner_array[0] = 0; corner_array[1] = i + 1; corner_array[2] = i + 2;
+		}
+		for(unsigned int j=0; j<3; j++)
+		{	index_array[j] = index ? gltf_get_index(index->data + (size_t)corner_array[j] * index->stride, index->component_type) : corner_array[j];
+			if(index_array[j] >= vertex_count)
+			{	return FALSE;
+			}
+		}
+		face_array[i] = gp_node_face_s(index_array[0], index_array[is_flip ? 2 : 1], index_array[is_flip ? 1 : 2], subset, color);
+	}
+	return TRUE;
+}
+
+// Return TRUE if the extensions the file requires can be ignored. Material and image extensions do not change the
+// geometry, compression extensions do.
+BOOL gltf_is_extension_supported(const gltf_document_s& document)
+{
+	// Local data
+	const gltf_json_s*							extension_array;
+
+
+	extension_array = gltf_json_get(document, &document.value_list[0], "extensionsRequired");
+	for(unsigned int i=0; i<gltf_json_count(extension_array); i++)
+	{	const std::string& name = gltf_json_at(document, extension_array, i)->string;
+		if(name != "KHR_mesh_quantization" && name.compare(0, 14, "KHR_materials_") && name != "KHR_texture_basisu" && name != "EXT_texture_webp")
+		{	return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+// Read the vertices, uvs and faces of a placed primitive into the lists at the instance's starts, with the subset index
+// subset. Returns 0 or an error message. Throws std::bad_alloc.
+const wchar_t* gltf_read_instance(const gltf_document_s& document, const std::vector<gltf_buffer_s>& buffer_list, const gltf_instance_s& instance, unsigned int subset, BOOL is_color,
+								  gp_node_vertex_s* vertex_array, gp_node_uv_s** uv_channel_array, unsigned int uv_channel_count, gp_node_face_s* face_array)
+{
+	// Local data
+	const gltf_json_s*							attributes;
+	gltf_accessor_s								position, normal, uv, index;
+	gltf_vertex_body_s							vertex_body;
+	gltf_uv_body_s								uv_body;
+	gltf_face_body_s							face_body;
+	gltf_offset_body_s							offset_body;
+	const wchar_t*								error;
+	const double*								m;
+	double										determinant, cofactor_array[9];
+	char										name[32];
+
+
+	attributes = gltf_json_get(document, instance.primitive, "attributes");
+	if((error = gltf_get_accessor(document, buffer_list, gltf_json_get_index(document, attributes, "POSITION"), position)) != 0)
+	{	return error;
+	}
+	if(position.component_count != 3 || position.count != instance.vertex_count)
+	{	return _T("A POSITION accessor is not valid.");
+	}
+	vertex_body.position	= &position;
+	vertex_body.normal		= 0;
+	if(gltf_json_get(document, attributes, "NORMAL"))
+	{	if((error = gltf_get_accessor(document, buffer_list, gltf_json_get_index(document, attributes, "NORMAL"), normal)) != 0)
+		{	return error;
+		}
+		if(normal.component_count != 3 || normal.count != position.count)
+		{	return _T("A NORMAL accessor is not valid.");
+		}
+		vertex_body.normal = &normal;
+	}
+
+	// Rows of the transform and of its cofactor matrix for the normals. The cofactor matrix is the inverse transpose
+	// times the determinant, so it is multiplied by the sign of the determinant.
+	m = instance.matrix_array;
+	for(unsigned int row=0; row<3; row++)
+	{	for(unsigned int column=0; column<4; column++)
+		{	vertex_body.matrix_array[row*4+column] = (float)m[column*4+row];
+		}
+	}
+	cofactor_array[0] = m[5] * m[10] - m[9] * m[6];		cofactor_array[1] = m[9] * m[2] - m[1] * m[10];		cofactor_array[2] = m[1] * m[6] - m[5] * m[2];
+	cofactor_array[3] = m[8] * m[6] - m[4] * m[10];		cofactor_array[4] = m[0] * m[10] - m[8] * m[2];		cofactor_array[5] = m[4] * m[2] - m[0] * m[6];
+	cofactor_array[6] = m[4] * m[9] - m[8] * m[5];		cofactor_array[7] = m[8] * m[1] - m[0] * m[9];		cofactor_array[8] = m[0] * m[5] - m[4] * m[1];
+	determinant = m[0] * cofactor_array[0] + m[4] * cofactor_array[1] + m[8] * cofactor_array[2];
+	for(unsigned int i=0; i<9; i++)
+	{	vertex_body.normal_matrix_array[i] = (float)(determinant < 0.0 ? -cofactor_array[i] : cofactor_array[i]);
+	}
+	vertex_body.is_transform = FALSE;
+	for(unsigned int i=0; i<16; i++)
+	{	if(m[i] != (i % 5 == 0 ? 1.0 : 0.0))
+		{	vertex_body.is_transform = TRUE;
+		}
+	}
+	vertex_body.is_copy	= !vertex_body.is_transform && vertex_body.normal && position.component_type == GLTF_FLOAT && normal.component_type == GLTF_FLOAT &&
+						  position.stride == sizeof(gp_node_vertex_s) && normal.stride == sizeof(gp_node_vertex_s) && normal.data == position.data + 3 * sizeof(float);
+	vertex_body.vertex_array = vertex_array + instance.vertex_start;
+	if(!parallel_for(instance.vertex_count, GLTF_CHUNK_SIZE, vertex_body, parallel_progress_s()))
+	{	return _T("A vertex has a value that is not a finite number.");
+	}
+
+	// TEXCOORD_n is uv channel n. The uvs of a channel the primitive does not have are 0.
+	for(unsigned int i=0; i<uv_channel_count; i++)
+	{	sprintf(name, "TEXCOORD_%u", i);
+		uv_body.uv = 0;
+		if(gltf_json_get(document, attributes, name))
+		{	if((error = gltf_get_accessor(document, buffer_list, gltf_json_get_index(document, attributes, name), uv)) != 0)
+			{	return error;
+			}
+			if(uv.component_count != 2 || uv.count != position.count)
+			{	return _T("A TEXCOORD accessor is not valid.");
+			}
+			uv_body.uv = &uv;
+		}
+		uv_body.uv_array = uv_channel_array[i] + instance.vertex_start;
+		if(!parallel_for(instance.vertex_count, GLTF_CHUNK_SIZE, uv_body, parallel_progress_s()))
+		{	return _T("A texture coordinate is not a finite number.");
+		}
+	}
+
+	// Read the faces with indices local to the primitive, make the normals then offset the indices.
+	face_body.index = 0;
+	if(gltf_json_get(document, instance.primitive, "indices"))
+	{	if((error = gltf_get_accessor(document, buffer_list, gltf_json_get_index(document, instance.primitive, "indices"), index)) != 0)
+		{	return error;
+		}
+		if(index.component_count != 1 || (index.component_type != GLTF_UNSIGNED_BYTE && index.component_type != GLTF_UNSIGNED_SHORT && index.component_type != GLTF_UNSIGNED_INT))
+		{	return _T("An indices accessor is not valid.");
+		}
+		face_body.index = &index;
+	}
+	face_body.vertex_count	= instance.vertex_count;
+	face_body.mode			= gltf_json_get(document, instance.primitive, "mode") ? gltf_json_get_index(document, instance.primitive, "mode") : GLTF_MODE_TRIANGLES;
+	face_body.subset		= subset;
+	face_body.color			= is_color ? gltf_get_material_color(document, instance.material) : gp_node_face_s().color;
+	face_body.is_flip		= determinant < 0.0;
+	face_body.face_array	= face_array + instance.face_start;
+	if(!parallel_for(instance.face_count, GLTF_CHUNK_SIZE, face_body, parallel_progress_s()))
+	{	return _T("A face has a vertex index that is out of range.");
+	}
+
+	if(!vertex_body.normal && !geo_create_node_normals(vertex_body.vertex_array, instance.vertex_count, face_body.face_array, instance.face_count))
+	{	throw std::bad_alloc();
+	}
+
+	offset_body.vertex_start	= instance.vertex_start;
+	offset_body.face_array		= face_body.face_array;
+	if(!parallel_for(instance.face_count, GLTF_CHUNK_SIZE, offset_body, parallel_progress_s()))
+	{	return _T("The import was cancelled.");
+	}
+	return 0;
+}
+
+
+// ------------------------------------------------------------------
+// ------------------------------------------------------------------
+// Local functions called during init, process, and shutdown
+
+// Initialize plugin - called when plugin is attached to ShaderMap.
+BOOL on_initialize(void)
+{
+	// Local data
+	const wchar_t*	ext_array[] = {_T("gltf"), _T("glb")};
+
+
+	// Tell ShaderMap we are starting initialization.
+	gp_begin_initialize();
+
+		// Set file format name and extension list.
+#ifdef _DEBUG
+		gp_set_file_info(_T("glTF 2.0 - DEBUG"), ext_array, 2);
+#else
+		gp_set_file_info(_T("glTF 2.0"), ext_array, 2);
+#endif
+
+	// Tell ShaderMap initialization is done.
+	gp_end_initialize();
+
+	return TRUE;
+}
+
+// Process plugin - called when plugin is asked by ShaderMap to import a 3D Model (geometry).
+BOOL on_process(unsigned int plugin_index, const wchar_t* file_path)
+{
+	// Local data
+	geo_file_map_s								file_map;
+	unsigned int								geometry_type, uv_channel_count, read_uv_channel_count, chunk_length, chunk_type, count, mode, subset_count;
+	unsigned long long							vertex_total, face_total, glb_length, bin_size;
+	BOOL										is_success, is_color;
+	const wchar_t*								error;
+	const char*									json_start;
+	const char*									json_end;
+	const unsigned char*						bin_chunk;
+	gltf_document_s								document;
+	std::wstring								directory;
+	std::vector<gltf_buffer_s>					buffer_list;
+	std::vector<gltf_instance_s>				instance_list;
+	std::vector<gp_node_vertex_s>				vertex_list;
+	std::vector<gp_node_face_s>					face_list;
+	std::vector<gp_node_uv_s>					uv_list_array[GLTF_MAX_UV_CHANNEL_COUNT];
+	std::vector<unsigned int>					uv_index_list, material_list;
+	geo_subset_material_s						subset_material;
+	gp_render_vertex_s							render_vertex;
+	unsigned int								corner_array[3];
+	gp_node_uv_data_s							node_uv_data;
+	gp_node_uv_s*								node_uv_channel_array[GLTF_MAX_UV_CHANNEL_COUNT];
+	unsigned int*								node_uv_index_array[GLTF_MAX_UV_CHANNEL_COUNT];
+	unsigned int								node_uv_count_array[GLTF_MAX_UV_CHANNEL_COUNT];
+	geo_mesh_s									render_mesh;
+	char										name[32];
+	size_t										i;
+
+
+	// Get geometry type. This can be of type render or of type node.
+	geometry_type = gp_get_geometry_type();
+
+	// Set return value
+	is_success = TRUE;
+
+	// Map the file into memory. See "geo_file_map.cpp".
+	if(!geo_file_map_open(file_path, file_map))
+	{	LOG_ERROR_MSG(plugin_index, _T("Failed to open file at file_path."));
+		return FALSE;
+	}
+
+	// -----------------
+
+	// A .glb has a 12 byte header, a JSON chunk and an optional binary chunk. A .gltf is JSON text.
+	bin_chunk	= 0;
+	bin_size	= 0;
+	if(file_map.size >= 12 && !memcmp(file_map.data, "glTF", 4))
+	{	memcpy(&count, file_map.data + 4, 4);
+		memcpy(&chunk_length, file_map.data + 8, 4);
+		glb_length = std::min<unsigned long long>(chunk_length, file_map.size);
+		if(count != 2)
+		{	LOG_ERROR_MSG(plugin_index, _T("The file is not glTF version 2."));
+			is_success = FALSE;
+			goto ON_PROCESS_CLEANUP;
+		}
+		if(glb_length < 20)
+		{	LOG_ERROR_MSG(plugin_index, _T("The file has no JSON chunk."));
+			is_success = FALSE;
+			goto ON_PROCESS_CLEANUP;
+		}
+		memcpy(&chunk_length, file_map.data + 12, 4);
+		memcpy(&chunk_type, file_map.data + 16, 4);
+		if(chunk_type != GLTF_GLB_CHUNK_JSON || 20ull + chunk_length > glb_length)
+		{	LOG_ERROR_MSG(plugin_index, _T("The file has no JSON chunk."));
+			is_success = FALSE;
+			goto ON_PROCESS_CLEANUP;
+		}
+		json_start	= (const char*)file_map.data + 20;
+		json_end	= json_start + chunk_length;
+
+		// The binary chunk follows the JSON chunk, which is padded to 4 bytes.
+		bin_size = 20ull + ((chunk_length + 3ull) & ~3ull);
+		if(bin_size + 8 <= glb_length)
+		{	memcpy(&chunk_length, file_map.data + bin_size, 4);
+			memcpy(&chunk_type, file_map.data + bin_size + 4, 4);
+			if(chunk_type == GLTF_GLB_CHUNK_BIN)
+			{	bin_chunk	= file_map.data + bin_size + 8;
+				bin_size	= std::min<unsigned long long>(chunk_length, glb_length - bin_size - 8);
+			}
+		}
+		if(!bin_chunk)
+		{	bin_size = 0;
+		}
+	}
+	else
+	{	json_start	= (const char*)file_map.data;
+		json_end	= json_start + file_map.size;
+		if(file_map.size >= 3 && !memcmp(json_start, "\xEF\xBB\xBF", 3))
+		{	json_start += 3;
+		}
+	}
+
+	// Parse the JSON. The root must be an object.
+	try
+	{	if(gltf_parse_json(json_start, json_end, document, 0) == GLTF_NONE || document.value_list[0].type != GLTF_JSON_OBJECT)
+		{	LOG_ERROR_MSG(plugin_index, _T("The file is not valid glTF JSON."));
+			is_success = FALSE;
+			goto ON_PROCESS_CLEANUP;
+		}
+	}
+	catch(...)
+	{	LOG_ERROR_MSG(plugin_index, _T("Memory Allocation Error: Failed to parse the JSON."));
+		is_success = FALSE;
+		goto ON_PROCESS_CLEANUP;
+	}
+	if(gltf_json_get_string(document, gltf_json_get(document, &document.value_list[0], "asset"), "version").compare(0, 2, "2."))
+	{	LOG_ERROR_MSG(plugin_index, _T("The file is not glTF version 2."));
+		is_success = FALSE;
+		goto ON_PROCESS_CLEANUP;
+	}
+	if(!gltf_is_extension_supported(document))
+	{	LOG_ERROR_MSG(plugin_index, _T("The file requires an extension that is not supported, such as mesh compression."));
+		is_success = FALSE;
+		goto ON_PROCESS_CLEANUP;
+	}
+
+	// Load the buffers and find the triangle primitives of the scene. External buffers are next to the file.
+	try
+	{	directory = file_path;
+		i = directory.find_last_of(_T("\\/"));
+		directory.resize(i == std::wstring::npos ? 0 : i + 1);
+		error = gltf_load_buffers(document, directory, bin_chunk, bin_size, buffer_list);
+		if(!error)
+		{	gltf_get_instances(document, instance_list);
+		}
+	}
+	catch(...)
+	{	error = _T("Memory Allocation Error: Failed to load the buffers.");
+	}
+	if(error)
+	{	LOG_ERROR_MSG(plugin_index, error);
+		is_success = FALSE;
+		goto ON_PROCESS_CLEANUP;
+	}
+	if(instance_list.empty())
+	{	LOG_ERROR_MSG(plugin_index, _T("The file has no triangle meshes."));
+		is_success = FALSE;
+		goto ON_PROCESS_CLEANUP;
+	}
+
+	// Place the vertices and faces of each instance in the lists. The uv channels are TEXCOORD_0 up to the last used.
+	vertex_total		= 0;
+	face_total			= 0;
+	uv_channel_count	= 0;
+	for(i=0; i<instance_list.size(); i++)
+	{	gltf_instance_s&	instance	= instance_list[i];
+		const gltf_json_s*	attributes	= gltf_json_get(document, instance.primitive, "attributes");
+		const gltf_json_s*	accessors	= gltf_json_get(document, &document.value_list[0], "accessors");
+		instance.vertex_count	= gltf_json_get_index(document, gltf_json_at(document, accessors, gltf_json_get_index(document, attributes, "POSITION")), "count");
+		count					= instance.vertex_count;
+		if(gltf_json_get(document, instance.primitive, "indices"))
+		{	count = gltf_json_get_index(document, gltf_json_at(document, accessors, gltf_json_get_index(document, instance.primitive, "indices")), "count");
+		}
+		if(instance.vertex_count == GLTF_NONE || count == GLTF_NONE)
+		{	LOG_ERROR_MSG(plugin_index, _T("A primitive has an accessor that is not valid."));
+			is_success = FALSE;
+			goto ON_PROCESS_CLEANUP;
+		}
+		mode					= gltf_json_get(document, instance.primitive, "mode") ? gltf_json_get_index(document, instance.primitive, "mode") : GLTF_MODE_TRIANGLES;
+		instance.face_count		= mode == GLTF_MODE_TRIANGLES ? count / 3 : (count < 3 ? 0 : count - 2);
+		instance.vertex_start	= (unsigned int)vertex_total;
+		instance.face_start		= (unsigned int)face_total;
+		vertex_total			+= instance.vertex_count;
+		face_total				+= instance.face_count;
+		if(vertex_total >= GLTF_NONE || face_total >= GLTF_NONE / 3)
+		{	LOG_ERROR_MSG(plugin_index, _T("The file has too many vertices or faces."));
+			is_success = FALSE;
+			goto ON_PROCESS_CLEANUP;
+		}
+		for(unsigned int j=uv_channel_count; j<GLTF_MAX_UV_CHANNEL_COUNT; j++)
+		{	sprintf(name, "TEXCOORD_%u", j);
+			if(gltf_json_get(document, attributes, name))
+			{	uv_channel_count = j + 1;
+			}
+		}
+	}
+	if(!face_total)
+	{	LOG_ERROR_MSG(plugin_index, _T("The file has no faces."));
+		is_success = FALSE;
+		goto ON_PROCESS_CLEANUP;
+	}
+	subset_count = (unsigned int)instance_list.size();
+
+	// Render geometry only uses TEXCOORD_0.
+	read_uv_channel_count = geometry_type == GP_GEOMETRY_TYPE_RENDER ? std::min<unsigned int>(uv_channel_count, 1) : uv_channel_count;
+	try
+	{	vertex_list.resize((size_t)vertex_total);
+		face_list.resize((size_t)face_total);
+		for(unsigned int j=0; j<read_uv_channel_count; j++)
+		{	uv_list_array[j].resize((size_t)vertex_total);
+			node_uv_channel_array[j] = uv_list_array[j].data();
+		}
+	}
+	catch(...)
+	{	LOG_ERROR_MSG(plugin_index, _T("Memory Allocation Error: Failed to allocate the vertex and face lists."));
+		is_success = FALSE;
+		goto ON_PROCESS_CLEANUP;
+	}
+
+	// Read the instances. Material colors are only read for node geometry if the options ask for them.
+	is_color = geometry_type == GP_GEOMETRY_TYPE_NODE && gp_is_option_material_color_from_file();
+	for(i=0; i<instance_list.size(); i++)
+	{	try
+		{	error = gltf_read_instance(document, buffer_list, instance_list[i], (unsigned int)i, is_color, vertex_list.data(), node_uv_channel_array, read_uv_channel_count, face_list.data());
+		}
+		catch(...)
+		{	error = _T("Memory Allocation Error: Failed to read a primitive.");
+		}
+		if(error)
+		{	LOG_ERROR_MSG(plugin_index, error);
+			is_success = FALSE;
+			goto ON_PROCESS_CLEANUP;
+		}
+	}
+
+	if(!uv_channel_count)
+	{	gp_flag_no_uv_geometry();
+	}
+
+	// -----------------
+
+	// GP_GEOMETRY_TYPE_RENDER
+	// This format for geometry is used for 3d models in the material visualizer.
+	if(geometry_type == GP_GEOMETRY_TYPE_RENDER)
+	{
+		// Corners with the same position, normal and uv share one render vertex. See "geo_mesh_build.cpp".
+		if(!geo_mesh_reserve(render_mesh, (unsigned int)face_list.size()))
+		{	LOG_ERROR_MSG(plugin_index, _T("Memory Allocation Error: Failed to allocate the render geometry lists."));
+			is_success = FALSE;
+			goto ON_PROCESS_CLEANUP;
+		}
+		try
+		{	for(i=0; i<face_list.size(); i++)
+			{	const gp_node_face_s& face = face_list[i];
+				for(unsigned int j=0; j<3; j++)
+				{	const unsigned int			index	= j == 0 ? face.a : (j == 1 ? face.b : face.c);
+					const gp_node_vertex_s&		vertex	= vertex_list[index];
+					render_vertex.x		= vertex.x;
+					render_vertex.y		= vertex.y;
+					render_vertex.z		= vertex.z;
+					render_vertex.nx	= vertex.nx;
+					render_vertex.ny	= vertex.ny;
+					render_vertex.nz	= vertex.nz;
+					render_vertex.u		= uv_channel_count ? uv_list_array[0][index].u : 0.0f;
+					render_vertex.v		= uv_channel_count ? -uv_list_array[0][index].v : 0.0f;
+					corner_array[j]		= geo_mesh_add_vertex(render_mesh, render_vertex);
+				}
+				geo_mesh_add_face(render_mesh, corner_array[0], corner_array[1], corner_array[2], face.subset_index);
+			}
+		}
+		catch(...)
+		{	LOG_ERROR_MSG(plugin_index, _T("Memory Allocation Error: Failed to allocate the render geometry lists."));
+			is_success = FALSE;
+			goto ON_PROCESS_CLEANUP;
+		}
+		std::vector<gp_node_vertex_s>().swap(vertex_list);
+		std::vector<gp_node_face_s>().swap(face_list);
+
+		if(!geo_mesh_optimize(render_mesh))
+		{	LOG_ERROR_MSG(plugin_index, _T("Memory Allocation Error: Failed to optimize the render geometry."));
+			is_success = FALSE;
+			goto ON_PROCESS_CLEANUP;
+		}
+
+		// Send the render lists to ShaderMap. No additional UV arrays.
+		if(!gp_create_render_geometry(render_mesh.vertex_list.data(), (unsigned int)render_mesh.vertex_list.size(), render_mesh.face_list.data(), (unsigned int)render_mesh.face_list.size(),
+									  subset_count, FALSE, 0, 0))
+		{	LOG_ERROR_MSG(plugin_index, _T("Failed to create render geometry with gp_create_render_geometry."));
+			is_success = FALSE;
+			goto ON_PROCESS_CLEANUP;
+		}
+	}
+	// GP_GEOMETRY_TYPE_NODE
+	// This format for geometry is used for 3d model nodes in the project grid.
+	else if(geometry_type == GP_GEOMETRY_TYPE_NODE)
+	{
+		// Primitives with the same material are a material id, in the order the materials are first used. See
+		// "geo_subset_sort.cpp".
+		try
+		{	material_list.resize(instance_list.size());
+			for(i=0; i<instance_list.size(); i++)
+			{	material_list[i] = instance_list[i].material;
+			}
+			if(!geo_list_subset_materials(material_list.data(), (unsigned int)material_list.size(), subset_material))
+			{	throw std::bad_alloc();
+			}
+			geo_define_subset_materials(subset_material);
+
+			// Every channel has a uv for each vertex, so all channels use the vertex indices of the faces.
+			uv_index_list.resize(uv_channel_count ? face_list.size() * 3 : 0);
+		}
+		catch(...)
+		{	LOG_ERROR_MSG(plugin_index, _T("Memory Allocation Error: Failed to allocate the uv index list."));
+			is_success = FALSE;
+			goto ON_PROCESS_CLEANUP;
+		}
+		for(i=0; i<uv_index_list.size()/3; i++)
+		{	uv_index_list[i*3]		= face_list[i].a;
+			uv_index_list[i*3+1]	= face_list[i].b;
+			uv_index_list[i*3+2]	= face_list[i].c;
+		}
+		for(unsigned int j=0; j<uv_channel_count; j++)
+		{	node_uv_index_array[j]	= uv_index_list.data();
+			node_uv_count_array[j]	= (unsigned int)vertex_list.size();
+		}
+		node_uv_data.uv_channel_count	= uv_channel_count;
+		node_uv_data.uv_channels_array	= node_uv_channel_array;
+		node_uv_data.uv_indices_array	= node_uv_index_array;
+		node_uv_data.uv_count_array		= node_uv_count_array;
+
+		// Send the node lists to ShaderMap. Each primitive is a subset.
+		if(!gp_create_node_geometry(vertex_list.data(), (unsigned int)vertex_list.size(), face_list.data(), (unsigned int)face_list.size(), &node_uv_data, subset_count, FALSE))
+		{	LOG_ERROR_MSG(plugin_index, _T("Failed to create node geometry with gp_create_node_geometry."));
+			is_success = FALSE;
+			goto ON_PROCESS_CLEANUP;
+		}
+	}
+
+ON_PROCESS_CLEANUP:
+
+	// Unmap the buffer files and the file.
+	for(i=0; i<buffer_list.size(); i++)
+	{	geo_file_map_close(buffer_list[i].file_map);
+	}
+	geo_file_map_close(file_map);
+
+	return is_success;
+}
+
+// Free any local plugin resources allocated - called by ShaderMap before detaching from the plugin.
+BOOL on_shutdown(void)
+{
+	// Stop the threads that read the files.
+	parallel_shutdown();
+
+	return TRUE;
+}
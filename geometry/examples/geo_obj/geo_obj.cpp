@@ -0,0 +1,985 @@
+/*
+	===============================================================
+
+	SHADERMAP SDK LICENSE
+
+	The ShaderMap SDK is released under The MIT License (MIT)
+	http://opensource.org/licenses/MIT
+
+	Copyright (c) 2007-2019 Rendering Systems Inc.
+
+	Permission is hereby granted, free of charge, to any person
+	obtaining a copy of this software and associated documentation
+	files (the "Software"), to deal	in the Software without
+	restriction, including without limitation the rights to use,
+	copy, modify, merge, publish, distribute, sublicense, and/or
+	sell copies of the Software, and to permit persons to whom the
+	Software is	furnished to do so, subject to the following
+	conditions:
+
+	The above copyright notice and this permission notice shall be
+	included in	all copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+	OF MERCHANTABILITY,	FITNESS FOR A PARTICULAR PURPOSE AND
+	NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+	OTHER DEALINGS IN THE SOFTWARE.
+
+	Developed by: Neil Kemp at Rendering Systems Inc.
+
+	Online:		http://shadermap.com
+	Corporate:	http://renderingsystems.com
+
+	===============================================================
+*/
+/*
+	===============================================================
+
+	ABOUT:
+
+	This project builds a geometry import plugin for ShaderMap 4.3.
+	The plugin loads Wavefront OBJ files and the face colors of
+	their MTL material libraries and sends them to ShaderMap in
+	one of two formats: render or node.
+
+	The file is mapped into memory and split into chunks of whole
+	lines that are parsed at the same time on all cores. Each
+	chunk keeps its own positions, uvs, normals and triangles.
+	Once every chunk is parsed the start of each chunk in the
+	merged lists is known, so the chunks are copied into the
+	lists ShaderMap wants at the same time too.
+
+	Faces are split into triangles as a fan. Relative (negative)
+	indices are supported.
+
+	Subsets: each material set by "usemtl" is a subset of the
+	RENDER geometry. For NODE geometry each group set by "g" or
+	"o" and material pair is a subset and the subsets of a group
+	are defined as one material id. A file without groups has a
+	material id for each material.
+
+	Faces are colored with the diffuse color (Kd) of their
+	material if the options ask for material colors from the file.
+
+	All geometry import plugins have the extension .smg and are
+	stored in the ShaderMap installation directory at:
+	"plugins\bin\geometry"
+
+	See "geometry\examples\geo_custom\geo_custom.cpp" to setup
+	your system for development. The steps are the same for this
+	project.
+
+	===============================================================
+*/
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Plugin includes
+
+#include "../../geo_plugin_core.cpp"
+#include "../../geo_file_map.cpp"
+#include "../../geo_mesh_build.cpp"
+#include "../../geo_text_parse.cpp"
+#include "../../../common/plugin_thread_pool.cpp"
+#include <math.h>
+#include <string.h>
+#include <map>
+#include <string>
+#include <vector>
+
+
+// ------------------------------------------------------------------
+// ------------------------------------------------------------------
+// Local defines
+
+// Bytes of the file parsed by one task, the least and most. Files are split into about 8 chunks per thread.
+#ifndef OBJ_MIN_CHUNK_SIZE
+#define OBJ_MIN_CHUNK_SIZE						(256 << 10)
+#endif
+#ifndef OBJ_MAX_CHUNK_SIZE
+#define OBJ_MAX_CHUNK_SIZE						(4 << 20)
+#endif
+
+// Marks a missing uv or normal index.
+#define OBJ_NONE								UINT_MAX
+
+
+// ------------------------------------------------------------------
+// ------------------------------------------------------------------
+// Local structs
+
+// A triangle of a chunk. Indices are zero based, or relative to the chunk lists if listed in relative_list of the chunk.
+// A relative index is a signed int and can be the same bits as OBJ_NONE until it is made absolute.
+struct obj_triangle_s
+{
+	unsigned int								v[3];					// Position indices
+	unsigned int								vt[3];					// UV indices, OBJ_NONE if missing
+	unsigned int								vn[3];					// Normal indices, OBJ_NONE if missing
+};
+
+// A change of group or material before a triangle of a chunk.
+struct obj_state_s
+{
+	unsigned int								triangle_start;			// First triangle of the chunk after the change
+	unsigned int								group;					// Index in name_list of the chunk, OBJ_NONE if unchanged
+	unsigned int								material;				// Index in name_list of the chunk, OBJ_NONE if unchanged
+};
+
+// Triangles of a chunk in one subset.
+struct obj_run_s
+{
+	unsigned int								triangle_start, triangle_end;
+	unsigned int								subset;
+	unsigned int								output_start;			// Index of the first triangle in the subset sorted face list
+};
+
+// A chunk of whole lines of the file and what was parsed from it.
+struct obj_chunk_s
+{
+	const char*									start;
+	const char*									end;
+
+	std::vector<float>							position_list;			// 3 floats per position
+	std::vector<float>							uv_list;				// 2 floats per uv
+	std::vector<float>							normal_list;			// 3 floats per normal
+	std::vector<obj_triangle_s>					triangle_list;
+	std::vector<unsigned int>					relative_list;			// triangle * 9 + slot of indices relative to the chunk lists
+	std::vector<obj_state_s>					state_list;
+	std::vector<std::string>					name_list;
+	std::vector<std::string>					mtllib_list;
+	BOOL										is_group;				// Has a "g" or "o" line
+	BOOL										is_missing_uv;			// Has a corner without a uv index
+
+	unsigned int								position_start, uv_start, normal_start;		// Start in the merged lists
+	std::vector<obj_run_s>						run_list;
+
+	const wchar_t*								error;
+
+	// c()
+	obj_chunk_s(void)
+	{	start = end = 0;
+		is_group = is_missing_uv = FALSE;
+		position_start = uv_start = normal_start = 0;
+		error = 0;
+	}
+};
+
+
+// ------------------------------------------------------------------
+// ------------------------------------------------------------------
+// Local functions used to parse the file
+
+// Parse count floats separated by spaces. The floats after the first required_count are 0 if not in the line.
+BOOL obj_parse_float_list(const char* pointer, const char* line_end, unsigned int required_count, unsigned int count, std::vector<float>& list_in_out)
+{
+	for(unsigned int i=0; i<count; i++)
+	{	geo_text_skip_space(pointer, line_end);
+		if(i >= required_count && pointer == line_end)
+		{	list_in_out.push_back(0.0f);
+			continue;
+		}
+		float value;
+		if(!geo_text_parse_float(pointer, line_end, value) || (pointer < line_end && !geo_text_is_space(*pointer)))
+		{	return FALSE;
+		}
+		list_in_out.push_back(value);
+	}
+	return TRUE;
+}
+
+// Parse an index of a face corner and make it zero based. Negative indices count back from local_count, the count
+// of the chunk list when the face is read, and are flagged with is_relative_out.
+inline BOOL obj_parse_index(const char*& pointer, const char* line_end, size_t local_count, unsigned int& index_out, BOOL& is_relative_out)
+{
+	// Local data
+	long long									index;
+	unsigned int								digit;
+	BOOL										is_negative;
+
+
+	is_negative = FALSE;
+	if(pointer < line_end && *pointer == '-')
+	{	is_negative = TRUE;
+		pointer++;
+	}
+	if(pointer >= line_end || (unsigned int)(*pointer - '0') >= 10)
+	{	return FALSE;
+	}
+	index = 0;
+	while(pointer < line_end && (digit = (unsigned int)(*pointer - '0')) < 10)
+	{	index = index * 10 + digit;
+		if(index > UINT_MAX)
+		{	return FALSE;
+		}
+		pointer++;
+	}
+
+	if(!index || (!is_negative && index == UINT_MAX))
+	{	return FALSE;
+	}
+	if(is_negative)
+	{	index = (long long)local_count - index;
+		if(index < INT_MIN)
+		{	return FALSE;
+		}
+		index_out		= (unsigned int)(int)index;
+		is_relative_out	= TRUE;
+	}
+	else
+	{	index_out		= (unsigned int)(index - 1);
+		is_relative_out	= FALSE;
+	}
+	return TRUE;
+}
+
+// Parse the corners of an "f" line and add them to the chunk as a fan of triangles.
+BOOL obj_parse_face(obj_chunk_s& chunk, const char* pointer, const char* line_end)
+{
+	// Local data
+	unsigned int								corner_array[3][3];		// First, previous and current corner - v, vt, vn
+	unsigned int								relative_array[3];		// Bit 0 v, bit 1 vt, bit 2 vn relative
+	unsigned int								corner_count, triangle_index, corner;
+	BOOL										is_relative;
+	obj_triangle_s								triangle;
+
+
+	corner_count = 0;
+	for(;;)
+	{	geo_text_skip_space(pointer, line_end);
+		if(pointer == line_end)
+		{	break;
+		}
+
+		// Corners are "v", "v/vt", "v//vn" or "v/vt/vn".
+		corner = corner_count < 2 ? corner_count : 2;
+		relative_array[corner] = 0;
+		if(!obj_parse_index(pointer, line_end, chunk.position_list.size() / 3, corner_array[corner][0], is_relative))
+		{	return FALSE;
+		}
+		relative_array[corner] |= is_relative ? 1 : 0;
+		corner_array[corner][1] = OBJ_NONE;
+		corner_array[corner][2] = OBJ_NONE;
+		if(pointer < line_end && *pointer == '/')
+		{	pointer++;
+			if(pointer < line_end && *pointer != '/')
+			{	if(!obj_parse_index(pointer, line_end, chunk.uv_list.size() / 2, corner_array[corner][1], is_relative))
+				{	return FALSE;
+				}
+				relative_array[corner] |= is_relative ? 2 : 0;
+			}
+			if(pointer < line_end && *pointer == '/')
+			{	pointer++;
+				if(!obj_parse_index(pointer, line_end, chunk.normal_list.size() / 3, corner_array[corner][2], is_relative))
+				{	return FALSE;
+				}
+				relative_array[corner] |= is_relative ? 4 : 0;
+			}
+		}
+		if(pointer < line_end && !geo_text_is_space(*pointer))
+		{	return FALSE;
+		}
+		if(corner_array[corner][1] == OBJ_NONE && !(relative_array[corner] & 2))
+		{	chunk.is_missing_uv = TRUE;
+		}
+		corner_count++;
+
+		// Add the triangle of the first, previous and current corner then make the current corner the previous.
+		if(corner_count >= 3)
+		{	triangle_index = (unsigned int)chunk.triangle_list.size();
+			for(unsigned int i=0; i<3; i++)
+			{	triangle.v[i]	= corner_array[i][0];
+				triangle.vt[i]	= corner_array[i][1];
+				triangle.vn[i]	= corner_array[i][2];
+				for(unsigned int j=0; j<3; j++)
+				{	if(relative_array[i] & (1 << j))
+					{	chunk.relative_list.push_back(triangle_index * 9 + j * 3 + i);
+					}
+				}
+			}
+			chunk.triangle_list.push_back(triangle);
+			memcpy(corner_array[1], corner_array[2], sizeof(corner_array[2]));
+			relative_array[1] = relative_array[2];
+		}
+	}
+	return corner_count >= 3;
+}
+
+// Parse the lines of a chunk. Returns FALSE and sets the error of the chunk on failure. Throws std::bad_alloc.
+BOOL obj_parse_chunk(obj_chunk_s& chunk)
+{
+	// Local data
+	const char*									pointer;
+	const char*									line_end;
+	const char*									keyword_end;
+	size_t										keyword_size;
+	obj_state_s									state;
+
+
+	for(pointer=chunk.start; pointer<chunk.end; pointer=line_end+1)
+	{	line_end = (const char*)memchr(pointer, '\n', chunk.end - pointer);
+		if(!line_end)
+		{	line_end = chunk.end;
+		}
+
+		geo_text_skip_space(pointer, line_end);
+		if(pointer == line_end || *pointer == '#')
+		{	continue;
+		}
+		keyword_end = pointer;
+		while(keyword_end < line_end && !geo_text_is_space(*keyword_end))
+		{	keyword_end++;
+		}
+		keyword_size = keyword_end - pointer;
+
+		// Vertex data
+		if(keyword_size == 1 && pointer[0] == 'v')
+		{	if(!obj_parse_float_list(keyword_end, line_end, 3, 3, chunk.position_list))
+			{	chunk.error = _T("A vertex position is not 3 numbers.");
+				return FALSE;
+			}
+		}
+		else if(keyword_size == 2 && pointer[0] == 'v' && pointer[1] == 't')
+		{	if(!obj_parse_float_list(keyword_end, line_end, 1, 2, chunk.uv_list))
+			{	chunk.error = _T("A texture coordinate is not a number.");
+				return FALSE;
+			}
+		}
+		else if(keyword_size == 2 && pointer[0] == 'v' && pointer[1] == 'n')
+		{	if(!obj_parse_float_list(keyword_end, line_end, 3, 3, chunk.normal_list))
+			{	chunk.error = _T("A vertex normal is not 3 numbers.");
+				return FALSE;
+			}
+		}
+
+		// Faces
+		else if(keyword_size == 1 && pointer[0] == 'f')
+		{	if(!obj_parse_face(chunk, keyword_end, line_end))
+			{	chunk.error = _T("A face has less than 3 corners or an invalid index.");
+				return FALSE;
+			}
+		}
+
+		// Groups and materials
+		else if((keyword_size == 1 && (pointer[0] == 'g' || pointer[0] == 'o')) || (keyword_size == 6 && !memcmp(pointer, "usemtl", 6)))
+		{	if(chunk.state_list.empty() || chunk.state_list.back().triangle_start != chunk.triangle_list.size())
+			{	state.triangle_start	= (unsigned int)chunk.triangle_list.size();
+				state.group				= OBJ_NONE;
+				state.material			= OBJ_NONE;
+				chunk.state_list.push_back(state);
+			}
+			if(keyword_size == 1)
+			{	chunk.state_list.back().group = (unsigned int)chunk.name_list.size();
+				chunk.is_group = TRUE;
+			}
+			else
+			{	chunk.state_list.back().material = (unsigned int)chunk.name_list.size();
+			}
+			chunk.name_list.push_back(geo_text_get_rest(keyword_end, line_end));
+		}
+		else if(keyword_size == 6 && !memcmp(pointer, "mtllib", 6))
+		{	chunk.mtllib_list.push_back(geo_text_get_rest(keyword_end, line_end));
+		}
+
+		// Smoothing groups, lines, points, curves and surfaces are not imported.
+	}
+	return TRUE;
+}
+
+// Parses chunks of the file.
+struct obj_parse_body_s
+{
+	obj_chunk_s*								chunk_array;
+
+	BOOL operator()(unsigned int chunk_start, unsigned int chunk_end) const
+	{	for(unsigned int i=chunk_start; i<chunk_end; i++)
+		{	try
+			{	if(!obj_parse_chunk(chunk_array[i]))
+				{	return FALSE;
+				}
+			}
+			catch(...)
+			{	chunk_array[i].error = _T("Memory Allocation Error: Failed to allocate the lists of a chunk.");
+				return FALSE;
+			}
+		}
+		return TRUE;
+	}
+};
+
+// Copies chunks into the merged lists. Relative indices are made absolute and every index is checked. If face_array is
+// not 0 the triangles are also written to it in subset order with their uv indices.
+struct obj_merge_body_s
+{
+	obj_chunk_s*								chunk_array;
+	unsigned int								position_count, uv_count, normal_count;
+	gp_node_vertex_s*							vertex_array;
+	gp_node_uv_s*								uv_array;
+	float*										normal_array;
+	gp_node_face_s*								face_array;
+	unsigned int*								uv_index_array;
+	unsigned int								missing_uv_index;		// UV index of corners without one
+	const unsigned int*							subset_color_array;
+
+	BOOL operator()(unsigned int chunk_start, unsigned int chunk_end) const
+	{	for(unsigned int i=chunk_start; i<chunk_end; i++)
+		{	obj_chunk_s& chunk = chunk_array[i];
+
+			for(size_t j=0; j<chunk.position_list.size(); j+=3)
+			{	vertex_array[chunk.position_start + j / 3] = gp_node_vertex_s(chunk.position_list[j], chunk.position_list[j+1], chunk.position_list[j+2], 0.0f, 0.0f, 0.0f);
+			}
+			for(size_t j=0; j<chunk.uv_list.size(); j+=2)
+			{	uv_array[chunk.uv_start + j / 2] = gp_node_uv_s(chunk.uv_list[j], chunk.uv_list[j+1]);
+			}
+			if(!chunk.normal_list.empty())
+			{	memcpy(normal_array + (size_t)chunk.normal_start * 3, chunk.normal_list.data(), chunk.normal_list.size() * sizeof(float));
+			}
+			std::vector<float>().swap(chunk.position_list);
+			std::vector<float>().swap(chunk.uv_list);
+			std::vector<float>().swap(chunk.normal_list);
+
+			// Relative indices count from the start of the chunk in the merged list and may point into earlier chunks.
+			for(size_t j=0; j<chunk.relative_list.size(); j++)
+			{	unsigned int	slot	= chunk.relative_list[j] % 9;
+				unsigned int&	index	= (&chunk.triangle_list[chunk.relative_list[j] / 9].v[0])[slot];
+				long long		start	= slot < 3 ? chunk.position_start : (slot < 6 ? chunk.uv_start : chunk.normal_start);
+				long long		value	= start + (int)index;
+				if(value < 0 || value >= UINT_MAX)
+				{	chunk.error = _T("A face index is out of range.");
+					return FALSE;
+				}
+				index = (unsigned int)value;
+			}
+			std::vector<unsigned int>().swap(chunk.relative_list);
+
+			for(size_t j=0; j<chunk.triangle_list.size(); j++)
+			{	const obj_triangle_s& triangle = chunk.triangle_list[j];
+				for(unsigned int k=0; k<3; k++)
+				{	if(triangle.v[k] >= position_count || (triangle.vt[k] != OBJ_NONE && triangle.vt[k] >= uv_count) ||
+					   (triangle.vn[k] != OBJ_NONE && triangle.vn[k] >= normal_count))
+					{	chunk.error = _T("A face index is out of range.");
+						return FALSE;
+					}
+				}
+			}
+
+			if(!face_array)
+			{	continue;
+			}
+			for(size_t j=0; j<chunk.run_list.size(); j++)
+			{	const obj_run_s& run = chunk.run_list[j];
+				for(unsigned int k=run.triangle_start; k<run.triangle_end; k++)
+				{	const obj_triangle_s&	triangle	= chunk.triangle_list[k];
+					unsigned int			output		= run.output_start + (k - run.triangle_start);
+					face_array[output] = gp_node_face_s(triangle.v[0], triangle.v[1], triangle.v[2], run.subset, subset_color_array[run.subset]);
+					if(uv_index_array)
+					{	for(unsigned int l=0; l<3; l++)
+						{	uv_index_array[(size_t)output * 3 + l] = triangle.vt[l] == OBJ_NONE ? missing_uv_index : triangle.vt[l];
+						}
+					}
+				}
+			}
+		}
+		return TRUE;
+	}
+};
+
+// Widen a file name read from the file. UTF-8 on Windows, the locale encoding elsewhere.
+std::wstring obj_widen(const std::string& name)
+{
+	// Local data
+	std::vector<wchar_t>						buffer(name.size() + 1);
+
+
+#ifdef _WIN32
+	if(!MultiByteToWideChar(CP_UTF8, 0, name.c_str(), -1, buffer.data(), (int)buffer.size()))
+	{	return std::wstring();
+	}
+#else
+	if(mbstowcs(buffer.data(), name.c_str(), buffer.size()) == (size_t)-1)
+	{	return std::wstring();
+	}
+	buffer.back() = 0;
+#endif
+	return std::wstring(buffer.data());
+}
+
+// Read the diffuse color (Kd) of each material of an MTL file into color_map_in_out. Materials already in the map are
+// kept. Returns FALSE if the file can not be opened. Throws std::bad_alloc.
+BOOL obj_load_mtl(const std::wstring& file_path, std::map<std::string, unsigned int>& color_map_in_out)
+{
+	// Local data
+	geo_file_map_s								file_map;
+	const char*									pointer;
+	const char*									end;
+	const char*									line_end;
+	std::string									material;
+	std::vector<float>							color_list;
+	BOOL										is_material;
+
+
+	if(!geo_file_map_open(file_path.c_str(), file_map))
+	{	return FALSE;
+	}
+
+	is_material	= FALSE;
+	pointer		= (const char*)file_map.data;
+	end			= pointer + file_map.size;
+	for(; pointer<end; pointer=line_end+1)
+	{	line_end = (const char*)memchr(pointer, '\n', end - pointer);
+		if(!line_end)
+		{	line_end = end;
+		}
+		geo_text_skip_space(pointer, line_end);
+		if(line_end - pointer > 7 && !memcmp(pointer, "newmtl", 6) && geo_text_is_space(pointer[6]))
+		{	material	= geo_text_get_rest(pointer + 6, line_end);
+			is_material	= color_map_in_out.find(material) == color_map_in_out.end();
+			if(is_material)
+			{	color_map_in_out[material] = gp_node_face_s().color;
+			}
+		}
+		else if(is_material && line_end - pointer > 3 && pointer[0] == 'K' && pointer[1] == 'd' && geo_text_is_space(pointer[2]))
+		{	color_list.clear();
+			if(obj_parse_float_list(pointer + 2, line_end, 3, 3, color_list))
+			{	unsigned int rgb_array[3];
+				for(unsigned int i=0; i<3; i++)
+				{	rgb_array[i] = (unsigned int)(std::min(std::max(color_list[i], 0.0f), 1.0f) * 255.0f + 0.5f);
+				}
+				color_map_in_out[material] = RGB(rgb_array[0], rgb_array[1], rgb_array[2]);
+			}
+		}
+	}
+
+	geo_file_map_close(file_map);
+	return TRUE;
+}
+
+
+// ------------------------------------------------------------------
+// ------------------------------------------------------------------
+// Local functions called during init, process, and shutdown
+
+// Initialize plugin - called when plugin is attached to ShaderMap.
+BOOL on_initialize(void)
+{
+	// Local data
+	const wchar_t*	ext_array[] = {_T("obj")};
+
+
+	// Tell ShaderMap we are starting initialization.
+	gp_begin_initialize();
+
+		// Set file format name and extension list.
+#ifdef _DEBUG
+		gp_set_file_info(_T("Wavefront OBJ - DEBUG"), ext_array, 1);
+#else
+		gp_set_file_info(_T("Wavefront OBJ"), ext_array, 1);
+#endif
+
+	// Tell ShaderMap initialization is done.
+	gp_end_initialize();
+
+	return TRUE;
+}
+
+// Process plugin - called when plugin is asked by ShaderMap to import a 3D Model (geometry).
+BOOL on_process(unsigned int plugin_index, const wchar_t* file_path)
+{
+	// Local data
+	geo_file_map_s								file_map;
+	unsigned int								i, j, geometry_type, chunk_count, group, material, subset;
+	unsigned int								uv_channel_count;
+	unsigned long long							chunk_size, chunk_end, position_count, uv_count, normal_count, triangle_count;
+	const char*									line_end;
+	BOOL										is_success, is_group, is_missing_uv;
+	std::vector<obj_chunk_s>					chunk_list;
+	obj_parse_body_s							parse_body;
+	obj_merge_body_s							merge_body;
+	obj_run_s									run;
+	const wchar_t*								error;
+
+	std::map<std::string, unsigned int>			group_map, material_map, color_map;
+	std::map<unsigned long long, unsigned int>	subset_map;
+	std::vector<std::string>					material_name_list;
+	std::vector<unsigned int>					subset_group_list, subset_material_list, subset_start_list, subset_color_list;
+	std::vector<unsigned int>					material_subset_list;
+	std::wstring								directory;
+
+	std::vector<gp_node_vertex_s>				vertex_list;
+	std::vector<gp_node_uv_s>					uv_list;
+	std::vector<float>							normal_list;
+	std::vector<gp_node_face_s>					face_list;
+	std::vector<unsigned int>					uv_index_list;
+	gp_node_uv_s*								node_uv_channel_array[1];
+	unsigned int*								node_uv_index_array[1];
+	unsigned int								node_uv_count_array[1];
+	gp_node_uv_data_s							node_uv_data;
+
+	gp_render_vertex_s							render_vertex;
+	unsigned int								corner_array[3];
+	geo_mesh_s									render_mesh;
+
+
+	// Get geometry type. This can be of type render or of type node.
+	geometry_type = gp_get_geometry_type();
+
+	// Set return value
+	is_success = TRUE;
+
+	// Map the file into memory. See "geo_file_map.cpp".
+	if(!geo_file_map_open(file_path, file_map))
+	{	LOG_ERROR_MSG(plugin_index, _T("Failed to open file at file_path."));
+		return FALSE;
+	}
+	if(!file_map.size)
+	{	LOG_ERROR_MSG(plugin_index, _T("The file is empty."));
+		is_success = FALSE;
+		goto ON_PROCESS_CLEANUP;
+	}
+
+	// -----------------
+
+	// Split the file into chunks that end after a new line and parse them on all cores.
+	chunk_size = file_map.size / (parallel_get_thread_limit() * 8ull);
+	chunk_size = std::min<unsigned long long>(std::max<unsigned long long>(chunk_size, OBJ_MIN_CHUNK_SIZE), OBJ_MAX_CHUNK_SIZE);
+	try
+	{	chunk_list.reserve((size_t)(file_map.size / chunk_size + 1));
+		for(unsigned long long chunk_start=0; chunk_start<file_map.size; chunk_start=chunk_end)
+		{	chunk_end = chunk_start + chunk_size;
+			if(chunk_end >= file_map.size)
+			{	chunk_end = file_map.size;
+			}
+			else
+			{	line_end	= (const char*)memchr(file_map.data + chunk_end, '\n', (size_t)(file_map.size - chunk_end));
+				chunk_end	= line_end ? (unsigned long long)((const unsigned char*)line_end - file_map.data) + 1 : file_map.size;
+			}
+			chunk_list.push_back(obj_chunk_s());
+			chunk_list.back().start	= (const char*)file_map.data + chunk_start;
+			chunk_list.back().end	= (const char*)file_map.data + chunk_end;
+		}
+	}
+	catch(...)
+	{	LOG_ERROR_MSG(plugin_index, _T("Memory Allocation Error: Failed to allocate the chunk list."));
+		is_success = FALSE;
+		goto ON_PROCESS_CLEANUP;
+	}
+	chunk_count = (unsigned int)chunk_list.size();
+
+	parse_body.chunk_array = chunk_list.data();
+	if(!parallel_for(chunk_count, 1, parse_body, parallel_progress_s()))
+	{	error = _T("Failed to parse the file.");
+		for(i=0; i<chunk_count; i++)
+		{	if(chunk_list[i].error)
+			{	error = chunk_list[i].error;
+				break;
+			}
+		}
+		LOG_ERROR_MSG(plugin_index, error);
+		is_success = FALSE;
+		goto ON_PROCESS_CLEANUP;
+	}
+
+	// -----------------
+
+	// Find where each chunk starts in the merged lists.
+	position_count = uv_count = normal_count = triangle_count = 0;
+	is_group = is_missing_uv = FALSE;
+	for(i=0; i<chunk_count; i++)
+	{	chunk_list[i].position_start	= (unsigned int)position_count;
+		chunk_list[i].uv_start			= (unsigned int)uv_count;
+		chunk_list[i].normal_start		= (unsigned int)normal_count;
+		position_count					+= chunk_list[i].position_list.size() / 3;
+		uv_count						+= chunk_list[i].uv_list.size() / 2;
+		normal_count					+= chunk_list[i].normal_list.size() / 3;
+		triangle_count					+= chunk_list[i].triangle_list.size();
+		is_group						|= chunk_list[i].is_group;
+		is_missing_uv					|= chunk_list[i].is_missing_uv;
+	}
+	if(position_count >= UINT_MAX || uv_count >= UINT_MAX - 1 || normal_count >= UINT_MAX || triangle_count >= UINT_MAX)
+	{	LOG_ERROR_MSG(plugin_index, _T("The file has too many vertices or faces."));
+		is_success = FALSE;
+		goto ON_PROCESS_CLEANUP;
+	}
+	if(!triangle_count)
+	{	LOG_ERROR_MSG(plugin_index, _T("The file has no faces."));
+		is_success = FALSE;
+		goto ON_PROCESS_CLEANUP;
+	}
+
+	// Split the triangles of each chunk into runs of one subset. RENDER subsets are materials, NODE subsets are group
+	// and material pairs. Subsets are numbered in the order they are first used. Group and material 0 are none.
+	try
+	{	group_map[std::string()]		= 0;
+		material_map[std::string()]		= 0;
+		material_name_list.push_back(std::string());
+		group		= 0;
+		material	= 0;
+		for(i=0; i<chunk_count; i++)
+		{	obj_chunk_s& chunk = chunk_list[i];
+			run.triangle_start = 0;
+			for(j=0; j<=chunk.state_list.size(); j++)
+			{	run.triangle_end = j < chunk.state_list.size() ? chunk.state_list[j].triangle_start : (unsigned int)chunk.triangle_list.size();
+				if(run.triangle_end > run.triangle_start)
+				{	unsigned long long key = geometry_type == GP_GEOMETRY_TYPE_NODE ? ((unsigned long long)group << 32 | material) : material;
+					std::map<unsigned long long, unsigned int>::iterator subset_iterator = subset_map.find(key);
+					if(subset_iterator == subset_map.end())
+					{	subset_iterator = subset_map.insert(std::make_pair(key, (unsigned int)subset_group_list.size())).first;
+						subset_group_list.push_back(group);
+						subset_material_list.push_back(material);
+						subset_start_list.push_back(0);
+					}
+					run.subset = subset_iterator->second;
+					subset_start_list[run.subset] += run.triangle_end - run.triangle_start;
+					chunk.run_list.push_back(run);
+				}
+				if(j == chunk.state_list.size())
+				{	break;
+				}
+
+				const obj_state_s& state = chunk.state_list[j];
+				if(state.group != OBJ_NONE)
+				{	group = group_map.insert(std::make_pair(chunk.name_list[state.group], (unsigned int)group_map.size())).first->second;
+				}
+				if(state.material != OBJ_NONE)
+				{	std::pair<std::map<std::string, unsigned int>::iterator, bool> result = material_map.insert(std::make_pair(chunk.name_list[state.material], (unsigned int)material_map.size()));
+					if(result.second)
+					{	material_name_list.push_back(result.first->first);
+					}
+					material = result.first->second;
+				}
+				run.triangle_start = run.triangle_end;
+			}
+		}
+
+		// Place the runs of each subset one after another in chunk order so the sort by subset is stable.
+		triangle_count = 0;
+		for(i=0; i<subset_start_list.size(); i++)
+		{	subset = subset_start_list[i];
+			subset_start_list[i] = (unsigned int)triangle_count;
+			triangle_count += subset;
+		}
+		for(i=0; i<chunk_count; i++)
+		{	for(j=0; j<chunk_list[i].run_list.size(); j++)
+			{	obj_run_s& chunk_run = chunk_list[i].run_list[j];
+				chunk_run.output_start = subset_start_list[chunk_run.subset];
+				subset_start_list[chunk_run.subset] += chunk_run.triangle_end - chunk_run.triangle_start;
+			}
+		}
+
+		// Read the colors of the materials from the MTL files if the options ask for them. A missing MTL file is not
+		// an error, the faces are then the default color.
+		subset_color_list.assign(subset_material_list.size(), gp_node_face_s().color);
+		if(geometry_type == GP_GEOMETRY_TYPE_NODE && gp_is_option_material_color_from_file())
+		{	directory = file_path;
+			directory.resize(directory.find_last_of(_T("/\\")) == std::wstring::npos ? 0 : directory.find_last_of(_T("/\\")) + 1);
+			for(i=0; i<chunk_count; i++)
+			{	for(j=0; j<chunk_list[i].mtllib_list.size(); j++)
+				{	obj_load_mtl(directory + obj_widen(chunk_list[i].mtllib_list[j]), color_map);
+				}
+			}
+			for(i=0; i<subset_material_list.size(); i++)
+			{	std::map<std::string, unsigned int>::const_iterator color_iterator = color_map.find(material_name_list[subset_material_list[i]]);
+				if(color_iterator != color_map.end())
+				{	subset_color_list[i] = color_iterator->second;
+				}
+			}
+		}
+
+		// Allocate the merged lists. Corners without a uv use an added uv at 0, 0 if other corners have uvs.
+		vertex_list.resize((size_t)position_count);
+		uv_list.resize((size_t)uv_count + (uv_count && is_missing_uv ? 1 : 0));
+		normal_list.resize((size_t)normal_count * 3);
+		if(geometry_type == GP_GEOMETRY_TYPE_NODE)
+		{	face_list.resize((size_t)triangle_count);
+			if(uv_count)
+			{	uv_index_list.resize((size_t)triangle_count * 3);
+			}
+		}
+	}
+	catch(...)
+	{	LOG_ERROR_MSG(plugin_index, _T("Memory Allocation Error: Failed to allocate the geometry lists."));
+		is_success = FALSE;
+		goto ON_PROCESS_CLEANUP;
+	}
+
+	// Merge the chunks on all cores.
+	merge_body.chunk_array			= chunk_list.data();
+	merge_body.position_count		= (unsigned int)position_count;
+	merge_body.uv_count				= (unsigned int)uv_count;
+	merge_body.normal_count			= (unsigned int)normal_count;
+	merge_body.vertex_array			= vertex_list.data();
+	merge_body.uv_array				= uv_list.data();
+	merge_body.normal_array			= normal_list.data();
+	merge_body.face_array			= face_list.empty() ? 0 : face_list.data();
+	merge_body.uv_index_array		= uv_index_list.empty() ? 0 : uv_index_list.data();
+	merge_body.missing_uv_index		= (unsigned int)uv_count;
+	merge_body.subset_color_array	= subset_color_list.data();
+	if(!parallel_for(chunk_count, 1, merge_body, parallel_progress_s()))
+	{	error = _T("Failed to merge the file.");
+		for(i=0; i<chunk_count; i++)
+		{	if(chunk_list[i].error)
+			{	error = chunk_list[i].error;
+				break;
+			}
+		}
+		LOG_ERROR_MSG(plugin_index, error);
+		is_success = FALSE;
+		goto ON_PROCESS_CLEANUP;
+	}
+
+	if(!uv_count)
+	{	gp_flag_no_uv_geometry();
+	}
+
+	// -----------------
+
+	// GP_GEOMETRY_TYPE_RENDER
+	// This format for geometry is used for 3d models in the material visualizer.
+	if(geometry_type == GP_GEOMETRY_TYPE_RENDER)
+	{
+		// Corners with the same position, normal and uv share one render vertex. See "geo_mesh_build.cpp".
+		if(!geo_mesh_reserve(render_mesh, (unsigned int)triangle_count))
+		{	LOG_ERROR_MSG(plugin_index, _T("Memory Allocation Error: Failed to allocate the render geometry lists."));
+			is_success = FALSE;
+			goto ON_PROCESS_CLEANUP;
+		}
+		try
+		{	for(i=0; i<chunk_count; i++)
+			{	for(j=0; j<chunk_list[i].run_list.size(); j++)
+				{	const obj_run_s& chunk_run = chunk_list[i].run_list[j];
+					for(unsigned int k=chunk_run.triangle_start; k<chunk_run.triangle_end; k++)
+					{	const obj_triangle_s& triangle = chunk_list[i].triangle_list[k];
+						for(unsigned int l=0; l<3; l++)
+						{	const gp_node_vertex_s& vertex = vertex_list[triangle.v[l]];
+							render_vertex.x		= vertex.x;
+							render_vertex.y		= vertex.y;
+							render_vertex.z		= vertex.z;
+							render_vertex.nx	= triangle.vn[l] != OBJ_NONE ? normal_list[(size_t)triangle.vn[l] * 3] : 0.0f;
+							render_vertex.ny	= triangle.vn[l] != OBJ_NONE ? normal_list[(size_t)triangle.vn[l] * 3 + 1] : 0.0f;
+							render_vertex.nz	= triangle.vn[l] != OBJ_NONE ? normal_list[(size_t)triangle.vn[l] * 3 + 2] : 0.0f;
+							render_vertex.u		= triangle.vt[l] != OBJ_NONE ? uv_list[triangle.vt[l]].u : 0.0f;
+							render_vertex.v		= triangle.vt[l] != OBJ_NONE ? -uv_list[triangle.vt[l]].v : 0.0f;
+							corner_array[l]		= geo_mesh_add_vertex(render_mesh, render_vertex);
+						}
+						geo_mesh_add_face(render_mesh, corner_array[0], corner_array[1], corner_array[2], chunk_run.subset);
+					}
+				}
+				std::vector<obj_triangle_s>().swap(chunk_list[i].triangle_list);
+			}
+		}
+		catch(...)
+		{	LOG_ERROR_MSG(plugin_index, _T("Memory Allocation Error: Failed to allocate the render geometry lists."));
+			is_success = FALSE;
+			goto ON_PROCESS_CLEANUP;
+		}
+		std::vector<obj_chunk_s>().swap(chunk_list);
+
+		if(!geo_mesh_optimize(render_mesh))
+		{	LOG_ERROR_MSG(plugin_index, _T("Memory Allocation Error: Failed to optimize the render geometry."));
+			is_success = FALSE;
+			goto ON_PROCESS_CLEANUP;
+		}
+
+		// Send the render lists to ShaderMap. Normals are created if the file has none.
+		if(!gp_create_render_geometry(render_mesh.vertex_list.data(), (unsigned int)render_mesh.vertex_list.size(), render_mesh.face_list.data(), (unsigned int)render_mesh.face_list.size(),
+									  (unsigned int)subset_group_list.size(), normal_count == 0, 0, 0))
+		{	LOG_ERROR_MSG(plugin_index, _T("Failed to create render geometry with gp_create_render_geometry."));
+			is_success = FALSE;
+			goto ON_PROCESS_CLEANUP;
+		}
+	}
+	// GP_GEOMETRY_TYPE_NODE
+	// This format for geometry is used for 3d model nodes in the project grid.
+	else if(geometry_type == GP_GEOMETRY_TYPE_NODE)
+	{
+		// A node vertex has one normal. Average the normals of the corners that use the vertex.
+		if(normal_count)
+		{	for(i=0; i<chunk_count; i++)
+			{	for(size_t k=0; k<chunk_list[i].triangle_list.size(); k++)
+				{	const obj_triangle_s& triangle = chunk_list[i].triangle_list[k];
+					for(unsigned int l=0; l<3; l++)
+					{	if(triangle.vn[l] != OBJ_NONE)
+						{	gp_node_vertex_s& vertex = vertex_list[triangle.v[l]];
+							vertex.nx += normal_list[(size_t)triangle.vn[l] * 3];
+							vertex.ny += normal_list[(size_t)triangle.vn[l] * 3 + 1];
+							vertex.nz += normal_list[(size_t)triangle.vn[l] * 3 + 2];
+						}
+					}
+				}
+				std::vector<obj_triangle_s>().swap(chunk_list[i].triangle_list);
+			}
+			for(i=0; i<vertex_list.size(); i++)
+			{	gp_node_vertex_s& vertex = vertex_list[i];
+				float length = sqrtf(vertex.nx * vertex.nx + vertex.ny * vertex.ny + vertex.nz * vertex.nz);
+				if(length > 0.0f)
+				{	vertex.nx /= length;
+					vertex.ny /= length;
+					vertex.nz /= length;
+				}
+			}
+		}
+		std::vector<obj_chunk_s>().swap(chunk_list);
+		std::vector<float>().swap(normal_list);
+
+		// Define a material id for the subsets of each group, or for each subset if the file has no groups.
+		try
+		{	for(group=0; group<(is_group ? group_map.size() : subset_group_list.size()); group++)
+			{	material_subset_list.clear();
+				for(subset=0; subset<subset_group_list.size(); subset++)
+				{	if(is_group ? subset_group_list[subset] == group : subset == group)
+					{	material_subset_list.push_back(subset);
+					}
+				}
+				if(!material_subset_list.empty())
+				{	gp_define_node_material_id((unsigned int)material_subset_list.size(), material_subset_list.data());
+				}
+			}
+		}
+		catch(...)
+		{	LOG_ERROR_MSG(plugin_index, _T("Memory Allocation Error: Failed to allocate the node material lists."));
+			is_success = FALSE;
+			goto ON_PROCESS_CLEANUP;
+		}
+
+		// Create the node uv data struct. There is 1 uv channel if the file has uvs.
+		uv_channel_count = 0;
+		if(uv_count)
+		{	node_uv_channel_array[0]	= uv_list.data();
+			node_uv_index_array[0]		= uv_index_list.data();
+			node_uv_count_array[0]		= (unsigned int)uv_list.size();
+			uv_channel_count			= 1;
+		}
+		node_uv_data.uv_channel_count	= uv_channel_count;
+		node_uv_data.uv_channels_array	= node_uv_channel_array;
+		node_uv_data.uv_indices_array	= node_uv_index_array;
+		node_uv_data.uv_count_array		= node_uv_count_array;
+
+		// Send the node lists to ShaderMap. Normals are created if the file has none.
+		if(!gp_create_node_geometry(vertex_list.data(), (unsigned int)vertex_list.size(), face_list.data(), (unsigned int)face_list.size(), &node_uv_data,
+									(unsigned int)subset_group_list.size(), normal_count == 0))
+		{	LOG_ERROR_MSG(plugin_index, _T("Failed to create node geometry with gp_create_node_geometry."));
+			is_success = FALSE;
+			goto ON_PROCESS_CLEANUP;
+		}
+	}
+
+ON_PROCESS_CLEANUP:
+
+	// Unmap the file.
+	geo_file_map_close(file_map);
+
+	return is_success;
+}
+
+// Free any local plugin resources allocated - called by ShaderMap before detaching from the plugin.
+BOOL on_shutdown(void)
+{
+	// Stop the threads that parse the files.
+	parallel_shutdown();
+
+	return TRUE;
+}
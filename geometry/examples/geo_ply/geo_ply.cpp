@@ -0,0 +1,1216 @@
+/*
+	===============================================================
+
+	SHADERMAP SDK LICENSE
+
+	The ShaderMap SDK is released under The MIT License (MIT)
+	http://opensource.org/licenses/MIT
+
+	Copyright (c) 2007-2019 Rendering Systems Inc.
+
+	Permission is hereby granted, free of charge, to any person
+	obtaining a copy of this software and associated documentation
+	files (the "Software"), to deal	in the Software without
+	restriction, including without limitation the rights to use,
+	copy, modify, merge, publish, distribute, sublicense, and/or
+	sell copies of the Software, and to permit persons to whom the
+	Software is	furnished to do so, subject to the following
+	conditions:
+
+	The above copyright notice and this permission notice shall be
+	included in	all copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+	OF MERCHANTABILITY,	FITNESS FOR A PARTICULAR PURPOSE AND
+	NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+	OTHER DEALINGS IN THE SOFTWARE.
+
+	Developed by: Neil Kemp at Rendering Systems Inc.
+
+	Online:		http://shadermap.com
+	Corporate:	http://renderingsystems.com
+
+	===============================================================
+*/
+/*
+	===============================================================
+
+	ABOUT:
+
+	This project builds a geometry import plugin for ShaderMap 4.3.
+	The plugin loads binary and ASCII PLY files, such as the
+	output of photogrammetry and 3D scanners, and sends them to
+	ShaderMap in one of two formats: render or node.
+
+	The file is mapped into memory. The vertex records of a binary
+	file have a fixed size and are read straight into the node
+	vertex list on all cores. The face records are read the same
+	way if each face is a triangle, which is checked on all cores
+	first. Files with other polygons and ASCII files are read one
+	record at a time and polygons are split into fans of
+	triangles. Elements other than vertex and face are skipped.
+
+	Vertex properties read:
+		x y z				Position
+		nx ny nz			Normal
+		u v, s t,
+		texture_u texture_v	UV
+		red green blue		Color, 0 - 255 or 0.0 - 1.0
+
+	Face properties read:
+		vertex_indices		List of vertex indices
+		texcoord			List of 2 uv values per corner
+		red green blue		Color
+		texnumber			Texture of the face, its subset
+
+	If the file has no normals smooth normals are made from the
+	faces on all cores (see "geo_node_normals.cpp"). The face
+	color is the face color of the file or the average of its
+	vertex colors, and is used if the options ask for material
+	colors from the file. Each texnumber is a subset and a
+	material id.
+
+	All geometry import plugins have the extension .smg and are
+	stored in the ShaderMap installation directory at:
+	"plugins\bin\geometry"
+
+	See "geometry\examples\geo_custom\geo_custom.cpp" to setup
+	your system for development. The steps are the same for this
+	project.
+
+	===============================================================
+*/
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Plugin includes
+
+#include "../../geo_plugin_core.cpp"
+#include "../../geo_file_map.cpp"
+#include "../../geo_mesh_build.cpp"
+#include "../../geo_subset_sort.cpp"
+#include "../../geo_text_parse.cpp"
+#include "../../geo_node_normals.cpp"
+#include <math.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+
+// ------------------------------------------------------------------
+// ------------------------------------------------------------------
+// Local defines
+
+// Property types
+#define PLY_TYPE_NONE							0
+#define PLY_TYPE_INT8							1
+#define PLY_TYPE_UINT8							2
+#define PLY_TYPE_INT16							3
+#define PLY_TYPE_UINT16							4
+#define PLY_TYPE_INT32							5
+#define PLY_TYPE_UINT32							6
+#define PLY_TYPE_FLOAT32						7
+#define PLY_TYPE_FLOAT64						8
+
+// File formats
+#define PLY_FORMAT_ASCII						0
+#define PLY_FORMAT_BINARY_LITTLE_ENDIAN			1
+#define PLY_FORMAT_BINARY_BIG_ENDIAN			2
+
+// Vertex fields
+#define PLY_VERTEX_X							0
+#define PLY_VERTEX_Y							1
+#define PLY_VERTEX_Z							2
+#define PLY_VERTEX_NX							3
+#define PLY_VERTEX_NY							4
+#define PLY_VERTEX_NZ							5
+#define PLY_VERTEX_U							6
+#define PLY_VERTEX_V							7
+#define PLY_VERTEX_RED							8
+#define PLY_VERTEX_GREEN						9
+#define PLY_VERTEX_BLUE							10
+#define PLY_VERTEX_FIELD_COUNT					11
+
+// Face fields. The lists of vertex indices and texcoords are read separately.
+#define PLY_FACE_RED							0
+#define PLY_FACE_GREEN							1
+#define PLY_FACE_BLUE							2
+#define PLY_FACE_TEXNUMBER						3
+#define PLY_FACE_FIELD_COUNT					4
+
+// A property that is not in the file.
+#define PLY_NONE								UINT_MAX
+
+// Largest texnumber + 1, the most subsets a file can have.
+#define PLY_MAX_SUBSET_COUNT					1024
+
+// Records in each chunk given to a thread.
+#define PLY_CHUNK_SIZE							16384
+
+
+// ------------------------------------------------------------------
+// ------------------------------------------------------------------
+// Local structs
+
+// A property of an element.
+struct ply_property_s
+{
+	std::string									name;
+	unsigned int								type;					// Type of the value or of the list items
+	unsigned int								count_type;				// Type of the list count, PLY_TYPE_NONE if not a list
+};
+
+// An element of the header and its properties.
+struct ply_element_s
+{
+	std::string									name;
+	unsigned int								count;
+	std::vector<ply_property_s>					property_list;
+};
+
+// Where the vertex fields are in a vertex record.
+struct ply_vertex_layout_s
+{
+	unsigned int								property_array[PLY_VERTEX_FIELD_COUNT];		// Property index of each field or PLY_NONE
+	unsigned int								offset_array[PLY_VERTEX_FIELD_COUNT];		// Offset in a binary record
+	unsigned int								type_array[PLY_VERTEX_FIELD_COUNT];
+	unsigned int								record_size;			// Size of a binary record, 0 if the records have lists
+	BOOL										is_normal, is_uv, is_color;
+};
+
+// Where the face fields are in a face record.
+struct ply_face_layout_s
+{
+	unsigned int								index_property;			// Property index of the vertex index list
+	unsigned int								uv_property;			// Property index of the texcoord list or PLY_NONE
+	unsigned int								property_array[PLY_FACE_FIELD_COUNT];		// Property index of each field or PLY_NONE
+	unsigned int								type_array[PLY_FACE_FIELD_COUNT];
+	BOOL										is_color;
+
+	// Binary records of triangles with a list of 3 vertex indices and a list of 6 texcoords have a fixed size.
+	unsigned int								record_size;			// 0 if the records can not have a fixed size
+	unsigned int								index_offset, uv_offset;					// Offsets of the list counts
+	unsigned int								index_count_type, index_type, uv_count_type, uv_type;
+	unsigned int								offset_array[PLY_FACE_FIELD_COUNT];
+};
+
+// Reads the fixed size binary vertex records of a range of vertices.
+struct ply_vertex_body_s
+{
+	const unsigned char*						record_array;
+	const ply_vertex_layout_s*					layout;
+	BOOL										is_swap;
+	gp_node_vertex_s*							vertex_array;
+	gp_node_uv_s*								uv_array;				// Can be 0
+	unsigned int*								color_array;			// Can be 0
+
+	BOOL operator()(unsigned int vertex_start, unsigned int vertex_end) const;
+};
+
+// Checks the list counts of the fixed size binary face records of a range of faces.
+struct ply_face_check_body_s
+{
+	const unsigned char*						record_array;
+	const ply_face_layout_s*					layout;
+	BOOL										is_swap;
+
+	BOOL operator()(unsigned int face_start, unsigned int face_end) const;
+};
+
+// Reads the fixed size binary face records of a range of faces.
+struct ply_face_body_s
+{
+	const unsigned char*						record_array;
+	const ply_face_layout_s*					layout;
+	BOOL										is_swap;
+	unsigned int								vertex_count;
+	const unsigned int*							vertex_color_array;		// Can be 0
+	gp_node_face_s*								face_array;
+	gp_node_uv_s*								uv_array;				// 3 per face, can be 0
+
+	BOOL operator()(unsigned int face_start, unsigned int face_end) const;
+};
+
+
+// ------------------------------------------------------------------
+// ------------------------------------------------------------------
+// Local functions called during process
+
+// Return the size of a value of type.
+inline unsigned int ply_get_type_size(unsigned int type)
+{
+	static const unsigned int size_array[] = { 0, 1, 1, 2, 2, 4, 4, 4, 8 };
+
+	return size_array[type];
+}
+
+// Return the type with name or PLY_TYPE_NONE.
+unsigned int ply_get_type(const std::string& name)
+{
+	// Local data
+	static const char* const					name_array[] = { "", "char", "uchar", "short", "ushort", "int", "uint", "float", "double" };
+	static const char* const					alias_array[] = { "", "int8", "uint8", "int16", "uint16", "int32", "uint32", "float32", "float64" };
+
+
+	for(unsigned int i=PLY_TYPE_INT8; i<=PLY_TYPE_FLOAT64; i++)
+	{	if(name == name_array[i] || name == alias_array[i])
+		{	return i;
+		}
+	}
+	return PLY_TYPE_NONE;
+}
+
+// Return the value of type at pointer. The bytes are reversed if is_swap.
+inline double ply_get_value(const unsigned char* pointer, unsigned int type, BOOL is_swap)
+{
+	// Local data
+	unsigned char								bytes[8];
+	unsigned int								size;
+
+
+	size = ply_get_type_size(type);
+	if(is_swap)
+	{	for(unsigned int i=0; i<size; i++)
+		{	bytes[i] = pointer[size - 1 - i];
+		}
+	}
+	else
+	{	memcpy(bytes, pointer, size);
+	}
+
+	switch(type)
+	{	case PLY_TYPE_INT8:		{ signed char value;	memcpy(&value, bytes, 1); return value; }
+		case PLY_TYPE_UINT8:	{ return bytes[0]; }
+		case PLY_TYPE_INT16:	{ short value;			memcpy(&value, bytes, 2); return value; }
+		case PLY_TYPE_UINT16:	{ unsigned short value;	memcpy(&value, bytes, 2); return value; }
+		case PLY_TYPE_INT32:	{ int value;			memcpy(&value, bytes, 4); return value; }
+		case PLY_TYPE_UINT32:	{ unsigned int value;	memcpy(&value, bytes, 4); return value; }
+		case PLY_TYPE_FLOAT32:	{ float value;			memcpy(&value, bytes, 4); return value; }
+		default:				{ double value;			memcpy(&value, bytes, 8); return value; }
+	}
+}
+
+// Read a value of type at pointer and move pointer past it. Returns FALSE if there is no value before end.
+inline BOOL ply_read_value(const unsigned char*& pointer, const unsigned char* end, unsigned int type, unsigned int format, double& value_out)
+{
+	// Local data
+	const char*									text;
+
+
+	// ASCII values are separated by spaces and new lines.
+	if(format == PLY_FORMAT_ASCII)
+	{	text = (const char*)pointer;
+		while(text < (const char*)end && (geo_text_is_space(*text) || *text == '\n'))
+		{	text++;
+		}
+		if(!geo_text_parse_double(text, (const char*)end, value_out))
+		{	return FALSE;
+		}
+		pointer = (const unsigned char*)text;
+		return TRUE;
+	}
+
+	if((size_t)(end - pointer) < ply_get_type_size(type))
+	{	return FALSE;
+	}
+	value_out	= ply_get_value(pointer, type, format == PLY_FORMAT_BINARY_BIG_ENDIAN);
+	pointer		+= ply_get_type_size(type);
+	return TRUE;
+}
+
+// Read a record of element at pointer and move pointer past it. value_array gets the value of each property that is not
+// a list, list_array the items of each list. Returns FALSE if the record is cut off or a list count is not valid.
+BOOL ply_read_record(const unsigned char*& pointer, const unsigned char* end, const ply_element_s& element, unsigned int format, double* value_array, std::vector<double>* list_array)
+{
+	// Local data
+	double										count;
+
+
+	for(size_t i=0; i<element.property_list.size(); i++)
+	{	const ply_property_s& property = element.property_list[i];
+		if(property.count_type == PLY_TYPE_NONE)
+		{	if(!ply_read_value(pointer, end, property.type, format, value_array[i]))
+			{	return FALSE;
+			}
+		}
+		else
+		{	// Each item takes at least 1 byte, a larger count is not valid.
+			if(!ply_read_value(pointer, end, property.count_type, format, count) || !(count >= 0.0 && count <= (double)(end - pointer)) || count != floor(count))
+			{	return FALSE;
+			}
+			list_array[i].resize((size_t)count);
+			for(size_t j=0; j<list_array[i].size(); j++)
+			{	if(!ply_read_value(pointer, end, property.type, format, list_array[i][j]))
+				{	return FALSE;
+				}
+			}
+		}
+	}
+	return TRUE;
+}
+
+// Return the 0 - 255 value of a color channel. Float channels are 0.0 - 1.0.
+inline unsigned int ply_get_color_channel(double value, unsigned int type)
+{
+	if(type == PLY_TYPE_FLOAT32 || type == PLY_TYPE_FLOAT64)
+	{	value *= 255.0;
+	}
+	return value > 0.0 ? (value < 255.0 ? (unsigned int)(value + 0.5) : 255) : 0;
+}
+
+// Return TRUE if value is a finite float.
+inline BOOL ply_is_float(double value)
+{
+	return fabs(value) <= 3.4028234663852886e38;
+}
+
+// Set a vertex from the values of its fields. Returns FALSE if a value is not a finite float.
+inline BOOL ply_set_vertex(const ply_vertex_layout_s& layout, const double* value_array, unsigned int index, gp_node_vertex_s* vertex_array, gp_node_uv_s* uv_array, unsigned int* color_array)
+{
+	for(unsigned int i=PLY_VERTEX_X; i<=PLY_VERTEX_V; i++)
+	{	if(!ply_is_float(value_array[i]))
+		{	return FALSE;
+		}
+	}
+	vertex_array[index] = gp_node_vertex_s((float)value_array[PLY_VERTEX_X], (float)value_array[PLY_VERTEX_Y], (float)value_array[PLY_VERTEX_Z],
+										   (float)value_array[PLY_VERTEX_NX], (float)value_array[PLY_VERTEX_NY], (float)value_array[PLY_VERTEX_NZ]);
+	if(uv_array)
+	{	uv_array[index] = gp_node_uv_s((float)value_array[PLY_VERTEX_U], (float)value_array[PLY_VERTEX_V]);
+	}
+	if(color_array)
+	{	color_array[index] = RGB(ply_get_color_channel(value_array[PLY_VERTEX_RED], layout.type_array[PLY_VERTEX_RED]),
+								 ply_get_color_channel(value_array[PLY_VERTEX_GREEN], layout.type_array[PLY_VERTEX_GREEN]),
+								 ply_get_color_channel(value_array[PLY_VERTEX_BLUE], layout.type_array[PLY_VERTEX_BLUE]));
+	}
+	return TRUE;
+}
+
+
+// Set a triangle from the indices of its corners, the 6 values of its texcoords and the values of its fields. Returns
+// FALSE if an index is out of range, a texcoord is not a finite float or the texnumber is out of range.
+inline BOOL ply_set_face(const ply_face_layout_s& layout, const double* corner_array, const double* uv_value_array, const double* value_array, unsigned int vertex_count,
+						 const unsigned int* vertex_color_array, gp_node_face_s& face_out, gp_node_uv_s* uv_out)
+{
+	// Local data
+	unsigned int								index_array[3];
+
+
+	for(unsigned int i=0; i<3; i++)
+	{	if(!(corner_array[i] >= 0.0 && corner_array[i] < (double)vertex_count))
+		{	return FALSE;
+		}
+		index_array[i] = (unsigned int)corner_array[i];
+	}
+	if(!(value_array[PLY_FACE_TEXNUMBER] >= 0.0 && value_array[PLY_FACE_TEXNUMBER] < PLY_MAX_SUBSET_COUNT))
+	{	return FALSE;
+	}
+	face_out = gp_node_face_s(index_array[0], index_array[1], index_array[2], (unsigned int)value_array[PLY_FACE_TEXNUMBER], gp_node_face_s().color);
+
+	if(uv_out)
+	{	for(unsigned int i=0; i<3; i++)
+		{	if(!ply_is_float(uv_value_array[i*2]) || !ply_is_float(uv_value_array[i*2+1]))
+			{	return FALSE;
+			}
+			uv_out[i] = gp_node_uv_s((float)uv_value_array[i*2], (float)uv_value_array[i*2+1]);
+		}
+	}
+
+	// The color of the face or the average color of its vertices.
+	if(layout.is_color)
+	{	face_out.color = RGB(ply_get_color_channel(value_array[PLY_FACE_RED], layout.type_array[PLY_FACE_RED]),
+							 ply_get_color_channel(value_array[PLY_FACE_GREEN], layout.type_array[PLY_FACE_GREEN]),
+							 ply_get_color_channel(value_array[PLY_FACE_BLUE], layout.type_array[PLY_FACE_BLUE]));
+	}
+	else if(vertex_color_array)
+	{	const unsigned int& color_0 = vertex_color_array[index_array[0]];
+		const unsigned int& color_1 = vertex_color_array[index_array[1]];
+		const unsigned int& color_2 = vertex_color_array[index_array[2]];
+		face_out.color = RGB((GetRValue(color_0) + GetRValue(color_1) + GetRValue(color_2) + 1) / 3,
+							 (GetGValue(color_0) + GetGValue(color_1) + GetGValue(color_2) + 1) / 3,
+							 (GetBValue(color_0) + GetBValue(color_1) + GetBValue(color_2) + 1) / 3);
+	}
+	return TRUE;
+}
+
+BOOL ply_vertex_body_s::operator()(unsigned int vertex_start, unsigned int vertex_end) const
+{
+	// Local data
+	double										value_array[PLY_VERTEX_FIELD_COUNT];
+
+
+	memset(value_array, 0, sizeof(value_array));
+	for(unsigned int i=vertex_start; i<vertex_end; i++)
+	{	const unsigned char* record = record_array + (size_t)i * layout->record_size;
+		for(unsigned int j=0; j<PLY_VERTEX_FIELD_COUNT; j++)
+		{	if(layout->property_array[j] != PLY_NONE)
+			{	value_array[j] = ply_get_value(record + layout->offset_array[j], layout->type_array[j], is_swap);
+			}
+		}
+		if(!ply_set_vertex(*layout, value_array, i, vertex_array, uv_array, color_array))
+		{	return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+BOOL ply_face_check_body_s::operator()(unsigned int face_start, unsigned int face_end) const
+{
+	for(unsigned int i=face_start; i<face_end; i++)
+	{	const unsigned char* record = record_array + (size_t)i * layout->record_size;
+		if(ply_get_value(record + layout->index_offset, layout->index_count_type, is_swap) != 3.0 ||
+		   (layout->uv_property != PLY_NONE && ply_get_value(record + layout->uv_offset, layout->uv_count_type, is_swap) != 6.0))
+		{	return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+BOOL ply_face_body_s::operator()(unsigned int face_start, unsigned int face_end) const
+{
+	// Local data
+	double										corner_array[3], uv_value_array[6], value_array[PLY_FACE_FIELD_COUNT];
+	unsigned int								index_start, index_size, uv_start, uv_size;
+
+
+	memset(value_array, 0, sizeof(value_array));
+	index_start	= layout->index_offset + ply_get_type_size(layout->index_count_type);
+	index_size	= ply_get_type_size(layout->index_type);
+	uv_start	= layout->uv_offset + ply_get_type_size(layout->uv_count_type);
+	uv_size		= ply_get_type_size(layout->uv_type);
+	for(unsigned int i=face_start; i<face_end; i++)
+	{	const unsigned char* record = record_array + (size_t)i * layout->record_size;
+		for(unsigned int j=0; j<3; j++)
+		{	corner_array[j] = ply_get_value(record + index_start + j * index_size, layout->index_type, is_swap);
+		}
+		if(uv_array)
+		{	for(unsigned int j=0; j<6; j++)
+			{	uv_value_array[j] = ply_get_value(record + uv_start + j * uv_size, layout->uv_type, is_swap);
+			}
+		}
+		for(unsigned int j=0; j<PLY_FACE_FIELD_COUNT; j++)
+		{	if(layout->property_array[j] != PLY_NONE)
+			{	value_array[j] = ply_get_value(record + layout->offset_array[j], layout->type_array[j], is_swap);
+			}
+		}
+		if(!ply_set_face(*layout, corner_array, uv_value_array, value_array, vertex_count, vertex_color_array, face_array[i], uv_array ? uv_array + (size_t)i * 3 : 0))
+		{	return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+// Return the word at pointer and move pointer past it and the spaces after it.
+std::string ply_get_word(const char*& pointer, const char* line_end)
+{
+	// Local data
+	const char*									start;
+
+
+	start = pointer;
+	while(pointer < line_end && !geo_text_is_space(*pointer))
+	{	pointer++;
+	}
+	std::string word(start, pointer);
+	geo_text_skip_space(pointer, line_end);
+	return word;
+}
+
+// Read the header of a PLY file. Returns 0 or an error message.
+const wchar_t* ply_read_header(const geo_file_map_s& file_map, unsigned int& format_out, std::vector<ply_element_s>& element_list_out, size_t& data_offset_out)
+{
+	// Local data
+	const char*									pointer;
+	const char*									end;
+	const char*									line_end;
+	std::string									word;
+	double										count;
+	BOOL										is_format;
+	ply_property_s								property;
+
+
+	pointer		= (const char*)file_map.data;
+	end			= pointer + file_map.size;
+	line_end	= geo_text_get_line_end(pointer, end);
+	if(geo_text_get_rest(pointer, line_end) != "ply")
+	{	return _T("The file is not a PLY file.");
+	}
+
+	is_format = FALSE;
+	for(pointer=line_end+1; pointer<end; pointer=line_end+1)
+	{	line_end = geo_text_get_line_end(pointer, end);
+		geo_text_skip_space(pointer, line_end);
+		word = ply_get_word(pointer, line_end);
+
+		if(word == "format")
+		{	word = ply_get_word(pointer, line_end);
+			if(word == "ascii")
+			{	format_out = PLY_FORMAT_ASCII;
+			}
+			else if(word == "binary_little_endian")
+			{	format_out = PLY_FORMAT_BINARY_LITTLE_ENDIAN;
+			}
+			else if(word == "binary_big_endian")
+			{	format_out = PLY_FORMAT_BINARY_BIG_ENDIAN;
+			}
+			else
+			{	return _T("The file has an unknown format.");
+			}
+			is_format = TRUE;
+		}
+		else if(word == "element")
+		{	element_list_out.push_back(ply_element_s());
+			element_list_out.back().name = ply_get_word(pointer, line_end);
+			if(!geo_text_parse_double(pointer, line_end, count) || !(count >= 0.0 && count < (double)UINT_MAX) || count != floor(count))
+			{	return _T("An element of the header has a count that is not valid.");
+			}
+			element_list_out.back().count = (unsigned int)count;
+		}
+		else if(word == "property")
+		{	if(element_list_out.empty())
+			{	return _T("A property of the header is not in an element.");
+			}
+			word				= ply_get_word(pointer, line_end);
+			property.count_type	= PLY_TYPE_NONE;
+			if(word == "list")
+			{	property.count_type = ply_get_type(ply_get_word(pointer, line_end));
+				if(property.count_type == PLY_TYPE_NONE || property.count_type >= PLY_TYPE_FLOAT32)
+				{	return _T("A list of the header has a count type that is not valid.");
+				}
+				word = ply_get_word(pointer, line_end);
+			}
+			property.type = ply_get_type(word);
+			property.name = ply_get_word(pointer, line_end);
+			if(property.type == PLY_TYPE_NONE || property.name.empty())
+			{	return _T("A property of the header is not valid.");
+			}
+			element_list_out.back().property_list.push_back(property);
+		}
+		else if(word == "end_header")
+		{	if(!is_format)
+			{	return _T("The header has no format.");
+			}
+			data_offset_out = line_end < end ? (size_t)(line_end + 1 - (const char*)file_map.data) : file_map.size;
+			return 0;
+		}
+		else if(word != "comment" && word != "obj_info" && !word.empty())
+		{	return _T("The header has a line that is not valid.");
+		}
+	}
+	return _T("The file has no end_header.");
+}
+
+// Find the vertex fields of element. Returns FALSE if it has no x, y and z.
+BOOL ply_get_vertex_layout(const ply_element_s& element, unsigned int format, ply_vertex_layout_s& layout_out)
+{
+	// Local data
+	static const char* const					name_array[PLY_VERTEX_FIELD_COUNT][4] = {
+													{ "x" }, { "y" }, { "z" }, { "nx" }, { "ny" }, { "nz" },
+													{ "u", "s", "texture_u", "texture_s" }, { "v", "t", "texture_v", "texture_t" },
+													{ "red", "diffuse_red" }, { "green", "diffuse_green" }, { "blue", "diffuse_blue" } };
+	unsigned int								offset;
+	BOOL										is_fixed;
+
+
+	for(unsigned int i=0; i<PLY_VERTEX_FIELD_COUNT; i++)
+	{	layout_out.property_array[i]	= PLY_NONE;
+		layout_out.offset_array[i]		= 0;
+		layout_out.type_array[i]		= PLY_TYPE_NONE;
+	}
+
+	offset		= 0;
+	is_fixed	= format != PLY_FORMAT_ASCII;
+	for(unsigned int i=0; i<element.property_list.size(); i++)
+	{	const ply_property_s& property = element.property_list[i];
+		if(property.count_type != PLY_TYPE_NONE)
+		{	is_fixed = FALSE;
+			continue;
+		}
+		for(unsigned int j=0; j<PLY_VERTEX_FIELD_COUNT; j++)
+		{	for(unsigned int k=0; k<4 && name_array[j][k]; k++)
+			{	if(layout_out.property_array[j] == PLY_NONE && property.name == name_array[j][k])
+				{	layout_out.property_array[j]	= i;
+					layout_out.offset_array[j]		= offset;
+					layout_out.type_array[j]		= property.type;
+				}
+			}
+		}
+		offset += ply_get_type_size(property.type);
+	}
+	layout_out.record_size = is_fixed ? offset : 0;
+
+	// Only use normals, uvs and colors that have all of their fields.
+	layout_out.is_normal	= layout_out.property_array[PLY_VERTEX_NX] != PLY_NONE && layout_out.property_array[PLY_VERTEX_NY] != PLY_NONE && layout_out.property_array[PLY_VERTEX_NZ] != PLY_NONE;
+	layout_out.is_uv		= layout_out.property_array[PLY_VERTEX_U] != PLY_NONE && layout_out.property_array[PLY_VERTEX_V] != PLY_NONE;
+	layout_out.is_color		= layout_out.property_array[PLY_VERTEX_RED] != PLY_NONE && layout_out.property_array[PLY_VERTEX_GREEN] != PLY_NONE && layout_out.property_array[PLY_VERTEX_BLUE] != PLY_NONE;
+	for(unsigned int i=PLY_VERTEX_NX; i<PLY_VERTEX_FIELD_COUNT; i++)
+	{	if(!(i <= PLY_VERTEX_NZ ? layout_out.is_normal : (i <= PLY_VERTEX_V ? layout_out.is_uv : layout_out.is_color)))
+		{	layout_out.property_array[i] = PLY_NONE;
+		}
+	}
+
+	return layout_out.property_array[PLY_VERTEX_X] != PLY_NONE && layout_out.property_array[PLY_VERTEX_Y] != PLY_NONE && layout_out.property_array[PLY_VERTEX_Z] != PLY_NONE;
+}
+
+// Find the face fields of element. Returns FALSE if it has no list of vertex indices.
+BOOL ply_get_face_layout(const ply_element_s& element, unsigned int format, ply_face_layout_s& layout_out)
+{
+	// Local data
+	static const char* const					name_array[PLY_FACE_FIELD_COUNT] = { "red", "green", "blue", "texnumber" };
+	unsigned int								offset;
+	BOOL										is_fixed;
+
+
+	for(unsigned int i=0; i<PLY_FACE_FIELD_COUNT; i++)
+	{	layout_out.property_array[i]	= PLY_NONE;
+		layout_out.offset_array[i]		= 0;
+		layout_out.type_array[i]		= PLY_TYPE_NONE;
+	}
+	layout_out.index_property	= PLY_NONE;
+	layout_out.uv_property		= PLY_NONE;
+	layout_out.index_offset		= layout_out.uv_offset = 0;
+	layout_out.index_count_type	= layout_out.index_type = layout_out.uv_count_type = layout_out.uv_type = PLY_TYPE_NONE;
+
+	offset		= 0;
+	is_fixed	= format != PLY_FORMAT_ASCII;
+	for(unsigned int i=0; i<element.property_list.size(); i++)
+	{	const ply_property_s& property = element.property_list[i];
+		if(property.count_type != PLY_TYPE_NONE)
+		{	if(layout_out.index_property == PLY_NONE && (property.name == "vertex_indices" || property.name == "vertex_index"))
+			{	layout_out.index_property	= i;
+				layout_out.index_offset		= offset;
+				layout_out.index_count_type	= property.count_type;
+				layout_out.index_type		= property.type;
+				offset += ply_get_type_size(property.count_type) + 3 * ply_get_type_size(property.type);
+			}
+			else if(layout_out.uv_property == PLY_NONE && property.name == "texcoord")
+			{	layout_out.uv_property		= i;
+				layout_out.uv_offset		= offset;
+				layout_out.uv_count_type	= property.count_type;
+				layout_out.uv_type			= property.type;
+				offset += ply_get_type_size(property.count_type) + 6 * ply_get_type_size(property.type);
+			}
+			else
+			{	is_fixed = FALSE;
+			}
+			continue;
+		}
+		for(unsigned int j=0; j<PLY_FACE_FIELD_COUNT; j++)
+		{	if(layout_out.property_array[j] == PLY_NONE && property.name == name_array[j])
+			{	layout_out.property_array[j]	= i;
+				layout_out.offset_array[j]		= offset;
+				layout_out.type_array[j]		= property.type;
+			}
+		}
+		offset += ply_get_type_size(property.type);
+	}
+	layout_out.record_size = is_fixed ? offset : 0;
+
+	layout_out.is_color = layout_out.property_array[PLY_FACE_RED] != PLY_NONE && layout_out.property_array[PLY_FACE_GREEN] != PLY_NONE && layout_out.property_array[PLY_FACE_BLUE] != PLY_NONE;
+	if(!layout_out.is_color)
+	{	layout_out.property_array[PLY_FACE_RED] = layout_out.property_array[PLY_FACE_GREEN] = layout_out.property_array[PLY_FACE_BLUE] = PLY_NONE;
+	}
+
+	return layout_out.index_property != PLY_NONE;
+}
+
+// Read the vertex element at pointer and move pointer past it. uv_list_out and color_list_out are filled if the layout
+// has uvs and colors and they are not 0. Returns FALSE and logs an error on failure.
+BOOL ply_read_vertices(unsigned int plugin_index, const ply_element_s& element, const ply_vertex_layout_s& layout, unsigned int format, const unsigned char*& pointer, const unsigned char* end,
+					   std::vector<gp_node_vertex_s>& vertex_list_out, std::vector<gp_node_uv_s>* uv_list_out, std::vector<unsigned int>* color_list_out)
+{
+	// Local data
+	ply_vertex_body_s							vertex_body;
+	std::vector<double>							value_list;
+	std::vector< std::vector<double> >			list_list;
+	double										field_array[PLY_VERTEX_FIELD_COUNT];
+
+
+	try
+	{	vertex_list_out.resize(element.count);
+		if(uv_list_out)
+		{	uv_list_out->resize(element.count);
+		}
+		if(color_list_out)
+		{	color_list_out->resize(element.count);
+		}
+	}
+	catch(...)
+	{	LOG_ERROR_MSG(plugin_index, _T("Memory Allocation Error: Failed to allocate the vertex list."));
+		return FALSE;
+	}
+	vertex_body.vertex_array	= vertex_list_out.data();
+	vertex_body.uv_array		= uv_list_out ? uv_list_out->data() : 0;
+	vertex_body.color_array		= color_list_out ? color_list_out->data() : 0;
+
+	// Fixed size records are read on all cores.
+	if(layout.record_size)
+	{	if((unsigned long long)(end - pointer) < (unsigned long long)element.count * layout.record_size)
+		{	LOG_ERROR_MSG(plugin_index, _T("The file ends before the last vertex."));
+			return FALSE;
+		}
+		vertex_body.record_array	= pointer;
+		vertex_body.layout			= &layout;
+		vertex_body.is_swap			= format == PLY_FORMAT_BINARY_BIG_ENDIAN;
+		if(!parallel_for(element.count, PLY_CHUNK_SIZE, vertex_body, parallel_progress_s()))
+		{	LOG_ERROR_MSG(plugin_index, _T("A vertex has a value that is not a finite number."));
+			return FALSE;
+		}
+		pointer += (size_t)element.count * layout.record_size;
+		return TRUE;
+	}
+
+	try
+	{	value_list.resize(element.property_list.size());
+		list_list.resize(element.property_list.size());
+		memset(field_array, 0, sizeof(field_array));
+		for(unsigned int i=0; i<element.count; i++)
+		{	if(!ply_read_record(pointer, end, element, format, value_list.data(), list_list.data()))
+			{	LOG_ERROR_MSG(plugin_index, _T("A vertex is cut off or not valid."));
+				return FALSE;
+			}
+			for(unsigned int j=0; j<PLY_VERTEX_FIELD_COUNT; j++)
+			{	if(layout.property_array[j] != PLY_NONE)
+				{	field_array[j] = value_list[layout.property_array[j]];
+				}
+			}
+			if(!ply_set_vertex(layout, field_array, i, vertex_body.vertex_array, vertex_body.uv_array, vertex_body.color_array))
+			{	LOG_ERROR_MSG(plugin_index, _T("A vertex has a value that is not a finite number."));
+				return FALSE;
+			}
+		}
+	}
+	catch(...)
+	{	LOG_ERROR_MSG(plugin_index, _T("Memory Allocation Error: Failed to read the vertices."));
+		return FALSE;
+	}
+	return TRUE;
+}
+
+// Read the face element at pointer and move pointer past it. Polygons are split into fans of triangles. uv_list_out
+// gets 3 uvs per triangle if it is not 0. Returns FALSE and logs an error on failure.
+BOOL ply_read_faces(unsigned int plugin_index, const ply_element_s& element, const ply_face_layout_s& layout, unsigned int format, const unsigned char*& pointer, const unsigned char* end,
+					unsigned int vertex_count, const unsigned int* vertex_color_array, std::vector<gp_node_face_s>& face_list_out, std::vector<gp_node_uv_s>* uv_list_out)
+{
+	// Local data
+	ply_face_check_body_s						check_body;
+	ply_face_body_s								face_body;
+	std::vector<double>							value_list;
+	std::vector< std::vector<double> >			list_list;
+	double										field_array[PLY_FACE_FIELD_COUNT], corner_array[3], uv_value_array[6];
+	gp_node_face_s								face;
+	gp_node_uv_s								uv_array[3];
+	size_t										corner_count;
+
+
+	// Fixed size records are read on all cores if every face is a triangle.
+	check_body.record_array	= pointer;
+	check_body.layout		= &layout;
+	check_body.is_swap		= format == PLY_FORMAT_BINARY_BIG_ENDIAN;
+	if(layout.record_size && (unsigned long long)(end - pointer) >= (unsigned long long)element.count * layout.record_size &&
+	   parallel_for(element.count, PLY_CHUNK_SIZE, check_body, parallel_progress_s()))
+	{	try
+		{	face_list_out.resize(element.count);
+			if(uv_list_out)
+			{	uv_list_out->resize((size_t)element.count * 3);
+			}
+		}
+		catch(...)
+		{	LOG_ERROR_MSG(plugin_index, _T("Memory Allocation Error: Failed to allocate the face list."));
+			return FALSE;
+		}
+		face_body.record_array			= pointer;
+		face_body.layout				= &layout;
+		face_body.is_swap				= check_body.is_swap;
+		face_body.vertex_count			= vertex_count;
+		face_body.vertex_color_array	= vertex_color_array;
+		face_body.face_array			= face_list_out.data();
+		face_body.uv_array				= uv_list_out ? uv_list_out->data() : 0;
+		if(!parallel_for(element.count, PLY_CHUNK_SIZE, face_body, parallel_progress_s()))
+		{	LOG_ERROR_MSG(plugin_index, _T("A face has a vertex index, texcoord or texnumber that is not valid."));
+			return FALSE;
+		}
+		pointer += (size_t)element.count * layout.record_size;
+		return TRUE;
+	}
+
+	try
+	{	face_list_out.reserve(element.count);
+		if(uv_list_out)
+		{	uv_list_out->reserve((size_t)element.count * 3);
+		}
+		value_list.resize(element.property_list.size());
+		list_list.resize(element.property_list.size());
+		memset(field_array, 0, sizeof(field_array));
+		memset(uv_value_array, 0, sizeof(uv_value_array));
+		for(unsigned int i=0; i<element.count; i++)
+		{	if(!ply_read_record(pointer, end, element, format, value_list.data(), list_list.data()))
+			{	LOG_ERROR_MSG(plugin_index, _T("A face is cut off or not valid."));
+				return FALSE;
+			}
+			for(unsigned int j=0; j<PLY_FACE_FIELD_COUNT; j++)
+			{	if(layout.property_array[j] != PLY_NONE)
+				{	field_array[j] = value_list[layout.property_array[j]];
+				}
+			}
+
+			// Split the polygon into a fan of triangles.
+			const std::vector<double>& index_list = list_list[layout.index_property];
+			corner_count = index_list.size();
+			if(uv_list_out && list_list[layout.uv_property].size() != corner_count * 2)
+			{	LOG_ERROR_MSG(plugin_index, _T("A face does not have 2 texcoords for each vertex."));
+				return FALSE;
+			}
+			for(size_t j=2; j<corner_count; j++)
+			{	corner_array[0]	= index_list[0];
+				corner_array[1]	= index_list[j-1];
+				corner_array[2]	= index_list[j];
+				if(uv_list_out)
+				{	const std::vector<double>& texcoord_list = list_list[layout.uv_property];
+					uv_value_array[0] = texcoord_list[0];			uv_value_array[1] = texcoord_list[1];
+					uv_value_array[2] = texcoord_list[j*2-2];		uv_value_array[3] = texcoord_list[j*2-1];
+					uv_value_array[4] = texcoord_list[j*2];			uv_value_array[5] = texcoord_list[j*2+1];
+				}
+				if(!ply_set_face(layout, corner_array, uv_value_array, field_array, vertex_count, vertex_color_array, face, uv_list_out ? uv_array : 0))
+				{	LOG_ERROR_MSG(plugin_index, _T("A face has a vertex index, texcoord or texnumber that is not valid."));
+					return FALSE;
+				}
+				if(face_list_out.size() >= UINT_MAX / 3)
+				{	LOG_ERROR_MSG(plugin_index, _T("The file has too many faces."));
+					return FALSE;
+				}
+				face_list_out.push_back(face);
+				if(uv_list_out)
+				{	uv_list_out->insert(uv_list_out->end(), uv_array, uv_array + 3);
+				}
+			}
+		}
+	}
+	catch(...)
+	{	LOG_ERROR_MSG(plugin_index, _T("Memory Allocation Error: Failed to read the faces."));
+		return FALSE;
+	}
+	return TRUE;
+}
+
+// Skip the element at pointer. Returns FALSE if it is cut off.
+BOOL ply_skip_element(const ply_element_s& element, unsigned int format, const unsigned char*& pointer, const unsigned char* end)
+{
+	// Local data
+	std::vector<double>							value_list;
+	std::vector< std::vector<double> >			list_list;
+	unsigned long long							record_size;
+
+
+	record_size = 0;
+	for(size_t i=0; i<element.property_list.size() && format!=PLY_FORMAT_ASCII; i++)
+	{	if(element.property_list[i].count_type != PLY_TYPE_NONE)
+		{	record_size = 0;
+			break;
+		}
+		record_size += ply_get_type_size(element.property_list[i].type);
+	}
+	if(record_size)
+	{	if((unsigned long long)(end - pointer) < element.count * record_size)
+		{	return FALSE;
+		}
+		pointer += (size_t)(element.count * record_size);
+		return TRUE;
+	}
+
+	try
+	{	value_list.resize(element.property_list.size());
+		list_list.resize(element.property_list.size());
+		for(unsigned int i=0; i<element.count; i++)
+		{	if(!ply_read_record(pointer, end, element, format, value_list.data(), list_list.data()))
+			{	return FALSE;
+			}
+		}
+	}
+	catch(...)
+	{	return FALSE;
+	}
+	return TRUE;
+}
+
+
+// ------------------------------------------------------------------
+// ------------------------------------------------------------------
+// Local functions called during init, process, and shutdown
+
+// Initialize plugin - called when plugin is attached to ShaderMap.
+BOOL on_initialize(void)
+{
+	// Local data
+	const wchar_t*	ext_array[] = {_T("ply")};
+
+
+	// Tell ShaderMap we are starting initialization.
+	gp_begin_initialize();
+
+		// Set file format name and extension list.
+#ifdef _DEBUG
+		gp_set_file_info(_T("Polygon File Format PLY - DEBUG"), ext_array, 1);
+#else
+		gp_set_file_info(_T("Polygon File Format PLY"), ext_array, 1);
+#endif
+
+	// Tell ShaderMap initialization is done.
+	gp_end_initialize();
+
+	return TRUE;
+}
+
+// Process plugin - called when plugin is asked by ShaderMap to import a 3D Model (geometry).
+BOOL on_process(unsigned int plugin_index, const wchar_t* file_path)
+{
+	// Local data
+	geo_file_map_s								file_map;
+	unsigned int								geometry_type, format, vertex_element, face_element, subset_count, uv_channel_count;
+	BOOL										is_success, is_color, is_face_uv;
+	const wchar_t*								error;
+	std::vector<ply_element_s>					element_list;
+	size_t										data_offset, i;
+	const unsigned char*						pointer;
+	const unsigned char*						end;
+	ply_vertex_layout_s							vertex_layout;
+	ply_face_layout_s							face_layout;
+	std::vector<gp_node_vertex_s>				vertex_list;
+	std::vector<gp_node_uv_s>					vertex_uv_list, face_uv_list;
+	std::vector<unsigned int>					color_list, uv_index_list;
+	std::vector<gp_node_face_s>					face_list;
+	gp_render_vertex_s							render_vertex;
+	unsigned int								corner_array[3];
+	gp_node_uv_data_s							node_uv_data;
+	gp_node_uv_s*								node_uv_channel_array[1];
+	unsigned int*								node_uv_index_array[1];
+	unsigned int								node_uv_count_array[1];
+	geo_mesh_s									render_mesh;
+
+
+	// Get geometry type. This can be of type render or of type node.
+	geometry_type = gp_get_geometry_type();
+
+	// Set return value
+	is_success = TRUE;
+
+	// Map the file into memory. See "geo_file_map.cpp".
+	if(!geo_file_map_open(file_path, file_map))
+	{	LOG_ERROR_MSG(plugin_index, _T("Failed to open file at file_path."));
+		return FALSE;
+	}
+
+	// -----------------
+
+	// Read the header and find the vertex and face elements.
+	try
+	{	error = ply_read_header(file_map, format, element_list, data_offset);
+	}
+	catch(...)
+	{	error = _T("Memory Allocation Error: Failed to read the header.");
+	}
+	if(error)
+	{	LOG_ERROR_MSG(plugin_index, error);
+		is_success = FALSE;
+		goto ON_PROCESS_CLEANUP;
+	}
+	vertex_element = face_element = PLY_NONE;
+	for(i=0; i<element_list.size(); i++)
+	{	if(vertex_element == PLY_NONE && element_list[i].name == "vertex")
+		{	vertex_element = (unsigned int)i;
+		}
+		else if(face_element == PLY_NONE && element_list[i].name == "face")
+		{	face_element = (unsigned int)i;
+		}
+	}
+	if(vertex_element == PLY_NONE || !ply_get_vertex_layout(element_list[vertex_element], format, vertex_layout))
+	{	LOG_ERROR_MSG(plugin_index, _T("The file has no vertex element with x, y and z."));
+		is_success = FALSE;
+		goto ON_PROCESS_CLEANUP;
+	}
+	if(face_element == PLY_NONE || face_element < vertex_element || !ply_get_face_layout(element_list[face_element], format, face_layout))
+	{	LOG_ERROR_MSG(plugin_index, _T("The file has no face element with vertex_indices after the vertex element."));
+		is_success = FALSE;
+		goto ON_PROCESS_CLEANUP;
+	}
+
+	// Colors are only read for node geometry if the options ask for them.
+	is_color = geometry_type == GP_GEOMETRY_TYPE_NODE && gp_is_option_material_color_from_file();
+	if(!is_color)
+	{	face_layout.is_color = FALSE;
+	}
+	is_face_uv = face_layout.uv_property != PLY_NONE;
+
+	// Read the elements in order up to the faces.
+	pointer	= file_map.data + data_offset;
+	end		= file_map.data + file_map.size;
+	for(i=0; i<=face_element; i++)
+	{	if(i == vertex_element)
+		{	if(!ply_read_vertices(plugin_index, element_list[i], vertex_layout, format, pointer, end, vertex_list, !is_face_uv && vertex_layout.is_uv ? &vertex_uv_list : 0,
+								  is_color && !face_layout.is_color && vertex_layout.is_color ? &color_list : 0))
+			{	is_success = FALSE;
+				goto ON_PROCESS_CLEANUP;
+			}
+		}
+		else if(i == face_element)
+		{	if(!ply_read_faces(plugin_index, element_list[i], face_layout, format, pointer, end, (unsigned int)vertex_list.size(), color_list.empty() ? 0 : color_list.data(),
+							   face_list, is_face_uv ? &face_uv_list : 0))
+			{	is_success = FALSE;
+				goto ON_PROCESS_CLEANUP;
+			}
+		}
+		else if(!ply_skip_element(element_list[i], format, pointer, end))
+		{	LOG_ERROR_MSG(plugin_index, _T("An element is cut off or not valid."));
+			is_success = FALSE;
+			goto ON_PROCESS_CLEANUP;
+		}
+	}
+	std::vector<unsigned int>().swap(color_list);
+	if(face_list.empty())
+	{	LOG_ERROR_MSG(plugin_index, _T("The file has no faces."));
+		is_success = FALSE;
+		goto ON_PROCESS_CLEANUP;
+	}
+
+	// Each texnumber is a subset.
+	subset_count = 1;
+	for(i=0; i<face_list.size(); i++)
+	{	if(face_list[i].subset_index >= subset_count)
+		{	subset_count = face_list[i].subset_index + 1;
+		}
+	}
+
+	// Make smooth normals from the faces if the file has none.
+	if(!vertex_layout.is_normal && !geo_create_node_normals(vertex_list.data(), (unsigned int)vertex_list.size(), face_list.data(), (unsigned int)face_list.size()))
+	{	LOG_ERROR_MSG(plugin_index, _T("Memory Allocation Error: Failed to create the normals."));
+		is_success = FALSE;
+		goto ON_PROCESS_CLEANUP;
+	}
+
+	if(!is_face_uv && !vertex_layout.is_uv)
+	{	gp_flag_no_uv_geometry();
+	}
+
+	// -----------------
+
+	// GP_GEOMETRY_TYPE_RENDER
+	// This format for geometry is used for 3d models in the material visualizer.
+	if(geometry_type == GP_GEOMETRY_TYPE_RENDER)
+	{
+		// Corners with the same position, normal and uv share one render vertex. See "geo_mesh_build.cpp".
+		if(!geo_mesh_reserve(render_mesh, (unsigned int)face_list.size()))
+		{	LOG_ERROR_MSG(plugin_index, _T("Memory Allocation Error: Failed to allocate the render geometry lists."));
+			is_success = FALSE;
+			goto ON_PROCESS_CLEANUP;
+		}
+		try
+		{	for(i=0; i<face_list.size(); i++)
+			{	const gp_node_face_s& face = face_list[i];
+				for(unsigned int j=0; j<3; j++)
+				{	const unsigned int			index	= j == 0 ? face.a : (j == 1 ? face.b : face.c);
+					const gp_node_vertex_s&		vertex	= vertex_list[index];
+					render_vertex.x		= vertex.x;
+					render_vertex.y		= vertex.y;
+					render_vertex.z		= vertex.z;
+					render_vertex.nx	= vertex.nx;
+					render_vertex.ny	= vertex.ny;
+					render_vertex.nz	= vertex.nz;
+					render_vertex.u		= is_face_uv ? face_uv_list[i*3+j].u : (vertex_layout.is_uv ? vertex_uv_list[index].u : 0.0f);
+					render_vertex.v		= is_face_uv ? -face_uv_list[i*3+j].v : (vertex_layout.is_uv ? -vertex_uv_list[index].v : 0.0f);
+					corner_array[j]		= geo_mesh_add_vertex(render_mesh, render_vertex);
+				}
+				geo_mesh_add_face(render_mesh, corner_array[0], corner_array[1], corner_array[2], face.subset_index);
+			}
+		}
+		catch(...)
+		{	LOG_ERROR_MSG(plugin_index, _T("Memory Allocation Error: Failed to allocate the render geometry lists."));
+			is_success = FALSE;
+			goto ON_PROCESS_CLEANUP;
+		}
+		std::vector<gp_node_vertex_s>().swap(vertex_list);
+		std::vector<gp_node_face_s>().swap(face_list);
+
+		if(!geo_mesh_optimize(render_mesh))
+		{	LOG_ERROR_MSG(plugin_index, _T("Memory Allocation Error: Failed to optimize the render geometry."));
+			is_success = FALSE;
+			goto ON_PROCESS_CLEANUP;
+		}
+
+		// Send the render lists to ShaderMap. No additional UV arrays.
+		if(!gp_create_render_geometry(render_mesh.vertex_list.data(), (unsigned int)render_mesh.vertex_list.size(), render_mesh.face_list.data(), (unsigned int)render_mesh.face_list.size(),
+									  subset_count, FALSE, 0, 0))
+		{	LOG_ERROR_MSG(plugin_index, _T("Failed to create render geometry with gp_create_render_geometry."));
+			is_success = FALSE;
+			goto ON_PROCESS_CLEANUP;
+		}
+	}
+	// GP_GEOMETRY_TYPE_NODE
+	// This format for geometry is used for 3d model nodes in the project grid.
+	else if(geometry_type == GP_GEOMETRY_TYPE_NODE)
+	{
+		// Create the node uv data struct. Texcoords have a uv for each corner, vertex uvs use the vertex indices.
+		uv_channel_count = 0;
+		if(is_face_uv || vertex_layout.is_uv)
+		{	try
+			{	uv_index_list.resize(face_list.size() * 3);
+			}
+			catch(...)
+			{	LOG_ERROR_MSG(plugin_index, _T("Memory Allocation Error: Failed to allocate the uv index list."));
+				is_success = FALSE;
+				goto ON_PROCESS_CLEANUP;
+			}
+			for(i=0; i<face_list.size(); i++)
+			{	uv_index_list[i*3]		= is_face_uv ? (unsigned int)(i * 3) : face_list[i].a;
+				uv_index_list[i*3+1]	= is_face_uv ? (unsigned int)(i * 3 + 1) : face_list[i].b;
+				uv_index_list[i*3+2]	= is_face_uv ? (unsigned int)(i * 3 + 2) : face_list[i].c;
+			}
+			node_uv_channel_array[0]	= is_face_uv ? face_uv_list.data() : vertex_uv_list.data();
+			node_uv_index_array[0]		= uv_index_list.data();
+			node_uv_count_array[0]		= (unsigned int)(is_face_uv ? face_uv_list.size() : vertex_uv_list.size());
+			uv_channel_count			= 1;
+		}
+		node_uv_data.uv_channel_count	= uv_channel_count;
+		node_uv_data.uv_channels_array	= node_uv_channel_array;
+		node_uv_data.uv_indices_array	= node_uv_index_array;
+		node_uv_data.uv_count_array		= node_uv_count_array;
+
+		// The faces of each subset must be together. See "geo_subset_sort.cpp".
+		if(!geo_sort_subset_faces(face_list.data(), (unsigned int)face_list.size(), subset_count, node_uv_index_array, uv_channel_count, 0, 0))
+		{	LOG_ERROR_MSG(plugin_index, _T("Memory Allocation Error: Failed to sort the faces by subset."));
+			is_success = FALSE;
+			goto ON_PROCESS_CLEANUP;
+		}
+
+		// Each texnumber is a material id.
+		for(unsigned int j=0; j<subset_count; j++)
+		{	gp_define_node_material_id(1, &j);
+		}
+
+		// Send the node lists to ShaderMap.
+		if(!gp_create_node_geometry(vertex_list.data(), (unsigned int)vertex_list.size(), face_list.data(), (unsigned int)face_list.size(), &node_uv_data, subset_count, FALSE))
+		{	LOG_ERROR_MSG(plugin_index, _T("Failed to create node geometry with gp_create_node_geometry."));
+			is_success = FALSE;
+			goto ON_PROCESS_CLEANUP;
+		}
+	}
+
+ON_PROCESS_CLEANUP:
+
+	// Unmap the file.
+	geo_file_map_close(file_map);
+
+	return is_success;
+}
+
+// Free any local plugin resources allocated - called by ShaderMap before detaching from the plugin.
+BOOL on_shutdown(void)
+{
+	// Stop the threads that read the files.
+	parallel_shutdown();
+
+	return TRUE;
+}
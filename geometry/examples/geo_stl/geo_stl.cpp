@@ -0,0 +1,484 @@
+/*
+	===============================================================
+
+	SHADERMAP SDK LICENSE
+
+	The ShaderMap SDK is released under The MIT License (MIT)
+	http://opensource.org/licenses/MIT
+
+	Copyright (c) 2007-2019 Rendering Systems Inc.
+
+	Permission is hereby granted, free of charge, to any person
+	obtaining a copy of this software and associated documentation
+	files (the "Software"), to deal	in the Software without
+	restriction, including without limitation the rights to use,
+	copy, modify, merge, publish, distribute, sublicense, and/or
+	sell copies of the Software, and to permit persons to whom the
+	Software is	furnished to do so, subject to the following
+	conditions:
+
+	The above copyright notice and this permission notice shall be
+	included in	all copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+	OF MERCHANTABILITY,	FITNESS FOR A PARTICULAR PURPOSE AND
+	NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+	OTHER DEALINGS IN THE SOFTWARE.
+
+	Developed by: Neil Kemp at Rendering Systems Inc.
+
+	Online:		http://shadermap.com
+	Corporate:	http://renderingsystems.com
+
+	===============================================================
+*/
+/*
+	===============================================================
+
+	ABOUT:
+
+	This project builds a geometry import plugin for ShaderMap 4.3.
+	The plugin loads binary and ASCII STL files and sends them to
+	ShaderMap in one of two formats: render or node.
+
+	STL stores the 3 corner positions of each face and no indices.
+	The file is mapped into memory and read in blocks of
+	STL_BLOCK_SIZE faces. The records of a binary block are copied
+	out on all cores and the corners of each block are welded into
+	shared vertices as it is read (see "geo_stream_weld.cpp"), so
+	only one block of corners is in memory at a time. Smooth
+	normals are then made from the faces on all cores (see
+	"geo_node_normals.cpp"). The facet normals of the file are not
+	used, many exporters write 0 or flat normals.
+
+	Face colors are read from the attribute of binary records in
+	the VisCAM / SolidView style (bit 15 set, 5 bits each of red,
+	green and blue from the high bits) or, if the header has
+	"COLOR=", the Materialise Magics style (bit 15 clear, red
+	from the low bits). They are used if the options ask for
+	material colors from the file.
+
+	Each "solid" of an ASCII file is a subset and a material id.
+
+	All geometry import plugins have the extension .smg and are
+	stored in the ShaderMap installation directory at:
+	"plugins\bin\geometry"
+
+	See "geometry\examples\geo_custom\geo_custom.cpp" to setup
+	your system for development. The steps are the same for this
+	project.
+
+	===============================================================
+*/
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Plugin includes
+
+#include "../../geo_plugin_core.cpp"
+#include "../../geo_file_map.cpp"
+#include "../../geo_mesh_build.cpp"
+#include "../../geo_text_parse.cpp"
+#include "../../geo_stream_weld.cpp"
+#include "../../geo_node_normals.cpp"
+#include <math.h>
+#include <string.h>
+#include <vector>
+
+
+// ------------------------------------------------------------------
+// ------------------------------------------------------------------
+// Local defines
+
+// Faces read and welded at a time. The corner positions of a block take 36 bytes per face.
+#ifndef STL_BLOCK_SIZE
+#define STL_BLOCK_SIZE							(1 << 20)
+#endif
+
+// Binary file layout - 80 byte header, face count, 50 byte records.
+#define STL_HEADER_SIZE							80
+#define STL_RECORD_SIZE							50
+
+// Fewest bytes of an ASCII facet - "facet normal", "outer loop", 3 "vertex" lines, "endloop" and "endfacet" with
+// single digit numbers. The file size divided by it is the most faces an ASCII file can have.
+#define STL_ASCII_FACET_SIZE					100
+
+// Faces in each chunk given to a thread when copying records.
+#define STL_CHUNK_SIZE							16384
+
+
+// ------------------------------------------------------------------
+// ------------------------------------------------------------------
+// Local structs
+
+// Copies the corner positions and colors of a block of binary records.
+struct stl_record_body_s
+{
+	const unsigned char*						record_array;
+	float*										position_array;			// 9 floats per face
+	gp_node_face_s*								face_array;
+	BOOL										is_color;				// Read colors from the attributes
+	BOOL										is_materialise;			// Materialise Magics colors, else VisCAM / SolidView
+	unsigned int								default_color;
+
+	BOOL operator()(unsigned int face_start, unsigned int face_end) const
+	{	for(unsigned int i=face_start; i<face_end; i++)
+		{	const unsigned char*	record		= record_array + (size_t)i * STL_RECORD_SIZE;
+			float*					position	= position_array + (size_t)i * 9;
+			unsigned short			attribute;
+
+			// Records are little endian, the facet normal is skipped.
+			memcpy(position, record + 12, 9 * sizeof(float));
+			for(unsigned int j=0; j<9; j++)
+			{	if(!(fabsf(position[j]) <= 3.4028234663852886e38f))
+				{	return FALSE;
+				}
+			}
+
+			face_array[i].subset_index	= 0;
+			face_array[i].color			= default_color;
+			if(is_color)
+			{	memcpy(&attribute, record + 48, sizeof(attribute));
+				if(is_materialise && !(attribute & 0x8000))
+				{	face_array[i].color = RGB(stl_get_color_channel(attribute), stl_get_color_channel(attribute >> 5), stl_get_color_channel(attribute >> 10));
+				}
+				else if(!is_materialise && (attribute & 0x8000))
+				{	face_array[i].color = RGB(stl_get_color_channel(attribute >> 10), stl_get_color_channel(attribute >> 5), stl_get_color_channel(attribute));
+				}
+			}
+		}
+		return TRUE;
+	}
+
+	// Return the 8 bit value of the 5 bit color channel in the low bits of value.
+	static unsigned int stl_get_color_channel(unsigned int value)
+	{	value &= 0x1F;
+		return value << 3 | value >> 2;
+	}
+};
+
+
+// ------------------------------------------------------------------
+// ------------------------------------------------------------------
+// Local functions called during process
+
+// Read the faces of a binary STL file and weld their corners. Returns FALSE and logs an error on failure.
+BOOL read_binary_stl(unsigned int plugin_index, const geo_file_map_s& file_map, unsigned int face_count, BOOL is_color, std::vector<gp_node_face_s>& face_list_out, geo_stream_weld_s& weld)
+{
+	// Local data
+	std::vector<float>							position_list;
+	stl_record_body_s							record_body;
+	unsigned int								block_start, block_size;
+	const char*									header;
+
+
+	try
+	{	face_list_out.resize(face_count);
+		position_list.resize((size_t)std::min<unsigned int>(face_count, STL_BLOCK_SIZE) * 9);
+	}
+	catch(...)
+	{	LOG_ERROR_MSG(plugin_index, _T("Memory Allocation Error: Failed to allocate the face list."));
+		return FALSE;
+	}
+
+	// Magics writes "COLOR=" and the default color in the header.
+	header								= (const char*)file_map.data;
+	record_body.is_materialise			= FALSE;
+	for(unsigned int i=0; i+6<=STL_HEADER_SIZE; i++)
+	{	if(!memcmp(header + i, "COLOR=", 6))
+		{	record_body.is_materialise	= TRUE;
+			break;
+		}
+	}
+	record_body.is_color		= is_color;
+	record_body.default_color	= gp_node_face_s().color;
+	record_body.position_array	= position_list.data();
+
+	for(block_start=0; block_start<face_count; block_start+=block_size)
+	{	block_size					= std::min<unsigned int>(face_count - block_start, STL_BLOCK_SIZE);
+		record_body.record_array	= file_map.data + STL_HEADER_SIZE + 4 + (size_t)block_start * STL_RECORD_SIZE;
+		record_body.face_array		= face_list_out.data() + block_start;
+		if(!parallel_for(block_size, STL_CHUNK_SIZE, record_body, parallel_progress_s()))
+		{	LOG_ERROR_MSG(plugin_index, _T("A vertex position is not a finite number."));
+			return FALSE;
+		}
+		if(!geo_stream_weld_add(weld, position_list.data(), block_size, face_list_out.data() + block_start))
+		{	LOG_ERROR_MSG(plugin_index, _T("Memory Allocation Error: Failed to weld the vertices."));
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+// Read the faces of an ASCII STL file and weld their corners. Each solid is a subset. Returns FALSE and logs an error
+// on failure.
+BOOL read_ascii_stl(unsigned int plugin_index, const geo_file_map_s& file_map, std::vector<gp_node_face_s>& face_list_out, unsigned int& subset_count_out, geo_stream_weld_s& weld)
+{
+	// Local data
+	std::vector<float>							position_list;
+	const char*									pointer;
+	const char*									end;
+	const char*									line_end;
+	unsigned int								corner_count, block_start, subset;
+	BOOL										is_solid_face;
+	float										position;
+
+
+	subset_count_out	= 0;
+	subset				= 0;
+	is_solid_face		= FALSE;
+	corner_count		= 0;
+	block_start			= 0;
+	pointer				= (const char*)file_map.data;
+	end					= pointer + file_map.size;
+	try
+	{	position_list.reserve((size_t)std::min<unsigned long long>(file_map.size / STL_ASCII_FACET_SIZE + 1, STL_BLOCK_SIZE) * 9);
+		for(; pointer<end; pointer=line_end+1)
+		{	line_end = geo_text_get_line_end(pointer, end);
+			geo_text_skip_space(pointer, line_end);
+
+			// A solid is a new subset once it has a face.
+			if(geo_text_is_keyword(pointer, line_end, "solid"))
+			{	if(is_solid_face)
+				{	subset++;
+				}
+				is_solid_face = FALSE;
+			}
+			else if(geo_text_is_keyword(pointer, line_end, "vertex"))
+			{	if(corner_count == 3)
+				{	LOG_ERROR_MSG(plugin_index, _T("A facet has more than 3 vertices."));
+					return FALSE;
+				}
+				geo_text_skip_word(pointer, line_end);
+				for(unsigned int i=0; i<3; i++)
+				{	if(!geo_text_parse_float(pointer, line_end, position))
+					{	LOG_ERROR_MSG(plugin_index, _T("A vertex position is not 3 numbers."));
+						return FALSE;
+					}
+					position_list.push_back(position);
+					geo_text_skip_space(pointer, line_end);
+				}
+				corner_count++;
+			}
+			else if(geo_text_is_keyword(pointer, line_end, "endloop"))
+			{	if(corner_count != 3)
+				{	LOG_ERROR_MSG(plugin_index, _T("A facet does not have 3 vertices."));
+					return FALSE;
+				}
+				face_list_out.push_back(gp_node_face_s(0, 0, 0, subset, gp_node_face_s().color));
+				subset_count_out	= subset + 1;
+				is_solid_face		= TRUE;
+				corner_count		= 0;
+
+				// Weld each full block.
+				if(face_list_out.size() - block_start == STL_BLOCK_SIZE)
+				{	if(!geo_stream_weld_add(weld, position_list.data(), STL_BLOCK_SIZE, face_list_out.data() + block_start))
+					{	LOG_ERROR_MSG(plugin_index, _T("Memory Allocation Error: Failed to weld the vertices."));
+						return FALSE;
+					}
+					position_list.clear();
+					block_start = (unsigned int)face_list_out.size();
+				}
+			}
+			if(face_list_out.size() >= UINT_MAX / 3)
+			{	LOG_ERROR_MSG(plugin_index, _T("The file has too many faces."));
+				return FALSE;
+			}
+		}
+	}
+	catch(...)
+	{	LOG_ERROR_MSG(plugin_index, _T("Memory Allocation Error: Failed to allocate the face list."));
+		return FALSE;
+	}
+
+	if(face_list_out.size() > block_start && !geo_stream_weld_add(weld, position_list.data(), (unsigned int)face_list_out.size() - block_start, face_list_out.data() + block_start))
+	{	LOG_ERROR_MSG(plugin_index, _T("Memory Allocation Error: Failed to weld the vertices."));
+		return FALSE;
+	}
+	return TRUE;
+}
+
+
+// ------------------------------------------------------------------
+// ------------------------------------------------------------------
+// Local functions called during init, process, and shutdown
+
+// Initialize plugin - called when plugin is attached to ShaderMap.
+BOOL on_initialize(void)
+{
+	// Local data
+	const wchar_t*	ext_array[] = {_T("stl")};
+
+
+	// Tell ShaderMap we are starting initialization.
+	gp_begin_initialize();
+
+		// Set file format name and extension list.
+#ifdef _DEBUG
+		gp_set_file_info(_T("Stereolithography STL - DEBUG"), ext_array, 1);
+#else
+		gp_set_file_info(_T("Stereolithography STL"), ext_array, 1);
+#endif
+
+	// Tell ShaderMap initialization is done.
+	gp_end_initialize();
+
+	return TRUE;
+}
+
+// Process plugin - called when plugin is asked by ShaderMap to import a 3D Model (geometry).
+BOOL on_process(unsigned int plugin_index, const wchar_t* file_path)
+{
+	// Local data
+	geo_file_map_s								file_map;
+	unsigned int								geometry_type, face_count, subset_count;
+	BOOL										is_success, is_binary;
+	geo_stream_weld_s							weld;
+	std::vector<gp_node_vertex_s>				vertex_list;
+	std::vector<gp_node_face_s>					face_list;
+	gp_node_uv_data_s							node_uv_data;
+	geo_mesh_s									render_mesh;
+
+
+	// Get geometry type. This can be of type render or of type node.
+	geometry_type = gp_get_geometry_type();
+
+	// Set return value
+	is_success	= TRUE;
+
+	// Map the file into memory. See "geo_file_map.cpp".
+	if(!geo_file_map_open(file_path, file_map))
+	{	LOG_ERROR_MSG(plugin_index, _T("Failed to open file at file_path."));
+		return FALSE;
+	}
+
+	// -----------------
+
+	// A binary file is the header, a face count and that many records. ASCII files start with "solid", but so do
+	// the headers of some binary files, so the size decides.
+	face_count	= 0;
+	is_binary	= FALSE;
+	if(file_map.size >= STL_HEADER_SIZE + 4)
+	{	memcpy(&face_count, file_map.data + STL_HEADER_SIZE, sizeof(face_count));
+		is_binary = file_map.size == STL_HEADER_SIZE + 4 + (unsigned long long)face_count * STL_RECORD_SIZE ||
+					(file_map.size > STL_HEADER_SIZE + 4 + (unsigned long long)face_count * STL_RECORD_SIZE && memcmp(file_map.data, "solid", 5));
+	}
+	if(is_binary && face_count >= UINT_MAX / 3)
+	{	LOG_ERROR_MSG(plugin_index, _T("The file has too many faces."));
+		is_success = FALSE;
+		goto ON_PROCESS_CLEANUP;
+	}
+	if(!is_binary && (file_map.size < 5 || memcmp(file_map.data, "solid", 5)))
+	{	LOG_ERROR_MSG(plugin_index, _T("The file is not a binary or ASCII STL file."));
+		is_success = FALSE;
+		goto ON_PROCESS_CLEANUP;
+	}
+
+	// Read the faces a block at a time and weld their corners.
+	subset_count = 1;
+	if(is_binary)
+	{	is_success = read_binary_stl(plugin_index, file_map, face_count, geometry_type == GP_GEOMETRY_TYPE_NODE && gp_is_option_material_color_from_file(), face_list, weld);
+	}
+	else
+	{	is_success = read_ascii_stl(plugin_index, file_map, face_list, subset_count, weld);
+	}
+	if(!is_success)
+	{	goto ON_PROCESS_CLEANUP;
+	}
+	if(face_list.empty())
+	{	LOG_ERROR_MSG(plugin_index, _T("The file has no faces."));
+		is_success = FALSE;
+		goto ON_PROCESS_CLEANUP;
+	}
+	if(!geo_stream_weld_end(weld, face_list.data(), (unsigned int)face_list.size(), vertex_list))
+	{	LOG_ERROR_MSG(plugin_index, _T("Memory Allocation Error: Failed to allocate the vertex list."));
+		is_success = FALSE;
+		goto ON_PROCESS_CLEANUP;
+	}
+	// Make smooth normals from the faces.
+	if(!geo_create_node_normals(vertex_list.data(), (unsigned int)vertex_list.size(), face_list.data(), (unsigned int)face_list.size()))
+	{	LOG_ERROR_MSG(plugin_index, _T("Memory Allocation Error: Failed to create the normals."));
+		is_success = FALSE;
+		goto ON_PROCESS_CLEANUP;
+	}
+
+	// STL has no texture coordinates.
+	gp_flag_no_uv_geometry();
+
+	// -----------------
+
+	// GP_GEOMETRY_TYPE_RENDER
+	// This format for geometry is used for 3d models in the material visualizer.
+	if(geometry_type == GP_GEOMETRY_TYPE_RENDER)
+	{
+		// The vertices are already welded, each node vertex is a render vertex. See "geo_mesh_build.cpp".
+		try
+		{	render_mesh.vertex_list.resize(vertex_list.size());
+			for(size_t i=0; i<vertex_list.size(); i++)
+			{	const gp_node_vertex_s& vertex = vertex_list[i];
+				render_mesh.vertex_list[i] = gp_render_vertex_s(vertex.x, vertex.y, vertex.z, vertex.nx, vertex.ny, vertex.nz, 0.0f, 0.0f);
+			}
+			std::vector<gp_node_vertex_s>().swap(vertex_list);
+			render_mesh.face_list.resize(face_list.size());
+			for(size_t i=0; i<face_list.size(); i++)
+			{	render_mesh.face_list[i] = gp_render_face_s(face_list[i].a, face_list[i].b, face_list[i].c, face_list[i].subset_index);
+			}
+			std::vector<gp_node_face_s>().swap(face_list);
+		}
+		catch(...)
+		{	LOG_ERROR_MSG(plugin_index, _T("Memory Allocation Error: Failed to allocate the render geometry lists."));
+			is_success = FALSE;
+			goto ON_PROCESS_CLEANUP;
+		}
+		if(!geo_mesh_optimize(render_mesh))
+		{	LOG_ERROR_MSG(plugin_index, _T("Memory Allocation Error: Failed to optimize the render geometry."));
+			is_success = FALSE;
+			goto ON_PROCESS_CLEANUP;
+		}
+
+		// Send the render lists to ShaderMap. No additional UV arrays.
+		if(!gp_create_render_geometry(render_mesh.vertex_list.data(), (unsigned int)render_mesh.vertex_list.size(), render_mesh.face_list.data(), (unsigned int)render_mesh.face_list.size(),
+									  subset_count, FALSE, 0, 0))
+		{	LOG_ERROR_MSG(plugin_index, _T("Failed to create render geometry with gp_create_render_geometry."));
+			is_success = FALSE;
+			goto ON_PROCESS_CLEANUP;
+		}
+	}
+	// GP_GEOMETRY_TYPE_NODE
+	// This format for geometry is used for 3d model nodes in the project grid.
+	else if(geometry_type == GP_GEOMETRY_TYPE_NODE)
+	{
+		// Each solid is a material id.
+		for(unsigned int i=0; i<subset_count; i++)
+		{	gp_define_node_material_id(1, &i);
+		}
+
+		// Send the node lists to ShaderMap. There are no uv channels.
+		if(!gp_create_node_geometry(vertex_list.data(), (unsigned int)vertex_list.size(), face_list.data(), (unsigned int)face_list.size(), &node_uv_data, subset_count, FALSE))
+		{	LOG_ERROR_MSG(plugin_index, _T("Failed to create node geometry with gp_create_node_geometry."));
+			is_success = FALSE;
+			goto ON_PROCESS_CLEANUP;
+		}
+	}
+
+ON_PROCESS_CLEANUP:
+
+	// Unmap the file.
+	geo_file_map_close(file_map);
+
+	return is_success;
+}
+
+// Free any local plugin resources allocated - called by ShaderMap before detaching from the plugin.
+BOOL on_shutdown(void)
+{
+	// Stop the threads that weld the files.
+	parallel_shutdown();
+
+	return TRUE;
+}
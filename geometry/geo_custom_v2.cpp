@@ -0,0 +1,1112 @@
+/*
+	===============================================================
+
+	SHADERMAP GEOMETRY CUSTOM VERSION 2 SOURCE FILE
+
+	Reads and writes version 2 of the CUSTOM model format used by
+	the geo_custom example (see "geometry/examples/geo_custom").
+
+	Version 1 is a raw dump of floats and indices with no magic,
+	version, subsets, uv channels after the first or triangle
+	colors. Version 2 is a versioned container that is about 4 to
+	8 times smaller and decodes on all cores:
+
+	* Positions and uvs are quantized to a grid over their bounds,
+	  normals to an octahedral map. The number of bits of each is
+	  stored in the header.
+
+	* Vertices, uvs and faces are split into chunks of up to
+	  GEO_CV2_CHUNK_SIZE elements. Each chunk is coded on its own
+	  so chunks are encoded and decoded in parallel on the plugin
+	  thread pool (see "common/plugin_thread_pool.cpp").
+
+	* In a chunk each value is stored as the difference from the
+	  value before it, written as a variable length integer, and
+	  each stream of those bytes is entropy coded with an order 0
+	  rANS coder (Duda - "Asymmetric numeral systems", 2013).
+	  Streams of one repeated byte, such as the subsets of a mesh
+	  with one subset, are stored as that byte. UV indices can be
+	  coded as the difference from the vertex indices, which is
+	  all zeros for the many meshes that index both the same.
+
+	* A subset table gives the material id of each subset, for
+	  gp_define_node_material_id(). Faces are sorted by subset.
+
+	* Faces can have a color for gp_node_face_s::color.
+
+	* The header, the tables and each chunk have a checksum.
+
+	Include this source code file after the geometry plugin core
+	file. #include "../../geo_custom_v2.cpp"
+
+	--
+
+	File layout, all values little endian:
+
+	geo_cv2_header_s
+	geo_cv2_uv_channel_s * uv_channel_count
+	unsigned int * subset_count				// Material id of each subset.
+	geo_cv2_chunk_s * chunk_count			// Vertex chunks, then uv chunks by channel, then face chunks, in order.
+	chunk data
+
+	Streams of each chunk type:
+
+	VERTEX		position x y z, normal u v
+	UV			uv u v
+	FACE		vertex index a b c, uv index a b c of each channel
+				after its GEO_CV2_UV_INDEX_ mode, subset, color if
+				GEO_CV2_FLAG_COLOR is set
+
+	Each stream is its size, coded size and GEO_CV2_STREAM_ mode
+	followed by the coded bytes.
+
+	--
+
+	Example:
+
+	geo_cv2_mesh_s		mesh;
+	const wchar_t*		error;
+
+	if(geo_cv2_is_file(file_map.data, file_map.size))
+	{	if(!geo_cv2_decode(file_map.data, file_map.size, mesh, parallel_progress_s(), error))
+		{	LOG_ERROR_MSG(plugin_index, error);
+			...
+		}
+	}
+
+	Call parallel_shutdown() from on_shutdown().
+
+
+	SHADERMAP SDK LICENSE
+
+	The ShaderMap SDK is released under The MIT License (MIT)
+	http://opensource.org/licenses/MIT
+
+	Copyright (c) 2007-2019 Rendering Systems Inc.
+
+	Permission is hereby granted, free of charge, to any person
+	obtaining a copy of this software and associated documentation
+	files (the "Software"), to deal	in the Software without
+	restriction, including without limitation the rights to use,
+	copy, modify, merge, publish, distribute, sublicense, and/or
+	sell copies of the Software, and to permit persons to whom the
+	Software is	furnished to do so, subject to the following
+	conditions:
+
+	The above copyright notice and this permission notice shall be
+	included in	all copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+	OF MERCHANTABILITY,	FITNESS FOR A PARTICULAR PURPOSE AND
+	NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+	OTHER DEALINGS IN THE SOFTWARE.
+
+	Developed by: Neil Kemp at Rendering Systems Inc.
+
+	Online:		http://shadermap.com
+	Corporate:	http://renderingsystems.com
+
+	===============================================================
+*/
+
+#ifndef GEO_CUSTOM_V2_CPP
+#define GEO_CUSTOM_V2_CPP
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Custom version 2 includes
+
+#include "../common/plugin_thread_pool.cpp"
+#include <float.h>
+#include <limits.h>
+#include <math.h>
+#include <stddef.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Custom version 2 defines
+
+// The first 8 bytes of a version 2 file and its version.
+#define GEO_CV2_MAGIC							"SMCUSTOM"
+#define GEO_CV2_VERSION							2
+
+// Header flags.
+#define GEO_CV2_FLAG_COLOR						0x1				// Faces have a color stream.
+
+// Stream modes.
+#define GEO_CV2_STREAM_RAW						0				// The bytes as they are.
+#define GEO_CV2_STREAM_RUN						1				// One byte repeated.
+#define GEO_CV2_STREAM_RANS						2				// rANS coded bytes.
+
+// UV index modes of a face chunk, the first value of each uv index stream.
+#define GEO_CV2_UV_INDEX_DELTA					0				// Coded like vertex indices.
+#define GEO_CV2_UV_INDEX_VERTEX					1				// Difference from the vertex index of the corner.
+
+// Chunk types.
+#define GEO_CV2_CHUNK_VERTEX					0
+#define GEO_CV2_CHUNK_UV						1
+#define GEO_CV2_CHUNK_FACE						2
+
+// Elements in each chunk written. Chunks read can be smaller.
+#define GEO_CV2_CHUNK_SIZE						65536
+
+// Most uv channels in a file.
+#define GEO_CV2_MAX_UV_CHANNELS					8
+
+// Default quantization bits.
+#define GEO_CV2_POSITION_BITS					20
+#define GEO_CV2_NORMAL_BITS						16
+#define GEO_CV2_UV_BITS							20
+
+// Most quantization bits of any value.
+#define GEO_CV2_MAX_BITS						24
+
+// rANS coder - symbol frequencies sum to 1 << GEO_CV2_PROB_BITS, the state is kept in [GEO_CV2_RANS_L, GEO_CV2_RANS_L << 8).
+#define GEO_CV2_PROB_BITS						12
+#define GEO_CV2_PROB_SCALE						(1u << GEO_CV2_PROB_BITS)
+#define GEO_CV2_RANS_L							(1u << 23)
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Custom version 2 structs
+
+// File header.
+struct geo_cv2_header_s
+{
+	char										magic[8];				// GEO_CV2_MAGIC
+	unsigned int								version;				// GEO_CV2_VERSION
+	unsigned int								flags;					// GEO_CV2_FLAG_
+	unsigned int								vertex_count;
+	unsigned int								face_count;
+	unsigned int								uv_channel_count;
+	unsigned int								subset_count;
+	unsigned int								chunk_count;
+	unsigned int								position_bits;
+	unsigned int								normal_bits;
+	unsigned int								uv_bits;
+	float										position_min[3];		// Position = position_min + quantized * position_step
+	float										position_step[3];
+	unsigned int								table_checksum;			// Checksum of the uv channel, subset and chunk tables.
+	unsigned int								header_checksum;		// Checksum of the header up to this field.
+};
+
+// A uv channel of the uv channel table.
+struct geo_cv2_uv_channel_s
+{
+	unsigned int								uv_count;
+	float										uv_min[2];				// UV = uv_min + quantized * uv_step
+	float										uv_step[2];
+};
+
+// A chunk of the chunk table.
+struct geo_cv2_chunk_s
+{
+	unsigned int								type;					// GEO_CV2_CHUNK_
+	unsigned int								channel;				// UV channel of a GEO_CV2_CHUNK_UV chunk, else 0.
+	unsigned int								first;					// First element of the chunk.
+	unsigned int								count;					// Elements in the chunk.
+	unsigned long long							offset;					// Offset of the chunk data in the file.
+	unsigned int								size;					// Bytes of chunk data.
+	unsigned int								checksum;				// Checksum of the chunk data.
+};
+
+// A mesh read from or written to a version 2 file.
+struct geo_cv2_mesh_s
+{
+	std::vector<gp_node_vertex_s>				vertex_list;
+	std::vector<gp_node_face_s>					face_list;				// Sorted by subset.
+	std::vector<std::vector<gp_node_uv_s> >		uv_channel_list;
+	std::vector<std::vector<unsigned int> >		uv_index_list;			// 3 per face per channel.
+	std::vector<unsigned int>					subset_material_list;	// Material id of each subset.
+	BOOL										is_color;				// Faces have colors.
+
+	// c()
+	geo_cv2_mesh_s(void)
+	{	is_color = FALSE;
+	}
+};
+
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Custom version 2 value coding
+
+// Return the checksum of size bytes.
+unsigned int geo_cv2_checksum(const void* data, size_t size)
+{
+	// Local data
+	const unsigned char*						byte_array;
+	unsigned long long							hash, word;
+	size_t										i;
+
+
+	byte_array	= (const unsigned char*)data;
+	hash		= 0x27D4EB2F165667C5ull ^ size;
+	for(i=0; i+8<=size; i+=8)
+	{	memcpy(&word, byte_array + i, 8);
+		hash ^= word * 0xC2B2AE3D27D4EB4Full;
+		hash = ((hash << 31) | (hash >> 33)) * 0x9E3779B97F4A7C15ull;
+	}
+	for(; i<size; i++)
+	{	hash = (hash ^ byte_array[i]) * 0x100000001B3ull;
+	}
+	hash ^= hash >> 33;
+	hash *= 0xFF51AFD7ED558CCDull;
+	hash ^= hash >> 33;
+	return (unsigned int)hash;
+}
+
+// Map a signed difference to an unsigned value with small magnitudes first, and back.
+inline unsigned int geo_cv2_zigzag(unsigned int value)
+{
+	return (value << 1) ^ (0u - (value >> 31));
+}
+
+inline unsigned int geo_cv2_unzigzag(unsigned int value)
+{
+	return (value >> 1) ^ (0u - (value & 1));
+}
+
+// Append a variable length integer, 7 bits per byte.
+inline void geo_cv2_write_varint(std::vector<unsigned char>& stream, unsigned int value)
+{
+	while(value >= 0x80)
+	{	stream.push_back((unsigned char)(value | 0x80));
+		value >>= 7;
+	}
+	stream.push_back((unsigned char)value);
+}
+
+// Read a variable length integer. Returns FALSE at the end of the stream or if the value is too long.
+inline BOOL geo_cv2_read_varint(const unsigned char*& pointer, const unsigned char* end, unsigned int& value_out)
+{
+	// Local data
+	unsigned int								shift;
+
+
+	if(pointer < end && *pointer < 0x80)
+	{	value_out = *pointer++;
+		return TRUE;
+	}
+	value_out = 0;
+	for(shift=0; shift<35; shift+=7)
+	{	if(pointer >= end)
+		{	return FALSE;
+		}
+		value_out |= (unsigned int)(*pointer & 0x7F) << shift;
+		if(!(*pointer++ & 0x80))
+		{	return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+// Append a 32 bit value.
+inline void geo_cv2_write_uint(std::vector<unsigned char>& data, unsigned int value)
+{
+	for(unsigned int i=0; i<4; i++)
+	{	data.push_back((unsigned char)(value >> (i * 8)));
+	}
+}
+
+// Read a 32 bit value. Returns FALSE at the end of the data.
+inline BOOL geo_cv2_read_uint(const unsigned char*& pointer, const unsigned char* end, unsigned int& value_out)
+{
+	if(end - pointer < 4)
+	{	return FALSE;
+	}
+	value_out	= (unsigned int)pointer[0] | ((unsigned int)pointer[1] << 8) | ((unsigned int)pointer[2] << 16) | ((unsigned int)pointer[3] << 24);
+	pointer		+= 4;
+	return TRUE;
+}
+
+// Quantize value to bits on the grid min + quantized * step.
+inline unsigned int geo_cv2_quantize(float value, float min, float step, unsigned int bits)
+{
+	// Local data
+	double										quantized;
+
+
+	quantized = step > 0.0f ? floor(((double)value - min) / step + 0.5) : 0.0;
+	return (unsigned int)std::max<double>(0.0, std::min<double>((double)((1u << bits) - 1), quantized));
+}
+
+// Return the min and step of the quantization grid of values from min to max.
+inline void geo_cv2_get_grid(float min, float max, unsigned int bits, float& min_out, float& step_out)
+{
+	min_out		= min;
+	step_out	= (float)(((double)max - min) / ((1u << bits) - 1));
+}
+
+// Quantize a unit normal to bits per component of an octahedral map.
+inline void geo_cv2_encode_normal(float x, float y, float z, unsigned int bits, unsigned int& u_out, unsigned int& v_out)
+{
+	// Local data
+	float										length, u, v;
+
+
+	length = fabsf(x) + fabsf(y) + fabsf(z);
+	if(!(length > 0.0f))
+	{	x = 0.0f; y = 0.0f; z = 1.0f; length = 1.0f;
+	}
+	u = x / length;
+	v = y / length;
+	if(z < 0.0f)
+	{	float fold_u = (1.0f - fabsf(v)) * (u < 0.0f ? -1.0f : 1.0f);
+		v = (1.0f - fabsf(u)) * (v < 0.0f ? -1.0f : 1.0f);
+		u = fold_u;
+	}
+	u_out = geo_cv2_quantize(u, -1.0f, 2.0f / ((1u << bits) - 1), bits);
+	v_out = geo_cv2_quantize(v, -1.0f, 2.0f / ((1u << bits) - 1), bits);
+}
+
+// Return the unit normal of a quantized octahedral map value.
+inline void geo_cv2_decode_normal(unsigned int u, unsigned int v, unsigned int bits, gp_node_vertex_s& vertex)
+{
+	// Local data
+	float										x, y, z, length;
+
+
+	x = -1.0f + u * (2.0f / ((1u << bits) - 1));
+	y = -1.0f + v * (2.0f / ((1u << bits) - 1));
+	z = 1.0f - fabsf(x) - fabsf(y);
+	if(z < 0.0f)
+	{	float fold_x = (1.0f - fabsf(y)) * (x < 0.0f ? -1.0f : 1.0f);
+		y = (1.0f - fabsf(x)) * (y < 0.0f ? -1.0f : 1.0f);
+		x = fold_x;
+	}
+	length		= 1.0f / sqrtf(x * x + y * y + z * z);
+	vertex.nx	= x * length;
+	vertex.ny	= y * length;
+	vertex.nz	= z * length;
+}
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Custom version 2 streams
+
+// Append a byte stream: its size, coded size and GEO_CV2_STREAM_ mode, then the coded bytes. A stream of one repeated
+// byte is stored as that byte, other streams are rANS coded if that makes them at least 1/16 smaller, else stored raw.
+void geo_cv2_write_stream(std::vector<unsigned char>& data, const std::vector<unsigned char>& stream)
+{
+	// Local data
+	unsigned int								count_array[256], frequency_array[256], start_array[256];
+	unsigned int								i, sum, largest, state_array[2], state_max;
+	std::vector<unsigned char>					table, code;
+	unsigned char*								pointer;
+	size_t										coded_size;
+
+
+	// Scale the symbol counts to frequencies that sum to GEO_CV2_PROB_SCALE, no used symbol below 1.
+	memset(count_array, 0, sizeof(count_array));
+	for(i=0; i<stream.size(); i++)
+	{	count_array[stream[i]]++;
+	}
+	geo_cv2_write_uint(data, (unsigned int)stream.size());
+	if(stream.empty() || count_array[stream[0]] == stream.size())
+	{	geo_cv2_write_uint(data, stream.empty() ? 0 : 1);
+		data.push_back(GEO_CV2_STREAM_RUN);
+		data.insert(data.end(), stream.begin(), stream.begin() + (stream.empty() ? 0 : 1));
+		return;
+	}
+	sum		= 0;
+	largest	= 0;
+	for(i=0; i<256; i++)
+	{	frequency_array[i] = count_array[i] ? std::max<unsigned int>(1, (unsigned int)((unsigned long long)count_array[i] * GEO_CV2_PROB_SCALE / stream.size())) : 0;
+		sum += frequency_array[i];
+		if(frequency_array[i] > frequency_array[largest])
+		{	largest = i;
+		}
+	}
+	while(sum > GEO_CV2_PROB_SCALE)
+	{	for(largest=0, i=1; i<256; i++)
+		{	if(frequency_array[i] > frequency_array[largest])
+			{	largest = i;
+			}
+		}
+		frequency_array[largest]--;
+		sum--;
+	}
+	frequency_array[largest] += GEO_CV2_PROB_SCALE - sum;
+
+	// Code the stream backwards so that it decodes forwards. Even and odd bytes are coded with 2 states so that the
+	// decoder can work on both at once.
+	for(sum=0, i=0; i<256; i++)
+	{	start_array[i] = sum;
+		sum += frequency_array[i];
+		geo_cv2_write_varint(table, frequency_array[i]);
+	}
+	code.resize(stream.size() * 2 + 16);
+	pointer			= code.data() + code.size();
+	state_array[0]	= GEO_CV2_RANS_L;
+	state_array[1]	= GEO_CV2_RANS_L;
+	for(size_t j=stream.size(); j-->0; )
+	{	unsigned int	frequency	= frequency_array[stream[j]];
+		unsigned int&	state		= state_array[j & 1];
+		state_max = ((GEO_CV2_RANS_L >> GEO_CV2_PROB_BITS) << 8) * frequency;
+		while(state >= state_max)
+		{	*--pointer = (unsigned char)state;
+			state >>= 8;
+		}
+		state = ((state / frequency) << GEO_CV2_PROB_BITS) + (state % frequency) + start_array[stream[j]];
+	}
+	for(i=2; i-->0; )
+	{	pointer -= 4;
+		pointer[0] = (unsigned char)state_array[i]; pointer[1] = (unsigned char)(state_array[i] >> 8);
+		pointer[2] = (unsigned char)(state_array[i] >> 16); pointer[3] = (unsigned char)(state_array[i] >> 24);
+	}
+	coded_size = table.size() + (size_t)(code.data() + code.size() - pointer);
+
+	// Raw bytes decode faster when coding saves little.
+	if(coded_size > stream.size() - stream.size() / 16)
+	{	geo_cv2_write_uint(data, (unsigned int)stream.size());
+		data.push_back(GEO_CV2_STREAM_RAW);
+		data.insert(data.end(), stream.begin(), stream.end());
+		return;
+	}
+	geo_cv2_write_uint(data, (unsigned int)coded_size);
+	data.push_back(GEO_CV2_STREAM_RANS);
+	data.insert(data.end(), table.begin(), table.end());
+	data.insert(data.end(), pointer, code.data() + code.size());
+}
+
+// Read a byte stream written by geo_cv2_write_stream(). stream_out and stream_end_out are set to the bytes of the stream,
+// in the file for a raw stream, else in buffer. Returns FALSE if the stream is not valid or is larger than max_size.
+BOOL geo_cv2_read_stream(const unsigned char*& pointer, const unsigned char* end, size_t max_size, std::vector<unsigned char>& buffer,
+						 const unsigned char*& stream_out, const unsigned char*& stream_end_out)
+{
+	// Local data
+	unsigned int								raw_size, coded_size, mode, i, sum, frequency, state_array[2];
+	unsigned int								slot_array[GEO_CV2_PROB_SCALE];
+	const unsigned char*						code_end;
+	unsigned char*								stream;
+
+
+	if(!geo_cv2_read_uint(pointer, end, raw_size) || !geo_cv2_read_uint(pointer, end, coded_size) || pointer == end ||
+	   raw_size > max_size || coded_size > raw_size || coded_size > (size_t)(end - pointer - 1))
+	{	return FALSE;
+	}
+	mode		= *pointer++;
+	code_end	= pointer + coded_size;
+
+	// Raw bytes are read where they are.
+	if(mode == GEO_CV2_STREAM_RAW)
+	{	if(coded_size != raw_size)
+		{	return FALSE;
+		}
+		stream_out		= pointer;
+		stream_end_out	= code_end;
+		pointer			= code_end;
+		return TRUE;
+	}
+
+	buffer.resize(raw_size);
+	stream_out		= buffer.data();
+	stream_end_out	= buffer.data() + raw_size;
+	if(mode == GEO_CV2_STREAM_RUN)
+	{	if(coded_size != (raw_size ? 1u : 0u))
+		{	return FALSE;
+		}
+		if(raw_size)
+		{	memset(buffer.data(), *pointer, raw_size);
+		}
+		pointer = code_end;
+		return TRUE;
+	}
+	if(mode != GEO_CV2_STREAM_RANS)
+	{	return FALSE;
+	}
+
+	// Frequencies, then for each slot its symbol, the symbol frequency - 1 and the slot offset in the symbol range.
+	for(sum=0, i=0; i<256; i++)
+	{	if(!geo_cv2_read_varint(pointer, code_end, frequency) || frequency > GEO_CV2_PROB_SCALE - sum)
+		{	return FALSE;
+		}
+		for(unsigned int j=0; j<frequency; j++)
+		{	slot_array[sum + j] = i | (j << 8) | ((frequency - 1) << 20);
+		}
+		sum += frequency;
+	}
+	if(sum != GEO_CV2_PROB_SCALE || !geo_cv2_read_uint(pointer, code_end, state_array[0]) || !geo_cv2_read_uint(pointer, code_end, state_array[1]))
+	{	return FALSE;
+	}
+
+	stream = buffer.data();
+	for(i=0; i<raw_size; i++)
+	{	unsigned int&	state	= state_array[i & 1];
+		unsigned int	slot	= slot_array[state & (GEO_CV2_PROB_SCALE - 1)];
+		stream[i]	= (unsigned char)slot;
+		state		= ((slot >> 20) + 1) * (state >> GEO_CV2_PROB_BITS) + ((slot >> 8) & (GEO_CV2_PROB_SCALE - 1));
+		while(state < GEO_CV2_RANS_L)
+		{	if(pointer >= code_end)
+			{	return FALSE;
+			}
+			state = (state << 8) | *pointer++;
+		}
+	}
+	pointer = code_end;
+	return TRUE;
+}
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Custom version 2 chunks
+
+// Encode each chunk of a mesh.
+struct geo_cv2_encode_body_s
+{
+	const geo_cv2_mesh_s*						mesh;
+	const geo_cv2_header_s*						header;
+	const geo_cv2_uv_channel_s*					uv_channel_array;
+	const geo_cv2_chunk_s*						chunk_array;
+	std::vector<unsigned char>*					chunk_data_array;
+
+	BOOL operator()(unsigned int chunk_start, unsigned int chunk_end) const
+	{	std::vector<unsigned char> stream_array[3 + GEO_CV2_MAX_UV_CHANNELS], vertex_stream, delta_code, vertex_code;
+		for(unsigned int i=chunk_start; i<chunk_end; i++)
+		{	const geo_cv2_chunk_s&	chunk			= chunk_array[i];
+			unsigned int			stream_count	= 0;
+			for(unsigned int j=0; j<3+GEO_CV2_MAX_UV_CHANNELS; j++)
+			{	stream_array[j].clear();
+			}
+
+			if(chunk.type == GEO_CV2_CHUNK_VERTEX)
+			{	unsigned int previous_array[5] = {0, 0, 0, 0, 0}, value_array[5];
+				for(unsigned int j=chunk.first; j<chunk.first+chunk.count; j++)
+				{	const gp_node_vertex_s& vertex = mesh->vertex_list[j];
+					value_array[0] = geo_cv2_quantize(vertex.x, header->position_min[0], header->position_step[0], header->position_bits);
+					value_array[1] = geo_cv2_quantize(vertex.y, header->position_min[1], header->position_step[1], header->position_bits);
+					value_array[2] = geo_cv2_quantize(vertex.z, header->position_min[2], header->position_step[2], header->position_bits);
+					geo_cv2_encode_normal(vertex.nx, vertex.ny, vertex.nz, header->normal_bits, value_array[3], value_array[4]);
+					for(unsigned int k=0; k<5; k++)
+					{	geo_cv2_write_varint(stream_array[k < 3 ? 0 : 1], geo_cv2_zigzag(value_array[k] - previous_array[k]));
+						previous_array[k] = value_array[k];
+					}
+				}
+				stream_count = 2;
+			}
+			else if(chunk.type == GEO_CV2_CHUNK_UV)
+			{	const geo_cv2_uv_channel_s& uv_channel = uv_channel_array[chunk.channel];
+				unsigned int previous_array[2] = {0, 0}, value_array[2];
+				for(unsigned int j=chunk.first; j<chunk.first+chunk.count; j++)
+				{	const gp_node_uv_s& uv = mesh->uv_channel_list[chunk.channel][j];
+					value_array[0] = geo_cv2_quantize(uv.u, uv_channel.uv_min[0], uv_channel.uv_step[0], header->uv_bits);
+					value_array[1] = geo_cv2_quantize(uv.v, uv_channel.uv_min[1], uv_channel.uv_step[1], header->uv_bits);
+					for(unsigned int k=0; k<2; k++)
+					{	geo_cv2_write_varint(stream_array[0], geo_cv2_zigzag(value_array[k] - previous_array[k]));
+						previous_array[k] = value_array[k];
+					}
+				}
+				stream_count = 1;
+			}
+			else
+			{	unsigned int previous_array[1 + GEO_CV2_MAX_UV_CHANNELS] = {0}, previous_subset = 0, previous_color = 0;
+				for(unsigned int k=0; k<header->uv_channel_count; k++)
+				{	geo_cv2_write_varint(stream_array[1 + k], GEO_CV2_UV_INDEX_DELTA);
+				}
+				for(unsigned int j=chunk.first; j<chunk.first+chunk.count; j++)
+				{	const gp_node_face_s& face = mesh->face_list[j];
+					geo_cv2_write_varint(stream_array[0], geo_cv2_zigzag(face.a - previous_array[0]));
+					geo_cv2_write_varint(stream_array[0], geo_cv2_zigzag(face.b - face.a));
+					geo_cv2_write_varint(stream_array[0], geo_cv2_zigzag(face.c - face.a));
+					previous_array[0] = face.a;
+					for(unsigned int k=0; k<header->uv_channel_count; k++)
+					{	const unsigned int* uv_index = &mesh->uv_index_list[k][(size_t)j * 3];
+						geo_cv2_write_varint(stream_array[1 + k], geo_cv2_zigzag(uv_index[0] - previous_array[1 + k]));
+						geo_cv2_write_varint(stream_array[1 + k], geo_cv2_zigzag(uv_index[1] - uv_index[0]));
+						geo_cv2_write_varint(stream_array[1 + k], geo_cv2_zigzag(uv_index[2] - uv_index[0]));
+						previous_array[1 + k] = uv_index[0];
+					}
+					geo_cv2_write_varint(stream_array[1 + header->uv_channel_count], face.subset_index - previous_subset);
+					previous_subset = face.subset_index;
+					if(header->flags & GEO_CV2_FLAG_COLOR)
+					{	geo_cv2_write_varint(stream_array[2 + header->uv_channel_count], face.color ^ previous_color);
+						previous_color = face.color;
+					}
+				}
+				stream_count = 2 + header->uv_channel_count + ((header->flags & GEO_CV2_FLAG_COLOR) ? 1 : 0);
+
+				// UV indices often follow the vertex indices, code them as the difference from those if that is smaller.
+				for(unsigned int k=0; k<header->uv_channel_count; k++)
+				{	vertex_stream.clear();
+					geo_cv2_write_varint(vertex_stream, GEO_CV2_UV_INDEX_VERTEX);
+					for(unsigned int j=chunk.first; j<chunk.first+chunk.count; j++)
+					{	const unsigned int* uv_index = &mesh->uv_index_list[k][(size_t)j * 3];
+						geo_cv2_write_varint(vertex_stream, geo_cv2_zigzag(uv_index[0] - mesh->face_list[j].a));
+						geo_cv2_write_varint(vertex_stream, geo_cv2_zigzag(uv_index[1] - mesh->face_list[j].b));
+						geo_cv2_write_varint(vertex_stream, geo_cv2_zigzag(uv_index[2] - mesh->face_list[j].c));
+					}
+					delta_code.clear();
+					vertex_code.clear();
+					geo_cv2_write_stream(delta_code, stream_array[1 + k]);
+					geo_cv2_write_stream(vertex_code, vertex_stream);
+					if(vertex_code.size() < delta_code.size())
+					{	stream_array[1 + k].swap(vertex_stream);
+					}
+				}
+			}
+
+			for(unsigned int j=0; j<stream_count; j++)
+			{	geo_cv2_write_stream(chunk_data_array[i], stream_array[j]);
+			}
+		}
+		return TRUE;
+	}
+};
+
+// Decode each chunk of a file into a mesh and check the values are in range.
+struct geo_cv2_decode_body_s
+{
+	const unsigned char*						data;
+	const geo_cv2_header_s*						header;
+	const geo_cv2_uv_channel_s*					uv_channel_array;
+	const geo_cv2_chunk_s*						chunk_array;
+	geo_cv2_mesh_s*								mesh;
+
+	BOOL operator()(unsigned int chunk_start, unsigned int chunk_end) const
+	{	std::vector<unsigned char> buffer_array[3 + GEO_CV2_MAX_UV_CHANNELS];
+		const unsigned char* pointer_array[3 + GEO_CV2_MAX_UV_CHANNELS];
+		const unsigned char* end_array[3 + GEO_CV2_MAX_UV_CHANNELS];
+		unsigned int uv_index_mode_array[GEO_CV2_MAX_UV_CHANNELS];
+		for(unsigned int i=chunk_start; i<chunk_end; i++)
+		{	const geo_cv2_chunk_s&	chunk			= chunk_array[i];
+			const unsigned char*	pointer			= data + chunk.offset;
+			const unsigned char*	end				= pointer + chunk.size;
+			unsigned int			stream_count, value;
+			if(geo_cv2_checksum(pointer, chunk.size) != chunk.checksum)
+			{	return FALSE;
+			}
+
+			// Each value takes at least a byte and at most 5, the streams can not be larger than that.
+			stream_count = chunk.type == GEO_CV2_CHUNK_VERTEX ? 2 : (chunk.type == GEO_CV2_CHUNK_UV ? 1 :
+						   2 + header->uv_channel_count + ((header->flags & GEO_CV2_FLAG_COLOR) ? 1 : 0));
+			for(unsigned int j=0; j<stream_count; j++)
+			{	if(!geo_cv2_read_stream(pointer, end, (size_t)chunk.count * 15 + 5, buffer_array[j], pointer_array[j], end_array[j]))
+				{	return FALSE;
+				}
+			}
+
+			if(chunk.type == GEO_CV2_CHUNK_VERTEX)
+			{	unsigned int value_array[5] = {0, 0, 0, 0, 0};
+				for(unsigned int j=chunk.first; j<chunk.first+chunk.count; j++)
+				{	gp_node_vertex_s& vertex = mesh->vertex_list[j];
+					for(unsigned int k=0; k<5; k++)
+					{	if(!geo_cv2_read_varint(pointer_array[k < 3 ? 0 : 1], end_array[k < 3 ? 0 : 1], value))
+						{	return FALSE;
+						}
+						value_array[k] += geo_cv2_unzigzag(value);
+					}
+					if(value_array[0] >> header->position_bits || value_array[1] >> header->position_bits || value_array[2] >> header->position_bits ||
+					   value_array[3] >> header->normal_bits || value_array[4] >> header->normal_bits)
+					{	return FALSE;
+					}
+					vertex.x = header->position_min[0] + value_array[0] * header->position_step[0];
+					vertex.y = header->position_min[1] + value_array[1] * header->position_step[1];
+					vertex.z = header->position_min[2] + value_array[2] * header->position_step[2];
+					geo_cv2_decode_normal(value_array[3], value_array[4], header->normal_bits, vertex);
+				}
+			}
+			else if(chunk.type == GEO_CV2_CHUNK_UV)
+			{	const geo_cv2_uv_channel_s& uv_channel = uv_channel_array[chunk.channel];
+				unsigned int value_array[2] = {0, 0};
+				for(unsigned int j=chunk.first; j<chunk.first+chunk.count; j++)
+				{	for(unsigned int k=0; k<2; k++)
+					{	if(!geo_cv2_read_varint(pointer_array[0], end_array[0], value))
+						{	return FALSE;
+						}
+						value_array[k] += geo_cv2_unzigzag(value);
+					}
+					if(value_array[0] >> header->uv_bits || value_array[1] >> header->uv_bits)
+					{	return FALSE;
+					}
+					mesh->uv_channel_list[chunk.channel][j].u = uv_channel.uv_min[0] + value_array[0] * uv_channel.uv_step[0];
+					mesh->uv_channel_list[chunk.channel][j].v = uv_channel.uv_min[1] + value_array[1] * uv_channel.uv_step[1];
+				}
+			}
+			else
+			{	unsigned int previous_array[1 + GEO_CV2_MAX_UV_CHANNELS] = {0}, corner_array[3], subset = 0, color = 0;
+				for(unsigned int k=0; k<header->uv_channel_count; k++)
+				{	if(!geo_cv2_read_varint(pointer_array[1 + k], end_array[1 + k], uv_index_mode_array[k]) || uv_index_mode_array[k] > GEO_CV2_UV_INDEX_VERTEX)
+					{	return FALSE;
+					}
+				}
+				for(unsigned int j=chunk.first; j<chunk.first+chunk.count; j++)
+				{	gp_node_face_s& face = mesh->face_list[j];
+					for(unsigned int k=0; k<1+header->uv_channel_count; k++)
+					{	unsigned int count = k ? uv_channel_array[k - 1].uv_count : header->vertex_count;
+						for(unsigned int l=0; l<3; l++)
+						{	if(!geo_cv2_read_varint(pointer_array[k], end_array[k], value))
+							{	return FALSE;
+							}
+							if(k && uv_index_mode_array[k - 1] == GEO_CV2_UV_INDEX_VERTEX)
+							{	corner_array[l] = (&face.a)[l] + geo_cv2_unzigzag(value);
+							}
+							else
+							{	corner_array[l] = (l ? corner_array[0] : previous_array[k]) + geo_cv2_unzigzag(value);
+							}
+							if(corner_array[l] >= count)
+							{	return FALSE;
+							}
+						}
+						previous_array[k] = corner_array[0];
+						if(k)
+						{	memcpy(&mesh->uv_index_list[k - 1][(size_t)j * 3], corner_array, sizeof(corner_array));
+						}
+						else
+						{	face.a = corner_array[0]; face.b = corner_array[1]; face.c = corner_array[2];
+						}
+					}
+					if(!geo_cv2_read_varint(pointer_array[1 + header->uv_channel_count], end_array[1 + header->uv_channel_count], value) ||
+					   value >= header->subset_count - subset)
+					{	return FALSE;
+					}
+					subset				+= value;
+					face.subset_index	= subset;
+					if(header->flags & GEO_CV2_FLAG_COLOR)
+					{	if(!geo_cv2_read_varint(pointer_array[2 + header->uv_channel_count], end_array[2 + header->uv_channel_count], value))
+						{	return FALSE;
+						}
+						color		^= value;
+						face.color	= color;
+					}
+				}
+			}
+
+			// Every value of the chunk is read.
+			for(unsigned int j=0; j<stream_count; j++)
+			{	if(pointer_array[j] != end_array[j])
+				{	return FALSE;
+				}
+			}
+		}
+		return TRUE;
+	}
+};
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Custom version 2 functions
+
+// Return TRUE if the data starts with the version 2 magic.
+BOOL geo_cv2_is_file(const unsigned char* data, unsigned long long size)
+{
+	return size >= 8 && memcmp(data, GEO_CV2_MAGIC, 8) == 0;
+}
+
+// Encode a mesh as a version 2 file. The faces must be sorted by subset and every index in range. Bits are the
+// quantization bits of positions, normals and uvs, up to GEO_CV2_MAX_BITS. Returns FALSE and sets error_out if the mesh
+// can not be encoded, on allocation failure or if cancelled.
+BOOL geo_cv2_encode(const geo_cv2_mesh_s& mesh, unsigned int position_bits, unsigned int normal_bits, unsigned int uv_bits,
+					std::vector<unsigned char>& file_out, const wchar_t*& error_out)
+{
+	// Local data
+	geo_cv2_header_s							header;
+	std::vector<geo_cv2_uv_channel_s>			uv_channel_list;
+	std::vector<geo_cv2_chunk_s>				chunk_list;
+	std::vector<std::vector<unsigned char> >	chunk_data_list;
+	geo_cv2_encode_body_s						encode_body;
+	float										min_array[3], max_array[3];
+	unsigned long long							offset;
+	size_t										table_offset;
+
+
+	file_out.clear();
+	error_out = 0;
+
+	// Check the mesh.
+	if(mesh.vertex_list.empty() || mesh.face_list.empty() || mesh.subset_material_list.empty() ||
+	   mesh.vertex_list.size() > UINT_MAX || mesh.face_list.size() > UINT_MAX / 3)
+	{	error_out = _T("The mesh has no vertices, faces or subsets, or is too large.");
+		return FALSE;
+	}
+	if(mesh.uv_channel_list.size() > GEO_CV2_MAX_UV_CHANNELS || mesh.uv_index_list.size() != mesh.uv_channel_list.size())
+	{	error_out = _T("The mesh has too many uv channels or a uv channel without indices.");
+		return FALSE;
+	}
+	if(position_bits < 1 || position_bits > GEO_CV2_MAX_BITS || normal_bits < 2 || normal_bits > GEO_CV2_MAX_BITS ||
+	   uv_bits < 1 || uv_bits > GEO_CV2_MAX_BITS)
+	{	error_out = _T("The quantization bits are out of range.");
+		return FALSE;
+	}
+	for(size_t i=0; i<mesh.face_list.size(); i++)
+	{	const gp_node_face_s& face = mesh.face_list[i];
+		if(face.a >= mesh.vertex_list.size() || face.b >= mesh.vertex_list.size() || face.c >= mesh.vertex_list.size() ||
+		   face.subset_index >= mesh.subset_material_list.size() || (i && face.subset_index < mesh.face_list[i - 1].subset_index))
+		{	error_out = _T("A face index is out of range or the faces are not sorted by subset.");
+			return FALSE;
+		}
+	}
+	for(size_t i=0; i<mesh.uv_channel_list.size(); i++)
+	{	if(mesh.uv_channel_list[i].empty() || mesh.uv_channel_list[i].size() > UINT_MAX || mesh.uv_index_list[i].size() != mesh.face_list.size() * 3)
+		{	error_out = _T("A uv channel is empty or does not have 3 indices per face.");
+			return FALSE;
+		}
+		for(size_t j=0; j<mesh.uv_index_list[i].size(); j++)
+		{	if(mesh.uv_index_list[i][j] >= mesh.uv_channel_list[i].size())
+			{	error_out = _T("A uv index is out of range.");
+				return FALSE;
+			}
+		}
+	}
+
+	// Header and the quantization grids. Non finite values can not be quantized.
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, GEO_CV2_MAGIC, 8);
+	header.version			= GEO_CV2_VERSION;
+	header.flags			= mesh.is_color ? GEO_CV2_FLAG_COLOR : 0;
+	header.vertex_count		= (unsigned int)mesh.vertex_list.size();
+	header.face_count		= (unsigned int)mesh.face_list.size();
+	header.uv_channel_count	= (unsigned int)mesh.uv_channel_list.size();
+	header.subset_count		= (unsigned int)mesh.subset_material_list.size();
+	header.position_bits	= position_bits;
+	header.normal_bits		= normal_bits;
+	header.uv_bits			= uv_bits;
+
+	for(unsigned int i=0; i<3; i++)
+	{	min_array[i] = FLT_MAX; max_array[i] = -FLT_MAX;
+	}
+	for(size_t i=0; i<mesh.vertex_list.size(); i++)
+	{	const float* position = &mesh.vertex_list[i].x;
+		for(unsigned int j=0; j<3; j++)
+		{	if(!(fabsf(position[j]) <= FLT_MAX))
+			{	error_out = _T("A vertex position is not finite.");
+				return FALSE;
+			}
+			min_array[j] = std::min(min_array[j], position[j]);
+			max_array[j] = std::max(max_array[j], position[j]);
+		}
+	}
+	for(unsigned int i=0; i<3; i++)
+	{	geo_cv2_get_grid(min_array[i], max_array[i], position_bits, header.position_min[i], header.position_step[i]);
+	}
+
+	try
+	{	uv_channel_list.resize(header.uv_channel_count);
+		for(unsigned int i=0; i<header.uv_channel_count; i++)
+		{	min_array[0] = min_array[1] = FLT_MAX; max_array[0] = max_array[1] = -FLT_MAX;
+			for(size_t j=0; j<mesh.uv_channel_list[i].size(); j++)
+			{	const float* uv = &mesh.uv_channel_list[i][j].u;
+				for(unsigned int k=0; k<2; k++)
+				{	if(!(fabsf(uv[k]) <= FLT_MAX))
+					{	error_out = _T("A uv is not finite.");
+						return FALSE;
+					}
+					min_array[k] = std::min(min_array[k], uv[k]);
+					max_array[k] = std::max(max_array[k], uv[k]);
+				}
+			}
+			uv_channel_list[i].uv_count = (unsigned int)mesh.uv_channel_list[i].size();
+			for(unsigned int k=0; k<2; k++)
+			{	geo_cv2_get_grid(min_array[k], max_array[k], uv_bits, uv_channel_list[i].uv_min[k], uv_channel_list[i].uv_step[k]);
+			}
+		}
+
+		// Chunk table - vertex chunks, uv chunks by channel, then face chunks.
+		for(unsigned int type=GEO_CV2_CHUNK_VERTEX; type<=GEO_CV2_CHUNK_FACE; type++)
+		{	for(unsigned int channel=0; channel<(type == GEO_CV2_CHUNK_UV ? header.uv_channel_count : 1); channel++)
+			{	unsigned int count = type == GEO_CV2_CHUNK_VERTEX ? header.vertex_count : (type == GEO_CV2_CHUNK_UV ? uv_channel_list[channel].uv_count : header.face_count);
+				for(unsigned int first=0; first<count; first+=std::min<unsigned int>(GEO_CV2_CHUNK_SIZE, count - first))
+				{	geo_cv2_chunk_s chunk;
+					memset(&chunk, 0, sizeof(chunk));
+					chunk.type		= type;
+					chunk.channel	= type == GEO_CV2_CHUNK_UV ? channel : 0;
+					chunk.first		= first;
+					chunk.count		= std::min<unsigned int>(GEO_CV2_CHUNK_SIZE, count - first);
+					chunk_list.push_back(chunk);
+				}
+			}
+		}
+		header.chunk_count = (unsigned int)chunk_list.size();
+
+		// Encode the chunks in parallel.
+		chunk_data_list.resize(chunk_list.size());
+		encode_body.mesh				= &mesh;
+		encode_body.header				= &header;
+		encode_body.uv_channel_array	= uv_channel_list.data();
+		encode_body.chunk_array			= chunk_list.data();
+		encode_body.chunk_data_array	= chunk_data_list.data();
+		if(!parallel_for(header.chunk_count, 1, encode_body, parallel_progress_s()))
+		{	error_out = _T("The encode was cancelled.");
+			return FALSE;
+		}
+
+		// Lay out the file.
+		offset = sizeof(header) + uv_channel_list.size() * sizeof(geo_cv2_uv_channel_s) + header.subset_count * sizeof(unsigned int) +
+				 chunk_list.size() * sizeof(geo_cv2_chunk_s);
+		for(size_t i=0; i<chunk_list.size(); i++)
+		{	chunk_list[i].offset	= offset;
+			chunk_list[i].size		= (unsigned int)chunk_data_list[i].size();
+			chunk_list[i].checksum	= geo_cv2_checksum(chunk_data_list[i].data(), chunk_data_list[i].size());
+			offset += chunk_data_list[i].size();
+		}
+		file_out.reserve((size_t)offset);
+		file_out.resize(sizeof(header));
+		table_offset = file_out.size();
+		file_out.insert(file_out.end(), (const unsigned char*)uv_channel_list.data(), (const unsigned char*)(uv_channel_list.data() + uv_channel_list.size()));
+		file_out.insert(file_out.end(), (const unsigned char*)mesh.subset_material_list.data(), (const unsigned char*)(mesh.subset_material_list.data() + header.subset_count));
+		file_out.insert(file_out.end(), (const unsigned char*)chunk_list.data(), (const unsigned char*)(chunk_list.data() + chunk_list.size()));
+		header.table_checksum	= geo_cv2_checksum(file_out.data() + table_offset, file_out.size() - table_offset);
+		header.header_checksum	= geo_cv2_checksum(&header, offsetof(geo_cv2_header_s, header_checksum));
+		memcpy(file_out.data(), &header, sizeof(header));
+		for(size_t i=0; i<chunk_data_list.size(); i++)
+		{	file_out.insert(file_out.end(), chunk_data_list[i].begin(), chunk_data_list[i].end());
+			std::vector<unsigned char>().swap(chunk_data_list[i]);
+		}
+	}
+	catch(...)
+	{	file_out.clear();
+		error_out = _T("Memory Allocation Error: Failed to encode the mesh.");
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+// Decode a version 2 file into mesh_out, setting progress as the chunks are decoded. Returns FALSE and sets error_out if the
+// file is not valid, on allocation failure or if cancelled.
+BOOL geo_cv2_decode(const unsigned char* data, unsigned long long size, geo_cv2_mesh_s& mesh_out, const parallel_progress_s& progress, const wchar_t*& error_out)
+{
+	// Local data
+	geo_cv2_header_s							header;
+	const geo_cv2_uv_channel_s*					uv_channel_array;
+	const unsigned int*							subset_material_array;
+	std::vector<geo_cv2_chunk_s>				chunk_list;
+	const geo_cv2_chunk_s*						chunk_array;
+	unsigned long long							table_size;
+	unsigned int								chunk_index, type, channel, count;
+	geo_cv2_decode_body_s						decode_body;
+
+
+	error_out = 0;
+
+	// Check the header.
+	if(!geo_cv2_is_file(data, size) || size < sizeof(header))
+	{	error_out = _T("The file is not a CUSTOM version 2 file.");
+		return FALSE;
+	}
+	memcpy(&header, data, sizeof(header));
+	if(header.version != GEO_CV2_VERSION)
+	{	error_out = _T("The CUSTOM file version is not supported.");
+		return FALSE;
+	}
+	if(header.header_checksum != geo_cv2_checksum(&header, offsetof(geo_cv2_header_s, header_checksum)))
+	{	error_out = _T("The CUSTOM file header is corrupt.");
+		return FALSE;
+	}
+	if(!header.vertex_count || !header.face_count || !header.subset_count || header.uv_channel_count > GEO_CV2_MAX_UV_CHANNELS ||
+	   header.position_bits < 1 || header.position_bits > GEO_CV2_MAX_BITS || header.normal_bits < 2 || header.normal_bits > GEO_CV2_MAX_BITS ||
+	   header.uv_bits < 1 || header.uv_bits > GEO_CV2_MAX_BITS || (header.flags & ~GEO_CV2_FLAG_COLOR))
+	{	error_out = _T("The CUSTOM file header has a count, bit depth or flag out of range.");
+		return FALSE;
+	}
+
+	// Check the tables.
+	table_size = header.uv_channel_count * (unsigned long long)sizeof(geo_cv2_uv_channel_s) + header.subset_count * (unsigned long long)sizeof(unsigned int) +
+				 header.chunk_count * (unsigned long long)sizeof(geo_cv2_chunk_s);
+	if(size - sizeof(header) < table_size)
+	{	error_out = _T("The file is smaller than its tables.");
+		return FALSE;
+	}
+	if(header.table_checksum != geo_cv2_checksum(data + sizeof(header), (size_t)table_size))
+	{	error_out = _T("The CUSTOM file tables are corrupt.");
+		return FALSE;
+	}
+	uv_channel_array		= (const geo_cv2_uv_channel_s*)(data + sizeof(header));
+	subset_material_array	= (const unsigned int*)(uv_channel_array + header.uv_channel_count);
+
+	// The chunk table has 64 bit offsets that may not be aligned in the file, copy it.
+	try
+	{	chunk_list.resize(header.chunk_count);
+	}
+	catch(...)
+	{	error_out = _T("Memory Allocation Error: Failed to allocate the CUSTOM chunk table.");
+		return FALSE;
+	}
+	if(header.chunk_count)
+	{	memcpy(chunk_list.data(), subset_material_array + header.subset_count, header.chunk_count * sizeof(geo_cv2_chunk_s));
+	}
+	chunk_array = chunk_list.data();
+	for(unsigned int i=0; i<header.uv_channel_count; i++)
+	{	if(!uv_channel_array[i].uv_count)
+		{	error_out = _T("A uv channel of the CUSTOM file is empty.");
+			return FALSE;
+		}
+	}
+
+	// The chunks must cover the vertices, each uv channel, then the faces in order and lie in the file.
+	chunk_index = 0;
+	for(unsigned int section=0; section<2+header.uv_channel_count; section++)
+	{	type	= section == 0 ? GEO_CV2_CHUNK_VERTEX : (section <= header.uv_channel_count ? GEO_CV2_CHUNK_UV : GEO_CV2_CHUNK_FACE);
+		channel	= type == GEO_CV2_CHUNK_UV ? section - 1 : 0;
+		count	= type == GEO_CV2_CHUNK_VERTEX ? header.vertex_count : (type == GEO_CV2_CHUNK_UV ? uv_channel_array[channel].uv_count : header.face_count);
+		for(unsigned int next=0; next<count; next+=chunk_array[chunk_index++].count)
+		{	if(chunk_index == header.chunk_count || chunk_array[chunk_index].type != type || chunk_array[chunk_index].channel != channel ||
+			   chunk_array[chunk_index].first != next || !chunk_array[chunk_index].count || chunk_array[chunk_index].count > GEO_CV2_CHUNK_SIZE ||
+			   chunk_array[chunk_index].count > count - next || chunk_array[chunk_index].offset > size ||
+			   chunk_array[chunk_index].size > size - chunk_array[chunk_index].offset)
+			{	error_out = _T("The CUSTOM file chunk table is not valid.");
+				return FALSE;
+			}
+		}
+	}
+	if(chunk_index != header.chunk_count)
+	{	error_out = _T("The CUSTOM file chunk table is not valid.");
+		return FALSE;
+	}
+
+	// Allocate the mesh.
+	try
+	{	mesh_out.vertex_list.resize(header.vertex_count);
+		mesh_out.face_list.resize(header.face_count);
+		mesh_out.uv_channel_list.resize(header.uv_channel_count);
+		mesh_out.uv_index_list.resize(header.uv_channel_count);
+		for(unsigned int i=0; i<header.uv_channel_count; i++)
+		{	mesh_out.uv_channel_list[i].resize(uv_channel_array[i].uv_count);
+			mesh_out.uv_index_list[i].resize((size_t)header.face_count * 3);
+		}
+		mesh_out.subset_material_list.assign(subset_material_array, subset_material_array + header.subset_count);
+		mesh_out.is_color = (header.flags & GEO_CV2_FLAG_COLOR) ? TRUE : FALSE;
+	}
+	catch(...)
+	{	error_out = _T("Memory Allocation Error: Failed to allocate the CUSTOM mesh.");
+		return FALSE;
+	}
+
+	// Decode the chunks in parallel.
+	decode_body.data				= data;
+	decode_body.header				= &header;
+	decode_body.uv_channel_array	= uv_channel_array;
+	decode_body.chunk_array			= chunk_array;
+	decode_body.mesh				= &mesh_out;
+	if(!parallel_for(header.chunk_count, 1, decode_body, progress))
+	{	error_out = PARALLEL_IS_CANCEL() ? _T("The import was cancelled.") : _T("A CUSTOM file chunk is corrupt.");
+		return FALSE;
+	}
+
+	// Each face chunk is sorted by subset, check where the chunks meet.
+	for(unsigned int i=1; i<header.chunk_count; i++)
+	{	if(chunk_array[i].type == GEO_CV2_CHUNK_FACE && chunk_array[i].first &&
+		   mesh_out.face_list[chunk_array[i].first].subset_index < mesh_out.face_list[chunk_array[i].first - 1].subset_index)
+		{	error_out = _T("The CUSTOM file faces are not sorted by subset.");
+			return FALSE;
+		}
+	}
+
+	return TRUE;
+}
+
+#endif // GEO_CUSTOM_V2_CPP
@@ -0,0 +1,222 @@
+/*
+	===============================================================
+
+	SHADERMAP GEOMETRY FILE MAP SOURCE FILE
+
+	Maps a model file into memory so an importer can read its
+	records in place.
+
+	Reading a binary model with fread() into arrays and then
+	copying the arrays into the lists sent to ShaderMap holds the
+	file in memory two or three times. A mapped file is paged in
+	by the system as it is read and takes no heap memory, and
+	records with the same layout as a gp_ struct can be passed to
+	ShaderMap straight from the view.
+
+	The view is copy-on-write: the pointers are not const and
+	can be passed to the gp_create_ functions, and a page is only
+	copied if it is written to. The file is never changed.
+
+	Include this source code file in a geometry plugin after the
+	plugin core file. #include "../../geo_file_map.cpp"
+
+	--
+
+	Example:
+
+	geo_file_map_s		file_map;
+
+	if(!geo_file_map_open(file_path, file_map))
+	{	LOG_ERROR_MSG(plugin_index, _T("Failed to open file at file_path."));
+		return FALSE;
+	}
+	if(file_map.size < sizeof(header_s))
+	{	...
+	}
+	header = (const header_s*)file_map.data;
+	...
+	geo_file_map_close(file_map);
+
+	An empty file is opened with data 0 and size 0. Check the size
+	against the counts in the file before reading records.
+
+
+	SHADERMAP SDK LICENSE
+
+	The ShaderMap SDK is released under The MIT License (MIT)
+	http://opensource.org/licenses/MIT
+
+	Copyright (c) 2007-2019 Rendering Systems Inc.
+
+	Permission is hereby granted, free of charge, to any person
+	obtaining a copy of this software and associated documentation
+	files (the "Software"), to deal	in the Software without
+	restriction, including without limitation the rights to use,
+	copy, modify, merge, publish, distribute, sublicense, and/or
+	sell copies of the Software, and to permit persons to whom the
+	Software is	furnished to do so, subject to the following
+	conditions:
+
+	The above copyright notice and this permission notice shall be
+	included in	all copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+	OF MERCHANTABILITY,	FITNESS FOR A PARTICULAR PURPOSE AND
+	NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+	OTHER DEALINGS IN THE SOFTWARE.
+
+	Developed by: Neil Kemp at Rendering Systems Inc.
+
+	Online:		http://shadermap.com
+	Corporate:	http://renderingsystems.com
+
+	===============================================================
+*/
+
+#ifndef GEO_FILE_MAP_CPP
+#define GEO_FILE_MAP_CPP
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// File map includes
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// File map structs
+
+// A file mapped into memory.
+struct geo_file_map_s
+{
+	unsigned char*								data;						// Copy-on-write view of the whole file. 0 if the file is empty.
+	unsigned long long							size;						// Bytes in the file.
+
+#ifdef _WIN32
+	HANDLE										file;
+	HANDLE										mapping;
+#endif
+
+	// c()
+	geo_file_map_s(void)
+	{	data = 0; size = 0;
+#ifdef _WIN32
+		file = INVALID_HANDLE_VALUE; mapping = 0;
+#endif
+	}
+};
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// File map functions
+
+// Unmap a file opened with geo_file_map_open(). Pointers into the view are no longer valid.
+void geo_file_map_close(geo_file_map_s& file_map_in_out)
+{
+#ifdef _WIN32
+	if(file_map_in_out.data)
+	{	UnmapViewOfFile(file_map_in_out.data);
+	}
+	if(file_map_in_out.mapping)
+	{	CloseHandle(file_map_in_out.mapping);
+	}
+	if(file_map_in_out.file != INVALID_HANDLE_VALUE)
+	{	CloseHandle(file_map_in_out.file);
+	}
+	file_map_in_out.file	= INVALID_HANDLE_VALUE;
+	file_map_in_out.mapping	= 0;
+#else
+	if(file_map_in_out.data)
+	{	munmap(file_map_in_out.data, (size_t)file_map_in_out.size);
+	}
+#endif
+	file_map_in_out.data	= 0;
+	file_map_in_out.size	= 0;
+}
+
+// Map the file at file_path into memory. Returns FALSE if the file can not be opened or is too large for the address space.
+BOOL geo_file_map_open(const wchar_t* file_path, geo_file_map_s& file_map_out)
+{
+	geo_file_map_close(file_map_out);
+
+#ifdef _WIN32
+	// Local data
+	LARGE_INTEGER								file_size;
+
+
+	file_map_out.file = CreateFileW(file_path, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+	if(file_map_out.file == INVALID_HANDLE_VALUE || !GetFileSizeEx(file_map_out.file, &file_size))
+	{	geo_file_map_close(file_map_out);
+		return FALSE;
+	}
+	if(!file_size.QuadPart)
+	{	return TRUE;
+	}
+	if((unsigned long long)file_size.QuadPart > (size_t)-1)
+	{	geo_file_map_close(file_map_out);
+		return FALSE;
+	}
+	file_map_out.mapping = CreateFileMappingW(file_map_out.file, 0, PAGE_WRITECOPY, 0, 0, 0);
+	if(!file_map_out.mapping)
+	{	geo_file_map_close(file_map_out);
+		return FALSE;
+	}
+	file_map_out.data = (unsigned char*)MapViewOfFile(file_map_out.mapping, FILE_MAP_COPY, 0, 0, 0);
+	if(!file_map_out.data)
+	{	geo_file_map_close(file_map_out);
+		return FALSE;
+	}
+	file_map_out.size = (unsigned long long)file_size.QuadPart;
+	return TRUE;
+#else
+	// Local data
+	char										narrow_path[4096];
+	struct stat									file_stat;
+	void*										data;
+	int											file;
+
+
+	if(wcstombs(narrow_path, file_path, sizeof(narrow_path)) == (size_t)-1)
+	{	return FALSE;
+	}
+	narrow_path[sizeof(narrow_path) - 1] = 0;
+
+	file = open(narrow_path, O_RDONLY);
+	if(file < 0)
+	{	return FALSE;
+	}
+	if(fstat(file, &file_stat) != 0 || (unsigned long long)file_stat.st_size > SIZE_MAX)
+	{	close(file);
+		return FALSE;
+	}
+	if(!file_stat.st_size)
+	{	close(file);
+		return TRUE;
+	}
+
+	// The view stays valid after the file is closed.
+	data = mmap(0, (size_t)file_stat.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, file, 0);
+	close(file);
+	if(data == MAP_FAILED)
+	{	return FALSE;
+	}
+	file_map_out.data = (unsigned char*)data;
+	file_map_out.size = (unsigned long long)file_stat.st_size;
+	return TRUE;
+#endif
+}
+
+#endif // GEO_FILE_MAP_CPP
@@ -0,0 +1,108 @@
+/*
+	===============================================================
+
+	SHADERMAP GEOMETRY IMPORT PROGRESS SOURCE FILE
+
+	Progress, cancel and chunked NODE geometry for importers.
+
+	gp_set_progress(), gp_is_cancel_process(),
+	gp_append_node_geometry() and gp_end_node_geometry() are
+	optional functions of the geometry plugin core. A pointer left
+	0 means ShaderMap does not support that function, so an
+	importer calls them through these functions, which do nothing
+	or return FALSE when they are missing.
+
+	Appending lets ShaderMap build the model while the importer is
+	still reading the file, and the importer only has to hold one
+	chunk of faces. Importers that finish their arrays in one piece
+	(welding, sorting by subset) keep using gp_create_node_geometry().
+
+	Include this source code file in a geometry plugin after the
+	plugin core file. #include "../../geo_import_progress.cpp"
+
+	--
+
+	Example:
+
+	if(geo_is_append_node_geometry())
+	{	for(...each chunk of faces in subset order...)
+		{	if(geo_is_cancel())
+			{	return FALSE;
+			}
+			if(!gp_append_node_geometry(vertex_array, vertex_count, face_array, face_count, &uv_data))
+			{	...
+			}
+			geo_set_progress(face_end, total_face_count, 10, 100);
+		}
+		if(!gp_end_node_geometry(subset_count, FALSE))
+		{	...
+		}
+	}
+
+
+	SHADERMAP SDK LICENSE
+
+	The ShaderMap SDK is released under The MIT License (MIT)
+	http://opensource.org/licenses/MIT
+
+	Copyright (c) 2007-2019 Rendering Systems Inc.
+
+	Permission is hereby granted, free of charge, to any person
+	obtaining a copy of this software and associated documentation
+	files (the "Software"), to deal	in the Software without
+	restriction, including without limitation the rights to use,
+	copy, modify, merge, publish, distribute, sublicense, and/or
+	sell copies of the Software, and to permit persons to whom the
+	Software is	furnished to do so, subject to the following
+	conditions:
+
+	The above copyright notice and this permission notice shall be
+	included in	all copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+	OF MERCHANTABILITY,	FITNESS FOR A PARTICULAR PURPOSE AND
+	NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+	OTHER DEALINGS IN THE SOFTWARE.
+
+	Developed by: Neil Kemp at Rendering Systems Inc.
+
+	Online:		http://shadermap.com
+	Corporate:	http://renderingsystems.com
+
+	===============================================================
+*/
+
+#ifndef GEO_IMPORT_PROGRESS_CPP
+#define GEO_IMPORT_PROGRESS_CPP
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Import progress functions
+
+// Set the import progress to progress_start - progress_end by done_count of count. Does nothing if ShaderMap has no
+// gp_set_progress().
+void geo_set_progress(unsigned long long done_count, unsigned long long count, unsigned int progress_start, unsigned int progress_end)
+{
+	if(gp_set_progress)
+	{	gp_set_progress(progress_start + (count ? (unsigned int)((progress_end - progress_start) * done_count / count) : 0));
+	}
+}
+
+// Return TRUE if ShaderMap canceled the import. Always FALSE if ShaderMap has no gp_is_cancel_process().
+BOOL geo_is_cancel(void)
+{
+	return (gp_is_cancel_process && gp_is_cancel_process()) ? TRUE : FALSE;
+}
+
+// Return TRUE if ShaderMap accepts NODE geometry in chunks with gp_append_node_geometry() and gp_end_node_geometry().
+BOOL geo_is_append_node_geometry(void)
+{
+	return (gp_append_node_geometry && gp_end_node_geometry) ? TRUE : FALSE;
+}
+
+#endif // GEO_IMPORT_PROGRESS_CPP
@@ -0,0 +1,457 @@
+/*
+	===============================================================
+
+	SHADERMAP GEOMETRY MESH BUILD SOURCE FILE
+
+	Builds indexed RENDER geometry for gp_create_render_geometry()
+	with shared vertices in an order that is fast to draw.
+
+	A model file usually indexes positions, normals and uvs
+	separately. Writing 3 render vertices per triangle makes the
+	vertex list 3 times the face count and the visualizer has to
+	upload and transform every one of them. Most corners of a
+	smooth mesh share all of position, normal and uv with the
+	corners of neighbouring triangles.
+
+	geo_mesh_add_vertex() hashes the whole render vertex and
+	returns the index of an equal vertex added before, so each
+	vertex is stored once. Vertices are equal when every float has
+	the same bits.
+
+	geo_mesh_optimize() then sorts the triangles by subset (see
+	"geo_subset_sort.cpp") and, inside each subset, orders them for the post-transform vertex
+	cache of the GPU with Tipsify (Sander, Nehab, Barczak - "Fast
+	Triangle Reordering for Vertex Locality and Reduced Overdraw",
+	2007). Last the vertices are renumbered in the order the
+	triangles first use them.
+
+	Include this source code file in a geometry plugin after the
+	plugin core file. #include "../../geo_mesh_build.cpp"
+
+	--
+
+	Example:
+
+	geo_mesh_s		mesh;
+
+	if(!geo_mesh_reserve(mesh, face_count))
+	{	... out of memory ...
+	}
+	for(each triangle)
+	{	a = geo_mesh_add_vertex(mesh, vertex_a);
+		b = geo_mesh_add_vertex(mesh, vertex_b);
+		c = geo_mesh_add_vertex(mesh, vertex_c);
+		geo_mesh_add_face(mesh, a, b, c, subset_index);
+	}
+	if(!geo_mesh_optimize(mesh))
+	{	... out of memory ...
+	}
+	gp_create_render_geometry(mesh.vertex_list.data(), (unsigned int)mesh.vertex_list.size(), mesh.face_list.data(), 
+							  (unsigned int)mesh.face_list.size(), subset_count, FALSE, 0, 0);
+
+	geo_mesh_add_vertex() and geo_mesh_add_face() throw
+	std::bad_alloc when out of memory. Catch it around the loop.
+
+	Call parallel_shutdown() from on_shutdown().
+
+
+	SHADERMAP SDK LICENSE
+
+	The ShaderMap SDK is released under The MIT License (MIT)
+	http://opensource.org/licenses/MIT
+
+	Copyright (c) 2007-2019 Rendering Systems Inc.
+
+	Permission is hereby granted, free of charge, to any person
+	obtaining a copy of this software and associated documentation
+	files (the "Software"), to deal	in the Software without
+	restriction, including without limitation the rights to use,
+	copy, modify, merge, publish, distribute, sublicense, and/or
+	sell copies of the Software, and to permit persons to whom the
+	Software is	furnished to do so, subject to the following
+	conditions:
+
+	The above copyright notice and this permission notice shall be
+	included in	all copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+	OF MERCHANTABILITY,	FITNESS FOR A PARTICULAR PURPOSE AND
+	NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+	OTHER DEALINGS IN THE SOFTWARE.
+
+	Developed by: Neil Kemp at Rendering Systems Inc.
+
+	Online:		http://shadermap.com
+	Corporate:	http://renderingsystems.com
+
+	===============================================================
+*/
+
+#ifndef GEO_MESH_BUILD_CPP
+#define GEO_MESH_BUILD_CPP
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Mesh build includes
+
+#include "geo_subset_sort.cpp"
+#include <limits.h>
+#include <string.h>
+#include <algorithm>
+#include <new>
+#include <vector>
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Mesh build defines
+
+// Vertices in the post-transform cache assumed by geo_mesh_optimize().
+#ifndef GEO_MESH_CACHE_SIZE
+#define GEO_MESH_CACHE_SIZE						16
+#endif
+
+// Marks an empty vertex index.
+#define GEO_MESH_EMPTY							UINT_MAX
+
+// Marks an empty slot of the weld table.
+#define GEO_MESH_EMPTY_SLOT						ULLONG_MAX
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Mesh build structs
+
+// Render geometry being built.
+struct geo_mesh_s
+{
+	std::vector<gp_render_vertex_s>				vertex_list;
+	std::vector<gp_render_face_s>				face_list;
+	std::vector<unsigned long long>				weld_table;					// Open addressed (hash << 32 | vertex index), a power of 2 in size.
+};
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Mesh build functions
+
+// Return the hash of the bits of a render vertex.
+inline unsigned int geo_mesh_hash_vertex(const gp_render_vertex_s& vertex)
+{
+	// Local data
+	unsigned long long							word_array[4];
+	unsigned long long							hash = 0;
+
+
+	memcpy(word_array, &vertex, sizeof(word_array));
+	for(unsigned int i=0; i<4; i++)
+	{	hash = (hash ^ word_array[i]) * 0x9E3779B97F4A7C15ull;
+		hash ^= hash >> 29;
+	}
+
+	// Mix the high bits into the low bits used to index the table.
+	hash ^= hash >> 32;
+	hash *= 0xFF51AFD7ED558CCDull;
+	hash ^= hash >> 29;
+	return (unsigned int)hash;
+}
+
+// Return TRUE if two render vertices have the same bits.
+inline BOOL geo_mesh_is_same_vertex(const gp_render_vertex_s& vertex_0, const gp_render_vertex_s& vertex_1)
+{
+	// Local data
+	unsigned long long							word_array_0[4], word_array_1[4];
+
+
+	memcpy(word_array_0, &vertex_0, sizeof(word_array_0));
+	memcpy(word_array_1, &vertex_1, sizeof(word_array_1));
+	return ((word_array_0[0] ^ word_array_1[0]) | (word_array_0[1] ^ word_array_1[1]) | 
+			(word_array_0[2] ^ word_array_1[2]) | (word_array_0[3] ^ word_array_1[3])) == 0;
+}
+
+// Size the weld table for vertex_count vertices at most half full and add the vertices already in the mesh.
+void geo_mesh_resize_weld_table(geo_mesh_s& mesh_in_out, size_t vertex_count)
+{
+	// Local data
+	size_t										size = 1024, mask;
+
+
+	while(size < vertex_count * 2)
+	{	size *= 2;
+	}
+	mesh_in_out.weld_table.assign(size, GEO_MESH_EMPTY_SLOT);
+	mask = size - 1;
+	for(size_t i=0; i<mesh_in_out.vertex_list.size(); i++)
+	{	unsigned int	hash = geo_mesh_hash_vertex(mesh_in_out.vertex_list[i]);
+		size_t			slot = hash & mask;
+		while(mesh_in_out.weld_table[slot] != GEO_MESH_EMPTY_SLOT)
+		{	slot = (slot + 1) & mask;
+		}
+		mesh_in_out.weld_table[slot] = (unsigned long long)hash << 32 | i;
+	}
+}
+
+// Clear the mesh and reserve for face_count triangles. Returns FALSE if out of memory.
+BOOL geo_mesh_reserve(geo_mesh_s& mesh_out, unsigned int face_count)
+{
+	try
+	{	mesh_out.vertex_list.clear();
+		mesh_out.face_list.clear();
+		mesh_out.face_list.reserve(face_count);
+
+		// A closed mesh has about one render vertex for every two triangles plus the uv seams.
+		mesh_out.vertex_list.reserve(face_count / 2 + 1024);
+		geo_mesh_resize_weld_table(mesh_out, face_count / 2 + 1024);
+	}
+	catch(...)
+	{	return FALSE;
+	}
+	return TRUE;
+}
+
+// Return the index of a vertex equal to vertex, adding it if there is none.
+unsigned int geo_mesh_add_vertex(geo_mesh_s& mesh_in_out, const gp_render_vertex_s& vertex)
+{
+	// Local data
+	size_t										mask, slot;
+	unsigned long long							entry;
+	unsigned int								hash, index;
+
+
+	if((mesh_in_out.vertex_list.size() + 1) * 2 > mesh_in_out.weld_table.size())
+	{	geo_mesh_resize_weld_table(mesh_in_out, mesh_in_out.vertex_list.size() * 2);
+	}
+	mask = mesh_in_out.weld_table.size() - 1;
+	hash = geo_mesh_hash_vertex(vertex);
+	slot = hash & mask;
+
+	// The hash is kept in the table so only a vertex with the same hash is read.
+	for(;;)
+	{	entry = mesh_in_out.weld_table[slot];
+		if(entry == GEO_MESH_EMPTY_SLOT)
+		{	break;
+		}
+		if((unsigned int)(entry >> 32) == hash && geo_mesh_is_same_vertex(mesh_in_out.vertex_list[(unsigned int)entry], vertex))
+		{	return (unsigned int)entry;
+		}
+		slot = (slot + 1) & mask;
+	}
+
+	index = (unsigned int)mesh_in_out.vertex_list.size();
+	mesh_in_out.vertex_list.push_back(vertex);
+	mesh_in_out.weld_table[slot] = (unsigned long long)hash << 32 | index;
+	return index;
+}
+
+// Add a triangle of vertex indices returned by geo_mesh_add_vertex().
+inline void geo_mesh_add_face(geo_mesh_s& mesh_in_out, unsigned int a, unsigned int b, unsigned int c, unsigned int subset_index)
+{
+	mesh_in_out.face_list.push_back(gp_render_face_s(a, b, c, subset_index));
+}
+
+// Working arrays of geo_mesh_tipsify(). Indexed by vertex unless noted.
+struct geo_mesh_tipsify_s
+{
+	std::vector<unsigned int>					live_count;					// Triangles of the subset not emitted yet.
+	std::vector<unsigned int>					cache_time;					// Time the vertex last entered the cache.
+	std::vector<unsigned int>					adjacency_start;			// Triangles of each vertex are adjacency_list[start to end - 1].
+	std::vector<unsigned int>					adjacency_end;
+	std::vector<unsigned int>					adjacency_list;				// Subset triangle indices.
+	std::vector<unsigned int>					touched_list;				// Vertices used by the subset in first use order.
+	std::vector<unsigned int>					dead_end_stack;
+	std::vector<unsigned int>					candidate_list;
+	std::vector<unsigned char>					is_emitted;					// Indexed by subset triangle.
+	unsigned int								time;
+};
+
+// Return the next fanning vertex after a dead end - a recent vertex with triangles left, else the next vertex in first use
+// order. Returns GEO_MESH_EMPTY when every triangle is emitted.
+unsigned int geo_mesh_skip_dead_end(geo_mesh_tipsify_s& work, size_t& cursor_in_out)
+{
+	while(!work.dead_end_stack.empty())
+	{	unsigned int vertex = work.dead_end_stack.back();
+		work.dead_end_stack.pop_back();
+		if(work.live_count[vertex])
+		{	return vertex;
+		}
+	}
+	while(cursor_in_out < work.touched_list.size())
+	{	unsigned int vertex = work.touched_list[cursor_in_out++];
+		if(work.live_count[vertex])
+		{	return vertex;
+		}
+	}
+	return GEO_MESH_EMPTY;
+}
+
+// Append the face_count triangles of face_array, all of one subset, to output_list in vertex cache order. work is sized
+// for the mesh vertices.
+void geo_mesh_tipsify(const gp_render_face_s* face_array, size_t face_count, geo_mesh_tipsify_s& work, std::vector<gp_render_face_s>& output_list)
+{
+	// Local data
+	unsigned int								offset, fan_vertex, best_vertex, best_priority, priority, vertex;
+	size_t										cursor;
+
+
+	// Count the triangles of each vertex and list the vertices in first use order.
+	work.touched_list.clear();
+	for(size_t i=0; i<face_count; i++)
+	{	const unsigned int corner_array[3] = {face_array[i].a, face_array[i].b, face_array[i].c};
+		for(unsigned int j=0; j<3; j++)
+		{	if(!work.live_count[corner_array[j]]++)
+			{	work.touched_list.push_back(corner_array[j]);
+			}
+		}
+	}
+
+	// Build the vertex to triangle adjacency.
+	offset = 0;
+	for(size_t i=0; i<work.touched_list.size(); i++)
+	{	vertex = work.touched_list[i];
+		work.adjacency_start[vertex]	= offset;
+		work.adjacency_end[vertex]		= offset;
+		offset += work.live_count[vertex];
+	}
+	work.adjacency_list.resize(offset);
+	for(size_t i=0; i<face_count; i++)
+	{	work.adjacency_list[work.adjacency_end[face_array[i].a]++] = (unsigned int)i;
+		work.adjacency_list[work.adjacency_end[face_array[i].b]++] = (unsigned int)i;
+		work.adjacency_list[work.adjacency_end[face_array[i].c]++] = (unsigned int)i;
+	}
+	work.is_emitted.assign(face_count, 0);
+	work.dead_end_stack.clear();
+
+	// Emit the triangles around a vertex, then fan around the vertex in the cache that will stay in it and has the
+	// most triangles left, or skip to another vertex at a dead end.
+	cursor		= 0;
+	fan_vertex	= geo_mesh_skip_dead_end(work, cursor);
+	while(fan_vertex != GEO_MESH_EMPTY)
+	{
+		work.candidate_list.clear();
+		for(unsigned int i=work.adjacency_start[fan_vertex]; i<work.adjacency_end[fan_vertex]; i++)
+		{	unsigned int face = work.adjacency_list[i];
+			if(work.is_emitted[face])
+			{	continue;
+			}
+			work.is_emitted[face] = 1;
+			output_list.push_back(face_array[face]);
+
+			const unsigned int corner_array[3] = {face_array[face].a, face_array[face].b, face_array[face].c};
+			for(unsigned int j=0; j<3; j++)
+			{	vertex = corner_array[j];
+				work.dead_end_stack.push_back(vertex);
+				work.candidate_list.push_back(vertex);
+				work.live_count[vertex]--;
+				if(work.time - work.cache_time[vertex] > GEO_MESH_CACHE_SIZE)
+				{	work.cache_time[vertex] = work.time++;
+				}
+			}
+		}
+
+		best_vertex		= GEO_MESH_EMPTY;
+		best_priority	= 0;
+		for(size_t i=0; i<work.candidate_list.size(); i++)
+		{	vertex = work.candidate_list[i];
+			if(!work.live_count[vertex])
+			{	continue;
+			}
+			priority = 0;
+			if(work.time - work.cache_time[vertex] + 2 * work.live_count[vertex] <= GEO_MESH_CACHE_SIZE)
+			{	priority = work.time - work.cache_time[vertex];
+			}
+			if(priority > best_priority || best_vertex == GEO_MESH_EMPTY)
+			{	best_priority	= priority;
+				best_vertex		= vertex;
+			}
+		}
+		fan_vertex = (best_vertex != GEO_MESH_EMPTY) ? best_vertex : geo_mesh_skip_dead_end(work, cursor);
+	}
+}
+
+// Sort the triangles by subset, order each subset for the vertex cache and number the vertices in the order they are first
+// used. Returns FALSE if out of memory, the mesh is then unchanged.
+BOOL geo_mesh_optimize(geo_mesh_s& mesh_in_out)
+{
+	// Local data
+	geo_mesh_tipsify_s							work;
+	std::vector<gp_render_face_s>				face_list, sorted_face_list;
+	std::vector<gp_render_vertex_s>				vertex_list;
+	std::vector<unsigned int>					remap_list;
+	const gp_render_face_s*						subset_face_array;
+	size_t										face_count, subset_start, subset_end;
+	unsigned int								subset_count;
+	unsigned int*								corner;
+
+
+	face_count = mesh_in_out.face_list.size();
+	if(!face_count)
+	{	return TRUE;
+	}
+
+	try
+	{	// The weld table is not needed after the last vertex is added.
+		std::vector<unsigned long long>().swap(mesh_in_out.weld_table);
+
+		// Stable sort by subset. Faces are usually in subset order already and are then used where they are.
+		subset_face_array = mesh_in_out.face_list.data();
+		for(size_t i=1; i<face_count; i++)
+		{	if(mesh_in_out.face_list[i].subset_index < mesh_in_out.face_list[i-1].subset_index)
+			{	subset_count = 0;
+				for(size_t j=0; j<face_count; j++)
+				{	subset_count = std::max(subset_count, mesh_in_out.face_list[j].subset_index + 1);
+				}
+				sorted_face_list = mesh_in_out.face_list;
+				if(!geo_sort_subset_faces(sorted_face_list.data(), (unsigned int)face_count, subset_count, 0, 0, 0, 0))
+				{	return FALSE;
+				}
+				subset_face_array = sorted_face_list.data();
+				break;
+			}
+		}
+
+		work.live_count.assign(mesh_in_out.vertex_list.size(), 0);
+		work.cache_time.assign(mesh_in_out.vertex_list.size(), 0);
+		work.adjacency_start.resize(mesh_in_out.vertex_list.size());
+		work.adjacency_end.resize(mesh_in_out.vertex_list.size());
+		work.time = GEO_MESH_CACHE_SIZE + 1;
+		face_list.reserve(face_count);
+
+		for(subset_start=0; subset_start<face_count; subset_start=subset_end)
+		{	subset_end = subset_start + 1;
+			while(subset_end < face_count && subset_face_array[subset_end].subset_index == subset_face_array[subset_start].subset_index)
+			{	subset_end++;
+			}
+			geo_mesh_tipsify(&subset_face_array[subset_start], subset_end - subset_start, work, face_list);
+		}
+		std::vector<gp_render_face_s>().swap(sorted_face_list);
+
+		// Number the vertices in first use order so the vertex fetch reads memory in order too.
+		remap_list.assign(mesh_in_out.vertex_list.size(), GEO_MESH_EMPTY);
+		vertex_list.reserve(mesh_in_out.vertex_list.size());
+		for(size_t i=0; i<face_count; i++)
+		{	unsigned int* corner_array[3] = {&face_list[i].a, &face_list[i].b, &face_list[i].c};
+			for(unsigned int j=0; j<3; j++)
+			{	corner = corner_array[j];
+				if(remap_list[*corner] == GEO_MESH_EMPTY)
+				{	remap_list[*corner] = (unsigned int)vertex_list.size();
+					vertex_list.push_back(mesh_in_out.vertex_list[*corner]);
+				}
+				*corner = remap_list[*corner];
+			}
+		}
+	}
+	catch(...)
+	{	return FALSE;
+	}
+
+	mesh_in_out.vertex_list.swap(vertex_list);
+	mesh_in_out.face_list.swap(face_list);
+	return TRUE;
+}
+
+#endif // GEO_MESH_BUILD_CPP
@@ -0,0 +1,246 @@
+/*
+	===============================================================
+
+	SHADERMAP GEOMETRY NODE NORMALS SOURCE FILE
+
+	Creates smooth vertex normals for NODE geometry loaded from a
+	file that has none, such as STL or a PLY scan.
+
+	The normal of a vertex is the sum of the normals of the faces
+	that use it, each as long as twice the area of the face, so
+	large faces count more than slivers. Vertices used by no face
+	or only by faces with no area get a normal of 0.
+
+	The vertices are split into ranges, one task per range. A task
+	adds the faces with a corner in its range to its vertices only,
+	so no two threads write a vertex and the sums are added in face
+	order whatever the thread count. The vertex index range of
+	each chunk of faces is found first so that a task only reads
+	the chunks that can have a corner in its range. Model files
+	mostly use vertices near each other in the file together and
+	then each chunk is read by one or two tasks. The only memory
+	used is 2 indices per chunk.
+
+	Include this source code file in a geometry plugin after the
+	plugin core file. #include "../../geo_node_normals.cpp"
+
+	--
+
+	Example:
+
+	if(!geo_create_node_normals(vertex_list.data(), vertex_count, face_list.data(), face_count))
+	{	... out of memory ...
+	}
+	gp_create_node_geometry(vertex_list.data(), vertex_count, face_list.data(), face_count, &node_uv_data, 1, FALSE);
+
+	The face indices must be less than vertex_count.
+
+	Call parallel_shutdown() from on_shutdown().
+
+
+	SHADERMAP SDK LICENSE
+
+	The ShaderMap SDK is released under The MIT License (MIT)
+	http://opensource.org/licenses/MIT
+
+	Copyright (c) 2007-2019 Rendering Systems Inc.
+
+	Permission is hereby granted, free of charge, to any person
+	obtaining a copy of this software and associated documentation
+	files (the "Software"), to deal	in the Software without
+	restriction, including without limitation the rights to use,
+	copy, modify, merge, publish, distribute, sublicense, and/or
+	sell copies of the Software, and to permit persons to whom the
+	Software is	furnished to do so, subject to the following
+	conditions:
+
+	The above copyright notice and this permission notice shall be
+	included in	all copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+	OF MERCHANTABILITY,	FITNESS FOR A PARTICULAR PURPOSE AND
+	NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+	OTHER DEALINGS IN THE SOFTWARE.
+
+	Developed by: Neil Kemp at Rendering Systems Inc.
+
+	Online:		http://shadermap.com
+	Corporate:	http://renderingsystems.com
+
+	===============================================================
+*/
+
+#ifndef GEO_NODE_NORMALS_CPP
+#define GEO_NODE_NORMALS_CPP
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Node normals includes
+
+#include "../common/plugin_thread_pool.cpp"
+#include <math.h>
+#include <algorithm>
+#include <vector>
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Node normals defines
+
+// Faces in each chunk.
+#define GEO_NORMALS_CHUNK_SIZE					65536
+
+// Fewest vertices in the range of a task.
+#define GEO_NORMALS_MIN_RANGE_SIZE				65536
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Node normals structs
+
+// Finds the lowest and highest vertex index of each chunk of faces.
+struct geo_normals_range_body_s
+{
+	const gp_node_face_s*						face_array;
+	unsigned int								face_count;
+	unsigned int*								chunk_range_array;			// Lowest, highest vertex index of each chunk.
+
+	BOOL operator()(unsigned int chunk_start, unsigned int chunk_end) const
+	{	for(unsigned int chunk=chunk_start; chunk<chunk_end; chunk++)
+		{	unsigned int	end			= std::min<unsigned int>((chunk + 1) * GEO_NORMALS_CHUNK_SIZE, face_count);
+			unsigned int	range_start	= UINT_MAX;
+			unsigned int	range_end	= 0;
+			for(unsigned int i=chunk*GEO_NORMALS_CHUNK_SIZE; i<end; i++)
+			{	const gp_node_face_s& face = face_array[i];
+				range_start	= std::min(range_start, std::min(face.a, std::min(face.b, face.c)));
+				range_end	= std::max(range_end, std::max(face.a, std::max(face.b, face.c)));
+			}
+			chunk_range_array[chunk * 2]		= range_start;
+			chunk_range_array[chunk * 2 + 1]	= range_end;
+		}
+		return TRUE;
+	}
+};
+
+// Sums the face normals of the vertices in each range then makes them unit length.
+struct geo_normals_sum_body_s
+{
+	gp_node_vertex_s*							vertex_array;
+	unsigned int								vertex_count;
+	const gp_node_face_s*						face_array;
+	unsigned int								face_count;
+	const unsigned int*							chunk_range_array;
+	unsigned int								chunk_count;
+	unsigned int								range_size;
+
+	BOOL operator()(unsigned int range_start, unsigned int range_end) const
+	{	for(unsigned int range=range_start; range<range_end; range++)
+		{	unsigned int vertex_start	= range * range_size;
+			unsigned int vertex_end		= (unsigned int)std::min<unsigned long long>((unsigned long long)vertex_start + range_size, vertex_count);
+			for(unsigned int i=vertex_start; i<vertex_end; i++)
+			{	vertex_array[i].nx = vertex_array[i].ny = vertex_array[i].nz = 0.0f;
+			}
+
+			for(unsigned int chunk=0; chunk<chunk_count; chunk++)
+			{	if(chunk_range_array[chunk * 2] >= vertex_end || chunk_range_array[chunk * 2 + 1] < vertex_start)
+				{	continue;
+				}
+				unsigned int end = std::min<unsigned int>((chunk + 1) * GEO_NORMALS_CHUNK_SIZE, face_count);
+				for(unsigned int i=chunk*GEO_NORMALS_CHUNK_SIZE; i<end; i++)
+				{	const gp_node_face_s&	face			= face_array[i];
+					const unsigned int		corner_array[3]	= {face.a, face.b, face.c};
+					BOOL					is_in_range		= FALSE;
+					for(unsigned int j=0; j<3; j++)
+					{	is_in_range |= corner_array[j] >= vertex_start && corner_array[j] < vertex_end;
+					}
+					if(!is_in_range)
+					{	continue;
+					}
+
+					// The cross product of two edges is as long as twice the area of the face.
+					const gp_node_vertex_s& a = vertex_array[face.a];
+					const gp_node_vertex_s& b = vertex_array[face.b];
+					const gp_node_vertex_s& c = vertex_array[face.c];
+					float edge_0[3] = {b.x - a.x, b.y - a.y, b.z - a.z};
+					float edge_1[3] = {c.x - a.x, c.y - a.y, c.z - a.z};
+					float normal[3] = {	edge_0[1] * edge_1[2] - edge_0[2] * edge_1[1],
+										edge_0[2] * edge_1[0] - edge_0[0] * edge_1[2],
+										edge_0[0] * edge_1[1] - edge_0[1] * edge_1[0] };
+					for(unsigned int j=0; j<3; j++)
+					{	if(corner_array[j] >= vertex_start && corner_array[j] < vertex_end)
+						{	gp_node_vertex_s& vertex = vertex_array[corner_array[j]];
+							vertex.nx += normal[0];
+							vertex.ny += normal[1];
+							vertex.nz += normal[2];
+						}
+					}
+				}
+			}
+
+			for(unsigned int i=vertex_start; i<vertex_end; i++)
+			{	gp_node_vertex_s&	vertex	= vertex_array[i];
+				float				length	= sqrtf(vertex.nx * vertex.nx + vertex.ny * vertex.ny + vertex.nz * vertex.nz);
+				if(length > 0.0f)
+				{	vertex.nx /= length;
+					vertex.ny /= length;
+					vertex.nz /= length;
+				}
+			}
+		}
+		return TRUE;
+	}
+};
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Node normals functions
+
+// Set the normal of each vertex to the area weighted average of the normals of the faces that use it. Runs on all cores.
+// Returns FALSE if out of memory, the vertices are then unchanged, or if the import was cancelled.
+BOOL geo_create_node_normals(gp_node_vertex_s* vertex_array, unsigned int vertex_count, const gp_node_face_s* face_array, unsigned int face_count)
+{
+	// Local data
+	std::vector<unsigned int>					chunk_range_list;
+	geo_normals_range_body_s					range_body;
+	geo_normals_sum_body_s						sum_body;
+	unsigned int								chunk_count, range_count;
+
+
+	if(!vertex_count)
+	{	return TRUE;
+	}
+
+	chunk_count = (unsigned int)(((unsigned long long)face_count + GEO_NORMALS_CHUNK_SIZE - 1) / GEO_NORMALS_CHUNK_SIZE);
+	try
+	{	chunk_range_list.resize((size_t)chunk_count * 2);
+	}
+	catch(...)
+	{	return FALSE;
+	}
+
+	range_body.face_array			= face_array;
+	range_body.face_count			= face_count;
+	range_body.chunk_range_array	= chunk_range_list.data();
+	if(!parallel_for(chunk_count, 1, range_body, parallel_progress_s()))
+	{	return FALSE;
+	}
+
+	// About 4 ranges per thread so that a thread with slow ranges does not hold up the rest.
+	sum_body.vertex_array		= vertex_array;
+	sum_body.vertex_count		= vertex_count;
+	sum_body.face_array			= face_array;
+	sum_body.face_count			= face_count;
+	sum_body.chunk_range_array	= chunk_range_list.data();
+	sum_body.chunk_count		= chunk_count;
+	sum_body.range_size			= std::max<unsigned int>(vertex_count / (parallel_get_thread_limit() * 4), GEO_NORMALS_MIN_RANGE_SIZE);
+	range_count					= (unsigned int)(((unsigned long long)vertex_count + sum_body.range_size - 1) / sum_body.range_size);
+	return parallel_for(range_count, 1, sum_body, parallel_progress_s());
+}
+
+#endif // GEO_NODE_NORMALS_CPP
@@ -0,0 +1,544 @@
+/*
+	===============================================================
+
+	SHADERMAP GEOMETRY NODE WELD SOURCE FILE
+
+	Welds duplicate vertices and uvs of NODE geometry before it is
+	sent to gp_create_node_geometry(), which wants geometry with no
+	duplicate vertices.
+
+	Many model formats store a vertex for each face corner, or
+	split vertices at uv or material seams. Welding them makes the
+	node geometry, and everything ShaderMap builds from it such as
+	the bake BVH, smaller.
+
+	Two vertices weld when no position component and no normal
+	component differ by more than the epsilons. Two uvs weld when
+	neither component differs by more than the uv epsilon. An
+	epsilon of 0 welds only equal values.
+
+	Each vertex welds to the first vertex before it that it
+	matches, and the kept vertices stay in their order, so the
+	result does not depend on the thread count. Matching is not
+	transitive: a vertex can weld to one that welded to another a
+	little further away.
+
+	Positions are put in a grid of cells 4 x epsilon wide and
+	hashed by cell. The vertices are split by hash into partitions
+	and each partition is sorted by hash and indexed by a bucket
+	table, so a vertex only compares itself with the vertices in
+	the 1 to 8 cells it could match in. Hashing, sorting, matching
+	and remapping faces run on the plugin thread pool (see
+	"common/plugin_thread_pool.cpp").
+
+	Include this source code file in a geometry plugin after the
+	plugin core file. #include "../../geo_node_weld.cpp"
+
+	--
+
+	Example:
+
+	if(!geo_weld_node_vertices(vertex_list.data(), vertex_count, face_list.data(), face_count, 1.0e-6f, 1.0e-3f) ||
+	   !geo_weld_node_uvs(node_uv_data, face_count, 1.0e-6f))
+	{	... out of memory ...
+	}
+	gp_create_node_geometry(vertex_list.data(), vertex_count, face_list.data(), face_count, &node_uv_data, 1, FALSE);
+
+	Both functions work in place. vertex_count and the uv counts
+	are set to the welded counts, the arrays are not reallocated.
+	Faces whose corners weld together are kept.
+
+	Call parallel_shutdown() from on_shutdown().
+
+
+	SHADERMAP SDK LICENSE
+
+	The ShaderMap SDK is released under The MIT License (MIT)
+	http://opensource.org/licenses/MIT
+
+	Copyright (c) 2007-2019 Rendering Systems Inc.
+
+	Permission is hereby granted, free of charge, to any person
+	obtaining a copy of this software and associated documentation
+	files (the "Software"), to deal	in the Software without
+	restriction, including without limitation the rights to use,
+	copy, modify, merge, publish, distribute, sublicense, and/or
+	sell copies of the Software, and to permit persons to whom the
+	Software is	furnished to do so, subject to the following
+	conditions:
+
+	The above copyright notice and this permission notice shall be
+	included in	all copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+	OF MERCHANTABILITY,	FITNESS FOR A PARTICULAR PURPOSE AND
+	NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+	OTHER DEALINGS IN THE SOFTWARE.
+
+	Developed by: Neil Kemp at Rendering Systems Inc.
+
+	Online:		http://shadermap.com
+	Corporate:	http://renderingsystems.com
+
+	===============================================================
+*/
+
+#ifndef GEO_NODE_WELD_CPP
+#define GEO_NODE_WELD_CPP
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Node weld includes
+
+#include "../common/plugin_thread_pool.cpp"
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Node weld defines
+
+// Partitions the points are split into by the high bits of their hash. A power of 2.
+#define GEO_WELD_PARTITION_BITS					6
+#define GEO_WELD_PARTITION_COUNT				(1u << GEO_WELD_PARTITION_BITS)
+
+// Points in each chunk given to a thread.
+#define GEO_WELD_CHUNK_SIZE						16384
+
+// Most bits of the hash used to index the bucket table. Up to 2 ^ GEO_WELD_BUCKET_BITS + 1 buckets are allocated.
+#define GEO_WELD_BUCKET_BITS					28
+
+// Largest cell coordinate. Keeps the cell of a huge position divided by a tiny epsilon in range.
+#define GEO_WELD_CELL_LIMIT						1.0e15
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Node weld point access
+
+// Return the position of a point to weld as 3 floats.
+inline void geo_weld_get_position(const gp_node_vertex_s& vertex, float* position_out)
+{
+	position_out[0] = vertex.x;
+	position_out[1] = vertex.y;
+	position_out[2] = vertex.z;
+}
+
+inline void geo_weld_get_position(const gp_node_uv_s& uv, float* position_out)
+{
+	position_out[0] = uv.u;
+	position_out[1] = uv.v;
+	position_out[2] = 0.0f;
+}
+
+// Return TRUE if two points weld.
+inline BOOL geo_weld_is_match(const gp_node_vertex_s& vertex_0, const gp_node_vertex_s& vertex_1, float position_epsilon, float normal_epsilon)
+{
+	return fabsf(vertex_0.x - vertex_1.x) <= position_epsilon && fabsf(vertex_0.y - vertex_1.y) <= position_epsilon &&
+		   fabsf(vertex_0.z - vertex_1.z) <= position_epsilon && fabsf(vertex_0.nx - vertex_1.nx) <= normal_epsilon &&
+		   fabsf(vertex_0.ny - vertex_1.ny) <= normal_epsilon && fabsf(vertex_0.nz - vertex_1.nz) <= normal_epsilon;
+}
+
+inline BOOL geo_weld_is_match(const gp_node_uv_s& uv_0, const gp_node_uv_s& uv_1, float position_epsilon, float normal_epsilon)
+{
+	return fabsf(uv_0.u - uv_1.u) <= position_epsilon && fabsf(uv_0.v - uv_1.v) <= position_epsilon;
+}
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Node weld structs
+
+// A point of the weld sorted by its cell hash.
+struct geo_weld_key_s
+{
+	unsigned int								hash;
+	unsigned int								index;
+
+	bool operator<(const geo_weld_key_s& key) const
+	{	return hash < key.hash || (hash == key.hash && index < key.index);
+	}
+};
+
+// The state of a weld shared by its passes.
+template<class POINT_T>
+struct geo_weld_s
+{
+	const POINT_T*								point_array;
+	unsigned int								point_count;
+	float										position_epsilon;
+	float										normal_epsilon;
+	double										cell_size;					// 0 when the epsilon is 0, the cell is then the position bits.
+	unsigned int								bucket_bits;				// Bits of the hash indexing bucket_start_list.
+	std::vector<unsigned int>					hash_list;					// Cell hash of each point.
+	std::vector<geo_weld_key_s>					key_list;					// Points by partition, each partition sorted by hash then index.
+	std::vector<unsigned int>					partition_start_list;		// GEO_WELD_PARTITION_COUNT + 1 starts in key_list.
+	std::vector<unsigned int>					bucket_start_list;			// 2 ^ bucket_bits + 1 starts in key_list, by the high bits of the hash.
+	std::vector<unsigned int>					chunk_count_list;			// Points of each chunk in each partition, then their key_list offsets.
+	std::vector<unsigned int>					weld_list;					// The point each point welds to, then its new index.
+};
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Node weld functions
+
+// Return the hash of a grid cell.
+inline unsigned int geo_weld_hash_cell(long long x, long long y, long long z)
+{
+	unsigned long long hash = (unsigned long long)x * 0x9E3779B97F4A7C15ull;
+
+	hash = (hash ^ (unsigned long long)y) * 0xC2B2AE3D27D4EB4Full;
+	hash = (hash ^ (unsigned long long)z) * 0x165667B19E3779F9ull;
+	hash ^= hash >> 29;
+	hash *= 0xFF51AFD7ED558CCDull;
+	return (unsigned int)(hash >> 32);
+}
+
+// Return the cell of a position component.
+inline long long geo_weld_get_cell(double position, double cell_size)
+{
+	return (long long)std::max<double>(-GEO_WELD_CELL_LIMIT, std::min<double>(GEO_WELD_CELL_LIMIT, floor(position / cell_size)));
+}
+
+// Return the hash of the cell a position is in. With no cell size the cell is the position bits, -0 is made 0.
+inline unsigned int geo_weld_hash_position(const float* position, double cell_size)
+{
+	// Local data
+	unsigned int								bits[3];
+	float										component;
+
+
+	if(cell_size == 0.0)
+	{	for(unsigned int i=0; i<3; i++)
+		{	component = position[i] + 0.0f;
+			memcpy(&bits[i], &component, sizeof(unsigned int));
+		}
+		return geo_weld_hash_cell(bits[0], bits[1], bits[2]);
+	}
+	return geo_weld_hash_cell(geo_weld_get_cell(position[0], cell_size), geo_weld_get_cell(position[1], cell_size), geo_weld_get_cell(position[2], cell_size));
+}
+
+// Hash each point and count the points of each chunk in each partition.
+template<class POINT_T>
+struct geo_weld_hash_body_s
+{
+	geo_weld_s<POINT_T>*						weld;
+
+	BOOL operator()(unsigned int chunk_start, unsigned int chunk_end) const
+	{	for(unsigned int chunk=chunk_start; chunk<chunk_end; chunk++)
+		{	unsigned int* count_array = &weld->chunk_count_list[(size_t)chunk * GEO_WELD_PARTITION_COUNT];
+			unsigned int end = std::min<unsigned int>((chunk + 1) * GEO_WELD_CHUNK_SIZE, weld->point_count);
+			for(unsigned int i=chunk*GEO_WELD_CHUNK_SIZE; i<end; i++)
+			{	float position[3];
+				geo_weld_get_position(weld->point_array[i], position);
+				weld->hash_list[i] = geo_weld_hash_position(position, weld->cell_size);
+				count_array[weld->hash_list[i] >> (32 - GEO_WELD_PARTITION_BITS)]++;
+			}
+		}
+		return TRUE;
+	}
+};
+
+// Write the keys of each chunk to its partitions in index order.
+template<class POINT_T>
+struct geo_weld_scatter_body_s
+{
+	geo_weld_s<POINT_T>*						weld;
+
+	BOOL operator()(unsigned int chunk_start, unsigned int chunk_end) const
+	{	for(unsigned int chunk=chunk_start; chunk<chunk_end; chunk++)
+		{	unsigned int* offset_array = &weld->chunk_count_list[(size_t)chunk * GEO_WELD_PARTITION_COUNT];
+			unsigned int end = std::min<unsigned int>((chunk + 1) * GEO_WELD_CHUNK_SIZE, weld->point_count);
+			for(unsigned int i=chunk*GEO_WELD_CHUNK_SIZE; i<end; i++)
+			{	geo_weld_key_s& key = weld->key_list[offset_array[weld->hash_list[i] >> (32 - GEO_WELD_PARTITION_BITS)]++];
+				key.hash	= weld->hash_list[i];
+				key.index	= i;
+			}
+		}
+		return TRUE;
+	}
+};
+
+// Sort each partition by hash then index and set the starts of its buckets.
+template<class POINT_T>
+struct geo_weld_sort_body_s
+{
+	geo_weld_s<POINT_T>*						weld;
+
+	BOOL operator()(unsigned int partition_start, unsigned int partition_end) const
+	{	for(unsigned int partition=partition_start; partition<partition_end; partition++)
+		{	unsigned int	key_start	= weld->partition_start_list[partition];
+			unsigned int	key_end		= weld->partition_start_list[partition + 1];
+			unsigned int	bucket		= partition << (weld->bucket_bits - GEO_WELD_PARTITION_BITS);
+			unsigned int	bucket_end	= (partition + 1) << (weld->bucket_bits - GEO_WELD_PARTITION_BITS);
+			std::sort(weld->key_list.begin() + key_start, weld->key_list.begin() + key_end);
+			for(unsigned int i=key_start; i<key_end; i++)
+			{	for(unsigned int key_bucket = weld->key_list[i].hash >> (32 - weld->bucket_bits); bucket<=key_bucket; bucket++)
+				{	weld->bucket_start_list[bucket] = i;
+				}
+			}
+			for(; bucket<bucket_end; bucket++)
+			{	weld->bucket_start_list[bucket] = key_end;
+			}
+		}
+		return TRUE;
+	}
+};
+
+// Find the first point before each point that it welds to, in the cells it could match in.
+template<class POINT_T>
+struct geo_weld_match_body_s
+{
+	geo_weld_s<POINT_T>*						weld;
+
+	// Return the first point before index in the cell with hash that matches point, or index if none.
+	unsigned int find_match(const POINT_T& point, unsigned int index, unsigned int hash) const
+	{	unsigned int		bucket	= hash >> (32 - weld->bucket_bits);
+		for(unsigned int i=weld->bucket_start_list[bucket]; i<weld->bucket_start_list[bucket + 1]; i++)
+		{	const geo_weld_key_s& key = weld->key_list[i];
+			if(key.hash > hash || (key.hash == hash && key.index >= index))
+			{	break;
+			}
+			if(key.hash == hash && geo_weld_is_match(weld->point_array[key.index], point, weld->position_epsilon, weld->normal_epsilon))
+			{	return key.index;
+			}
+		}
+		return index;
+	}
+
+	BOOL operator()(unsigned int index_start, unsigned int index_end) const
+	{	for(unsigned int i=index_start; i<index_end; i++)
+		{	const POINT_T&	point = weld->point_array[i];
+			unsigned int	match = i;
+			if(weld->cell_size == 0.0)
+			{	match = find_match(point, i, weld->hash_list[i]);
+			}
+			else
+			{	// A match is within epsilon so it is in the 1 or 2 cells on each axis that the epsilon range overlaps.
+				float		position[3];
+				long long	cell_start[3], cell_end[3];
+				geo_weld_get_position(point, position);
+				for(unsigned int j=0; j<3; j++)
+				{	cell_start[j]	= geo_weld_get_cell((double)position[j] - weld->position_epsilon, weld->cell_size);
+					cell_end[j]		= geo_weld_get_cell((double)position[j] + weld->position_epsilon, weld->cell_size);
+				}
+				for(long long x=cell_start[0]; x<=cell_end[0]; x++)
+				{	for(long long y=cell_start[1]; y<=cell_end[1]; y++)
+					{	for(long long z=cell_start[2]; z<=cell_end[2]; z++)
+						{	match = std::min<unsigned int>(match, find_match(point, match, geo_weld_hash_cell(x, y, z)));
+						}
+					}
+				}
+			}
+			weld->weld_list[i] = match;
+		}
+		return TRUE;
+	}
+};
+
+// Find the new index of each point of point_array. Returns the welded point count in point_count_out and the new index of
+// each point in weld_list_out. Returns FALSE if out of memory or the import was cancelled.
+template<class POINT_T>
+BOOL geo_weld_points(const POINT_T* point_array, unsigned int point_count, float position_epsilon, float normal_epsilon,
+					 std::vector<unsigned int>& weld_list_out, unsigned int& point_count_out)
+{
+	// Local data
+	geo_weld_s<POINT_T>							weld;
+	geo_weld_hash_body_s<POINT_T>				hash_body;
+	geo_weld_scatter_body_s<POINT_T>			scatter_body;
+	geo_weld_sort_body_s<POINT_T>				sort_body;
+	geo_weld_match_body_s<POINT_T>				match_body;
+	unsigned int								chunk_count, offset, count, new_index;
+
+
+	weld.point_array		= point_array;
+	weld.point_count		= point_count;
+	weld.position_epsilon	= std::max<float>(0.0f, position_epsilon);
+	weld.normal_epsilon		= std::max<float>(0.0f, normal_epsilon);
+	weld.cell_size			= 4.0 * weld.position_epsilon;
+	weld.bucket_bits		= GEO_WELD_PARTITION_BITS;
+	while(weld.bucket_bits < GEO_WELD_BUCKET_BITS && (1u << weld.bucket_bits) < point_count)
+	{	weld.bucket_bits++;
+	}
+	chunk_count				= (point_count + GEO_WELD_CHUNK_SIZE - 1) / GEO_WELD_CHUNK_SIZE;
+	hash_body.weld			= &weld;
+	scatter_body.weld		= &weld;
+	sort_body.weld			= &weld;
+	match_body.weld			= &weld;
+
+	try
+	{	weld.hash_list.resize(point_count);
+		weld.key_list.resize(point_count);
+		weld.weld_list.resize(point_count);
+		weld.partition_start_list.resize(GEO_WELD_PARTITION_COUNT + 1);
+		weld.bucket_start_list.resize(((size_t)1 << weld.bucket_bits) + 1);
+		weld.chunk_count_list.assign((size_t)chunk_count * GEO_WELD_PARTITION_COUNT, 0);
+	}
+	catch(...)
+	{	return FALSE;
+	}
+
+	// Hash the points and split them into partitions, each partition in index order. Then sort the partitions by hash.
+	if(!parallel_for(chunk_count, 1, hash_body, parallel_progress_s()))
+	{	return FALSE;
+	}
+	offset = 0;
+	for(unsigned int partition=0; partition<GEO_WELD_PARTITION_COUNT; partition++)
+	{	weld.partition_start_list[partition] = offset;
+		for(unsigned int chunk=0; chunk<chunk_count; chunk++)
+		{	count = weld.chunk_count_list[(size_t)chunk * GEO_WELD_PARTITION_COUNT + partition];
+			weld.chunk_count_list[(size_t)chunk * GEO_WELD_PARTITION_COUNT + partition] = offset;
+			offset += count;
+		}
+	}
+	weld.partition_start_list[GEO_WELD_PARTITION_COUNT] = offset;
+	weld.bucket_start_list[(size_t)1 << weld.bucket_bits] = offset;
+	if(!parallel_for(chunk_count, 1, scatter_body, parallel_progress_s()))
+	{	return FALSE;
+	}
+	std::vector<unsigned int>().swap(weld.chunk_count_list);
+	if(!parallel_for(GEO_WELD_PARTITION_COUNT, 1, sort_body, parallel_progress_s()))
+	{	return FALSE;
+	}
+
+	// Find the point each point welds to.
+	if(!parallel_for(point_count, GEO_WELD_CHUNK_SIZE, match_body, parallel_progress_s()))
+	{	return FALSE;
+	}
+
+	// Weld to the point the match welded to, which is always before it, and number the points kept in order.
+	new_index = 0;
+	for(unsigned int i=0; i<point_count; i++)
+	{	if(weld.weld_list[i] == i)
+		{	weld.weld_list[i] = new_index++;
+		}
+		else
+		{	weld.weld_list[i] = weld.weld_list[weld.weld_list[i]];
+		}
+	}
+
+	weld_list_out.swap(weld.weld_list);
+	point_count_out = new_index;
+	return TRUE;
+}
+
+// Move the points kept by a weld to their new index. New indices are never after old ones so this is done in order.
+template<class POINT_T>
+void geo_weld_compact(POINT_T* point_array, unsigned int point_count, const std::vector<unsigned int>& weld_list)
+{
+	// Local data
+	unsigned int								new_count = 0;
+
+
+	for(unsigned int i=0; i<point_count; i++)
+	{	if(weld_list[i] == new_count)
+		{	point_array[new_count++] = point_array[i];
+		}
+	}
+}
+
+// Remap the corners of faces to the new vertex indices.
+struct geo_weld_face_body_s
+{
+	gp_node_face_s*								face_array;
+	const unsigned int*							weld_array;
+
+	BOOL operator()(unsigned int face_start, unsigned int face_end) const
+	{	for(unsigned int i=face_start; i<face_end; i++)
+		{	face_array[i].a = weld_array[face_array[i].a];
+			face_array[i].b = weld_array[face_array[i].b];
+			face_array[i].c = weld_array[face_array[i].c];
+		}
+		return TRUE;
+	}
+};
+
+// Remap uv indices to the new uv indices.
+struct geo_weld_index_body_s
+{
+	unsigned int*								index_array;
+	const unsigned int*							weld_array;
+
+	BOOL operator()(unsigned int index_start, unsigned int index_end) const
+	{	for(unsigned int i=index_start; i<index_end; i++)
+		{	index_array[i] = weld_array[index_array[i]];
+		}
+		return TRUE;
+	}
+};
+
+// Weld the vertices of NODE geometry in place and remap the faces. vertex_count_in_out is set to the welded count.
+// Face corners must be less than vertex_count_in_out. Returns FALSE if out of memory, the geometry is then unchanged, or
+// if the import was cancelled, the geometry can then not be used.
+BOOL geo_weld_node_vertices(gp_node_vertex_s* vertex_array, unsigned int& vertex_count_in_out, gp_node_face_s* face_array,
+							unsigned int face_count, float position_epsilon, float normal_epsilon)
+{
+	// Local data
+	std::vector<unsigned int>					weld_list;
+	geo_weld_face_body_s						face_body;
+	unsigned int								vertex_count;
+
+
+	if(!vertex_count_in_out)
+	{	return TRUE;
+	}
+	if(!geo_weld_points(vertex_array, vertex_count_in_out, position_epsilon, normal_epsilon, weld_list, vertex_count))
+	{	return FALSE;
+	}
+	if(vertex_count == vertex_count_in_out)
+	{	return TRUE;
+	}
+
+	geo_weld_compact(vertex_array, vertex_count_in_out, weld_list);
+	face_body.face_array	= face_array;
+	face_body.weld_array	= weld_list.data();
+	if(!parallel_for(face_count, GEO_WELD_CHUNK_SIZE, face_body, parallel_progress_s()))
+	{	return FALSE;
+	}
+	vertex_count_in_out		= vertex_count;
+	return TRUE;
+}
+
+// Weld the uvs of each channel of NODE geometry in place and remap the uv indices, 3 for each of face_count faces.
+// uv_data_in_out.uv_count_array is set to the welded counts. Returns FALSE if out of memory, channels welded before
+// that stay welded, or if the import was cancelled, the uvs can then not be used.
+BOOL geo_weld_node_uvs(gp_node_uv_data_s& uv_data_in_out, unsigned int face_count, float uv_epsilon)
+{
+	// Local data
+	std::vector<unsigned int>					weld_list;
+	geo_weld_index_body_s						index_body;
+	unsigned int								uv_count;
+
+
+	for(unsigned int channel=0; channel<uv_data_in_out.uv_channel_count; channel++)
+	{	if(!uv_data_in_out.uv_count_array[channel])
+		{	continue;
+		}
+		if(!geo_weld_points(uv_data_in_out.uv_channels_array[channel], uv_data_in_out.uv_count_array[channel], uv_epsilon, 0.0f, weld_list, uv_count))
+		{	return FALSE;
+		}
+		if(uv_count == uv_data_in_out.uv_count_array[channel])
+		{	continue;
+		}
+
+		geo_weld_compact(uv_data_in_out.uv_channels_array[channel], uv_data_in_out.uv_count_array[channel], weld_list);
+		index_body.index_array	= uv_data_in_out.uv_indices_array[channel];
+		index_body.weld_array	= weld_list.data();
+		if(!parallel_for((unsigned int)std::min<unsigned long long>((unsigned long long)face_count * 3, UINT_MAX), GEO_WELD_CHUNK_SIZE, index_body, parallel_progress_s()))
+		{	return FALSE;
+		}
+		uv_data_in_out.uv_count_array[channel] = uv_count;
+	}
+	return TRUE;
+}
+
+#endif // GEO_NODE_WELD_CPP
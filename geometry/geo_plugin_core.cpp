@@ -97,11 +97,11 @@ struct gp_render_vertex_s
 
 
 	// c()
-	gp_render_vertex_s::gp_render_vertex_s(void)
+	gp_render_vertex_s(void)
 	{	x = y = z = nx = ny = nz = u = v = 0.0f;
 	}
 	// c(...)
-	gp_render_vertex_s::gp_render_vertex_s(float c_x, float c_y, float c_z, float c_nx, float c_ny, float c_nz, float c_u, float c_v)
+	gp_render_vertex_s(float c_x, float c_y, float c_z, float c_nx, float c_ny, float c_nz, float c_u, float c_v)
 	{	x = c_x; y = c_y; z = c_z; nx = c_nx; ny = c_ny; nz = c_nz; u = c_u; v = c_v;
 	}
 };
@@ -115,12 +115,12 @@ struct gp_render_face_s
 
 
 	// c()
-	gp_render_face_s::gp_render_face_s(void)
+	gp_render_face_s(void)
 	{	a = b = c = subset_index = 0;
 	}
 
 	// c(...)
-	gp_render_face_s::gp_render_face_s(unsigned int c_a, unsigned int c_b, unsigned int c_c, unsigned int subset)
+	gp_render_face_s(unsigned int c_a, unsigned int c_b, unsigned int c_c, unsigned int subset)
 	{	a = c_a; b = c_b; c = c_c; subset_index = subset;
 	}
 };
@@ -134,12 +134,12 @@ struct gp_node_vertex_s
 
 
 	// c()
-	gp_node_vertex_s::gp_node_vertex_s(void)
+	gp_node_vertex_s(void)
 	{	x = y = z = nx = ny = nz = 0.0f;
 	}
 
 	// c(...)
-	gp_node_vertex_s::gp_node_vertex_s(float c_x, float c_y, float c_z, float c_nx, float c_ny, float c_nz)
+	gp_node_vertex_s(float c_x, float c_y, float c_z, float c_nx, float c_ny, float c_nz)
 	{	x = c_x; y = c_y; z = c_z; nx = c_nx; ny = c_ny; nz = c_nz;
 	}
 };
@@ -152,12 +152,12 @@ struct gp_node_uv_s
 
 
 	// c()
-	gp_node_uv_s::gp_node_uv_s(void)
+	gp_node_uv_s(void)
 	{	u = v = 0.0f;
 	}
 
 	// c(...)
-	gp_node_uv_s::gp_node_uv_s(float c_u, float c_v)
+	gp_node_uv_s(float c_u, float c_v)
 	{	u = c_u; v = c_v;
 	}
 };
@@ -171,13 +171,13 @@ struct gp_node_face_s
 	unsigned int								color;					// Color value set by RGB(r, g, b);
 
 	// c()
-	gp_node_face_s::gp_node_face_s(void)
+	gp_node_face_s(void)
 	{	a = b = c = subset_index = 0;
 		color = RGB(191, 191, 191);
 	}
 
 	// c(...)
-	gp_node_face_s::gp_node_face_s(unsigned int c_a, unsigned int c_b, unsigned int c_c, unsigned int subset, unsigned int col)
+	gp_node_face_s(unsigned int c_a, unsigned int c_b, unsigned int c_c, unsigned int subset, unsigned int col)
 	{	a = c_a; b = c_b; c = c_c; subset_index = subset; color = col;
 	}
 };
@@ -191,7 +191,7 @@ struct gp_node_uv_data_s
 	unsigned int**								uv_indices_array;		// Array of arrays of uv indices for each uv channel - will be of size uv_channel_count - each array has 3 indices per triangle
 
 	// c()
-	gp_node_uv_data_s::gp_node_uv_data_s(void)
+	gp_node_uv_data_s(void)
 	{	
 		uv_channel_count						= 0;
 		uv_channels_array						= 0;
@@ -241,13 +241,13 @@ gp_set_file_info_type							gp_set_file_info = 0;
 typedef unsigned int							(*gp_get_geometry_type_type)(void);
 gp_get_geometry_type_type						gp_get_geometry_type = 0;
 
-// Create the loaded geometry for RENDERING by sending it to ShaderMap - Ensure "gp_get_geo_type()" == GP_GEOMETRY_TYPE_RENDER
+// Create the loaded geometry for RENDERING by sending it to ShaderMap - Ensure "gp_get_geometry_type()" == GP_GEOMETRY_TYPE_RENDER
 // The triangle_array parameter must be sorted from lowest to highest subsets
 // The parameter additional_uv_arrays is an array of float arrays - 2 floats per vertex - can be 0 if no additional uv channels
 typedef BOOL									(*gp_create_render_geometry_type)(gp_render_vertex_s* /*vertex_array*/, unsigned int /*vertex_count*/, gp_render_face_s* /*triangle_array*/, unsigned int /*triangle_count*/, unsigned int /*subset_count*/, BOOL /*is_create_normals*/, float** /*additional_uv_arrays*/, unsigned int /*additional_uv_array_count*/);
 gp_create_render_geometry_type					gp_create_render_geometry = 0;
 
-// Create the loaded geometry for NODES by sending it to ShaderMap - Ensure "gp_get_geo_type()" == GP_GEOMETRY_TYPE_NODE
+// Create the loaded geometry for NODES by sending it to ShaderMap - Ensure "gp_get_geometry_type()" == GP_GEOMETRY_TYPE_NODE
 // The triangle_array parameter must be sorted from lowest to highest subsets - Geometry should be optimized with no duplicate vertices
 typedef BOOL									(*gp_create_node_geometry_type)(gp_node_vertex_s* /*vertex_array*/, unsigned int /*vertex_count*/, gp_node_face_s* /*triangle_array*/, unsigned int /*triangle_count*/, const gp_node_uv_data_s* /*uv_data_pointer*/, unsigned int /*subset_count*/, BOOL /*is_create_normals*/);
 gp_create_node_geometry_type					gp_create_node_geometry = 0;
@@ -265,6 +265,32 @@ typedef void									(*gp_flag_no_uv_geometry_type)(void);
 gp_flag_no_uv_geometry_type						gp_flag_no_uv_geometry = 0;
 
 
+// **
+// Progress, cancel and streaming functions used in "on_process()". These are optional - a pointer ShaderMap leaves 0
+// means the function is not supported, so check the pointer before calling and fall back to "gp_create_node_geometry()".
+
+// Set the progress of the import - a progress integer between 0-100.
+typedef void									(*gp_set_progress_type)(unsigned int /*progress*/);
+gp_set_progress_type							gp_set_progress = 0;
+
+// Determine if the import has been canceled - check often. If TRUE return FALSE from "on_process()" without creating geometry.
+typedef BOOL									(*gp_is_cancel_process_type)(void);
+gp_is_cancel_process_type						gp_is_cancel_process = 0;
+
+// Append a chunk of NODE geometry - Ensure "gp_get_geometry_type()" == GP_GEOMETRY_TYPE_NODE. Call any number of times then
+// call "gp_end_node_geometry()" instead of "gp_create_node_geometry()". ShaderMap builds the model as chunks arrive.
+// Vertices and uvs are added after those of earlier chunks. Face vertex indices and uv indices index all vertices and uvs
+// appended so far, including this chunk, and never a later chunk. Faces must be sorted by subset across all chunks.
+// Every chunk must have the same uv_channel_count, uv_count_array gives the uvs added to each channel by this chunk (can be 0)
+// and uv_indices_array has 3 indices per triangle of this chunk. A chunk can have no vertices or no triangles.
+typedef BOOL									(*gp_append_node_geometry_type)(const gp_node_vertex_s* /*vertex_array*/, unsigned int /*vertex_count*/, const gp_node_face_s* /*triangle_array*/, unsigned int /*triangle_count*/, const gp_node_uv_data_s* /*uv_data_pointer*/);
+gp_append_node_geometry_type					gp_append_node_geometry = 0;
+
+// Finish the NODE geometry sent with "gp_append_node_geometry()". Returns FALSE if the geometry is empty or invalid.
+typedef BOOL									(*gp_end_node_geometry_type)(unsigned int /*subset_count*/, BOOL /*is_create_normals*/);
+gp_end_node_geometry_type						gp_end_node_geometry = 0;
+
+
 // **
 // Utility functions using during processing in "on_process()".
 
@@ -302,7 +328,14 @@ BOOL											on_shutdown(void);
 // "plugin_initialize()" sets the API function pointers then calls "on_initialize()".
 // "plugin_process()" and "plugin_shutdown()" each call the user defined "on_process()" and "on_shutdown()" functions.
 
+#ifdef _WIN32
 #define DLL_EXPORT								__declspec(dllexport)
+#else
+#define DLL_EXPORT								__attribute__((visibility("default")))		// Linux shared object build - see "host/compat/windows.h".
+#endif
+
+// A host that includes this file for the structs and function types defines SMSDK_HOST so the plugin exports are left out.
+#ifndef SMSDK_HOST
 
 extern "C" {
 
@@ -336,7 +369,12 @@ extern "C" {
 		gp_define_node_material_id				= (gp_define_node_material_id_type)function_pointer_array[204];
 		gp_is_option_material_color_from_file	= (gp_is_option_material_color_from_file_type)function_pointer_array[205];
 		gp_flag_no_uv_geometry					= (gp_flag_no_uv_geometry_type)function_pointer_array[206];
-		/*Elements 207 - 299 are reserved for future use*/
+		/*Elements 207 - 210 are optional, 0 if not supported*/
+		gp_set_progress							= (gp_set_progress_type)function_pointer_array[207];
+		gp_is_cancel_process					= (gp_is_cancel_process_type)function_pointer_array[208];
+		gp_append_node_geometry					= (gp_append_node_geometry_type)function_pointer_array[209];
+		gp_end_node_geometry					= (gp_end_node_geometry_type)function_pointer_array[210];
+		/*Elements 211 - 299 are reserved for future use*/
 
 		return on_initialize();
 	}
@@ -351,3 +389,5 @@ extern "C" {
 	{	return on_shutdown();
 	}	
 }
+
+#endif // SMSDK_HOST
@@ -0,0 +1,405 @@
+/*
+	===============================================================
+
+	SHADERMAP GEOMETRY STREAM WELD SOURCE FILE
+
+	Welds the corners of faces into shared vertices while a file
+	is read, for formats such as STL that store 3 positions per
+	face and no indices.
+
+	geo_node_weld.cpp welds an array of vertices that is already
+	loaded. A scan of 100M faces has 300M corners, 7 GB as node
+	vertices, so they are not loaded first. The faces are added in
+	blocks instead and only the welded positions are kept, about
+	6 times fewer than the corners of a closed mesh.
+
+	Corners weld when their positions have the same bits, with -0
+	the same as 0. The positions are hashed and split by the high
+	bits of the hash into partitions. Each partition has its own
+	list of positions and hash table, so each block is hashed,
+	split and welded with one task per partition on the plugin
+	thread pool (see "common/plugin_thread_pool.cpp"). A corner
+	is the first vertex of its partition with its position or
+	welds to it, so the result does not depend on the thread count.
+
+	geo_stream_weld_end() numbers the vertices in the order the
+	faces first use them, so faces near each other in the file
+	use vertices near each other in the vertex list.
+
+	Include this source code file in a geometry plugin after the
+	plugin core file. #include "../../geo_stream_weld.cpp"
+
+	--
+
+	Example:
+
+	geo_stream_weld_s	weld;
+
+	for(each block of faces)
+	{	... read 9 floats per face, the positions of corners a, b, c, into position_list ...
+		if(!geo_stream_weld_add(weld, position_list.data(), block_face_count, &face_list[block_start]))
+		{	... out of memory or too many vertices ...
+		}
+	}
+	if(!geo_stream_weld_end(weld, face_list.data(), face_count, vertex_list))
+	{	... out of memory or too many vertices ...
+	}
+
+	geo_stream_weld_add() sets a, b and c of the faces to weld
+	ids. geo_stream_weld_end() makes them indices in vertex_list,
+	which it fills with the positions and 0 normals.
+
+	Call parallel_shutdown() from on_shutdown().
+
+
+	SHADERMAP SDK LICENSE
+
+	The ShaderMap SDK is released under The MIT License (MIT)
+	http://opensource.org/licenses/MIT
+
+	Copyright (c) 2007-2019 Rendering Systems Inc.
+
+	Permission is hereby granted, free of charge, to any person
+	obtaining a copy of this software and associated documentation
+	files (the "Software"), to deal	in the Software without
+	restriction, including without limitation the rights to use,
+	copy, modify, merge, publish, distribute, sublicense, and/or
+	sell copies of the Software, and to permit persons to whom the
+	Software is	furnished to do so, subject to the following
+	conditions:
+
+	The above copyright notice and this permission notice shall be
+	included in	all copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+	OF MERCHANTABILITY,	FITNESS FOR A PARTICULAR PURPOSE AND
+	NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+	OTHER DEALINGS IN THE SOFTWARE.
+
+	Developed by: Neil Kemp at Rendering Systems Inc.
+
+	Online:		http://shadermap.com
+	Corporate:	http://renderingsystems.com
+
+	===============================================================
+*/
+
+#ifndef GEO_STREAM_WELD_CPP
+#define GEO_STREAM_WELD_CPP
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Stream weld includes
+
+#include "../common/plugin_thread_pool.cpp"
+#include <limits.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Stream weld defines
+
+// Partitions the corners are split into by the high bits of their hash. The rest of the bits of a weld id are the
+// index of the vertex in its partition.
+#define GEO_STREAM_WELD_PARTITION_BITS			6
+#define GEO_STREAM_WELD_PARTITION_COUNT			(1u << GEO_STREAM_WELD_PARTITION_BITS)
+#define GEO_STREAM_WELD_INDEX_BITS				(32 - GEO_STREAM_WELD_PARTITION_BITS)
+
+// Corners in each chunk given to a thread when hashing.
+#define GEO_STREAM_WELD_CHUNK_SIZE				16384
+
+// Marks an empty slot of a hash table.
+#define GEO_STREAM_WELD_EMPTY_SLOT				ULLONG_MAX
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Stream weld structs
+
+// The vertices of one partition.
+struct geo_stream_weld_partition_s
+{
+	std::vector<float>							position_list;				// 3 floats per vertex.
+	std::vector<unsigned long long>				table;						// Open addressed (hash << 32 | vertex index), a power of 2 in size.
+	std::vector<unsigned int>					index_list;					// Index in the vertex list of each vertex, set by geo_stream_weld_end().
+};
+
+// The state of a weld. Faces are added to it in blocks.
+struct geo_stream_weld_s
+{
+	geo_stream_weld_partition_s					partition_array[GEO_STREAM_WELD_PARTITION_COUNT];
+
+	// The block being added.
+	const float*								position_array;
+	unsigned int								corner_count;
+	gp_node_face_s*								face_array;
+	std::vector<unsigned int>					hash_list;					// Hash of each corner.
+	std::vector<unsigned int>					corner_list;				// Corners by partition in corner order.
+	std::vector<unsigned int>					chunk_count_list;			// Corners of each chunk in each partition, then their corner_list offsets.
+	unsigned int								partition_start_array[GEO_STREAM_WELD_PARTITION_COUNT + 1];
+
+	// c()
+	geo_stream_weld_s(void)
+	{	position_array = 0; corner_count = 0; face_array = 0;
+	}
+};
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Stream weld functions
+
+// Return the position of a corner with -0 made 0.
+inline void geo_stream_weld_get_position(const float* position, float* position_out)
+{
+	for(unsigned int i=0; i<3; i++)
+	{	position_out[i] = position[i] + 0.0f;
+	}
+}
+
+// Return the hash of the bits of a position.
+inline unsigned int geo_stream_weld_hash(const float* position)
+{
+	// Local data
+	unsigned int								bits[3];
+	unsigned long long							hash;
+
+
+	memcpy(bits, position, sizeof(bits));
+	hash = (unsigned long long)bits[0] * 0x9E3779B97F4A7C15ull;
+	hash = (hash ^ bits[1]) * 0xC2B2AE3D27D4EB4Full;
+	hash = (hash ^ bits[2]) * 0x165667B19E3779F9ull;
+	hash ^= hash >> 29;
+	hash *= 0xFF51AFD7ED558CCDull;
+	return (unsigned int)(hash >> 32);
+}
+
+// Return the index of corner 0, 1 or 2 of a face.
+inline unsigned int& geo_stream_weld_get_corner(gp_node_face_s& face, unsigned int corner)
+{
+	return corner == 0 ? face.a : (corner == 1 ? face.b : face.c);
+}
+
+// Hash each corner and count the corners of each chunk in each partition.
+struct geo_stream_weld_hash_body_s
+{
+	geo_stream_weld_s*							weld;
+
+	BOOL operator()(unsigned int chunk_start, unsigned int chunk_end) const
+	{	for(unsigned int chunk=chunk_start; chunk<chunk_end; chunk++)
+		{	unsigned int*	count_array	= &weld->chunk_count_list[(size_t)chunk * GEO_STREAM_WELD_PARTITION_COUNT];
+			unsigned int	end			= std::min<unsigned int>((chunk + 1) * GEO_STREAM_WELD_CHUNK_SIZE, weld->corner_count);
+			float			position[3];
+			memset(count_array, 0, GEO_STREAM_WELD_PARTITION_COUNT * sizeof(unsigned int));
+			for(unsigned int i=chunk*GEO_STREAM_WELD_CHUNK_SIZE; i<end; i++)
+			{	geo_stream_weld_get_position(weld->position_array + (size_t)i * 3, position);
+				weld->hash_list[i] = geo_stream_weld_hash(position);
+				count_array[weld->hash_list[i] >> GEO_STREAM_WELD_INDEX_BITS]++;
+			}
+		}
+		return TRUE;
+	}
+};
+
+// Write the corners of each chunk to their partitions in corner order.
+struct geo_stream_weld_scatter_body_s
+{
+	geo_stream_weld_s*							weld;
+
+	BOOL operator()(unsigned int chunk_start, unsigned int chunk_end) const
+	{	for(unsigned int chunk=chunk_start; chunk<chunk_end; chunk++)
+		{	unsigned int*	offset_array	= &weld->chunk_count_list[(size_t)chunk * GEO_STREAM_WELD_PARTITION_COUNT];
+			unsigned int	end				= std::min<unsigned int>((chunk + 1) * GEO_STREAM_WELD_CHUNK_SIZE, weld->corner_count);
+			for(unsigned int i=chunk*GEO_STREAM_WELD_CHUNK_SIZE; i<end; i++)
+			{	weld->corner_list[offset_array[weld->hash_list[i] >> GEO_STREAM_WELD_INDEX_BITS]++] = i;
+			}
+		}
+		return TRUE;
+	}
+};
+
+// Weld the corners of each partition to the vertices of the partition and set the weld ids of the faces.
+struct geo_stream_weld_insert_body_s
+{
+	geo_stream_weld_s*							weld;
+
+	BOOL operator()(unsigned int partition_start, unsigned int partition_end) const
+	{	for(unsigned int partition=partition_start; partition<partition_end; partition++)
+		{	geo_stream_weld_partition_s& vertices = weld->partition_array[partition];
+			try
+			{	for(unsigned int i=weld->partition_start_array[partition]; i<weld->partition_start_array[partition + 1]; i++)
+				{	unsigned int	corner		= weld->corner_list[i];
+					unsigned int	hash		= weld->hash_list[corner];
+					unsigned int	index		= UINT_MAX;
+					float			position[3];
+					size_t			mask, slot;
+					geo_stream_weld_get_position(weld->position_array + (size_t)corner * 3, position);
+
+					// Grow the table to keep it at most half full.
+					if((vertices.position_list.size() / 3 + 1) * 2 > vertices.table.size())
+					{	std::vector<unsigned long long> table(std::max<size_t>(vertices.table.size() * 2, 1024), GEO_STREAM_WELD_EMPTY_SLOT);
+						for(size_t j=0; j<vertices.table.size(); j++)
+						{	if(vertices.table[j] != GEO_STREAM_WELD_EMPTY_SLOT)
+							{	slot = (size_t)(vertices.table[j] >> 32) & (table.size() - 1);
+								while(table[slot] != GEO_STREAM_WELD_EMPTY_SLOT)
+								{	slot = (slot + 1) & (table.size() - 1);
+								}
+								table[slot] = vertices.table[j];
+							}
+						}
+						vertices.table.swap(table);
+					}
+
+					mask = vertices.table.size() - 1;
+					for(slot=hash&mask; vertices.table[slot]!=GEO_STREAM_WELD_EMPTY_SLOT; slot=(slot + 1) & mask)
+					{	if((unsigned int)(vertices.table[slot] >> 32) == hash && !memcmp(&vertices.position_list[(size_t)(unsigned int)vertices.table[slot] * 3], position, sizeof(position)))
+						{	index = (unsigned int)vertices.table[slot];
+							break;
+						}
+					}
+					if(index == UINT_MAX)
+					{	index = (unsigned int)(vertices.position_list.size() / 3);
+						if(index >> GEO_STREAM_WELD_INDEX_BITS)
+						{	return FALSE;
+						}
+						vertices.position_list.insert(vertices.position_list.end(), position, position + 3);
+						vertices.table[slot] = (unsigned long long)hash << 32 | index;
+					}
+
+					geo_stream_weld_get_corner(weld->face_array[corner / 3], corner % 3) = partition << GEO_STREAM_WELD_INDEX_BITS | index;
+				}
+			}
+			catch(...)
+			{	return FALSE;
+			}
+		}
+		return TRUE;
+	}
+};
+
+// Copy the positions of each partition to the vertex list and free the partition.
+struct geo_stream_weld_copy_body_s
+{
+	geo_stream_weld_s*							weld;
+	gp_node_vertex_s*							vertex_array;
+
+	BOOL operator()(unsigned int partition_start, unsigned int partition_end) const
+	{	for(unsigned int partition=partition_start; partition<partition_end; partition++)
+		{	geo_stream_weld_partition_s& vertices = weld->partition_array[partition];
+			for(size_t i=0; i<vertices.index_list.size(); i++)
+			{	vertex_array[vertices.index_list[i]] = gp_node_vertex_s(vertices.position_list[i*3], vertices.position_list[i*3+1], vertices.position_list[i*3+2], 0.0f, 0.0f, 0.0f);
+			}
+			std::vector<float>().swap(vertices.position_list);
+			std::vector<unsigned int>().swap(vertices.index_list);
+		}
+		return TRUE;
+	}
+};
+
+// Weld a block of faces. position_array has 9 floats per face, the positions of corners a, b and c. Sets a, b and c
+// of the faces to weld ids. Runs on all cores. Returns FALSE if out of memory, a partition has more than
+// 2 ^ GEO_STREAM_WELD_INDEX_BITS vertices or the import was cancelled, the weld can then not be used.
+BOOL geo_stream_weld_add(geo_stream_weld_s& weld_in_out, const float* position_array, unsigned int face_count, gp_node_face_s* face_array)
+{
+	// Local data
+	geo_stream_weld_hash_body_s					hash_body;
+	geo_stream_weld_scatter_body_s				scatter_body;
+	geo_stream_weld_insert_body_s				insert_body;
+	unsigned int								chunk_count, offset;
+
+
+	if(face_count > UINT_MAX / 3)
+	{	return FALSE;
+	}
+	weld_in_out.position_array	= position_array;
+	weld_in_out.corner_count	= face_count * 3;
+	weld_in_out.face_array		= face_array;
+	chunk_count					= (weld_in_out.corner_count + GEO_STREAM_WELD_CHUNK_SIZE - 1) / GEO_STREAM_WELD_CHUNK_SIZE;
+	try
+	{	weld_in_out.hash_list.resize(weld_in_out.corner_count);
+		weld_in_out.corner_list.resize(weld_in_out.corner_count);
+		weld_in_out.chunk_count_list.resize((size_t)chunk_count * GEO_STREAM_WELD_PARTITION_COUNT);
+	}
+	catch(...)
+	{	return FALSE;
+	}
+
+	// Hash, then split the corners into partitions in corner order.
+	hash_body.weld = &weld_in_out;
+	if(!parallel_for(chunk_count, 1, hash_body, parallel_progress_s()))
+	{	return FALSE;
+	}
+
+	offset = 0;
+	for(unsigned int partition=0; partition<GEO_STREAM_WELD_PARTITION_COUNT; partition++)
+	{	weld_in_out.partition_start_array[partition] = offset;
+		for(unsigned int chunk=0; chunk<chunk_count; chunk++)
+		{	unsigned int& count = weld_in_out.chunk_count_list[(size_t)chunk * GEO_STREAM_WELD_PARTITION_COUNT + partition];
+			unsigned int chunk_offset = offset;
+			offset += count;
+			count = chunk_offset;
+		}
+	}
+	weld_in_out.partition_start_array[GEO_STREAM_WELD_PARTITION_COUNT] = offset;
+
+	scatter_body.weld = &weld_in_out;
+	if(!parallel_for(chunk_count, 1, scatter_body, parallel_progress_s()))
+	{	return FALSE;
+	}
+
+	insert_body.weld = &weld_in_out;
+	return parallel_for(GEO_STREAM_WELD_PARTITION_COUNT, 1, insert_body, parallel_progress_s());
+}
+
+// Make the weld ids of all faces added vertex indices and fill vertex_list_out with the welded positions and 0 normals.
+// Returns FALSE if out of memory or the import was cancelled. The weld can not be used again.
+BOOL geo_stream_weld_end(geo_stream_weld_s& weld_in_out, gp_node_face_s* face_array, unsigned int face_count, std::vector<gp_node_vertex_s>& vertex_list_out)
+{
+	// Local data
+	geo_stream_weld_copy_body_s					copy_body;
+	unsigned int								vertex_count;
+
+
+	// The work lists of the last block and the hash tables are not needed.
+	std::vector<unsigned int>().swap(weld_in_out.hash_list);
+	std::vector<unsigned int>().swap(weld_in_out.corner_list);
+	std::vector<unsigned int>().swap(weld_in_out.chunk_count_list);
+	try
+	{	for(unsigned int partition=0; partition<GEO_STREAM_WELD_PARTITION_COUNT; partition++)
+		{	geo_stream_weld_partition_s& vertices = weld_in_out.partition_array[partition];
+			std::vector<unsigned long long>().swap(vertices.table);
+			vertices.index_list.assign(vertices.position_list.size() / 3, UINT_MAX);
+		}
+
+		// Number the vertices in the order they are first used and replace the weld ids with vertex indices.
+		vertex_count = 0;
+		for(unsigned int i=0; i<face_count; i++)
+		{	for(unsigned int j=0; j<3; j++)
+			{	unsigned int&	corner	= geo_stream_weld_get_corner(face_array[i], j);
+				unsigned int&	index	= weld_in_out.partition_array[corner >> GEO_STREAM_WELD_INDEX_BITS].index_list[corner & ((1u << GEO_STREAM_WELD_INDEX_BITS) - 1)];
+				if(index == UINT_MAX)
+				{	index = vertex_count++;
+				}
+				corner = index;
+			}
+		}
+		vertex_list_out.resize(vertex_count);
+	}
+	catch(...)
+	{	return FALSE;
+	}
+
+	copy_body.weld			= &weld_in_out;
+	copy_body.vertex_array	= vertex_list_out.data();
+	return parallel_for(GEO_STREAM_WELD_PARTITION_COUNT, 1, copy_body, parallel_progress_s());
+}
+
+#endif // GEO_STREAM_WELD_CPP
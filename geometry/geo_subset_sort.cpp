@@ -0,0 +1,389 @@
+/*
+	===============================================================
+
+	SHADERMAP GEOMETRY SUBSET SORT SOURCE FILE
+
+	Sorts the faces of RENDER or NODE geometry by subset for
+	gp_create_render_geometry() and gp_create_node_geometry(),
+	which want triangle_array sorted from the lowest to the highest
+	subset_index, and builds the subset lists of the material ids
+	for gp_define_node_material_id().
+
+	geo_sort_subset_faces() is a stable least significant digit
+	radix sort of gp_render_face_s or gp_node_face_s on the
+	subset index, 11 bits per pass. Up to 2048 subsets sort in one
+	pass and up to 4M in two. Each pass counts the digits of each
+	chunk of faces and then scatters each chunk to its place, both
+	on the plugin thread pool (see "common/plugin_thread_pool.cpp").
+	Faces keep their order inside a subset, so the result does not
+	depend on the thread count. Faces that are already in subset
+	order are not moved.
+
+	The uv index arrays of NODE geometry have 3 indices per face
+	and are moved with their faces.
+
+	When a material is given for each subset the subsets of each
+	material are listed in subset order. The materials are in the
+	order of the first subset that uses them. Materials are any
+	unsigned int, such as an index in the file's material list.
+
+	Include this source code file in a geometry plugin after the
+	plugin core file. #include "../../geo_subset_sort.cpp"
+
+	--
+
+	Example:
+
+	geo_subset_material_s	material;
+	unsigned int*			uv_index_arrays[1]	= {uv_index_list.data()};
+
+	if(!geo_sort_subset_faces(face_list.data(), face_count, subset_count, uv_index_arrays, 1, subset_material_list.data(), &material))
+	{	... out of memory ...
+	}
+	geo_define_subset_materials(material);
+	gp_create_node_geometry(vertex_list.data(), vertex_count, face_list.data(), face_count, &node_uv_data, subset_count, FALSE);
+
+	Every subset_index must be less than subset_count.
+
+	Call parallel_shutdown() from on_shutdown().
+
+
+	SHADERMAP SDK LICENSE
+
+	The ShaderMap SDK is released under The MIT License (MIT)
+	http://opensource.org/licenses/MIT
+
+	Copyright (c) 2007-2019 Rendering Systems Inc.
+
+	Permission is hereby granted, free of charge, to any person
+	obtaining a copy of this software and associated documentation
+	files (the "Software"), to deal	in the Software without
+	restriction, including without limitation the rights to use,
+	copy, modify, merge, publish, distribute, sublicense, and/or
+	sell copies of the Software, and to permit persons to whom the
+	Software is	furnished to do so, subject to the following
+	conditions:
+
+	The above copyright notice and this permission notice shall be
+	included in	all copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+	OF MERCHANTABILITY,	FITNESS FOR A PARTICULAR PURPOSE AND
+	NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+	OTHER DEALINGS IN THE SOFTWARE.
+
+	Developed by: Neil Kemp at Rendering Systems Inc.
+
+	Online:		http://shadermap.com
+	Corporate:	http://renderingsystems.com
+
+	===============================================================
+*/
+
+#ifndef GEO_SUBSET_SORT_CPP
+#define GEO_SUBSET_SORT_CPP
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Subset sort includes
+
+#include "../common/plugin_thread_pool.cpp"
+#include <limits.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Subset sort defines
+
+// Bits of the subset index sorted by each pass.
+#define GEO_SUBSET_RADIX_BITS					11
+#define GEO_SUBSET_RADIX_SIZE					(1u << GEO_SUBSET_RADIX_BITS)
+
+// Faces in each chunk given to a thread.
+#define GEO_SUBSET_CHUNK_SIZE					65536
+
+// Marks an empty slot of the material table.
+#define GEO_SUBSET_EMPTY						UINT_MAX
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Subset sort structs
+
+// The subsets of each material id, see geo_sort_subset_faces().
+struct geo_subset_material_s
+{
+	std::vector<unsigned int>					material_start_list;		// First entry of each material id in subset_list, and the end.
+	std::vector<unsigned int>					subset_list;				// Subsets of each material id in subset order.
+};
+
+// The state of a sort shared by its passes.
+template<class FACE_T>
+struct geo_subset_sort_s
+{
+	FACE_T*										face_array;
+	unsigned int								face_count;
+	unsigned int								chunk_count;
+	unsigned int								shift;						// Lowest bit of the digit of this pass.
+	unsigned int								digit_count;				// Digits of this pass.
+	BOOL										is_first_pass;				// order_list is not set yet, faces are in face order.
+	std::vector<unsigned int>					order_list;					// Faces in the order sorted so far.
+	std::vector<unsigned int>					next_order_list;
+	std::vector<unsigned int>					chunk_count_list;			// Faces of each chunk with each digit, then their next_order_list offsets.
+	std::vector<FACE_T>							face_list;					// The faces in sorted order.
+	std::vector<unsigned int>					uv_index_list;				// An uv index array in sorted order.
+};
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Subset sort functions
+
+// Count the digits of the subsets of the faces of each chunk.
+template<class FACE_T>
+struct geo_subset_count_body_s
+{
+	geo_subset_sort_s<FACE_T>*					sort;
+
+	BOOL operator()(unsigned int chunk_start, unsigned int chunk_end) const
+	{	for(unsigned int chunk=chunk_start; chunk<chunk_end; chunk++)
+		{	unsigned int*	count_array	= &sort->chunk_count_list[(size_t)chunk * sort->digit_count];
+			unsigned int	end			= std::min<unsigned int>((chunk + 1) * GEO_SUBSET_CHUNK_SIZE, sort->face_count);
+			memset(count_array, 0, sort->digit_count * sizeof(unsigned int));
+			for(unsigned int i=chunk*GEO_SUBSET_CHUNK_SIZE; i<end; i++)
+			{	unsigned int face = sort->is_first_pass ? i : sort->order_list[i];
+				count_array[(sort->face_array[face].subset_index >> sort->shift) & (GEO_SUBSET_RADIX_SIZE - 1)]++;
+			}
+		}
+		return TRUE;
+	}
+};
+
+// Write the faces of each chunk to their place in next_order_list.
+template<class FACE_T>
+struct geo_subset_scatter_body_s
+{
+	geo_subset_sort_s<FACE_T>*					sort;
+
+	BOOL operator()(unsigned int chunk_start, unsigned int chunk_end) const
+	{	for(unsigned int chunk=chunk_start; chunk<chunk_end; chunk++)
+		{	unsigned int*	offset_array	= &sort->chunk_count_list[(size_t)chunk * sort->digit_count];
+			unsigned int	end				= std::min<unsigned int>((chunk + 1) * GEO_SUBSET_CHUNK_SIZE, sort->face_count);
+			for(unsigned int i=chunk*GEO_SUBSET_CHUNK_SIZE; i<end; i++)
+			{	unsigned int face = sort->is_first_pass ? i : sort->order_list[i];
+				sort->next_order_list[offset_array[(sort->face_array[face].subset_index >> sort->shift) & (GEO_SUBSET_RADIX_SIZE - 1)]++] = face;
+			}
+		}
+		return TRUE;
+	}
+};
+
+// Copy the faces, or an uv index array if uv_index_array is not 0, to their sorted places.
+template<class FACE_T>
+struct geo_subset_gather_body_s
+{
+	geo_subset_sort_s<FACE_T>*					sort;
+	const unsigned int*							uv_index_array;
+
+	BOOL operator()(unsigned int face_start, unsigned int face_end) const
+	{	for(unsigned int i=face_start; i<face_end; i++)
+		{	unsigned int face = sort->order_list[i];
+			if(uv_index_array)
+			{	sort->uv_index_list[(size_t)i * 3]		= uv_index_array[(size_t)face * 3];
+				sort->uv_index_list[(size_t)i * 3 + 1]	= uv_index_array[(size_t)face * 3 + 1];
+				sort->uv_index_list[(size_t)i * 3 + 2]	= uv_index_array[(size_t)face * 3 + 2];
+			}
+			else
+			{	sort->face_list[i] = sort->face_array[face];
+			}
+		}
+		return TRUE;
+	}
+};
+
+// Copy the sorted faces, or the sorted uv index array to uv_index_array if it is not 0, back to the caller's array.
+template<class FACE_T>
+struct geo_subset_copy_body_s
+{
+	geo_subset_sort_s<FACE_T>*					sort;
+	unsigned int*								uv_index_array;
+
+	BOOL operator()(unsigned int face_start, unsigned int face_end) const
+	{	if(uv_index_array)
+		{	memcpy(uv_index_array + (size_t)face_start * 3, sort->uv_index_list.data() + (size_t)face_start * 3, (size_t)(face_end - face_start) * 3 * sizeof(unsigned int));
+		}
+		else
+		{	std::copy(sort->face_list.begin() + face_start, sort->face_list.begin() + face_end, sort->face_array + face_start);
+		}
+		return TRUE;
+	}
+};
+
+// List the subsets of each material id. Materials are numbered in the order of the first subset that uses them.
+// Returns FALSE if out of memory.
+BOOL geo_list_subset_materials(const unsigned int* subset_material_array, unsigned int subset_count, geo_subset_material_s& material_out)
+{
+	// Local data
+	std::vector<unsigned int>					value_table;				// Open addressed material values.
+	std::vector<unsigned int>					id_table;					// Material id of each value_table slot.
+	std::vector<unsigned int>					subset_id_list;				// Material id of each subset.
+	size_t										mask, slot;
+	unsigned int								material_count, count, offset;
+
+
+	try
+	{	mask = 15;
+		while(mask < (size_t)subset_count * 2)
+		{	mask = mask * 2 + 1;
+		}
+		value_table.resize(mask + 1);
+		id_table.assign(mask + 1, GEO_SUBSET_EMPTY);
+		subset_id_list.resize(subset_count);
+		material_out.material_start_list.clear();
+		material_out.subset_list.resize(subset_count);
+
+		// Number the materials and count their subsets.
+		material_count = 0;
+		for(unsigned int i=0; i<subset_count; i++)
+		{	slot = (subset_material_array[i] * 0x9E3779B9u >> 7) & mask;
+			while(id_table[slot] != GEO_SUBSET_EMPTY && value_table[slot] != subset_material_array[i])
+			{	slot = (slot + 1) & mask;
+			}
+			if(id_table[slot] == GEO_SUBSET_EMPTY)
+			{	value_table[slot]	= subset_material_array[i];
+				id_table[slot]		= material_count++;
+				material_out.material_start_list.push_back(0);
+			}
+			subset_id_list[i] = id_table[slot];
+			material_out.material_start_list[id_table[slot]]++;
+		}
+		material_out.material_start_list.push_back(0);
+	}
+	catch(...)
+	{	return FALSE;
+	}
+
+	offset = 0;
+	for(unsigned int i=0; i<=material_count; i++)
+	{	count = material_out.material_start_list[i];
+		material_out.material_start_list[i] = offset;
+		offset += count;
+	}
+	for(unsigned int i=0; i<subset_count; i++)
+	{	material_out.subset_list[material_out.material_start_list[subset_id_list[i]]++] = i;
+	}
+	for(unsigned int i=material_count; i>0; i--)
+	{	material_out.material_start_list[i] = material_out.material_start_list[i - 1];
+	}
+	material_out.material_start_list[0] = 0;
+	return TRUE;
+}
+
+// Sort face_array by subset, keeping the order of the faces of each subset, and move the 3 indices of each face in each
+// of the uv_index_array_count arrays of uv_index_arrays with it. Every subset_index must be less than subset_count. If
+// subset_material_array and material_out are not 0 the subsets of each material of subset_material_array, one per
+// subset, are listed in material_out. Returns FALSE if out of memory, the arrays are then unchanged, or if the import
+// was cancelled, the arrays can then not be used.
+template<class FACE_T>
+BOOL geo_sort_subset_faces(FACE_T* face_array, unsigned int face_count, unsigned int subset_count, unsigned int** uv_index_arrays, unsigned int uv_index_array_count,
+						   const unsigned int* subset_material_array, geo_subset_material_s* material_out)
+{
+	// Local data
+	geo_subset_sort_s<FACE_T>					sort;
+	geo_subset_count_body_s<FACE_T>				count_body;
+	geo_subset_scatter_body_s<FACE_T>			scatter_body;
+	geo_subset_gather_body_s<FACE_T>			gather_body;
+	geo_subset_copy_body_s<FACE_T>				copy_body;
+	unsigned int								offset, count;
+	BOOL										is_sorted;
+
+
+	if(subset_material_array && material_out && !geo_list_subset_materials(subset_material_array, subset_count, *material_out))
+	{	return FALSE;
+	}
+
+	// Faces are usually in subset order already.
+	is_sorted = TRUE;
+	for(unsigned int i=1; i<face_count && is_sorted; i++)
+	{	is_sorted = face_array[i].subset_index >= face_array[i-1].subset_index;
+	}
+	if(is_sorted)
+	{	return TRUE;
+	}
+
+	sort.face_array				= face_array;
+	sort.face_count				= face_count;
+	sort.chunk_count			= (face_count + GEO_SUBSET_CHUNK_SIZE - 1) / GEO_SUBSET_CHUNK_SIZE;
+	sort.is_first_pass			= TRUE;
+	count_body.sort				= &sort;
+	scatter_body.sort			= &sort;
+	gather_body.sort			= &sort;
+	copy_body.sort				= &sort;
+	try
+	{	sort.order_list.resize(face_count);
+		sort.next_order_list.resize(face_count);
+		sort.chunk_count_list.resize((size_t)sort.chunk_count * GEO_SUBSET_RADIX_SIZE);
+		sort.face_list.resize(face_count);
+		sort.uv_index_list.resize(uv_index_array_count ? (size_t)face_count * 3 : 0);
+	}
+	catch(...)
+	{	return FALSE;
+	}
+
+	// Sort the face order by each digit of the subset index, lowest first. Each pass keeps the order of the last one for
+	// equal digits, so faces with the same subset stay in face order.
+	for(sort.shift=0; sort.shift<32 && (subset_count - 1) >> sort.shift; sort.shift+=GEO_SUBSET_RADIX_BITS)
+	{	sort.digit_count = std::min<unsigned int>(GEO_SUBSET_RADIX_SIZE, ((subset_count - 1) >> sort.shift) + 1);
+		if(!parallel_for(sort.chunk_count, 1, count_body, parallel_progress_s()))
+		{	return FALSE;
+		}
+		offset = 0;
+		for(unsigned int digit=0; digit<sort.digit_count; digit++)
+		{	for(unsigned int chunk=0; chunk<sort.chunk_count; chunk++)
+			{	count = sort.chunk_count_list[(size_t)chunk * sort.digit_count + digit];
+				sort.chunk_count_list[(size_t)chunk * sort.digit_count + digit] = offset;
+				offset += count;
+			}
+		}
+		if(!parallel_for(sort.chunk_count, 1, scatter_body, parallel_progress_s()))
+		{	return FALSE;
+		}
+		sort.order_list.swap(sort.next_order_list);
+		sort.is_first_pass = FALSE;
+	}
+
+	// Move the faces and the uv indices to their sorted places.
+	gather_body.uv_index_array	= 0;
+	copy_body.uv_index_array	= 0;
+	if(!parallel_for(face_count, GEO_SUBSET_CHUNK_SIZE, gather_body, parallel_progress_s()) ||
+	   !parallel_for(face_count, GEO_SUBSET_CHUNK_SIZE, copy_body, parallel_progress_s()))
+	{	return FALSE;
+	}
+	for(unsigned int i=0; i<uv_index_array_count; i++)
+	{	gather_body.uv_index_array	= uv_index_arrays[i];
+		copy_body.uv_index_array	= uv_index_arrays[i];
+		if(!parallel_for(face_count, GEO_SUBSET_CHUNK_SIZE, gather_body, parallel_progress_s()) ||
+		   !parallel_for(face_count, GEO_SUBSET_CHUNK_SIZE, copy_body, parallel_progress_s()))
+		{	return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+// Define a node material id for each material of a geo_sort_subset_faces() material list, in material order.
+void geo_define_subset_materials(const geo_subset_material_s& material)
+{
+	for(size_t i=0; i+1<material.material_start_list.size(); i++)
+	{	gp_define_node_material_id(material.material_start_list[i + 1] - material.material_start_list[i], material.subset_list.data() + material.material_start_list[i]);
+	}
+}
+
+#endif // GEO_SUBSET_SORT_CPP
@@ -0,0 +1,279 @@
+/*
+	===============================================================
+
+	SHADERMAP GEOMETRY TEXT PARSE SOURCE FILE
+
+	Reads numbers and names from the lines of text model files
+	such as OBJ, ASCII PLY and ASCII STL.
+
+	The functions read from a pointer into a mapped file up to
+	the end of the line and never past it, so a file does not have
+	to end with a null character. Numbers are parsed without
+	strtod(), which depends on the locale of the process and is
+	several times slower. A number is read into a double within a
+	few units of its last bit, so a double can be a little off
+	strtod() for numbers of more than 15 significant digits or
+	exponents past 22. A number parsed as a float is the same float
+	strtof() returns: the rare numbers that are too close to half
+	way between two floats to round the double are parsed again
+	with strtof().
+
+	Include this source code file in a geometry plugin after the
+	plugin core file. #include "../../geo_text_parse.cpp"
+
+	--
+
+	Example:
+
+	for(pointer=data; pointer<end; pointer=line_end+1)
+	{	line_end = geo_text_get_line_end(pointer, end);
+		geo_text_skip_space(pointer, line_end);
+		if(line_end - pointer > 2 && pointer[0] == 'v' && geo_text_is_space(pointer[1]))
+		{	pointer++;
+			for(i=0; i<3; i++)
+			{	geo_text_skip_space(pointer, line_end);
+				if(!geo_text_parse_float(pointer, line_end, position[i]))
+				{	... not a number ...
+				}
+			}
+		}
+	}
+
+
+	SHADERMAP SDK LICENSE
+
+	The ShaderMap SDK is released under The MIT License (MIT)
+	http://opensource.org/licenses/MIT
+
+	Copyright (c) 2007-2019 Rendering Systems Inc.
+
+	Permission is hereby granted, free of charge, to any person
+	obtaining a copy of this software and associated documentation
+	files (the "Software"), to deal	in the Software without
+	restriction, including without limitation the rights to use,
+	copy, modify, merge, publish, distribute, sublicense, and/or
+	sell copies of the Software, and to permit persons to whom the
+	Software is	furnished to do so, subject to the following
+	conditions:
+
+	The above copyright notice and this permission notice shall be
+	included in	all copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+	OF MERCHANTABILITY,	FITNESS FOR A PARTICULAR PURPOSE AND
+	NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+	OTHER DEALINGS IN THE SOFTWARE.
+
+	Developed by: Neil Kemp at Rendering Systems Inc.
+
+	Online:		http://shadermap.com
+	Corporate:	http://renderingsystems.com
+
+	===============================================================
+*/
+
+#ifndef GEO_TEXT_PARSE_CPP
+#define GEO_TEXT_PARSE_CPP
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Text parse includes
+
+#include <float.h>
+#include <locale.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Text parse functions
+
+// Return TRUE if c is a space inside of a line.
+inline BOOL geo_text_is_space(char c)
+{
+	return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+// Skip spaces up to line_end.
+inline void geo_text_skip_space(const char*& pointer, const char* line_end)
+{
+	while(pointer < line_end && geo_text_is_space(*pointer))
+	{	pointer++;
+	}
+}
+
+// Skip a word and the spaces after it up to line_end.
+inline void geo_text_skip_word(const char*& pointer, const char* line_end)
+{
+	while(pointer < line_end && !geo_text_is_space(*pointer))
+	{	pointer++;
+	}
+	geo_text_skip_space(pointer, line_end);
+}
+
+// Return the new line character ending the line at pointer, or end if it is the last line.
+inline const char* geo_text_get_line_end(const char* pointer, const char* end)
+{
+	const char* line_end = pointer < end ? (const char*)memchr(pointer, '\n', end - pointer) : 0;
+
+	return line_end ? line_end : end;
+}
+
+// Return TRUE if the word at pointer is keyword. The word ends at a space or line_end.
+inline BOOL geo_text_is_keyword(const char* pointer, const char* line_end, const char* keyword)
+{
+	size_t keyword_size = strlen(keyword);
+
+	return (size_t)(line_end - pointer) >= keyword_size && !memcmp(pointer, keyword, keyword_size) &&
+		   (pointer + keyword_size == line_end || geo_text_is_space(pointer[keyword_size]));
+}
+
+// Return the rest of the line without the spaces around it.
+std::string geo_text_get_rest(const char* pointer, const char* line_end)
+{
+	geo_text_skip_space(pointer, line_end);
+	while(line_end > pointer && geo_text_is_space(line_end[-1]))
+	{	line_end--;
+	}
+	return std::string(pointer, line_end);
+}
+
+// Parse a decimal number such as "-1.25e-3" at pointer. Returns FALSE if there is no number. pointer is left after
+// the number.
+inline BOOL geo_text_parse_double(const char*& pointer, const char* line_end, double& value_out)
+{
+	// Local data
+	static const double							power_array[] = {	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+																	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+	unsigned long long							mantissa;
+	unsigned int								digit;
+	int											exponent, exponent_value;
+	BOOL										is_negative, is_exponent_negative, is_digit;
+	double										value;
+
+
+	mantissa	= 0;
+	exponent	= 0;
+	is_digit	= FALSE;
+	is_negative	= FALSE;
+	if(pointer < line_end && (*pointer == '-' || *pointer == '+'))
+	{	is_negative = *pointer == '-';
+		pointer++;
+	}
+
+	// Keep the first 18 digits, they are exact in the mantissa and more than a float holds.
+	while(pointer < line_end && (digit = (unsigned int)(*pointer - '0')) < 10)
+	{	if(mantissa < 100000000000000000ull)
+		{	mantissa = mantissa * 10 + digit;
+		}
+		else
+		{	exponent++;
+		}
+		is_digit = TRUE;
+		pointer++;
+	}
+	if(pointer < line_end && *pointer == '.')
+	{	pointer++;
+		while(pointer < line_end && (digit = (unsigned int)(*pointer - '0')) < 10)
+		{	if(mantissa < 100000000000000000ull)
+			{	mantissa = mantissa * 10 + digit;
+				exponent--;
+			}
+			is_digit = TRUE;
+			pointer++;
+		}
+	}
+	if(!is_digit)
+	{	return FALSE;
+	}
+
+	if(pointer < line_end && (*pointer == 'e' || *pointer == 'E'))
+	{	pointer++;
+		is_exponent_negative = FALSE;
+		if(pointer < line_end && (*pointer == '-' || *pointer == '+'))
+		{	is_exponent_negative = *pointer == '-';
+			pointer++;
+		}
+		if(pointer >= line_end || (unsigned int)(*pointer - '0') >= 10)
+		{	return FALSE;
+		}
+		exponent_value = 0;
+		while(pointer < line_end && (digit = (unsigned int)(*pointer - '0')) < 10)
+		{	if(exponent_value < 100000)
+			{	exponent_value = exponent_value * 10 + (int)digit;
+			}
+			pointer++;
+		}
+		exponent += is_exponent_negative ? -exponent_value : exponent_value;
+	}
+
+	// Powers of 10 up to 22 are exact doubles.
+	value = (double)mantissa;
+	if(mantissa && exponent)
+	{	if(exponent > 0 && exponent <= 22)
+		{	value *= power_array[exponent];
+		}
+		else if(exponent < 0 && exponent >= -22)
+		{	value /= power_array[-exponent];
+		}
+		else
+		{	value *= pow(10.0, (double)exponent);
+		}
+	}
+	value_out = is_negative ? -value : value;
+	return TRUE;
+}
+
+// Parse the number from start to end with strtof(). The decimal point is replaced with the one of the locale.
+float geo_text_strtof(const char* start, const char* end)
+{
+	// Local data
+	std::string									text(start, end);
+	const char*									point;
+	size_t										point_index;
+
+
+	point		= localeconv()->decimal_point;
+	point_index	= text.find('.');
+	if(point_index != std::string::npos && point && *point)
+	{	text.replace(point_index, 1, point);
+	}
+	return strtof(text.c_str(), 0);
+}
+
+// Parse a decimal number as a float. Returns FALSE if there is no number or it is out of float range.
+inline BOOL geo_text_parse_float(const char*& pointer, const char* line_end, float& value_out)
+{
+	// Local data
+	const char*									start;
+	double										value;
+	unsigned long long							bits;
+
+
+	start = pointer;
+	if(!geo_text_parse_double(pointer, line_end, value) || fabs(value) > 3.4028234663852886e38)
+	{	return FALSE;
+	}
+
+	// A float drops the low 29 bits of the mantissa of a double, they are 0x10000000 half way between two floats. The
+	// double is within a few units of its last bit, so rounding it gives the float strtof() does unless those bits are
+	// within 8 of half way. More bits are dropped for floats smaller than FLT_MIN, they are always parsed again.
+	memcpy(&bits, &value, sizeof(bits));
+	if((bits & 0x1FFFFFFFull) - (0x10000000ull - 8) <= 16 || (value != 0.0 && fabs(value) < FLT_MIN))
+	{	value_out = geo_text_strtof(start, pointer);
+	}
+	else
+	{	value_out = (float)value;
+	}
+	return TRUE;
+}
+
+#endif // GEO_TEXT_PARSE_CPP
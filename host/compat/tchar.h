@@ -0,0 +1,32 @@
+/*
+	===============================================================
+
+	SHADERMAP HOST COMPATIBILITY HEADER - tchar.h
+
+	A minimal stand-in for the Win32 "tchar.h" header for Linux
+	builds of plugins. ShaderMap plugins are always built with the
+	Unicode character set so all text macros produce wide strings.
+
+	See "host/compat/windows.h" for details.
+
+	The ShaderMap SDK is released under The MIT License (MIT)
+	http://opensource.org/licenses/MIT
+
+	Copyright (c) 2007-2019 Rendering Systems Inc.
+
+	===============================================================
+*/
+
+#ifndef SM_HOST_COMPAT_TCHAR_H
+#define SM_HOST_COMPAT_TCHAR_H
+
+#include <wchar.h>
+
+typedef wchar_t									TCHAR;
+
+// Two level macro so that macro arguments such as __FILE__ are expanded before they are widened.
+#define __T(x)									L ## x
+#define _T(x)									__T(x)
+#define _TEXT(x)								__T(x)
+
+#endif
@@ -0,0 +1,177 @@
+/*
+	===============================================================
+
+	SHADERMAP HOST COMPATIBILITY HEADER - windows.h
+
+	A minimal stand-in for the Win32 "windows.h" header. It allows
+	the plugin core files and plugin sources to be compiled as
+	shared objects (*.so) on Linux so they can be loaded by the
+	headless hosts found in the "host" folder.
+
+	Only the types, macros and functions used by the SDK are
+	defined here. Add this folder to the include path when
+	building a plugin for Linux. Example:
+
+	g++ -O2 -shared -fPIC -I host/compat maps/examples/source_ts_normal/source_ts_normal.cpp -o source_ts_normal.so
+
+	This file is never used when building with Visual Studio.
+
+
+	SHADERMAP SDK LICENSE
+
+	The ShaderMap SDK is released under The MIT License (MIT)
+	http://opensource.org/licenses/MIT
+
+	Copyright (c) 2007-2019 Rendering Systems Inc.
+
+	Permission is hereby granted, free of charge, to any person
+	obtaining a copy of this software and associated documentation
+	files (the "Software"), to deal	in the Software without
+	restriction, including without limitation the rights to use,
+	copy, modify, merge, publish, distribute, sublicense, and/or
+	sell copies of the Software, and to permit persons to whom the
+	Software is	furnished to do so, subject to the following
+	conditions:
+
+	The above copyright notice and this permission notice shall be
+	included in	all copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+	OF MERCHANTABILITY,	FITNESS FOR A PARTICULAR PURPOSE AND
+	NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+	OTHER DEALINGS IN THE SOFTWARE.
+
+	Online:		http://shadermap.com
+	Corporate:	http://renderingsystems.com
+
+	===============================================================
+*/
+
+#ifndef SM_HOST_COMPAT_WINDOWS_H
+#define SM_HOST_COMPAT_WINDOWS_H
+
+#ifdef _WIN32
+#error "host/compat/windows.h must not be used on Windows. Remove host/compat from the include path."
+#endif
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// General includes
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <errno.h>
+#include <wchar.h>
+#include <math.h>
+#include <new>
+#include <string>
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Types
+
+typedef int										BOOL;
+typedef unsigned char							BYTE;
+typedef unsigned short							WORD;
+typedef unsigned int							DWORD;					// 32 bit as on Windows.
+typedef unsigned int							UINT;
+typedef int										LONG;					// 32 bit as on Windows.
+typedef DWORD									COLORREF;
+typedef wchar_t									WCHAR;
+
+// A rectangle - same layout as the Win32 RECT.
+struct RECT
+{
+	LONG										left;
+	LONG										top;
+	LONG										right;
+	LONG										bottom;
+};
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Defines
+
+#ifndef TRUE
+#define TRUE									1
+#endif
+
+#ifndef FALSE
+#define FALSE									0
+#endif
+
+#define RGB(r, g, b)							((COLORREF)(((BYTE)(r) | ((WORD)((BYTE)(g)) << 8)) | (((DWORD)(BYTE)(b)) << 16)))
+#define GetRValue(rgb)							((BYTE)(rgb))
+#define GetGValue(rgb)							((BYTE)(((WORD)(rgb)) >> 8))
+#define GetBValue(rgb)							((BYTE)((rgb) >> 16))
+
+// Storage-class attributes such as __declspec(dllexport) in "half.hpp" have no meaning here. Plugin exports use DLL_EXPORT from the core files.
+#define __declspec(x)
+
+#define ZeroMemory(destination, length)		memset((destination), 0, (length))
+#define CopyMemory(destination, source, length)	memcpy((destination), (source), (length))
+
+// MSVC treats __FUNCTION__ as a string literal so _T(__FUNCTION__) is a wide string literal.
+// GCC and Clang do not, the token pasting in _T() produces L__FUNCTION__ which is widened here at runtime instead.
+#define L__FUNCTION__							compat_widen_string(__FUNCTION__)
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Functions
+
+// Widen a narrow string. The returned pointer is valid until the next call on the same thread.
+inline const wchar_t* compat_widen_string(const char* narrow_string)
+{
+	static thread_local std::wstring			wide_string;
+
+	wide_string.assign(narrow_string, narrow_string + strlen(narrow_string));
+	return wide_string.c_str();
+}
+
+// Secure CRT memcpy_s.
+inline int memcpy_s(void* destination, size_t destination_size, const void* source, size_t count)
+{
+	if(count == 0)
+	{	return 0;
+	}
+	if(!destination || !source || destination_size < count)
+	{	if(destination && destination_size)
+		{	memset(destination, 0, destination_size);
+		}
+		return EINVAL;
+	}
+	memcpy(destination, source, count);
+	return 0;
+}
+
+// Secure CRT _wfopen_s. The wide file path and mode are converted to the current locale multibyte encoding.
+inline int _wfopen_s(FILE** file_out, const wchar_t* file_path, const wchar_t* mode)
+{
+	// Local data
+	char										narrow_path[4096], narrow_mode[16];
+
+
+	*file_out = 0;
+	if(wcstombs(narrow_path, file_path, sizeof(narrow_path)) == (size_t)-1 ||
+	   wcstombs(narrow_mode, mode, sizeof(narrow_mode)) == (size_t)-1)
+	{	return EINVAL;
+	}
+	narrow_path[sizeof(narrow_path) - 1] = 0;
+	narrow_mode[sizeof(narrow_mode) - 1] = 0;
+
+	*file_out = fopen(narrow_path, narrow_mode);
+	return *file_out ? 0 : errno;
+}
+
+#endif
@@ -0,0 +1,694 @@
+/*
+	===============================================================
+
+	SHADERMAP HEADLESS HOST - COMMON SOURCE FILE
+
+	Shared code for the headless Linux hosts found in this folder.
+	The hosts stand in for the ShaderMap application so that
+	plugins built as shared objects (*.so) can be run, tested and
+	benchmarked on machines without ShaderMap, for example Linux
+	render nodes.
+
+	This file contains plugin library loading, property storage,
+	timing, memory measurement, half float conversion and small
+	string helpers. It is included by the host source files the
+	same way plugins include the plugin core files.
+
+	#include "host_common.cpp"
+
+
+	SHADERMAP SDK LICENSE
+
+	The ShaderMap SDK is released under The MIT License (MIT)
+	http://opensource.org/licenses/MIT
+
+	Copyright (c) 2007-2019 Rendering Systems Inc.
+
+	Permission is hereby granted, free of charge, to any person
+	obtaining a copy of this software and associated documentation
+	files (the "Software"), to deal	in the Software without
+	restriction, including without limitation the rights to use,
+	copy, modify, merge, publish, distribute, sublicense, and/or
+	sell copies of the Software, and to permit persons to whom the
+	Software is	furnished to do so, subject to the following
+	conditions:
+
+	The above copyright notice and this permission notice shall be
+	included in	all copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+	OF MERCHANTABILITY,	FITNESS FOR A PARTICULAR PURPOSE AND
+	NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+	OTHER DEALINGS IN THE SOFTWARE.
+
+	Online:		http://shadermap.com
+	Corporate:	http://renderingsystems.com
+
+	===============================================================
+*/
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// General includes
+
+#include "windows.h"
+#include <tchar.h>
+#include <dlfcn.h>
+#include <locale.h>
+#include <stdarg.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Host defines
+
+// Size of the function pointer array passed to "plugin_initialize()". Matches the element ranges documented in the plugin cores.
+#define HOST_FUNCTION_POINTER_COUNT				1000
+
+// Property types - in the same order as the add property functions in the plugin cores.
+#define HOST_PROPERTY_PAGELIST					0
+#define HOST_PROPERTY_FILE						1
+#define HOST_PROPERTY_CHECKBOX					2
+#define HOST_PROPERTY_LIST						3
+#define HOST_PROPERTY_NUMBERBOX_INT				4
+#define HOST_PROPERTY_NUMBERBOX_FLOAT			5
+#define HOST_PROPERTY_COLORBOX					6
+#define HOST_PROPERTY_SLIDER					7
+#define HOST_PROPERTY_RANGE_SLIDER				8
+#define HOST_PROPERTY_COORDSYS					9
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Host structs
+
+// Exported plugin function types. Every plugin type exports the same set of functions, see the bottom of the plugin core files.
+typedef void									(*host_plugin_version_type)(unsigned int& /*version_major_out*/, unsigned int& /*version_minor_out*/);
+typedef BOOL									(*host_plugin_initialize_type)(void** /*function_pointer_array*/);
+typedef BOOL									(*host_plugin_process_type)(void* /*param_0*/, void* /*param_1*/);
+typedef BOOL									(*host_plugin_shutdown_type)(void);
+typedef BOOL									(*host_plugin_custom_type)(void* /*param_0*/, void* /*param_1*/, void* /*param_2*/);
+
+// A loaded plugin shared object.
+struct host_library_s
+{
+	void*										handle;
+	std::string									file_path;
+	unsigned int								sdk_version_major;
+	unsigned int								sdk_version_minor;
+
+	host_plugin_version_type					plugin_version;
+	host_plugin_initialize_type					plugin_initialize;
+	host_plugin_process_type					plugin_process;
+	host_plugin_shutdown_type					plugin_shutdown;
+	host_plugin_custom_type						plugin_custom[4];		// Not every plugin type exports all of these, missing exports are 0.
+
+	// c()
+	host_library_s(void)
+	{	handle = 0;
+		sdk_version_major = sdk_version_minor = 0;
+		plugin_version = 0; plugin_initialize = 0; plugin_process = 0; plugin_shutdown = 0;
+		plugin_custom[0] = plugin_custom[1] = plugin_custom[2] = plugin_custom[3] = 0;
+	}
+};
+
+// A property control added by a plugin with one of the add property functions.
+// The same struct stores the defaults (per plugin) and the current values (per map or filter instance).
+struct host_property_s
+{
+	unsigned int								type;					// HOST_PROPERTY_ type.
+	std::wstring								caption;
+	unsigned int								page_index;
+	std::vector<std::wstring>					string_list;			// Pagelist and list strings.
+	int											int_min, int_max;		// Numberbox int, slider and range slider limits.
+	float										float_min, float_max;	// Numberbox float limits.
+
+	int											value_int;				// Checkbox, list, pagelist, numberbox int, colorbox, slider, coordsys and the low position of a range slider.
+	int											value_int_high;			// High position of a range slider.
+	float										value_float;			// Numberbox float.
+	std::wstring								value_file;				// File path.
+
+	// c()
+	host_property_s(void)
+	{	type = HOST_PROPERTY_CHECKBOX; page_index = 0;
+		int_min = int_max = 0; float_min = float_max = 0.0f;
+		value_int = value_int_high = 0; value_float = 0.0f;
+	}
+};
+
+// Collects samples of a measurement and reports min, median, mean and max.
+struct host_sample_list_s
+{
+	std::vector<double>							sample_list;
+
+	void add(double sample)
+	{	sample_list.push_back(sample);
+	}
+
+	double min(void) const
+	{	return sample_list.empty() ? 0.0 : *std::min_element(sample_list.begin(), sample_list.end());
+	}
+
+	double max(void) const
+	{	return sample_list.empty() ? 0.0 : *std::max_element(sample_list.begin(), sample_list.end());
+	}
+
+	double mean(void) const
+	{	double sum = 0.0;
+		for(size_t i=0; i<sample_list.size(); i++)
+		{	sum += sample_list[i];
+		}
+		return sample_list.empty() ? 0.0 : sum / (double)sample_list.size();
+	}
+
+	double median(void) const
+	{	if(sample_list.empty())
+		{	return 0.0;
+		}
+		std::vector<double> sorted_list(sample_list);
+		std::sort(sorted_list.begin(), sorted_list.end());
+		size_t half = sorted_list.size() / 2;
+		return (sorted_list.size() & 1) ? sorted_list[half] : (sorted_list[half - 1] + sorted_list[half]) * 0.5;
+	}
+};
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Host log
+
+// Serializes host output from plugin threads.
+std::mutex										host_log_mutex;
+
+// Verbosity of plugin messages (status strings, progress). Errors are always printed.
+BOOL											host_is_verbose = FALSE;
+
+// Print a message to stderr. Thread safe.
+void host_log(const char* format, ...)
+{
+	va_list										arg_list;
+	std::lock_guard<std::mutex>					lock(host_log_mutex);
+
+	va_start(arg_list, format);
+	vfprintf(stderr, format, arg_list);
+	va_end(arg_list);
+	fputc('\n', stderr);
+}
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// String helpers
+
+// Convert a wide string to a narrow string in the current locale.
+std::string host_narrow(const wchar_t* wide_string)
+{
+	// Local data
+	std::string									narrow_string;
+	size_t										length;
+
+
+	if(!wide_string)
+	{	return narrow_string;
+	}
+	length = wcstombs(0, wide_string, 0);
+	if(length == (size_t)-1)
+	{	// Not representable in the locale - keep ASCII only.
+		for(; *wide_string; wide_string++)
+		{	narrow_string.push_back(*wide_string < 128 ? (char)*wide_string : '?');
+		}
+		return narrow_string;
+	}
+	narrow_string.resize(length);
+	wcstombs(&narrow_string[0], wide_string, length + 1);
+	return narrow_string;
+}
+
+// Convert a narrow string in the current locale to a wide string.
+std::wstring host_widen(const char* narrow_string)
+{
+	// Local data
+	std::wstring								wide_string;
+	size_t										length;
+
+
+	if(!narrow_string)
+	{	return wide_string;
+	}
+	length = mbstowcs(0, narrow_string, 0);
+	if(length == (size_t)-1)
+	{	for(; *narrow_string; narrow_string++)
+		{	wide_string.push_back((wchar_t)(unsigned char)*narrow_string);
+		}
+		return wide_string;
+	}
+	wide_string.resize(length);
+	mbstowcs(&wide_string[0], narrow_string, length + 1);
+	return wide_string;
+}
+
+// Return the lower case extension of a file path without the dot.
+std::string host_get_extension(const std::string& file_path)
+{
+	// Local data
+	std::string									extension;
+	size_t										dot_position, slash_position;
+
+
+	dot_position	= file_path.find_last_of('.');
+	slash_position	= file_path.find_last_of('/');
+	if(dot_position == std::string::npos || (slash_position != std::string::npos && dot_position < slash_position))
+	{	return extension;
+	}
+	extension = file_path.substr(dot_position + 1);
+	for(size_t i=0; i<extension.size(); i++)
+	{	extension[i] = (char)tolower((unsigned char)extension[i]);
+	}
+	return extension;
+}
+
+// Return the file name part of a file path.
+std::string host_get_file_name(const std::string& file_path)
+{
+	size_t slash_position = file_path.find_last_of("/\\");
+	return slash_position == std::string::npos ? file_path : file_path.substr(slash_position + 1);
+}
+
+// Return the directory part of a file path including the trailing slash, or an empty string.
+std::string host_get_directory(const std::string& file_path)
+{
+	size_t slash_position = file_path.find_last_of("/\\");
+	return slash_position == std::string::npos ? std::string() : file_path.substr(0, slash_position + 1);
+}
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Timing and memory
+
+// Return a monotonic time in seconds.
+double host_get_time(void)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Reset the peak resident set size of the process so that the next "host_get_peak_rss()" reports the peak from this point.
+// Returns FALSE if the kernel does not support resetting the peak, in that case the lifetime peak is reported.
+BOOL host_reset_peak_rss(void)
+{
+	// Local data
+	FILE*										fp;
+	BOOL										is_success;
+
+
+	fp = fopen("/proc/self/clear_refs", "w");
+	if(!fp)
+	{	return FALSE;
+	}
+	is_success = fputs("5", fp) >= 0;
+	is_success = (fclose(fp) == 0) && is_success;
+	return is_success;
+}
+
+// Return the peak resident set size of the process in bytes.
+unsigned long long host_get_peak_rss(void)
+{
+	// Local data
+	FILE*										fp;
+	char										line[256];
+	unsigned long long							peak_kb;
+	struct rusage								usage;
+
+
+	// VmHWM honours "host_reset_peak_rss()".
+	fp = fopen("/proc/self/status", "r");
+	if(fp)
+	{	while(fgets(line, sizeof(line), fp))
+		{	if(sscanf(line, "VmHWM: %llu kB", &peak_kb) == 1)
+			{	fclose(fp);
+				return peak_kb * 1024ull;
+			}
+		}
+		fclose(fp);
+	}
+
+	// Fallback to the lifetime peak.
+	getrusage(RUSAGE_SELF, &usage);
+	return (unsigned long long)usage.ru_maxrss * 1024ull;
+}
+
+// Return the current resident set size of the process in bytes.
+unsigned long long host_get_current_rss(void)
+{
+	// Local data
+	FILE*										fp;
+	char										line[256];
+	unsigned long long							rss_kb;
+
+
+	fp = fopen("/proc/self/status", "r");
+	if(!fp)
+	{	return 0;
+	}
+	while(fgets(line, sizeof(line), fp))
+	{	if(sscanf(line, "VmRSS: %llu kB", &rss_kb) == 1)
+		{	fclose(fp);
+			return rss_kb * 1024ull;
+		}
+	}
+	fclose(fp);
+	return 0;
+}
+
+
+// Clear the soft-dirty bits of all pages of the process. Used with "host_get_written_byte_count()" to measure how much
+// of a buffer a plugin writes. Returns FALSE if the kernel does not support soft-dirty tracking.
+BOOL host_clear_soft_dirty(void)
+{
+	// Local data
+	FILE*										fp;
+	BOOL										is_success;
+
+
+	fp = fopen("/proc/self/clear_refs", "w");
+	if(!fp)
+	{	return FALSE;
+	}
+	is_success = fputs("4", fp) >= 0;
+	is_success = (fclose(fp) == 0) && is_success;
+	return is_success;
+}
+
+// Return the number of bytes in the pages of a buffer that were written since "host_clear_soft_dirty()".
+// The count is rounded to whole pages. Returns ULLONG_MAX if /proc/self/pagemap can not be read.
+unsigned long long host_get_written_byte_count(const void* buffer, size_t buffer_size)
+{
+	// Local data
+	FILE*										fp;
+	size_t										page_size, first_page, last_page;
+	unsigned long long							entry, written_count;
+
+
+	if(!buffer || !buffer_size)
+	{	return 0;
+	}
+	fp = fopen("/proc/self/pagemap", "rb");
+	if(!fp)
+	{	return ULLONG_MAX;
+	}
+	page_size		= (size_t)sysconf(_SC_PAGESIZE);
+	first_page		= (size_t)buffer / page_size;
+	last_page		= ((size_t)buffer + buffer_size - 1) / page_size;
+	written_count	= 0;
+	if(fseeko(fp, (off_t)(first_page * sizeof(entry)), SEEK_SET) != 0)
+	{	fclose(fp);
+		return ULLONG_MAX;
+	}
+	for(size_t page=first_page; page<=last_page; page++)
+	{	if(fread(&entry, sizeof(entry), 1, fp) != 1)
+		{	fclose(fp);
+			return ULLONG_MAX;
+		}
+		if(entry & (1ull << 55))			// Bit 55 - page is soft-dirty.
+		{	written_count += page_size;
+		}
+	}
+	fclose(fp);
+	return written_count;
+}
+
+// Return if the kernel tracks soft-dirty pages. Clearing can succeed on kernels built without soft-dirty support in which
+// case no page is ever reported as written, this checks a written page is seen.
+BOOL host_is_soft_dirty_supported(void)
+{
+	// Local data
+	std::vector<unsigned char>					test_page;
+	size_t										page_size;
+
+
+	page_size = (size_t)sysconf(_SC_PAGESIZE);
+	test_page.assign(page_size * 2, 0);
+	if(!host_clear_soft_dirty())
+	{	return FALSE;
+	}
+	test_page[page_size] = 1;
+	return host_get_written_byte_count(&test_page[page_size], 1) == page_size;
+}
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Half float conversion
+
+// Convert a half float (as raw bits) to a float.
+float host_half_to_float(unsigned short half_bits)
+{
+	// Local data
+	unsigned int								sign, exponent, mantissa, bits;
+	float										value;
+
+
+	sign		= (half_bits & 0x8000u) << 16;
+	exponent	= (half_bits >> 10) & 0x1Fu;
+	mantissa	= half_bits & 0x3FFu;
+
+	if(exponent == 0)
+	{	// Zero or subnormal.
+		value = ldexpf((float)mantissa, -24);
+		return sign ? -value : value;
+	}
+	if(exponent == 31)
+	{	bits = sign | 0x7F800000u | (mantissa << 13);
+	}
+	else
+	{	bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+	}
+	memcpy(&value, &bits, sizeof(float));
+	return value;
+}
+
+// Convert a float to a half float (as raw bits) with round to nearest even.
+unsigned short host_float_to_half(float value)
+{
+	// Local data
+	unsigned int								bits, sign, exponent, mantissa, shift, round_bits, half_value;
+
+
+	memcpy(&bits, &value, sizeof(float));
+	sign		= (bits >> 16) & 0x8000u;
+	exponent	= (bits >> 23) & 0xFFu;
+	mantissa	= bits & 0x7FFFFFu;
+
+	// NaN and infinity.
+	if(exponent == 0xFF)
+	{	return (unsigned short)(sign | 0x7C00u | (mantissa ? 0x200u : 0));
+	}
+
+	// Overflow to infinity.
+	if(exponent > 142)
+	{	return (unsigned short)(sign | 0x7C00u);
+	}
+
+	// Normal half range.
+	if(exponent > 112)
+	{	half_value	= ((exponent - 112) << 10) | (mantissa >> 13);
+		round_bits	= mantissa & 0x1FFFu;
+		if(round_bits > 0x1000u || (round_bits == 0x1000u && (half_value & 1)))
+		{	half_value++;			// May carry into the exponent which correctly rounds up to the next power of two or infinity.
+		}
+		return (unsigned short)(sign | half_value);
+	}
+
+	// Subnormal half range or underflow to zero.
+	if(exponent < 102)
+	{	return (unsigned short)sign;
+	}
+	mantissa	|= 0x800000u;
+	shift		= 126 - exponent;
+	half_value	= mantissa >> shift;
+	round_bits	= mantissa & ((1u << shift) - 1);
+	if(round_bits > (1u << (shift - 1)) || (round_bits == (1u << (shift - 1)) && (half_value & 1)))
+	{	half_value++;
+	}
+	return (unsigned short)(sign | half_value);
+}
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Plugin library loading
+
+// Load a plugin shared object and resolve its exports. Returns FALSE and logs an error on failure.
+BOOL host_load_library(const char* file_path, host_library_s& library_out)
+{
+	// Local data
+	static const char*							custom_name_array[4] = { "plugin_custom_0", "plugin_custom_1", "plugin_custom_2", "plugin_custom_3" };
+
+
+	// dlopen() searches the library path for names without a slash, plugins are always loaded from a file path.
+	library_out.file_path	= strchr(file_path, '/') ? file_path : std::string("./") + file_path;
+	library_out.handle		= dlopen(library_out.file_path.c_str(), RTLD_NOW | RTLD_LOCAL);
+	if(!library_out.handle)
+	{	host_log("error: failed to load plugin \"%s\": %s", file_path, dlerror());
+		return FALSE;
+	}
+
+	library_out.plugin_version		= (host_plugin_version_type)dlsym(library_out.handle, "plugin_version");
+	library_out.plugin_initialize	= (host_plugin_initialize_type)dlsym(library_out.handle, "plugin_initialize");
+	library_out.plugin_process		= (host_plugin_process_type)dlsym(library_out.handle, "plugin_process");
+	library_out.plugin_shutdown		= (host_plugin_shutdown_type)dlsym(library_out.handle, "plugin_shutdown");
+	for(unsigned int i=0; i<4; i++)
+	{	library_out.plugin_custom[i] = (host_plugin_custom_type)dlsym(library_out.handle, custom_name_array[i]);
+	}
+
+	if(!library_out.plugin_version || !library_out.plugin_initialize || !library_out.plugin_process || !library_out.plugin_shutdown)
+	{	host_log("error: \"%s\" is not a ShaderMap plugin, required exports are missing.", file_path);
+		dlclose(library_out.handle);
+		library_out.handle = 0;
+		return FALSE;
+	}
+
+	library_out.plugin_version(library_out.sdk_version_major, library_out.sdk_version_minor);
+	if(library_out.sdk_version_major != SMSDK_VERSION_MAJOR)
+	{	host_log("error: \"%s\" was built with SDK %u.%u, this host supports SDK %u.x.", file_path,
+				 library_out.sdk_version_major, library_out.sdk_version_minor, SMSDK_VERSION_MAJOR);
+		dlclose(library_out.handle);
+		library_out.handle = 0;
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+// Shutdown and unload a plugin shared object.
+void host_unload_library(host_library_s& library)
+{
+	if(library.handle)
+	{	library.plugin_shutdown();
+		dlclose(library.handle);
+		library.handle = 0;
+	}
+}
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Property helpers
+
+// Find a property value. Logs an error and returns 0 if the index is out of range.
+host_property_s* host_find_property(std::vector<host_property_s>& property_list, unsigned int property_index, const char* function_name)
+{
+	if(property_index >= property_list.size())
+	{	host_log("error: %s: property index %u is out of range (%u properties).", function_name, property_index, (unsigned int)property_list.size());
+		return 0;
+	}
+	return &property_list[property_index];
+}
+
+// Set a property value from a string. The format depends on the property type:
+// checkbox, list, pagelist, numberbox int, slider, coordsys - integer; numberbox float - float; colorbox - integer or #RRGGBB;
+// range slider - "low,high"; file - a file path.
+BOOL host_set_property_from_string(host_property_s& property, const char* value_string)
+{
+	// Local data
+	unsigned int								r, g, b;
+	int											low, high;
+
+
+	switch(property.type)
+	{
+	case HOST_PROPERTY_FILE:
+		property.value_file = host_widen(value_string);
+		return TRUE;
+
+	case HOST_PROPERTY_NUMBERBOX_FLOAT:
+		property.value_float = (float)atof(value_string);
+		return TRUE;
+
+	case HOST_PROPERTY_COLORBOX:
+		if(value_string[0] == '#' && sscanf(value_string + 1, "%02x%02x%02x", &r, &g, &b) == 3)
+		{	property.value_int = (int)RGB(r, g, b);
+			return TRUE;
+		}
+		property.value_int = atoi(value_string);
+		return TRUE;
+
+	case HOST_PROPERTY_RANGE_SLIDER:
+		if(sscanf(value_string, "%d,%d", &low, &high) != 2)
+		{	return FALSE;
+		}
+		property.value_int		= low;
+		property.value_int_high	= high;
+		return TRUE;
+
+	default:
+		property.value_int = atoi(value_string);
+		return TRUE;
+	}
+}
+
+// Parse a "index=value" property override and apply it to a property list.
+BOOL host_apply_property_override(std::vector<host_property_s>& property_list, const char* override_string)
+{
+	// Local data
+	const char*									equals;
+	unsigned int								property_index;
+
+
+	equals = strchr(override_string, '=');
+	if(!equals || sscanf(override_string, "%u", &property_index) != 1)
+	{	host_log("error: invalid property override \"%s\", expected index=value.", override_string);
+		return FALSE;
+	}
+	if(property_index >= property_list.size())
+	{	host_log("error: property override \"%s\" is out of range, the plugin has %u properties.", override_string, (unsigned int)property_list.size());
+		return FALSE;
+	}
+	if(!host_set_property_from_string(property_list[property_index], equals + 1))
+	{	host_log("error: invalid value in property override \"%s\".", override_string);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+// Print a property list - used by the hosts to show which index controls what.
+void host_print_property_list(const std::vector<host_property_s>& property_list)
+{
+	// Local data
+	static const char*							type_name_array[10] = { "pagelist", "file", "checkbox", "list", "numberbox_int",
+																		"numberbox_float", "colorbox", "slider", "range_slider", "coordsys" };
+
+
+	for(size_t i=0; i<property_list.size(); i++)
+	{	const host_property_s& property = property_list[i];
+		if(property.type == HOST_PROPERTY_NUMBERBOX_FLOAT)
+		{	printf("  prop %2u  %-15s  page %u  \"%s\" = %g\n", (unsigned int)i, type_name_array[property.type], property.page_index,
+				   host_narrow(property.caption.c_str()).c_str(), property.value_float);
+		}
+		else if(property.type == HOST_PROPERTY_RANGE_SLIDER)
+		{	printf("  prop %2u  %-15s  page %u  \"%s\" = %d,%d\n", (unsigned int)i, type_name_array[property.type], property.page_index,
+				   host_narrow(property.caption.c_str()).c_str(), property.value_int, property.value_int_high);
+		}
+		else if(property.type == HOST_PROPERTY_FILE)
+		{	printf("  prop %2u  %-15s  page %u  \"%s\" = \"%s\"\n", (unsigned int)i, type_name_array[property.type], property.page_index,
+				   host_narrow(property.caption.c_str()).c_str(), host_narrow(property.value_file.c_str()).c_str());
+		}
+		else
+		{	printf("  prop %2u  %-15s  page %u  \"%s\" = %d\n", (unsigned int)i, type_name_array[property.type < 10 ? property.type : 2], property.page_index,
+				   host_narrow(property.caption.c_str()).c_str(), property.value_int);
+		}
+	}
+}
@@ -0,0 +1,720 @@
+/*
+	===============================================================
+
+	SHADERMAP HEADLESS HOST - FILTER API SOURCE FILE
+
+	Implements the functions that ShaderMap passes to filter
+	plugins in "plugin_initialize()" (see
+	"filters/filter_plugin_core.cpp") so that filter plugins can be
+	initialized and applied without ShaderMap.
+
+	Each map has its own filter stack. Filters applied before the
+	map is processed (pre filters) have negative filter positions
+	-1, -2, -3... and filters applied after (post filters) have
+	positive positions 1, 2, 3... The map id and filter position
+	are how a plugin identifies its instance when it gets property
+	values. Stacks of different maps can be processed at the same
+	time from different threads.
+
+	Include after the filter plugin core (with SMSDK_HOST defined),
+	"host_common.cpp" and "host_image.cpp".
+
+
+	SHADERMAP SDK LICENSE
+
+	The ShaderMap SDK is released under The MIT License (MIT)
+	http://opensource.org/licenses/MIT
+
+	Copyright (c) 2007-2019 Rendering Systems Inc.
+
+	See "host_common.cpp" for the full license text.
+
+	===============================================================
+*/
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Filter host structs
+
+// A loaded filter plugin and the data it defined in "on_initialize()".
+struct host_filter_plugin_s
+{
+	host_library_s								library;
+	filter_plugin_info_s						info;					// String members point into the strings below.
+	std::wstring								name, description, thumb_filename;
+	std::vector<host_property_s>				property_list;			// Default property values including the auto added mask properties.
+};
+
+// A filter in the filter stack of the map.
+struct host_filter_instance_s
+{
+	host_filter_plugin_s*						plugin;
+	int											filter_position;		// Negative for pre filters, positive for post filters.
+	std::vector<host_property_s>				property_list;
+
+	// Process statistics of the last "on_process()".
+	std::atomic<unsigned int>					progress;
+	std::atomic<unsigned int>					progress_call_count;
+	std::atomic<unsigned int>					error_count;
+	unsigned long long							cancel_poll_count;
+
+	// c()
+	host_filter_instance_s(void)
+	{	plugin = 0; filter_position = 0;
+		reset_statistics();
+	}
+
+	// Reset the process statistics.
+	void reset_statistics(void)
+	{	progress = 0; progress_call_count = 0; error_count = 0; cancel_poll_count = 0;
+	}
+};
+
+// A map with a filter stack.
+struct host_filter_map_s
+{
+	unsigned int								map_id;
+	std::vector<host_filter_instance_s*>		stack_list;				// Filters in the order they are applied.
+	unsigned int								mask_width, mask_height;
+	std::vector<unsigned short>					mask_pixel_list;
+	unsigned int								thread_limit;			// Returned by fp_get_map_thread_limit() while this map is filtered, 0 for the context limit.
+
+	// c()
+	host_filter_map_s(void)
+	{	map_id = 0; mask_width = mask_height = 0; thread_limit = 0;
+	}
+
+	// d()
+	~host_filter_map_s(void)
+	{	for(size_t i=0; i<stack_list.size(); i++)
+		{	delete stack_list[i];
+		}
+	}
+};
+
+// Host state shared by all filter API functions.
+struct host_filter_context_s
+{
+	std::vector<host_filter_plugin_s*>			plugin_list;
+	std::vector<host_filter_map_s*>				map_list;
+	host_filter_plugin_s*						initializing_plugin;	// Plugin inside "on_initialize()".
+
+	// ShaderMap options.
+	unsigned int								option_default_coord_sys;
+	unsigned int								thread_limit;
+
+	// Cancel control. Cancel is set by the host or after cancel_after_poll_count calls of "fp_is_cancel_process()" (0 disables).
+	std::atomic<BOOL>							is_cancel;
+	std::atomic<unsigned long long>				cancel_poll_count;
+	unsigned long long							cancel_after_poll_count;
+
+	// Translation files defined by plugins.
+	std::vector<std::wstring>					translation_file_list;
+
+	// c()
+	host_filter_context_s(void)
+	{	initializing_plugin			= 0;
+		option_default_coord_sys	= MAP_COORDSYS_X_POS_RIGHT | MAP_COORDSYS_Y_POS_UP | MAP_COORDSYS_Z_POS_NEAR;
+		thread_limit				= 1;
+		is_cancel					= FALSE;
+		cancel_poll_count			= 0;
+		cancel_after_poll_count		= 0;
+	}
+};
+
+host_filter_context_s							host_filter_context;
+
+// The map being filtered by the calling thread. Used by the API functions that do not pass a map id.
+static thread_local host_filter_map_s*			host_filter_calling_map = 0;
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Filter host helpers
+
+// Return a map by id or 0 and log an error.
+host_filter_map_s* host_filter_find_map(unsigned int map_id, const char* function_name)
+{
+	for(size_t i=0; i<host_filter_context.map_list.size(); i++)
+	{	if(host_filter_context.map_list[i]->map_id == map_id)
+		{	return host_filter_context.map_list[i];
+		}
+	}
+	host_log("error: %s: invalid map id %u.", function_name, map_id);
+	return 0;
+}
+
+// Return the filter instance at a filter position or 0 and log an error.
+host_filter_instance_s* host_filter_find_instance(unsigned int map_id, int filter_position, const char* function_name)
+{
+	host_filter_map_s* map = host_filter_find_map(map_id, function_name);
+	if(!map)
+	{	return 0;
+	}
+	for(size_t i=0; i<map->stack_list.size(); i++)
+	{	if(map->stack_list[i]->filter_position == filter_position)
+		{	return map->stack_list[i];
+		}
+	}
+	host_log("error: %s: map %u has no filter at position %d.", function_name, map_id, filter_position);
+	return 0;
+}
+
+// Return a property of a filter instance checking the property type. Logs an error and returns 0 on mismatch.
+host_property_s* host_filter_find_property(unsigned int map_id, int filter_position, unsigned int property_index, unsigned int property_type, const char* function_name)
+{
+	host_filter_instance_s*	instance;
+	host_property_s*		property;
+
+
+	instance = host_filter_find_instance(map_id, filter_position, function_name);
+	if(!instance)
+	{	return 0;
+	}
+	property = host_find_property(instance->property_list, property_index, function_name);
+	if(property && property->type != property_type)
+	{	host_log("error: %s: property %u of filter %d is not of the requested type.", function_name, property_index, filter_position);
+		return 0;
+	}
+	return property;
+}
+
+// Add a property to the plugin being initialized.
+host_property_s* host_filter_add_property(unsigned int type, const wchar_t* caption, unsigned int page_index, const char* function_name)
+{
+	host_property_s		property;
+
+
+	if(!host_filter_context.initializing_plugin)
+	{	host_log("error: %s: called outside of on_initialize().", function_name);
+		return 0;
+	}
+	property.type		= type;
+	property.caption	= caption ? caption : L"";
+	property.page_index	= page_index;
+	host_filter_context.initializing_plugin->property_list.push_back(property);
+	return &host_filter_context.initializing_plugin->property_list.back();
+}
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Filter API - setup and info functions (0 - 4, 100 - 101)
+
+void host_fp_begin_initialize(void)
+{
+}
+
+void host_fp_end_initialize(void)
+{
+}
+
+unsigned int host_fp_define_translation_file(const wchar_t* file_title, const wchar_t* default_prefix)
+{
+	host_filter_context.translation_file_list.push_back(file_title ? file_title : L"");
+	return (unsigned int)host_filter_context.translation_file_list.size() - 1;
+}
+
+// Translation files are not loaded by the headless host. An empty string is returned for every id.
+const wchar_t* host_fp_get_trans_string(unsigned int file_index, unsigned int id)
+{
+	return L"";
+}
+
+void host_fp_define_help_file(const wchar_t* help_file, const wchar_t* default_language)
+{
+}
+
+void host_fp_set_plugin_info(const filter_plugin_info_s& plugin_info)
+{
+	host_filter_plugin_s* plugin = host_filter_context.initializing_plugin;
+	if(!plugin)
+	{	host_log("error: %s: called outside of on_initialize().", __FUNCTION__);
+		return;
+	}
+
+	// Copy strings - the plugin may pass pointers to temporary strings.
+	plugin->name					= plugin_info.name ? plugin_info.name : L"";
+	plugin->description				= plugin_info.description ? plugin_info.description : L"";
+	plugin->thumb_filename			= plugin_info.thumb_filename ? plugin_info.thumb_filename : L"";
+	plugin->info					= plugin_info;
+	plugin->info.name				= plugin->name.c_str();
+	plugin->info.description		= plugin->description.c_str();
+	plugin->info.thumb_filename		= plugin->thumb_filename.c_str();
+}
+
+unsigned int host_fp_get_option_default_coord_sys(void)
+{
+	return host_filter_context.option_default_coord_sys;
+}
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Filter API - add property functions (200 - 209)
+
+void host_fp_add_property_pagelist(const wchar_t* caption, const wchar_t** string_array, unsigned int string_count, unsigned int cur_select)
+{
+	host_property_s* property = host_filter_add_property(HOST_PROPERTY_PAGELIST, caption, 0, __FUNCTION__);
+	if(property)
+	{	for(unsigned int i=0; i<string_count; i++)
+		{	property->string_list.push_back(string_array[i] ? string_array[i] : L"");
+		}
+		property->value_int = (int)cur_select;
+	}
+}
+
+void host_fp_add_property_file(const wchar_t* caption, const wchar_t* initial_path, const wchar_t* extension_filter_pointer, unsigned int page_index)
+{
+	host_property_s* property = host_filter_add_property(HOST_PROPERTY_FILE, caption, page_index, __FUNCTION__);
+	if(property)
+	{	property->value_file = initial_path ? initial_path : L"";
+	}
+}
+
+void host_fp_add_property_checkbox(const wchar_t* caption, BOOL is_checked, unsigned int page_index)
+{
+	host_property_s* property = host_filter_add_property(HOST_PROPERTY_CHECKBOX, caption, page_index, __FUNCTION__);
+	if(property)
+	{	property->value_int = is_checked ? TRUE : FALSE;
+	}
+}
+
+void host_fp_add_property_list(const wchar_t* caption, const wchar_t** string_array, unsigned int string_count, unsigned int cur_select, unsigned int page_index)
+{
+	host_property_s* property = host_filter_add_property(HOST_PROPERTY_LIST, caption, page_index, __FUNCTION__);
+	if(property)
+	{	for(unsigned int i=0; i<string_count; i++)
+		{	property->string_list.push_back(string_array[i] ? string_array[i] : L"");
+		}
+		property->value_int = (int)cur_select;
+	}
+}
+
+void host_fp_add_property_numberbox_int(const wchar_t* caption, int min, int max, int value, unsigned int page_index)
+{
+	host_property_s* property = host_filter_add_property(HOST_PROPERTY_NUMBERBOX_INT, caption, page_index, __FUNCTION__);
+	if(property)
+	{	property->int_min = min; property->int_max = max; property->value_int = value;
+	}
+}
+
+void host_fp_add_property_numberbox_float(const wchar_t* caption, float min, float max, float value, unsigned int page_index)
+{
+	host_property_s* property = host_filter_add_property(HOST_PROPERTY_NUMBERBOX_FLOAT, caption, page_index, __FUNCTION__);
+	if(property)
+	{	property->float_min = min; property->float_max = max; property->value_float = value;
+	}
+}
+
+void host_fp_add_property_colorbox(const wchar_t* caption, COLORREF color, unsigned int page_index)
+{
+	host_property_s* property = host_filter_add_property(HOST_PROPERTY_COLORBOX, caption, page_index, __FUNCTION__);
+	if(property)
+	{	property->value_int = (int)color;
+	}
+}
+
+void host_fp_add_property_slider(const wchar_t* caption, int min, int max, int position, unsigned int page_index, BOOL is_forced_center, int forced_center)
+{
+	host_property_s* property = host_filter_add_property(HOST_PROPERTY_SLIDER, caption, page_index, __FUNCTION__);
+	if(property)
+	{	property->int_min = min; property->int_max = max; property->value_int = position;
+	}
+}
+
+void host_fp_add_property_range_slider(const wchar_t* caption_low, const wchar_t* caption_mid, const wchar_t* caption_high,
+									   int min, int max, int position_min, int position_max, unsigned int page_index)
+{
+	host_property_s* property = host_filter_add_property(HOST_PROPERTY_RANGE_SLIDER, caption_mid ? caption_mid : caption_low, page_index, __FUNCTION__);
+	if(property)
+	{	property->int_min = min; property->int_max = max; property->value_int = position_min; property->value_int_high = position_max;
+	}
+}
+
+void host_fp_add_property_coordsys(const wchar_t* caption, unsigned int coordinate_system, unsigned int page_index)
+{
+	host_property_s* property = host_filter_add_property(HOST_PROPERTY_COORDSYS, caption, page_index, __FUNCTION__);
+	if(property)
+	{	property->value_int = (int)coordinate_system;
+	}
+}
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Filter API - get and set property functions (300 - 317)
+
+unsigned int host_fp_get_property_pagelist(unsigned int map_id, int filter_position, unsigned int property_index)
+{
+	host_property_s* property = host_filter_find_property(map_id, filter_position, property_index, HOST_PROPERTY_PAGELIST, __FUNCTION__);
+	return property ? (unsigned int)property->value_int : 0;
+}
+
+const wchar_t* host_fp_get_property_file(unsigned int map_id, int filter_position, unsigned int property_index)
+{
+	host_property_s* property = host_filter_find_property(map_id, filter_position, property_index, HOST_PROPERTY_FILE, __FUNCTION__);
+	return property ? property->value_file.c_str() : L"";
+}
+
+BOOL host_fp_get_property_checkbox(unsigned int map_id, int filter_position, unsigned int property_index)
+{
+	host_property_s* property = host_filter_find_property(map_id, filter_position, property_index, HOST_PROPERTY_CHECKBOX, __FUNCTION__);
+	return property ? (property->value_int ? TRUE : FALSE) : FALSE;
+}
+
+unsigned int host_fp_get_property_list(unsigned int map_id, int filter_position, unsigned int property_index)
+{
+	host_property_s* property = host_filter_find_property(map_id, filter_position, property_index, HOST_PROPERTY_LIST, __FUNCTION__);
+	return property ? (unsigned int)property->value_int : 0;
+}
+
+int host_fp_get_property_numberbox_int(unsigned int map_id, int filter_position, unsigned int property_index)
+{
+	host_property_s* property = host_filter_find_property(map_id, filter_position, property_index, HOST_PROPERTY_NUMBERBOX_INT, __FUNCTION__);
+	return property ? property->value_int : 0;
+}
+
+float host_fp_get_property_numberbox_float(unsigned int map_id, int filter_position, unsigned int property_index)
+{
+	host_property_s* property = host_filter_find_property(map_id, filter_position, property_index, HOST_PROPERTY_NUMBERBOX_FLOAT, __FUNCTION__);
+	return property ? property->value_float : 0.0f;
+}
+
+COLORREF host_fp_get_property_colorbox(unsigned int map_id, int filter_position, unsigned int property_index)
+{
+	host_property_s* property = host_filter_find_property(map_id, filter_position, property_index, HOST_PROPERTY_COLORBOX, __FUNCTION__);
+	return property ? (COLORREF)property->value_int : 0;
+}
+
+int host_fp_get_property_slider(unsigned int map_id, int filter_position, unsigned int property_index)
+{
+	host_property_s* property = host_filter_find_property(map_id, filter_position, property_index, HOST_PROPERTY_SLIDER, __FUNCTION__);
+	return property ? property->value_int : 0;
+}
+
+void host_fp_get_property_range_slider(unsigned int map_id, int filter_position, unsigned int property_index, int& position_min_out, int& position_max_out)
+{
+	host_property_s* property = host_filter_find_property(map_id, filter_position, property_index, HOST_PROPERTY_RANGE_SLIDER, __FUNCTION__);
+	position_min_out = property ? property->value_int : 0;
+	position_max_out = property ? property->value_int_high : 0;
+}
+
+unsigned int host_fp_get_property_coordsys(unsigned int map_id, int filter_position, unsigned int property_index)
+{
+	host_property_s* property = host_filter_find_property(map_id, filter_position, property_index, HOST_PROPERTY_COORDSYS, __FUNCTION__);
+	return property ? (unsigned int)property->value_int : 0;
+}
+
+void host_fp_set_property_checkbox(unsigned int map_id, int filter_position, unsigned int property_index, BOOL check_state)
+{
+	host_property_s* property = host_filter_find_property(map_id, filter_position, property_index, HOST_PROPERTY_CHECKBOX, __FUNCTION__);
+	if(property)
+	{	property->value_int = check_state ? TRUE : FALSE;
+	}
+}
+
+void host_fp_set_property_list(unsigned int map_id, int filter_position, unsigned int property_index, unsigned int cur_sel)
+{
+	host_property_s* property = host_filter_find_property(map_id, filter_position, property_index, HOST_PROPERTY_LIST, __FUNCTION__);
+	if(property)
+	{	property->value_int = (int)cur_sel;
+	}
+}
+
+void host_fp_set_property_numberbox_int(unsigned int map_id, int filter_position, unsigned int property_index, int value)
+{
+	host_property_s* property = host_filter_find_property(map_id, filter_position, property_index, HOST_PROPERTY_NUMBERBOX_INT, __FUNCTION__);
+	if(property)
+	{	property->value_int = value;
+	}
+}
+
+void host_fp_set_property_numberbox_float(unsigned int map_id, int filter_position, unsigned int property_index, float value)
+{
+	host_property_s* property = host_filter_find_property(map_id, filter_position, property_index, HOST_PROPERTY_NUMBERBOX_FLOAT, __FUNCTION__);
+	if(property)
+	{	property->value_float = value;
+	}
+}
+
+void host_fp_set_property_colorbox(unsigned int map_id, int filter_position, unsigned int property_index, COLORREF color)
+{
+	host_property_s* property = host_filter_find_property(map_id, filter_position, property_index, HOST_PROPERTY_COLORBOX, __FUNCTION__);
+	if(property)
+	{	property->value_int = (int)color;
+	}
+}
+
+void host_fp_set_property_slider(unsigned int map_id, int filter_position, unsigned int property_index, int position)
+{
+	host_property_s* property = host_filter_find_property(map_id, filter_position, property_index, HOST_PROPERTY_SLIDER, __FUNCTION__);
+	if(property)
+	{	property->value_int = position;
+	}
+}
+
+void host_fp_set_property_range_slider(unsigned int map_id, int filter_position, unsigned int property_index, int position_min, int position_max)
+{
+	host_property_s* property = host_filter_find_property(map_id, filter_position, property_index, HOST_PROPERTY_RANGE_SLIDER, __FUNCTION__);
+	if(property)
+	{	property->value_int = position_min; property->value_int_high = position_max;
+	}
+}
+
+void host_fp_set_property_coordsys(unsigned int map_id, int filter_position, unsigned int property_index, unsigned int coordsys)
+{
+	host_property_s* property = host_filter_find_property(map_id, filter_position, property_index, HOST_PROPERTY_COORDSYS, __FUNCTION__);
+	if(property)
+	{	property->value_int = (int)coordsys;
+	}
+}
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Filter API - process utility functions (400 - 404)
+
+BOOL host_fp_is_cancel_process(void)
+{
+	unsigned long long poll_count = ++host_filter_context.cancel_poll_count;
+	if(host_filter_context.cancel_after_poll_count && poll_count >= host_filter_context.cancel_after_poll_count)
+	{	host_filter_context.is_cancel = TRUE;
+	}
+	return host_filter_context.is_cancel;
+}
+
+void host_fp_set_filter_progress(unsigned int map_id, int filter_position, unsigned int progress)
+{
+	host_filter_instance_s* instance = host_filter_find_instance(map_id, filter_position, __FUNCTION__);
+	if(instance)
+	{	instance->progress = progress > 100 ? 100 : progress;
+		instance->progress_call_count++;
+	}
+}
+
+void host_fp_log_filter_error(unsigned int map_id, int filter_position, const wchar_t* error_message, const wchar_t* function, const wchar_t* source_filepath, int source_line_number)
+{
+	for(size_t i=0; i<host_filter_context.map_list.size(); i++)
+	{	host_filter_map_s* map = host_filter_context.map_list[i];
+		for(size_t j=0; j<map->stack_list.size() && map->map_id == map_id; j++)
+		{	if(map->stack_list[j]->filter_position == filter_position)
+			{	map->stack_list[j]->error_count++;
+			}
+		}
+	}
+	host_log("error: map %u filter %d: %s [%s, %s:%d]", map_id, filter_position, host_narrow(error_message).c_str(), host_narrow(function).c_str(),
+			 host_get_file_name(host_narrow(source_filepath)).c_str(), source_line_number);
+}
+
+unsigned int host_fp_get_map_thread_limit(void)
+{
+	return (host_filter_calling_map && host_filter_calling_map->thread_limit) ? host_filter_calling_map->thread_limit : host_filter_context.thread_limit;
+}
+
+// The returned pointer is owned by the host and is valid until the mask is changed.
+void host_fp_get_map_mask(unsigned int map_id, unsigned int& width_out, unsigned int& height_out, unsigned short** pixel_array_out)
+{
+	host_filter_map_s*	map			= host_filter_find_map(map_id, __FUNCTION__);
+	BOOL				is_valid	= map && !map->mask_pixel_list.empty();
+	width_out	= is_valid ? map->mask_width : 0;
+	height_out	= is_valid ? map->mask_height : 0;
+	if(pixel_array_out)
+	{	*pixel_array_out = is_valid ? map->mask_pixel_list.data() : 0;
+	}
+}
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Filter host functions
+
+// Fill the function pointer array passed to "plugin_initialize()". Element numbers match "filters/filter_plugin_core.cpp".
+void host_filter_build_function_pointer_array(void** function_pointer_array)
+{
+	memset(function_pointer_array, 0, sizeof(void*) * HOST_FUNCTION_POINTER_COUNT);
+
+	function_pointer_array[0]	= (void*)host_fp_begin_initialize;
+	function_pointer_array[1]	= (void*)host_fp_end_initialize;
+	function_pointer_array[2]	= (void*)host_fp_define_translation_file;
+	function_pointer_array[3]	= (void*)host_fp_get_trans_string;
+	function_pointer_array[4]	= (void*)host_fp_define_help_file;
+
+	function_pointer_array[100]	= (void*)host_fp_set_plugin_info;
+	function_pointer_array[101]	= (void*)host_fp_get_option_default_coord_sys;
+
+	function_pointer_array[200]	= (void*)host_fp_add_property_pagelist;
+	function_pointer_array[201]	= (void*)host_fp_add_property_file;
+	function_pointer_array[202]	= (void*)host_fp_add_property_checkbox;
+	function_pointer_array[203]	= (void*)host_fp_add_property_list;
+	function_pointer_array[204]	= (void*)host_fp_add_property_numberbox_int;
+	function_pointer_array[205]	= (void*)host_fp_add_property_numberbox_float;
+	function_pointer_array[206]	= (void*)host_fp_add_property_colorbox;
+	function_pointer_array[207]	= (void*)host_fp_add_property_slider;
+	function_pointer_array[208]	= (void*)host_fp_add_property_range_slider;
+	function_pointer_array[209]	= (void*)host_fp_add_property_coordsys;
+
+	function_pointer_array[300]	= (void*)host_fp_get_property_pagelist;
+	function_pointer_array[301]	= (void*)host_fp_get_property_file;
+	function_pointer_array[302]	= (void*)host_fp_get_property_checkbox;
+	function_pointer_array[303]	= (void*)host_fp_get_property_list;
+	function_pointer_array[304]	= (void*)host_fp_get_property_numberbox_int;
+	function_pointer_array[305]	= (void*)host_fp_get_property_numberbox_float;
+	function_pointer_array[306]	= (void*)host_fp_get_property_colorbox;
+	function_pointer_array[307]	= (void*)host_fp_get_property_slider;
+	function_pointer_array[308]	= (void*)host_fp_get_property_range_slider;
+	function_pointer_array[309]	= (void*)host_fp_get_property_coordsys;
+	function_pointer_array[310]	= (void*)host_fp_set_property_checkbox;
+	function_pointer_array[311]	= (void*)host_fp_set_property_list;
+	function_pointer_array[312]	= (void*)host_fp_set_property_numberbox_int;
+	function_pointer_array[313]	= (void*)host_fp_set_property_numberbox_float;
+	function_pointer_array[314]	= (void*)host_fp_set_property_colorbox;
+	function_pointer_array[315]	= (void*)host_fp_set_property_slider;
+	function_pointer_array[316]	= (void*)host_fp_set_property_range_slider;
+	function_pointer_array[317]	= (void*)host_fp_set_property_coordsys;
+
+	function_pointer_array[400]	= (void*)host_fp_is_cancel_process;
+	function_pointer_array[401]	= (void*)host_fp_set_filter_progress;
+	function_pointer_array[402]	= (void*)host_fp_log_filter_error;
+	function_pointer_array[403]	= (void*)host_fp_get_map_thread_limit;
+	function_pointer_array[404]	= (void*)host_fp_get_map_mask;
+}
+
+// Load and initialize a filter plugin. A plugin already loaded from the same path is returned as is.
+// Returns 0 and logs an error on failure.
+host_filter_plugin_s* host_filter_load_plugin(const char* file_path)
+{
+	// Local data
+	host_filter_plugin_s*						plugin;
+	void*										function_pointer_array[HOST_FUNCTION_POINTER_COUNT];
+	host_property_s								mask_property;
+	BOOL										is_success;
+
+
+	for(size_t i=0; i<host_filter_context.plugin_list.size(); i++)
+	{	if(host_filter_context.plugin_list[i]->library.file_path == file_path ||
+		   host_filter_context.plugin_list[i]->library.file_path == std::string("./") + file_path)
+		{	return host_filter_context.plugin_list[i];
+		}
+	}
+
+	plugin = new host_filter_plugin_s;
+	if(!host_load_library(file_path, plugin->library))
+	{	delete plugin;
+		return 0;
+	}
+
+	host_filter_build_function_pointer_array(function_pointer_array);
+	host_filter_context.initializing_plugin = plugin;
+	is_success = plugin->library.plugin_initialize(function_pointer_array);
+	host_filter_context.initializing_plugin = 0;
+	if(!is_success)
+	{	host_log("error: \"%s\" failed to initialize.", file_path);
+		host_unload_library(plugin->library);
+		delete plugin;
+		return 0;
+	}
+
+	// ShaderMap adds 2 mask checkboxes after the plugin properties of every filter - Use Mask and Invert Mask.
+	mask_property.type			= HOST_PROPERTY_CHECKBOX;
+	mask_property.page_index	= plugin->property_list.empty() ? 0 : plugin->property_list.back().page_index;
+	mask_property.caption		= L"Use Mask";
+	mask_property.value_int		= TRUE;
+	plugin->property_list.push_back(mask_property);
+	mask_property.caption		= L"Invert Mask";
+	mask_property.value_int		= FALSE;
+	plugin->property_list.push_back(mask_property);
+
+	host_filter_context.plugin_list.push_back(plugin);
+	return plugin;
+}
+
+// Add a map with an empty filter stack. The map is owned by the context.
+host_filter_map_s* host_filter_add_map(unsigned int map_id)
+{
+	host_filter_map_s* map = new host_filter_map_s;
+	map->map_id = map_id;
+	host_filter_context.map_list.push_back(map);
+	return map;
+}
+
+// Add a filter to the stack of a map. Pre filters are applied first in the order added, then post filters in the order added.
+host_filter_instance_s* host_filter_add_instance(host_filter_map_s* map, host_filter_plugin_s* plugin, BOOL is_pre_filter)
+{
+	// Local data
+	host_filter_instance_s*						instance;
+	int											count;
+	size_t										insert_index;
+
+
+	instance = new host_filter_instance_s;
+	instance->plugin		= plugin;
+	instance->property_list	= plugin->property_list;
+
+	count			= 0;
+	insert_index	= 0;
+	for(size_t i=0; i<map->stack_list.size(); i++)
+	{	if((map->stack_list[i]->filter_position < 0) == (is_pre_filter ? true : false))
+		{	count++;
+		}
+		if(map->stack_list[i]->filter_position < 0)
+		{	insert_index = i + 1;
+		}
+	}
+	instance->filter_position = is_pre_filter ? -(count + 1) : count + 1;
+	if(is_pre_filter)
+	{	map->stack_list.insert(map->stack_list.begin() + insert_index, instance);
+	}
+	else
+	{	map->stack_list.push_back(instance);
+	}
+	return instance;
+}
+
+// Apply one filter of the stack of a map to the map pixels. Returns the result of "on_process()".
+BOOL host_filter_process_instance(host_filter_map_s* map, host_filter_instance_s* instance, host_image_s& image, BOOL is_normal_map, unsigned int coord_system, unsigned int tile_type)
+{
+	// Local data
+	process_data_s								process_data;
+	BOOL										is_sRGB, is_success;
+	unsigned long long							poll_start;
+
+
+	process_data.map_id					= map->map_id;
+	process_data.filter_position		= instance->filter_position;
+	process_data.is_grayscale			= image.is_grayscale;
+	process_data.is_sRGB				= image.is_sRGB;
+	process_data.is_normal_map			= is_normal_map;
+	process_data.map_width				= image.width;
+	process_data.map_height				= image.height;
+	process_data.map_tile_type			= tile_type;
+	process_data.map_coordinate_system	= is_normal_map ? coord_system : 0;
+	process_data.map_pixel_data			= image.pixel_list.data();
+
+	instance->reset_statistics();
+	poll_start	= host_filter_context.cancel_poll_count;
+	is_sRGB		= image.is_sRGB;
+	host_filter_calling_map = map;
+	is_success	= instance->plugin->library.plugin_process(&process_data, &is_sRGB);
+	host_filter_calling_map = 0;
+	instance->cancel_poll_count = host_filter_context.cancel_poll_count - poll_start;
+
+	// The filter may change the color space of the pixels.
+	image.is_sRGB = is_sRGB ? TRUE : FALSE;
+	return is_success;
+}
+
+// Shutdown all plugins and release all maps and their stacks.
+void host_filter_shutdown(void)
+{
+	for(size_t i=0; i<host_filter_context.map_list.size(); i++)
+	{	delete host_filter_context.map_list[i];
+	}
+	host_filter_context.map_list.clear();
+	for(size_t i=0; i<host_filter_context.plugin_list.size(); i++)
+	{	host_unload_library(host_filter_context.plugin_list[i]->library);
+		delete host_filter_context.plugin_list[i];
+	}
+	host_filter_context.plugin_list.clear();
+}
@@ -0,0 +1,478 @@
+/*
+	===============================================================
+
+	SHADERMAP HEADLESS HOST - FILTER STACK BENCHMARK
+
+	A command line host that builds a filter stack from filter
+	plugins built as Linux shared objects and applies it to a map
+	the way ShaderMap does: every run starts from the unfiltered
+	map pixels and applies each filter in stack order. This is
+	what happens each time a property in a filter stack is changed
+	so the per filter numbers show where interactive latency goes.
+
+	For each filter and run the host reports:
+
+	time			Wall time of "on_process()".
+	MB/s			Map size divided by time.
+	written			Bytes of map pixel pages written by the filter,
+					measured with kernel soft-dirty page tracking
+					(rounded to pages, "n/a" if unsupported).
+	changed			Bytes of map pixels that differ after the filter.
+	progress		Calls to fp_set_filter_progress().
+	polls			Calls to fp_is_cancel_process().
+
+	--
+
+	BUILD (from the SDK root folder)
+
+	Plugin:
+	g++ -std=c++11 -O2 -shared -fPIC -fvisibility=hidden -I host/compat filters/examples/filter_rgba/filter_rgba.cpp -o filter_rgba.so
+
+	Host:
+	g++ -std=c++11 -O2 -I host/compat host/host_filter_bench.cpp -o host_filter_bench -ldl -lz -pthread
+
+	--
+
+	USAGE
+
+	host_filter_bench --image FILE [options]
+
+	--image FILE				The map the stack is applied to. PNG, EXR or
+								synthetic:WxH / synthetic_gray:WxH.
+	--normal					The image is a normal map. Pixels are
+								converted from 0...1 to -1...1 vectors.
+	--coordsys N				Normal map coordinate system. Default is
+								X+ right, Y+ up, Z+ near.
+	--tile N					Map tile type, MAP_TILE_ value. Default 0.
+	--pre FILE.so				Add a pre filter (positions -1, -2, ...).
+	--post FILE.so				Add a post filter (positions 1, 2, ...).
+	--mask FILE					Mask image of the map.
+	--prop POS:INDEX=VALUE		Set a property of the filter at position POS.
+	--tweak POS:INDEX=V1,V2,..	Set a property to the next value before each
+								run to simulate dragging a property control.
+	--threads N					Value returned by fp_get_map_thread_limit().
+	--warmup N					Untimed runs before measuring. Default 1.
+	--iterations N				Timed runs. Default 5.
+	--cancel-after N			Report cancel after N calls to
+								fp_is_cancel_process() in each run.
+	--no-diff					Skip the changed byte count (saves a copy
+								of the map per filter).
+	--output FILE.exr			Save the filtered map of the last run.
+	--csv FILE					Append one line per filter per run.
+	--list						Print the stack and properties then exit.
+	--verbose					Print extra messages.
+
+	Example:
+	./host_filter_bench --image synthetic:4096x4096 --post filter_rgba.so --post filter_rgba.so --prop 1:0=50 --tweak 2:1=-20,0,20
+
+	Exit code is 0 if every filter succeeded in every run, 1
+	otherwise.
+
+
+	SHADERMAP SDK LICENSE
+
+	The ShaderMap SDK is released under The MIT License (MIT)
+	http://opensource.org/licenses/MIT
+
+	Copyright (c) 2007-2019 Rendering Systems Inc.
+
+	See "host_common.cpp" for the full license text.
+
+	===============================================================
+*/
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Host includes
+
+#define SMSDK_HOST
+#include "../filters/filter_plugin_core.cpp"
+#include "host_common.cpp"
+#include "host_image.cpp"
+#include "host_filter_api.cpp"
+#include <thread>
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Benchmark
+
+// A property value list applied one value per run.
+struct host_filter_tweak_s
+{
+	int											filter_position;
+	unsigned int								property_index;
+	std::vector<std::string>					value_list;
+};
+
+// Command line options.
+struct host_filter_bench_options_s
+{
+	std::string									image_path;
+	std::string									mask_path;
+	std::vector<std::pair<std::string, BOOL> >	filter_list;			// Plugin path, is pre filter.
+	std::vector<std::string>					property_list;
+	std::vector<host_filter_tweak_s>			tweak_list;
+	std::string									output_path;
+	std::string									csv_path;
+	BOOL										is_normal_map;
+	unsigned int								coord_system;
+	unsigned int								tile_type;
+	unsigned int								thread_limit;
+	unsigned int								warmup_count;
+	unsigned int								iteration_count;
+	unsigned long long							cancel_after_poll_count;
+	BOOL										is_diff;
+	BOOL										is_list;
+
+	// c()
+	host_filter_bench_options_s(void)
+	{	is_normal_map			= FALSE;
+		coord_system			= MAP_COORDSYS_X_POS_RIGHT | MAP_COORDSYS_Y_POS_UP | MAP_COORDSYS_Z_POS_NEAR;
+		tile_type				= MAP_TILE_NONE;
+		thread_limit			= std::max(1u, std::thread::hardware_concurrency());
+		warmup_count			= 1;
+		iteration_count			= 5;
+		cancel_after_poll_count	= 0;
+		is_diff					= TRUE;
+		is_list					= FALSE;
+	}
+};
+
+// Per filter measurements over all timed runs.
+struct host_filter_bench_stage_s
+{
+	host_sample_list_s							time_list;
+	host_sample_list_s							written_list;
+	host_sample_list_s							changed_list;
+	unsigned int								fail_count;
+
+	// c()
+	host_filter_bench_stage_s(void)
+	{	fail_count = 0;
+	}
+};
+
+// Print usage.
+void host_filter_bench_usage(void)
+{
+	fprintf(stderr,
+		"usage: host_filter_bench --image FILE [--normal] [--coordsys N] [--tile N] [--pre FILE.so]... [--post FILE.so]...\n"
+		"                         [--mask FILE] [--prop POS:INDEX=VALUE]... [--tweak POS:INDEX=V1,V2,...]... [--threads N]\n"
+		"                         [--warmup N] [--iterations N] [--cancel-after N] [--no-diff] [--output FILE.exr]\n"
+		"                         [--csv FILE] [--list] [--verbose]\n");
+}
+
+// Split "POS:INDEX=VALUE" into the filter position and "INDEX=VALUE". Returns FALSE if invalid.
+BOOL host_filter_bench_split_position(const char* argument, int& filter_position_out, std::string& rest_out)
+{
+	const char* colon = strchr(argument, ':');
+	if(!colon || sscanf(argument, "%d", &filter_position_out) != 1 || filter_position_out == 0)
+	{	host_log("error: invalid argument \"%s\", expected POSITION:INDEX=VALUE with a non zero position.", argument);
+		return FALSE;
+	}
+	rest_out = colon + 1;
+	return TRUE;
+}
+
+// Parse the command line. Returns FALSE on invalid arguments.
+BOOL host_filter_bench_parse(int argc, char** argv, host_filter_bench_options_s& options_out)
+{
+	for(int i=1; i<argc; i++)
+	{
+		std::string argument = argv[i];
+		BOOL		is_value = (i + 1 < argc);
+
+		if(argument == "--image" && is_value)				{ options_out.image_path = argv[++i]; }
+		else if(argument == "--mask" && is_value)			{ options_out.mask_path = argv[++i]; }
+		else if(argument == "--pre" && is_value)			{ options_out.filter_list.push_back(std::make_pair(std::string(argv[++i]), TRUE)); }
+		else if(argument == "--post" && is_value)			{ options_out.filter_list.push_back(std::make_pair(std::string(argv[++i]), FALSE)); }
+		else if(argument == "--prop" && is_value)			{ options_out.property_list.push_back(argv[++i]); }
+		else if(argument == "--coordsys" && is_value)		{ options_out.coord_system = (unsigned int)strtoul(argv[++i], 0, 0); }
+		else if(argument == "--tile" && is_value)			{ options_out.tile_type = (unsigned int)atoi(argv[++i]) & MAP_TILE_XY; }
+		else if(argument == "--threads" && is_value)		{ options_out.thread_limit = std::max(1, atoi(argv[++i])); }
+		else if(argument == "--warmup" && is_value)			{ options_out.warmup_count = (unsigned int)std::max(0, atoi(argv[++i])); }
+		else if(argument == "--iterations" && is_value)		{ options_out.iteration_count = (unsigned int)std::max(1, atoi(argv[++i])); }
+		else if(argument == "--cancel-after" && is_value)	{ options_out.cancel_after_poll_count = strtoull(argv[++i], 0, 10); }
+		else if(argument == "--output" && is_value)			{ options_out.output_path = argv[++i]; }
+		else if(argument == "--csv" && is_value)			{ options_out.csv_path = argv[++i]; }
+		else if(argument == "--normal")						{ options_out.is_normal_map = TRUE; }
+		else if(argument == "--no-diff")					{ options_out.is_diff = FALSE; }
+		else if(argument == "--list")						{ options_out.is_list = TRUE; }
+		else if(argument == "--verbose")					{ host_is_verbose = TRUE; }
+		else if(argument == "--tweak" && is_value)
+		{	host_filter_tweak_s	tweak;
+			std::string			rest, value;
+			if(!host_filter_bench_split_position(argv[++i], tweak.filter_position, rest) || sscanf(rest.c_str(), "%u=", &tweak.property_index) != 1 ||
+			   rest.find('=') == std::string::npos)
+			{	return FALSE;
+			}
+			rest = rest.substr(rest.find('=') + 1);
+			for(size_t start=0; start<=rest.size(); )
+			{	size_t end = rest.find(',', start);
+				end = (end == std::string::npos) ? rest.size() : end;
+				tweak.value_list.push_back(rest.substr(start, end - start));
+				start = end + 1;
+			}
+			options_out.tweak_list.push_back(tweak);
+		}
+		else
+		{	host_log("error: unknown or incomplete argument \"%s\".", argument.c_str());
+			return FALSE;
+		}
+	}
+	return !options_out.image_path.empty() && !options_out.filter_list.empty();
+}
+
+// Find a filter instance in the stack of a map by position. Logs an error if not found.
+host_filter_instance_s* host_filter_bench_find(host_filter_map_s* filter_map, int filter_position)
+{
+	for(size_t i=0; i<filter_map->stack_list.size(); i++)
+	{	if(filter_map->stack_list[i]->filter_position == filter_position)
+		{	return filter_map->stack_list[i];
+		}
+	}
+	host_log("error: there is no filter at position %d.", filter_position);
+	return 0;
+}
+
+// Count the bytes that differ between two buffers.
+unsigned long long host_filter_bench_count_changed(const unsigned short* before, const unsigned short* after, size_t count)
+{
+	unsigned long long changed = 0;
+	for(size_t i=0; i<count; i++)
+	{	changed += (before[i] != after[i]) ? ((before[i] & 0xFF) != (after[i] & 0xFF)) + ((before[i] >> 8) != (after[i] >> 8)) : 0;
+	}
+	return changed;
+}
+
+// Entry point.
+int main(int argc, char** argv)
+{
+	// Local data
+	host_filter_bench_options_s					options;
+	host_filter_map_s*							filter_map;
+	host_image_s								base_image, image;
+	std::vector<unsigned short>					before_list;
+	std::vector<host_filter_bench_stage_s>		stage_list;
+	host_sample_list_s							total_list;
+	FILE*										csv_fp;
+	unsigned int								fail_count;
+	BOOL										is_soft_dirty, is_success;
+	double										time_start, time_ms, total_ms;
+
+
+	setlocale(LC_ALL, "");
+	if(!host_filter_bench_parse(argc, argv, options))
+	{	host_filter_bench_usage();
+		return 1;
+	}
+
+	host_filter_context.thread_limit			= options.thread_limit;
+	host_filter_context.cancel_after_poll_count	= options.cancel_after_poll_count;
+
+	// Build the stack of a single map.
+	filter_map = host_filter_add_map(0);
+	for(size_t i=0; i<options.filter_list.size(); i++)
+	{	host_filter_plugin_s* plugin = host_filter_load_plugin(options.filter_list[i].first.c_str());
+		if(!plugin)
+		{	host_filter_shutdown();
+			return 1;
+		}
+		host_filter_add_instance(filter_map, plugin, options.filter_list[i].second);
+	}
+
+	// Apply property values.
+	for(size_t i=0; i<options.property_list.size(); i++)
+	{	int							filter_position;
+		std::string					rest;
+		host_filter_instance_s*		instance;
+		if(!host_filter_bench_split_position(options.property_list[i].c_str(), filter_position, rest) ||
+		   !(instance = host_filter_bench_find(filter_map, filter_position)) || !host_apply_property_override(instance->property_list, rest.c_str()))
+		{	host_filter_shutdown();
+			return 1;
+		}
+	}
+	for(size_t i=0; i<options.tweak_list.size(); i++)
+	{	host_filter_instance_s* instance = host_filter_bench_find(filter_map, options.tweak_list[i].filter_position);
+		if(!instance || options.tweak_list[i].property_index >= instance->property_list.size())
+		{	host_log("error: invalid --tweak property for filter %d.", options.tweak_list[i].filter_position);
+			host_filter_shutdown();
+			return 1;
+		}
+	}
+
+	// Print the stack.
+	for(size_t i=0; i<filter_map->stack_list.size(); i++)
+	{	const host_filter_instance_s* instance = filter_map->stack_list[i];
+		printf("filter %+d  %s  \"%s\" (version %u, SDK %u.%u)\n", instance->filter_position, host_get_file_name(instance->plugin->library.file_path).c_str(),
+			   host_narrow(instance->plugin->name.c_str()).c_str(), instance->plugin->info.version,
+			   instance->plugin->library.sdk_version_major, instance->plugin->library.sdk_version_minor);
+		host_print_property_list(instance->property_list);
+	}
+	if(options.is_list)
+	{	host_filter_shutdown();
+		return 0;
+	}
+
+	// Load the map and mask.
+	is_success = host_load_image(options.image_path.c_str(), base_image);
+	if(is_success && !options.mask_path.empty())
+	{	is_success = host_load_mask(options.mask_path.c_str(), filter_map->mask_width, filter_map->mask_height, filter_map->mask_pixel_list);
+	}
+	if(!is_success)
+	{	host_filter_shutdown();
+		return 1;
+	}
+	if(options.is_normal_map)
+	{	// Normal maps are passed as vectors in linear space.
+		for(size_t i=0; i<base_image.pixel_list.size(); i++)
+		{	if((i % base_image.get_channel_count()) != base_image.get_channel_count() - 1)
+			{	base_image.pixel_list[i] = host_float_to_half(host_half_to_float(base_image.pixel_list[i]) * 2.0f - 1.0f);
+			}
+		}
+		base_image.is_sRGB			= FALSE;
+		base_image.is_rasterized	= FALSE;
+	}
+	printf("map         %ux%u %s%s, %.1f MB, threads %u\n", base_image.width, base_image.height, base_image.is_grayscale ? "grayscale" : "color",
+		   options.is_normal_map ? " normal map" : (base_image.is_sRGB ? " sRGB" : " linear"), base_image.get_byte_size() / 1048576.0, options.thread_limit);
+
+	csv_fp = 0;
+	if(!options.csv_path.empty())
+	{	csv_fp = fopen(options.csv_path.c_str(), "a");
+		if(!csv_fp)
+		{	host_log("error: failed to open \"%s\".", options.csv_path.c_str());
+		}
+		else if(ftell(csv_fp) == 0)
+		{	fprintf(csv_fp, "run,position,plugin,result,width,height,time_ms,mb_per_s,written_bytes,changed_bytes,progress_calls,cancel_polls\n");
+		}
+	}
+
+	// Run the stack.
+	stage_list.resize(filter_map->stack_list.size());
+	is_soft_dirty	= host_is_soft_dirty_supported();
+	fail_count		= 0;
+	for(unsigned int run=0; run<options.warmup_count + options.iteration_count; run++)
+	{
+		BOOL			is_warmup	= (run < options.warmup_count);
+		unsigned int	timed_run	= run - options.warmup_count;
+
+		// Apply the next value of each tweaked property.
+		for(size_t i=0; i<options.tweak_list.size(); i++)
+		{	const host_filter_tweak_s& tweak = options.tweak_list[i];
+			host_filter_instance_s* instance = host_filter_bench_find(filter_map, tweak.filter_position);
+			host_set_property_from_string(instance->property_list[tweak.property_index], tweak.value_list[run % tweak.value_list.size()].c_str());
+		}
+
+		// Every run starts from the unfiltered map.
+		image = base_image;
+		host_filter_context.is_cancel			= FALSE;
+		host_filter_context.cancel_poll_count	= 0;
+		total_ms = 0.0;
+
+		for(size_t i=0; i<filter_map->stack_list.size(); i++)
+		{
+			host_filter_instance_s*		instance	= filter_map->stack_list[i];
+			unsigned long long			written		= ULLONG_MAX;
+			unsigned long long			changed		= 0;
+
+			if(options.is_diff && !is_warmup)
+			{	before_list = image.pixel_list;
+			}
+			if(is_soft_dirty)
+			{	host_clear_soft_dirty();
+			}
+
+			time_start	= host_get_time();
+			is_success	= host_filter_process_instance(filter_map, instance, image, options.is_normal_map, options.coord_system, options.tile_type);
+			time_ms		= (host_get_time() - time_start) * 1000.0;
+			total_ms	+= time_ms;
+
+			if(is_warmup)
+			{	continue;
+			}
+			if(is_soft_dirty)
+			{	written = host_get_written_byte_count(image.pixel_list.data(), (size_t)image.get_byte_size());
+			}
+			if(options.is_diff)
+			{	changed = host_filter_bench_count_changed(before_list.data(), image.pixel_list.data(), image.pixel_list.size());
+			}
+
+			host_filter_bench_stage_s& stage = stage_list[i];
+			stage.time_list.add(time_ms);
+			if(written != ULLONG_MAX)
+			{	stage.written_list.add((double)written);
+			}
+			stage.changed_list.add((double)changed);
+			if(!is_success)
+			{	stage.fail_count++;
+				fail_count++;
+			}
+
+			if(host_is_verbose || options.iteration_count <= 10)
+			{	printf("run %3u  filter %+3d  %-6s  %9.3f ms  %9.1f MB/s  written %9.2f MB  changed %9.2f MB  progress %u  polls %llu\n", timed_run,
+					   instance->filter_position, is_success ? "ok" : (host_filter_context.is_cancel ? "cancel" : "fail"), time_ms,
+					   time_ms > 0.0 ? image.get_byte_size() / 1048576.0 / (time_ms / 1000.0) : 0.0,
+					   written == ULLONG_MAX ? 0.0 : written / 1048576.0, options.is_diff ? changed / 1048576.0 : 0.0,
+					   (unsigned int)instance->progress_call_count, instance->cancel_poll_count);
+			}
+			if(csv_fp)
+			{	fprintf(csv_fp, "%u,%d,%s,%d,%u,%u,%.4f,%.2f,%lld,%lld,%u,%llu\n", timed_run, instance->filter_position,
+						host_get_file_name(instance->plugin->library.file_path).c_str(), is_success ? 1 : 0, image.width, image.height, time_ms,
+						time_ms > 0.0 ? image.get_byte_size() / 1048576.0 / (time_ms / 1000.0) : 0.0,
+						written == ULLONG_MAX ? -1ll : (long long)written, options.is_diff ? (long long)changed : -1ll,
+						(unsigned int)instance->progress_call_count, instance->cancel_poll_count);
+			}
+
+			// A failed or canceled filter stops the stack the same as in ShaderMap.
+			if(!is_success)
+			{	break;
+			}
+		}
+
+		if(!is_warmup)
+		{	total_list.add(total_ms);
+		}
+	}
+
+	// Summary
+	printf("\nfilter     median ms    mean ms     max ms   share  written MB  changed MB  fails\n");
+	for(size_t i=0; i<filter_map->stack_list.size(); i++)
+	{	const host_filter_bench_stage_s&	stage = stage_list[i];
+		char								written_string[32];
+
+		if(stage.written_list.sample_list.empty())
+		{	snprintf(written_string, sizeof(written_string), "n/a");
+		}
+		else
+		{	snprintf(written_string, sizeof(written_string), "%.2f", stage.written_list.median() / 1048576.0);
+		}
+		printf("%+6d  %11.3f %10.3f %10.3f  %5.1f%%  %10s  %10.2f  %5u\n", filter_map->stack_list[i]->filter_position,
+			   stage.time_list.median(), stage.time_list.mean(), stage.time_list.max(),
+			   total_list.mean() > 0.0 ? stage.time_list.mean() / total_list.mean() * 100.0 : 0.0,
+			   written_string, options.is_diff ? stage.changed_list.median() / 1048576.0 : 0.0, stage.fail_count);
+	}
+	printf("stack   %11.3f %10.3f %10.3f  (min %.3f ms)\n", total_list.median(), total_list.mean(), total_list.max(), total_list.min());
+
+	if(csv_fp)
+	{	fclose(csv_fp);
+	}
+
+	if(!options.output_path.empty())
+	{	if(options.is_normal_map)
+		{	// Back to 0...1 for viewing.
+			for(size_t i=0; i<image.pixel_list.size(); i++)
+			{	if((i % image.get_channel_count()) != image.get_channel_count() - 1)
+				{	image.pixel_list[i] = host_float_to_half(host_half_to_float(image.pixel_list[i]) * 0.5f + 0.5f);
+				}
+			}
+		}
+		if(!host_save_exr(options.output_path.c_str(), image))
+		{	fail_count++;
+		}
+	}
+
+	host_filter_shutdown();
+	return fail_count ? 1 : 0;
+}
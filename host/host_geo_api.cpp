@@ -0,0 +1,709 @@
+/*
+	===============================================================
+
+	SHADERMAP HEADLESS HOST - GEOMETRY API SOURCE FILE
+
+	Implements the functions that ShaderMap passes to geometry
+	plugins in "plugin_initialize()" (see
+	"geometry/geo_plugin_core.cpp") so that geometry importers can
+	be run without ShaderMap.
+
+	The host asks for one geometry type per import, RENDER or
+	NODE, and copies the arrays passed to
+	"gp_create_render_geometry()" or "gp_create_node_geometry()"
+	the same way ShaderMap does. NODE geometry can also arrive in
+	chunks from "gp_append_node_geometry()". The copy is timed
+	separately so that the importer time can be reported without
+	it.
+
+	Progress and cancel are recorded in host_geo_context. Set
+	cancel_after_poll_count to cancel an import after that many
+	calls of "gp_is_cancel_process()".
+
+	Include after the geometry plugin core (with SMSDK_HOST
+	defined), "geometry/geo_custom_v2.cpp" and "host_common.cpp".
+
+
+	SHADERMAP SDK LICENSE
+
+	The ShaderMap SDK is released under The MIT License (MIT)
+	http://opensource.org/licenses/MIT
+
+	Copyright (c) 2007-2019 Rendering Systems Inc.
+
+	See "host_common.cpp" for the full license text.
+
+	===============================================================
+*/
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Geometry host structs
+
+// A loaded geometry plugin and the file info it set in "on_initialize()".
+struct host_geo_plugin_s
+{
+	host_library_s								library;
+	std::wstring								name;
+	std::vector<std::wstring>					extension_list;
+};
+
+// The geometry received from an importer.
+struct host_geometry_s
+{
+	unsigned int								geometry_type;			// GP_GEOMETRY_TYPE_ of the import.
+	unsigned int								subset_count;
+	BOOL										is_create_normals;
+	BOOL										is_no_uv;				// Set by "gp_flag_no_uv_geometry()".
+	unsigned int								create_call_count;		// Calls to gp_create_render_geometry(), gp_create_node_geometry() or gp_end_node_geometry().
+	unsigned int								append_call_count;		// Calls to gp_append_node_geometry().
+
+	// GP_GEOMETRY_TYPE_RENDER
+	std::vector<gp_render_vertex_s>				render_vertex_list;
+	std::vector<gp_render_face_s>				render_face_list;
+	std::vector<std::vector<float> >			additional_uv_list;		// 2 floats per vertex per additional channel.
+
+	// GP_GEOMETRY_TYPE_NODE
+	std::vector<gp_node_vertex_s>				node_vertex_list;
+	std::vector<gp_node_face_s>					node_face_list;
+	std::vector<std::vector<gp_node_uv_s> >		uv_channel_list;
+	std::vector<std::vector<unsigned int> >		uv_index_list;			// 3 per triangle per channel.
+	std::vector<std::vector<unsigned int> >		material_id_list;		// Subsets of each material id.
+
+	// c()
+	host_geometry_s(void)
+	{	clear(GP_GEOMETRY_TYPE_RENDER);
+	}
+
+	// Release all arrays and set the geometry type of the next import.
+	void clear(unsigned int type)
+	{	geometry_type = type; subset_count = 0; is_create_normals = FALSE; is_no_uv = FALSE; create_call_count = 0; append_call_count = 0;
+		std::vector<gp_render_vertex_s>().swap(render_vertex_list);
+		std::vector<gp_render_face_s>().swap(render_face_list);
+		std::vector<std::vector<float> >().swap(additional_uv_list);
+		std::vector<gp_node_vertex_s>().swap(node_vertex_list);
+		std::vector<gp_node_face_s>().swap(node_face_list);
+		std::vector<std::vector<gp_node_uv_s> >().swap(uv_channel_list);
+		std::vector<std::vector<unsigned int> >().swap(uv_index_list);
+		std::vector<std::vector<unsigned int> >().swap(material_id_list);
+	}
+
+	// Return the number of vertices.
+	unsigned int get_vertex_count(void) const
+	{	return (unsigned int)(geometry_type == GP_GEOMETRY_TYPE_RENDER ? render_vertex_list.size() : node_vertex_list.size());
+	}
+
+	// Return the number of triangles.
+	unsigned int get_triangle_count(void) const
+	{	return (unsigned int)(geometry_type == GP_GEOMETRY_TYPE_RENDER ? render_face_list.size() : node_face_list.size());
+	}
+
+	// Return the size of the geometry arrays in bytes.
+	unsigned long long get_byte_size(void) const
+	{	unsigned long long size = render_vertex_list.size() * sizeof(gp_render_vertex_s) + render_face_list.size() * sizeof(gp_render_face_s) +
+								  node_vertex_list.size() * sizeof(gp_node_vertex_s) + node_face_list.size() * sizeof(gp_node_face_s);
+		for(size_t i=0; i<additional_uv_list.size(); i++)
+		{	size += additional_uv_list[i].size() * sizeof(float);
+		}
+		for(size_t i=0; i<uv_channel_list.size(); i++)
+		{	size += uv_channel_list[i].size() * sizeof(gp_node_uv_s) + uv_index_list[i].size() * sizeof(unsigned int);
+		}
+		return size;
+	}
+};
+
+// Host state shared by all geometry API functions.
+struct host_geo_context_s
+{
+	std::vector<host_geo_plugin_s*>				plugin_list;
+	host_geo_plugin_s*							initializing_plugin;	// Plugin inside "on_initialize()".
+
+	// The import in progress.
+	host_geometry_s								geometry;
+	double										create_time;			// Seconds spent copying geometry in the create functions.
+	unsigned int								error_count;			// Calls to gp_log_plugin_error().
+	unsigned int								progress;				// Last value passed to gp_set_progress().
+	unsigned int								progress_call_count;
+
+	// Cancel control. Cancel is set by the host or after cancel_after_poll_count calls of "gp_is_cancel_process()" (0 disables).
+	BOOL										is_cancel;
+	unsigned long long							cancel_poll_count;
+	unsigned long long							cancel_after_poll_count;
+
+	// ShaderMap options.
+	BOOL										option_material_color_from_file;
+
+	// Translation files defined by plugins.
+	std::vector<std::wstring>					translation_file_list;
+
+	// c()
+	host_geo_context_s(void)
+	{	initializing_plugin					= 0;
+		create_time							= 0.0;
+		error_count							= 0;
+		progress							= 0;
+		progress_call_count					= 0;
+		is_cancel							= FALSE;
+		cancel_poll_count					= 0;
+		cancel_after_poll_count				= 0;
+		option_material_color_from_file		= TRUE;
+	}
+};
+
+host_geo_context_s								host_geo_context;
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Geometry API - setup and info functions (0 - 3, 100)
+
+void host_gp_begin_initialize(void)
+{
+}
+
+void host_gp_end_initialize(void)
+{
+}
+
+unsigned int host_gp_define_translation_file(const wchar_t* file_title, const wchar_t* default_prefix)
+{
+	host_geo_context.translation_file_list.push_back(file_title ? file_title : L"");
+	return (unsigned int)host_geo_context.translation_file_list.size() - 1;
+}
+
+// Translation files are not loaded by the headless host. An empty string is returned for every id.
+const wchar_t* host_gp_get_trans_string(unsigned int file_index, unsigned int id)
+{
+	return L"";
+}
+
+void host_gp_set_file_info(const wchar_t* name, const wchar_t** extension_array, unsigned int extension_count)
+{
+	host_geo_plugin_s* plugin = host_geo_context.initializing_plugin;
+	if(!plugin)
+	{	host_log("error: %s: called outside of on_initialize().", __FUNCTION__);
+		return;
+	}
+	plugin->name = name ? name : L"";
+	plugin->extension_list.clear();
+	for(unsigned int i=0; i<extension_count; i++)
+	{	plugin->extension_list.push_back(extension_array[i] ? extension_array[i] : L"");
+	}
+}
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Geometry API - process functions (200 - 206)
+
+unsigned int host_gp_get_geometry_type(void)
+{
+	return host_geo_context.geometry.geometry_type;
+}
+
+BOOL host_gp_create_render_geometry(gp_render_vertex_s* vertex_array, unsigned int vertex_count, gp_render_face_s* triangle_array, unsigned int triangle_count,
+									unsigned int subset_count, BOOL is_create_normals, float** additional_uv_arrays, unsigned int additional_uv_array_count)
+{
+	host_geometry_s&	geometry	= host_geo_context.geometry;
+	double				time_start	= host_get_time();
+
+
+	if(geometry.geometry_type != GP_GEOMETRY_TYPE_RENDER)
+	{	host_log("error: %s: the requested geometry type is NODE.", __FUNCTION__);
+		return FALSE;
+	}
+	if(!vertex_array || !triangle_array || !vertex_count || !triangle_count || !subset_count || (additional_uv_array_count && !additional_uv_arrays))
+	{	host_log("error: %s: empty or invalid geometry arrays.", __FUNCTION__);
+		return FALSE;
+	}
+
+	try
+	{	geometry.render_vertex_list.assign(vertex_array, vertex_array + vertex_count);
+		geometry.render_face_list.assign(triangle_array, triangle_array + triangle_count);
+		geometry.additional_uv_list.resize(additional_uv_array_count);
+		for(unsigned int i=0; i<additional_uv_array_count; i++)
+		{	geometry.additional_uv_list[i].assign(additional_uv_arrays[i], additional_uv_arrays[i] + (size_t)vertex_count * 2);
+		}
+	}
+	catch(const std::bad_alloc&)
+	{	host_log("error: %s: failed to allocate %u vertices and %u triangles.", __FUNCTION__, vertex_count, triangle_count);
+		geometry.clear(GP_GEOMETRY_TYPE_RENDER);
+		return FALSE;
+	}
+	geometry.subset_count		= subset_count;
+	geometry.is_create_normals	= is_create_normals ? TRUE : FALSE;
+	geometry.create_call_count++;
+
+	host_geo_context.create_time += host_get_time() - time_start;
+	return TRUE;
+}
+
+BOOL host_gp_create_node_geometry(gp_node_vertex_s* vertex_array, unsigned int vertex_count, gp_node_face_s* triangle_array, unsigned int triangle_count,
+								  const gp_node_uv_data_s* uv_data_pointer, unsigned int subset_count, BOOL is_create_normals)
+{
+	host_geometry_s&	geometry	= host_geo_context.geometry;
+	double				time_start	= host_get_time();
+
+
+	if(geometry.geometry_type != GP_GEOMETRY_TYPE_NODE)
+	{	host_log("error: %s: the requested geometry type is RENDER.", __FUNCTION__);
+		return FALSE;
+	}
+	if(geometry.append_call_count)
+	{	host_log("error: %s: geometry was appended, finish it with gp_end_node_geometry().", __FUNCTION__);
+		return FALSE;
+	}
+	if(!vertex_array || !triangle_array || !vertex_count || !triangle_count || !subset_count)
+	{	host_log("error: %s: empty or invalid geometry arrays.", __FUNCTION__);
+		return FALSE;
+	}
+	if(uv_data_pointer && uv_data_pointer->uv_channel_count &&
+	   (!uv_data_pointer->uv_channels_array || !uv_data_pointer->uv_count_array || !uv_data_pointer->uv_indices_array))
+	{	host_log("error: %s: invalid uv data.", __FUNCTION__);
+		return FALSE;
+	}
+
+	try
+	{	geometry.node_vertex_list.assign(vertex_array, vertex_array + vertex_count);
+		geometry.node_face_list.assign(triangle_array, triangle_array + triangle_count);
+		if(uv_data_pointer)
+		{	geometry.uv_channel_list.resize(uv_data_pointer->uv_channel_count);
+			geometry.uv_index_list.resize(uv_data_pointer->uv_channel_count);
+			for(unsigned int i=0; i<uv_data_pointer->uv_channel_count; i++)
+			{	geometry.uv_channel_list[i].assign(uv_data_pointer->uv_channels_array[i], uv_data_pointer->uv_channels_array[i] + uv_data_pointer->uv_count_array[i]);
+				geometry.uv_index_list[i].assign(uv_data_pointer->uv_indices_array[i], uv_data_pointer->uv_indices_array[i] + (size_t)triangle_count * 3);
+			}
+		}
+	}
+	catch(const std::bad_alloc&)
+	{	host_log("error: %s: failed to allocate %u vertices and %u triangles.", __FUNCTION__, vertex_count, triangle_count);
+		geometry.clear(GP_GEOMETRY_TYPE_NODE);
+		return FALSE;
+	}
+	geometry.subset_count		= subset_count;
+	geometry.is_create_normals	= is_create_normals ? TRUE : FALSE;
+	geometry.create_call_count++;
+
+	host_geo_context.create_time += host_get_time() - time_start;
+	return TRUE;
+}
+
+void host_gp_log_plugin_error(unsigned int plugin_index, const wchar_t* error_message, const wchar_t* function, const wchar_t* source_filepath, int source_line_number)
+{
+	host_geo_context.error_count++;
+	host_log("error: plugin %u: %s [%s, %s:%d]", plugin_index, host_narrow(error_message).c_str(), host_narrow(function).c_str(),
+			 host_get_file_name(host_narrow(source_filepath)).c_str(), source_line_number);
+}
+
+void host_gp_define_node_material_id(unsigned int subset_count, const unsigned int* subset_array)
+{
+	if(!subset_count || !subset_array)
+	{	host_log("error: %s: empty subset list.", __FUNCTION__);
+		return;
+	}
+	host_geo_context.geometry.material_id_list.push_back(std::vector<unsigned int>(subset_array, subset_array + subset_count));
+}
+
+BOOL host_gp_is_option_material_color_from_file(void)
+{
+	return host_geo_context.option_material_color_from_file;
+}
+
+void host_gp_flag_no_uv_geometry(void)
+{
+	host_geo_context.geometry.is_no_uv = TRUE;
+}
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Geometry API - progress, cancel and streaming functions (207 - 210)
+
+void host_gp_set_progress(unsigned int progress)
+{
+	host_geo_context.progress = progress > 100 ? 100 : progress;
+	host_geo_context.progress_call_count++;
+}
+
+BOOL host_gp_is_cancel_process(void)
+{
+	unsigned long long poll_count = ++host_geo_context.cancel_poll_count;
+	if(host_geo_context.cancel_after_poll_count && poll_count >= host_geo_context.cancel_after_poll_count)
+	{	host_geo_context.is_cancel = TRUE;
+	}
+	return host_geo_context.is_cancel;
+}
+
+// Chunks are added to the geometry lists as they arrive. Indices are checked against the vertices and uvs received so far
+// since those are all ShaderMap has when it builds the model from the chunks.
+BOOL host_gp_append_node_geometry(const gp_node_vertex_s* vertex_array, unsigned int vertex_count, const gp_node_face_s* triangle_array, unsigned int triangle_count,
+								  const gp_node_uv_data_s* uv_data_pointer)
+{
+	// Local data
+	host_geometry_s&							geometry	= host_geo_context.geometry;
+	double										time_start	= host_get_time();
+	unsigned int								uv_channel_count, total_vertex_count, total_uv_count;
+
+
+	if(geometry.geometry_type != GP_GEOMETRY_TYPE_NODE)
+	{	host_log("error: %s: the requested geometry type is RENDER.", __FUNCTION__);
+		return FALSE;
+	}
+	if(geometry.create_call_count)
+	{	host_log("error: %s: the geometry was already created.", __FUNCTION__);
+		return FALSE;
+	}
+	uv_channel_count = uv_data_pointer ? uv_data_pointer->uv_channel_count : 0;
+	if((vertex_count && !vertex_array) || (triangle_count && !triangle_array) ||
+	   (uv_channel_count && (!uv_data_pointer->uv_channels_array || !uv_data_pointer->uv_count_array || !uv_data_pointer->uv_indices_array)))
+	{	host_log("error: %s: invalid geometry arrays.", __FUNCTION__);
+		return FALSE;
+	}
+	if(geometry.append_call_count && uv_channel_count != geometry.uv_channel_list.size())
+	{	host_log("error: %s: %u uv channels, earlier chunks had %u.", __FUNCTION__, uv_channel_count, (unsigned int)geometry.uv_channel_list.size());
+		return FALSE;
+	}
+	if((unsigned long long)geometry.node_vertex_list.size() + vertex_count > UINT_MAX ||
+	   (unsigned long long)geometry.node_face_list.size() + triangle_count > UINT_MAX / 3)
+	{	host_log("error: %s: too many vertices or triangles.", __FUNCTION__);
+		return FALSE;
+	}
+
+	// Faces may only use what has been received.
+	total_vertex_count = (unsigned int)geometry.node_vertex_list.size() + vertex_count;
+	for(unsigned int t=0; t<triangle_count; t++)
+	{	if(triangle_array[t].a >= total_vertex_count || triangle_array[t].b >= total_vertex_count || triangle_array[t].c >= total_vertex_count)
+		{	host_log("error: %s: chunk triangle %u uses a vertex that was not appended (%u vertices).", __FUNCTION__, t, total_vertex_count);
+			return FALSE;
+		}
+	}
+	for(unsigned int i=0; i<uv_channel_count; i++)
+	{	total_uv_count = (unsigned int)(geometry.append_call_count ? geometry.uv_channel_list[i].size() : 0) + uv_data_pointer->uv_count_array[i];
+		if((uv_data_pointer->uv_count_array[i] && !uv_data_pointer->uv_channels_array[i]) || (triangle_count && !uv_data_pointer->uv_indices_array[i]))
+		{	host_log("error: %s: invalid uv data.", __FUNCTION__);
+			return FALSE;
+		}
+		for(size_t j=0; j<(size_t)triangle_count * 3; j++)
+		{	if(uv_data_pointer->uv_indices_array[i][j] >= total_uv_count)
+			{	host_log("error: %s: uv channel %u index %u uses a uv that was not appended (%u uvs).", __FUNCTION__, i, (unsigned int)j, total_uv_count);
+				return FALSE;
+			}
+		}
+	}
+
+	try
+	{	geometry.node_vertex_list.insert(geometry.node_vertex_list.end(), vertex_array, vertex_array + vertex_count);
+		geometry.node_face_list.insert(geometry.node_face_list.end(), triangle_array, triangle_array + triangle_count);
+		geometry.uv_channel_list.resize(uv_channel_count);
+		geometry.uv_index_list.resize(uv_channel_count);
+		for(unsigned int i=0; i<uv_channel_count; i++)
+		{	geometry.uv_channel_list[i].insert(geometry.uv_channel_list[i].end(), uv_data_pointer->uv_channels_array[i],
+											   uv_data_pointer->uv_channels_array[i] + uv_data_pointer->uv_count_array[i]);
+			geometry.uv_index_list[i].insert(geometry.uv_index_list[i].end(), uv_data_pointer->uv_indices_array[i],
+											 uv_data_pointer->uv_indices_array[i] + (size_t)triangle_count * 3);
+		}
+	}
+	catch(const std::bad_alloc&)
+	{	host_log("error: %s: failed to allocate %u vertices and %u triangles.", __FUNCTION__, vertex_count, triangle_count);
+		geometry.clear(GP_GEOMETRY_TYPE_NODE);
+		return FALSE;
+	}
+	geometry.append_call_count++;
+
+	host_geo_context.create_time += host_get_time() - time_start;
+	return TRUE;
+}
+
+BOOL host_gp_end_node_geometry(unsigned int subset_count, BOOL is_create_normals)
+{
+	host_geometry_s& geometry = host_geo_context.geometry;
+
+
+	if(!geometry.append_call_count || geometry.create_call_count)
+	{	host_log("error: %s: no appended geometry to end.", __FUNCTION__);
+		return FALSE;
+	}
+	if(geometry.node_vertex_list.empty() || geometry.node_face_list.empty() || !subset_count)
+	{	host_log("error: %s: empty geometry or no subsets.", __FUNCTION__);
+		return FALSE;
+	}
+	geometry.subset_count		= subset_count;
+	geometry.is_create_normals	= is_create_normals ? TRUE : FALSE;
+	geometry.create_call_count++;
+	return TRUE;
+}
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Geometry host functions
+
+// Fill the function pointer array passed to "plugin_initialize()". Element numbers match "geometry/geo_plugin_core.cpp".
+void host_geo_build_function_pointer_array(void** function_pointer_array)
+{
+	memset(function_pointer_array, 0, sizeof(void*) * HOST_FUNCTION_POINTER_COUNT);
+
+	function_pointer_array[0]	= (void*)host_gp_begin_initialize;
+	function_pointer_array[1]	= (void*)host_gp_end_initialize;
+	function_pointer_array[2]	= (void*)host_gp_define_translation_file;
+	function_pointer_array[3]	= (void*)host_gp_get_trans_string;
+
+	function_pointer_array[100]	= (void*)host_gp_set_file_info;
+
+	function_pointer_array[200]	= (void*)host_gp_get_geometry_type;
+	function_pointer_array[201]	= (void*)host_gp_create_render_geometry;
+	function_pointer_array[202]	= (void*)host_gp_create_node_geometry;
+	function_pointer_array[203]	= (void*)host_gp_log_plugin_error;
+	function_pointer_array[204]	= (void*)host_gp_define_node_material_id;
+	function_pointer_array[205]	= (void*)host_gp_is_option_material_color_from_file;
+	function_pointer_array[206]	= (void*)host_gp_flag_no_uv_geometry;
+	function_pointer_array[207]	= (void*)host_gp_set_progress;
+	function_pointer_array[208]	= (void*)host_gp_is_cancel_process;
+	function_pointer_array[209]	= (void*)host_gp_append_node_geometry;
+	function_pointer_array[210]	= (void*)host_gp_end_node_geometry;
+}
+
+// Load and initialize a geometry plugin. Returns 0 and logs an error on failure.
+host_geo_plugin_s* host_geo_load_plugin(const char* file_path)
+{
+	// Local data
+	host_geo_plugin_s*							plugin;
+	void*										function_pointer_array[HOST_FUNCTION_POINTER_COUNT];
+	BOOL										is_success;
+
+
+	plugin = new host_geo_plugin_s;
+	if(!host_load_library(file_path, plugin->library))
+	{	delete plugin;
+		return 0;
+	}
+
+	host_geo_build_function_pointer_array(function_pointer_array);
+	host_geo_context.initializing_plugin = plugin;
+	is_success = plugin->library.plugin_initialize(function_pointer_array);
+	host_geo_context.initializing_plugin = 0;
+	if(!is_success)
+	{	host_log("error: \"%s\" failed to initialize.", file_path);
+		host_unload_library(plugin->library);
+		delete plugin;
+		return 0;
+	}
+
+	host_geo_context.plugin_list.push_back(plugin);
+	return plugin;
+}
+
+// Import a file with a plugin as RENDER or NODE geometry. The result is left in host_geo_context.geometry.
+// Returns FALSE if "on_process()" failed or the plugin did not create geometry.
+BOOL host_geo_import(host_geo_plugin_s* plugin, unsigned int plugin_index, const char* file_path, unsigned int geometry_type)
+{
+	// Local data
+	std::wstring								wide_path;
+	BOOL										is_success;
+
+
+	host_geo_context.geometry.clear(geometry_type);
+	host_geo_context.create_time			= 0.0;
+	host_geo_context.error_count			= 0;
+	host_geo_context.progress				= 0;
+	host_geo_context.progress_call_count	= 0;
+	host_geo_context.is_cancel				= FALSE;
+	host_geo_context.cancel_poll_count		= 0;
+
+	wide_path	= host_widen(file_path);
+	is_success	= plugin->library.plugin_process(&plugin_index, (void*)wide_path.c_str());
+	if(is_success && !host_geo_context.geometry.create_call_count)
+	{	host_log(host_geo_context.geometry.append_call_count ? "error: \"%s\" appended geometry without gp_end_node_geometry()." :
+				 "error: \"%s\" returned TRUE without creating geometry.", host_get_file_name(plugin->library.file_path).c_str());
+		is_success = FALSE;
+	}
+	if(is_success && host_geo_context.is_cancel)
+	{	host_log("error: \"%s\" returned TRUE after the import was canceled.", host_get_file_name(plugin->library.file_path).c_str());
+		is_success = FALSE;
+	}
+	return is_success;
+}
+
+// Check the received geometry the way ShaderMap relies on it: indices in range, subsets sorted and below the subset count,
+// uv indices in range. Logs the first problem of each kind and returns the number of problems found.
+unsigned int host_geo_validate(const host_geometry_s& geometry)
+{
+	// Local data
+	unsigned int								problem_count, vertex_count, triangle_count, previous_subset;
+	BOOL										is_index_logged, is_subset_logged;
+
+
+	problem_count		= 0;
+	is_index_logged		= FALSE;
+	is_subset_logged	= FALSE;
+	previous_subset		= 0;
+	vertex_count		= geometry.get_vertex_count();
+	triangle_count		= geometry.get_triangle_count();
+
+	for(unsigned int t=0; t<triangle_count; t++)
+	{
+		unsigned int a, b, c, subset_index;
+		if(geometry.geometry_type == GP_GEOMETRY_TYPE_RENDER)
+		{	const gp_render_face_s& face = geometry.render_face_list[t];
+			a = face.a; b = face.b; c = face.c; subset_index = face.subset_index;
+		}
+		else
+		{	const gp_node_face_s& face = geometry.node_face_list[t];
+			a = face.a; b = face.b; c = face.c; subset_index = face.subset_index;
+		}
+
+		if(a >= vertex_count || b >= vertex_count || c >= vertex_count)
+		{	if(!is_index_logged)
+			{	host_log("invalid: triangle %u has a vertex index out of range (%u vertices).", t, vertex_count);
+				is_index_logged = TRUE;
+			}
+			problem_count++;
+		}
+		if(subset_index >= geometry.subset_count || subset_index < previous_subset)
+		{	if(!is_subset_logged)
+			{	host_log("invalid: triangle %u has subset %u, subset count %u, previous subset %u.", t, subset_index, geometry.subset_count, previous_subset);
+				is_subset_logged = TRUE;
+			}
+			problem_count++;
+		}
+		previous_subset = subset_index;
+	}
+
+	for(size_t i=0; i<geometry.uv_index_list.size(); i++)
+	{	unsigned int uv_count = (unsigned int)geometry.uv_channel_list[i].size();
+		for(size_t j=0; j<geometry.uv_index_list[i].size(); j++)
+		{	if(geometry.uv_index_list[i][j] >= uv_count)
+			{	host_log("invalid: uv channel %u index %u is out of range (%u uvs).", (unsigned int)i, (unsigned int)j, uv_count);
+				problem_count++;
+				break;
+			}
+		}
+	}
+
+	for(size_t i=0; i<geometry.material_id_list.size(); i++)
+	{	for(size_t j=0; j<geometry.material_id_list[i].size(); j++)
+		{	if(geometry.material_id_list[i][j] >= geometry.subset_count)
+			{	host_log("invalid: material id %u lists subset %u, subset count %u.", (unsigned int)i, geometry.material_id_list[i][j], geometry.subset_count);
+				problem_count++;
+				break;
+			}
+		}
+	}
+
+	return problem_count;
+}
+
+// Save NODE geometry with its first uv channel as a CUSTOM file (see "host_model.cpp"). Returns FALSE and logs an error on failure.
+BOOL host_geo_save_custom(const char* file_path, const host_geometry_s& geometry)
+{
+	// Local data
+	FILE*										fp;
+	unsigned int								count_array[3];
+	std::vector<unsigned int>					index_list;
+	gp_node_uv_s								zero_uv;
+	BOOL										is_success;
+
+
+	if(geometry.geometry_type != GP_GEOMETRY_TYPE_NODE || geometry.node_face_list.empty())
+	{	host_log("error: only NODE geometry can be saved as CUSTOM.");
+		return FALSE;
+	}
+
+	BOOL is_uv = !geometry.uv_channel_list.empty() && !geometry.uv_channel_list[0].empty();
+	index_list.resize(geometry.node_face_list.size() * 7);
+	for(size_t t=0; t<geometry.node_face_list.size(); t++)
+	{	unsigned int* index = &index_list[t * 7];
+		index[0] = geometry.node_face_list[t].a;
+		index[1] = geometry.node_face_list[t].b;
+		index[2] = geometry.node_face_list[t].c;
+		index[3] = is_uv ? geometry.uv_index_list[0][t * 3] : 0;
+		index[4] = is_uv ? geometry.uv_index_list[0][t * 3 + 1] : 0;
+		index[5] = is_uv ? geometry.uv_index_list[0][t * 3 + 2] : 0;
+		index[6] = (unsigned int)(t * 3);
+	}
+	count_array[0] = (unsigned int)geometry.node_vertex_list.size();
+	count_array[1] = is_uv ? (unsigned int)geometry.uv_channel_list[0].size() : 1;
+	count_array[2] = (unsigned int)index_list.size();
+
+	fp = fopen(file_path, "wb");
+	if(!fp)
+	{	host_log("error: failed to create \"%s\".", file_path);
+		return FALSE;
+	}
+	// gp_node_vertex_s and gp_node_uv_s have the same layout as the CUSTOM vertex and uv.
+	is_success = fwrite(count_array, sizeof(unsigned int), 3, fp) == 3 &&
+				 fwrite(geometry.node_vertex_list.data(), sizeof(gp_node_vertex_s), count_array[0], fp) == count_array[0] &&
+				 (is_uv ? fwrite(geometry.uv_channel_list[0].data(), sizeof(gp_node_uv_s), count_array[1], fp) == count_array[1] :
+						  fwrite(&zero_uv, sizeof(gp_node_uv_s), 1, fp) == 1) &&
+				 fwrite(index_list.data(), sizeof(unsigned int), count_array[2], fp) == count_array[2];
+	if(fclose(fp) != 0 || !is_success)
+	{	host_log("error: failed to write \"%s\".", file_path);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+// Save NODE geometry with its subsets, material ids and uv channels as a CUSTOM version 2 file (see
+// "geometry/geo_custom_v2.cpp"). Returns FALSE and logs an error on failure.
+BOOL host_geo_save_custom_v2(const char* file_path, const host_geometry_s& geometry)
+{
+	// Local data
+	geo_cv2_mesh_s								mesh;
+	std::vector<unsigned char>					file_data;
+	const wchar_t*								error;
+	FILE*										fp;
+	BOOL										is_success;
+
+
+	if(geometry.geometry_type != GP_GEOMETRY_TYPE_NODE || geometry.node_face_list.empty())
+	{	host_log("error: only NODE geometry can be saved as CUSTOM.");
+		return FALSE;
+	}
+
+	// Subsets not listed by a material id get a material of their own.
+	mesh.vertex_list		= geometry.node_vertex_list;
+	mesh.face_list			= geometry.node_face_list;
+	mesh.uv_channel_list	= geometry.uv_channel_list;
+	mesh.uv_index_list		= geometry.uv_index_list;
+	mesh.is_color			= host_geo_context.option_material_color_from_file;
+	mesh.subset_material_list.resize(geometry.subset_count);
+	for(unsigned int i=0; i<geometry.subset_count; i++)
+	{	mesh.subset_material_list[i] = (unsigned int)geometry.material_id_list.size() + i;
+	}
+	for(size_t i=0; i<geometry.material_id_list.size(); i++)
+	{	for(size_t j=0; j<geometry.material_id_list[i].size(); j++)
+		{	if(geometry.material_id_list[i][j] < geometry.subset_count)
+			{	mesh.subset_material_list[geometry.material_id_list[i][j]] = (unsigned int)i;
+			}
+		}
+	}
+
+	if(!geo_cv2_encode(mesh, GEO_CV2_POSITION_BITS, GEO_CV2_NORMAL_BITS, GEO_CV2_UV_BITS, file_data, error))
+	{	host_log("error: failed to encode \"%s\": %s", file_path, host_narrow(error).c_str());
+		return FALSE;
+	}
+
+	fp = fopen(file_path, "wb");
+	if(!fp)
+	{	host_log("error: failed to create \"%s\".", file_path);
+		return FALSE;
+	}
+	is_success = fwrite(file_data.data(), 1, file_data.size(), fp) == file_data.size();
+	if(fclose(fp) != 0 || !is_success)
+	{	host_log("error: failed to write \"%s\".", file_path);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+// Shutdown all plugins.
+void host_geo_shutdown(void)
+{
+	for(size_t i=0; i<host_geo_context.plugin_list.size(); i++)
+	{	host_unload_library(host_geo_context.plugin_list[i]->library);
+		delete host_geo_context.plugin_list[i];
+	}
+	host_geo_context.plugin_list.clear();
+	host_geo_context.geometry.clear(GP_GEOMETRY_TYPE_RENDER);
+}
@@ -0,0 +1,743 @@
+/*
+	===============================================================
+
+	SHADERMAP HEADLESS HOST - GEOMETRY IMPORT BENCHMARK
+
+	A command line host that loads a geometry importer plugin
+	built as a Linux shared object and imports files with it as
+	RENDER geometry (Material Visualizer) and NODE geometry
+	(Project Grid). For each import the host reports:
+
+	time			Wall time of "on_process()".
+	host			Time spent in the host copying the geometry
+					passed to the create functions. Excluded from
+					the triangle rate.
+	Mtri/s			Million triangles per second of importer time.
+	MB/s			File size divided by importer time.
+	allocs			Heap allocations (malloc, calloc, realloc and
+					everything built on them such as new) made
+					during the import, counted by the host.
+	alloc MB		Bytes requested by those allocations.
+	peak MB			Peak resident memory above the resident memory
+					before the import.
+
+	The host can also generate a corpus of CUSTOM meshes (see
+	"geometry/examples/geo_custom") from 10K to 50M triangles to
+	measure how importers scale. The meshes are noisy height
+	fields written a row at a time so that even the largest
+	sizes do not have to fit in memory.
+
+	--
+
+	BUILD (from the SDK root folder)
+
+	Plugin:
+	g++ -std=c++11 -O2 -shared -fPIC -fvisibility=hidden -I host/compat geometry/examples/geo_custom/geo_custom.cpp -o geo_custom.so
+
+	Host:
+	g++ -std=c++11 -O2 -I host/compat host/host_geo_bench.cpp -o host_geo_bench -ldl -lz -pthread
+
+	--
+
+	USAGE
+
+	host_geo_bench PLUGIN.so [options]
+	host_geo_bench --generate DIR [--sizes LIST]
+	host_geo_bench --check
+
+	--file FILE				Add a file to import.
+	--corpus DIR			Add every file in DIR with an extension the
+							plugin supports, smallest first.
+	--mode MODE				render, node or both. Default both.
+	--warmup N				Untimed imports of each file before measuring.
+							Default 0 - the first import includes the cold
+							file cache.
+	--iterations N			Timed imports of each file and mode. Default 3.
+	--palette				Report the "material color from file" option
+							as off.
+	--no-validate			Skip checking the imported geometry.
+	--cancel-after N		Report cancel after N calls to
+							gp_is_cancel_process() in each import.
+	--output FILE.custom	Save the NODE geometry of the last file.
+	--output-v2 FILE.custom	Save the NODE geometry of the last file as
+							CUSTOM version 2 with subsets, material ids,
+							all uv channels and, unless --palette, face
+							colors.
+	--csv FILE				Append one line per timed import.
+	--list					Print plugin info then exit.
+	--verbose				Print extra messages.
+
+	--generate DIR			Write mesh_<SIZE>.custom files to DIR.
+	--sizes LIST			Comma separated triangle counts with an
+							optional k or m suffix. Default is
+							10k,100k,1m,10m,50m. The 50M mesh is about
+							2 GB.
+
+	--check					Weld known meshes with "geo_node_weld.cpp"
+							and check the vertex, uv and face results,
+							then exit.
+
+	Example:
+	./host_geo_bench --generate corpus --sizes 10k,100k,1m,10m
+	./host_geo_bench geo_custom.so --corpus corpus --csv geo.csv
+
+	Exit code is 0 if every import succeeded and was valid, 1
+	otherwise. With --check it is 0 if every check passed, 1
+	otherwise.
+
+
+	SHADERMAP SDK LICENSE
+
+	The ShaderMap SDK is released under The MIT License (MIT)
+	http://opensource.org/licenses/MIT
+
+	Copyright (c) 2007-2019 Rendering Systems Inc.
+
+	See "host_common.cpp" for the full license text.
+
+	===============================================================
+*/
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Host includes
+
+#define SMSDK_HOST
+#include "../geometry/geo_plugin_core.cpp"
+#include "../geometry/geo_custom_v2.cpp"
+#include "../geometry/geo_node_weld.cpp"
+#include "host_common.cpp"
+#include "host_geo_api.cpp"
+#include <dirent.h>
+#include <math.h>
+#include <sys/stat.h>
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Allocation counting
+
+// The host replaces malloc, calloc, realloc and free with versions that count calls then forward to the glibc allocator.
+// Plugins resolve these symbols to the host so their allocations, including operator new, are counted too.
+extern "C" void*								__libc_malloc(size_t size);
+extern "C" void*								__libc_calloc(size_t count, size_t size);
+extern "C" void*								__libc_realloc(void* pointer, size_t size);
+extern "C" void									__libc_free(void* pointer);
+
+std::atomic<unsigned long long>					host_geo_alloc_count(0);
+std::atomic<unsigned long long>					host_geo_alloc_byte_count(0);
+
+extern "C" void* malloc(size_t size)
+{
+	host_geo_alloc_count.fetch_add(1, std::memory_order_relaxed);
+	host_geo_alloc_byte_count.fetch_add(size, std::memory_order_relaxed);
+	return __libc_malloc(size);
+}
+
+extern "C" void* calloc(size_t count, size_t size)
+{
+	host_geo_alloc_count.fetch_add(1, std::memory_order_relaxed);
+	host_geo_alloc_byte_count.fetch_add(count * size, std::memory_order_relaxed);
+	return __libc_calloc(count, size);
+}
+
+extern "C" void* realloc(void* pointer, size_t size)
+{
+	host_geo_alloc_count.fetch_add(1, std::memory_order_relaxed);
+	host_geo_alloc_byte_count.fetch_add(size, std::memory_order_relaxed);
+	return __libc_realloc(pointer, size);
+}
+
+extern "C" void free(void* pointer)
+{
+	__libc_free(pointer);
+}
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Mesh corpus
+
+// Height of the corpus surface at x, y in 0...1 with its gradient. A few octaves of sines give every vertex a
+// different normal like a scanned surface.
+float host_geo_corpus_height(float x, float y, float& dx_out, float& dy_out)
+{
+	// Local data
+	static const float							frequency_array[4]	= { 3.0f, 11.0f, 37.0f, 131.0f };
+	static const float							amplitude_array[4]	= { 0.08f, 0.02f, 0.006f, 0.0015f };
+	float										height;
+
+
+	height = 0.0f;
+	dx_out = dy_out = 0.0f;
+	for(unsigned int i=0; i<4; i++)
+	{	float f = frequency_array[i] * 6.2831853f, a = amplitude_array[i];
+		float sx = sinf(f * x + i), cx = cosf(f * x + i);
+		float sy = sinf(f * y + i * 2.0f), cy = cosf(f * y + i * 2.0f);
+		height	+= a * sx * sy;
+		dx_out	+= a * f * cx * sy;
+		dy_out	+= a * f * sx * cy;
+	}
+	return height;
+}
+
+// Write a CUSTOM mesh with about triangle_count triangles. Returns FALSE and logs an error on failure.
+BOOL host_geo_generate_custom(const char* file_path, unsigned long long triangle_count)
+{
+	// Local data
+	FILE*										fp;
+	unsigned int								grid_size, row_vertex_count, count_array[3];
+	std::vector<float>							row_list;
+	std::vector<unsigned int>					index_row_list;
+	BOOL										is_success;
+
+
+	// A grid of grid_size x grid_size quads has 2 * grid_size^2 triangles.
+	grid_size			= std::max(1u, (unsigned int)ceil(sqrt((double)triangle_count / 2.0)));
+	row_vertex_count	= grid_size + 1;
+	if((unsigned long long)grid_size * grid_size * 2 * 7 > 0xFFFFFFFFull)
+	{	host_log("error: %llu triangles is more than the CUSTOM format can index.", triangle_count);
+		return FALSE;
+	}
+	count_array[0] = row_vertex_count * row_vertex_count;
+	count_array[1] = count_array[0];
+	count_array[2] = grid_size * grid_size * 2 * 7;
+
+	fp = fopen(file_path, "wb");
+	if(!fp)
+	{	host_log("error: failed to create \"%s\".", file_path);
+		return FALSE;
+	}
+	is_success = fwrite(count_array, sizeof(unsigned int), 3, fp) == 3;
+
+	// Vertices - position XYZ, normal XYZ.
+	row_list.resize((size_t)row_vertex_count * 6);
+	for(unsigned int y=0; y<row_vertex_count && is_success; y++)
+	{	for(unsigned int x=0; x<row_vertex_count; x++)
+		{	float	u = (float)x / grid_size, v = (float)y / grid_size, dx, dy;
+			float	height	= host_geo_corpus_height(u, v, dx, dy);
+			float	length	= sqrtf(dx * dx + dy * dy + 1.0f);
+			float*	vertex	= &row_list[(size_t)x * 6];
+			vertex[0] = u - 0.5f; vertex[1] = height; vertex[2] = v - 0.5f;
+			vertex[3] = -dx / length; vertex[4] = 1.0f / length; vertex[5] = -dy / length;
+		}
+		is_success = fwrite(row_list.data(), sizeof(float), row_list.size(), fp) == row_list.size();
+	}
+
+	// UVs - one per vertex.
+	row_list.resize((size_t)row_vertex_count * 2);
+	for(unsigned int y=0; y<row_vertex_count && is_success; y++)
+	{	for(unsigned int x=0; x<row_vertex_count; x++)
+		{	row_list[(size_t)x * 2]		= (float)x / grid_size;
+			row_list[(size_t)x * 2 + 1]	= 1.0f - (float)y / grid_size;
+		}
+		is_success = fwrite(row_list.data(), sizeof(float), row_list.size(), fp) == row_list.size();
+	}
+
+	// Indices - 7 per triangle, vertex and uv indices are the same.
+	index_row_list.resize((size_t)grid_size * 14);
+	for(unsigned int y=0; y<grid_size && is_success; y++)
+	{	for(unsigned int x=0; x<grid_size; x++)
+		{	unsigned int	i00		= y * row_vertex_count + x, i10 = i00 + 1, i01 = i00 + row_vertex_count, i11 = i01 + 1;
+			unsigned int	start	= (y * grid_size + x) * 6;
+			unsigned int*	index	= &index_row_list[(size_t)x * 14];
+			index[0] = i00; index[1] = i01; index[2] = i10; index[3] = i00; index[4] = i01; index[5] = i10; index[6] = start;
+			index[7] = i10; index[8] = i01; index[9] = i11; index[10] = i10; index[11] = i01; index[12] = i11; index[13] = start + 3;
+		}
+		is_success = fwrite(index_row_list.data(), sizeof(unsigned int), index_row_list.size(), fp) == index_row_list.size();
+	}
+
+	if(fclose(fp) != 0 || !is_success)
+	{	host_log("error: failed to write \"%s\".", file_path);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+// Parse a triangle count such as "250k" or "10m". Returns 0 if invalid.
+unsigned long long host_geo_parse_size(const std::string& size_string)
+{
+	// Local data
+	char*										end;
+	double										value;
+
+
+	value = strtod(size_string.c_str(), &end);
+	if(*end == 'k' || *end == 'K')		{ value *= 1.0e3; end++; }
+	else if(*end == 'm' || *end == 'M')	{ value *= 1.0e6; end++; }
+	return (*end || value < 1.0) ? 0 : (unsigned long long)value;
+}
+
+// Generate the corpus. Returns FALSE on failure.
+BOOL host_geo_generate_corpus(const std::string& directory, const std::string& size_list_string)
+{
+	mkdir(directory.c_str(), 0755);
+	for(size_t start=0; start<=size_list_string.size(); )
+	{
+		size_t				end				= std::min(size_list_string.find(',', start), size_list_string.size());
+		std::string			size_string		= size_list_string.substr(start, end - start);
+		unsigned long long	triangle_count	= host_geo_parse_size(size_string);
+		std::string			file_path		= directory + "/mesh_" + size_string + ".custom";
+		double				time_start		= host_get_time();
+
+		start = end + 1;
+		if(!triangle_count)
+		{	host_log("error: invalid size \"%s\".", size_string.c_str());
+			return FALSE;
+		}
+		if(!host_geo_generate_custom(file_path.c_str(), triangle_count))
+		{	return FALSE;
+		}
+		printf("generated   %s  %.1f s\n", file_path.c_str(), host_get_time() - time_start);
+	}
+	return TRUE;
+}
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Benchmark
+
+// Command line options.
+struct host_geo_bench_options_s
+{
+	std::string									plugin_path;
+	std::vector<std::string>					file_list;
+	std::string									corpus_directory;
+	std::string									generate_directory;
+	std::string									size_list;
+	std::string									output_path;
+	std::string									output_v2_path;
+	std::string									csv_path;
+	BOOL										is_render;
+	BOOL										is_node;
+	BOOL										is_palette;
+	BOOL										is_validate;
+	BOOL										is_list;
+	BOOL										is_check;
+	unsigned int								warmup_count;
+	unsigned int								iteration_count;
+	unsigned long long							cancel_after_poll_count;
+
+	// c()
+	host_geo_bench_options_s(void)
+	{	size_list				= "10k,100k,1m,10m,50m";
+		is_render				= TRUE;
+		is_node					= TRUE;
+		is_palette				= FALSE;
+		is_validate				= TRUE;
+		is_list					= FALSE;
+		is_check				= FALSE;
+		warmup_count			= 0;
+		iteration_count			= 3;
+		cancel_after_poll_count	= 0;
+	}
+};
+
+// Print usage.
+void host_geo_bench_usage(void)
+{
+	fprintf(stderr,
+		"usage: host_geo_bench PLUGIN.so [--file FILE]... [--corpus DIR] [--mode render|node|both] [--warmup N]\n"
+		"                      [--iterations N] [--palette] [--no-validate] [--cancel-after N] [--output FILE.custom]\n"
+		"                      [--csv FILE] [--output-v2 FILE.custom] [--list] [--verbose]\n"
+		"       host_geo_bench --generate DIR [--sizes 10k,100k,1m,10m,50m]\n"
+		"       host_geo_bench --check\n");
+}
+
+// Parse the command line. Returns FALSE on invalid arguments.
+BOOL host_geo_bench_parse(int argc, char** argv, host_geo_bench_options_s& options_out)
+{
+	for(int i=1; i<argc; i++)
+	{
+		std::string argument = argv[i];
+		BOOL		is_value = (i + 1 < argc);
+
+		if(argument == "--file" && is_value)				{ options_out.file_list.push_back(argv[++i]); }
+		else if(argument == "--corpus" && is_value)			{ options_out.corpus_directory = argv[++i]; }
+		else if(argument == "--generate" && is_value)		{ options_out.generate_directory = argv[++i]; }
+		else if(argument == "--sizes" && is_value)			{ options_out.size_list = argv[++i]; }
+		else if(argument == "--warmup" && is_value)			{ options_out.warmup_count = (unsigned int)std::max(0, atoi(argv[++i])); }
+		else if(argument == "--iterations" && is_value)		{ options_out.iteration_count = (unsigned int)std::max(1, atoi(argv[++i])); }
+		else if(argument == "--output" && is_value)			{ options_out.output_path = argv[++i]; }
+		else if(argument == "--output-v2" && is_value)		{ options_out.output_v2_path = argv[++i]; }
+		else if(argument == "--csv" && is_value)			{ options_out.csv_path = argv[++i]; }
+		else if(argument == "--cancel-after" && is_value)	{ options_out.cancel_after_poll_count = strtoull(argv[++i], 0, 10); }
+		else if(argument == "--palette")					{ options_out.is_palette = TRUE; }
+		else if(argument == "--no-validate")				{ options_out.is_validate = FALSE; }
+		else if(argument == "--list")						{ options_out.is_list = TRUE; }
+		else if(argument == "--verbose")					{ host_is_verbose = TRUE; }
+		else if(argument == "--check")						{ options_out.is_check = TRUE; }
+		else if(argument == "--mode" && is_value)
+		{	std::string mode = argv[++i];
+			options_out.is_render	= (mode == "render" || mode == "both");
+			options_out.is_node		= (mode == "node" || mode == "both");
+			if(!options_out.is_render && !options_out.is_node)
+			{	host_log("error: invalid mode \"%s\".", mode.c_str());
+				return FALSE;
+			}
+		}
+		else if(argument[0] != '-' && options_out.plugin_path.empty())
+		{	options_out.plugin_path = argument;
+		}
+		else
+		{	host_log("error: unknown or incomplete argument \"%s\".", argument.c_str());
+			return FALSE;
+		}
+	}
+	return !options_out.plugin_path.empty() || !options_out.generate_directory.empty() || options_out.is_check;
+}
+
+// Return the size of a file in bytes or 0.
+unsigned long long host_geo_bench_get_file_size(const std::string& file_path)
+{
+	struct stat file_stat;
+	return stat(file_path.c_str(), &file_stat) == 0 ? (unsigned long long)file_stat.st_size : 0;
+}
+
+// Add the files of a directory that the plugin can import, smallest first. Returns FALSE if the directory can't be read.
+BOOL host_geo_bench_add_corpus(const std::string& directory, const host_geo_plugin_s* plugin, std::vector<std::string>& file_list_out)
+{
+	// Local data
+	DIR*										dir;
+	struct dirent*								entry;
+	std::vector<std::pair<unsigned long long, std::string> >	corpus_list;
+
+
+	dir = opendir(directory.c_str());
+	if(!dir)
+	{	host_log("error: failed to open directory \"%s\".", directory.c_str());
+		return FALSE;
+	}
+	while((entry = readdir(dir)) != 0)
+	{	std::string file_path	= directory + "/" + entry->d_name;
+		std::string extension	= host_get_extension(file_path);
+		for(size_t i=0; i<plugin->extension_list.size(); i++)
+		{	if(!extension.empty() && extension == host_get_extension("." + host_narrow(plugin->extension_list[i].c_str())))
+			{	corpus_list.push_back(std::make_pair(host_geo_bench_get_file_size(file_path), file_path));
+				break;
+			}
+		}
+	}
+	closedir(dir);
+
+	std::sort(corpus_list.begin(), corpus_list.end());
+	for(size_t i=0; i<corpus_list.size(); i++)
+	{	file_list_out.push_back(corpus_list[i].second);
+	}
+	if(corpus_list.empty())
+	{	host_log("warning: no importable files in \"%s\".", directory.c_str());
+	}
+	return TRUE;
+}
+
+// Entry point.
+// A mesh welded by host_geo_bench_check().
+struct host_geo_check_mesh_s
+{
+	std::vector<gp_node_vertex_s>				vertex_list;
+	std::vector<gp_node_face_s>					face_list;
+	std::vector<gp_node_uv_s>					uv_list;
+	std::vector<unsigned int>					uv_index_list;
+};
+
+// Build a 2 x 2 grid of unit quads in the xy plane with its own 4 vertices and uvs for each quad, 16 in all, and 2
+// faces for each quad. Quad q = y * 2 + x is moved by quad_offset[q] on x, the quads at x = 1 get right_normal. The
+// uvs are the unmoved positions divided by 2.
+void host_geo_check_build_grid(const float* quad_offset, const float* right_normal, host_geo_check_mesh_s& mesh_out)
+{
+	static const unsigned int					corner[4][2] = { { 0, 0 }, { 1, 0 }, { 1, 1 }, { 0, 1 } };
+
+
+	for(unsigned int q=0; q<4; q++)
+	{
+		unsigned int	qx		= q % 2, qy = q / 2;
+		unsigned int	start	= (unsigned int)mesh_out.vertex_list.size();
+		const float*	normal	= qx ? right_normal : 0;
+
+		for(unsigned int c=0; c<4; c++)
+		{	float x = (float)(qx + corner[c][0]), y = (float)(qy + corner[c][1]);
+			mesh_out.vertex_list.push_back(gp_node_vertex_s(x + quad_offset[q], y, 0.0f, normal ? normal[0] : 0.0f, normal ? normal[1] : 0.0f, normal ? normal[2] : 1.0f));
+			mesh_out.uv_list.push_back(gp_node_uv_s(x * 0.5f, y * 0.5f));
+		}
+		mesh_out.face_list.push_back(gp_node_face_s(start, start + 1, start + 2, 0, 0));
+		mesh_out.face_list.push_back(gp_node_face_s(start, start + 2, start + 3, 0, 0));
+		for(size_t f=mesh_out.face_list.size()-2; f<mesh_out.face_list.size(); f++)
+		{	mesh_out.uv_index_list.push_back(mesh_out.face_list[f].a);
+			mesh_out.uv_index_list.push_back(mesh_out.face_list[f].b);
+			mesh_out.uv_index_list.push_back(mesh_out.face_list[f].c);
+		}
+	}
+}
+
+// Weld a grid of host_geo_check_build_grid() and check the counts, and that every face corner still has the position,
+// normal and uv it had before the weld. Returns FALSE if a check failed.
+BOOL host_geo_check_weld_grid(const char* name, const float* quad_offset, const float* right_normal, float position_epsilon,
+							  unsigned int expected_vertex_count)
+{
+	// Local data
+	host_geo_check_mesh_s						mesh, source;
+	gp_node_uv_data_s							uv_data;
+	gp_node_uv_s*								uv_array;
+	unsigned int*								uv_index_array;
+	unsigned int								vertex_count, uv_count;
+	BOOL										is_valid;
+
+
+	host_geo_check_build_grid(quad_offset, right_normal, mesh);
+	source			= mesh;
+
+	uv_array					= mesh.uv_list.data();
+	uv_index_array				= mesh.uv_index_list.data();
+	uv_count					= (unsigned int)mesh.uv_list.size();
+	uv_data.uv_channel_count	= 1;
+	uv_data.uv_channels_array	= &uv_array;
+	uv_data.uv_count_array		= &uv_count;
+	uv_data.uv_indices_array	= &uv_index_array;
+	vertex_count				= (unsigned int)mesh.vertex_list.size();
+
+	if(!geo_weld_node_vertices(mesh.vertex_list.data(), vertex_count, mesh.face_list.data(), (unsigned int)mesh.face_list.size(), position_epsilon, 1.0e-3f) ||
+	   !geo_weld_node_uvs(uv_data, (unsigned int)mesh.face_list.size(), 0.0f))
+	{	host_log("error: weld check \"%s\" failed to weld.", name);
+		return FALSE;
+	}
+
+	is_valid = TRUE;
+	if(vertex_count != expected_vertex_count || uv_count != 9)
+	{	host_log("error: weld check \"%s\" has %u vertices and %u uvs, expected %u and 9.", name, vertex_count, uv_count, expected_vertex_count);
+		is_valid = FALSE;
+	}
+	for(size_t f=0; f<mesh.face_list.size() && is_valid; f++)
+	{	const unsigned int* index			= &mesh.face_list[f].a;
+		const unsigned int* source_index	= &source.face_list[f].a;
+		for(unsigned int c=0; c<3; c++)
+		{	if(index[c] >= vertex_count || mesh.uv_index_list[f * 3 + c] >= uv_count)
+			{	is_valid = FALSE;
+				break;
+			}
+			const gp_node_vertex_s&	vertex			= mesh.vertex_list[index[c]];
+			const gp_node_vertex_s&	source_vertex	= source.vertex_list[source_index[c]];
+			const gp_node_uv_s&		uv				= mesh.uv_list[mesh.uv_index_list[f * 3 + c]];
+			const gp_node_uv_s&		source_uv		= source.uv_list[source.uv_index_list[f * 3 + c]];
+			if(!geo_weld_is_match(vertex, source_vertex, position_epsilon, 1.0e-3f) || uv.u != source_uv.u || uv.v != source_uv.v)
+			{	is_valid = FALSE;
+				break;
+			}
+		}
+		if(!is_valid)
+		{	host_log("error: weld check \"%s\" face %u does not match its corners before the weld.", name, (unsigned int)f);
+		}
+	}
+
+	printf("check weld  %-16s %2u vertices  %2u uvs  %s\n", name, vertex_count, uv_count, is_valid ? "ok" : "fail");
+	return is_valid;
+}
+
+// Check "geo_node_weld.cpp". Returns the number of failed checks.
+unsigned int host_geo_bench_check(void)
+{
+	// Local data
+	static const float							no_offset[4]		= { 0.0f, 0.0f, 0.0f, 0.0f };
+	static const float							near_offset[4]		= { 0.0f, 4.0e-5f, -4.0e-5f, 4.0e-5f };
+	static const float							far_offset[4]		= { 0.0f, 2.0e-4f, 4.0e-4f, 6.0e-4f };
+	static const float							up_normal[3]		= { 0.0f, 0.0f, 1.0f };
+	static const float							tilted_normal[3]	= { 0.0f, 0.6f, 0.8f };
+	unsigned int								fail_count;
+
+
+	// The 16 split vertices weld to the 9 of the grid unless they are moved too far apart or their normals differ, the
+	// 3 vertices on x = 1 are then split in two.
+	fail_count = 0;
+	fail_count += host_geo_check_weld_grid("equal", no_offset, up_normal, 0.0f, 9) ? 0 : 1;
+	fail_count += host_geo_check_weld_grid("within epsilon", near_offset, up_normal, 1.0e-4f, 9) ? 0 : 1;
+	fail_count += host_geo_check_weld_grid("beyond epsilon", far_offset, up_normal, 1.0e-4f, 16) ? 0 : 1;
+	fail_count += host_geo_check_weld_grid("normal seam", no_offset, tilted_normal, 1.0e-4f, 12) ? 0 : 1;
+	parallel_shutdown();
+	return fail_count;
+}
+
+int main(int argc, char** argv)
+{
+	// Local data
+	host_geo_bench_options_s					options;
+	host_geo_plugin_s*							plugin;
+	std::vector<unsigned int>					mode_list;
+	FILE*										csv_fp;
+	unsigned int								fail_count;
+	BOOL										is_success, is_rss_reset;
+	double										time_start, time_ms, host_ms;
+
+
+	setlocale(LC_ALL, "");
+	if(!host_geo_bench_parse(argc, argv, options))
+	{	host_geo_bench_usage();
+		return 1;
+	}
+
+	if(!options.generate_directory.empty())
+	{	return host_geo_generate_corpus(options.generate_directory, options.size_list) ? 0 : 1;
+	}
+	if(options.is_check)
+	{	return host_geo_bench_check() ? 1 : 0;
+	}
+
+	host_geo_context.option_material_color_from_file	= !options.is_palette;
+	host_geo_context.cancel_after_poll_count			= options.cancel_after_poll_count;
+
+	plugin = host_geo_load_plugin(options.plugin_path.c_str());
+	if(!plugin)
+	{	return 1;
+	}
+	printf("plugin      %s\n", plugin->library.file_path.c_str());
+	printf("name        %s (SDK %u.%u)\n", host_narrow(plugin->name.c_str()).c_str(), plugin->library.sdk_version_major, plugin->library.sdk_version_minor);
+	for(size_t i=0; i<plugin->extension_list.size(); i++)
+	{	printf("  extension %s\n", host_narrow(plugin->extension_list[i].c_str()).c_str());
+	}
+	if(options.is_list)
+	{	host_geo_shutdown();
+		return 0;
+	}
+
+	if(!options.corpus_directory.empty() && !host_geo_bench_add_corpus(options.corpus_directory, plugin, options.file_list))
+	{	host_geo_shutdown();
+		return 1;
+	}
+	if(options.file_list.empty())
+	{	host_log("error: no files to import, use --file or --corpus.");
+		host_geo_shutdown();
+		return 1;
+	}
+
+	if(options.is_render)
+	{	mode_list.push_back(GP_GEOMETRY_TYPE_RENDER);
+	}
+	if(options.is_node)
+	{	mode_list.push_back(GP_GEOMETRY_TYPE_NODE);
+	}
+
+	csv_fp = 0;
+	if(!options.csv_path.empty())
+	{	csv_fp = fopen(options.csv_path.c_str(), "a");
+		if(!csv_fp)
+		{	host_log("error: failed to open \"%s\".", options.csv_path.c_str());
+		}
+		else if(ftell(csv_fp) == 0)
+		{	fprintf(csv_fp, "plugin,file,mode,iteration,result,file_bytes,vertices,triangles,subsets,time_ms,host_ms,mtri_per_s,mb_per_s,allocs,alloc_bytes,peak_rss_delta_mb,geometry_mb\n");
+		}
+	}
+
+	printf("\nfile                             mode     triangles   vertices   median ms    host ms   Mtri/s     MB/s     allocs  alloc MB   peak MB\n");
+
+	// Import every file in every mode.
+	fail_count		= 0;
+	is_rss_reset	= TRUE;
+	for(size_t f=0; f<options.file_list.size(); f++)
+	{
+		const std::string&	file_path = options.file_list[f];
+		unsigned long long	file_size = host_geo_bench_get_file_size(file_path);
+
+		for(size_t m=0; m<mode_list.size(); m++)
+		{
+			host_sample_list_s	time_list, host_list, alloc_list, alloc_byte_list, rss_list;
+			unsigned int		mode = mode_list[m];
+			const char*			mode_name = (mode == GP_GEOMETRY_TYPE_RENDER) ? "render" : "node";
+			BOOL				is_mode_success = TRUE;
+
+			for(unsigned int i=0; i<options.warmup_count + options.iteration_count; i++)
+			{
+				BOOL is_warmup = (i < options.warmup_count);
+
+				// Release the previous geometry first so that it is not part of the peak.
+				host_geo_context.geometry.clear(mode);
+				is_rss_reset = host_reset_peak_rss() && is_rss_reset;
+				unsigned long long base_rss		= host_get_current_rss();
+				unsigned long long alloc_start	= host_geo_alloc_count;
+				unsigned long long byte_start	= host_geo_alloc_byte_count;
+
+				time_start	= host_get_time();
+				is_success	= host_geo_import(plugin, 0, file_path.c_str(), mode);
+				time_ms		= (host_get_time() - time_start) * 1000.0;
+				host_ms		= host_geo_context.create_time * 1000.0;
+
+				unsigned long long alloc_count	= host_geo_alloc_count - alloc_start;
+				unsigned long long alloc_bytes	= host_geo_alloc_byte_count - byte_start;
+				unsigned long long peak_rss		= host_get_peak_rss();
+				const host_geometry_s& geometry	= host_geo_context.geometry;
+
+				if(is_success && options.is_validate && i == 0 && host_geo_validate(geometry))
+				{	host_log("error: \"%s\" %s geometry is invalid.", file_path.c_str(), mode_name);
+					is_success = FALSE;
+				}
+				if(!is_success)
+				{	is_mode_success = FALSE;
+					fail_count++;
+					break;
+				}
+				if(is_warmup)
+				{	continue;
+				}
+
+				double import_s = std::max(1.0e-9, (time_ms - host_ms) / 1000.0);
+				time_list.add(time_ms);
+				host_list.add(host_ms);
+				alloc_list.add((double)alloc_count);
+				alloc_byte_list.add((double)alloc_bytes);
+				rss_list.add(peak_rss > base_rss ? (peak_rss - base_rss) / 1048576.0 : 0.0);
+
+				if(host_is_verbose)
+				{	printf("  run %u  %.2f ms  host %.2f ms  %llu allocs  peak %.1f MB  progress %u  polls %llu  chunks %u\n", i - options.warmup_count, time_ms, host_ms,
+						   alloc_count, rss_list.sample_list.back(), host_geo_context.progress_call_count, host_geo_context.cancel_poll_count, geometry.append_call_count);
+				}
+				if(csv_fp)
+				{	fprintf(csv_fp, "%s,%s,%s,%u,1,%llu,%u,%u,%u,%.3f,%.3f,%.3f,%.2f,%llu,%llu,%.1f,%.1f\n", host_get_file_name(options.plugin_path).c_str(),
+							host_get_file_name(file_path).c_str(), mode_name, i - options.warmup_count, file_size, geometry.get_vertex_count(),
+							geometry.get_triangle_count(), geometry.subset_count, time_ms, host_ms, geometry.get_triangle_count() / 1.0e6 / import_s,
+							file_size / 1048576.0 / import_s, alloc_count, alloc_bytes, rss_list.sample_list.back(), geometry.get_byte_size() / 1048576.0);
+				}
+			}
+
+			if(!is_mode_success)
+			{	printf("%-32s %-6s   %s\n", host_get_file_name(file_path).c_str(), mode_name, host_geo_context.is_cancel ? "canceled" : "failed");
+				if(csv_fp)
+				{	fprintf(csv_fp, "%s,%s,%s,0,0,%llu,0,0,0,0,0,0,0,0,0,0,0\n", host_get_file_name(options.plugin_path).c_str(),
+							host_get_file_name(file_path).c_str(), mode_name, file_size);
+				}
+				continue;
+			}
+
+			const host_geometry_s&	geometry	= host_geo_context.geometry;
+			double					import_s	= std::max(1.0e-9, (time_list.median() - host_list.median()) / 1000.0);
+			printf("%-32s %-6s %11u %10u  %10.2f %10.2f %8.2f %8.1f %10.0f %9.1f %9.1f%s\n", host_get_file_name(file_path).c_str(), mode_name,
+				   geometry.get_triangle_count(), geometry.get_vertex_count(), time_list.median(), host_list.median(),
+				   geometry.get_triangle_count() / 1.0e6 / import_s, file_size / 1048576.0 / import_s,
+				   alloc_list.median(), alloc_byte_list.median() / 1048576.0, rss_list.max(), is_rss_reset ? "" : "*");
+		}
+	}
+
+	if(!is_rss_reset)
+	{	printf("* peak could not be reset - lifetime peak shown\n");
+	}
+	if(csv_fp)
+	{	fclose(csv_fp);
+	}
+
+	// Save the NODE geometry of the last file.
+	if(!options.output_path.empty() || !options.output_v2_path.empty())
+	{	if(host_geo_context.geometry.geometry_type != GP_GEOMETRY_TYPE_NODE &&
+		   !host_geo_import(plugin, 0, options.file_list.back().c_str(), GP_GEOMETRY_TYPE_NODE))
+		{	fail_count++;
+		}
+		else
+		{	if(!options.output_path.empty() && !host_geo_save_custom(options.output_path.c_str(), host_geo_context.geometry))
+			{	fail_count++;
+			}
+			if(!options.output_v2_path.empty() && !host_geo_save_custom_v2(options.output_v2_path.c_str(), host_geo_context.geometry))
+			{	fail_count++;
+			}
+		}
+	}
+
+	host_geo_shutdown();
+	return fail_count ? 1 : 0;
+}
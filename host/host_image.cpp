@@ -0,0 +1,873 @@
+/*
+	===============================================================
+
+	SHADERMAP HEADLESS HOST - IMAGE SOURCE FILE
+
+	Loads and saves the images used as map inputs, source maps,
+	masks and outputs by the headless hosts. Pixels are stored the
+	way ShaderMap passes them to plugins: 16 bit half floats with
+	2 (grayscale) or 4 (color) channels per pixel, origin UPPER
+	LEFT.
+
+	Supported files:
+
+	PNG		- All color types, 1 to 16 bits, interlaced or not.
+	EXR		- Single part scanline files with NONE, RLE, ZIPS or
+			  ZIP compression and HALF, FLOAT or UINT channels.
+			  Saved files use NONE compression and HALF channels.
+
+	An image can also be generated with "synthetic:WIDTHxHEIGHT"
+	(color) or "synthetic_gray:WIDTHxHEIGHT" (grayscale) in place
+	of a file path. Synthetic images are useful for benchmarks at
+	exact sizes, for example "synthetic:8192x8192".
+
+	Requires zlib. Link with -lz.
+
+	Include after "host_common.cpp".
+
+
+	SHADERMAP SDK LICENSE
+
+	The ShaderMap SDK is released under The MIT License (MIT)
+	http://opensource.org/licenses/MIT
+
+	Copyright (c) 2007-2019 Rendering Systems Inc.
+
+	See "host_common.cpp" for the full license text.
+
+	===============================================================
+*/
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// General includes
+
+#include <zlib.h>
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Image structs
+
+// An image in ShaderMap pixel format.
+struct host_image_s
+{
+	unsigned int								width;
+	unsigned int								height;
+	BOOL										is_grayscale;			// If TRUE then 2 half floats per pixel (Color, Alpha) else 4 (Red, Green, Blue, Alpha).
+	BOOL										is_sRGB;				// Pixels are in sRGB color space else in linear color space.
+	BOOL										is_rasterized;			// All color channels are in the range 0.0f - 1.0f.
+	std::vector<unsigned short>					pixel_list;				// Half floats as raw bits.
+
+	// c()
+	host_image_s(void)
+	{	width = height = 0;
+		is_grayscale = FALSE; is_sRGB = FALSE; is_rasterized = TRUE;
+	}
+
+	// Return the number of half floats per pixel.
+	unsigned int get_channel_count(void) const
+	{	return is_grayscale ? 2 : 4;
+	}
+
+	// Return the size of the pixel data in bytes.
+	unsigned long long get_byte_size(void) const
+	{	return (unsigned long long)pixel_list.size() * sizeof(unsigned short);
+	}
+
+	// Allocate pixels. Returns FALSE on allocation failure.
+	BOOL allocate(unsigned int new_width, unsigned int new_height, BOOL new_is_grayscale)
+	{	width			= new_width;
+		height			= new_height;
+		is_grayscale	= new_is_grayscale;
+		try
+		{	pixel_list.assign((size_t)width * height * get_channel_count(), 0);
+		}
+		catch(const std::bad_alloc&)
+		{	width = height = 0;
+			return FALSE;
+		}
+		return TRUE;
+	}
+};
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// File helpers
+
+// Read an entire file into a byte list.
+BOOL host_read_file(const char* file_path, std::vector<unsigned char>& data_out)
+{
+	// Local data
+	FILE*										fp;
+	long										file_size;
+
+
+	fp = fopen(file_path, "rb");
+	if(!fp)
+	{	host_log("error: failed to open \"%s\".", file_path);
+		return FALSE;
+	}
+	fseek(fp, 0, SEEK_END);
+	file_size = ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+	if(file_size < 0)
+	{	fclose(fp);
+		return FALSE;
+	}
+	data_out.resize((size_t)file_size);
+	if(file_size && fread(data_out.data(), 1, (size_t)file_size, fp) != (size_t)file_size)
+	{	host_log("error: failed to read \"%s\".", file_path);
+		fclose(fp);
+		return FALSE;
+	}
+	fclose(fp);
+	return TRUE;
+}
+
+// Read big endian and little endian integers.
+inline unsigned int host_read_be32(const unsigned char* p)
+{	return ((unsigned int)p[0] << 24) | ((unsigned int)p[1] << 16) | ((unsigned int)p[2] << 8) | (unsigned int)p[3];
+}
+
+inline unsigned int host_read_le32(const unsigned char* p)
+{	return (unsigned int)p[0] | ((unsigned int)p[1] << 8) | ((unsigned int)p[2] << 16) | ((unsigned int)p[3] << 24);
+}
+
+inline unsigned long long host_read_le64(const unsigned char* p)
+{	return (unsigned long long)host_read_le32(p) | ((unsigned long long)host_read_le32(p + 4) << 32);
+}
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// PNG
+
+// Paeth predictor used by PNG filter type 4.
+inline unsigned char host_png_paeth(int a, int b, int c)
+{
+	int p = a + b - c, pa = abs(p - a), pb = abs(p - b), pc = abs(p - c);
+	if(pa <= pb && pa <= pc)
+	{	return (unsigned char)a;
+	}
+	return (unsigned char)(pb <= pc ? b : c);
+}
+
+// Reverse the PNG row filters of a (sub) image in place. Returns FALSE if the data is too short or a filter type is invalid.
+BOOL host_png_unfilter(unsigned char* data, size_t data_size, unsigned int width, unsigned int height, unsigned int bits_per_pixel, size_t& consumed_out)
+{
+	// Local data
+	size_t										stride, filter_bytes;
+	unsigned char*								row, *prior_row;
+	unsigned char								filter_type;
+
+
+	stride			= ((size_t)width * bits_per_pixel + 7) / 8;
+	filter_bytes	= bits_per_pixel >= 8 ? bits_per_pixel / 8 : 1;
+	consumed_out	= (stride + 1) * height;
+	if(consumed_out > data_size)
+	{	return FALSE;
+	}
+
+	prior_row = 0;
+	for(unsigned int y=0; y<height; y++)
+	{
+		filter_type	= data[y * (stride + 1)];
+		row			= data + y * (stride + 1) + 1;
+		for(size_t i=0; i<stride; i++)
+		{
+			int a = i >= filter_bytes ? row[i - filter_bytes] : 0;
+			int b = prior_row ? prior_row[i] : 0;
+			int c = (prior_row && i >= filter_bytes) ? prior_row[i - filter_bytes] : 0;
+			switch(filter_type)
+			{
+			case 0:																	break;
+			case 1:	row[i] = (unsigned char)(row[i] + a);							break;
+			case 2:	row[i] = (unsigned char)(row[i] + b);							break;
+			case 3:	row[i] = (unsigned char)(row[i] + ((a + b) >> 1));				break;
+			case 4:	row[i] = (unsigned char)(row[i] + host_png_paeth(a, b, c));		break;
+			default: return FALSE;
+			}
+		}
+		prior_row = row;
+	}
+	return TRUE;
+}
+
+// Load a PNG file.
+BOOL host_load_png(const char* file_path, host_image_s& image_out)
+{
+	// Adam7 interlace passes - x start, y start, x step, y step.
+	static const unsigned int					adam7_array[7][4] = { {0,0,8,8}, {4,0,8,8}, {0,4,4,8}, {2,0,4,4}, {0,2,2,4}, {1,0,2,2}, {0,1,1,2} };
+
+	// Local data
+	std::vector<unsigned char>					file_data, idat_data, raw_data;
+	unsigned char								palette[256][4];
+	unsigned int								width, height, bit_depth, color_type, interlace, sample_count, bits_per_pixel, max_value, pass_count;
+	unsigned int								trns_key[3];
+	BOOL										is_trns_key;
+	size_t										position, raw_size, offset, consumed;
+	uLongf										inflated_size;
+	z_stream									stream;
+
+
+	if(!host_read_file(file_path, file_data))
+	{	return FALSE;
+	}
+	if(file_data.size() < 8 || memcmp(file_data.data(), "\x89PNG\r\n\x1a\n", 8) != 0)
+	{	host_log("error: \"%s\" is not a PNG file.", file_path);
+		return FALSE;
+	}
+
+	// Read chunks.
+	width = height = bit_depth = color_type = interlace = 0;
+	is_trns_key = FALSE;
+	memset(palette, 255, sizeof(palette));
+	position = 8;
+	while(position + 12 <= file_data.size())
+	{
+		unsigned int		chunk_size	= host_read_be32(&file_data[position]);
+		const unsigned char* chunk_type	= &file_data[position + 4];
+		const unsigned char* chunk_data	= &file_data[position + 8];
+
+		if(position + 12 + (size_t)chunk_size > file_data.size())
+		{	host_log("error: \"%s\" is truncated.", file_path);
+			return FALSE;
+		}
+		if(crc32(crc32(0, Z_NULL, 0), chunk_type, chunk_size + 4) != host_read_be32(chunk_data + chunk_size))
+		{	host_log("error: \"%s\" has a chunk with a bad CRC.", file_path);
+			return FALSE;
+		}
+
+		if(memcmp(chunk_type, "IHDR", 4) == 0 && chunk_size >= 13)
+		{	width		= host_read_be32(chunk_data);
+			height		= host_read_be32(chunk_data + 4);
+			bit_depth	= chunk_data[8];
+			color_type	= chunk_data[9];
+			interlace	= chunk_data[12];
+		}
+		else if(memcmp(chunk_type, "PLTE", 4) == 0)
+		{	for(unsigned int i=0; i<chunk_size / 3 && i<256; i++)
+			{	palette[i][0] = chunk_data[i * 3]; palette[i][1] = chunk_data[i * 3 + 1]; palette[i][2] = chunk_data[i * 3 + 2];
+			}
+		}
+		else if(memcmp(chunk_type, "tRNS", 4) == 0)
+		{	if(color_type == 3)
+			{	for(unsigned int i=0; i<chunk_size && i<256; i++)
+				{	palette[i][3] = chunk_data[i];
+				}
+			}
+			else if(color_type == 0 && chunk_size >= 2)
+			{	trns_key[0] = (chunk_data[0] << 8) | chunk_data[1];
+				is_trns_key = TRUE;
+			}
+			else if(color_type == 2 && chunk_size >= 6)
+			{	for(unsigned int i=0; i<3; i++)
+				{	trns_key[i] = (chunk_data[i * 2] << 8) | chunk_data[i * 2 + 1];
+				}
+				is_trns_key = TRUE;
+			}
+		}
+		else if(memcmp(chunk_type, "IDAT", 4) == 0)
+		{	idat_data.insert(idat_data.end(), chunk_data, chunk_data + chunk_size);
+		}
+		else if(memcmp(chunk_type, "IEND", 4) == 0)
+		{	break;
+		}
+		position += 12 + (size_t)chunk_size;
+	}
+
+	switch(color_type)
+	{
+	case 0:	sample_count = 1; break;
+	case 2:	sample_count = 3; break;
+	case 3:	sample_count = 1; break;
+	case 4:	sample_count = 2; break;
+	case 6:	sample_count = 4; break;
+	default:
+		host_log("error: \"%s\" has an unsupported PNG color type %u.", file_path, color_type);
+		return FALSE;
+	}
+	if(!width || !height || (bit_depth != 1 && bit_depth != 2 && bit_depth != 4 && bit_depth != 8 && bit_depth != 16))
+	{	host_log("error: \"%s\" has an invalid PNG header.", file_path);
+		return FALSE;
+	}
+	bits_per_pixel	= sample_count * bit_depth;
+	max_value		= (1u << bit_depth) - 1;
+
+	// Determine the inflated size and inflate.
+	pass_count	= interlace ? 7 : 1;
+	raw_size	= 0;
+	for(unsigned int pass=0; pass<pass_count; pass++)
+	{	unsigned int pass_width		= interlace ? (width + adam7_array[pass][2] - adam7_array[pass][0] - 1) / adam7_array[pass][2] : width;
+		unsigned int pass_height	= interlace ? (height + adam7_array[pass][3] - adam7_array[pass][1] - 1) / adam7_array[pass][3] : height;
+		if(pass_width && pass_height)
+		{	raw_size += (((size_t)pass_width * bits_per_pixel + 7) / 8 + 1) * pass_height;
+		}
+	}
+	raw_data.resize(raw_size);
+
+	memset(&stream, 0, sizeof(stream));
+	if(inflateInit(&stream) != Z_OK)
+	{	return FALSE;
+	}
+	stream.next_in		= idat_data.data();
+	stream.avail_in		= (uInt)idat_data.size();
+	stream.next_out		= raw_data.data();
+	stream.avail_out	= (uInt)raw_data.size();
+	inflate(&stream, Z_FINISH);
+	inflated_size		= stream.total_out;
+	inflateEnd(&stream);
+	if(inflated_size != raw_size)
+	{	host_log("error: \"%s\" has corrupt image data.", file_path);
+		return FALSE;
+	}
+
+	// Allocate. Grayscale color types are kept in grayscale format.
+	if(!image_out.allocate(width, height, color_type == 0 || color_type == 4))
+	{	host_log("error: failed to allocate %ux%u image for \"%s\".", width, height, file_path);
+		return FALSE;
+	}
+	image_out.is_sRGB		= TRUE;
+	image_out.is_rasterized	= TRUE;
+
+	// Unfilter each pass and store samples.
+	offset = 0;
+	for(unsigned int pass=0; pass<pass_count; pass++)
+	{
+		unsigned int x_start		= interlace ? adam7_array[pass][0] : 0;
+		unsigned int y_start		= interlace ? adam7_array[pass][1] : 0;
+		unsigned int x_step			= interlace ? adam7_array[pass][2] : 1;
+		unsigned int y_step			= interlace ? adam7_array[pass][3] : 1;
+		unsigned int pass_width		= (width + x_step - x_start - 1) / x_step;
+		unsigned int pass_height	= (height + y_step - y_start - 1) / y_step;
+		size_t		 stride			= ((size_t)pass_width * bits_per_pixel + 7) / 8;
+
+		if(!pass_width || !pass_height)
+		{	continue;
+		}
+		if(!host_png_unfilter(&raw_data[offset], raw_data.size() - offset, pass_width, pass_height, bits_per_pixel, consumed))
+		{	host_log("error: \"%s\" has invalid PNG filter data.", file_path);
+			return FALSE;
+		}
+
+		for(unsigned int py=0; py<pass_height; py++)
+		{
+			const unsigned char* row = &raw_data[offset + py * (stride + 1) + 1];
+			for(unsigned int px=0; px<pass_width; px++)
+			{
+				unsigned int	sample_array[4];
+				float			value_array[4];
+				size_t			pixel_index	= ((size_t)(y_start + py * y_step) * width + x_start + px * x_step) * image_out.get_channel_count();
+
+				// Read the samples of this pixel.
+				for(unsigned int s=0; s<sample_count; s++)
+				{	size_t bit_position = ((size_t)px * sample_count + s) * bit_depth;
+					if(bit_depth == 16)
+					{	sample_array[s] = (row[bit_position / 8] << 8) | row[bit_position / 8 + 1];
+					}
+					else if(bit_depth == 8)
+					{	sample_array[s] = row[bit_position / 8];
+					}
+					else
+					{	sample_array[s] = (row[bit_position / 8] >> (8 - bit_depth - (bit_position % 8))) & max_value;
+					}
+				}
+
+				// Convert to Color, Alpha or Red, Green, Blue, Alpha.
+				switch(color_type)
+				{
+				case 0:
+					value_array[0] = sample_array[0] / (float)max_value;
+					value_array[1] = (is_trns_key && sample_array[0] == trns_key[0]) ? 0.0f : 1.0f;
+					break;
+				case 4:
+					value_array[0] = sample_array[0] / (float)max_value;
+					value_array[1] = sample_array[1] / (float)max_value;
+					break;
+				case 2:
+					for(unsigned int c=0; c<3; c++)
+					{	value_array[c] = sample_array[c] / (float)max_value;
+					}
+					value_array[3] = (is_trns_key && sample_array[0] == trns_key[0] && sample_array[1] == trns_key[1] && sample_array[2] == trns_key[2]) ? 0.0f : 1.0f;
+					break;
+				case 3:
+					for(unsigned int c=0; c<4; c++)
+					{	value_array[c] = palette[sample_array[0] & 255][c] / 255.0f;
+					}
+					break;
+				default:
+					for(unsigned int c=0; c<4; c++)
+					{	value_array[c] = sample_array[c] / (float)max_value;
+					}
+					break;
+				}
+
+				for(unsigned int c=0; c<image_out.get_channel_count(); c++)
+				{	image_out.pixel_list[pixel_index + c] = host_float_to_half(value_array[c]);
+				}
+			}
+		}
+		offset += consumed;
+	}
+
+	return TRUE;
+}
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// EXR
+
+// EXR channel description from the "channels" header attribute.
+struct host_exr_channel_s
+{
+	std::string									name;
+	int											pixel_type;				// 0 UINT, 1 HALF, 2 FLOAT
+	int											x_sampling, y_sampling;
+};
+
+// Undo the EXR ZIP / RLE predictor and byte interleave.
+void host_exr_unpredict(const std::vector<unsigned char>& source, unsigned char* destination)
+{
+	// Local data
+	std::vector<unsigned char>					temp(source);
+	size_t										half_size;
+
+
+	for(size_t i=1; i<temp.size(); i++)
+	{	temp[i] = (unsigned char)(temp[i - 1] + temp[i] - 128);
+	}
+	half_size = (temp.size() + 1) / 2;
+	for(size_t i=0; i<temp.size(); i++)
+	{	destination[i] = (i & 1) ? temp[half_size + i / 2] : temp[i / 2];
+	}
+}
+
+// Decode EXR run length encoded data. Returns FALSE on corrupt data.
+BOOL host_exr_rle_decode(const unsigned char* source, size_t source_size, std::vector<unsigned char>& destination)
+{
+	// Local data
+	size_t										position;
+	int											count;
+
+
+	position = 0;
+	while(position < source_size)
+	{	count = (signed char)source[position++];
+		if(count < 0)
+		{	if(position + (size_t)(-count) > source_size)
+			{	return FALSE;
+			}
+			destination.insert(destination.end(), source + position, source + position - count);
+			position += (size_t)(-count);
+		}
+		else
+		{	if(position >= source_size)
+			{	return FALSE;
+			}
+			destination.insert(destination.end(), (size_t)count + 1, source[position++]);
+		}
+	}
+	return TRUE;
+}
+
+// Load an EXR file.
+BOOL host_load_exr(const char* file_path, host_image_s& image_out)
+{
+	// Local data
+	std::vector<unsigned char>					file_data, block_data, compressed_data;
+	std::vector<host_exr_channel_s>				channel_list;
+	int											data_window[4], compression, lines_per_block, channel_map[4];
+	unsigned int								width, height, block_count, version_flags;
+	size_t										position, line_size;
+	BOOL										is_grayscale;
+
+
+	if(!host_read_file(file_path, file_data))
+	{	return FALSE;
+	}
+	if(file_data.size() < 8 || host_read_le32(&file_data[0]) != 20000630)
+	{	host_log("error: \"%s\" is not an EXR file.", file_path);
+		return FALSE;
+	}
+	version_flags = host_read_le32(&file_data[4]);
+	if((version_flags & 0xFF) != 2 || (version_flags & (0x200 | 0x800 | 0x1000)))
+	{	host_log("error: \"%s\" is a tiled, deep or multi-part EXR which is not supported.", file_path);
+		return FALSE;
+	}
+
+	// Read header attributes.
+	compression = -1;
+	data_window[0] = data_window[1] = data_window[2] = data_window[3] = 0;
+	position = 8;
+	while(position < file_data.size() && file_data[position] != 0)
+	{
+		std::string name((const char*)&file_data[position]);
+		position += name.size() + 1;
+		std::string type((const char*)&file_data[position]);
+		position += type.size() + 1;
+		if(position + 4 > file_data.size())
+		{	break;
+		}
+		unsigned int attribute_size = host_read_le32(&file_data[position]);
+		position += 4;
+		if(position + attribute_size > file_data.size())
+		{	break;
+		}
+		const unsigned char* value = &file_data[position];
+
+		if(name == "channels" && type == "chlist")
+		{	size_t p = 0;
+			while(p < attribute_size && value[p] != 0)
+			{	host_exr_channel_s channel;
+				channel.name		= (const char*)&value[p];
+				p += channel.name.size() + 1;
+				channel.pixel_type	= (int)host_read_le32(&value[p]);
+				channel.x_sampling	= (int)host_read_le32(&value[p + 8]);
+				channel.y_sampling	= (int)host_read_le32(&value[p + 12]);
+				p += 16;
+				channel_list.push_back(channel);
+			}
+		}
+		else if(name == "compression" && attribute_size >= 1)
+		{	compression = value[0];
+		}
+		else if(name == "dataWindow" && attribute_size >= 16)
+		{	for(int i=0; i<4; i++)
+			{	data_window[i] = (int)host_read_le32(&value[i * 4]);
+			}
+		}
+		position += attribute_size;
+	}
+	position++;
+
+	width	= (unsigned int)(data_window[2] - data_window[0] + 1);
+	height	= (unsigned int)(data_window[3] - data_window[1] + 1);
+	switch(compression)
+	{
+	case 0: case 1: case 2:	lines_per_block = 1;	break;
+	case 3:					lines_per_block = 16;	break;
+	default:
+		host_log("error: \"%s\" uses EXR compression %d. Only NONE, RLE, ZIPS and ZIP are supported.", file_path, compression);
+		return FALSE;
+	}
+	if(channel_list.empty() || !width || !height)
+	{	host_log("error: \"%s\" has an invalid EXR header.", file_path);
+		return FALSE;
+	}
+
+	// Map channels to R, G, B, A or Y, A - layer prefixes such as "diffuse.R" are ignored.
+	channel_map[0] = channel_map[1] = channel_map[2] = channel_map[3] = -1;
+	is_grayscale = TRUE;
+	for(size_t i=0; i<channel_list.size(); i++)
+	{	std::string short_name = channel_list[i].name.substr(channel_list[i].name.find_last_of('.') == std::string::npos ? 0 : channel_list[i].name.find_last_of('.') + 1);
+		if(channel_list[i].x_sampling != 1 || channel_list[i].y_sampling != 1)
+		{	host_log("error: \"%s\" has sub-sampled channels which are not supported.", file_path);
+			return FALSE;
+		}
+		if(short_name == "R" || short_name == "r")		{ channel_map[0] = (int)i; is_grayscale = FALSE; }
+		else if(short_name == "G" || short_name == "g")	{ channel_map[1] = (int)i; is_grayscale = FALSE; }
+		else if(short_name == "B" || short_name == "b")	{ channel_map[2] = (int)i; is_grayscale = FALSE; }
+		else if(short_name == "A" || short_name == "a")	{ channel_map[3] = (int)i; }
+		else if(short_name == "Y" || short_name == "y")	{ if(channel_map[0] < 0) channel_map[0] = (int)i; }
+	}
+	if(channel_map[0] < 0 && channel_map[1] < 0 && channel_map[2] < 0)
+	{	channel_map[0] = 0;
+	}
+
+	// Bytes per scanline.
+	line_size = 0;
+	for(size_t i=0; i<channel_list.size(); i++)
+	{	line_size += (size_t)width * (channel_list[i].pixel_type == 1 ? 2 : 4);
+	}
+
+	if(!image_out.allocate(width, height, is_grayscale))
+	{	host_log("error: failed to allocate %ux%u image for \"%s\".", width, height, file_path);
+		return FALSE;
+	}
+	image_out.is_sRGB		= FALSE;
+	image_out.is_rasterized	= TRUE;
+
+	// Read the blocks using the offset table.
+	block_count = (height + lines_per_block - 1) / lines_per_block;
+	for(unsigned int block=0; block<block_count; block++)
+	{
+		if(position + (block + 1) * 8 > file_data.size())
+		{	host_log("error: \"%s\" is truncated.", file_path);
+			return FALSE;
+		}
+		unsigned long long	chunk_offset	= host_read_le64(&file_data[position + block * 8]);
+		if(chunk_offset + 8 > file_data.size())
+		{	host_log("error: \"%s\" has an invalid offset table.", file_path);
+			return FALSE;
+		}
+		int					first_line		= (int)host_read_le32(&file_data[chunk_offset]) - data_window[1];
+		unsigned int		data_size		= host_read_le32(&file_data[chunk_offset + 4]);
+		unsigned int		line_count		= std::min((unsigned int)lines_per_block, height - (unsigned int)first_line);
+		size_t				expected_size	= line_size * line_count;
+		const unsigned char* chunk_data		= &file_data[chunk_offset + 8];
+
+		if(first_line < 0 || (unsigned int)first_line >= height || chunk_offset + 8 + data_size > file_data.size())
+		{	host_log("error: \"%s\" has an invalid block.", file_path);
+			return FALSE;
+		}
+
+		// Decompress. Blocks that would not get smaller are stored uncompressed.
+		block_data.resize(expected_size);
+		if(compression == 0 || data_size == expected_size)
+		{	if(data_size < expected_size)
+			{	host_log("error: \"%s\" has a short block.", file_path);
+				return FALSE;
+			}
+			memcpy(block_data.data(), chunk_data, expected_size);
+		}
+		else if(compression == 1)
+		{	compressed_data.clear();
+			if(!host_exr_rle_decode(chunk_data, data_size, compressed_data) || compressed_data.size() != expected_size)
+			{	host_log("error: \"%s\" has corrupt RLE data.", file_path);
+				return FALSE;
+			}
+			host_exr_unpredict(compressed_data, block_data.data());
+		}
+		else
+		{	uLongf inflated_size = (uLongf)expected_size;
+			compressed_data.resize(expected_size);
+			if(uncompress(compressed_data.data(), &inflated_size, chunk_data, data_size) != Z_OK || inflated_size != expected_size)
+			{	host_log("error: \"%s\" has corrupt ZIP data.", file_path);
+				return FALSE;
+			}
+			host_exr_unpredict(compressed_data, block_data.data());
+		}
+
+		// Each line holds all samples of the first channel, then the second channel, and so on.
+		for(unsigned int line=0; line<line_count; line++)
+		{
+			const unsigned char*	line_data	= &block_data[line * line_size];
+			unsigned short*			destination	= &image_out.pixel_list[(size_t)(first_line + line) * width * image_out.get_channel_count()];
+			size_t					channel_offset_array[64];
+			size_t					channel_offset = 0;
+
+			for(size_t i=0; i<channel_list.size() && i<64; i++)
+			{	channel_offset_array[i]	= channel_offset;
+				channel_offset			+= (size_t)width * (channel_list[i].pixel_type == 1 ? 2 : 4);
+			}
+
+			for(unsigned int c=0; c<image_out.get_channel_count(); c++)
+			{
+				int channel_index = is_grayscale ? channel_map[c == 0 ? 0 : 3] : channel_map[c];
+				for(unsigned int x=0; x<width; x++)
+				{	unsigned short half_value;
+					if(channel_index < 0 || channel_index >= 64)
+					{	half_value = (c == image_out.get_channel_count() - 1) ? 0x3C00 : 0;		// Missing alpha is 1.0, missing color is 0.0.
+					}
+					else
+					{	const unsigned char* sample = line_data + channel_offset_array[channel_index];
+						switch(channel_list[channel_index].pixel_type)
+						{
+						case 1:		half_value = (unsigned short)(sample[x * 2] | (sample[x * 2 + 1] << 8));					break;
+						case 2:		{ float f; unsigned int bits = host_read_le32(&sample[x * 4]); memcpy(&f, &bits, 4); half_value = host_float_to_half(f); } break;
+						default:	half_value = host_float_to_half((float)host_read_le32(&sample[x * 4]));					break;
+						}
+					}
+					destination[(size_t)x * image_out.get_channel_count() + c] = half_value;
+				}
+			}
+		}
+	}
+
+	// Determine if the color channels are rasterized.
+	for(size_t i=0; i<image_out.pixel_list.size() && image_out.is_rasterized; i++)
+	{	if((i % image_out.get_channel_count()) != image_out.get_channel_count() - 1)
+		{	float value = host_half_to_float(image_out.pixel_list[i]);
+			if(!(value >= 0.0f && value <= 1.0f))
+			{	image_out.is_rasterized = FALSE;
+			}
+		}
+	}
+
+	return TRUE;
+}
+
+// Save an EXR file with HALF channels and no compression.
+BOOL host_save_exr(const char* file_path, const host_image_s& image)
+{
+	// Local data
+	FILE*										fp;
+	std::vector<unsigned char>					header, line_data;
+	const char*									channel_name_array[4];
+	unsigned int								channel_count, output_channel_count, source_channel_array[4];
+	unsigned long long							offset;
+
+
+	// Channels must be sorted by name. Color is saved as A, B, G, R and grayscale as A, Y.
+	channel_count = image.get_channel_count();
+	if(image.is_grayscale)
+	{	channel_name_array[0] = "A"; source_channel_array[0] = 1;
+		channel_name_array[1] = "Y"; source_channel_array[1] = 0;
+		output_channel_count = 2;
+	}
+	else
+	{	channel_name_array[0] = "A"; source_channel_array[0] = 3;
+		channel_name_array[1] = "B"; source_channel_array[1] = 2;
+		channel_name_array[2] = "G"; source_channel_array[2] = 1;
+		channel_name_array[3] = "R"; source_channel_array[3] = 0;
+		output_channel_count = 4;
+	}
+
+	// Helpers to append header data.
+	auto append_bytes	= [&header](const void* data, size_t size) { header.insert(header.end(), (const unsigned char*)data, (const unsigned char*)data + size); };
+	auto append_string	= [&append_bytes](const char* s) { append_bytes(s, strlen(s) + 1); };
+	auto append_int		= [&append_bytes](int value) { unsigned char b[4] = { (unsigned char)value, (unsigned char)(value >> 8), (unsigned char)(value >> 16), (unsigned char)(value >> 24) }; append_bytes(b, 4); };
+	auto append_float	= [&append_int](float value) { int bits; memcpy(&bits, &value, 4); append_int(bits); };
+
+	append_int(20000630);
+	append_int(2);
+
+	append_string("channels"); append_string("chlist"); append_int((int)(output_channel_count * 18 + 1));
+	for(unsigned int i=0; i<output_channel_count; i++)
+	{	append_string(channel_name_array[i]);
+		append_int(1);								// HALF
+		append_int(0);								// pLinear and reserved
+		append_int(1); append_int(1);				// Sampling
+	}
+	header.push_back(0);
+
+	append_string("compression"); append_string("compression"); append_int(1); header.push_back(0);
+	append_string("dataWindow"); append_string("box2i"); append_int(16);
+	append_int(0); append_int(0); append_int((int)image.width - 1); append_int((int)image.height - 1);
+	append_string("displayWindow"); append_string("box2i"); append_int(16);
+	append_int(0); append_int(0); append_int((int)image.width - 1); append_int((int)image.height - 1);
+	append_string("lineOrder"); append_string("lineOrder"); append_int(1); header.push_back(0);
+	append_string("pixelAspectRatio"); append_string("float"); append_int(4); append_float(1.0f);
+	append_string("screenWindowCenter"); append_string("v2f"); append_int(8); append_float(0.0f); append_float(0.0f);
+	append_string("screenWindowWidth"); append_string("float"); append_int(4); append_float(1.0f);
+	header.push_back(0);
+
+	// Offset table - one entry per line.
+	offset = header.size() + (unsigned long long)image.height * 8;
+	for(unsigned int y=0; y<image.height; y++)
+	{	unsigned long long line_offset = offset + (unsigned long long)y * (8 + (unsigned long long)image.width * output_channel_count * 2);
+		for(int b=0; b<8; b++)
+		{	header.push_back((unsigned char)(line_offset >> (b * 8)));
+		}
+	}
+
+	fp = fopen(file_path, "wb");
+	if(!fp)
+	{	host_log("error: failed to create \"%s\".", file_path);
+		return FALSE;
+	}
+	fwrite(header.data(), 1, header.size(), fp);
+
+	line_data.resize(8 + (size_t)image.width * output_channel_count * 2);
+	for(unsigned int y=0; y<image.height; y++)
+	{	unsigned int data_size = (unsigned int)(line_data.size() - 8);
+		memcpy(&line_data[0], &y, 4);
+		memcpy(&line_data[4], &data_size, 4);
+		for(unsigned int c=0; c<output_channel_count; c++)
+		{	for(unsigned int x=0; x<image.width; x++)
+			{	unsigned short value = image.pixel_list[((size_t)y * image.width + x) * channel_count + source_channel_array[c]];
+				line_data[8 + ((size_t)c * image.width + x) * 2]		= (unsigned char)value;
+				line_data[8 + ((size_t)c * image.width + x) * 2 + 1]	= (unsigned char)(value >> 8);
+			}
+		}
+		fwrite(line_data.data(), 1, line_data.size(), fp);
+	}
+
+	if(fclose(fp) != 0)
+	{	host_log("error: failed to write \"%s\".", file_path);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Synthetic images and general loading
+
+// Generate a smooth test pattern. Color channels are in the range 0.0f - 1.0f.
+BOOL host_create_synthetic_image(unsigned int width, unsigned int height, BOOL is_grayscale, host_image_s& image_out)
+{
+	if(!width || !height || !image_out.allocate(width, height, is_grayscale))
+	{	host_log("error: failed to create a %ux%u synthetic image.", width, height);
+		return FALSE;
+	}
+	image_out.is_sRGB		= TRUE;
+	image_out.is_rasterized	= TRUE;
+
+	for(unsigned int y=0; y<height; y++)
+	{	for(unsigned int x=0; x<width; x++)
+		{
+			float				u		= x / (float)width, v = y / (float)height;
+			float				r		= 0.5f + 0.5f * sinf(u * 37.0f + v * 11.0f);
+			float				g		= 0.5f + 0.5f * sinf(v * 29.0f - u * 7.0f);
+			float				b		= 0.5f + 0.5f * cosf((u + v) * 17.0f);
+			unsigned short*		pixel	= &image_out.pixel_list[((size_t)y * width + x) * image_out.get_channel_count()];
+
+			if(is_grayscale)
+			{	pixel[0] = host_float_to_half(0.3f * r + 0.59f * g + 0.11f * b);
+				pixel[1] = 0x3C00;
+			}
+			else
+			{	pixel[0] = host_float_to_half(r);
+				pixel[1] = host_float_to_half(g);
+				pixel[2] = host_float_to_half(b);
+				pixel[3] = 0x3C00;
+			}
+		}
+	}
+	return TRUE;
+}
+
+// Load an image by file extension or create a synthetic image. See the notes at the top of this file.
+BOOL host_load_image(const char* image_spec, host_image_s& image_out)
+{
+	// Local data
+	unsigned int								width, height;
+	std::string									extension;
+
+
+	if(sscanf(image_spec, "synthetic:%ux%u", &width, &height) == 2)
+	{	return host_create_synthetic_image(width, height, FALSE, image_out);
+	}
+	if(sscanf(image_spec, "synthetic_gray:%ux%u", &width, &height) == 2)
+	{	return host_create_synthetic_image(width, height, TRUE, image_out);
+	}
+
+	extension = host_get_extension(image_spec);
+	if(extension == "png")
+	{	return host_load_png(image_spec, image_out);
+	}
+	if(extension == "exr")
+	{	return host_load_exr(image_spec, image_out);
+	}
+
+	host_log("error: \"%s\" is not a supported image. Use PNG, EXR, synthetic:WxH or synthetic_gray:WxH.", image_spec);
+	return FALSE;
+}
+
+// Load a mask. Masks are single channel 16 bit images, the first channel of the image is used.
+BOOL host_load_mask(const char* image_spec, unsigned int& width_out, unsigned int& height_out, std::vector<unsigned short>& mask_out)
+{
+	// Local data
+	host_image_s								image;
+	float										value;
+
+
+	if(!host_load_image(image_spec, image))
+	{	return FALSE;
+	}
+	width_out	= image.width;
+	height_out	= image.height;
+	mask_out.resize((size_t)image.width * image.height);
+	for(size_t i=0; i<mask_out.size(); i++)
+	{	value		= host_half_to_float(image.pixel_list[i * image.get_channel_count()]);
+		value		= value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+		mask_out[i]	= (unsigned short)(value * 65535.0f + 0.5f);
+	}
+	return TRUE;
+}
@@ -0,0 +1,1157 @@
+/*
+	===============================================================
+
+	SHADERMAP HEADLESS HOST - MAP API SOURCE FILE
+
+	Implements the functions that ShaderMap passes to map plugins
+	in "plugin_initialize()" (see "maps/map_plugin_core.cpp") so
+	that map plugins can be initialized and processed without
+	ShaderMap.
+
+	Map inputs, source maps and masks are read from files with
+	"host_image.cpp" and "host_model.cpp". Every map plugin
+	instance and every input is a node with a unique id, the same
+	way nodes are identified in a ShaderMap project. Different
+	nodes can be processed at the same time from different threads.
+
+	Include after a map plugin core (with SMSDK_HOST defined),
+	"host_common.cpp", "host_image.cpp" and "host_model.cpp".
+
+
+	SHADERMAP SDK LICENSE
+
+	The ShaderMap SDK is released under The MIT License (MIT)
+	http://opensource.org/licenses/MIT
+
+	Copyright (c) 2007-2019 Rendering Systems Inc.
+
+	See "host_common.cpp" for the full license text.
+
+	===============================================================
+*/
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Map host structs
+
+// A map input defined by a plugin with "mp_add_input()".
+struct host_map_input_s
+{
+	std::wstring								name;
+	std::wstring								description;
+	int											type;					// MAP_INPUT_TYPE_ (MAP, MODEL, or LIGHTSCAN)
+	BOOL										is_input_filter_grayscale;
+	map_input_filter_data_s						default_input_filter_data;
+};
+
+// A loaded map plugin and the data it defined in "on_initialize()".
+struct host_map_plugin_s
+{
+	host_library_s								library;
+	map_plugin_info_s							info;					// String members point into the strings below.
+	std::wstring								name, description, default_suffix, thumb_filename;
+	std::vector<host_map_input_s>				input_list;
+	std::vector<host_property_s>				property_list;			// Default property values including the auto added mask properties.
+	BOOL										is_source_input_filter_grayscale;
+	map_input_filter_data_s						default_source_input_filter_data;
+	BOOL										is_initialized;
+
+	// c()
+	host_map_plugin_s(void)
+	{	is_source_input_filter_grayscale = FALSE;
+		is_initialized = FALSE;
+	}
+};
+
+// A project node. Either a map plugin instance or an input (image or model) loaded from file.
+struct host_map_node_s
+{
+	unsigned int								id;
+	host_map_plugin_s*							plugin;					// 0 for inputs loaded from file.
+
+	// Map plugin instance data.
+	std::vector<host_property_s>				property_list;
+	std::vector<unsigned int>					input_id_list;
+	std::vector<map_input_filter_data_s>		input_filter_list;
+	map_input_filter_data_s						source_input_filter_data;
+	host_image_s								source_image;			// Source image of a MAP_PLUGIN_TYPE_SOURCE plugin.
+	unsigned int								mask_width, mask_height;
+	std::vector<unsigned short>					mask_pixel_list;
+	std::wstring								output_filename;
+
+	// Output - the created map of a plugin or the image loaded from file.
+	BOOL										is_created;
+	host_image_s								image;
+	unsigned int								coord_system;
+	unsigned int								tile_type;
+	unsigned int								thread_limit;			// Returned by mp_get_map_thread_limit() while this node is processed, 0 for the context limit.
+
+	// 3D model inputs.
+	host_model_s*								model;
+	host_model_s*								cage;
+
+	// Process statistics.
+	std::atomic<unsigned int>					progress;
+	std::atomic<unsigned int>					progress_call_count;
+	std::atomic<unsigned int>					region_update_count;
+	std::atomic<unsigned int>					error_count;
+
+	// c()
+	host_map_node_s(void)
+	{	id = 0; plugin = 0;
+		mask_width = mask_height = 0;
+		is_created = FALSE; coord_system = 0; tile_type = MAP_TILE_NONE; thread_limit = 0;
+		model = cage = 0;
+		reset_statistics();
+	}
+
+	// d()
+	~host_map_node_s(void)
+	{	delete model;
+		delete cage;
+	}
+
+	// Reset the process statistics.
+	void reset_statistics(void)
+	{	progress = 0; progress_call_count = 0; region_update_count = 0; error_count = 0;
+	}
+};
+
+// An entry in the node cache registry. Cached data is owned by the plugin that registered it.
+struct host_node_cache_entry_s
+{
+	unsigned int								node_id;
+	unsigned int								cache_type;
+	std::wstring								cache_name;
+	const void*									data_pointer;
+	unsigned long long							data_size;
+	host_map_plugin_s*							plugin;
+};
+
+// Host state shared by all map API functions.
+struct host_map_context_s
+{
+	std::vector<host_map_plugin_s*>				plugin_list;
+	std::vector<host_map_node_s*>				node_list;				// Indexed by node id.
+	host_map_plugin_s*							initializing_plugin;	// Plugin inside "on_initialize()".
+
+	// ShaderMap options.
+	unsigned int								option_default_tile_type;
+	unsigned int								option_default_coord_sys;
+	unsigned int								option_udim_u_max;
+	unsigned int								option_udim_postfix_format;
+	unsigned int								thread_limit;
+	BOOL										is_cache_enabled;
+
+	// Node cache registry.
+	std::mutex									cache_mutex;
+	std::vector<host_node_cache_entry_s>		cache_list;
+
+	// Cancel control. Cancel is set by the host or after cancel_after_poll_count calls of "mp_is_cancel_process()" (0 disables).
+	std::atomic<BOOL>							is_cancel;
+	std::atomic<unsigned long long>				cancel_poll_count;
+	unsigned long long							cancel_after_poll_count;
+
+	// Translation files defined by plugins.
+	std::vector<std::wstring>					translation_file_list;
+
+	// c()
+	host_map_context_s(void)
+	{	initializing_plugin			= 0;
+		option_default_tile_type	= MAP_TILE_NONE;
+		option_default_coord_sys	= MAP_COORDSYS_X_POS_RIGHT | MAP_COORDSYS_Y_POS_UP | MAP_COORDSYS_Z_POS_NEAR;
+		option_udim_u_max			= 10;
+		option_udim_postfix_format	= UDIM_POSTFIX_ID;
+		thread_limit				= 1;
+		is_cache_enabled			= TRUE;
+		is_cancel					= FALSE;
+		cancel_poll_count			= 0;
+		cancel_after_poll_count		= 0;
+	}
+};
+
+host_map_context_s								host_map_context;
+
+// The node inside "on_process()" on the calling thread. Its plugin owns the cache data registered from that thread.
+static thread_local host_map_node_s*			host_map_calling_node = 0;
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Map host helpers
+
+// Return a node by id or 0 and log an error.
+host_map_node_s* host_map_find_node(unsigned int node_id, const char* function_name)
+{
+	if(node_id >= host_map_context.node_list.size() || !host_map_context.node_list[node_id])
+	{	host_log("error: %s: invalid map id %u.", function_name, node_id);
+		return 0;
+	}
+	return host_map_context.node_list[node_id];
+}
+
+// Return an input node of a map plugin node or 0 and log an error.
+host_map_node_s* host_map_find_input_node(unsigned int map_id, unsigned int input_index, const char* function_name)
+{
+	host_map_node_s* node = host_map_find_node(map_id, function_name);
+	if(!node)
+	{	return 0;
+	}
+	if(input_index >= node->input_id_list.size())
+	{	host_log("error: %s: input index %u is out of range, map %u has %u inputs.", function_name, input_index, map_id, (unsigned int)node->input_id_list.size());
+		return 0;
+	}
+	return host_map_find_node(node->input_id_list[input_index], function_name);
+}
+
+// Return a property of a map node checking the property type. Logs an error and returns 0 on mismatch.
+host_property_s* host_map_find_property(unsigned int map_id, unsigned int property_index, unsigned int property_type, const char* function_name)
+{
+	host_map_node_s*	node;
+	host_property_s*	property;
+
+
+	node = host_map_find_node(map_id, function_name);
+	if(!node)
+	{	return 0;
+	}
+	property = host_find_property(node->property_list, property_index, function_name);
+	if(property && property->type != property_type)
+	{	host_log("error: %s: property %u of map %u is not of the requested type.", function_name, property_index, map_id);
+		return 0;
+	}
+	return property;
+}
+
+// Return the plugin being initialized or 0 and log an error. Used by the functions that are only valid in "on_initialize()".
+host_map_plugin_s* host_map_get_initializing_plugin(const char* function_name)
+{
+	if(!host_map_context.initializing_plugin)
+	{	host_log("error: %s: called outside of on_initialize().", function_name);
+	}
+	return host_map_context.initializing_plugin;
+}
+
+// Add a property to the plugin being initialized.
+host_property_s* host_map_add_property(unsigned int type, const wchar_t* caption, unsigned int page_index, const char* function_name)
+{
+	host_map_plugin_s*	plugin;
+	host_property_s		property;
+
+
+	plugin = host_map_get_initializing_plugin(function_name);
+	if(!plugin)
+	{	return 0;
+	}
+	property.type		= type;
+	property.caption	= caption ? caption : L"";
+	property.page_index	= page_index;
+	plugin->property_list.push_back(property);
+	return &plugin->property_list.back();
+}
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Map API - setup and info functions (0 - 4, 100 - 105, 200)
+
+void host_mp_begin_initialize(void)
+{
+}
+
+void host_mp_end_initialize(void)
+{
+}
+
+unsigned int host_mp_define_translation_file(const wchar_t* file_title, const wchar_t* default_prefix)
+{
+	host_map_context.translation_file_list.push_back(file_title ? file_title : L"");
+	return (unsigned int)host_map_context.translation_file_list.size() - 1;
+}
+
+// Translation files are not loaded by the headless host. An empty string is returned for every id.
+const wchar_t* host_mp_get_trans_string(unsigned int file_index, unsigned int id)
+{
+	return L"";
+}
+
+void host_mp_define_help_file(const wchar_t* help_file, const wchar_t* default_language)
+{
+}
+
+unsigned int host_mp_get_option_default_tile_type(void)
+{
+	return host_map_context.option_default_tile_type;
+}
+
+unsigned int host_mp_get_option_default_coord_sys(void)
+{
+	return host_map_context.option_default_coord_sys;
+}
+
+unsigned int host_mp_get_option_udim_u_max(void)
+{
+	return host_map_context.option_udim_u_max;
+}
+
+unsigned int host_mp_get_option_udim_postfix_format(void)
+{
+	return host_map_context.option_udim_postfix_format;
+}
+
+void host_mp_add_input(const wchar_t* input_name, const wchar_t* input_description, int input_type, BOOL is_input_filter_grayscale, map_input_filter_data_s* default_input_filter_data)
+{
+	host_map_plugin_s*	plugin;
+	host_map_input_s	input;
+
+
+	plugin = host_map_get_initializing_plugin(__FUNCTION__);
+	if(!plugin)
+	{	return;
+	}
+	input.name							= input_name ? input_name : L"";
+	input.description					= input_description ? input_description : L"";
+	input.type							= input_type;
+	input.is_input_filter_grayscale		= is_input_filter_grayscale;
+	if(default_input_filter_data)
+	{	input.default_input_filter_data	= *default_input_filter_data;
+	}
+	plugin->input_list.push_back(input);
+}
+
+void host_mp_setup_source_input_filter(BOOL is_input_filter_grayscale, map_input_filter_data_s* default_input_filter_data)
+{
+	host_map_plugin_s* plugin = host_map_get_initializing_plugin(__FUNCTION__);
+	if(!plugin)
+	{	return;
+	}
+	plugin->is_source_input_filter_grayscale = is_input_filter_grayscale;
+	if(default_input_filter_data)
+	{	plugin->default_source_input_filter_data = *default_input_filter_data;
+	}
+}
+
+void host_mp_set_plugin_info(const map_plugin_info_s& plugin_info)
+{
+	host_map_plugin_s* plugin = host_map_get_initializing_plugin(__FUNCTION__);
+	if(!plugin)
+	{	return;
+	}
+
+	// Copy strings - the plugin may pass pointers to temporary strings.
+	plugin->name					= plugin_info.name ? plugin_info.name : L"";
+	plugin->description				= plugin_info.description ? plugin_info.description : L"";
+	plugin->default_suffix			= plugin_info.default_suffix ? plugin_info.default_suffix : L"";
+	plugin->thumb_filename			= plugin_info.thumb_filename ? plugin_info.thumb_filename : L"";
+	plugin->info					= plugin_info;
+	plugin->info.name				= plugin->name.c_str();
+	plugin->info.description		= plugin->description.c_str();
+	plugin->info.default_suffix		= plugin->default_suffix.c_str();
+	plugin->info.thumb_filename		= plugin->thumb_filename.c_str();
+}
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Map API - add property functions (300 - 309)
+
+void host_mp_add_property_pagelist(const wchar_t* caption, const wchar_t** string_array, unsigned int string_count, unsigned int cur_select)
+{
+	host_property_s* property = host_map_add_property(HOST_PROPERTY_PAGELIST, caption, 0, __FUNCTION__);
+	if(property)
+	{	for(unsigned int i=0; i<string_count; i++)
+		{	property->string_list.push_back(string_array[i] ? string_array[i] : L"");
+		}
+		property->value_int = (int)cur_select;
+	}
+}
+
+void host_mp_add_property_file(const wchar_t* caption, const wchar_t* initial_path, const wchar_t* extension_filter_pointer, unsigned int page_index)
+{
+	host_property_s* property = host_map_add_property(HOST_PROPERTY_FILE, caption, page_index, __FUNCTION__);
+	if(property)
+	{	property->value_file = initial_path ? initial_path : L"";
+	}
+}
+
+void host_mp_add_property_checkbox(const wchar_t* caption, BOOL is_checked, unsigned int page_index)
+{
+	host_property_s* property = host_map_add_property(HOST_PROPERTY_CHECKBOX, caption, page_index, __FUNCTION__);
+	if(property)
+	{	property->value_int = is_checked ? TRUE : FALSE;
+	}
+}
+
+void host_mp_add_property_list(const wchar_t* caption, const wchar_t** string_array, unsigned int string_count, unsigned int cur_select, unsigned int page_index)
+{
+	host_property_s* property = host_map_add_property(HOST_PROPERTY_LIST, caption, page_index, __FUNCTION__);
+	if(property)
+	{	for(unsigned int i=0; i<string_count; i++)
+		{	property->string_list.push_back(string_array[i] ? string_array[i] : L"");
+		}
+		property->value_int = (int)cur_select;
+	}
+}
+
+void host_mp_add_property_numberbox_int(const wchar_t* caption, int min, int max, int value, unsigned int page_index)
+{
+	host_property_s* property = host_map_add_property(HOST_PROPERTY_NUMBERBOX_INT, caption, page_index, __FUNCTION__);
+	if(property)
+	{	property->int_min = min; property->int_max = max; property->value_int = value;
+	}
+}
+
+void host_mp_add_property_numberbox_float(const wchar_t* caption, float min, float max, float value, unsigned int page_index)
+{
+	host_property_s* property = host_map_add_property(HOST_PROPERTY_NUMBERBOX_FLOAT, caption, page_index, __FUNCTION__);
+	if(property)
+	{	property->float_min = min; property->float_max = max; property->value_float = value;
+	}
+}
+
+void host_mp_add_property_colorbox(const wchar_t* caption, COLORREF color, unsigned int page_index)
+{
+	host_property_s* property = host_map_add_property(HOST_PROPERTY_COLORBOX, caption, page_index, __FUNCTION__);
+	if(property)
+	{	property->value_int = (int)color;
+	}
+}
+
+void host_mp_add_property_slider(const wchar_t* caption, int min, int max, int position, unsigned int page_index, BOOL is_forced_center, int forced_center)
+{
+	host_property_s* property = host_map_add_property(HOST_PROPERTY_SLIDER, caption, page_index, __FUNCTION__);
+	if(property)
+	{	property->int_min = min; property->int_max = max; property->value_int = position;
+	}
+}
+
+void host_mp_add_property_range_slider(const wchar_t* caption_low, const wchar_t* caption_mid, const wchar_t* caption_high,
+									   int min, int max, int position_min, int position_max, unsigned int page_index)
+{
+	host_property_s* property = host_map_add_property(HOST_PROPERTY_RANGE_SLIDER, caption_mid ? caption_mid : caption_low, page_index, __FUNCTION__);
+	if(property)
+	{	property->int_min = min; property->int_max = max; property->value_int = position_min; property->value_int_high = position_max;
+	}
+}
+
+void host_mp_add_property_coordsys(const wchar_t* caption, unsigned int coordinate_system, unsigned int page_index)
+{
+	host_property_s* property = host_map_add_property(HOST_PROPERTY_COORDSYS, caption, page_index, __FUNCTION__);
+	if(property)
+	{	property->value_int = (int)coordinate_system;
+	}
+}
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Map API - source map functions (400 - 405)
+
+unsigned int host_mp_get_source_width(unsigned int map_id)
+{
+	host_map_node_s* node = host_map_find_node(map_id, __FUNCTION__);
+	return node ? node->source_image.width : 0;
+}
+
+unsigned int host_mp_get_source_height(unsigned int map_id)
+{
+	host_map_node_s* node = host_map_find_node(map_id, __FUNCTION__);
+	return node ? node->source_image.height : 0;
+}
+
+BOOL host_mp_is_source_grayscale(unsigned int map_id)
+{
+	host_map_node_s* node = host_map_find_node(map_id, __FUNCTION__);
+	return node ? node->source_image.is_grayscale : FALSE;
+}
+
+BOOL host_mp_is_source_rasterized(unsigned int map_id)
+{
+	host_map_node_s* node = host_map_find_node(map_id, __FUNCTION__);
+	return node ? node->source_image.is_rasterized : FALSE;
+}
+
+BOOL host_mp_is_source_sRGB(unsigned int map_id)
+{
+	host_map_node_s* node = host_map_find_node(map_id, __FUNCTION__);
+	return node ? node->source_image.is_sRGB : FALSE;
+}
+
+const void* host_mp_get_source_pixel_array(unsigned int map_id)
+{
+	host_map_node_s* node = host_map_find_node(map_id, __FUNCTION__);
+	return (node && !node->source_image.pixel_list.empty()) ? node->source_image.pixel_list.data() : 0;
+}
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Map API - input functions (500 - 516)
+
+unsigned int host_mp_get_input_id(unsigned int map_id, unsigned int input_index)
+{
+	host_map_node_s* node = host_map_find_input_node(map_id, input_index, __FUNCTION__);
+	return node ? node->id : 0;
+}
+
+unsigned int host_mp_get_input_width(unsigned int map_id, unsigned int input_index)
+{
+	host_map_node_s* node = host_map_find_input_node(map_id, input_index, __FUNCTION__);
+	return node ? node->image.width : 0;
+}
+
+unsigned int host_mp_get_input_height(unsigned int map_id, unsigned int input_index)
+{
+	host_map_node_s* node = host_map_find_input_node(map_id, input_index, __FUNCTION__);
+	return node ? node->image.height : 0;
+}
+
+unsigned int host_mp_get_input_coordsys(unsigned int map_id, unsigned int input_index)
+{
+	host_map_node_s* node = host_map_find_input_node(map_id, input_index, __FUNCTION__);
+	return node ? node->coord_system : 0;
+}
+
+unsigned int host_mp_get_input_tile_type(unsigned int map_id, unsigned int input_index)
+{
+	host_map_node_s* node = host_map_find_input_node(map_id, input_index, __FUNCTION__);
+	return node ? node->tile_type : MAP_TILE_NONE;
+}
+
+BOOL host_mp_is_input_grayscale(unsigned int map_id, unsigned int input_index)
+{
+	host_map_node_s* node = host_map_find_input_node(map_id, input_index, __FUNCTION__);
+	return node ? node->image.is_grayscale : FALSE;
+}
+
+BOOL host_mp_is_input_sRGB(unsigned int map_id, unsigned int input_index)
+{
+	host_map_node_s* node = host_map_find_input_node(map_id, input_index, __FUNCTION__);
+	return node ? node->image.is_sRGB : FALSE;
+}
+
+const void* host_mp_get_input_pixel_array(unsigned int map_id, unsigned int input_index)
+{
+	host_map_node_s* node = host_map_find_input_node(map_id, input_index, __FUNCTION__);
+	return (node && !node->image.pixel_list.empty()) ? node->image.pixel_list.data() : 0;
+}
+
+void host_mp_get_input_model(unsigned int map_id, unsigned int input_index, BOOL is_cage, model_input_data_s& model_data_out)
+{
+	host_map_node_s* node = host_map_find_input_node(map_id, input_index, __FUNCTION__);
+	model_data_out = model_input_data_s();
+	if(node)
+	{	host_model_s* model = is_cage ? node->cage : node->model;
+		if(model)
+		{	model->get_input_data(model_data_out);
+		}
+	}
+}
+
+BOOL host_mp_get_input_model_subset_list(unsigned int map_id, unsigned int input_index, BOOL is_cage, unsigned int& material_id_in_out, unsigned int* subset_list_out, unsigned int* subset_list_count_out)
+{
+	// Local data
+	host_map_node_s*							node;
+	host_model_s*								model;
+	unsigned int								subset_count;
+
+
+	node = host_map_find_input_node(map_id, input_index, __FUNCTION__);
+	model = node ? (is_cage ? node->cage : node->model) : 0;
+	if(!model)
+	{	return FALSE;
+	}
+
+	// Models loaded by the host have no materials, material 0 contains all subsets.
+	material_id_in_out	= 0;
+	subset_count		= (unsigned int)(model->subset_lookup_list.size() / 2);
+	if(subset_list_count_out)
+	{	*subset_list_count_out = subset_count;
+	}
+	if(subset_list_out)
+	{	for(unsigned int i=0; i<subset_count; i++)
+		{	subset_list_out[i] = i;
+		}
+	}
+	return TRUE;
+}
+
+BOOL host_mp_is_cache_enabled(void)
+{
+	return host_map_context.is_cache_enabled;
+}
+
+BOOL host_mp_register_node_cache(unsigned int node_id, unsigned int cache_type, const wchar_t* cache_name, const void* data_pointer, unsigned long long data_size)
+{
+	// Local data
+	host_node_cache_entry_s						entry;
+	std::lock_guard<std::mutex>					lock(host_map_context.cache_mutex);
+
+
+	if(!host_map_context.is_cache_enabled || node_id >= host_map_context.node_list.size() || !host_map_context.node_list[node_id])
+	{	return FALSE;
+	}
+	if(cache_type > CACHE_TYPE_CAGE || !cache_name || !data_pointer)
+	{	return FALSE;
+	}
+	for(size_t i=0; i<host_map_context.cache_list.size(); i++)
+	{	if(host_map_context.cache_list[i].node_id == node_id && host_map_context.cache_list[i].cache_name == cache_name)
+		{	return FALSE;
+		}
+	}
+
+	entry.node_id		= node_id;
+	entry.cache_type	= cache_type;
+	entry.cache_name	= cache_name;
+	entry.data_pointer	= data_pointer;
+	entry.data_size		= data_size;
+	entry.plugin		= host_map_calling_node ? host_map_calling_node->plugin : 0;
+	host_map_context.cache_list.push_back(entry);
+	return TRUE;
+}
+
+const void* host_mp_get_node_cache(unsigned int node_id, const wchar_t* cache_name)
+{
+	std::lock_guard<std::mutex> lock(host_map_context.cache_mutex);
+
+	if(!cache_name)
+	{	return 0;
+	}
+	for(size_t i=0; i<host_map_context.cache_list.size(); i++)
+	{	if(host_map_context.cache_list[i].node_id == node_id && host_map_context.cache_list[i].cache_name == cache_name)
+		{	return host_map_context.cache_list[i].data_pointer;
+		}
+	}
+	return 0;
+}
+
+BOOL host_mp_is_input_model_uvs(unsigned int map_id, unsigned int input_index, BOOL is_cage)
+{
+	host_map_node_s* node = host_map_find_input_node(map_id, input_index, __FUNCTION__);
+	host_model_s* model = node ? (is_cage ? node->cage : node->model) : 0;
+	return (model && !model->uv_list.empty()) ? TRUE : FALSE;
+}
+
+// Light scan inputs are not supported by the headless host. An empty light scan is returned.
+void host_mp_get_input_light_scan(unsigned int map_id, unsigned int input_index, light_scan_input_data_s& light_scan_data_out)
+{
+	light_scan_data_out = light_scan_input_data_s();
+	host_log("error: %s: light scan inputs are not supported by this host.", __FUNCTION__);
+}
+
+void host_mp_get_input_filter_data(unsigned int map_id, unsigned int input_index, map_input_filter_data_s& input_filter_data_out)
+{
+	host_map_node_s* node = host_map_find_node(map_id, __FUNCTION__);
+	input_filter_data_out.reset();
+	if(node && input_index < node->input_filter_list.size())
+	{	input_filter_data_out = node->input_filter_list[input_index];
+	}
+}
+
+void host_mp_get_source_input_filter_data(unsigned int map_id, map_input_filter_data_s& input_filter_data_out)
+{
+	host_map_node_s* node = host_map_find_node(map_id, __FUNCTION__);
+	input_filter_data_out.reset();
+	if(node)
+	{	input_filter_data_out = node->source_input_filter_data;
+	}
+}
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Map API - get and set property functions (600 - 617)
+
+unsigned int host_mp_get_property_pagelist(unsigned int map_id, unsigned int property_index)
+{
+	host_property_s* property = host_map_find_property(map_id, property_index, HOST_PROPERTY_PAGELIST, __FUNCTION__);
+	return property ? (unsigned int)property->value_int : 0;
+}
+
+const wchar_t* host_mp_get_property_file(unsigned int map_id, unsigned int property_index)
+{
+	host_property_s* property = host_map_find_property(map_id, property_index, HOST_PROPERTY_FILE, __FUNCTION__);
+	return property ? property->value_file.c_str() : L"";
+}
+
+BOOL host_mp_get_property_checkbox(unsigned int map_id, unsigned int property_index)
+{
+	host_property_s* property = host_map_find_property(map_id, property_index, HOST_PROPERTY_CHECKBOX, __FUNCTION__);
+	return property ? (property->value_int ? TRUE : FALSE) : FALSE;
+}
+
+unsigned int host_mp_get_property_list(unsigned int map_id, unsigned int property_index)
+{
+	host_property_s* property = host_map_find_property(map_id, property_index, HOST_PROPERTY_LIST, __FUNCTION__);
+	return property ? (unsigned int)property->value_int : 0;
+}
+
+int host_mp_get_property_numberbox_int(unsigned int map_id, unsigned int property_index)
+{
+	host_property_s* property = host_map_find_property(map_id, property_index, HOST_PROPERTY_NUMBERBOX_INT, __FUNCTION__);
+	return property ? property->value_int : 0;
+}
+
+float host_mp_get_property_numberbox_float(unsigned int map_id, unsigned int property_index)
+{
+	host_property_s* property = host_map_find_property(map_id, property_index, HOST_PROPERTY_NUMBERBOX_FLOAT, __FUNCTION__);
+	return property ? property->value_float : 0.0f;
+}
+
+COLORREF host_mp_get_property_colorbox(unsigned int map_id, unsigned int property_index)
+{
+	host_property_s* property = host_map_find_property(map_id, property_index, HOST_PROPERTY_COLORBOX, __FUNCTION__);
+	return property ? (COLORREF)property->value_int : 0;
+}
+
+int host_mp_get_property_slider(unsigned int map_id, unsigned int property_index)
+{
+	host_property_s* property = host_map_find_property(map_id, property_index, HOST_PROPERTY_SLIDER, __FUNCTION__);
+	return property ? property->value_int : 0;
+}
+
+void host_mp_get_property_range_slider(unsigned int map_id, unsigned int property_index, int& position_min_out, int& position_max_out)
+{
+	host_property_s* property = host_map_find_property(map_id, property_index, HOST_PROPERTY_RANGE_SLIDER, __FUNCTION__);
+	position_min_out = property ? property->value_int : 0;
+	position_max_out = property ? property->value_int_high : 0;
+}
+
+unsigned int host_mp_get_property_coordsys(unsigned int map_id, unsigned int property_index)
+{
+	host_property_s* property = host_map_find_property(map_id, property_index, HOST_PROPERTY_COORDSYS, __FUNCTION__);
+	return property ? (unsigned int)property->value_int : 0;
+}
+
+void host_mp_set_property_checkbox(unsigned int map_id, unsigned int property_index, BOOL check_state)
+{
+	host_property_s* property = host_map_find_property(map_id, property_index, HOST_PROPERTY_CHECKBOX, __FUNCTION__);
+	if(property)
+	{	property->value_int = check_state ? TRUE : FALSE;
+	}
+}
+
+void host_mp_set_property_list(unsigned int map_id, unsigned int property_index, unsigned int cur_sel)
+{
+	host_property_s* property = host_map_find_property(map_id, property_index, HOST_PROPERTY_LIST, __FUNCTION__);
+	if(property)
+	{	property->value_int = (int)cur_sel;
+	}
+}
+
+void host_mp_set_property_numberbox_int(unsigned int map_id, unsigned int property_index, int value)
+{
+	host_property_s* property = host_map_find_property(map_id, property_index, HOST_PROPERTY_NUMBERBOX_INT, __FUNCTION__);
+	if(property)
+	{	property->value_int = value;
+	}
+}
+
+void host_mp_set_property_numberbox_float(unsigned int map_id, unsigned int property_index, float value)
+{
+	host_property_s* property = host_map_find_property(map_id, property_index, HOST_PROPERTY_NUMBERBOX_FLOAT, __FUNCTION__);
+	if(property)
+	{	property->value_float = value;
+	}
+}
+
+void host_mp_set_property_colorbox(unsigned int map_id, unsigned int property_index, COLORREF color)
+{
+	host_property_s* property = host_map_find_property(map_id, property_index, HOST_PROPERTY_COLORBOX, __FUNCTION__);
+	if(property)
+	{	property->value_int = (int)color;
+	}
+}
+
+void host_mp_set_property_slider(unsigned int map_id, unsigned int property_index, int position)
+{
+	host_property_s* property = host_map_find_property(map_id, property_index, HOST_PROPERTY_SLIDER, __FUNCTION__);
+	if(property)
+	{	property->value_int = position;
+	}
+}
+
+void host_mp_set_property_range_slider(unsigned int map_id, unsigned int property_index, int position_min, int position_max)
+{
+	host_property_s* property = host_map_find_property(map_id, property_index, HOST_PROPERTY_RANGE_SLIDER, __FUNCTION__);
+	if(property)
+	{	property->value_int = position_min; property->value_int_high = position_max;
+	}
+}
+
+void host_mp_set_property_coordsys(unsigned int map_id, unsigned int property_index, unsigned int coordsys)
+{
+	host_property_s* property = host_map_find_property(map_id, property_index, HOST_PROPERTY_COORDSYS, __FUNCTION__);
+	if(property)
+	{	property->value_int = (int)coordsys;
+	}
+}
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Map API - process utility functions (700 - 708)
+
+BOOL host_mp_is_cancel_process(void)
+{
+	unsigned long long poll_count = ++host_map_context.cancel_poll_count;
+	if(host_map_context.cancel_after_poll_count && poll_count >= host_map_context.cancel_after_poll_count)
+	{	host_map_context.is_cancel = TRUE;
+	}
+	return host_map_context.is_cancel;
+}
+
+void host_mp_set_map_progress(unsigned int map_id, unsigned int progress)
+{
+	host_map_node_s* node = host_map_find_node(map_id, __FUNCTION__);
+	if(node)
+	{	node->progress = progress > 100 ? 100 : progress;
+		node->progress_call_count++;
+	}
+}
+
+void host_mp_set_map_progress_animation(unsigned int map_id, unsigned int progress_min, unsigned int progress_max)
+{
+	host_map_node_s* node = host_map_find_node(map_id, __FUNCTION__);
+	if(node)
+	{	node->progress = progress_min > 100 ? 100 : progress_min;
+		node->progress_call_count++;
+	}
+}
+
+void host_mp_log_map_error(unsigned int map_id, const wchar_t* error_message, const wchar_t* function, const wchar_t* source_filepath, int source_line_number)
+{
+	if(map_id < host_map_context.node_list.size() && host_map_context.node_list[map_id])
+	{	host_map_context.node_list[map_id]->error_count++;
+	}
+	host_log("error: map %u: %s [%s, %s:%d]", map_id, host_narrow(error_message).c_str(), host_narrow(function).c_str(),
+			 host_get_file_name(host_narrow(source_filepath)).c_str(), source_line_number);
+}
+
+unsigned int host_mp_get_map_thread_limit(void)
+{
+	return (host_map_calling_node && host_map_calling_node->thread_limit) ? host_map_calling_node->thread_limit : host_map_context.thread_limit;
+}
+
+void host_mp_set_map_status(unsigned int map_id, wchar_t* status_string)
+{
+	if(host_is_verbose)
+	{	host_log("map %u: %s", map_id, host_narrow(status_string).c_str());
+	}
+}
+
+// The returned pointer is owned by the host and is valid until the mask is changed.
+void host_mp_get_map_mask(unsigned int map_id, unsigned int& width_out, unsigned int& height_out, unsigned short** pixel_array_out)
+{
+	host_map_node_s* node = host_map_find_node(map_id, __FUNCTION__);
+	width_out	= node ? node->mask_width : 0;
+	height_out	= node ? node->mask_height : 0;
+	if(pixel_array_out)
+	{	*pixel_array_out = (node && !node->mask_pixel_list.empty()) ? node->mask_pixel_list.data() : 0;
+	}
+}
+
+const wchar_t* host_mp_get_map_output_filename(unsigned int map_id)
+{
+	host_map_node_s* node = host_map_find_node(map_id, __FUNCTION__);
+	return (node && !node->output_filename.empty()) ? node->output_filename.c_str() : 0;
+}
+
+void host_mp_set_map_output_filename(unsigned int map_id, const wchar_t* new_filename)
+{
+	host_map_node_s* node = host_map_find_node(map_id, __FUNCTION__);
+	if(node && new_filename)
+	{	node->output_filename = new_filename;
+	}
+}
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Map API - map creation functions (800 - 801)
+
+BOOL host_mp_create_map(unsigned int map_id, const map_create_info_s& create_info, void** pixel_array_out)
+{
+	host_map_node_s* node = host_map_find_node(map_id, __FUNCTION__);
+	if(!node)
+	{	return FALSE;
+	}
+	if(!create_info.width || !create_info.height)
+	{	host_log("error: %s: map %u has an invalid size %ux%u.", __FUNCTION__, map_id, create_info.width, create_info.height);
+		return FALSE;
+	}
+
+	// Reuse the map pixels if the size and format are unchanged - plugins may create the map at start of processing.
+	if(!node->is_created || node->image.width != create_info.width || node->image.height != create_info.height || node->image.is_grayscale != create_info.is_grayscale)
+	{	if(!node->image.allocate(create_info.width, create_info.height, create_info.is_grayscale))
+		{	host_log("error: %s: failed to allocate a %ux%u map.", __FUNCTION__, create_info.width, create_info.height);
+			node->is_created = FALSE;
+			return FALSE;
+		}
+	}
+	if(create_info.pixel_array)
+	{	memcpy(node->image.pixel_list.data(), create_info.pixel_array, (size_t)node->image.get_byte_size());
+	}
+
+	node->image.is_sRGB			= create_info.is_sRGB;
+	node->image.is_rasterized	= (node->plugin && node->plugin->info.is_normal_map) ? FALSE : TRUE;
+	node->coord_system			= create_info.coord_system;
+	node->tile_type				= create_info.tile_type;
+	node->is_created			= TRUE;
+
+	if(pixel_array_out)
+	{	*pixel_array_out = node->image.pixel_list.data();
+	}
+	return TRUE;
+}
+
+void host_mp_update_map_region(unsigned int map_id, const RECT& region)
+{
+	host_map_node_s* node = host_map_find_node(map_id, __FUNCTION__);
+	if(!node)
+	{	return;
+	}
+	if(!node->is_created || region.left < 0 || region.top < 0 || region.left > region.right || region.top > region.bottom ||
+	   (unsigned int)region.right > node->image.width || (unsigned int)region.bottom > node->image.height)
+	{	host_log("error: %s: invalid region (%d, %d, %d, %d) for map %u.", __FUNCTION__, region.left, region.top, region.right, region.bottom, map_id);
+		return;
+	}
+	node->region_update_count++;
+}
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Map host functions
+
+// Fill the function pointer array passed to "plugin_initialize()". Element numbers match "maps/map_plugin_core.cpp".
+void host_map_build_function_pointer_array(void** function_pointer_array)
+{
+	memset(function_pointer_array, 0, sizeof(void*) * HOST_FUNCTION_POINTER_COUNT);
+
+	function_pointer_array[0]	= (void*)host_mp_begin_initialize;
+	function_pointer_array[1]	= (void*)host_mp_end_initialize;
+	function_pointer_array[2]	= (void*)host_mp_define_translation_file;
+	function_pointer_array[3]	= (void*)host_mp_get_trans_string;
+	function_pointer_array[4]	= (void*)host_mp_define_help_file;
+
+	function_pointer_array[100]	= (void*)host_mp_get_option_default_tile_type;
+	function_pointer_array[101]	= (void*)host_mp_get_option_default_coord_sys;
+	function_pointer_array[102]	= (void*)host_mp_get_option_udim_u_max;
+	function_pointer_array[103]	= (void*)host_mp_get_option_udim_postfix_format;
+	function_pointer_array[104]	= (void*)host_mp_add_input;
+	function_pointer_array[105]	= (void*)host_mp_setup_source_input_filter;
+
+	function_pointer_array[200]	= (void*)host_mp_set_plugin_info;
+
+	function_pointer_array[300]	= (void*)host_mp_add_property_pagelist;
+	function_pointer_array[301]	= (void*)host_mp_add_property_file;
+	function_pointer_array[302]	= (void*)host_mp_add_property_checkbox;
+	function_pointer_array[303]	= (void*)host_mp_add_property_list;
+	function_pointer_array[304]	= (void*)host_mp_add_property_numberbox_int;
+	function_pointer_array[305]	= (void*)host_mp_add_property_numberbox_float;
+	function_pointer_array[306]	= (void*)host_mp_add_property_colorbox;
+	function_pointer_array[307]	= (void*)host_mp_add_property_slider;
+	function_pointer_array[308]	= (void*)host_mp_add_property_range_slider;
+	function_pointer_array[309]	= (void*)host_mp_add_property_coordsys;
+
+	function_pointer_array[400]	= (void*)host_mp_get_source_width;
+	function_pointer_array[401]	= (void*)host_mp_get_source_height;
+	function_pointer_array[402]	= (void*)host_mp_is_source_grayscale;
+	function_pointer_array[403]	= (void*)host_mp_is_source_rasterized;
+	function_pointer_array[404]	= (void*)host_mp_is_source_sRGB;
+	function_pointer_array[405]	= (void*)host_mp_get_source_pixel_array;
+
+	function_pointer_array[500]	= (void*)host_mp_get_input_id;
+	function_pointer_array[501]	= (void*)host_mp_get_input_width;
+	function_pointer_array[502]	= (void*)host_mp_get_input_height;
+	function_pointer_array[503]	= (void*)host_mp_get_input_coordsys;
+	function_pointer_array[504]	= (void*)host_mp_get_input_tile_type;
+	function_pointer_array[505]	= (void*)host_mp_is_input_grayscale;
+	function_pointer_array[506]	= (void*)host_mp_is_input_sRGB;
+	function_pointer_array[507]	= (void*)host_mp_get_input_pixel_array;
+	function_pointer_array[508]	= (void*)host_mp_get_input_model;
+	function_pointer_array[509]	= (void*)host_mp_get_input_model_subset_list;
+	function_pointer_array[510]	= (void*)host_mp_is_cache_enabled;
+	function_pointer_array[511]	= (void*)host_mp_register_node_cache;
+	function_pointer_array[512]	= (void*)host_mp_get_node_cache;
+	function_pointer_array[513]	= (void*)host_mp_is_input_model_uvs;
+	function_pointer_array[514]	= (void*)host_mp_get_input_light_scan;
+	function_pointer_array[515]	= (void*)host_mp_get_input_filter_data;
+	function_pointer_array[516]	= (void*)host_mp_get_source_input_filter_data;
+
+	function_pointer_array[600]	= (void*)host_mp_get_property_pagelist;
+	function_pointer_array[601]	= (void*)host_mp_get_property_file;
+	function_pointer_array[602]	= (void*)host_mp_get_property_checkbox;
+	function_pointer_array[603]	= (void*)host_mp_get_property_list;
+	function_pointer_array[604]	= (void*)host_mp_get_property_numberbox_int;
+	function_pointer_array[605]	= (void*)host_mp_get_property_numberbox_float;
+	function_pointer_array[606]	= (void*)host_mp_get_property_colorbox;
+	function_pointer_array[607]	= (void*)host_mp_get_property_slider;
+	function_pointer_array[608]	= (void*)host_mp_get_property_range_slider;
+	function_pointer_array[609]	= (void*)host_mp_get_property_coordsys;
+	function_pointer_array[610]	= (void*)host_mp_set_property_checkbox;
+	function_pointer_array[611]	= (void*)host_mp_set_property_list;
+	function_pointer_array[612]	= (void*)host_mp_set_property_numberbox_int;
+	function_pointer_array[613]	= (void*)host_mp_set_property_numberbox_float;
+	function_pointer_array[614]	= (void*)host_mp_set_property_colorbox;
+	function_pointer_array[615]	= (void*)host_mp_set_property_slider;
+	function_pointer_array[616]	= (void*)host_mp_set_property_range_slider;
+	function_pointer_array[617]	= (void*)host_mp_set_property_coordsys;
+
+	function_pointer_array[700]	= (void*)host_mp_is_cancel_process;
+	function_pointer_array[701]	= (void*)host_mp_set_map_progress;
+	function_pointer_array[702]	= (void*)host_mp_set_map_progress_animation;
+	function_pointer_array[703]	= (void*)host_mp_log_map_error;
+	function_pointer_array[704]	= (void*)host_mp_get_map_thread_limit;
+	function_pointer_array[705]	= (void*)host_mp_set_map_status;
+	function_pointer_array[706]	= (void*)host_mp_get_map_mask;
+	function_pointer_array[707]	= (void*)host_mp_get_map_output_filename;
+	function_pointer_array[708]	= (void*)host_mp_set_map_output_filename;
+
+	function_pointer_array[800]	= (void*)host_mp_create_map;
+	function_pointer_array[801]	= (void*)host_mp_update_map_region;
+}
+
+// Load and initialize a map plugin. Returns 0 and logs an error on failure.
+host_map_plugin_s* host_map_load_plugin(const char* file_path)
+{
+	// Local data
+	host_map_plugin_s*							plugin;
+	void*										function_pointer_array[HOST_FUNCTION_POINTER_COUNT];
+	host_property_s								mask_property;
+	BOOL										is_success;
+
+
+	plugin = new host_map_plugin_s;
+	if(!host_load_library(file_path, plugin->library))
+	{	delete plugin;
+		return 0;
+	}
+
+	host_map_build_function_pointer_array(function_pointer_array);
+	host_map_context.initializing_plugin = plugin;
+	is_success = plugin->library.plugin_initialize(function_pointer_array);
+	host_map_context.initializing_plugin = 0;
+	if(!is_success)
+	{	host_log("error: \"%s\" failed to initialize.", file_path);
+		host_unload_library(plugin->library);
+		delete plugin;
+		return 0;
+	}
+	plugin->is_initialized = TRUE;
+
+	// ShaderMap adds 2 mask checkboxes after the plugin properties of every map type plugin - Use Mask and Invert Mask.
+	if(plugin->info.type == MAP_PLUGIN_TYPE_MAP)
+	{	mask_property.type			= HOST_PROPERTY_CHECKBOX;
+		mask_property.page_index	= plugin->property_list.empty() ? 0 : plugin->property_list.back().page_index;
+		mask_property.caption		= L"Use Mask";
+		mask_property.value_int		= TRUE;
+		plugin->property_list.push_back(mask_property);
+		mask_property.caption		= L"Invert Mask";
+		mask_property.value_int		= FALSE;
+		plugin->property_list.push_back(mask_property);
+	}
+
+	host_map_context.plugin_list.push_back(plugin);
+	return plugin;
+}
+
+// Add a node to the project. The node is owned by the context.
+host_map_node_s* host_map_add_node(host_map_plugin_s* plugin)
+{
+	host_map_node_s* node = new host_map_node_s;
+	node->id		= (unsigned int)host_map_context.node_list.size();
+	node->plugin	= plugin;
+	if(plugin)
+	{	node->property_list	= plugin->property_list;
+		node->source_input_filter_data = plugin->default_source_input_filter_data;
+		for(size_t i=0; i<plugin->input_list.size(); i++)
+		{	node->input_filter_list.push_back(plugin->input_list[i].default_input_filter_data);
+		}
+	}
+	host_map_context.node_list.push_back(node);
+	return node;
+}
+
+// Release node cache entries of a node and notify every plugin so that it frees its cached data.
+// A node_id of UINT_MAX clears all entries.
+void host_map_clear_node_cache(unsigned int node_id, unsigned int cache_type)
+{
+	// Local data
+	std::vector<host_node_cache_entry_s>		kept_list;
+
+
+	{	std::lock_guard<std::mutex> lock(host_map_context.cache_mutex);
+		for(size_t i=0; i<host_map_context.cache_list.size(); i++)
+		{	const host_node_cache_entry_s& entry = host_map_context.cache_list[i];
+			if((node_id != UINT_MAX && entry.node_id != node_id) || (cache_type != CACHE_TYPE_ANY && entry.cache_type != cache_type))
+			{	kept_list.push_back(entry);
+			}
+		}
+		host_map_context.cache_list.swap(kept_list);
+	}
+
+	for(size_t i=0; i<host_map_context.plugin_list.size(); i++)
+	{	host_plugin_custom_type on_node_cache_clear = host_map_context.plugin_list[i]->library.plugin_custom[2];
+		if(on_node_cache_clear)
+		{	if(node_id == UINT_MAX)
+			{	for(unsigned int id=0; id<host_map_context.node_list.size(); id++)
+				{	unsigned int type = cache_type;
+					on_node_cache_clear(&id, &type, 0);
+				}
+			}
+			else
+			{	unsigned int id = node_id, type = cache_type;
+				on_node_cache_clear(&id, &type, 0);
+			}
+		}
+	}
+}
+
+// Return the total size in bytes of registered node cache data.
+unsigned long long host_map_get_node_cache_size(void)
+{
+	std::lock_guard<std::mutex>	lock(host_map_context.cache_mutex);
+	unsigned long long			size = 0;
+
+	for(size_t i=0; i<host_map_context.cache_list.size(); i++)
+	{	size += host_map_context.cache_list[i].data_size;
+	}
+	return size;
+}
+
+// Process a map plugin node. Returns the result of "on_process()".
+BOOL host_map_process_node(host_map_node_s* node)
+{
+	// Local data
+	unsigned int								map_id;
+	BOOL										is_success;
+
+
+	// Each process creates a new map the same as ShaderMap does on a re-render.
+	map_id				= node->id;
+	node->is_created	= FALSE;
+	node->reset_statistics();
+	host_map_calling_node = node;
+	is_success = node->plugin->library.plugin_process(&map_id, 0);
+	host_map_calling_node = 0;
+	return is_success;
+}
+
+// Shutdown all plugins and release all nodes.
+void host_map_shutdown(void)
+{
+	host_map_clear_node_cache(UINT_MAX, CACHE_TYPE_ANY);
+	for(size_t i=0; i<host_map_context.node_list.size(); i++)
+	{	delete host_map_context.node_list[i];
+	}
+	host_map_context.node_list.clear();
+	for(size_t i=0; i<host_map_context.plugin_list.size(); i++)
+	{	host_unload_library(host_map_context.plugin_list[i]->library);
+		delete host_map_context.plugin_list[i];
+	}
+	host_map_context.plugin_list.clear();
+	parallel_shutdown();
+}
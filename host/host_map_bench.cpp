@@ -0,0 +1,453 @@
+/*
+	===============================================================
+
+	SHADERMAP HEADLESS HOST - MAP BENCHMARK
+
+	A command line host that loads a single map plugin built as a
+	Linux shared object, feeds it inputs from files and runs
+	"on_process()" a number of times, reporting wall time,
+	megapixels per second and peak resident memory for each run.
+
+	This is intended for regression testing and performance work
+	on map plugins without ShaderMap, for example on render nodes
+	or in continuous integration.
+
+	--
+
+	BUILD (from the SDK root folder)
+
+	Plugin:
+	g++ -std=c++11 -O2 -shared -fPIC -fvisibility=hidden -I host/compat maps/examples/map_color_to_ts_normal/map_color_to_ts_normal.cpp -o map_color_to_ts_normal.so
+
+	-fvisibility=hidden exports only the DLL_EXPORT plugin functions,
+	the same as a Windows DLL. Without it GCC can not inline the
+	plugin's own helper functions in a -fPIC build.
+
+	Host:
+	g++ -std=c++11 -O2 -I host/compat host/host_map_bench.cpp -o host_map_bench -ldl -lz -pthread
+
+	--
+
+	USAGE
+
+	host_map_bench PLUGIN.so [options]
+	host_map_bench --check
+
+	--source FILE			Source image of a source type plugin.
+	--input FILE			Add an input in plugin input order. A PNG, EXR
+							or synthetic image for map inputs or a CUSTOM
+							file for 3D model inputs.
+	--cage FILE				Cage model (CUSTOM) for the model input given
+							just before it, or the last model input if
+							it is given before any --input.
+	--mask FILE				Mask image of the map.
+	--prop INDEX=VALUE		Set a property, see --list for indices.
+	--threads N				Value returned by mp_get_map_thread_limit().
+							Default is the number of hardware threads.
+	--warmup N				Untimed runs before measuring. Default 1.
+	--iterations N			Timed runs. Default 5.
+	--cancel-after N		Report cancel after N calls to
+							mp_is_cancel_process() in each run.
+	--no-cache				Report the node cache as disabled.
+	--output FILE.exr		Save the map created by the last run.
+	--csv FILE				Append one line per timed run to a CSV file.
+	--list					Print plugin info and properties then exit.
+	--verbose				Print map status messages.
+	--check					Check the shared plugin code that needs no
+							plugin, such as the mask hash of
+							"plugin_mask.cpp", then exit.
+
+	Images can be given as "synthetic:WIDTHxHEIGHT" or
+	"synthetic_gray:WIDTHxHEIGHT", see "host_image.cpp".
+
+	Example:
+	./host_map_bench map_color_to_ts_normal.so --input synthetic:4096x4096 --prop 0=150 --iterations 10 --output normal.exr
+
+	Peak memory is measured per run by resetting the kernel high
+	water mark (/proc/self/clear_refs) before each run. It includes
+	the memory held by the host for inputs and outputs.
+
+	Exit code is 0 if every run succeeded, 1 otherwise. With --check
+	it is 0 if every check passed, 1 otherwise.
+
+
+	SHADERMAP SDK LICENSE
+
+	The ShaderMap SDK is released under The MIT License (MIT)
+	http://opensource.org/licenses/MIT
+
+	Copyright (c) 2007-2019 Rendering Systems Inc.
+
+	See "host_common.cpp" for the full license text.
+
+	===============================================================
+*/
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Host includes
+
+#define SMSDK_HOST
+#include "../maps/map_plugin_core.cpp"
+#include "host_common.cpp"
+#include "host_image.cpp"
+#include "host_model.cpp"
+#include "host_map_api.cpp"
+#include "../common/plugin_mask.cpp"
+#include <thread>
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Benchmark
+
+// Command line options.
+struct host_map_bench_options_s
+{
+	std::string									plugin_path;
+	std::string									source_path;
+	std::vector<std::string>					input_path_list;
+	std::string									cage_path;
+	int											cage_input;				// Input given before --cage, -1 for the last model input.
+	std::string									mask_path;
+	std::vector<std::string>					property_list;
+	std::string									output_path;
+	std::string									csv_path;
+	unsigned int								thread_limit;
+	unsigned int								warmup_count;
+	unsigned int								iteration_count;
+	unsigned long long							cancel_after_poll_count;
+	BOOL										is_cache_enabled;
+	BOOL										is_list;
+	BOOL										is_check;
+
+	// c()
+	host_map_bench_options_s(void)
+	{	thread_limit			= std::max(1u, std::thread::hardware_concurrency());
+		warmup_count			= 1;
+		iteration_count			= 5;
+		cancel_after_poll_count	= 0;
+		cage_input				= -1;
+		is_cache_enabled		= TRUE;
+		is_list					= FALSE;
+		is_check				= FALSE;
+	}
+};
+
+// Print usage.
+void host_map_bench_usage(void)
+{
+	fprintf(stderr,
+		"usage: host_map_bench PLUGIN.so [--source FILE] [--input FILE]... [--cage FILE] [--mask FILE]\n"
+		"                      [--prop INDEX=VALUE]... [--threads N] [--warmup N] [--iterations N]\n"
+		"                      [--cancel-after N] [--no-cache] [--output FILE.exr] [--csv FILE] [--list] [--verbose]\n"
+		"       host_map_bench --check\n");
+}
+
+// Parse the command line. Returns FALSE on invalid arguments.
+BOOL host_map_bench_parse(int argc, char** argv, host_map_bench_options_s& options_out)
+{
+	for(int i=1; i<argc; i++)
+	{
+		std::string argument = argv[i];
+		BOOL		is_value = (i + 1 < argc);
+
+		if(argument == "--source" && is_value)				{ options_out.source_path = argv[++i]; }
+		else if(argument == "--input" && is_value)			{ options_out.input_path_list.push_back(argv[++i]); }
+		else if(argument == "--cage" && is_value)			{ options_out.cage_path = argv[++i]; options_out.cage_input = (int)options_out.input_path_list.size() - 1; }
+		else if(argument == "--mask" && is_value)			{ options_out.mask_path = argv[++i]; }
+		else if(argument == "--prop" && is_value)			{ options_out.property_list.push_back(argv[++i]); }
+		else if(argument == "--threads" && is_value)		{ options_out.thread_limit = std::max(1, atoi(argv[++i])); }
+		else if(argument == "--warmup" && is_value)			{ options_out.warmup_count = (unsigned int)std::max(0, atoi(argv[++i])); }
+		else if(argument == "--iterations" && is_value)		{ options_out.iteration_count = (unsigned int)std::max(1, atoi(argv[++i])); }
+		else if(argument == "--cancel-after" && is_value)	{ options_out.cancel_after_poll_count = strtoull(argv[++i], 0, 10); }
+		else if(argument == "--output" && is_value)			{ options_out.output_path = argv[++i]; }
+		else if(argument == "--csv" && is_value)			{ options_out.csv_path = argv[++i]; }
+		else if(argument == "--no-cache")					{ options_out.is_cache_enabled = FALSE; }
+		else if(argument == "--list")						{ options_out.is_list = TRUE; }
+		else if(argument == "--verbose")					{ host_is_verbose = TRUE; }
+		else if(argument == "--check")						{ options_out.is_check = TRUE; }
+		else if(argument[0] != '-' && options_out.plugin_path.empty())
+		{	options_out.plugin_path = argument;
+		}
+		else
+		{	host_log("error: unknown or incomplete argument \"%s\".", argument.c_str());
+			return FALSE;
+		}
+	}
+	return options_out.is_check || !options_out.plugin_path.empty();
+}
+
+// Create the input nodes of a map node from files. Returns FALSE on failure.
+BOOL host_map_bench_setup_inputs(host_map_node_s* map_node, const host_map_bench_options_s& options)
+{
+	// Local data
+	host_map_plugin_s*							plugin;
+	host_map_node_s*							input_node;
+	int											last_model_input;
+
+
+	plugin = map_node->plugin;
+	if(options.input_path_list.size() != plugin->input_list.size())
+	{	host_log("error: the plugin has %u inputs but %u were given with --input.", (unsigned int)plugin->input_list.size(), (unsigned int)options.input_path_list.size());
+		return FALSE;
+	}
+
+	last_model_input = -1;
+	for(size_t i=0; i<plugin->input_list.size(); i++)
+	{
+		const char* input_path = options.input_path_list[i].c_str();
+
+		input_node = host_map_add_node(0);
+		map_node->input_id_list.push_back(input_node->id);
+
+		switch(plugin->input_list[i].type)
+		{
+		case MAP_INPUT_TYPE_MAP:
+			if(!host_load_image(input_path, input_node->image))
+			{	return FALSE;
+			}
+			input_node->is_created		= TRUE;
+			input_node->coord_system	= host_map_context.option_default_coord_sys;
+			input_node->tile_type		= host_map_context.option_default_tile_type;
+			break;
+
+		case MAP_INPUT_TYPE_MODEL:
+			input_node->model = new host_model_s;
+			if(!host_load_custom_model(input_path, *input_node->model))
+			{	return FALSE;
+			}
+			last_model_input = (int)i;
+			break;
+
+		default:
+			host_log("error: input %u \"%s\" is a light scan input which is not supported by this host.", (unsigned int)i, host_narrow(plugin->input_list[i].name.c_str()).c_str());
+			return FALSE;
+		}
+	}
+
+	if(!options.cage_path.empty())
+	{	if(last_model_input < 0)
+		{	host_log("error: --cage was given but the plugin has no 3D model input.");
+			return FALSE;
+		}
+		if(options.cage_input >= 0)
+		{	if(plugin->input_list[options.cage_input].type != MAP_INPUT_TYPE_MODEL)
+			{	host_log("error: --cage was given after input %d which is not a 3D model input.", options.cage_input);
+				return FALSE;
+			}
+			last_model_input = options.cage_input;
+		}
+		input_node = host_map_context.node_list[map_node->input_id_list[last_model_input]];
+		input_node->cage = new host_model_s;
+		if(!host_load_custom_model(options.cage_path.c_str(), *input_node->cage))
+		{	return FALSE;
+		}
+	}
+
+	return TRUE;
+}
+
+// Print plugin info, inputs and properties.
+void host_map_bench_print_plugin(const host_map_plugin_s* plugin, const std::vector<host_property_s>& property_list)
+{
+	printf("plugin      %s\n", plugin->library.file_path.c_str());
+	printf("name        %s (version %u, SDK %u.%u, %s%s)\n", host_narrow(plugin->name.c_str()).c_str(), plugin->info.version,
+		   plugin->library.sdk_version_major, plugin->library.sdk_version_minor,
+		   plugin->info.type == MAP_PLUGIN_TYPE_SOURCE ? "source" : "map", plugin->info.is_normal_map ? ", normal map" : "");
+	for(size_t i=0; i<plugin->input_list.size(); i++)
+	{	printf("  input %u   %-6s \"%s\"\n", (unsigned int)i,
+			   plugin->input_list[i].type == MAP_INPUT_TYPE_MAP ? "map" : (plugin->input_list[i].type == MAP_INPUT_TYPE_MODEL ? "model" : "light"),
+			   host_narrow(plugin->input_list[i].name.c_str()).c_str());
+	}
+	host_print_property_list(property_list);
+}
+
+// Check the mask hash. Every bit of one pixel is flipped at each pixel index (every index mod 16 of the
+// 16 pixel blocks and the pixels after the last block) and the hash must change. Returns the number of failures.
+unsigned int host_map_bench_check_mask_hash(void)
+{
+	// Local data
+	std::vector<unsigned short>					pixel_list(16 * 4 + 5);
+	unsigned long long							base_hash;
+	unsigned int								fail_count, random;
+
+
+	random = 12345;
+	for(size_t i=0; i<pixel_list.size(); i++)
+	{	random			= random * 1103515245u + 12345u;
+		pixel_list[i]	= (unsigned short)(random >> 16);
+	}
+	base_hash = plugin_mask_hash(&pixel_list[0], pixel_list.size());
+
+	fail_count = 0;
+	for(size_t i=0; i<pixel_list.size(); i++)
+	{	for(unsigned int bit=0; bit<16; bit++)
+		{	pixel_list[i] ^= (unsigned short)(1u << bit);
+			if(plugin_mask_hash(&pixel_list[0], pixel_list.size()) == base_hash)
+			{	host_log("error: mask hash did not change when bit %u of pixel %u was flipped.", bit, (unsigned int)i);
+				fail_count++;
+			}
+			pixel_list[i] ^= (unsigned short)(1u << bit);
+		}
+	}
+	if(plugin_mask_hash(&pixel_list[0], pixel_list.size() - 1) == base_hash)
+	{	host_log("error: mask hash did not change with the pixel count.");
+		fail_count++;
+	}
+
+	printf("check mask hash  %s\n", fail_count ? "fail" : "ok");
+	return fail_count;
+}
+
+// Entry point.
+int main(int argc, char** argv)
+{
+	// Local data
+	host_map_bench_options_s					options;
+	host_map_plugin_s*							plugin;
+	host_map_node_s*							map_node;
+	host_sample_list_s							time_list, mpix_list, rss_list;
+	FILE*										csv_fp;
+	unsigned long long							setup_rss;
+	unsigned int								fail_count;
+	BOOL										is_success, is_rss_reset;
+	double										time_start, time_ms, mpix;
+
+
+	setlocale(LC_ALL, "");
+	if(!host_map_bench_parse(argc, argv, options))
+	{	host_map_bench_usage();
+		return 1;
+	}
+
+	if(options.is_check)
+	{	return host_map_bench_check_mask_hash() ? 1 : 0;
+	}
+
+	host_map_context.thread_limit				= options.thread_limit;
+	host_map_context.is_cache_enabled			= options.is_cache_enabled;
+	host_map_context.cancel_after_poll_count	= options.cancel_after_poll_count;
+
+	// Load the plugin and create its node.
+	plugin = host_map_load_plugin(options.plugin_path.c_str());
+	if(!plugin)
+	{	return 1;
+	}
+	map_node = host_map_add_node(plugin);
+
+	for(size_t i=0; i<options.property_list.size(); i++)
+	{	if(!host_apply_property_override(map_node->property_list, options.property_list[i].c_str()))
+		{	host_map_shutdown();
+			return 1;
+		}
+	}
+
+	if(options.is_list)
+	{	host_map_bench_print_plugin(plugin, map_node->property_list);
+		host_map_shutdown();
+		return 0;
+	}
+
+	// Load inputs, source and mask.
+	is_success = host_map_bench_setup_inputs(map_node, options);
+	if(is_success && plugin->info.type == MAP_PLUGIN_TYPE_SOURCE)
+	{	if(options.source_path.empty())
+		{	host_log("error: the plugin is a source map, use --source to set the source image.");
+			is_success = FALSE;
+		}
+		else
+		{	is_success = host_load_image(options.source_path.c_str(), map_node->source_image);
+		}
+	}
+	if(is_success && !options.mask_path.empty())
+	{	is_success = host_load_mask(options.mask_path.c_str(), map_node->mask_width, map_node->mask_height, map_node->mask_pixel_list);
+	}
+	if(!is_success)
+	{	host_map_shutdown();
+		return 1;
+	}
+
+	host_map_bench_print_plugin(plugin, map_node->property_list);
+	printf("threads     %u\n", options.thread_limit);
+	setup_rss = host_get_current_rss();
+
+	csv_fp = 0;
+	if(!options.csv_path.empty())
+	{	csv_fp = fopen(options.csv_path.c_str(), "a");
+		if(!csv_fp)
+		{	host_log("error: failed to open \"%s\".", options.csv_path.c_str());
+		}
+		else if(ftell(csv_fp) == 0)
+		{	fprintf(csv_fp, "plugin,threads,iteration,result,width,height,time_ms,mpix_per_s,peak_rss_mb,cancel_polls,progress_calls,region_updates\n");
+		}
+	}
+
+	// Run.
+	fail_count = 0;
+	is_rss_reset = TRUE;
+	for(unsigned int i=0; i<options.warmup_count + options.iteration_count; i++)
+	{
+		BOOL is_warmup = (i < options.warmup_count);
+
+		host_map_context.is_cancel			= FALSE;
+		host_map_context.cancel_poll_count	= 0;
+		is_rss_reset = host_reset_peak_rss();
+
+		time_start	= host_get_time();
+		is_success	= host_map_process_node(map_node);
+		time_ms		= (host_get_time() - time_start) * 1000.0;
+
+		unsigned long long peak_rss = host_get_peak_rss();
+		mpix = map_node->is_created ? (double)map_node->image.width * map_node->image.height / 1.0e6 : 0.0;
+
+		if(!is_success || !map_node->is_created)
+		{	fail_count += is_warmup ? 0 : 1;
+		}
+		if(is_warmup)
+		{	continue;
+		}
+
+		time_list.add(time_ms);
+		mpix_list.add(time_ms > 0.0 ? mpix / (time_ms / 1000.0) : 0.0);
+		rss_list.add(peak_rss / 1048576.0);
+
+		printf("run %3u  %-7s  %ux%u  %10.2f ms  %9.2f MPix/s  peak %8.1f MB%s  polls %llu  progress %u  regions %u\n", i - options.warmup_count,
+			   is_success ? (map_node->is_created ? "ok" : "no map") : (host_map_context.is_cancel ? "cancel" : "fail"),
+			   map_node->image.width, map_node->image.height, time_ms, mpix_list.sample_list.back(), rss_list.sample_list.back(),
+			   is_rss_reset ? "" : "*", (unsigned long long)host_map_context.cancel_poll_count,
+			   (unsigned int)map_node->progress_call_count, (unsigned int)map_node->region_update_count);
+
+		if(csv_fp)
+		{	fprintf(csv_fp, "%s,%u,%u,%d,%u,%u,%.3f,%.3f,%.1f,%llu,%u,%u\n", host_get_file_name(options.plugin_path).c_str(), options.thread_limit,
+					i - options.warmup_count, is_success ? 1 : 0, map_node->image.width, map_node->image.height, time_ms,
+					mpix_list.sample_list.back(), rss_list.sample_list.back(), (unsigned long long)host_map_context.cancel_poll_count,
+					(unsigned int)map_node->progress_call_count, (unsigned int)map_node->region_update_count);
+		}
+	}
+
+	printf("time ms     min %.2f  median %.2f  mean %.2f  max %.2f\n", time_list.min(), time_list.median(), time_list.mean(), time_list.max());
+	printf("MPix/s      min %.2f  median %.2f  mean %.2f  max %.2f\n", mpix_list.min(), mpix_list.median(), mpix_list.mean(), mpix_list.max());
+	printf("peak MB     min %.1f  median %.1f  max %.1f  (after setup %.1f%s)\n", rss_list.min(), rss_list.median(), rss_list.max(), setup_rss / 1048576.0,
+		   is_rss_reset ? "" : ", * peak could not be reset - lifetime peak shown");
+	printf("node cache  %.1f MB registered\n", host_map_get_node_cache_size() / 1048576.0);
+
+	if(csv_fp)
+	{	fclose(csv_fp);
+	}
+
+	// Save the last map.
+	if(!options.output_path.empty())
+	{	if(!map_node->is_created)
+		{	host_log("error: no map was created, \"%s\" not saved.", options.output_path.c_str());
+			fail_count++;
+		}
+		else if(!host_save_exr(options.output_path.c_str(), map_node->image))
+		{	fail_count++;
+		}
+	}
+
+	host_map_shutdown();
+	return fail_count ? 1 : 0;
+}
@@ -0,0 +1,192 @@
+/*
+	===============================================================
+
+	SHADERMAP HEADLESS HOST - MODEL SOURCE FILE
+
+	Loads 3D model inputs for the headless map host. Models are
+	read from the CUSTOM binary format used by the geo_custom
+	example plugin (see "geometry/examples/geo_custom") and are
+	returned to map plugins as "model_input_data_s".
+
+	The CUSTOM file contains:
+
+		unsigned int vertex_count
+		unsigned int uv_count
+		unsigned int index_count
+		vertex_s * vertex_count			// Position XYZ, Normal XYZ.
+		vector_2_s * uv_count			// UV.
+		unsigned int * index_count		// 7 per triangle - Vertex ABC, UV ABC, start index.
+
+	The file has no subsets, materials or tangents. The host
+	creates a single subset, a gray color for every triangle and
+	per triangle corner MikkTSpace tangents (see
+	"maps/map_model_tangent_space.cpp"). A file written without
+	normals has a zero normal at each vertex, the host then
+	replaces all normals with smooth normals creased at 60 degrees.
+	They point along cross(b - a, c - a) of each triangle a, b, c.
+
+	Include after "host_common.cpp" and a map plugin core.
+
+
+	SHADERMAP SDK LICENSE
+
+	The ShaderMap SDK is released under The MIT License (MIT)
+	http://opensource.org/licenses/MIT
+
+	Copyright (c) 2007-2019 Rendering Systems Inc.
+
+	See "host_common.cpp" for the full license text.
+
+	===============================================================
+*/
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Model includes
+
+#include "../maps/map_model_tangent_space.cpp"
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Model structs
+
+// A loaded 3D model. Owns the arrays that "model_input_data_s" points to.
+struct host_model_s
+{
+	std::vector<model_input_vertex_s>			vertex_list;
+	std::vector<model_input_vector2_s>			uv_list;
+	std::vector<model_input_tangent_s>			tangent_list;			// 3 per triangle.
+	std::vector<unsigned int>					index_list;				// 7 per triangle.
+	std::vector<unsigned int>					subset_lookup_list;		// 2 per subset.
+	std::vector<unsigned int>					triangle_color_list;	// 1 per triangle.
+
+	// Return the number of triangles.
+	unsigned int get_triangle_count(void) const
+	{	return (unsigned int)(index_list.size() / 7);
+	}
+
+	// Return the size of the model arrays in bytes.
+	unsigned long long get_byte_size(void) const
+	{	return vertex_list.size() * sizeof(model_input_vertex_s) + uv_list.size() * sizeof(model_input_vector2_s) +
+			   tangent_list.size() * sizeof(model_input_tangent_s) + (index_list.size() + subset_lookup_list.size() + triangle_color_list.size()) * sizeof(unsigned int);
+	}
+
+	// Fill a "model_input_data_s" with pointers to this model.
+	void get_input_data(model_input_data_s& model_data_out) const
+	{	model_data_out.vertex_count			= (unsigned int)vertex_list.size();
+		model_data_out.uv_count				= (unsigned int)uv_list.size();
+		model_data_out.index_count			= (unsigned int)index_list.size();
+		model_data_out.subset_count			= (unsigned int)(subset_lookup_list.size() / 2);
+		model_data_out.vertex_array			= vertex_list.data();
+		model_data_out.uv_array				= uv_list.data();
+		model_data_out.tangent_array		= tangent_list.data();
+		model_data_out.index_array			= index_list.data();
+		model_data_out.subset_lookup_table	= subset_lookup_list.data();
+		model_data_out.triangle_color_array	= triangle_color_list.data();
+	}
+};
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Model functions
+
+// Compute the MikkTSpace tangent of each triangle corner on all cores. Bi-Normal = cross(N, T.xyz) * T.w. Returns
+// FALSE and logs an error if out of memory.
+BOOL host_compute_model_tangents(host_model_s& model)
+{
+	try
+	{	model.tangent_list.resize((size_t)model.get_triangle_count() * 3);
+	}
+	catch(const std::bad_alloc&)
+	{	host_log("error: failed to allocate model tangents.");
+		return FALSE;
+	}
+	if(!model_create_tangents(model.vertex_list.data(), (unsigned int)model.vertex_list.size(), model.uv_list.data(), (unsigned int)model.uv_list.size(),
+							  model.index_list.data(), (unsigned int)model.index_list.size(), model.tangent_list.data()))
+	{	host_log("error: failed to compute model tangents.");
+		return FALSE;
+	}
+	return TRUE;
+}
+
+// Replace the normals of a model with smooth normals if any vertex has a zero normal. Returns FALSE and logs an error if
+// out of memory.
+BOOL host_compute_model_normals(host_model_s& model, const char* file_path)
+{
+	for(size_t i=0; i<model.vertex_list.size(); i++)
+	{	const model_input_vector3_s& normal = model.vertex_list[i].normal;
+		if(normal.x != 0.0f || normal.y != 0.0f || normal.z != 0.0f)
+		{	continue;
+		}
+		if(host_is_verbose)
+		{	host_log("\"%s\" has vertices with no normal, creating smooth normals.", file_path);
+		}
+		if(!model_create_normals(model.vertex_list, model.index_list.data(), (unsigned int)model.index_list.size(), 60.0f, MODEL_NORMALS_WEIGHT_ANGLE))
+		{	host_log("error: failed to compute model normals.");
+			return FALSE;
+		}
+		break;
+	}
+	return TRUE;
+}
+
+// Load a CUSTOM model file. Returns FALSE and logs an error on failure.
+BOOL host_load_custom_model(const char* file_path, host_model_s& model_out)
+{
+	// Local data
+	FILE*										fp;
+	unsigned int								count_array[3];
+	BOOL										is_success;
+
+
+	fp = fopen(file_path, "rb");
+	if(!fp)
+	{	host_log("error: failed to open model \"%s\".", file_path);
+		return FALSE;
+	}
+	if(fread(count_array, sizeof(unsigned int), 3, fp) != 3 || !count_array[0] || !count_array[1] || !count_array[2] || count_array[2] % 7)
+	{	host_log("error: \"%s\" is not a valid CUSTOM model.", file_path);
+		fclose(fp);
+		return FALSE;
+	}
+
+	try
+	{	model_out.vertex_list.resize(count_array[0]);
+		model_out.uv_list.resize(count_array[1]);
+		model_out.index_list.resize(count_array[2]);
+	}
+	catch(const std::bad_alloc&)
+	{	host_log("error: failed to allocate model \"%s\".", file_path);
+		fclose(fp);
+		return FALSE;
+	}
+
+	is_success = fread(model_out.vertex_list.data(), sizeof(model_input_vertex_s), count_array[0], fp) == count_array[0] &&
+				 fread(model_out.uv_list.data(), sizeof(model_input_vector2_s), count_array[1], fp) == count_array[1] &&
+				 fread(model_out.index_list.data(), sizeof(unsigned int), count_array[2], fp) == count_array[2];
+	fclose(fp);
+	if(!is_success)
+	{	host_log("error: \"%s\" is truncated.", file_path);
+		return FALSE;
+	}
+
+	// Validate indices so that plugins can trust them.
+	for(size_t i=0; i<model_out.index_list.size(); i+=7)
+	{	for(unsigned int c=0; c<3; c++)
+		{	if(model_out.index_list[i + c] >= count_array[0] || model_out.index_list[i + 3 + c] >= count_array[1])
+			{	host_log("error: \"%s\" has an out of range index at triangle %u.", file_path, (unsigned int)(i / 7));
+				return FALSE;
+			}
+		}
+	}
+
+	// One subset with all triangles and a gray color per triangle.
+	model_out.subset_lookup_list.assign(2, 0);
+	model_out.subset_lookup_list[1] = model_out.get_triangle_count();
+	model_out.triangle_color_list.assign(model_out.get_triangle_count(), RGB(128, 128, 128));
+
+	return host_compute_model_normals(model_out, file_path) && host_compute_model_tangents(model_out);
+}
@@ -0,0 +1,478 @@
+/*
+	===============================================================
+
+	SHADERMAP HEADLESS HOST - PROJECT SOURCE FILE
+
+	Reads ShaderMap project files (*.smpx) and builds the node
+	graph they describe. A project is an XML file with a header
+	and one element per node:
+
+	<node_N>
+		<node_type v="1" />							1 for map nodes.
+		<plugin_file_name v="NAME.smp" />
+		<plugin_type v="0" />						0 source, 1 map.
+		<input_index_list v="A;B" />				Project node of each plugin input.
+		<prop_count v="3" />
+		<prop_I type="T" value="V" />				Property values in plugin order.
+		<coord_system v="26" />
+		<tile_type v="0" />
+		<source_file_path v="FILE" />				Source image of source nodes.
+		<map_mask i="-1" f="FILE" />
+		<pre_filter_count v="1" />
+		<pre_filter_I>								Same plugin_file_name and prop_I
+		...											elements as a node.
+		<post_filter_count v="1" />
+		<post_filter_I> ...
+	</node_N>
+
+	The property "type" in a project file is ShaderMap's own
+	property id and is not the same as the HOST_PROPERTY_ types.
+	Values are applied in plugin property order and interpreted
+	with the property type the plugin defines.
+
+	Include after "host_common.cpp" and "host_image.cpp".
+
+
+	SHADERMAP SDK LICENSE
+
+	The ShaderMap SDK is released under The MIT License (MIT)
+	http://opensource.org/licenses/MIT
+
+	Copyright (c) 2007-2019 Rendering Systems Inc.
+
+	See "host_common.cpp" for the full license text.
+
+	===============================================================
+*/
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Project defines
+
+// Node types in project files.
+#define HOST_PROJECT_NODE_TYPE_MAP				1
+
+// Plugin types in project files - same as MAP_PLUGIN_TYPE_.
+#define HOST_PROJECT_PLUGIN_TYPE_SOURCE			0
+#define HOST_PROJECT_PLUGIN_TYPE_MAP			1
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Project structs
+
+// An XML element with its attributes and child elements. Text content is not kept, project files store values in attributes.
+struct host_xml_element_s
+{
+	std::string									name;
+	std::vector<std::pair<std::string, std::string> >	attribute_list;
+	std::vector<host_xml_element_s>				child_list;
+
+	// Return the first child element with a name or 0.
+	const host_xml_element_s* find_child(const std::string& child_name) const
+	{	for(size_t i=0; i<child_list.size(); i++)
+		{	if(child_list[i].name == child_name)
+			{	return &child_list[i];
+			}
+		}
+		return 0;
+	}
+
+	// Return an attribute value or 0.
+	const char* get_attribute(const char* attribute_name) const
+	{	for(size_t i=0; i<attribute_list.size(); i++)
+		{	if(attribute_list[i].first == attribute_name)
+			{	return attribute_list[i].second.c_str();
+			}
+		}
+		return 0;
+	}
+
+	// Return the "v" attribute of a child element or a default value.
+	std::string get_child_value(const std::string& child_name, const char* default_value) const
+	{	const host_xml_element_s*	child = find_child(child_name);
+		const char*					value = child ? child->get_attribute("v") : 0;
+		return value ? value : default_value;
+	}
+
+	// Return the "v" attribute of a child element as an integer or a default value.
+	int get_child_int(const std::string& child_name, int default_value) const
+	{	const host_xml_element_s*	child = find_child(child_name);
+		const char*					value = child ? child->get_attribute("v") : 0;
+		return value ? atoi(value) : default_value;
+	}
+};
+
+// A property value stored in a project file.
+struct host_project_property_s
+{
+	int											type;					// ShaderMap property id, see the notes at the top of this file.
+	std::string									value;
+};
+
+// A filter in the pre or post filter stack of a project node.
+struct host_project_filter_s
+{
+	std::string									plugin_file_name;
+	std::vector<host_project_property_s>		property_list;
+};
+
+// A project node.
+struct host_project_node_s
+{
+	unsigned int								index;					// N of <node_N>.
+	int											node_type;
+	std::string									plugin_file_name;
+	int											plugin_type;
+	std::vector<int>							input_index_list;		// Project node index of each input, -1 if not connected.
+	std::vector<host_project_property_s>		property_list;
+	unsigned int								coord_system;
+	unsigned int								tile_type;
+	std::string									source_file_path;		// Resolved against the project folder.
+	std::string									mask_file_path;			// ^
+	std::vector<host_project_filter_s>			pre_filter_list;
+	std::vector<host_project_filter_s>			post_filter_list;
+
+	// Graph data set by "host_project_build_graph()".
+	std::vector<unsigned int>					dependent_list;			// Nodes that use this node as an input.
+	unsigned int								depth;					// Longest chain of dependent nodes below this node, 1 for nodes nothing depends on.
+
+	// c()
+	host_project_node_s(void)
+	{	index = 0; node_type = HOST_PROJECT_NODE_TYPE_MAP; plugin_type = HOST_PROJECT_PLUGIN_TYPE_MAP;
+		coord_system = 0; tile_type = 0; depth = 1;
+	}
+};
+
+// A loaded project.
+struct host_project_s
+{
+	std::string									file_path;
+	std::string									directory;
+	std::vector<host_project_node_s>			node_list;
+	std::vector<unsigned int>					order_list;				// Node indices in dependency order.
+};
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// XML parsing
+
+// Decode the XML character entities of an attribute value.
+std::string host_xml_decode(const std::string& text)
+{
+	// Local data
+	static const char*							entity_array[5][2] = { {"&amp;", "&"}, {"&lt;", "<"}, {"&gt;", ">"}, {"&quot;", "\""}, {"&apos;", "'"} };
+	std::string									decoded;
+
+
+	for(size_t i=0; i<text.size(); i++)
+	{	BOOL is_entity = FALSE;
+		if(text[i] == '&')
+		{	for(unsigned int e=0; e<5 && !is_entity; e++)
+			{	size_t length = strlen(entity_array[e][0]);
+				if(text.compare(i, length, entity_array[e][0]) == 0)
+				{	decoded	+= entity_array[e][1];
+					i		+= length - 1;
+					is_entity = TRUE;
+				}
+			}
+		}
+		if(!is_entity)
+		{	decoded += text[i];
+		}
+	}
+	return decoded;
+}
+
+// Skip white space, text content, the XML declaration and comments. Returns the position of the next element tag.
+size_t host_xml_skip(const std::string& text, size_t position)
+{
+	for(;;)
+	{	position = text.find('<', position);
+		if(position == std::string::npos)
+		{	return position;
+		}
+		if(text.compare(position, 4, "<!--") == 0)
+		{	position = text.find("-->", position);
+			position = (position == std::string::npos) ? position : position + 3;
+		}
+		else if(text.compare(position, 2, "<?") == 0)
+		{	position = text.find("?>", position);
+			position = (position == std::string::npos) ? position : position + 2;
+		}
+		else
+		{	return position;
+		}
+		if(position == std::string::npos)
+		{	return position;
+		}
+	}
+}
+
+// Parse the element starting at position (a '<'). Returns FALSE on a syntax error. position_in_out is left after the element.
+BOOL host_xml_parse_element(const std::string& text, size_t& position_in_out, host_xml_element_s& element_out, unsigned int depth)
+{
+	// Local data
+	size_t										position, name_end;
+
+
+	position = position_in_out + 1;
+	if(depth > 64)
+	{	return FALSE;
+	}
+
+	// Name
+	name_end = text.find_first_of(" \t\r\n/>", position);
+	if(name_end == std::string::npos || name_end == position)
+	{	return FALSE;
+	}
+	element_out.name	= text.substr(position, name_end - position);
+	position			= name_end;
+
+	// Attributes
+	for(;;)
+	{	position = text.find_first_not_of(" \t\r\n", position);
+		if(position == std::string::npos)
+		{	return FALSE;
+		}
+		if(text.compare(position, 2, "/>") == 0)
+		{	position_in_out = position + 2;
+			return TRUE;
+		}
+		if(text[position] == '>')
+		{	position++;
+			break;
+		}
+
+		size_t equals = text.find('=', position);
+		if(equals == std::string::npos)
+		{	return FALSE;
+		}
+		size_t quote = text.find_first_not_of(" \t\r\n", equals + 1);
+		if(quote == std::string::npos || (text[quote] != '"' && text[quote] != '\''))
+		{	return FALSE;
+		}
+		size_t value_end = text.find(text[quote], quote + 1);
+		if(value_end == std::string::npos)
+		{	return FALSE;
+		}
+		std::string attribute_name = text.substr(position, equals - position);
+		attribute_name.erase(attribute_name.find_last_not_of(" \t\r\n") + 1);
+		element_out.attribute_list.push_back(std::make_pair(attribute_name, host_xml_decode(text.substr(quote + 1, value_end - quote - 1))));
+		position = value_end + 1;
+	}
+
+	// Children up to the end tag
+	for(;;)
+	{	position = host_xml_skip(text, position);
+		if(position == std::string::npos)
+		{	return FALSE;
+		}
+		if(text.compare(position, 2, "</") == 0)
+		{	size_t end = text.find('>', position);
+			if(end == std::string::npos || text.compare(position + 2, element_out.name.size(), element_out.name) != 0)
+			{	return FALSE;
+			}
+			position_in_out = end + 1;
+			return TRUE;
+		}
+		element_out.child_list.push_back(host_xml_element_s());
+		if(!host_xml_parse_element(text, position, element_out.child_list.back(), depth + 1))
+		{	return FALSE;
+		}
+	}
+}
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Project functions
+
+// Resolve a file path stored in a project. Relative paths are relative to the project folder. Windows paths that do not
+// exist on this machine fall back to the file name in the project folder, where the example projects keep their images.
+std::string host_project_resolve_path(const host_project_s& project, std::string file_path)
+{
+	// Local data
+	FILE*										fp;
+
+
+	if(file_path.empty())
+	{	return file_path;
+	}
+	std::replace(file_path.begin(), file_path.end(), '\\', '/');
+	BOOL is_absolute = file_path[0] == '/' || (file_path.size() > 1 && file_path[1] == ':');
+	if(!is_absolute)
+	{	return project.directory + file_path;
+	}
+	fp = fopen(file_path.c_str(), "rb");
+	if(fp)
+	{	fclose(fp);
+		return file_path;
+	}
+	return project.directory + host_get_file_name(file_path);
+}
+
+// Read the plugin file name and property values of a node or filter element.
+void host_project_read_properties(const host_xml_element_s& element, std::vector<host_project_property_s>& property_list_out)
+{
+	int property_count = element.get_child_int("prop_count", 0);
+	for(int i=0; i<property_count; i++)
+	{	const host_xml_element_s*	child = element.find_child("prop_" + std::to_string(i));
+		host_project_property_s		property;
+		const char*					type	= child ? child->get_attribute("type") : 0;
+		const char*					value	= child ? child->get_attribute("value") : 0;
+		property.type	= type ? atoi(type) : -1;
+		property.value	= value ? value : "";
+		// Multi value properties are separated with ';' in project files, the host property strings use ','.
+		std::replace(property.value.begin(), property.value.end(), ';', ',');
+		property_list_out.push_back(property);
+	}
+}
+
+// Read a pre or post filter stack.
+void host_project_read_filters(const host_xml_element_s& node_element, const char* prefix, std::vector<host_project_filter_s>& filter_list_out)
+{
+	int filter_count = node_element.get_child_int(std::string(prefix) + "_count", 0);
+	for(int i=0; i<filter_count; i++)
+	{	const host_xml_element_s* filter_element = node_element.find_child(std::string(prefix) + "_" + std::to_string(i));
+		if(filter_element)
+		{	host_project_filter_s filter;
+			filter.plugin_file_name = filter_element->get_child_value("plugin_file_name", "");
+			host_project_read_properties(*filter_element, filter.property_list);
+			filter_list_out.push_back(filter);
+		}
+	}
+}
+
+// Find the dependents of every node, check that every input exists, sort the nodes in dependency order and compute the
+// depth of each node. Returns FALSE and logs an error if an input is missing or the graph has a cycle.
+BOOL host_project_build_graph(host_project_s& project)
+{
+	// Local data
+	std::vector<unsigned int>					pending_list;
+	std::vector<unsigned int>					ready_list;
+
+
+	for(size_t n=0; n<project.node_list.size(); n++)
+	{	project.node_list[n].dependent_list.clear();
+	}
+	for(size_t n=0; n<project.node_list.size(); n++)
+	{	const host_project_node_s& node = project.node_list[n];
+		for(size_t i=0; i<node.input_index_list.size(); i++)
+		{	int input_index = node.input_index_list[i];
+			if(input_index < 0 || (size_t)input_index >= project.node_list.size())
+			{	host_log("error: node %u input %u is not connected.", node.index, (unsigned int)i);
+				return FALSE;
+			}
+			project.node_list[input_index].dependent_list.push_back((unsigned int)n);
+		}
+	}
+
+	// Kahn's algorithm.
+	pending_list.resize(project.node_list.size());
+	for(size_t n=0; n<project.node_list.size(); n++)
+	{	pending_list[n] = (unsigned int)project.node_list[n].input_index_list.size();
+		if(!pending_list[n])
+		{	ready_list.push_back((unsigned int)n);
+		}
+	}
+	project.order_list.clear();
+	while(!ready_list.empty())
+	{	unsigned int n = ready_list.back();
+		ready_list.pop_back();
+		project.order_list.push_back(n);
+		for(size_t d=0; d<project.node_list[n].dependent_list.size(); d++)
+		{	if(--pending_list[project.node_list[n].dependent_list[d]] == 0)
+			{	ready_list.push_back(project.node_list[n].dependent_list[d]);
+			}
+		}
+	}
+	if(project.order_list.size() != project.node_list.size())
+	{	host_log("error: the project node graph has a cycle.");
+		return FALSE;
+	}
+
+	// Depth in reverse dependency order.
+	for(size_t i=project.order_list.size(); i-- > 0; )
+	{	host_project_node_s& node = project.node_list[project.order_list[i]];
+		node.depth = 1;
+		for(size_t d=0; d<node.dependent_list.size(); d++)
+		{	node.depth = std::max(node.depth, project.node_list[node.dependent_list[d]].depth + 1);
+		}
+	}
+	return TRUE;
+}
+
+// Load a project file and build its node graph. Returns FALSE and logs an error on failure.
+BOOL host_project_load(const char* file_path, host_project_s& project_out)
+{
+	// Local data
+	std::vector<unsigned char>					file_data;
+	std::string									text;
+	host_xml_element_s							root;
+	const host_xml_element_s*					header;
+	size_t										position;
+	int											node_count;
+
+
+	if(!host_read_file(file_path, file_data))
+	{	return FALSE;
+	}
+	text.assign(file_data.begin(), file_data.end());
+	if(text.compare(0, 3, "\xEF\xBB\xBF") == 0)
+	{	text.erase(0, 3);
+	}
+
+	position = host_xml_skip(text, 0);
+	if(position == std::string::npos || !host_xml_parse_element(text, position, root, 0) || root.name != "shadermap_project")
+	{	host_log("error: \"%s\" is not a valid ShaderMap project.", file_path);
+		return FALSE;
+	}
+
+	project_out.file_path	= file_path;
+	project_out.directory	= host_get_directory(file_path);
+	project_out.node_list.clear();
+
+	header		= root.find_child("header");
+	node_count	= header ? header->get_child_int("node_count", 0) : 0;
+	for(int n=0; n<node_count; n++)
+	{
+		const host_xml_element_s*	node_element = root.find_child("node_" + std::to_string(n));
+		host_project_node_s			node;
+
+		if(!node_element)
+		{	host_log("error: \"%s\" is missing node_%d.", file_path, n);
+			return FALSE;
+		}
+		node.index				= (unsigned int)n;
+		node.node_type			= node_element->get_child_int("node_type", HOST_PROJECT_NODE_TYPE_MAP);
+		node.plugin_file_name	= node_element->get_child_value("plugin_file_name", "");
+		node.plugin_type		= node_element->get_child_int("plugin_type", HOST_PROJECT_PLUGIN_TYPE_MAP);
+		node.coord_system		= (unsigned int)node_element->get_child_int("coord_system", 0);
+		node.tile_type			= (unsigned int)node_element->get_child_int("tile_type", 0);
+		node.source_file_path	= host_project_resolve_path(project_out, node_element->get_child_value("source_file_path", ""));
+
+		std::string input_string = node_element->get_child_value("input_index_list", "");
+		for(size_t start=0; start<input_string.size(); )
+		{	size_t end = std::min(input_string.find(';', start), input_string.size());
+			if(end > start)
+			{	node.input_index_list.push_back(atoi(input_string.substr(start, end - start).c_str()));
+			}
+			start = end + 1;
+		}
+
+		const host_xml_element_s* mask_element = node_element->find_child("map_mask");
+		if(mask_element && mask_element->get_attribute("f"))
+		{	node.mask_file_path = host_project_resolve_path(project_out, mask_element->get_attribute("f"));
+		}
+
+		host_project_read_properties(*node_element, node.property_list);
+		host_project_read_filters(*node_element, "pre_filter", node.pre_filter_list);
+		host_project_read_filters(*node_element, "post_filter", node.post_filter_list);
+		project_out.node_list.push_back(node);
+	}
+
+	return host_project_build_graph(project_out);
+}
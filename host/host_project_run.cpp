@@ -0,0 +1,812 @@
+/*
+	===============================================================
+
+	SHADERMAP HEADLESS HOST - PROJECT RUNNER
+
+	A command line host that renders a ShaderMap project (*.smpx)
+	with map and filter plugins built as Linux shared objects.
+
+	The project nodes form a dependency graph - a map node can
+	only run after the nodes connected to its inputs. Nodes whose
+	inputs are complete run at the same time on a pool of worker
+	threads. The total of the thread limits handed to running
+	nodes never exceeds the --threads budget: each node started
+	gets an equal share of the threads not used by running nodes
+	(at least 1) and that share is what mp_get_map_thread_limit()
+	and fp_get_map_thread_limit() return to its plugins. When
+	several nodes are ready the node with the longest chain of
+	dependent nodes is started first and gets the larger share.
+
+	Each node is processed the same as in ShaderMap: the plugin
+	creates the map then the filter stack of the node is applied.
+	Pre filters are applied to the source image of source nodes
+	before processing and to the created map of map nodes before
+	the post filters. A node that fails skips every node that
+	depends on it.
+
+	"src_color_texture.smp" is built into ShaderMap and is not
+	part of the SDK. The runner loads the source image of these
+	nodes directly. Use --source to replace a source image with a
+	PNG, EXR or synthetic image (the runner does not read JPG).
+
+	Plugins are found by file name in the --plugin-dir folders.
+	For "example_NAME_d.smp" the runner tries
+	example_NAME_d.so, example_NAME.so, NAME_d.so and NAME.so.
+	Use --plugin to map a project file name to a file.
+
+	--
+
+	BUILD (from the SDK root folder)
+
+	Plugins:
+	g++ -std=c++11 -O2 -shared -fPIC -fvisibility=hidden -I host/compat maps/examples/map_color_to_ts_normal/map_color_to_ts_normal.cpp -o plugins/map_color_to_ts_normal.so
+	g++ -std=c++11 -O2 -shared -fPIC -fvisibility=hidden -I host/compat filters/examples/filter_rgba/filter_rgba.cpp -o plugins/filter_rgba.so
+
+	Host:
+	g++ -std=c++11 -O2 -I host/compat host/host_project_run.cpp -o host_project_run -ldl -lz -pthread
+
+	--
+
+	USAGE
+
+	host_project_run PROJECT.smpx [options]
+
+	--plugin-dir DIR		Add a folder to search for plugins.
+	--plugin NAME=FILE.so	Use FILE.so for the project plugin NAME.
+	--source N=FILE			Source image of node N. PNG, EXR or
+							synthetic:WxH / synthetic_gray:WxH.
+	--model N=FILE			Make node N a 3D model loaded from a CUSTOM
+							file (project model nodes are not read).
+	--threads N				Thread budget shared by running nodes.
+							Default is the number of hardware threads.
+	--jobs N				Maximum nodes running at the same time.
+							Default is the thread budget. 1 renders one
+							node at a time like ShaderMap.
+	--iterations N			Render the project N times. Default 1.
+	--output-dir DIR		Save every created map as DIR/node_N.exr.
+	--csv FILE				Append one line per node per iteration.
+	--list					Print the node graph then exit.
+	--verbose				Print map status messages.
+
+	Example:
+	./host_project_run maps/examples/map_color_to_ts_normal/_example_map_color_to_ts_normal_sm4_projects/acrylic_rose.smpx
+		--plugin-dir plugins --source 0=synthetic:2048x2048 --threads 16 --output-dir out
+
+	Exit code is 0 if every node succeeded in every iteration, 1
+	otherwise.
+
+
+	SHADERMAP SDK LICENSE
+
+	The ShaderMap SDK is released under The MIT License (MIT)
+	http://opensource.org/licenses/MIT
+
+	Copyright (c) 2007-2019 Rendering Systems Inc.
+
+	See "host_common.cpp" for the full license text.
+
+	===============================================================
+*/
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Host includes
+
+#define SMSDK_HOST
+#include "../maps/map_plugin_core.cpp"
+#undef LOG_ERROR_MSG
+#include "../filters/filter_plugin_core.cpp"
+#include "host_common.cpp"
+#include "host_image.cpp"
+#include "host_model.cpp"
+#include "host_map_api.cpp"
+#include "host_filter_api.cpp"
+#include "host_project.cpp"
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <sys/stat.h>
+#include <thread>
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Runner defines
+
+// The built in ShaderMap source plugin that loads an image file.
+#define HOST_RUN_BUILTIN_SOURCE					"src_color_texture.smp"
+
+// Node status.
+#define HOST_RUN_STATUS_WAITING					0
+#define HOST_RUN_STATUS_RUNNING					1
+#define HOST_RUN_STATUS_DONE					2
+#define HOST_RUN_STATUS_FAILED					3
+#define HOST_RUN_STATUS_SKIPPED					4
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Runner structs
+
+// A project node ready to run.
+struct host_run_node_s
+{
+	const host_project_node_s*					project_node;
+	host_map_node_s*							map_node;
+	host_filter_map_s*							filter_map;				// 0 if the node has no filters.
+	BOOL										is_image;				// Source image loaded by the host, no plugin.
+	BOOL										is_model;				// 3D model loaded by the host, nothing to process.
+	host_image_s								source_image;			// Unfiltered source image of source and image nodes.
+
+	// State of the current iteration.
+	unsigned int								status;
+	unsigned int								pending_count;			// Inputs not done.
+	unsigned int								thread_share;
+	double										start_time, end_time;
+
+	// c()
+	host_run_node_s(void)
+	{	project_node = 0; map_node = 0; filter_map = 0; is_image = is_model = FALSE;
+		status = HOST_RUN_STATUS_WAITING; pending_count = 0; thread_share = 0; start_time = end_time = 0.0;
+	}
+};
+
+// Command line options.
+struct host_run_options_s
+{
+	std::string									project_path;
+	std::vector<std::string>					plugin_directory_list;
+	std::map<std::string, std::string>			plugin_path_map;		// Project plugin file name to file.
+	std::map<unsigned int, std::string>			source_map;				// Node index to source image.
+	std::map<unsigned int, std::string>			model_map;				// Node index to CUSTOM file.
+	std::string									output_directory;
+	std::string									csv_path;
+	unsigned int								thread_budget;
+	unsigned int								job_count;
+	unsigned int								iteration_count;
+	BOOL										is_list;
+
+	// c()
+	host_run_options_s(void)
+	{	thread_budget	= std::max(1u, std::thread::hardware_concurrency());
+		job_count		= 0;
+		iteration_count	= 1;
+		is_list			= FALSE;
+	}
+};
+
+// Scheduler state shared by the main thread and the workers. Guarded by mutex.
+struct host_run_scheduler_s
+{
+	std::mutex									mutex;
+	std::condition_variable						main_condition;			// A node finished.
+	std::condition_variable						worker_condition;		// A node was queued or the run is over.
+	std::vector<unsigned int>					ready_list;				// Nodes with all inputs done.
+	std::deque<unsigned int>					job_list;				// Nodes handed to workers.
+	unsigned int								available_thread_count;
+	unsigned int								running_count;
+	unsigned int								finished_count;
+	BOOL										is_stop;
+
+	// c()
+	host_run_scheduler_s(void)
+	{	available_thread_count = running_count = finished_count = 0;
+		is_stop = FALSE;
+	}
+};
+
+std::vector<host_run_node_s*>					host_run_node_list;		// Indexed by project node index.
+host_run_scheduler_s							host_run_scheduler;
+double											host_run_time_start;
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Setup
+
+// Print usage.
+void host_run_usage(void)
+{
+	fprintf(stderr,
+		"usage: host_project_run PROJECT.smpx [--plugin-dir DIR]... [--plugin NAME=FILE.so]... [--source N=FILE]...\n"
+		"                        [--model N=FILE]... [--threads N] [--jobs N] [--iterations N] [--output-dir DIR]\n"
+		"                        [--csv FILE] [--list] [--verbose]\n");
+}
+
+// Split "KEY=VALUE". Returns FALSE if there is no '='.
+BOOL host_run_split(const char* argument, std::string& key_out, std::string& value_out)
+{
+	const char* equals = strchr(argument, '=');
+	if(!equals || equals == argument)
+	{	host_log("error: invalid argument \"%s\", expected KEY=VALUE.", argument);
+		return FALSE;
+	}
+	key_out		= std::string(argument, equals - argument);
+	value_out	= equals + 1;
+	return TRUE;
+}
+
+// Parse the command line. Returns FALSE on invalid arguments.
+BOOL host_run_parse(int argc, char** argv, host_run_options_s& options_out)
+{
+	for(int i=1; i<argc; i++)
+	{
+		std::string argument = argv[i];
+		BOOL		is_value = (i + 1 < argc);
+		std::string	key, value;
+
+		if(argument == "--plugin-dir" && is_value)			{ options_out.plugin_directory_list.push_back(argv[++i]); }
+		else if(argument == "--threads" && is_value)		{ options_out.thread_budget = std::max(1, atoi(argv[++i])); }
+		else if(argument == "--jobs" && is_value)			{ options_out.job_count = std::max(1, atoi(argv[++i])); }
+		else if(argument == "--iterations" && is_value)		{ options_out.iteration_count = std::max(1, atoi(argv[++i])); }
+		else if(argument == "--output-dir" && is_value)		{ options_out.output_directory = argv[++i]; }
+		else if(argument == "--csv" && is_value)			{ options_out.csv_path = argv[++i]; }
+		else if(argument == "--list")						{ options_out.is_list = TRUE; }
+		else if(argument == "--verbose")					{ host_is_verbose = TRUE; }
+		else if(argument == "--plugin" && is_value)
+		{	if(!host_run_split(argv[++i], key, value))
+			{	return FALSE;
+			}
+			options_out.plugin_path_map[key] = value;
+		}
+		else if((argument == "--source" || argument == "--model") && is_value)
+		{	if(!host_run_split(argv[++i], key, value))
+			{	return FALSE;
+			}
+			(argument == "--source" ? options_out.source_map : options_out.model_map)[(unsigned int)atoi(key.c_str())] = value;
+		}
+		else if(argument[0] != '-' && options_out.project_path.empty())
+		{	options_out.project_path = argument;
+		}
+		else
+		{	host_log("error: unknown or incomplete argument \"%s\".", argument.c_str());
+			return FALSE;
+		}
+	}
+	if(!options_out.job_count)
+	{	options_out.job_count = options_out.thread_budget;
+	}
+	return !options_out.project_path.empty();
+}
+
+// Return the shared object of a project plugin file name or an empty string.
+std::string host_run_find_plugin(const std::string& plugin_file_name, const host_run_options_s& options)
+{
+	// Local data
+	std::vector<std::string>					title_list;
+	std::string									title;
+	FILE*										fp;
+
+
+	std::map<std::string, std::string>::const_iterator mapped = options.plugin_path_map.find(plugin_file_name);
+	if(mapped != options.plugin_path_map.end())
+	{	return mapped->second;
+	}
+
+	// Debug builds end in _d and the example projects use the example_ prefix of the Visual Studio target names.
+	title = plugin_file_name.substr(0, plugin_file_name.find_last_of('.'));
+	title_list.push_back(title);
+	if(title.size() > 2 && title.compare(title.size() - 2, 2, "_d") == 0)
+	{	title_list.push_back(title.substr(0, title.size() - 2));
+	}
+	for(size_t i=0, count=title_list.size(); i<count; i++)
+	{	if(title_list[i].compare(0, 8, "example_") == 0)
+		{	title_list.push_back(title_list[i].substr(8));
+		}
+	}
+
+	for(size_t d=0; d<options.plugin_directory_list.size(); d++)
+	{	for(size_t t=0; t<title_list.size(); t++)
+		{	std::string file_path = options.plugin_directory_list[d] + "/" + title_list[t] + ".so";
+			fp = fopen(file_path.c_str(), "rb");
+			if(fp)
+			{	fclose(fp);
+				return file_path;
+			}
+		}
+	}
+	return std::string();
+}
+
+// Apply project property values to a property list in plugin order.
+void host_run_apply_properties(const std::vector<host_project_property_s>& value_list, std::vector<host_property_s>& property_list, const char* owner_name)
+{
+	if(value_list.size() != property_list.size())
+	{	host_log("warning: %s has %u properties in the project and %u in the plugin, the plugin may be a different version.", owner_name,
+				 (unsigned int)value_list.size(), (unsigned int)property_list.size());
+	}
+	for(size_t i=0; i<value_list.size() && i<property_list.size(); i++)
+	{	if(!host_set_property_from_string(property_list[i], value_list[i].value.c_str()))
+		{	host_log("warning: %s property %u has an invalid value \"%s\".", owner_name, (unsigned int)i, value_list[i].value.c_str());
+		}
+	}
+}
+
+// Add the filters of a project node to its filter map.
+BOOL host_run_setup_filters(host_run_node_s* run_node, const std::vector<host_project_filter_s>& filter_list, BOOL is_pre_filter, const host_run_options_s& options)
+{
+	for(size_t i=0; i<filter_list.size(); i++)
+	{
+		std::string				plugin_path = host_run_find_plugin(filter_list[i].plugin_file_name, options);
+		host_filter_plugin_s*	plugin;
+		host_filter_instance_s*	instance;
+		char					owner_name[64];
+
+		if(plugin_path.empty())
+		{	host_log("error: node %u: filter plugin \"%s\" was not found, use --plugin-dir or --plugin.", run_node->project_node->index,
+					 filter_list[i].plugin_file_name.c_str());
+			return FALSE;
+		}
+		plugin = host_filter_load_plugin(plugin_path.c_str());
+		if(!plugin)
+		{	return FALSE;
+		}
+		if(!run_node->filter_map)
+		{	run_node->filter_map = host_filter_add_map(run_node->map_node->id);
+		}
+		instance = host_filter_add_instance(run_node->filter_map, plugin, is_pre_filter);
+		snprintf(owner_name, sizeof(owner_name), "node %u filter %+d", run_node->project_node->index, instance->filter_position);
+		host_run_apply_properties(filter_list[i].property_list, instance->property_list, owner_name);
+	}
+	return TRUE;
+}
+
+// Create the host nodes of every project node in dependency order. Returns FALSE and logs an error on failure.
+BOOL host_run_setup(const host_project_s& project, const host_run_options_s& options)
+{
+	// Local data
+	std::map<std::string, host_map_plugin_s*>	plugin_map;
+
+
+	host_run_node_list.assign(project.node_list.size(), 0);
+	for(size_t o=0; o<project.order_list.size(); o++)
+	{
+		const host_project_node_s&	project_node	= project.node_list[project.order_list[o]];
+		host_run_node_s*			run_node		= new host_run_node_s;
+		char						owner_name[32];
+
+		host_run_node_list[project_node.index] = run_node;
+		run_node->project_node = &project_node;
+		snprintf(owner_name, sizeof(owner_name), "node %u", project_node.index);
+
+		std::map<unsigned int, std::string>::const_iterator model = options.model_map.find(project_node.index);
+		std::map<unsigned int, std::string>::const_iterator source = options.source_map.find(project_node.index);
+		std::string source_path = (source != options.source_map.end()) ? source->second : project_node.source_file_path;
+
+		// 3D model
+		if(model != options.model_map.end())
+		{	run_node->is_model			= TRUE;
+			run_node->map_node			= host_map_add_node(0);
+			run_node->map_node->model	= new host_model_s;
+			if(!host_load_custom_model(model->second.c_str(), *run_node->map_node->model))
+			{	return FALSE;
+			}
+			continue;
+		}
+		if(project_node.node_type != HOST_PROJECT_NODE_TYPE_MAP)
+		{	host_log("error: node %u has node type %d which this runner does not read, use --model for 3D model nodes.", project_node.index, project_node.node_type);
+			return FALSE;
+		}
+
+		// Image loaded by the host
+		if(project_node.plugin_file_name == HOST_RUN_BUILTIN_SOURCE)
+		{	run_node->is_image	= TRUE;
+			run_node->map_node	= host_map_add_node(0);
+			run_node->map_node->coord_system	= project_node.coord_system;
+			run_node->map_node->tile_type		= project_node.tile_type;
+			if(!host_load_image(source_path.c_str(), run_node->source_image))
+			{	host_log("error: node %u: failed to load the source image, use --source to set a PNG, EXR or synthetic image.", project_node.index);
+				return FALSE;
+			}
+		}
+
+		// Map plugin
+		else
+		{	std::string plugin_path = host_run_find_plugin(project_node.plugin_file_name, options);
+			if(plugin_path.empty())
+			{	host_log("error: node %u: plugin \"%s\" was not found, use --plugin-dir or --plugin.", project_node.index, project_node.plugin_file_name.c_str());
+				return FALSE;
+			}
+			if(!plugin_map.count(plugin_path))
+			{	plugin_map[plugin_path] = host_map_load_plugin(plugin_path.c_str());
+				if(!plugin_map[plugin_path])
+				{	return FALSE;
+				}
+			}
+			host_map_plugin_s* plugin = plugin_map[plugin_path];
+
+			run_node->map_node = host_map_add_node(plugin);
+			run_node->map_node->coord_system	= project_node.coord_system;
+			run_node->map_node->tile_type		= project_node.tile_type;
+			host_run_apply_properties(project_node.property_list, run_node->map_node->property_list, owner_name);
+
+			if(project_node.input_index_list.size() != plugin->input_list.size())
+			{	host_log("error: node %u has %u inputs in the project and %u in the plugin.", project_node.index,
+						 (unsigned int)project_node.input_index_list.size(), (unsigned int)plugin->input_list.size());
+				return FALSE;
+			}
+			for(size_t i=0; i<project_node.input_index_list.size(); i++)
+			{	run_node->map_node->input_id_list.push_back(host_run_node_list[project_node.input_index_list[i]]->map_node->id);
+			}
+
+			if(plugin->info.type == MAP_PLUGIN_TYPE_SOURCE)
+			{	if(!host_load_image(source_path.c_str(), run_node->source_image))
+				{	host_log("error: node %u: failed to load the source image, use --source to set a PNG, EXR or synthetic image.", project_node.index);
+					return FALSE;
+				}
+			}
+		}
+
+		if(!project_node.mask_file_path.empty())
+		{	host_map_node_s* map_node = run_node->map_node;
+			if(!host_load_mask(project_node.mask_file_path.c_str(), map_node->mask_width, map_node->mask_height, map_node->mask_pixel_list))
+			{	return FALSE;
+			}
+		}
+		if(!host_run_setup_filters(run_node, project_node.pre_filter_list, TRUE, options) ||
+		   !host_run_setup_filters(run_node, project_node.post_filter_list, FALSE, options))
+		{	return FALSE;
+		}
+		if(run_node->filter_map)
+		{	run_node->filter_map->mask_width		= run_node->map_node->mask_width;
+			run_node->filter_map->mask_height		= run_node->map_node->mask_height;
+			run_node->filter_map->mask_pixel_list	= run_node->map_node->mask_pixel_list;
+		}
+	}
+	return TRUE;
+}
+
+// Print the node graph.
+void host_run_print_graph(const host_project_s& project)
+{
+	for(size_t o=0; o<project.order_list.size(); o++)
+	{
+		const host_run_node_s*		run_node		= host_run_node_list[project.order_list[o]];
+		const host_project_node_s*	project_node	= run_node->project_node;
+		std::string					input_string;
+
+		for(size_t i=0; i<project_node->input_index_list.size(); i++)
+		{	input_string += (i ? "," : "") + std::to_string(project_node->input_index_list[i]);
+		}
+		printf("node %-3u  %-40s  inputs [%s]  depth %u  filters %u pre %u post\n", project_node->index,
+			   run_node->is_model ? "(model)" : (run_node->is_image ? "(image)" : host_get_file_name(run_node->map_node->plugin->library.file_path).c_str()),
+			   input_string.c_str(), project_node->depth, (unsigned int)project_node->pre_filter_list.size(), (unsigned int)project_node->post_filter_list.size());
+		if(host_is_verbose && run_node->map_node->plugin)
+		{	host_print_property_list(run_node->map_node->property_list);
+		}
+	}
+}
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Processing
+
+// Apply the pre (is_pre_filter) or post filters of a node to an image. Returns FALSE if a filter failed.
+BOOL host_run_apply_filters(host_run_node_s* run_node, host_image_s& image, BOOL is_pre_filter)
+{
+	if(!run_node->filter_map)
+	{	return TRUE;
+	}
+	BOOL is_normal_map = (run_node->map_node->plugin && run_node->map_node->plugin->info.is_normal_map) ? TRUE : FALSE;
+	for(size_t i=0; i<run_node->filter_map->stack_list.size(); i++)
+	{	host_filter_instance_s* instance = run_node->filter_map->stack_list[i];
+		if((instance->filter_position < 0) == (is_pre_filter ? true : false) &&
+		   !host_filter_process_instance(run_node->filter_map, instance, image, is_normal_map, run_node->map_node->coord_system, run_node->map_node->tile_type))
+		{	host_log("error: node %u filter %+d failed.", run_node->project_node->index, instance->filter_position);
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+// Process a node with its thread share. Called on a worker thread. Returns FALSE on failure.
+BOOL host_run_process_node(host_run_node_s* run_node)
+{
+	host_map_node_s* map_node = run_node->map_node;
+
+	map_node->thread_limit = run_node->thread_share;
+	if(run_node->filter_map)
+	{	run_node->filter_map->thread_limit = run_node->thread_share;
+	}
+
+	if(run_node->is_model)
+	{	return TRUE;
+	}
+	if(run_node->is_image)
+	{	map_node->image			= run_node->source_image;
+		map_node->is_created	= TRUE;
+		return host_run_apply_filters(run_node, map_node->image, TRUE) && host_run_apply_filters(run_node, map_node->image, FALSE);
+	}
+
+	if(map_node->plugin->info.type == MAP_PLUGIN_TYPE_SOURCE)
+	{	map_node->source_image = run_node->source_image;
+		if(!host_run_apply_filters(run_node, map_node->source_image, TRUE))
+		{	return FALSE;
+		}
+	}
+	if(!host_map_process_node(map_node) || !map_node->is_created)
+	{	host_log("error: node %u: \"%s\" failed.", run_node->project_node->index, host_get_file_name(map_node->plugin->library.file_path).c_str());
+		return FALSE;
+	}
+	if(map_node->plugin->info.type != MAP_PLUGIN_TYPE_SOURCE && !host_run_apply_filters(run_node, map_node->image, TRUE))
+	{	return FALSE;
+	}
+	return host_run_apply_filters(run_node, map_node->image, FALSE);
+}
+
+// Mark the nodes that depend on a failed node as skipped. Called with the scheduler mutex locked.
+void host_run_skip_dependents(host_run_node_s* run_node)
+{
+	for(size_t d=0; d<run_node->project_node->dependent_list.size(); d++)
+	{	host_run_node_s* dependent = host_run_node_list[run_node->project_node->dependent_list[d]];
+		if(dependent->status == HOST_RUN_STATUS_WAITING)
+		{	dependent->status = HOST_RUN_STATUS_SKIPPED;
+			host_run_scheduler.finished_count++;
+			host_run_skip_dependents(dependent);
+		}
+	}
+}
+
+// Worker thread. Processes queued nodes until the run is over.
+void host_run_worker(void)
+{
+	std::unique_lock<std::mutex> lock(host_run_scheduler.mutex);
+	for(;;)
+	{
+		host_run_scheduler.worker_condition.wait(lock, [] { return host_run_scheduler.is_stop || !host_run_scheduler.job_list.empty(); });
+		if(host_run_scheduler.job_list.empty())
+		{	return;
+		}
+		host_run_node_s* run_node = host_run_node_list[host_run_scheduler.job_list.front()];
+		host_run_scheduler.job_list.pop_front();
+
+		lock.unlock();
+		run_node->start_time	= host_get_time();
+		BOOL is_success			= host_run_process_node(run_node);
+		run_node->end_time		= host_get_time();
+		lock.lock();
+
+		// Return the threads to the budget and release the dependents.
+		run_node->status = is_success ? HOST_RUN_STATUS_DONE : HOST_RUN_STATUS_FAILED;
+		host_run_scheduler.available_thread_count += run_node->thread_share;
+		host_run_scheduler.running_count--;
+		host_run_scheduler.finished_count++;
+		if(is_success)
+		{	for(size_t d=0; d<run_node->project_node->dependent_list.size(); d++)
+			{	unsigned int dependent_index = run_node->project_node->dependent_list[d];
+				if(--host_run_node_list[dependent_index]->pending_count == 0 && host_run_node_list[dependent_index]->status == HOST_RUN_STATUS_WAITING)
+				{	host_run_scheduler.ready_list.push_back(dependent_index);
+				}
+			}
+		}
+		else
+		{	host_run_skip_dependents(run_node);
+		}
+		host_run_scheduler.main_condition.notify_one();
+	}
+}
+
+// Render every node of the project once. Returns the number of nodes that did not finish.
+unsigned int host_run_project(const host_project_s& project, const host_run_options_s& options)
+{
+	// Local data
+	std::vector<std::thread>					worker_list;
+	unsigned int								node_count, fail_count;
+
+
+	node_count = (unsigned int)host_run_node_list.size();
+	host_run_scheduler.ready_list.clear();
+	host_run_scheduler.job_list.clear();
+	host_run_scheduler.available_thread_count	= options.thread_budget;
+	host_run_scheduler.running_count			= 0;
+	host_run_scheduler.finished_count			= 0;
+	host_run_scheduler.is_stop					= FALSE;
+	for(unsigned int n=0; n<node_count; n++)
+	{	host_run_node_s* run_node = host_run_node_list[n];
+		run_node->status		= HOST_RUN_STATUS_WAITING;
+		run_node->pending_count	= (unsigned int)run_node->project_node->input_index_list.size();
+		run_node->thread_share	= 0;
+		run_node->start_time	= run_node->end_time = 0.0;
+		if(!run_node->pending_count)
+		{	host_run_scheduler.ready_list.push_back(n);
+		}
+	}
+
+	host_map_context.is_cancel			= FALSE;
+	host_filter_context.is_cancel		= FALSE;
+	host_run_time_start					= host_get_time();
+	for(unsigned int i=0; i<std::min(options.job_count, node_count); i++)
+	{	worker_list.push_back(std::thread(host_run_worker));
+	}
+
+	{	std::unique_lock<std::mutex> lock(host_run_scheduler.mutex);
+		while(host_run_scheduler.finished_count < node_count)
+		{
+			// Start ready nodes while there are threads in the budget and idle workers.
+			while(!host_run_scheduler.ready_list.empty() && host_run_scheduler.available_thread_count > 0 && host_run_scheduler.running_count < options.job_count)
+			{	std::vector<unsigned int>& ready_list = host_run_scheduler.ready_list;
+
+				// Longest chain of dependents first.
+				size_t best = 0;
+				for(size_t r=1; r<ready_list.size(); r++)
+				{	if(host_run_node_list[ready_list[r]]->project_node->depth > host_run_node_list[ready_list[best]]->project_node->depth)
+					{	best = r;
+					}
+				}
+				host_run_node_s* run_node = host_run_node_list[ready_list[best]];
+				unsigned int idle_count = options.job_count - host_run_scheduler.running_count;
+				unsigned int share_count = (unsigned int)std::min<size_t>(ready_list.size(), idle_count);
+
+				// Rounded up so the node first in line gets the remainder.
+				run_node->thread_share	= (host_run_scheduler.available_thread_count + share_count - 1) / share_count;
+				run_node->status		= HOST_RUN_STATUS_RUNNING;
+				host_run_scheduler.available_thread_count -= run_node->thread_share;
+				host_run_scheduler.running_count++;
+				host_run_scheduler.job_list.push_back(ready_list[best]);
+				ready_list.erase(ready_list.begin() + best);
+				host_run_scheduler.worker_condition.notify_one();
+			}
+			if(host_run_scheduler.finished_count < node_count)
+			{	host_run_scheduler.main_condition.wait(lock);
+			}
+		}
+		host_run_scheduler.is_stop = TRUE;
+		host_run_scheduler.worker_condition.notify_all();
+	}
+	for(size_t i=0; i<worker_list.size(); i++)
+	{	worker_list[i].join();
+	}
+
+	fail_count = 0;
+	for(unsigned int n=0; n<node_count; n++)
+	{	fail_count += (host_run_node_list[n]->status == HOST_RUN_STATUS_DONE) ? 0 : 1;
+	}
+	return fail_count;
+}
+
+// Return the longest path through the graph using the measured node times, in seconds.
+double host_run_get_critical_path(const host_project_s& project)
+{
+	// Local data
+	std::vector<double>							finish_list(project.node_list.size(), 0.0);
+	double										critical_path = 0.0;
+
+
+	for(size_t o=0; o<project.order_list.size(); o++)
+	{	unsigned int		n			= project.order_list[o];
+		const host_run_node_s*	run_node	= host_run_node_list[n];
+		double				start		= 0.0;
+		for(size_t i=0; i<project.node_list[n].input_index_list.size(); i++)
+		{	start = std::max(start, finish_list[project.node_list[n].input_index_list[i]]);
+		}
+		finish_list[n]	= start + (run_node->end_time - run_node->start_time);
+		critical_path	= std::max(critical_path, finish_list[n]);
+	}
+	return critical_path;
+}
+
+// Shutdown plugins and release the nodes.
+void host_run_shutdown(void)
+{
+	for(size_t i=0; i<host_run_node_list.size(); i++)
+	{	delete host_run_node_list[i];
+	}
+	host_run_node_list.clear();
+	host_filter_shutdown();
+	host_map_shutdown();
+}
+
+// Entry point.
+int main(int argc, char** argv)
+{
+	// Local data
+	static const char*							status_name_array[5] = { "waiting", "running", "ok", "fail", "skipped" };
+	host_run_options_s							options;
+	host_project_s								project;
+	host_sample_list_s							wall_list, sum_list, critical_list;
+	FILE*										csv_fp;
+	unsigned int								fail_count;
+
+
+	setlocale(LC_ALL, "");
+	if(!host_run_parse(argc, argv, options))
+	{	host_run_usage();
+		return 1;
+	}
+
+	if(!host_project_load(options.project_path.c_str(), project))
+	{	return 1;
+	}
+	if(project.node_list.empty())
+	{	host_log("error: \"%s\" has no nodes.", options.project_path.c_str());
+		return 1;
+	}
+
+	host_map_context.thread_limit		= options.thread_budget;
+	host_filter_context.thread_limit	= options.thread_budget;
+	if(!host_run_setup(project, options))
+	{	host_run_shutdown();
+		return 1;
+	}
+
+	printf("project     %s, %u nodes, thread budget %u, jobs %u\n", options.project_path.c_str(), (unsigned int)project.node_list.size(),
+		   options.thread_budget, options.job_count);
+	host_run_print_graph(project);
+	if(options.is_list)
+	{	host_run_shutdown();
+		return 0;
+	}
+
+	csv_fp = 0;
+	if(!options.csv_path.empty())
+	{	csv_fp = fopen(options.csv_path.c_str(), "a");
+		if(!csv_fp)
+		{	host_log("error: failed to open \"%s\".", options.csv_path.c_str());
+		}
+		else if(ftell(csv_fp) == 0)
+		{	fprintf(csv_fp, "project,thread_budget,jobs,iteration,node,plugin,status,threads,start_ms,time_ms,width,height\n");
+		}
+	}
+
+	// Render.
+	fail_count = 0;
+	for(unsigned int iteration=0; iteration<options.iteration_count; iteration++)
+	{
+		double time_start	= host_get_time();
+		fail_count			+= host_run_project(project, options);
+		double wall_time	= host_get_time() - time_start;
+		double sum_time		= 0.0;
+
+		printf("\niteration %u\n", iteration);
+		for(size_t o=0; o<project.order_list.size(); o++)
+		{	const host_run_node_s*	run_node	= host_run_node_list[project.order_list[o]];
+			const host_map_node_s*	map_node	= run_node->map_node;
+			double					node_time	= run_node->end_time - run_node->start_time;
+			std::string				name		= run_node->is_model ? "(model)" : (run_node->is_image ? "(image)" : host_get_file_name(map_node->plugin->library.file_path));
+
+			sum_time += node_time;
+			printf("node %-3u  %-32s  %-7s  threads %3u  start %10.2f ms  time %10.2f ms  %ux%u\n", run_node->project_node->index, name.c_str(),
+				   status_name_array[run_node->status], run_node->thread_share,
+				   run_node->start_time > 0.0 ? (run_node->start_time - host_run_time_start) * 1000.0 : 0.0, node_time * 1000.0,
+				   map_node->is_created ? map_node->image.width : 0, map_node->is_created ? map_node->image.height : 0);
+			if(csv_fp)
+			{	fprintf(csv_fp, "%s,%u,%u,%u,%u,%s,%s,%u,%.3f,%.3f,%u,%u\n", host_get_file_name(options.project_path).c_str(), options.thread_budget,
+						options.job_count, iteration, run_node->project_node->index, name.c_str(), status_name_array[run_node->status], run_node->thread_share,
+						run_node->start_time > 0.0 ? (run_node->start_time - host_run_time_start) * 1000.0 : 0.0, node_time * 1000.0,
+						map_node->is_created ? map_node->image.width : 0, map_node->is_created ? map_node->image.height : 0);
+			}
+		}
+
+		wall_list.add(wall_time * 1000.0);
+		sum_list.add(sum_time * 1000.0);
+		critical_list.add(host_run_get_critical_path(project) * 1000.0);
+	}
+
+	printf("\nwall ms           min %.2f  median %.2f  max %.2f\n", wall_list.min(), wall_list.median(), wall_list.max());
+	printf("node sum ms       median %.2f  (one node at a time)\n", sum_list.median());
+	printf("critical path ms  median %.2f  (lower bound)\n", critical_list.median());
+	printf("concurrency       %.2fx\n", wall_list.median() > 0.0 ? sum_list.median() / wall_list.median() : 0.0);
+
+	if(csv_fp)
+	{	fclose(csv_fp);
+	}
+
+	// Save the maps of the last iteration.
+	if(!options.output_directory.empty())
+	{	mkdir(options.output_directory.c_str(), 0755);
+		for(size_t n=0; n<host_run_node_list.size(); n++)
+		{	const host_map_node_s* map_node = host_run_node_list[n]->map_node;
+			if(map_node->is_created)
+			{	std::string file_path = options.output_directory + "/node_" + std::to_string(n) + ".exr";
+				if(!host_save_exr(file_path.c_str(), map_node->image))
+				{	fail_count++;
+				}
+			}
+		}
+	}
+
+	host_run_shutdown();
+	return fail_count ? 1 : 0;
+}
@@ -180,7 +180,9 @@
 // ----------------------------------------------------------------
 // Plugin includes
 
-#include "..\..\map_plugin_core.cpp"
+#include "../../map_plugin_core.cpp"
+#include "../../map_create_stream.cpp"
+#include "../../../common/plugin_mask.cpp"
 #include <vector>
 #include <algorithm>
 #include "assert.h"
@@ -224,8 +226,49 @@ struct vector_3_s
 
 void							normalize_vector(vector_3_s& normal_in_out);
 
-unsigned short*					resize_mask_pixels(unsigned short* mask_pixel_array, unsigned int mask_width, unsigned int mask_height, 
-												   unsigned int new_width, unsigned int new_height);
+
+// ------------------------------------------------------------------
+// ------------------------------------------------------------------
+// Pixel kernel - see "common/plugin_pixel_kernel.cpp".
+
+// Converts a color pixel to a normalized vector in tangent space.
+struct color_to_normal_kernel_s
+{
+	float						intensity;
+
+	// Called for every pixel. The input is never grayscale so CHANNEL_COUNT is always 4.
+	template<unsigned int CHANNEL_COUNT> void process_pixel(float* pixel, float mask) const
+	{
+		// Local data
+		float					opacity;
+		vector_3_s				v3_0;
+
+
+		// Ensure the Blue channel will result in a positive Z value when converted to normal, else invert the Blue channel.
+		if(pixel[2] < 0.5f)
+		{	pixel[2] = 1.0f - pixel[2];
+		}
+
+		// Blend the color (0.5f, 0.5f, 1.0f) to the pixel using the inverted mask as blending weight.
+		// This will cause darker mask pixels to be closer to (0.5f, 0.5f, 1.0f) which will result in an "up" vector.
+		// Without a mask the mask value is 1.0f and the pixel is unchanged.
+		opacity		= 1.0f - mask;
+		pixel[0]	= CHANNEL_BLEND_ALPHA_R_R32(pixel[0], 0.5f, CHANNEL_BLEND_NORMAL_R32, opacity);
+		pixel[1]	= CHANNEL_BLEND_ALPHA_R_R32(pixel[1], 0.5f, CHANNEL_BLEND_NORMAL_R32, opacity);
+		pixel[2]	= CHANNEL_BLEND_ALPHA_R_R32(pixel[2], 1.0f, CHANNEL_BLEND_NORMAL_R32, opacity);
+
+		// Convert the color to a normalized vector in tangent space.
+		v3_0.x		= (pixel[0] * 2.0f - 1.0f) * intensity;
+		v3_0.y		= (pixel[1] * 2.0f - 1.0f) * intensity;
+		v3_0.z		= (pixel[2] * 2.0f - 1.0f);
+
+		normalize_vector(v3_0);
+
+		pixel[0]	= v3_0.x;
+		pixel[1]	= v3_0.y;
+		pixel[2]	= v3_0.z;
+	}
+};
 
 
 // ------------------------------------------------------------------
@@ -265,8 +308,8 @@ BOOL on_initialize(void)
 		// -----------------
 
 		// Add input. A single color map input. 
-		// Set the parameter "is_3d_model" to FALSE to tell ShaderMap the input is a map.
-		mp_add_input(_T("Color Texture"), _T("A diffuse image such as a color image or texture."), FALSE);
+		// Set the parameter "input_type" to MAP_INPUT_TYPE_MAP to tell ShaderMap the input is a map. No input filter is used so 0 is passed for its data.
+		mp_add_input(_T("Color Texture"), _T("A diffuse image such as a color image or texture."), MAP_INPUT_TYPE_MAP, FALSE, 0);
 
 		// -----------------
 
@@ -286,18 +329,11 @@ BOOL on_initialize(void)
 // Process plugin - called when plugin is asked by ShaderMap to process Map Pixels.
 BOOL on_process(unsigned int map_id)
 {
-	// Local structs
-	struct pixel_64_s
-	{	half_float::half		r, g, b, a;
-	};
-
 	// Local data
-	unsigned int				i, count_i, width, height, tile_type, thread_limit, mask_width, mask_height;	
-	float						intensity, opacity;
-	BOOL						is_use_mask, is_invert_mask;
-	unsigned short*				mask_pixel_array, *local_mask_pixel_array;
-	pixel_64_s*					local_normal_map_pixels, *input_pixel_pointer;
-	vector_3_s					v3_0;
+	unsigned int				width, height, tile_type;	
+	BOOL						is_use_mask, is_invert_mask, is_success;
+	const unsigned short*		mask_pixel_array;
+	color_to_normal_kernel_s	kernel;
 	map_create_info_s			create_info;
 	
 
@@ -306,12 +342,6 @@ BOOL on_process(unsigned int map_id)
 
 	// -----------------
 
-	// Get Map thread limit from ShaderMap. Would use this if processing map in multiple threads.
-	// This map does not use multithreading so this line is for demonstration only.
-	thread_limit				= mp_get_map_thread_limit();
-
-	// -----------------
-
 	// Ensure input map is not grayscale. We need RGBA format pixels.
 	if(mp_is_input_grayscale(map_id, 0))
 	{	LOG_ERROR_MSG(map_id, _T("Invalid input format. Grayscale images are not allowed."));
@@ -331,7 +361,7 @@ BOOL on_process(unsigned int map_id)
 	// -----------------
 	
 	// Get property values - pay special attention to the property index requested.	
-	intensity					= mp_get_property_slider(map_id, 0) / 100.0f;		// Convert to floating point multiplier.
+	kernel.intensity			= mp_get_property_slider(map_id, 0) / 100.0f;		// Convert to floating point multiplier.
 	// Don't forget to get the values from the auto added mask properties.
 	is_use_mask					= mp_get_property_checkbox(map_id, 1);
 	is_invert_mask				= mp_get_property_checkbox(map_id, 2);
@@ -340,167 +370,57 @@ BOOL on_process(unsigned int map_id)
 
 	// Get tile type of input. 
 	tile_type					= mp_get_input_tile_type(map_id, 0);
-	
-	// Get pointer to input map's pixels.
-	input_pixel_pointer			= (pixel_64_s*)mp_get_input_pixel_array(map_id, 0);
-
-	// -----------------
-
-	// Allocate source map normal map pixels. 
-	local_normal_map_pixels = new (std::nothrow) pixel_64_s[width * height];
-	if(!local_normal_map_pixels)
-	{	LOG_ERROR_MSG(map_id, _T("Memory Allocation Error: Failed to allocate local_normal_map_pixels."));
-		return FALSE;
-	}
-
-	// Copy the pixels from the input map into this array.
-	memcpy_s(local_normal_map_pixels, sizeof(pixel_64_s) * width * height, input_pixel_pointer, sizeof(pixel_64_s) * width * height);	
 
 	// -----------------
 
-	// The local dynamic pixel array we use to store mask pixels in.
-	local_mask_pixel_array = 0;
-
-	// Get mask data if enabled	
+	// Get the mask at the input map size, inverted if required. The mask is resized with an area or bilinear filter
+	// and kept in a cache until it changes. 0 if the mask is disabled or no mask is set.
+	mask_pixel_array = 0;
 	if(is_use_mask)
-	{	
-		// Get mask size and pixels from ShaderMap.
-		mp_get_map_mask(map_id, mask_width, mask_height, &mask_pixel_array);
-
-		// If mask is set to the map then apply the mask to the local_normal_map_pixels.
-		if(mask_pixel_array)
-		{
-			// Create local copy of mask pixels.
-			local_mask_pixel_array = new (std::nothrow) unsigned short[mask_width * mask_height];
-			if(!local_mask_pixel_array)
-			{	LOG_ERROR_MSG(map_id, _T("Memory Allocation Error: Failed to allocate local_mask_pixel_array."));
-				delete [] local_normal_map_pixels;
-				return FALSE;
-			}
-			memcpy(local_mask_pixel_array, mask_pixel_array, sizeof(unsigned short) * mask_width * mask_height);
-
-			// Resize the mask to the input map size if not already the same size.
-			// Using a simple nearest neighbor scale.
-			if(mask_width != width || mask_height != height)
-			{
-				// Resize mask - local_mask_pixel_array is released by the function and a new array is allocated and returned with scaled pixels.
-				local_mask_pixel_array = resize_mask_pixels(local_mask_pixel_array, mask_width, mask_height, width, height);
-				if(!local_mask_pixel_array)
-				{	LOG_ERROR_MSG(map_id, _T("Resize mask pixels failed. Most likely caused by a memory allocation error."));
-					delete [] local_normal_map_pixels;
-					return FALSE;
-				}
-			}
-
-			// Invert local (resized) mask if required.
-			if(is_invert_mask)
-			{	
-				count_i = width * height;
-				for(i=0; i<count_i; i++)
-				{	local_mask_pixel_array[i] = USHRT_MAX - local_mask_pixel_array[i];
-				}
-			}
-
-			// For every pixel, blend the color (0.5f, 0.5f, 1.0f) to the "local_normal_map_pixels" array using inverted mask as blending weight.
-			// This will cause darker mask pixels to be closer to (0.5f, 0.5f, 1.0f) which will result in an "up" vector when converted to normals below.
-			count_i = width * height;
-			for(i=0; i<count_i; i++)
-			{	
-				// Get mask opacity value for blending.
-				opacity = 1.0f - (local_mask_pixel_array[i] / 65535.0f);
-
-				// Ensure the Blue channel will result in a positive Z value when converted to normal, else invert the Blue channel.
-				if(local_normal_map_pixels[i].b < 0.5f)
-				{	local_normal_map_pixels[i].b = 1.0f - local_normal_map_pixels[i].b;
-				}
-				
-				// Blend the color (0.5f, 0.5f, 1.0f) to the "local_normal_map_pixels" using the mask opacity value.
-				local_normal_map_pixels[i].r = CHANNEL_BLEND_ALPHA_R_R32(local_normal_map_pixels[i].r, 0.5f, CHANNEL_BLEND_NORMAL_R32, opacity);
-				local_normal_map_pixels[i].g = CHANNEL_BLEND_ALPHA_R_R32(local_normal_map_pixels[i].g, 0.5f, CHANNEL_BLEND_NORMAL_R32, opacity);
-				local_normal_map_pixels[i].b = CHANNEL_BLEND_ALPHA_R_R32(local_normal_map_pixels[i].b, 1.0f, CHANNEL_BLEND_NORMAL_R32, opacity);
-			}
-
-			// Free mask pixels.
-			delete [] local_mask_pixel_array;
-			local_mask_pixel_array = 0;
-		}
-	}
-
-	// -----------------
-
-	// Update map progress.
-	mp_set_map_progress(map_id, 50);
-
-	// -----------------
-
-	// For every pixel, convert the color to a normalized vector in tangent space.
-	count_i = width * height;
-	for(i=0; i<count_i; i++)
-	{
-		v3_0.x = (local_normal_map_pixels[i].r * 2.0f - 1.0f) * intensity;
-		v3_0.y = (local_normal_map_pixels[i].g * 2.0f - 1.0f) * intensity;
-		v3_0.z = (local_normal_map_pixels[i].b * 2.0f - 1.0f);
-
-		if(v3_0.z < 0)
-		{	v3_0.z = -v3_0.z;
-		}
-		
-		normalize_vector(v3_0);
-
-		local_normal_map_pixels[i].r = v3_0.x;
-		local_normal_map_pixels[i].g = v3_0.y;
-		local_normal_map_pixels[i].b = v3_0.z;
+	{	mask_pixel_array = plugin_mask_get(map_id, width, height, is_invert_mask);
 	}
 
 	// -----------------
 
-	// Update map progress.
-	mp_set_map_progress(map_id, 75);
-
-	// -----------------
-
 	// Check for cancel
 	if(mp_is_cancel_process())
-	{	delete [] local_normal_map_pixels;
+	{	if(mask_pixel_array)
+		{	plugin_mask_release(mask_pixel_array);
+		}
 		return FALSE;
 	}
 
 	// -----------------
 
-	// Setup the create map info struct.
+	// Setup the create map info struct. There is no pixel_array, the map pixels are written by the kernel.
 	create_info.width			= width;									// Size of source map.
 	create_info.height			= height;
 	create_info.is_grayscale	= FALSE;									// Not in grayscale.
 	create_info.is_sRGB			= FALSE;									// Linear color space pixels.
 	create_info.tile_type		= tile_type;								// The tile type from the input.
 	create_info.coord_system	= MAP_COORDSYS_X_POS_RIGHT | MAP_COORDSYS_Y_POS_DOWN | MAP_COORDSYS_Z_POS_NEAR;	// The coordinate system of the normal map.
-	create_info.pixel_array		= (const void*)local_normal_map_pixels;		// The pixels.
 
-	// Send the create_info struct / pixels to ShaderMap to create the map.
-	if(!mp_create_map(map_id, create_info, 0))
-	{	LOG_ERROR_MSG(map_id, _T("Failed to create map with mp_create_map()."));
-		delete [] local_normal_map_pixels;
-		return FALSE;
-	}
+	// Create the map and convert the input pixels straight into the map pixels owned by ShaderMap, a band of rows at a time.
+	// No local copy of the map is made. See "map_create_stream.cpp".
+	is_success = map_stream_create(map_id, create_info, mp_get_input_pixel_array(map_id, 0), mask_pixel_array, kernel, 0, 100);
 
 	// -----------------
 
 	// Cleanup
-	delete [] local_normal_map_pixels;
-	local_normal_map_pixels = 0;
-
-	// -----------------
-
-	// Update map progress.
-	mp_set_map_progress(map_id, 100);
+	if(mask_pixel_array)
+	{	plugin_mask_release(mask_pixel_array);
+		mask_pixel_array = 0;
+	}
 	
-	return TRUE;
+	return is_success;
 }
 
 // Free any local plugin resources allocated - called by ShaderMap before detaching from the plugin.
 BOOL on_shutdown(void)
 {
-	// Nothing to do.
+	// Release the cached masks and stop the pool threads.
+	plugin_mask_clear();
+	parallel_shutdown();
 
 	return TRUE;
 }
@@ -550,49 +470,3 @@ void normalize_vector(vector_3_s& normal_in_out)
 	{	normal_in_out.x = normal_in_out.y = normal_in_out.z = 0.0f;
 	}	
 }
-
-// Resize the mask pixels using nearest neighbor scaling
-unsigned short* resize_mask_pixels(unsigned short* mask_pixel_array, unsigned int mask_width, unsigned int mask_height, 
-								   unsigned int new_width, unsigned int new_height)
-{
-	// Local data
-	unsigned int					i, j, x, y, x_delta, y_delta, index;;
-	unsigned short*					resized_pixel_array, *source_line;
-
-
-	// Check for same size and early exit.
-	if(mask_width == new_width && mask_height != new_height)
-	{	return mask_pixel_array;
-	}
-
-	// Allocate new size pixel array.
-	resized_pixel_array = new (std::nothrow) unsigned short[new_width * new_height];
-	if(!resized_pixel_array)
-	{	return 0;
-	}
-
-	// Resize using nearest neighbor scaling.
-	x_delta = (mask_width << 16) / new_width;
-    y_delta = (mask_height << 16) / new_height;
-	y		= 0;
-	index	= 0;	
-	for(j=0; j<new_height; j++)
-	{
-		source_line = &mask_pixel_array[(y >> 16) * mask_width];
-		x			= 0;
-		for(i=0; i<new_width; i++)
-		{
-			resized_pixel_array[index] = source_line[(x >> 16)];
-			x += x_delta;
-			index++;
-		}
-		y += y_delta;
-	}
-
-	// Free old mask pixel array.
-	delete [] mask_pixel_array;
-	mask_pixel_array = 0;
-
-	// Return resized pixels.
-	return resized_pixel_array;
-}
\ No newline at end of file
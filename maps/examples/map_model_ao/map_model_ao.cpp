@@ -0,0 +1,642 @@
+﻿/*
+	===============================================================
+
+	SHADERMAP SDK LICENSE
+
+	The ShaderMap SDK is released under The MIT License (MIT)
+	http://opensource.org/licenses/MIT
+
+	Copyright (c) 2007-2019 Rendering Systems Inc.
+
+	Permission is hereby granted, free of charge, to any person
+	obtaining a copy of this software and associated documentation
+	files (the "Software"), to deal	in the Software without
+	restriction, including without limitation the rights to use,
+	copy, modify, merge, publish, distribute, sublicense, and/or
+	sell copies of the Software, and to permit persons to whom the
+	Software is	furnished to do so, subject to the following
+	conditions:
+
+	The above copyright notice and this permission notice shall be
+	included in	all copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+	OF MERCHANTABILITY,	FITNESS FOR A PARTICULAR PURPOSE AND
+	NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+	OTHER DEALINGS IN THE SOFTWARE.
+
+	Developed by: Neil Kemp at Rendering Systems Inc.
+
+	Online:		http://shadermap.com
+	Corporate:	http://renderingsystems.com
+
+
+	===============================================================
+*/
+/*
+	===============================================================
+
+	ABOUT:
+
+	This project builds a map plugin for ShaderMap 4.3. The plugin
+	bakes the ambient occlusion of a high poly model onto the
+	texture coordinates of a low poly model. It is an example on
+	how to trace many rays per texel with the shared ray mesh and
+	stop each texel once it has enough of them.
+
+	The bake is done by "maps\map_model_bake.cpp", which this
+	plugin shares with
+	"maps\examples\map_model_ts_normal\map_model_ts_normal.cpp".
+	The texels covered by the low poly model are found by the tile
+	rasterizer of "maps\map_model_raster.cpp". A ray is cast from
+	the cage toward the low poly surface at each texel to find the
+	high poly surface. From there rays are sent over the
+	hemisphere around the high poly normal, more of them near the
+	normal by the cosine of their angle to it, and the part of them
+	that hit nothing within Occlusion Distance is the value of the
+	texel. White is open, black is fully occluded.
+
+	Rays are sent a packet of 16 at a time. Once a texel has Min
+	Samples rays the 95% confidence interval of its value is found
+	from the rays so far with the Agresti-Coull method, and the
+	texel stops when the interval is within Noise Threshold of the
+	value or it has Max Samples rays. The method counts two more
+	open and two more occluded rays, so a texel whose rays all
+	agree still has an interval of about 2.8 / rays and does not
+	stop before about 2.8 / Noise Threshold rays. At the default of
+	0.1 open areas stop after Min Samples rays, a texel half
+	occluded after 112 and creases get the most rays. A Noise
+	Threshold of 0 sends Max Samples rays for every texel.
+
+	The directions come from the 2D Sobol sequence, so each packet
+	fills the hemisphere evenly. Its first Min Samples points are
+	each in their own band of angle to the normal, Min Samples
+	rounded up to a power of two bands. Each texel changes the
+	sequence so texels next to each other do not share the same
+	noise. With the Blue Noise Sequence the directions of a texel
+	are turned around the normal by a value of a 64 x 64 blue noise
+	mask and moved within their band of angle to the normal by a
+	value of a second one. The masks are made by the void and
+	cluster method at initialize. Texels next to each other then
+	get very different directions, and the error left in the map is
+	fine grain that evens out when looked at from afar, not
+	blotches. With the Sobol Sequence each texel scrambles the bits
+	of the sequence by a hash of its position, which gives white
+	noise.
+
+	Rays that miss the high poly model from the cage get white.
+	The map is created at the start and each row of tiles is shown
+	in ShaderMap once it is baked. Edge Padding then grows the
+	baked texels outward by that many texels.
+
+	With Use Mask on, each baked texel is blended toward white by
+	the inverted mask, so black mask texels are open.
+
+	All map plugins have the extension .smp and are
+	stored in the ShaderMap installation directory at:
+	"plugins\bin\maps"
+
+	See "maps\examples\map_color_to_ts_normal\map_color_to_ts_normal.cpp"
+	to setup your system for development. The steps are the same
+	for this project.
+
+	===============================================================
+*/
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Plugin includes
+
+#include "../../map_plugin_core.cpp"
+#include "../../map_model_bake.cpp"
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
+
+// ------------------------------------------------------------------
+// ------------------------------------------------------------------
+// Local defines
+
+
+// Values of the Sequence property.
+#define BAKE_SEQUENCE_BLUE_NOISE				0
+#define BAKE_SEQUENCE_SOBOL						1
+
+// The blue noise mask is BLUE_NOISE_SIZE x BLUE_NOISE_SIZE and tiles the map. Its energy is a Gaussian of BLUE_NOISE_SIGMA
+// cut at BLUE_NOISE_RADIUS texels.
+#define BLUE_NOISE_SIZE							64
+#define BLUE_NOISE_SIGMA						1.5f
+#define BLUE_NOISE_RADIUS						6
+
+// Property indices.
+#define BAKE_PROPERTY_WIDTH						0
+#define BAKE_PROPERTY_HEIGHT					1
+#define BAKE_PROPERTY_CAGE_OFFSET				2
+#define BAKE_PROPERTY_RAY_DISTANCE				3
+#define BAKE_PROPERTY_OCCLUSION_DISTANCE		4
+#define BAKE_PROPERTY_MIN_SAMPLES				5
+#define BAKE_PROPERTY_MAX_SAMPLES				6
+#define BAKE_PROPERTY_NOISE_THRESHOLD			7
+#define BAKE_PROPERTY_SEQUENCE					8
+#define BAKE_PROPERTY_EDGE_PADDING				9
+#define BAKE_PROPERTY_USE_MASK					10
+#define BAKE_PROPERTY_INVERT_MASK				11
+
+// Input indices.
+#define BAKE_INPUT_LOW							0
+#define BAKE_INPUT_HIGH							1
+
+
+// ------------------------------------------------------------------
+// ------------------------------------------------------------------
+// Local structs
+
+// The inputs and settings of a bake, read by the loop bodies on all threads.
+struct bake_s
+{
+	model_bake_s								model;						// The models, raster, ray mesh and map. See "map_model_bake.cpp".
+	float										occlusion_distance;			// How far occlusion rays go.
+	unsigned int								min_samples, max_samples;	// Rays per texel.
+	unsigned int								band_count;					// min_samples rounded up to a power of two.
+	float										threshold;					// A texel stops when its 95% confidence interval is within this.
+	unsigned int								sequence;					// A BAKE_SEQUENCE_ value.
+};
+
+
+// ------------------------------------------------------------------
+// ------------------------------------------------------------------
+// Local data
+
+// Two blue noise masks with values in (0, 1), made at initialize. One for each dimension of the sequence.
+static float									blue_noise_array[2][BLUE_NOISE_SIZE * BLUE_NOISE_SIZE];
+
+
+// ------------------------------------------------------------------
+// ------------------------------------------------------------------
+// Helper function prototypes - defined at bottom of this source code page.
+
+BOOL							bake_get_texel_surface(const bake_s& bake, const model_bake_texel_s& texel, float* position_out, float* normal_out);
+float							bake_get_texel_occlusion(const bake_s& bake, unsigned int x, unsigned int y, const float* position, const float* normal);
+void							offset_ray_origin(const float* position, const float* normal, float* origin_out);
+void							blue_noise_build(unsigned int seed, float* mask_out);
+unsigned int					sobol_get(unsigned int index, unsigned int dimension);
+unsigned int					hash_uint(unsigned int value);
+
+
+// ------------------------------------------------------------------
+// ------------------------------------------------------------------
+// Loop bodies - see "map_model_bake.cpp".
+
+// Bakes the occlusion of a texel. The high poly surface hit by the ray of the texel is sampled until the texel stops.
+// Misses are left open.
+struct bake_texel_body_s
+{
+	const bake_s*								bake;
+
+	void operator()(const model_bake_texel_s& texel, unsigned int x, unsigned int y, float* pixel_out) const
+	{
+		// Local data
+		float									position[3], normal[3];
+
+
+		if(bake_get_texel_surface(*bake, texel, position, normal))
+		{	pixel_out[0] = bake_get_texel_occlusion(*bake, x, y, position, normal);
+		}
+	}
+};
+
+
+// ------------------------------------------------------------------
+// ------------------------------------------------------------------
+// Local functions called during init, process, and shutdown
+
+// Initialize plugin - called when plugin is attached to ShaderMap.
+BOOL on_initialize(void)
+{
+	// Local data
+	map_plugin_info_s			plugin_info;
+	const wchar_t*				sequence_list[] = { _T("Blue Noise"), _T("Sobol") };
+
+
+	// Tell app we are starting initialize
+	mp_begin_initialize();
+
+		// Send plugin info to ShaderMap
+		plugin_info.version						= 101;												// Version integer
+		plugin_info.type						= MAP_PLUGIN_TYPE_MAP;								// A map type map, generated from its model inputs.
+		plugin_info.default_save_format			= MAP_FORMAT_TGA_RGB_8;								// The default file format ShaderMap will use to export this map type.
+#ifdef _DEBUG
+		plugin_info.name						= _T("Example Model AO - DEBUG");					// Display name
+#else
+		plugin_info.name						= _T("Example Model AO");							// Display name
+#endif
+		plugin_info.description					= _T("Bakes the ambient occlusion of a high poly model onto the texture coordinates of a low poly model.\n\nUses a low poly model with an optional cage and a high poly model as inputs.");	// Description of map.
+		plugin_info.thumb_filename				= _T("example_map_model_ao.png");					// Thumbnail. This must be located in plugins/maps/thumbs/ in the ShaderMap directory.
+		plugin_info.is_maintain_color_space		= TRUE;												// Occlusion is linear and should not be converted to sRGB.
+		plugin_info.default_suffix				= _T("_AO");										// The suffix for batch processing of maps.
+
+		mp_set_plugin_info(plugin_info);
+
+		// -----------------
+
+		// Add inputs. Model inputs have no input filter so 0 is passed for its data. The cage is part of the low poly input.
+		mp_add_input(_T("Low Poly Model"), _T("The model the occlusion is baked for. Its texture coordinates are used. Its cage is used if it matches the model."), MAP_INPUT_TYPE_MODEL, FALSE, 0);
+		mp_add_input(_T("High Poly Model"), _T("The detailed model the occlusion is baked from."), MAP_INPUT_TYPE_MODEL, FALSE, 0);
+
+		// -----------------
+
+		// Add properties
+		mp_add_property_numberbox_int(_T("Width: "), 1, 16384, 1024, 0);					// 0
+		mp_add_property_numberbox_int(_T("Height: "), 1, 16384, 1024, 0);					// 1
+		mp_add_property_numberbox_float(_T("Cage Offset: "), 0.0f, 10000.0f, 0.1f, 0);		// 2		// Used when the low poly input has no matching cage.
+		mp_add_property_numberbox_float(_T("Ray Distance: "), 0.0f, 10000.0f, 0.1f, 0);		// 3		// How far rays go past the low poly surface.
+		mp_add_property_numberbox_float(_T("Occlusion Distance: "), 0.0f, 10000.0f, 1.0f, 0);	// 4	// How far occlusion rays go.
+		mp_add_property_numberbox_int(_T("Min Samples: "), 1, 4096, 32, 0);					// 5		// Rays per texel before it can stop.
+		mp_add_property_numberbox_int(_T("Max Samples: "), 1, 4096, 256, 0);				// 6		// Rays per texel at most.
+		mp_add_property_numberbox_float(_T("Noise Threshold: "), 0.0f, 1.0f, 0.1f, 0);		// 7		// 0 always sends Max Samples rays.
+		mp_add_property_list(_T("Sequence: "), sequence_list, 2, BAKE_SEQUENCE_BLUE_NOISE, 0);	// 8
+		mp_add_property_numberbox_int(_T("Edge Padding: "), 0, 64, 4, 0);					// 9		// Texels baked texels are grown by.
+
+		// The following are mask properties that are added automatically to every map type map.
+		// AUTO PROPERTY: Use Mask															// 10
+		// AUTO PROPERTY: Invert Mask														// 11
+
+		// -----------------
+
+		// Make the blue noise masks.
+		blue_noise_build(1, blue_noise_array[0]);
+		blue_noise_build(2, blue_noise_array[1]);
+
+	// Tell app initialize was success - map is added
+	mp_end_initialize();
+
+	return TRUE;
+}
+
+// Process plugin - called when plugin is asked by ShaderMap to process Map Pixels.
+BOOL on_process(unsigned int map_id)
+{
+	// Local data
+	unsigned int				padding;
+	BOOL						is_use_mask, is_invert_mask;
+	bake_s						bake;
+	bake_texel_body_s			texel_body;
+
+
+	// Update map progress.
+	mp_set_map_progress(map_id, 0);
+
+	// -----------------
+
+	// Get property values.
+	bake.model.width			= (unsigned int)std::max(1, mp_get_property_numberbox_int(map_id, BAKE_PROPERTY_WIDTH));
+	bake.model.height			= (unsigned int)std::max(1, mp_get_property_numberbox_int(map_id, BAKE_PROPERTY_HEIGHT));
+	bake.model.cage_offset		= std::max(0.0f, mp_get_property_numberbox_float(map_id, BAKE_PROPERTY_CAGE_OFFSET));
+	bake.model.ray_distance		= std::max(0.0f, mp_get_property_numberbox_float(map_id, BAKE_PROPERTY_RAY_DISTANCE));
+	bake.occlusion_distance		= std::max(0.0f, mp_get_property_numberbox_float(map_id, BAKE_PROPERTY_OCCLUSION_DISTANCE));
+	bake.max_samples			= (unsigned int)std::max(1, std::min(4096, mp_get_property_numberbox_int(map_id, BAKE_PROPERTY_MAX_SAMPLES)));
+	bake.min_samples			= (unsigned int)std::max(1, std::min((int)bake.max_samples, mp_get_property_numberbox_int(map_id, BAKE_PROPERTY_MIN_SAMPLES)));
+	bake.threshold				= std::max(0.0f, mp_get_property_numberbox_float(map_id, BAKE_PROPERTY_NOISE_THRESHOLD));
+	bake.sequence				= mp_get_property_list(map_id, BAKE_PROPERTY_SEQUENCE) == BAKE_SEQUENCE_SOBOL ? BAKE_SEQUENCE_SOBOL : BAKE_SEQUENCE_BLUE_NOISE;
+	padding						= (unsigned int)std::max(0, std::min(64, mp_get_property_numberbox_int(map_id, BAKE_PROPERTY_EDGE_PADDING)));
+	is_use_mask					= mp_get_property_checkbox(map_id, BAKE_PROPERTY_USE_MASK);
+	is_invert_mask				= mp_get_property_checkbox(map_id, BAKE_PROPERTY_INVERT_MASK);
+
+	// The first 2^k points of the sequence are each in their own band of 1 / 2^k, so the first min_samples are in their own
+	// band of 1 / band_count.
+	bake.band_count = 1;
+	while(bake.band_count < bake.min_samples)
+	{	bake.band_count <<= 1;
+	}
+
+	// Empty and masked texels are open.
+	bake.model.empty_value[0]				= 1.0f;
+	bake.model.create_info.is_grayscale		= TRUE;
+	bake.model.create_info.is_sRGB			= FALSE;
+	bake.model.create_info.tile_type		= MAP_TILE_NONE;
+
+	// -----------------
+
+	// Get the models, the high poly ray mesh and the low poly raster shared with other maps, and the mask, then create the
+	// map. See "map_model_bake.cpp".
+	if(!model_bake_begin(map_id, BAKE_INPUT_LOW, BAKE_INPUT_HIGH, is_use_mask, is_invert_mask, 20, bake.model))
+	{	return FALSE;
+	}
+
+	// Bake a row of tiles at a time on all threads and show it in ShaderMap, then grow the baked texels by the edge padding.
+	texel_body.bake = &bake;
+	return model_bake_run(map_id, bake.model, texel_body, padding, 20);
+}
+
+// Free any local plugin resources allocated - called by ShaderMap before detaching from the plugin.
+BOOL on_shutdown(void)
+{
+	// Release the cached masks, ray meshes and rasters and stop the pool threads.
+	plugin_mask_clear();
+	node_cache_clear();
+	parallel_shutdown();
+
+	return TRUE;
+}
+
+// Arrange map data being loaded. Do this by index of properties.
+void on_arrange_load_data(unsigned int version, unsigned int index_count, unsigned int* index_array)
+{
+	// Nothing to do, no version control needed - all indices match original version 101 positions.
+}
+
+// Called when an node has been removed from the project.
+// Any data stored by input IDs > above_input_id should be subtracted by 1.
+void on_input_id_change(unsigned int above_input_id)
+{
+	// Renumber the cached ray meshes and rasters. See "map_node_cache.cpp".
+	node_cache_on_input_id_change(above_input_id);
+}
+
+// Called when either a node has been removed from the project or a part of it has changed.
+// The type of clear is defined in type (CACHE_TYPE_ANY, _MAP, _MODEL, or _CAGE).
+void on_node_cache_clear(unsigned int input_id, unsigned int type)
+{
+	// Release the cached ray meshes and rasters.
+	node_cache_on_clear(input_id, type);
+}
+
+// Called when ShaderMap is deleting old cache entries.
+// Check local cache for matching data pointer, if found free and remove that entry.
+void on_node_cache_clear_single(const void* data_pointer)
+{
+	// Release the cached ray mesh or raster if it is ours.
+	node_cache_on_clear_single(data_pointer);
+}
+
+
+// ------------------------------------------------------------------
+// ------------------------------------------------------------------
+// Helper functions
+
+// Get the position and normal of the high poly surface hit by the ray of a texel. The normal faces back along the ray.
+// Returns FALSE for a miss.
+BOOL bake_get_texel_surface(const bake_s& bake, const model_bake_texel_s& texel, float* position_out, float* normal_out)
+{
+	// Local data
+	const unsigned int*			index;
+	const model_input_vertex_s*	p[3];
+	float						e1[3], e2[3];
+	const float*				direction = texel.direction;
+
+
+	if(texel.hit_triangle == MODEL_RAY_NONE)
+	{	return FALSE;
+	}
+	index = bake.model.high.index_array + (size_t)texel.hit_triangle * 7;
+	for(unsigned int i=0; i<3; i++)
+	{	p[i] = &bake.model.high.vertex_array[index[i]];
+	}
+	for(unsigned int i=0; i<3; i++)
+	{	position_out[i]	= texel.origin[i] + direction[i] * texel.t;
+		normal_out[i]	= (1.0f - texel.u - texel.v) * (&p[0]->normal.x)[i] + texel.u * (&p[1]->normal.x)[i] + texel.v * (&p[2]->normal.x)[i];
+	}
+	model_bake_normalize(normal_out);
+	if(normal_out[0] == 0.0f && normal_out[1] == 0.0f && normal_out[2] == 0.0f)
+	{	// Use the face normal.
+		for(unsigned int i=0; i<3; i++)
+		{	e1[i] = (&p[1]->position.x)[i] - (&p[0]->position.x)[i];
+			e2[i] = (&p[2]->position.x)[i] - (&p[0]->position.x)[i];
+		}
+		normal_out[0] = e1[1] * e2[2] - e1[2] * e2[1];
+		normal_out[1] = e1[2] * e2[0] - e1[0] * e2[2];
+		normal_out[2] = e1[0] * e2[1] - e1[1] * e2[0];
+		model_bake_normalize(normal_out);
+	}
+	if(normal_out[0] * direction[0] + normal_out[1] * direction[1] + normal_out[2] * direction[2] > 0.0f)
+	{	for(unsigned int i=0; i<3; i++)
+		{	normal_out[i] = -normal_out[i];
+		}
+	}
+	return TRUE;
+}
+
+// Get the part of the hemisphere around normal at position that is open, 1 if open and 0 if fully occluded, for the texel
+// at x, y. Rays are sent a packet at a time until the texel has min_samples rays and the 95% confidence interval of the
+// value is within threshold of it, or it has max_samples rays.
+float bake_get_texel_occlusion(const bake_s& bake, unsigned int x, unsigned int y, const float* position, const float* normal)
+{
+	// Local data
+	float						origin[3], direction[3], tangent[3], bi_normal[3], shift[2], sample[2];
+	float						sign, a, b, r, phi, z, open, count, p;
+	unsigned int				scramble[2], bits, sample_count, hit_count;
+	model_ray_packet_s			packet;
+	model_ray_packet_hit_s		hit;
+
+
+	// A tangent and bi-normal around the normal, from "Building an Orthonormal Basis, Revisited" by Duff et al.
+	sign			= normal[2] < 0.0f ? -1.0f : 1.0f;
+	a				= -1.0f / (sign + normal[2]);
+	b				= normal[0] * normal[1] * a;
+	tangent[0]		= 1.0f + sign * normal[0] * normal[0] * a;
+	tangent[1]		= sign * b;
+	tangent[2]		= -sign * normal[0];
+	bi_normal[0]	= b;
+	bi_normal[1]	= sign + normal[1] * normal[1] * a;
+	bi_normal[2]	= -normal[1];
+	offset_ray_origin(position, normal, origin);
+
+	// Change the sequence for this texel. The first dimension picks the angle to the normal and its first min_samples points
+	// are each in their own band of 1 / band_count, so blue noise moves them within their band. The second dimension turns
+	// the directions around the normal and blue noise turns them by up to a full turn.
+	if(bake.sequence == BAKE_SEQUENCE_BLUE_NOISE)
+	{	shift[0]	= blue_noise_array[0][(y % BLUE_NOISE_SIZE) * BLUE_NOISE_SIZE + x % BLUE_NOISE_SIZE] / (float)bake.band_count;
+		shift[1]	= blue_noise_array[1][(y % BLUE_NOISE_SIZE) * BLUE_NOISE_SIZE + x % BLUE_NOISE_SIZE];
+		scramble[0]	= scramble[1] = 0;
+	}
+	else
+	{	shift[0]	= shift[1] = 0.0f;
+		scramble[0]	= hash_uint(x ^ hash_uint(y));
+		scramble[1]	= hash_uint(scramble[0]);
+	}
+
+	sample_count	= 0;
+	hit_count		= 0;
+	while(sample_count < bake.max_samples)
+	{
+		// Directions with the density of the cosine of their angle to the normal.
+		packet.clear();
+		for(unsigned int i=sample_count; i<std::min(sample_count + MODEL_RAY_PACKET_SIZE, bake.max_samples); i++)
+		{	for(unsigned int j=0; j<2; j++)
+			{	sample[j] = (float)((sobol_get(i, j) ^ scramble[j]) >> 8) * (1.0f / 16777216.0f) + shift[j];
+				sample[j] = sample[j] < 1.0f ? sample[j] : sample[j] - 1.0f;
+			}
+			r	= sqrtf(sample[0]);
+			phi	= 6.28318531f * sample[1];
+			z	= sqrtf(std::max(0.0f, 1.0f - sample[0]));
+			for(unsigned int j=0; j<3; j++)
+			{	direction[j] = tangent[j] * r * cosf(phi) + bi_normal[j] * r * sinf(phi) + normal[j] * z;
+			}
+			packet.add(origin, direction, 0.0f, bake.occlusion_distance);
+		}
+		bits = model_ray_occluded_packet(*bake.model.mesh, packet, MODEL_RAY_TEST_WATERTIGHT, hit);
+		for(; bits; bits&=bits-1)
+		{	hit_count++;
+		}
+		sample_count += packet.count;
+
+		// Each ray is 0 or 1. The Agresti-Coull interval adds two hits and two misses, then its half width at 95% is about
+		// 2 * sqrt(p * (1 - p) / count). Stop once it is below threshold. Rays that all agree still give a width of about
+		// 2.8 / count, so a texel is not stopped as fully open or occluded after a few rays.
+		if(sample_count >= bake.min_samples)
+		{	count	= (float)sample_count + 4.0f;
+			p		= ((float)hit_count + 2.0f) / count;
+			if(4.0f * p * (1.0f - p) / count < bake.threshold * bake.threshold)
+			{	break;
+			}
+		}
+	}
+	open = (float)(sample_count - hit_count) / (float)sample_count;
+	return open;
+}
+
+// Move a point off the surface along its normal so rays from it do not hit the triangle it is on. The move is a number of
+// float steps of each coordinate, so it fits the size of the coordinates. From "A Fast and Robust Method for Avoiding
+// Self-Intersection" by Wachter and Binder.
+void offset_ray_origin(const float* position, const float* normal, float* origin_out)
+{
+	// Local data
+	int							step;
+	unsigned int				bits;
+
+
+	for(unsigned int i=0; i<3; i++)
+	{	if(fabsf(position[i]) < 1.0f / 32.0f)
+		{	origin_out[i] = position[i] + normal[i] * (1.0f / 65536.0f);
+			continue;
+		}
+		step = (int)(normal[i] * 256.0f);
+		memcpy(&bits, &position[i], sizeof(bits));
+		bits = (unsigned int)((int)bits + (position[i] < 0.0f ? -step : step));
+		memcpy(&origin_out[i], &bits, sizeof(bits));
+	}
+}
+
+// Make a blue noise mask with the void and cluster method of Ulichney. Texels are ranked by adding each to the largest void
+// of the ones before it, mask_out gets BLUE_NOISE_SIZE x BLUE_NOISE_SIZE values of (rank + 0.5) / texel count. seed picks the
+// starting pattern.
+void blue_noise_build(unsigned int seed, float* mask_out)
+{
+	// Local data
+	const unsigned int			count = BLUE_NOISE_SIZE * BLUE_NOISE_SIZE;
+	const int					width = BLUE_NOISE_RADIUS * 2 + 1;
+	std::vector<float>			kernel_list(width * width), energy_list(count), start_energy_list;
+	std::vector<unsigned char>	pattern_list(count, 0), start_pattern_list;
+	unsigned int				start_count, rank, cluster, vacancy, texel;
+
+
+	// Add or remove a texel from the pattern and its Gaussian from the energy of the texels around it. The mask wraps.
+	struct local_s
+	{	static void set(std::vector<unsigned char>& pattern, std::vector<float>& energy, const std::vector<float>& kernel, unsigned int texel, unsigned char value)
+		{	pattern[texel] = value;
+			for(int dy=-BLUE_NOISE_RADIUS; dy<=BLUE_NOISE_RADIUS; dy++)
+			{	for(int dx=-BLUE_NOISE_RADIUS; dx<=BLUE_NOISE_RADIUS; dx++)
+				{	energy[((texel / BLUE_NOISE_SIZE + dy + BLUE_NOISE_SIZE) % BLUE_NOISE_SIZE) * BLUE_NOISE_SIZE + (texel % BLUE_NOISE_SIZE + dx + BLUE_NOISE_SIZE) % BLUE_NOISE_SIZE] +=
+						value ? kernel[(dy + BLUE_NOISE_RADIUS) * (BLUE_NOISE_RADIUS * 2 + 1) + dx + BLUE_NOISE_RADIUS] :
+								-kernel[(dy + BLUE_NOISE_RADIUS) * (BLUE_NOISE_RADIUS * 2 + 1) + dx + BLUE_NOISE_RADIUS];
+				}
+			}
+		}
+		// The texel in the pattern with the most energy, or out of the pattern with the least.
+		static unsigned int find(const std::vector<unsigned char>& pattern, const std::vector<float>& energy, unsigned char value)
+		{	unsigned int result = 0;
+			float best = value ? -FLT_MAX : FLT_MAX;
+			for(unsigned int i=0; i<(unsigned int)pattern.size(); i++)
+			{	if(pattern[i] == value && (value ? energy[i] > best : energy[i] < best))
+				{	best = energy[i]; result = i;
+				}
+			}
+			return result;
+		}
+	};
+
+	for(int dy=-BLUE_NOISE_RADIUS; dy<=BLUE_NOISE_RADIUS; dy++)
+	{	for(int dx=-BLUE_NOISE_RADIUS; dx<=BLUE_NOISE_RADIUS; dx++)
+		{	kernel_list[(dy + BLUE_NOISE_RADIUS) * width + dx + BLUE_NOISE_RADIUS] = expf(-(float)(dx * dx + dy * dy) / (2.0f * BLUE_NOISE_SIGMA * BLUE_NOISE_SIGMA));
+		}
+	}
+
+	// Start with a tenth of the texels at random, then move the texel in the tightest cluster to the largest void until
+	// it is the same texel.
+	start_count = 0;
+	for(unsigned int i=0; start_count<count / 10; i++)
+	{	texel = hash_uint(seed * 0x9e3779b9u + i) % count;
+		if(!pattern_list[texel])
+		{	local_s::set(pattern_list, energy_list, kernel_list, texel, 1);
+			start_count++;
+		}
+	}
+	for(unsigned int i=0; i<count; i++)
+	{	cluster = local_s::find(pattern_list, energy_list, 1);
+		local_s::set(pattern_list, energy_list, kernel_list, cluster, 0);
+		vacancy = local_s::find(pattern_list, energy_list, 0);
+		local_s::set(pattern_list, energy_list, kernel_list, vacancy, 1);
+		if(vacancy == cluster)
+		{	break;
+		}
+	}
+	start_pattern_list	= pattern_list;
+	start_energy_list	= energy_list;
+
+	// Rank the starting texels by taking out the tightest cluster each time.
+	for(rank=start_count; rank>0; rank--)
+	{	cluster = local_s::find(pattern_list, energy_list, 1);
+		local_s::set(pattern_list, energy_list, kernel_list, cluster, 0);
+		mask_out[cluster] = ((float)(rank - 1) + 0.5f) / (float)count;
+	}
+
+	// Rank the rest by filling the largest void each time. Past half full the largest void of the texels in the pattern is
+	// the tightest cluster of the texels out of it, so one step ranks both halves.
+	pattern_list	= start_pattern_list;
+	energy_list		= start_energy_list;
+	for(rank=start_count; rank<count; rank++)
+	{	vacancy = local_s::find(pattern_list, energy_list, 0);
+		local_s::set(pattern_list, energy_list, kernel_list, vacancy, 1);
+		mask_out[vacancy] = ((float)rank + 0.5f) / (float)count;
+	}
+}
+
+// Get dimension 0 or 1 of point index of the 2D Sobol sequence as a 32 bit fraction. Dimension 0 is the van der Corput
+// sequence, dimension 1 uses the direction numbers of the polynomial x + 1.
+unsigned int sobol_get(unsigned int index, unsigned int dimension)
+{
+	// Local data
+	unsigned int				result, v;
+
+
+	result = 0;
+	if(dimension == 0)
+	{	for(v=0x80000000u; index; index>>=1, v>>=1)
+		{	result ^= (index & 1) ? v : 0;
+		}
+	}
+	else
+	{	for(v=0x80000000u; index; index>>=1, v^=v>>1)
+		{	result ^= (index & 1) ? v : 0;
+		}
+	}
+	return result;
+}
+
+// Hash an integer to 32 well mixed bits.
+unsigned int hash_uint(unsigned int value)
+{
+	value ^= value >> 16;
+	value *= 0x7feb352du;
+	value ^= value >> 15;
+	value *= 0x846ca68bu;
+	value ^= value >> 16;
+	return value;
+}
@@ -0,0 +1,406 @@
+﻿/*
+	===============================================================
+
+	SHADERMAP SDK LICENSE
+
+	The ShaderMap SDK is released under The MIT License (MIT)
+	http://opensource.org/licenses/MIT
+
+	Copyright (c) 2007-2019 Rendering Systems Inc.
+
+	Permission is hereby granted, free of charge, to any person
+	obtaining a copy of this software and associated documentation
+	files (the "Software"), to deal	in the Software without
+	restriction, including without limitation the rights to use,
+	copy, modify, merge, publish, distribute, sublicense, and/or
+	sell copies of the Software, and to permit persons to whom the
+	Software is	furnished to do so, subject to the following
+	conditions:
+
+	The above copyright notice and this permission notice shall be
+	included in	all copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+	OF MERCHANTABILITY,	FITNESS FOR A PARTICULAR PURPOSE AND
+	NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+	OTHER DEALINGS IN THE SOFTWARE.
+
+	Developed by: Neil Kemp at Rendering Systems Inc.
+
+	Online:		http://shadermap.com
+	Corporate:	http://renderingsystems.com
+
+
+	===============================================================
+*/
+/*
+	===============================================================
+
+	ABOUT:
+
+	This project builds a map plugin for ShaderMap 4.3. The plugin
+	bakes a tangent space normal map of a high poly model onto the
+	texture coordinates of a low poly model. It is an example on
+	how to use model inputs, their cages and the shared ray mesh.
+
+	The bake is done by "maps\map_model_bake.cpp", which this
+	plugin shares with other model bakers. Each texel covered by a
+	low poly triangle in UV space is found by the tile rasterizer
+	of "maps\map_model_raster.cpp", shared with other maps baked
+	from the model at the same size. A ray is cast from the cage
+	toward the low poly surface at the texel and the closest hit on
+	the high poly model is found with the watertight test of
+	"maps\map_model_ray.cpp". The rays of each 4 x 4 group of
+	texels are traced together as a packet. The high poly normal at
+	the hit is moved into the tangent space of the low poly surface
+	from the tangents of the model input.
+
+	The cage is the cage of the low poly input if it has one with
+	the same vertices and triangles as the low poly model. Else
+	the low poly model pushed out along its normals by the Cage
+	Offset property is used. Rays that hit nothing within Ray
+	Distance past the low poly surface get the flat normal.
+
+	The map is created at the start and tiles are baked on all the
+	threads allowed by ShaderMap. Each row of tiles is shown in
+	ShaderMap once it is baked. Edge Padding then grows the baked
+	texels outward by that many texels.
+
+	UV (0, 0) is the upper left of the map. The normals are found
+	with X along the tangent, Y along the bi-normal and Z out of
+	the surface. For MikkTSpace tangents that is X right, Y up and
+	Z near. They are flipped to match the Coord System property.
+	The bi-normal is flipped by the sign of the tangent W of the
+	corners, weighted by the texel, so each texel of a triangle on
+	a mirrored UV seam takes the side of its nearest corners.
+
+	With Use Mask on, each baked normal is blended toward the flat
+	normal by the inverted mask and normalized, so black mask
+	texels are flat.
+
+	All map plugins have the extension .smp and are
+	stored in the ShaderMap installation directory at:
+	"plugins\bin\maps"
+
+	See "maps\examples\map_color_to_ts_normal\map_color_to_ts_normal.cpp"
+	to setup your system for development. The steps are the same
+	for this project.
+
+	===============================================================
+*/
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Plugin includes
+
+#include "../../map_plugin_core.cpp"
+#include "../../map_model_bake.cpp"
+#include <math.h>
+#include <algorithm>
+
+
+// ------------------------------------------------------------------
+// ------------------------------------------------------------------
+// Local defines
+
+
+// Property indices.
+#define BAKE_PROPERTY_WIDTH						0
+#define BAKE_PROPERTY_HEIGHT					1
+#define BAKE_PROPERTY_COORD_SYSTEM				2
+#define BAKE_PROPERTY_CAGE_OFFSET				3
+#define BAKE_PROPERTY_RAY_DISTANCE				4
+#define BAKE_PROPERTY_EDGE_PADDING				5
+#define BAKE_PROPERTY_USE_MASK					6
+#define BAKE_PROPERTY_INVERT_MASK				7
+
+// Input indices.
+#define BAKE_INPUT_LOW							0
+#define BAKE_INPUT_HIGH							1
+
+
+// ------------------------------------------------------------------
+// ------------------------------------------------------------------
+// Local structs
+
+// The inputs and settings of a bake, read by the loop bodies on all threads.
+struct bake_s
+{
+	model_bake_s								model;						// The models, raster, ray mesh and map. See "map_model_bake.cpp".
+	float										flip[3];					// 1 or -1 for each axis to match the coordinate system.
+};
+
+// The tangent, bi-normal and normal of the low poly surface at a texel.
+struct bake_frame_s
+{
+	float										t[3], b[3], n[3];
+};
+
+
+// ------------------------------------------------------------------
+// ------------------------------------------------------------------
+// Helper function prototypes - defined at bottom of this source code page.
+
+void							bake_get_texel_frame(const bake_s& bake, const model_bake_texel_s& texel, bake_frame_s& frame_out);
+void							bake_get_texel_normal(const bake_s& bake, const bake_frame_s& frame, unsigned int hit_triangle, float u, float v, float* normal_out);
+
+
+// ------------------------------------------------------------------
+// ------------------------------------------------------------------
+// Loop bodies - see "map_model_bake.cpp".
+
+// Bakes the normal of a texel in the tangent space of the low poly surface.
+struct bake_texel_body_s
+{
+	const bake_s*								bake;
+
+	void operator()(const model_bake_texel_s& texel, unsigned int x, unsigned int y, float* pixel_out) const
+	{
+		// Local data
+		bake_frame_s							frame;
+
+
+		bake_get_texel_frame(*bake, texel, frame);
+		bake_get_texel_normal(*bake, frame, texel.hit_triangle, texel.u, texel.v, pixel_out);
+	}
+};
+
+
+// ------------------------------------------------------------------
+// ------------------------------------------------------------------
+// Local functions called during init, process, and shutdown
+
+// Initialize plugin - called when plugin is attached to ShaderMap.
+BOOL on_initialize(void)
+{
+	// Local data
+	map_plugin_info_s			plugin_info;
+	unsigned int				default_coord_sys;
+
+
+	// Tell app we are starting initialize
+	mp_begin_initialize();
+
+		// Send plugin info to ShaderMap
+		plugin_info.version						= 101;												// Version integer
+		plugin_info.type						= MAP_PLUGIN_TYPE_MAP;								// A map type map, generated from its model inputs.
+		plugin_info.default_save_format			= MAP_FORMAT_TGA_RGB_8;								// The default file format ShaderMap will use to export this map type.
+#ifdef _DEBUG
+		plugin_info.name						= _T("Example Model TS Normal - DEBUG");			// Display name
+#else
+		plugin_info.name						= _T("Example Model TS Normal");					// Display name
+#endif
+		plugin_info.description					= _T("Bakes the normals of a high poly model into the tangent space of a low poly model.\n\nUses a low poly model with an optional cage and a high poly model as inputs.");	// Description of map.
+		plugin_info.thumb_filename				= _T("example_map_model_ts_normal.png");			// Thumbnail. This must be located in plugins/maps/thumbs/ in the ShaderMap directory.
+		plugin_info.is_normal_map				= TRUE;												// This map is a normal map.
+		plugin_info.is_maintain_color_space		= TRUE;												// Normals are in linear color space and should not be converted to sRGB.
+		plugin_info.default_suffix				= _T("_NORM");										// The suffix for batch processing of maps.
+
+		mp_set_plugin_info(plugin_info);
+
+		// -----------------
+
+		// Add inputs. Model inputs have no input filter so 0 is passed for its data. The cage is part of the low poly input.
+		mp_add_input(_T("Low Poly Model"), _T("The model the normals are baked for. Its texture coordinates and tangents are used. Its cage is used if it matches the model."), MAP_INPUT_TYPE_MODEL, FALSE, 0);
+		mp_add_input(_T("High Poly Model"), _T("The detailed model the normals are baked from."), MAP_INPUT_TYPE_MODEL, FALSE, 0);
+
+		// -----------------
+
+		// Get the default coordinate system from the ShaderMap options.
+		default_coord_sys						= mp_get_option_default_coord_sys();
+		if(default_coord_sys == 0)
+		{	default_coord_sys					= MAP_COORDSYS_X_POS_RIGHT | MAP_COORDSYS_Y_POS_DOWN | MAP_COORDSYS_Z_POS_NEAR;
+		}
+
+		// Add properties
+		mp_add_property_numberbox_int(_T("Width: "), 1, 16384, 1024, 0);					// 0
+		mp_add_property_numberbox_int(_T("Height: "), 1, 16384, 1024, 0);					// 1
+		mp_add_property_coordsys(_T("Coord System"), default_coord_sys, 0);					// 2
+		mp_add_property_numberbox_float(_T("Cage Offset: "), 0.0f, 10000.0f, 0.1f, 0);		// 3		// Used when the low poly input has no matching cage.
+		mp_add_property_numberbox_float(_T("Ray Distance: "), 0.0f, 10000.0f, 0.1f, 0);		// 4		// How far rays go past the low poly surface.
+		mp_add_property_numberbox_int(_T("Edge Padding: "), 0, 64, 4, 0);					// 5		// Texels baked texels are grown by.
+
+		// The following are mask properties that are added automatically to every map type map.
+		// AUTO PROPERTY: Use Mask															// 6
+		// AUTO PROPERTY: Invert Mask														// 7
+
+	// Tell app initialize was success - map is added
+	mp_end_initialize();
+
+	return TRUE;
+}
+
+// Process plugin - called when plugin is asked by ShaderMap to process Map Pixels.
+BOOL on_process(unsigned int map_id)
+{
+	// Local data
+	unsigned int				coord_system, padding;
+	BOOL						is_use_mask, is_invert_mask;
+	bake_s						bake;
+	bake_texel_body_s			texel_body;
+
+
+	// Update map progress.
+	mp_set_map_progress(map_id, 0);
+
+	// -----------------
+
+	// Get property values.
+	bake.model.width			= (unsigned int)std::max(1, mp_get_property_numberbox_int(map_id, BAKE_PROPERTY_WIDTH));
+	bake.model.height			= (unsigned int)std::max(1, mp_get_property_numberbox_int(map_id, BAKE_PROPERTY_HEIGHT));
+	coord_system				= mp_get_property_coordsys(map_id, BAKE_PROPERTY_COORD_SYSTEM);
+	bake.model.cage_offset		= std::max(0.0f, mp_get_property_numberbox_float(map_id, BAKE_PROPERTY_CAGE_OFFSET));
+	bake.model.ray_distance		= std::max(0.0f, mp_get_property_numberbox_float(map_id, BAKE_PROPERTY_RAY_DISTANCE));
+	padding						= (unsigned int)std::max(0, std::min(64, mp_get_property_numberbox_int(map_id, BAKE_PROPERTY_EDGE_PADDING)));
+	is_use_mask					= mp_get_property_checkbox(map_id, BAKE_PROPERTY_USE_MASK);
+	is_invert_mask				= mp_get_property_checkbox(map_id, BAKE_PROPERTY_INVERT_MASK);
+
+	// Normals are baked as X right, Y up and Z near.
+	bake.flip[0]				= (coord_system & MAP_COORDSYS_X_POS_LEFT) ? -1.0f : 1.0f;
+	bake.flip[1]				= (coord_system & MAP_COORDSYS_Y_POS_DOWN) ? -1.0f : 1.0f;
+	bake.flip[2]				= (coord_system & MAP_COORDSYS_Z_POS_FAR) ? -1.0f : 1.0f;
+
+	// Empty and masked texels get the flat normal.
+	bake.model.is_normal					= TRUE;
+	bake.model.empty_value[2]				= bake.flip[2];
+	bake.model.create_info.is_grayscale		= FALSE;
+	bake.model.create_info.is_sRGB			= FALSE;
+	bake.model.create_info.tile_type		= MAP_TILE_NONE;
+	bake.model.create_info.coord_system		= coord_system;
+
+	// -----------------
+
+	// Get the models, the high poly ray mesh and the low poly raster shared with other maps, and the mask, then create the
+	// map. See "map_model_bake.cpp".
+	if(!model_bake_begin(map_id, BAKE_INPUT_LOW, BAKE_INPUT_HIGH, is_use_mask, is_invert_mask, 25, bake.model))
+	{	return FALSE;
+	}
+
+	// Bake a row of tiles at a time on all threads and show it in ShaderMap, then grow the baked texels by the edge padding.
+	texel_body.bake = &bake;
+	return model_bake_run(map_id, bake.model, texel_body, padding, 25);
+}
+
+// Free any local plugin resources allocated - called by ShaderMap before detaching from the plugin.
+BOOL on_shutdown(void)
+{
+	// Release the cached masks, ray meshes and rasters and stop the pool threads.
+	plugin_mask_clear();
+	node_cache_clear();
+	parallel_shutdown();
+
+	return TRUE;
+}
+
+// Arrange map data being loaded. Do this by index of properties.
+void on_arrange_load_data(unsigned int version, unsigned int index_count, unsigned int* index_array)
+{
+	// Nothing to do, no version control needed - all indices match original version 101 positions.
+}
+
+// Called when an node has been removed from the project.
+// Any data stored by input IDs > above_input_id should be subtracted by 1.
+void on_input_id_change(unsigned int above_input_id)
+{
+	// Renumber the cached ray meshes and rasters. See "map_node_cache.cpp".
+	node_cache_on_input_id_change(above_input_id);
+}
+
+// Called when either a node has been removed from the project or a part of it has changed.
+// The type of clear is defined in type (CACHE_TYPE_ANY, _MAP, _MODEL, or _CAGE).
+void on_node_cache_clear(unsigned int input_id, unsigned int type)
+{
+	// Release the cached ray meshes and rasters.
+	node_cache_on_clear(input_id, type);
+}
+
+// Called when ShaderMap is deleting old cache entries.
+// Check local cache for matching data pointer, if found free and remove that entry.
+void on_node_cache_clear_single(const void* data_pointer)
+{
+	// Release the cached ray mesh or raster if it is ours.
+	node_cache_on_clear_single(data_pointer);
+}
+
+
+// ------------------------------------------------------------------
+// ------------------------------------------------------------------
+// Helper functions
+
+// Get the tangent space of the low poly surface at a texel. The normal is the one its ray was cast along.
+void bake_get_texel_frame(const bake_s& bake, const model_bake_texel_s& texel, bake_frame_s& frame_out)
+{
+	// Local data
+	const model_input_tangent_s* tangent;
+	const float*				weight = texel.weight;
+	float*						n = frame_out.n;
+	float*						t = frame_out.t;
+	float*						b = frame_out.b;
+	float						d;
+
+
+	tangent = bake.model.low.tangent_array + (size_t)texel.triangle * 3;
+	for(unsigned int i=0; i<3; i++)
+	{	n[i] = texel.normal[i];
+		t[i] = 0.0f;
+	}
+	for(unsigned int i=0; i<3; i++)
+	{	t[0] += weight[i] * tangent[i].tangent.x; t[1] += weight[i] * tangent[i].tangent.y; t[2] += weight[i] * tangent[i].tangent.z;
+	}
+
+	// Make the tangent perpendicular to the normal, the bi-normal is cross(N, T) * T.w.
+	d = n[0] * t[0] + n[1] * t[1] + n[2] * t[2];
+	for(unsigned int i=0; i<3; i++)
+	{	t[i] -= n[i] * d;
+	}
+	model_bake_normalize(t);
+	if(t[0] == 0.0f && t[1] == 0.0f && t[2] == 0.0f)
+	{	t[0] = fabsf(n[0]) < 0.9f ? 0.0f : -n[1];
+		t[1] = fabsf(n[0]) < 0.9f ? n[2] : n[0];
+		t[2] = fabsf(n[0]) < 0.9f ? -n[1] : 0.0f;
+		model_bake_normalize(t);
+	}
+	d		= weight[0] * tangent[0].w + weight[1] * tangent[1].w + weight[2] * tangent[2].w < 0.0f ? -1.0f : 1.0f;
+	b[0]	= (n[1] * t[2] - n[2] * t[1]) * d;
+	b[1]	= (n[2] * t[0] - n[0] * t[2]) * d;
+	b[2]	= (n[0] * t[1] - n[1] * t[0]) * d;
+}
+
+// Get the normal of a texel from the high poly triangle its ray hit, or MODEL_RAY_NONE for a miss, and the weights u, v
+// of the hit. normal_out gets X, Y and Z.
+void bake_get_texel_normal(const bake_s& bake, const bake_frame_s& frame, unsigned int hit_triangle, float u, float v, float* normal_out)
+{
+	// Local data
+	const unsigned int*			index;
+	float						high_normal[3];
+	const model_input_data_s&	high = bake.model.high;
+
+
+	// Move the high poly normal at the closest hit into tangent space. Misses get the flat normal.
+	normal_out[0] = 0.0f;
+	normal_out[1] = 0.0f;
+	normal_out[2] = 1.0f;
+	if(hit_triangle != MODEL_RAY_NONE)
+	{
+		index = high.index_array + (size_t)hit_triangle * 7;
+		for(unsigned int i=0; i<3; i++)
+		{	high_normal[i]	= (1.0f - u - v) * (&high.vertex_array[index[0]].normal.x)[i] +
+							  u * (&high.vertex_array[index[1]].normal.x)[i] +
+							  v * (&high.vertex_array[index[2]].normal.x)[i];
+		}
+		model_bake_normalize(high_normal);
+		if(high_normal[0] != 0.0f || high_normal[1] != 0.0f || high_normal[2] != 0.0f)
+		{	normal_out[0] = high_normal[0] * frame.t[0] + high_normal[1] * frame.t[1] + high_normal[2] * frame.t[2];
+			normal_out[1] = high_normal[0] * frame.b[0] + high_normal[1] * frame.b[1] + high_normal[2] * frame.b[2];
+			normal_out[2] = high_normal[0] * frame.n[0] + high_normal[1] * frame.n[1] + high_normal[2] * frame.n[2];
+			model_bake_normalize(normal_out);
+		}
+	}
+	for(unsigned int i=0; i<3; i++)
+	{	normal_out[i] *= bake.flip[i];
+	}
+}
@@ -171,7 +171,8 @@
 // ----------------------------------------------------------------
 // Plugin includes
 
-#include "..\..\map_plugin_core.cpp"
+#include "../../map_plugin_core.cpp"
+#include "../../map_create_stream.cpp"
 
 // Have to undefine Min and Max macros so they don't interfere with the half.hpp file
 // These are redefined after the file is included
@@ -206,6 +207,46 @@ struct vector_3_s
 void							normalize_vector(vector_3_s& normal_in_out);
 
 
+// ------------------------------------------------------------------
+// ------------------------------------------------------------------
+// Pixel kernel - see "common/plugin_pixel_kernel.cpp".
+
+// Applies the intensity to a normal map pixel and normalizes it.
+struct source_normal_kernel_s
+{
+	float						intensity;
+	BOOL						is_rasterized;
+
+	// Called for every pixel. The source is never grayscale so CHANNEL_COUNT is always 4.
+	// Alpha value is untouched and should always be in rasterized range, even when is_rasterized == FALSE.
+	// Source maps have no mask so mask is always 1.0f and not used.
+	template<unsigned int CHANNEL_COUNT> void process_pixel(float* pixel, float /*mask*/) const
+	{
+		// Local data
+		vector_3_s				v3_0;
+
+
+		// If pixels are in range 0 to 1 convert to vector range -1 to 1, else already in normalized vector range.
+		if(is_rasterized)
+		{	v3_0.x = (pixel[0] * 2.0f - 1.0f) * intensity;
+			v3_0.y = (pixel[1] * 2.0f - 1.0f) * intensity;
+			v3_0.z = (pixel[2] * 2.0f - 1.0f);
+		}
+		else
+		{	v3_0.x = pixel[0] * intensity;
+			v3_0.y = pixel[1] * intensity;
+			v3_0.z = pixel[2];
+		}
+
+		normalize_vector(v3_0);
+
+		pixel[0] = v3_0.x;
+		pixel[1] = v3_0.y;
+		pixel[2] = v3_0.z;
+	}
+};
+
+
 // ------------------------------------------------------------------
 // ------------------------------------------------------------------
 // Local functions called during init, process, and shutdown
@@ -274,17 +315,9 @@ BOOL on_initialize(void)
 // Process plugin - called when plugin is asked by ShaderMap to process Source Map Pixels.
 BOOL on_process(unsigned int map_id)
 {
-	// Local structs
-	struct pixel_64_s
-	{	half_float::half		r, g, b, a;
-	};
-	
 	// Local data
-	unsigned int				i, count_i, width, height, tile_type, coord_system, thread_limit;
-	float						intensity;
-	BOOL						is_rasterized;
-	pixel_64_s*					local_normal_map_pixels;
-	vector_3_s					v3_0;
+	unsigned int				width, height, tile_type, coord_system;
+	source_normal_kernel_s		kernel;
 	map_create_info_s			create_info;
 
 	
@@ -312,129 +345,36 @@ BOOL on_process(unsigned int map_id)
 	// -----------------
 
 	// Determine if the pixels are rasterized (0 - 1 rage) or in vector format.
-	is_rasterized				= mp_is_source_rasterized(map_id);
+	kernel.is_rasterized		= mp_is_source_rasterized(map_id);
 
 	// -----------------
 
-	// Get Map thread limit from ShaderMap. Would use this if processing map in multiple threads.
-	// This map does not use multithreading so this line is for demonstration only.
-	thread_limit				= mp_get_map_thread_limit();
-	
-	// -----------------
-
 	// Get property values - pay special attention to the property index requested.	
 	tile_type					= mp_get_property_list(map_id, 0);
 	coord_system				= mp_get_property_coordsys(map_id, 1);
-	intensity					= mp_get_property_slider(map_id, 2) / 100.0f;		// Convert to floating point multiplier.
-
-	// -----------------
-
-	// Allocate source map normal map pixels. 
-	local_normal_map_pixels = new (std::nothrow) pixel_64_s[width * height];
-	if(!local_normal_map_pixels)
-	{	LOG_ERROR_MSG(map_id, _T("Memory Allocation Error: Failed to allocate local_normal_map_pixels."));
-		return FALSE;
-	}
-
-	// Copy the pixels from ShaderMap into this array. Use "mp_get_source_pixel_array()".
-	memcpy_s(local_normal_map_pixels, sizeof(pixel_64_s) * width * height, mp_get_source_pixel_array(map_id), sizeof(pixel_64_s) * width * height);	
-
-	// -----------------
-
-	// Update map progress.
-	mp_set_map_progress(map_id, 25);
-
-	// -----------------
-
-	// If pixels are in range 0 to 1
-	if(is_rasterized)
-	{	
-		// All maps of Normal Map type pixels are expected to be in normalized vector form.
-		// For every pixel: Convert to vector range -1 to 1, apply intensity multiplier, and normalize.
-		// Alpha value is untouched and should always be in rasterized range.
-		count_i = width * height;
-		for(i=0; i<count_i; i++)
-		{
-			v3_0.x = (local_normal_map_pixels[i].r * 2.0f - 1.0f) * intensity;
-			v3_0.y = (local_normal_map_pixels[i].g * 2.0f - 1.0f) * intensity;
-			v3_0.z = (local_normal_map_pixels[i].b * 2.0f - 1.0f);
-			
-			normalize_vector(v3_0);
-
-			local_normal_map_pixels[i].r = v3_0.x;
-			local_normal_map_pixels[i].g = v3_0.y;
-			local_normal_map_pixels[i].b = v3_0.z;
-		}
-	}
-	// Else already in normalized vector range.
-	else
-	{	
-		// For every pixel: Apply intensity multiplier and normalize.
-		// Alpha value is untouched and should always be in rasterized range, even when is_rasterized == FALSE.
-		count_i = width * height;
-		for(i=0; i<count_i; i++)
-		{	
-			v3_0.x = local_normal_map_pixels[i].r * intensity;
-			v3_0.y = local_normal_map_pixels[i].g * intensity;
-			v3_0.z = local_normal_map_pixels[i].b;
-
-			normalize_vector(v3_0);
-
-			local_normal_map_pixels[i].r = v3_0.x;
-			local_normal_map_pixels[i].g = v3_0.y;
-			local_normal_map_pixels[i].b = v3_0.z;
-		}
-	}
+	kernel.intensity			= mp_get_property_slider(map_id, 2) / 100.0f;		// Convert to floating point multiplier.
 
 	// -----------------
-
-	// Update map progress.
-	mp_set_map_progress(map_id, 75);
 	
-	// -----------------
-		
-	// Check for cancel
-	if(mp_is_cancel_process())
-	{	delete [] local_normal_map_pixels;
-		return FALSE;
-	}
-
-	// -----------------
-	
-	// Setup the create map info struct.
+	// Setup the create map info struct. There is no pixel_array, the map pixels are written by the kernel.
 	create_info.width			= width;									// Size of source map.
 	create_info.height			= height;
 	create_info.is_grayscale	= FALSE;									// Not in grayscale.
 	create_info.is_sRGB			= FALSE;									// Linear color space pixels.
 	create_info.tile_type		= tile_type;								// The tile type from the property.
 	create_info.coord_system	= coord_system;								// The coordinate system from the property.
-	create_info.pixel_array		= (const void*)local_normal_map_pixels;		// The pixels.
-
-	// Send the create_info struct / pixels to ShaderMap to create the map.
-	if(!mp_create_map(map_id, create_info, 0))
-	{	LOG_ERROR_MSG(map_id, _T("Failed to create map with mp_create_map()."));
-		delete [] local_normal_map_pixels;
-		return FALSE;
-	}
-
-	// -----------------
 
-	// Cleanup
-	delete [] local_normal_map_pixels;
-	local_normal_map_pixels = 0;
-
-	// -----------------
-
-	// Update map progress.
-	mp_set_map_progress(map_id, 100);	
-	
-	return TRUE;
+	// Create the map and write the normalized source pixels straight into the map pixels owned by ShaderMap, a band of
+	// rows at a time. Use "mp_get_source_pixel_array()" to read the source. No local copy of the map is made.
+	// See "map_create_stream.cpp".
+	return map_stream_create(map_id, create_info, mp_get_source_pixel_array(map_id), 0, kernel, 0, 100);
 }
 
 // Free any local plugin resources allocated - called by ShaderMap before detaching from the plugin.
 BOOL on_shutdown(void)
 {		
-	// Nothing to do.
+	// Stop the pool threads.
+	parallel_shutdown();
 
 	return TRUE;
 }
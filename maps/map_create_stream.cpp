@@ -0,0 +1,185 @@
+/*
+	===============================================================
+
+	SHADERMAP MAP CREATE STREAM SOURCE FILE
+
+	Creates a map by writing pixels straight into the pixel array
+	owned by ShaderMap.
+
+	The usual way to create a map is to allocate a local pixel
+	array, copy the input pixels into it, change them, then pass
+	the array to mp_create_map() which copies it again. For a
+	16K x 16K RGBA map that is 2 GiB of local pixels and two extra
+	passes over memory.
+
+	Instead call mp_create_map() with create_info.pixel_array = 0
+	and pixel_array_out set. ShaderMap allocates the map and
+	returns its pixel array. Then read the input pixels a row at a
+	time, change them and write them to the map pixel array. No
+	full size local array is needed and the pixels are touched
+	once.
+
+	map_stream_create() does this with a pixel kernel (see
+	"common/plugin_pixel_kernel.cpp"). The kernel reads the source
+	pixels and writes the map pixels in bands of rows, run on the
+	plugin thread pool within the map thread limit. The map
+	progress is set as bands finish and the map is shown in
+	ShaderMap with mp_update_map_region() when all rows are done.
+
+	Include this source code file in a map plugin after the plugin
+	core file. #include "../../map_create_stream.cpp"
+
+	--
+
+	Example:
+
+	create_info.width			= width;
+	create_info.height			= height;
+	create_info.is_grayscale	= FALSE;
+	create_info.tile_type		= tile_type;
+	create_info.coord_system	= coord_system;
+
+	if(!map_stream_create(map_id, create_info, mp_get_input_pixel_array(map_id, 0), mask_pixel_array, kernel, 0, 100))
+	{	return FALSE;
+	}
+
+	The source pixel array must have the size and format of the
+	map in create_info. A plugin that writes the map pixels with
+	its own loops can call map_stream_begin() to create the map and
+	get the pixel array, then map_stream_update() after each band.
+
+	Call parallel_shutdown() from on_shutdown().
+
+	If processing is cancelled or fails after the map was created
+	return FALSE from on_process(). ShaderMap does not use the
+	partly written map.
+
+
+	SHADERMAP SDK LICENSE
+
+	The ShaderMap SDK is released under The MIT License (MIT)
+	http://opensource.org/licenses/MIT
+
+	Copyright (c) 2007-2019 Rendering Systems Inc.
+
+	Permission is hereby granted, free of charge, to any person
+	obtaining a copy of this software and associated documentation
+	files (the "Software"), to deal	in the Software without
+	restriction, including without limitation the rights to use,
+	copy, modify, merge, publish, distribute, sublicense, and/or
+	sell copies of the Software, and to permit persons to whom the
+	Software is	furnished to do so, subject to the following
+	conditions:
+
+	The above copyright notice and this permission notice shall be
+	included in	all copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+	OF MERCHANTABILITY,	FITNESS FOR A PARTICULAR PURPOSE AND
+	NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+	OTHER DEALINGS IN THE SOFTWARE.
+
+	Developed by: Neil Kemp at Rendering Systems Inc.
+
+	Online:		http://shadermap.com
+	Corporate:	http://renderingsystems.com
+
+	===============================================================
+*/
+
+#ifndef MAP_CREATE_STREAM_CPP
+#define MAP_CREATE_STREAM_CPP
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Map create stream includes
+
+#include "../common/plugin_pixel_kernel.cpp"
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Map create stream defines
+
+// Rows a plugin with its own loops should write between calls to map_stream_update().
+#define MAP_STREAM_BAND_ROW_COUNT				PIXEL_KERNEL_CANCEL_ROW_COUNT
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Map create stream functions
+
+// Create the map without copying pixels and return the pixel array owned by ShaderMap, 2 or 4 half floats per pixel
+// depending on create_info.is_grayscale. Returns 0 and logs an error on failure.
+void* map_stream_begin(unsigned int map_id, const map_create_info_s& create_info)
+{
+	// Local data
+	map_create_info_s							stream_info;
+	void*										map_pixel_array;
+
+
+	stream_info				= create_info;
+	stream_info.pixel_array	= 0;
+	map_pixel_array			= 0;
+	if(!mp_create_map(map_id, stream_info, &map_pixel_array) || !map_pixel_array)
+	{	LOG_ERROR_MSG(map_id, _T("Failed to create map with mp_create_map()."));
+		return 0;
+	}
+	return map_pixel_array;
+}
+
+// Show rows y_start to y_end - 1 of the map in ShaderMap and set the progress from progress_start to progress_end by the rows done.
+void map_stream_update(unsigned int map_id, const map_create_info_s& create_info, unsigned int y_start, unsigned int y_end,
+					   unsigned int progress_start, unsigned int progress_end)
+{
+	// Local data
+	RECT										region;
+
+
+	region.left		= 0;
+	region.top		= (LONG)y_start;
+	region.right	= (LONG)create_info.width;
+	region.bottom	= (LONG)y_end;
+	mp_update_map_region(map_id, region);
+	mp_set_map_progress(map_id, progress_start + (unsigned int)((unsigned long long)(progress_end - progress_start) * y_end / create_info.height));
+}
+
+// Create the map and write its pixels by running a pixel kernel on source_pixel_array. The source must have the size and
+// format of the map. mask_pixel_array is 0 or one value per map pixel. Progress is set from progress_start to progress_end.
+// Returns FALSE if cancelled or on error.
+template<class KERNEL_T>
+BOOL map_stream_create(unsigned int map_id, const map_create_info_s& create_info, const void* source_pixel_array, const unsigned short* mask_pixel_array,
+					   const KERNEL_T& kernel, unsigned int progress_start, unsigned int progress_end)
+{
+	// Local data
+	void*										map_pixel_array;
+	pixel_kernel_image_s						image;
+
+
+	if(!source_pixel_array)
+	{	LOG_ERROR_MSG(map_id, _T("Invalid source pixel array."));
+		return FALSE;
+	}
+
+	map_pixel_array = map_stream_begin(map_id, create_info);
+	if(!map_pixel_array)
+	{	return FALSE;
+	}
+
+	image = pixel_kernel_get_image(create_info, source_pixel_array, map_pixel_array);
+	if(!pixel_kernel_run(image, mask_pixel_array, kernel, parallel_get_progress(map_id, progress_start, progress_end)))
+	{	if(!mp_is_cancel_process())
+		{	LOG_ERROR_MSG(map_id, _T("Memory Allocation Error: Failed to allocate pixel kernel rows."));
+		}
+		return FALSE;
+	}
+	map_stream_update(map_id, create_info, 0, create_info.height, progress_start, progress_end);
+	return TRUE;
+}
+
+#endif // MAP_CREATE_STREAM_CPP
@@ -0,0 +1,560 @@
+/*
+	===============================================================
+
+	SHADERMAP MAP MODEL BAKE SOURCE FILE
+
+	Bakes a map from a high poly model onto the texture coordinates
+	of a low poly model. It holds the parts every model baker has,
+	so a baker only gives the value of a texel.
+
+	The texels covered by the low poly model are found by the tile
+	rasterizer of "map_model_raster.cpp". At each texel a ray is
+	cast from the cage toward the low poly surface, up to Ray
+	Distance past it, against the ray mesh of the high poly model
+	of "map_model_ray.cpp". Without a matching cage the ray starts
+	Cage Offset out along the low poly normal. The rays of a run of
+	texels are cast as one packet.
+
+	The texel body of the baker gets the low poly surface, the ray
+	and the closest hit of each covered texel and writes its value.
+	Texels are then blended toward empty_value by the inverted
+	mask. Each row of tiles is written to the map pixels owned by
+	ShaderMap and shown once it is baked. Edge Padding then grows
+	the baked texels outward one texel per pass with the average
+	of their neighbors.
+
+	Maps are grayscale or RGBA as set in create_info. The last
+	channel is 0 for empty texels and 1 for baked ones. With
+	is_normal the first three channels are a normal and are
+	normalized after they are blended or averaged.
+
+	Include this source code file in a map plugin after the plugin
+	core file. #include "../../map_model_bake.cpp"
+
+	--
+
+	Example:
+
+	struct texel_body_s
+	{	void operator()(const model_bake_texel_s& texel, unsigned int x, unsigned int y, float* pixel_out) const
+		{	pixel_out[0] = texel.hit_triangle == MODEL_RAY_NONE ? 0.0f : 1.0f;
+		}
+	};
+
+	bake.width						= width;
+	bake.height						= height;
+	bake.cage_offset				= cage_offset;
+	bake.ray_distance				= ray_distance;
+	bake.empty_value[0]				= 0.0f;
+	bake.create_info.is_grayscale	= TRUE;
+	if(!model_bake_begin(map_id, 0, 1, is_use_mask, is_invert_mask, 20, bake))
+	{	return FALSE;
+	}
+	if(!model_bake_run(map_id, bake, texel_body, padding, 20))
+	{	return FALSE;
+	}
+
+	model_bake_begin() gets the models of the low and high poly
+	inputs, the ray mesh, the raster, the mask and creates the map.
+	model_bake_run() releases them when it is done or cancelled.
+	Call the node cache functions from the plugin callbacks as
+	shown in "map_node_cache.cpp", plugin_mask_clear(),
+	node_cache_clear() and parallel_shutdown() from on_shutdown().
+
+
+	SHADERMAP SDK LICENSE
+
+	The ShaderMap SDK is released under The MIT License (MIT)
+	http://opensource.org/licenses/MIT
+
+	Copyright (c) 2007-2019 Rendering Systems Inc.
+
+	Permission is hereby granted, free of charge, to any person
+	obtaining a copy of this software and associated documentation
+	files (the "Software"), to deal	in the Software without
+	restriction, including without limitation the rights to use,
+	copy, modify, merge, publish, distribute, sublicense, and/or
+	sell copies of the Software, and to permit persons to whom the
+	Software is	furnished to do so, subject to the following
+	conditions:
+
+	The above copyright notice and this permission notice shall be
+	included in	all copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+	OF MERCHANTABILITY,	FITNESS FOR A PARTICULAR PURPOSE AND
+	NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+	OTHER DEALINGS IN THE SOFTWARE.
+
+	Developed by: Neil Kemp at Rendering Systems Inc.
+
+	Online:		http://shadermap.com
+	Corporate:	http://renderingsystems.com
+
+	===============================================================
+*/
+
+#ifndef MAP_MODEL_BAKE_CPP
+#define MAP_MODEL_BAKE_CPP
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Model bake includes
+
+#include "map_create_stream.cpp"
+#include "map_model_raster.cpp"
+#include "map_model_ray.cpp"
+#include "../common/plugin_mask.cpp"
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Model bake defines
+
+// Coverage of a texel. Texels filled by edge padding pass n are marked MODEL_BAKE_COVERAGE_BAKED + n.
+#define MODEL_BAKE_COVERAGE_EMPTY				0
+#define MODEL_BAKE_COVERAGE_BAKED				1
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Model bake structs
+
+// The inputs and settings of a bake, read by the loop bodies on all threads.
+struct model_bake_s
+{
+	model_input_data_s							low;						// The low poly model, its cage and its raster.
+	model_input_data_s							cage;
+	BOOL										is_cage;
+	const model_raster_s*						raster;
+	model_input_data_s							high;						// The high poly model and its ray mesh.
+	const model_ray_mesh_s*						mesh;
+
+	unsigned int								width, height;				// Size of the map.
+	float										cage_offset;				// Used when there is no cage.
+	float										ray_distance;				// How far past the low poly surface rays go.
+	BOOL										is_normal;					// The first three channels are a normal.
+	float										empty_value[4];				// Of texels that are not baked, all channels but the last.
+	map_create_info_s							create_info;				// Set by the baker except width and height.
+
+	const unsigned short*						mask_pixel_array;			// One value per texel, 0 if no mask is used.
+	unsigned short*								map_pixel_array;			// Owned by ShaderMap, 2 or 4 half floats per texel.
+	unsigned char*								coverage_array;				// One MODEL_BAKE_COVERAGE_ value per texel.
+	std::vector<unsigned char>					coverage_list;
+
+	// c()
+	model_bake_s(void)
+	{	is_cage = FALSE; raster = 0; mesh = 0; width = 0; height = 0; cage_offset = 0.0f; ray_distance = 0.0f; is_normal = FALSE;
+		empty_value[0] = empty_value[1] = empty_value[2] = empty_value[3] = 0.0f;
+		mask_pixel_array = 0; map_pixel_array = 0; coverage_array = 0;
+	}
+
+	// Return the half floats per texel.
+	unsigned int get_channel_count(void) const
+	{	return create_info.is_grayscale ? 2 : 4;
+	}
+};
+
+// A covered texel, its low poly surface, its ray and what the ray hit.
+struct model_bake_texel_s
+{
+	unsigned int								triangle;					// The low poly triangle, position in index_array / 7.
+	float										weight[3];					// Of the corners of the triangle.
+	float										position[3];				// Of the low poly surface.
+	float										normal[3];
+	float										origin[3];					// Of the ray, on the cage.
+	float										direction[3];
+	float										t_max;
+	unsigned int								hit_triangle;				// The high poly triangle hit, MODEL_RAY_NONE for a miss.
+	float										t, u, v;					// Of the hit. See model_bvh_hit_s.
+};
+
+// Bakes the tiles of one tile row. The covered texels of each tile are baked a packet of rays at a time by texel_body, then
+// the tile is written to the map. texel_body is called on all threads with
+// void operator()(const model_bake_texel_s& texel, unsigned int x, unsigned int y, float* pixel_out) const
+// where pixel_out holds empty_value and the baker writes all channels but the last.
+template<class TEXEL_T>
+struct model_bake_tile_body_s
+{
+	const model_bake_s*							bake;
+	const TEXEL_T*								texel_body;
+	unsigned int								tile_row;
+
+	BOOL operator()(unsigned int column_start, unsigned int column_end) const;
+};
+
+// Fills the empty texels next to texels baked or filled by earlier passes with the average of those neighbors. Texels
+// filled by this pass are marked so other rows of the same pass skip them.
+struct model_bake_pad_body_s
+{
+	const model_bake_s*							bake;
+	unsigned int								pass;
+
+	BOOL operator()(unsigned int y_start, unsigned int y_end) const;
+};
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Model bake local functions
+
+// Normalize a 3 element vector. A zero vector stays zero.
+inline void model_bake_normalize(float* v)
+{
+	float t = sqrtf(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+	if(t > 0.0f)
+	{	v[0] /= t; v[1] /= t; v[2] /= t;
+	}
+	else
+	{	v[0] = v[1] = v[2] = 0.0f;
+	}
+}
+
+// Get the low poly surface and the ray of the point at weights 1 - u - v, u, v on a low poly triangle. The ray goes from the
+// cage toward the low poly surface, then up to ray_distance past it.
+void model_bake_get_texel_ray(const model_bake_s& bake, unsigned int triangle, float u, float v, model_bake_texel_s& texel_out)
+{
+	// Local data
+	const unsigned int*							index;
+	const model_input_vertex_s*					corner[3];
+	float										e1[3], e2[3], length;
+	const float*								weight	= texel_out.weight;
+	float*										p		= texel_out.position;
+	float*										n		= texel_out.normal;
+	float*										c		= texel_out.origin;
+	float*										direction = texel_out.direction;
+
+
+	index					= bake.low.index_array + (size_t)triangle * 7;
+	texel_out.triangle		= triangle;
+	texel_out.weight[0]		= 1.0f - u - v;
+	texel_out.weight[1]		= u;
+	texel_out.weight[2]		= v;
+	for(unsigned int i=0; i<3; i++)
+	{	corner[i] = &bake.low.vertex_array[index[i]];
+	}
+
+	// Position and normal of the low poly surface.
+	for(unsigned int i=0; i<3; i++)
+	{	p[i] = n[i] = 0.0f;
+	}
+	for(unsigned int i=0; i<3; i++)
+	{	p[0] += weight[i] * corner[i]->position.x;	p[1] += weight[i] * corner[i]->position.y;	p[2] += weight[i] * corner[i]->position.z;
+		n[0] += weight[i] * corner[i]->normal.x;	n[1] += weight[i] * corner[i]->normal.y;	n[2] += weight[i] * corner[i]->normal.z;
+	}
+	model_bake_normalize(n);
+	if(n[0] == 0.0f && n[1] == 0.0f && n[2] == 0.0f)
+	{	// Use the face normal.
+		for(unsigned int i=0; i<3; i++)
+		{	e1[i] = (&corner[1]->position.x)[i] - (&corner[0]->position.x)[i];
+			e2[i] = (&corner[2]->position.x)[i] - (&corner[0]->position.x)[i];
+		}
+		n[0] = e1[1] * e2[2] - e1[2] * e2[1];
+		n[1] = e1[2] * e2[0] - e1[0] * e2[2];
+		n[2] = e1[0] * e2[1] - e1[1] * e2[0];
+		model_bake_normalize(n);
+	}
+
+	// The ray starts on the cage and goes toward the low poly surface.
+	if(bake.is_cage)
+	{	index = bake.cage.index_array + (size_t)triangle * 7;
+		c[0] = c[1] = c[2] = 0.0f;
+		for(unsigned int i=0; i<3; i++)
+		{	c[0] += weight[i] * bake.cage.vertex_array[index[i]].position.x;
+			c[1] += weight[i] * bake.cage.vertex_array[index[i]].position.y;
+			c[2] += weight[i] * bake.cage.vertex_array[index[i]].position.z;
+		}
+	}
+	else
+	{	for(unsigned int i=0; i<3; i++)
+		{	c[i] = p[i] + n[i] * bake.cage_offset;
+		}
+	}
+	for(unsigned int i=0; i<3; i++)
+	{	direction[i] = p[i] - c[i];
+	}
+	length = sqrtf(direction[0] * direction[0] + direction[1] * direction[1] + direction[2] * direction[2]);
+	if(length > 1e-20f)
+	{	for(unsigned int i=0; i<3; i++)
+		{	direction[i] /= length;
+		}
+	}
+	else
+	{	for(unsigned int i=0; i<3; i++)
+		{	direction[i] = -n[i];
+		}
+		length = 0.0f;
+	}
+	texel_out.t_max = length + bake.ray_distance;
+}
+
+// Bake the texels of each tile in the columns. The raster keeps the texels of a tile in 4 x 4 groups, so the rays of a run
+// of them start close together and go the same way and visit the same nodes of the ray mesh.
+template<class TEXEL_T>
+BOOL model_bake_tile_body_s<TEXEL_T>::operator()(unsigned int column_start, unsigned int column_end) const
+{
+	// Local data
+	float										pixel_array[MODEL_RASTER_TILE_SIZE * MODEL_RASTER_TILE_SIZE * 4];
+	float*										pixel;
+	float										mask;
+	int											x_start, y_start, x_end, y_end;
+	unsigned int								tile, texel_start, texel_end, x, y;
+	model_bake_texel_s							texel_array[MODEL_RAY_PACKET_SIZE];
+	model_ray_packet_s							packet;
+	model_ray_packet_hit_s						hit;
+	const model_raster_s*						raster			= bake->raster;
+	const unsigned int							channel_count	= bake->get_channel_count();
+
+
+	for(unsigned int column=column_start; column<column_end; column++)
+	{
+		x_start		= (int)(column * MODEL_RASTER_TILE_SIZE);
+		y_start		= (int)(tile_row * MODEL_RASTER_TILE_SIZE);
+		x_end		= std::min<int>(x_start + MODEL_RASTER_TILE_SIZE, (int)bake->width);
+		y_end		= std::min<int>(y_start + MODEL_RASTER_TILE_SIZE, (int)bake->height);
+		tile		= tile_row * raster->tile_column_count + column;
+		texel_start	= raster->tile_start_array[tile];
+		texel_end	= raster->tile_start_array[tile + 1];
+
+		for(unsigned int i=0; i<MODEL_RASTER_TILE_SIZE * MODEL_RASTER_TILE_SIZE; i++)
+		{	for(unsigned int c=0; c<channel_count; c++)
+			{	pixel_array[i * channel_count + c] = c < channel_count - 1 ? bake->empty_value[c] : 0.0f;
+			}
+		}
+		for(int ty=y_start; ty<y_end; ty++)
+		{	memset(bake->coverage_array + (size_t)ty * bake->width + x_start, MODEL_BAKE_COVERAGE_EMPTY, x_end - x_start);
+		}
+
+		for(unsigned int i=texel_start; i<texel_end; i+=MODEL_RAY_PACKET_SIZE)
+		{
+			packet.clear();
+			for(unsigned int j=i; j<std::min(i + MODEL_RAY_PACKET_SIZE, texel_end); j++)
+			{	model_bake_texel_s& texel = texel_array[packet.count];
+				model_bake_get_texel_ray(*bake, raster->triangle_array[j], raster->weight_array[j * 2], raster->weight_array[j * 2 + 1], texel);
+				packet.add(texel.origin, texel.direction, 0.0f, texel.t_max);
+			}
+			model_ray_intersect_packet(*bake->mesh, packet, MODEL_RAY_TEST_WATERTIGHT, hit);
+			for(unsigned int j=0; j<packet.count; j++)
+			{	texel_array[j].hit_triangle	= hit.triangle[j];
+				texel_array[j].t			= hit.t[j];
+				texel_array[j].u			= hit.u[j];
+				texel_array[j].v			= hit.v[j];
+				pixel						= &pixel_array[raster->texel_array[i + j] * channel_count];
+				model_raster_get_texel_position(*raster, tile, i + j, x, y);
+				(*texel_body)(texel_array[j], x, y, pixel);
+
+				// Blend toward the empty value by the inverted mask.
+				if(bake->mask_pixel_array)
+				{	mask = bake->mask_pixel_array[(size_t)y * bake->width + x] * (1.0f / 65535.0f);
+					for(unsigned int c=0; c<channel_count - 1; c++)
+					{	pixel[c] = pixel[c] * mask + bake->empty_value[c] * (1.0f - mask);
+					}
+					if(bake->is_normal)
+					{	model_bake_normalize(pixel);
+					}
+				}
+				pixel[channel_count - 1] = 1.0f;
+				bake->coverage_array[(size_t)y * bake->width + x] = MODEL_BAKE_COVERAGE_BAKED;
+			}
+		}
+
+		// Write each row of the tile to the map.
+		for(int ty=y_start; ty<y_end; ty++)
+		{	half_batch_from_float(&pixel_array[(ty - y_start) * MODEL_RASTER_TILE_SIZE * channel_count],
+								  bake->map_pixel_array + ((size_t)ty * bake->width + x_start) * channel_count, (size_t)(x_end - x_start) * channel_count);
+		}
+	}
+	return TRUE;
+}
+
+// Pad the empty texels of the rows. Normals are normalized, other values are divided by the neighbor count.
+BOOL model_bake_pad_body_s::operator()(unsigned int y_start, unsigned int y_end) const
+{
+	// Local data
+	unsigned char								coverage;
+	unsigned int								count;
+	float										value[4];
+	const unsigned short*						neighbor;
+	int											nx, ny;
+	const unsigned int							channel_count = bake->get_channel_count();
+
+
+	for(int y=(int)y_start; y<(int)y_end; y++)
+	{	for(int x=0; x<(int)bake->width; x++)
+		{
+			if(bake->coverage_array[(size_t)y * bake->width + x] != MODEL_BAKE_COVERAGE_EMPTY)
+			{	continue;
+			}
+			value[0] = value[1] = value[2] = value[3] = 0.0f;
+			count = 0;
+			for(int dy=-1; dy<=1; dy++)
+			{	for(int dx=-1; dx<=1; dx++)
+				{
+					nx = x + dx;
+					ny = y + dy;
+					if(nx < 0 || ny < 0 || nx >= (int)bake->width || ny >= (int)bake->height)
+					{	continue;
+					}
+					coverage = bake->coverage_array[(size_t)ny * bake->width + nx];
+					if(coverage == MODEL_BAKE_COVERAGE_EMPTY || coverage > MODEL_BAKE_COVERAGE_BAKED + pass - 1)
+					{	continue;
+					}
+					neighbor = bake->map_pixel_array + ((size_t)ny * bake->width + nx) * channel_count;
+					for(unsigned int c=0; c<channel_count - 1; c++)
+					{	value[c] += half_batch_scalar_to_float(neighbor[c]);
+					}
+					count++;
+				}
+			}
+			if(!count)
+			{	continue;
+			}
+			if(bake->is_normal)
+			{	model_bake_normalize(value);
+			}
+			else
+			{	for(unsigned int c=0; c<channel_count - 1; c++)
+				{	value[c] /= (float)count;
+				}
+			}
+			value[channel_count - 1] = 1.0f;
+			half_batch_from_float(value, bake->map_pixel_array + ((size_t)y * bake->width + x) * channel_count, channel_count);
+			bake->coverage_array[(size_t)y * bake->width + x] = (unsigned char)(MODEL_BAKE_COVERAGE_BAKED + pass);
+		}
+	}
+	return TRUE;
+}
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Model bake functions
+
+// Release the ray mesh, raster and mask of a bake. The map pixels stay with ShaderMap.
+void model_bake_release(model_bake_s& bake)
+{
+	if(bake.mask_pixel_array)
+	{	plugin_mask_release(bake.mask_pixel_array);
+	}
+	model_raster_release(bake.raster);
+	model_ray_release(bake.mesh);
+	bake.mask_pixel_array	= 0;
+	bake.raster				= 0;
+	bake.mesh				= 0;
+}
+
+// Get the models of inputs low_input and high_input, the ray mesh of the high poly model and the raster of the low poly model,
+// shared with other maps, and the mask if is_use_mask. Then create the map. The cage is used only if it has the triangles of the
+// low poly model. width, height and create_info must be set. Progress is set from 0 to progress_end. Returns FALSE and logs
+// an error on failure or if cancelled, nothing is left to release.
+BOOL model_bake_begin(unsigned int map_id, unsigned int low_input, unsigned int high_input, BOOL is_use_mask, BOOL is_invert_mask,
+					  unsigned int progress_end, model_bake_s& bake)
+{
+	mp_get_input_model(map_id, low_input, FALSE, bake.low);
+	mp_get_input_model(map_id, low_input, TRUE, bake.cage);
+	mp_get_input_model(map_id, high_input, FALSE, bake.high);
+	if(!bake.low.is_valid() || !bake.high.is_valid())
+	{	LOG_ERROR_MSG(map_id, _T("Invalid model input. Both a low poly and a high poly model are required."));
+		return FALSE;
+	}
+	bake.is_cage = bake.cage.is_valid() && bake.cage.index_count == bake.low.index_count && bake.cage.vertex_count == bake.low.vertex_count;
+
+	// -----------------
+
+	// Building the ray mesh takes most of the time. See "map_model_ray.cpp".
+	bake.mesh = model_ray_get(map_id, high_input, FALSE, bake.high, parallel_get_progress(map_id, 0, progress_end * 4 / 5));
+	if(!bake.mesh)
+	{	if(!mp_is_cancel_process())
+		{	LOG_ERROR_MSG(map_id, _T("Failed to build the high poly ray mesh. Out of memory."));
+		}
+		return FALSE;
+	}
+
+	// See "map_model_raster.cpp".
+	bake.raster = model_raster_get(map_id, low_input, bake.low, bake.width, bake.height, MODEL_RASTER_UDIM_FIRST, FALSE,
+								   parallel_get_progress(map_id, progress_end * 4 / 5, progress_end));
+	if(!bake.raster)
+	{	model_bake_release(bake);
+		if(!mp_is_cancel_process())
+		{	LOG_ERROR_MSG(map_id, _T("Failed to rasterize the low poly model. Out of memory."));
+		}
+		return FALSE;
+	}
+	try
+	{	bake.coverage_list.resize((size_t)bake.width * bake.height);
+	}
+	catch(...)
+	{	model_bake_release(bake);
+		LOG_ERROR_MSG(map_id, _T("Memory Allocation Error: Failed to allocate the coverage list."));
+		return FALSE;
+	}
+	bake.coverage_array = bake.coverage_list.data();
+
+	// Get the mask at the map size, inverted if required. 0 if the mask is disabled or no mask is set.
+	bake.mask_pixel_array = is_use_mask ? plugin_mask_get(map_id, bake.width, bake.height, is_invert_mask) : 0;
+
+	// -----------------
+
+	// The tiles write straight into the map pixels owned by ShaderMap. See "map_create_stream.cpp".
+	bake.create_info.width	= bake.width;
+	bake.create_info.height	= bake.height;
+	bake.map_pixel_array	= (unsigned short*)map_stream_begin(map_id, bake.create_info);
+	if(!bake.map_pixel_array)
+	{	model_bake_release(bake);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+// Bake a row of tiles at a time on all threads with texel_body and show it in ShaderMap, then grow the baked texels by padding
+// texels, one texel per pass. Progress is set from progress_start to 100. The bake is released. Returns FALSE if cancelled.
+template<class TEXEL_T>
+BOOL model_bake_run(unsigned int map_id, model_bake_s& bake, const TEXEL_T& texel_body, unsigned int padding, unsigned int progress_start)
+{
+	// Local data
+	model_bake_tile_body_s<TEXEL_T>				tile_body;
+	model_bake_pad_body_s						pad_body;
+
+
+	// Texels take very different times so each thread takes one tile at a time.
+	tile_body.bake			= &bake;
+	tile_body.texel_body	= &texel_body;
+	for(unsigned int i=0; i<bake.raster->tile_row_count; i++)
+	{
+		tile_body.tile_row = i;
+		if(!parallel_for(bake.raster->tile_column_count, 1, tile_body, parallel_progress_s()))
+		{	model_bake_release(bake);
+			return FALSE;
+		}
+		map_stream_update(map_id, bake.create_info, i * MODEL_RASTER_TILE_SIZE, std::min((i + 1) * MODEL_RASTER_TILE_SIZE, bake.height),
+						  progress_start, padding ? 90 : 100);
+	}
+	model_bake_release(bake);
+
+	// -----------------
+
+	pad_body.bake = &bake;
+	for(unsigned int i=1; i<=padding; i++)
+	{
+		pad_body.pass = i;
+		if(!parallel_for_rows(bake.height, MAP_STREAM_BAND_ROW_COUNT, pad_body, parallel_progress_s()))
+		{	return FALSE;
+		}
+		mp_set_map_progress(map_id, 90 + 10 * i / padding);
+	}
+	if(padding)
+	{	map_stream_update(map_id, bake.create_info, 0, bake.height, 100, 100);
+	}
+	return TRUE;
+}
+
+#endif // MAP_MODEL_BAKE_CPP
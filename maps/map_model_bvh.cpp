@@ -0,0 +1,1034 @@
+/*
+	===============================================================
+
+	SHADERMAP MAP MODEL BVH SOURCE FILE
+
+	Builds a bounding volume hierarchy over the triangles of a
+	model input (model_input_data_s) so that a map plugin can cast
+	rays against it, and caches it so that every map baked from
+	the same model uses one build.
+
+	The BVH is split with the surface area heuristic over
+	MODEL_BVH_BIN_COUNT bins of triangle centroids on each axis.
+	Nodes with more than MODEL_BVH_PARALLEL_COUNT triangles are
+	binned and partitioned on all cores. The nodes below them are
+	subtrees that are built on all cores, one thread each.
+
+	A node is 32 bytes, its bounds and two unsigned ints. The two
+	children of a node are next to each other in node_array so
+	that one index finds both. A leaf lists its triangles in
+	triangle_array, a triangle being its position in index_array
+	divided by 7. The BVH has no copy of the vertices, rays are
+	tested against the triangles of the model_input_data_s it was
+	built from.
+
+	model_bvh_get() finds the BVH of the model or the cage of an
+	input in the node cache (see "map_node_cache.cpp"), or builds
+	it and adds it as a shared entry of type CACHE_TYPE_MODEL or
+	CACHE_TYPE_CAGE. Shared entries are registered with
+	mp_register_node_cache(), so other plugins built with this
+	file get the BVH with mp_get_node_cache() instead of building
+	it again. They only read the members of model_bvh_s before
+	its lists.
+
+	Include this source code file in a map plugin after the plugin
+	core file. #include "../../map_model_bvh.cpp"
+
+	--
+
+	Example:
+
+	mp_get_input_model(map_id, 0, FALSE, model);
+	bvh = model_bvh_get(map_id, 0, FALSE, model, parallel_get_progress(map_id, 0, 20));
+	if(!bvh)
+	{	return FALSE;		// Cancelled or out of memory.
+	}
+	if(model_bvh_intersect(*bvh, model, origin, direction, 0.0f, FLT_MAX, hit))
+	{	... hit.triangle, hit.t, hit.u, hit.v ...
+	}
+	model_bvh_release(bvh);
+
+	Call the node cache functions from the plugin callbacks as
+	shown in "map_node_cache.cpp", node_cache_clear() and
+	parallel_shutdown() from on_shutdown().
+
+
+	SHADERMAP SDK LICENSE
+
+	The ShaderMap SDK is released under The MIT License (MIT)
+	http://opensource.org/licenses/MIT
+
+	Copyright (c) 2007-2019 Rendering Systems Inc.
+
+	Permission is hereby granted, free of charge, to any person
+	obtaining a copy of this software and associated documentation
+	files (the "Software"), to deal	in the Software without
+	restriction, including without limitation the rights to use,
+	copy, modify, merge, publish, distribute, sublicense, and/or
+	sell copies of the Software, and to permit persons to whom the
+	Software is	furnished to do so, subject to the following
+	conditions:
+
+	The above copyright notice and this permission notice shall be
+	included in	all copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+	OF MERCHANTABILITY,	FITNESS FOR A PARTICULAR PURPOSE AND
+	NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+	OTHER DEALINGS IN THE SOFTWARE.
+
+	Developed by: Neil Kemp at Rendering Systems Inc.
+
+	Online:		http://shadermap.com
+	Corporate:	http://renderingsystems.com
+
+	===============================================================
+*/
+
+#ifndef MAP_MODEL_BVH_CPP
+#define MAP_MODEL_BVH_CPP
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Model BVH includes
+
+#include "../common/plugin_thread_pool.cpp"
+#include "map_node_cache.cpp"
+#include <float.h>
+#include <limits.h>
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+#include <new>
+#include <string>
+#include <vector>
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Model BVH defines
+
+// Changed when the members of model_bvh_s before its lists change, so a BVH shared by an older plugin is not used.
+#define MODEL_BVH_VERSION						1
+
+// Names of the BVHs in the node cache. The version and the vertex and triangle counts are added to the name, see
+// model_bvh_get().
+#define MODEL_BVH_MODEL_CACHE_NAME				L"sdk_model_bvh"
+#define MODEL_BVH_CAGE_CACHE_NAME				L"sdk_cage_bvh"
+
+// Most bins of triangle centroids on each axis that splits are chosen from. Nodes with fewer triangles have one bin each.
+#define MODEL_BVH_BIN_COUNT						16
+
+// Most triangles a leaf has unless they can not be split.
+#define MODEL_BVH_LEAF_MAX						8
+
+// Cost of testing the bounds of a node, where testing a triangle costs 1.
+#define MODEL_BVH_TRAVERSAL_COST				1.0f
+
+// Nodes with more triangles are binned and partitioned on all cores, smaller ones are built as subtrees on one thread.
+#define MODEL_BVH_PARALLEL_COUNT				65536
+
+// Triangles in each chunk given to a thread.
+#define MODEL_BVH_CHUNK_SIZE					16384
+
+// Deepest node. Nodes at this depth are leaves, so a traversal stack of MODEL_BVH_STACK_SIZE never overflows.
+#define MODEL_BVH_MAX_DEPTH						62
+#define MODEL_BVH_STACK_SIZE					64
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Model BVH structs
+
+// A node of the BVH.
+struct model_bvh_node_s
+{
+	model_input_vector3_s						bounds_min;
+	unsigned int								first;						// Inner node - the first child, the second is first + 1. Leaf - the first entry in triangle_array.
+	model_input_vector3_s						bounds_max;
+	unsigned int								count;						// Leaf - its triangles. Inner node - 0.
+};
+
+static_assert(sizeof(model_bvh_node_s) == 32, "model_bvh_node_s must be 32 bytes.");
+
+// A BVH of the triangles of a model input. Node 0 is the root.
+struct model_bvh_s
+{
+	unsigned int								version;					// MODEL_BVH_VERSION
+	unsigned int								vertex_count;				// Of the model it was built from.
+	unsigned int								triangle_count;
+	unsigned int								node_count;
+	const model_bvh_node_s*						node_array;
+	const unsigned int*							triangle_array;				// Triangles of the leaves.
+
+	// Owned by the plugin that built the BVH. Other plugins only use the members above.
+	std::vector<model_bvh_node_s>				node_list;
+	std::vector<unsigned int>					triangle_list;
+
+	// c()
+	model_bvh_s(void)
+	{	version = MODEL_BVH_VERSION; vertex_count = 0; triangle_count = 0; node_count = 0; node_array = 0; triangle_array = 0;
+	}
+
+	// Return the bytes of the BVH.
+	unsigned long long get_byte_count(void) const
+	{	return sizeof(model_bvh_s) + (unsigned long long)node_list.capacity() * sizeof(model_bvh_node_s) + (unsigned long long)triangle_list.capacity() * sizeof(unsigned int);
+	}
+};
+
+// The closest triangle hit by a ray. The hit point is a + u * (b - a) + v * (c - a) of the triangle positions.
+struct model_bvh_hit_s
+{
+	unsigned int								triangle;					// Its position in index_array / 7.
+	float										t;							// Distance along the ray in lengths of its direction.
+	float										u;
+	float										v;
+};
+
+// A triangle while the BVH is built. Centroids are kept as bounds_min + bounds_max, twice the centroid.
+struct model_bvh_ref_s
+{
+	float										bounds_min[3];
+	unsigned int								triangle;
+	float										bounds_max[3];
+};
+
+// Bounds of triangles and of their centroids.
+struct model_bvh_bounds_s
+{
+	float										bounds_min[3];
+	float										bounds_max[3];
+	float										centroid_min[3];
+	float										centroid_max[3];
+
+	// Set empty bounds.
+	void clear(void)
+	{	for(unsigned int i=0; i<3; i++)
+		{	bounds_min[i] = centroid_min[i] = FLT_MAX; bounds_max[i] = centroid_max[i] = -FLT_MAX;
+		}
+	}
+
+	// Grow to hold a triangle.
+	void add(const model_bvh_ref_s& ref)
+	{	for(unsigned int i=0; i<3; i++)
+		{	float centroid = ref.bounds_min[i] + ref.bounds_max[i];
+			bounds_min[i]	= std::min(bounds_min[i], ref.bounds_min[i]);	bounds_max[i]	= std::max(bounds_max[i], ref.bounds_max[i]);
+			centroid_min[i]	= std::min(centroid_min[i], centroid);			centroid_max[i]	= std::max(centroid_max[i], centroid);
+		}
+	}
+
+	// Grow to hold other bounds.
+	void add(const model_bvh_bounds_s& other)
+	{	for(unsigned int i=0; i<3; i++)
+		{	bounds_min[i]	= std::min(bounds_min[i], other.bounds_min[i]);		bounds_max[i]	= std::max(bounds_max[i], other.bounds_max[i]);
+			centroid_min[i]	= std::min(centroid_min[i], other.centroid_min[i]);	centroid_max[i]	= std::max(centroid_max[i], other.centroid_max[i]);
+		}
+	}
+
+	// Return half the surface area of the bounds.
+	float get_half_area(void) const
+	{	float x = bounds_max[0] - bounds_min[0], y = bounds_max[1] - bounds_min[1], z = bounds_max[2] - bounds_min[2];
+		return (x < 0.0f || y < 0.0f || z < 0.0f) ? 0.0f : x * y + y * z + z * x;
+	}
+};
+
+// A bin of triangle centroids.
+struct model_bvh_bin_s
+{
+	model_bvh_bounds_s							bounds;
+	unsigned int								count;
+};
+
+// The bins of a node on all three axes.
+struct model_bvh_bin_set_s
+{
+	model_bvh_bin_s								bin_array[3][MODEL_BVH_BIN_COUNT];
+	unsigned int								bin_count;
+	float										centroid_min[3];			// Maps centroids to bins.
+	float										bin_scale[3];				// 0 on an axis where all centroids are equal.
+
+	// Empty the bins and set how the centroids in bounds of a node with count triangles are binned.
+	void clear(const model_bvh_bounds_s& bounds, unsigned int count)
+	{	bin_count = std::max<unsigned int>(2, std::min<unsigned int>(count, MODEL_BVH_BIN_COUNT));
+		for(unsigned int axis=0; axis<3; axis++)
+		{	float extent		= bounds.centroid_max[axis] - bounds.centroid_min[axis];
+			centroid_min[axis]	= bounds.centroid_min[axis];
+			bin_scale[axis]		= extent > 0.0f ? bin_count / extent : 0.0f;
+			for(unsigned int i=0; i<bin_count; i++)
+			{	bin_array[axis][i].bounds.clear();
+				bin_array[axis][i].count = 0;
+			}
+		}
+	}
+
+	// Return the bin of a triangle on axis. NaN bins as 0.
+	unsigned int get_bin(const model_bvh_ref_s& ref, unsigned int axis) const
+	{	float position = (ref.bounds_min[axis] + ref.bounds_max[axis] - centroid_min[axis]) * bin_scale[axis];
+		return position > 0.0f ? (position < bin_count - 1 ? (unsigned int)position : bin_count - 1) : 0;
+	}
+
+	// Add the triangles of ref_array to the bins.
+	void add(const model_bvh_ref_s* ref_array, unsigned int count)
+	{	for(unsigned int i=0; i<count; i++)
+		{	for(unsigned int axis=0; axis<3; axis++)
+			{	if(bin_scale[axis] > 0.0f)
+				{	model_bvh_bin_s& bin = bin_array[axis][get_bin(ref_array[i], axis)];
+					bin.bounds.add(ref_array[i]);
+					bin.count++;
+				}
+			}
+		}
+	}
+
+	// Add the bins of other, binned with the same bounds.
+	void add(const model_bvh_bin_set_s& other)
+	{	for(unsigned int axis=0; axis<3; axis++)
+		{	for(unsigned int i=0; i<bin_count; i++)
+			{	bin_array[axis][i].bounds.add(other.bin_array[axis][i].bounds);
+				bin_array[axis][i].count += other.bin_array[axis][i].count;
+			}
+		}
+	}
+};
+
+// The split of a node. Triangles in bins up to and including bin of axis go to the first child.
+struct model_bvh_split_s
+{
+	unsigned int								axis;
+	unsigned int								bin;
+	float										cost;
+	model_bvh_bounds_s							bounds[2];					// Of the two children.
+	unsigned int								count[2];
+};
+
+// A node to split. The node has its bounds set.
+struct model_bvh_task_s
+{
+	unsigned int								node;
+	unsigned int								start;						// Its triangles in ref_list.
+	unsigned int								end;
+	unsigned int								depth;
+	model_bvh_bounds_s							bounds;
+};
+
+// The state of model_bvh_build().
+struct model_bvh_build_s
+{
+	const model_input_data_s*					model;
+	model_bvh_s*								bvh;
+	unsigned int								triangle_count;
+	std::vector<model_bvh_ref_s>				ref_list;
+	std::vector<model_bvh_ref_s>				swap_list;					// ref_list is partitioned into it and copied back.
+	std::vector<model_bvh_node_s>				top_node_list;				// Nodes split on all cores.
+	std::vector<model_bvh_task_s>				subtree_list;				// Nodes built on one thread.
+	std::vector<std::vector<model_bvh_node_s> >	subtree_node_list;			// The nodes of each subtree, node 0 is the subtree node.
+	std::vector<unsigned int>					subtree_start_list;			// Position of node 1 of each subtree in node_list.
+
+	// The node being split on all cores.
+	model_bvh_task_s							task;
+	model_bvh_split_s							split;
+	const model_bvh_bin_set_s*					bin_set;
+	std::vector<model_bvh_bin_set_s>			chunk_bin_list;
+	std::vector<model_bvh_bounds_s>				chunk_bounds_list;
+	std::vector<unsigned int>					chunk_offset_list;			// Triangles of each chunk that go to the first child, then their offsets.
+};
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Model BVH build functions
+
+// Choose the split of a node with count triangles from its bins. Returns FALSE if it has no split, when all centroids are equal.
+BOOL model_bvh_find_split(const model_bvh_bin_set_s& bin_set, unsigned int count, float half_area, model_bvh_split_s& split_out)
+{
+	// Local data
+	model_bvh_bounds_s							bounds;
+	float										right_cost[MODEL_BVH_BIN_COUNT];
+	unsigned int								right_count;
+	BOOL										is_split;
+
+
+	is_split		= FALSE;
+	split_out.cost	= FLT_MAX;
+	for(unsigned int axis=0; axis<3; axis++)
+	{	if(!(bin_set.bin_scale[axis] > 0.0f))
+		{	continue;
+		}
+		const model_bvh_bin_s* bin_array = bin_set.bin_array[axis];
+
+		// Area times count of the bins right of each split, then sweep from the left.
+		bounds.clear();
+		right_count = 0;
+		for(unsigned int i=bin_set.bin_count-1; i>0; i--)
+		{	bounds.add(bin_array[i].bounds);
+			right_count		+= bin_array[i].count;
+			right_cost[i-1]	= right_count ? bounds.get_half_area() * right_count : FLT_MAX;
+		}
+		bounds.clear();
+		right_count = count;
+		for(unsigned int i=0; i<bin_set.bin_count-1; i++)
+		{	bounds.add(bin_array[i].bounds);
+			right_count -= bin_array[i].count;
+			if(!right_count || right_count == count)
+			{	continue;
+			}
+			float cost = MODEL_BVH_TRAVERSAL_COST + (bounds.get_half_area() * (count - right_count) + right_cost[i]) / std::max(half_area, FLT_MIN);
+			if(cost < split_out.cost)
+			{	split_out.axis	= axis;
+				split_out.bin	= i;
+				split_out.cost	= cost;
+				is_split		= TRUE;
+			}
+		}
+	}
+	if(!is_split)
+	{	return FALSE;
+	}
+
+	// Bounds of the children.
+	split_out.bounds[0].clear();
+	split_out.bounds[1].clear();
+	split_out.count[0] = split_out.count[1] = 0;
+	for(unsigned int i=0; i<bin_set.bin_count; i++)
+	{	const model_bvh_bin_s& bin = bin_set.bin_array[split_out.axis][i];
+		split_out.bounds[i > split_out.bin].add(bin.bounds);
+		split_out.count[i > split_out.bin] += bin.count;
+	}
+	return TRUE;
+}
+
+// Set the bounds of a node.
+inline void model_bvh_set_node_bounds(model_bvh_node_s& node, const model_bvh_bounds_s& bounds)
+{
+	node.bounds_min.x = bounds.bounds_min[0]; node.bounds_min.y = bounds.bounds_min[1]; node.bounds_min.z = bounds.bounds_min[2];
+	node.bounds_max.x = bounds.bounds_max[0]; node.bounds_max.y = bounds.bounds_max[1]; node.bounds_max.z = bounds.bounds_max[2];
+}
+
+// Split the triangles of a node with equal centroids at their middle. Sets the bounds of both halves.
+void model_bvh_split_middle(const model_bvh_ref_s* ref_array, unsigned int count, model_bvh_split_s& split_out)
+{
+	split_out.count[0] = count / 2;
+	split_out.count[1] = count - count / 2;
+	split_out.bounds[0].clear();
+	split_out.bounds[1].clear();
+	for(unsigned int i=0; i<count; i++)
+	{	split_out.bounds[i >= count / 2].add(ref_array[i]);
+	}
+}
+
+// Build the subtree of a task on this thread into node_list_out. Node 0 of the list is the task node, the children of
+// node i are given as indices in the list.
+BOOL model_bvh_build_subtree(model_bvh_ref_s* ref_array, const model_bvh_task_s& subtree, std::vector<model_bvh_node_s>& node_list_out)
+{
+	// Local data
+	std::vector<model_bvh_task_s>				stack;
+	model_bvh_task_s							task, child;
+	model_bvh_split_s							split;
+	model_bvh_bin_set_s							bin_set;
+	unsigned int								count;
+	BOOL										is_split;
+
+
+	try
+	{	node_list_out.resize(1);
+		model_bvh_set_node_bounds(node_list_out[0], subtree.bounds);
+		task		= subtree;
+		task.node	= 0;
+		stack.push_back(task);
+		while(!stack.empty())
+		{
+			task = stack.back();
+			stack.pop_back();
+			count = task.end - task.start;
+
+			// Split with the lowest cost, or at the middle if all centroids are equal and there are too many to be a leaf.
+			is_split = FALSE;
+			if(count > 1 && task.depth < MODEL_BVH_MAX_DEPTH)
+			{	bin_set.clear(task.bounds, count);
+				bin_set.add(ref_array + task.start, count);
+				if(model_bvh_find_split(bin_set, count, task.bounds.get_half_area(), split))
+				{	is_split = split.cost < count || count > MODEL_BVH_LEAF_MAX;
+					if(is_split)
+					{	std::partition(ref_array + task.start, ref_array + task.end,
+									   [&](const model_bvh_ref_s& ref) { return bin_set.get_bin(ref, split.axis) <= split.bin; });
+					}
+				}
+				else if(count > MODEL_BVH_LEAF_MAX)
+				{	model_bvh_split_middle(ref_array + task.start, count, split);
+					is_split = TRUE;
+				}
+			}
+			if(!is_split)
+			{	node_list_out[task.node].first = task.start;
+				node_list_out[task.node].count = count;
+				continue;
+			}
+
+			node_list_out[task.node].first = (unsigned int)node_list_out.size();
+			node_list_out[task.node].count = 0;
+			node_list_out.resize(node_list_out.size() + 2);
+			for(unsigned int i=0; i<2; i++)
+			{	child.node		= node_list_out[task.node].first + i;
+				child.start		= i ? task.start + split.count[0] : task.start;
+				child.end		= i ? task.end : task.start + split.count[0];
+				child.depth		= task.depth + 1;
+				child.bounds	= split.bounds[i];
+				model_bvh_set_node_bounds(node_list_out[child.node], child.bounds);
+				stack.push_back(child);
+			}
+		}
+	}
+	catch(...)
+	{	return FALSE;
+	}
+	return TRUE;
+}
+
+// Make a ref of each triangle and the bounds of each chunk.
+struct model_bvh_ref_body_s
+{
+	model_bvh_build_s*							build;
+
+	BOOL operator()(unsigned int chunk_start, unsigned int chunk_end) const
+	{	const model_input_vertex_s*	vertex_array	= build->model->vertex_array;
+		const unsigned int*			index_array		= build->model->index_array;
+		for(unsigned int chunk=chunk_start; chunk<chunk_end; chunk++)
+		{	model_bvh_bounds_s&	bounds	= build->chunk_bounds_list[chunk];
+			unsigned int		end		= std::min<unsigned int>((chunk + 1) * MODEL_BVH_CHUNK_SIZE, build->triangle_count);
+			bounds.clear();
+			for(unsigned int i=chunk*MODEL_BVH_CHUNK_SIZE; i<end; i++)
+			{	const unsigned int*				index	= index_array + (size_t)i * 7;
+				const model_input_vector3_s&	a		= vertex_array[index[0]].position;
+				const model_input_vector3_s&	b		= vertex_array[index[1]].position;
+				const model_input_vector3_s&	c		= vertex_array[index[2]].position;
+				model_bvh_ref_s&				ref		= build->ref_list[i];
+				ref.bounds_min[0] = std::min(std::min(a.x, b.x), c.x); ref.bounds_max[0] = std::max(std::max(a.x, b.x), c.x);
+				ref.bounds_min[1] = std::min(std::min(a.y, b.y), c.y); ref.bounds_max[1] = std::max(std::max(a.y, b.y), c.y);
+				ref.bounds_min[2] = std::min(std::min(a.z, b.z), c.z); ref.bounds_max[2] = std::max(std::max(a.z, b.z), c.z);
+				ref.triangle = i;
+				bounds.add(ref);
+			}
+		}
+		return TRUE;
+	}
+};
+
+// Bin the triangles of each chunk of the node being split.
+struct model_bvh_bin_body_s
+{
+	model_bvh_build_s*							build;
+
+	BOOL operator()(unsigned int chunk_start, unsigned int chunk_end) const
+	{	const model_bvh_task_s& task = build->task;
+		for(unsigned int chunk=chunk_start; chunk<chunk_end; chunk++)
+		{	unsigned int	start	= task.start + chunk * MODEL_BVH_CHUNK_SIZE;
+			unsigned int	end		= std::min<unsigned int>(start + MODEL_BVH_CHUNK_SIZE, task.end);
+			build->chunk_bin_list[chunk].clear(task.bounds, task.end - task.start);
+			build->chunk_bin_list[chunk].add(&build->ref_list[start], end - start);
+		}
+		return TRUE;
+	}
+};
+
+// Count the triangles of each chunk of the node being split that go to the first child.
+struct model_bvh_count_body_s
+{
+	model_bvh_build_s*							build;
+
+	BOOL operator()(unsigned int chunk_start, unsigned int chunk_end) const
+	{	const model_bvh_task_s& task = build->task;
+		for(unsigned int chunk=chunk_start; chunk<chunk_end; chunk++)
+		{	unsigned int	start	= task.start + chunk * MODEL_BVH_CHUNK_SIZE;
+			unsigned int	end		= std::min<unsigned int>(start + MODEL_BVH_CHUNK_SIZE, task.end);
+			unsigned int	count	= 0;
+			for(unsigned int i=start; i<end; i++)
+			{	count += build->bin_set->get_bin(build->ref_list[i], build->split.axis) <= build->split.bin;
+			}
+			build->chunk_offset_list[chunk] = count;
+		}
+		return TRUE;
+	}
+};
+
+// Write the triangles of each chunk of the node being split to swap_list, first child first, in order.
+struct model_bvh_scatter_body_s
+{
+	model_bvh_build_s*							build;
+
+	BOOL operator()(unsigned int chunk_start, unsigned int chunk_end) const
+	{	const model_bvh_task_s& task = build->task;
+		for(unsigned int chunk=chunk_start; chunk<chunk_end; chunk++)
+		{	unsigned int	start			= task.start + chunk * MODEL_BVH_CHUNK_SIZE;
+			unsigned int	end				= std::min<unsigned int>(start + MODEL_BVH_CHUNK_SIZE, task.end);
+			unsigned int	left_offset		= task.start + build->chunk_offset_list[chunk];
+			unsigned int	right_offset	= task.start + build->split.count[0] + (start - task.start) - build->chunk_offset_list[chunk];
+			for(unsigned int i=start; i<end; i++)
+			{	const model_bvh_ref_s& ref = build->ref_list[i];
+				if(build->bin_set->get_bin(ref, build->split.axis) <= build->split.bin)
+				{	build->swap_list[left_offset++] = ref;
+				}
+				else
+				{	build->swap_list[right_offset++] = ref;
+				}
+			}
+		}
+		return TRUE;
+	}
+};
+
+// Copy each chunk of the node being split back from swap_list.
+struct model_bvh_copy_body_s
+{
+	model_bvh_build_s*							build;
+
+	BOOL operator()(unsigned int chunk_start, unsigned int chunk_end) const
+	{	const model_bvh_task_s& task = build->task;
+		unsigned int start	= task.start + chunk_start * MODEL_BVH_CHUNK_SIZE;
+		unsigned int end	= std::min<unsigned int>(task.start + chunk_end * MODEL_BVH_CHUNK_SIZE, task.end);
+		memcpy(&build->ref_list[start], &build->swap_list[start], (size_t)(end - start) * sizeof(model_bvh_ref_s));
+		return TRUE;
+	}
+};
+
+// Build each subtree on one thread.
+struct model_bvh_subtree_body_s
+{
+	model_bvh_build_s*							build;
+
+	BOOL operator()(unsigned int subtree_start, unsigned int subtree_end) const
+	{	for(unsigned int i=subtree_start; i<subtree_end; i++)
+		{	if(!model_bvh_build_subtree(build->ref_list.data(), build->subtree_list[i], build->subtree_node_list[i]))
+			{	return FALSE;
+			}
+		}
+		return TRUE;
+	}
+};
+
+// Copy the nodes of each subtree to node_list, renumbering their children, and free them.
+struct model_bvh_gather_body_s
+{
+	model_bvh_build_s*							build;
+
+	BOOL operator()(unsigned int subtree_start, unsigned int subtree_end) const
+	{	for(unsigned int i=subtree_start; i<subtree_end; i++)
+		{	std::vector<model_bvh_node_s>&	subtree_node_list	= build->subtree_node_list[i];
+			unsigned int					start				= build->subtree_start_list[i];
+			for(size_t j=0; j<subtree_node_list.size(); j++)
+			{	model_bvh_node_s node = subtree_node_list[j];
+				if(!node.count)
+				{	node.first += start - 1;
+				}
+				build->bvh->node_list[j ? start + j - 1 : build->subtree_list[i].node] = node;
+			}
+			std::vector<model_bvh_node_s>().swap(subtree_node_list);
+		}
+		return TRUE;
+	}
+};
+
+// Make the triangle list of the BVH.
+struct model_bvh_triangle_body_s
+{
+	model_bvh_build_s*							build;
+
+	BOOL operator()(unsigned int index_start, unsigned int index_end) const
+	{	for(unsigned int i=index_start; i<index_end; i++)
+		{	build->bvh->triangle_list[i] = build->ref_list[i].triangle;
+		}
+		return TRUE;
+	}
+};
+
+// Split a node on all cores. Adds its children to the nodes split on all cores or to the subtrees.
+BOOL model_bvh_split_top(model_bvh_build_s& build, const model_bvh_task_s& task, std::vector<model_bvh_task_s>& task_list_in_out)
+{
+	// Local data
+	model_bvh_bin_body_s						bin_body;
+	model_bvh_count_body_s						count_body;
+	model_bvh_scatter_body_s					scatter_body;
+	model_bvh_copy_body_s						copy_body;
+	model_bvh_bin_set_s							bin_set;
+	model_bvh_task_s							child;
+	unsigned int								count, chunk_count, offset, chunk_left_count;
+
+
+	build.task	= task;
+	count		= task.end - task.start;
+	chunk_count	= (count + MODEL_BVH_CHUNK_SIZE - 1) / MODEL_BVH_CHUNK_SIZE;
+	try
+	{	build.chunk_bin_list.resize(chunk_count);
+		build.chunk_offset_list.resize(chunk_count);
+	}
+	catch(...)
+	{	return FALSE;
+	}
+
+	// Bin on all cores and choose the split. Nodes this large always split.
+	bin_body.build = &build;
+	if(!parallel_for(chunk_count, 1, bin_body, parallel_progress_s()))
+	{	return FALSE;
+	}
+	bin_set.clear(task.bounds, count);
+	for(unsigned int i=0; i<chunk_count; i++)
+	{	bin_set.add(build.chunk_bin_list[i]);
+	}
+	build.bin_set = &bin_set;
+	if(!model_bvh_find_split(bin_set, count, task.bounds.get_half_area(), build.split))
+	{	model_bvh_split_middle(&build.ref_list[task.start], count, build.split);
+	}
+	else
+	{
+		// Partition into swap_list keeping the order of each child, then copy back.
+		count_body.build = &build;
+		if(!parallel_for(chunk_count, 1, count_body, parallel_progress_s()))
+		{	return FALSE;
+		}
+		offset = 0;
+		for(unsigned int i=0; i<chunk_count; i++)
+		{	chunk_left_count				= build.chunk_offset_list[i];
+			build.chunk_offset_list[i]		= offset;
+			offset							+= chunk_left_count;
+		}
+		scatter_body.build	= &build;
+		copy_body.build		= &build;
+		if(!parallel_for(chunk_count, 1, scatter_body, parallel_progress_s()) ||
+		   !parallel_for(chunk_count, 1, copy_body, parallel_progress_s()))
+		{	return FALSE;
+		}
+	}
+
+	// Add the children.
+	try
+	{	model_bvh_node_s& node = build.top_node_list[task.node];
+		node.first = (unsigned int)build.top_node_list.size();
+		node.count = 0;
+		build.top_node_list.resize(build.top_node_list.size() + 2);
+		for(unsigned int i=0; i<2; i++)
+		{	child.node		= build.top_node_list[task.node].first + i;
+			child.start		= i ? task.start + build.split.count[0] : task.start;
+			child.end		= i ? task.end : task.start + build.split.count[0];
+			child.depth		= task.depth + 1;
+			child.bounds	= build.split.bounds[i];
+			model_bvh_set_node_bounds(build.top_node_list[child.node], child.bounds);
+			if(child.end - child.start > MODEL_BVH_PARALLEL_COUNT && child.depth < MODEL_BVH_MAX_DEPTH)
+			{	task_list_in_out.push_back(child);
+			}
+			else
+			{	build.subtree_list.push_back(child);
+			}
+		}
+	}
+	catch(...)
+	{	return FALSE;
+	}
+	return TRUE;
+}
+
+// Build a BVH of the triangles of model into bvh_out, setting progress as the subtrees are built. Returns FALSE if
+// cancelled or out of memory. The vertex indices of model must be in range.
+BOOL model_bvh_build(const model_input_data_s& model, model_bvh_s& bvh_out, const parallel_progress_s& progress)
+{
+	// Local data
+	model_bvh_build_s							build;
+	model_bvh_ref_body_s						ref_body;
+	model_bvh_subtree_body_s					subtree_body;
+	model_bvh_gather_body_s						gather_body;
+	model_bvh_triangle_body_s					triangle_body;
+	std::vector<model_bvh_task_s>				task_list;
+	model_bvh_task_s							task;
+	unsigned int								chunk_count;
+	unsigned long long							node_count;
+
+
+	bvh_out					= model_bvh_s();
+	bvh_out.vertex_count	= model.vertex_count;
+	build.model				= &model;
+	build.bvh				= &bvh_out;
+	build.triangle_count	= model.index_count / 7;
+	if(!build.triangle_count || !model.vertex_array || !model.index_array)
+	{	return TRUE;
+	}
+	chunk_count = (build.triangle_count + MODEL_BVH_CHUNK_SIZE - 1) / MODEL_BVH_CHUNK_SIZE;
+	try
+	{	build.ref_list.resize(build.triangle_count);
+		build.chunk_bounds_list.resize(chunk_count);
+		build.top_node_list.resize(1);
+		if(build.triangle_count > MODEL_BVH_PARALLEL_COUNT)
+		{	build.swap_list.resize(build.triangle_count);
+		}
+	}
+	catch(...)
+	{	return FALSE;
+	}
+
+	// Bound each triangle, then the root.
+	ref_body.build = &build;
+	if(!parallel_for(chunk_count, 1, ref_body, parallel_progress_s()))
+	{	return FALSE;
+	}
+	task.node	= 0;
+	task.start	= 0;
+	task.end	= build.triangle_count;
+	task.depth	= 0;
+	task.bounds.clear();
+	for(unsigned int i=0; i<chunk_count; i++)
+	{	task.bounds.add(build.chunk_bounds_list[i]);
+	}
+	model_bvh_set_node_bounds(build.top_node_list[0], task.bounds);
+	std::vector<model_bvh_bounds_s>().swap(build.chunk_bounds_list);
+
+	// Split the large nodes on all cores until the rest are subtrees, then build the subtrees.
+	try
+	{	if(build.triangle_count > MODEL_BVH_PARALLEL_COUNT)
+		{	task_list.push_back(task);
+		}
+		else
+		{	build.subtree_list.push_back(task);
+		}
+		while(!task_list.empty())
+		{	task = task_list.back();
+			task_list.pop_back();
+			if(!model_bvh_split_top(build, task, task_list))
+			{	return FALSE;
+			}
+		}
+		std::vector<model_bvh_ref_s>().swap(build.swap_list);
+		build.subtree_node_list.resize(build.subtree_list.size());
+		build.subtree_start_list.resize(build.subtree_list.size());
+	}
+	catch(...)
+	{	return FALSE;
+	}
+
+	// Largest first so that a large one does not start last.
+	std::sort(build.subtree_list.begin(), build.subtree_list.end(),
+			  [](const model_bvh_task_s& a, const model_bvh_task_s& b) { return a.end - a.start > b.end - b.start; });
+	subtree_body.build = &build;
+	if(!parallel_for((unsigned int)build.subtree_list.size(), 1, subtree_body, progress))
+	{	return FALSE;
+	}
+
+	// Put the nodes of the subtrees after the top nodes.
+	node_count = build.top_node_list.size();
+	for(size_t i=0; i<build.subtree_list.size(); i++)
+	{	build.subtree_start_list[i] = (unsigned int)std::min<unsigned long long>(node_count, UINT_MAX);
+		node_count += build.subtree_node_list[i].size() - 1;
+	}
+	if(node_count > UINT_MAX)
+	{	return FALSE;
+	}
+	try
+	{	bvh_out.node_list.resize((size_t)node_count);
+		bvh_out.triangle_list.resize(build.triangle_count);
+	}
+	catch(...)
+	{	return FALSE;
+	}
+	std::copy(build.top_node_list.begin(), build.top_node_list.end(), bvh_out.node_list.begin());
+	gather_body.build	= &build;
+	triangle_body.build	= &build;
+	if(!parallel_for((unsigned int)build.subtree_list.size(), 1, gather_body, parallel_progress_s()) ||
+	   !parallel_for(build.triangle_count, MODEL_BVH_CHUNK_SIZE, triangle_body, parallel_progress_s()))
+	{	bvh_out = model_bvh_s();
+		return FALSE;
+	}
+
+	bvh_out.triangle_count	= build.triangle_count;
+	bvh_out.node_count		= (unsigned int)node_count;
+	bvh_out.node_array		= bvh_out.node_list.data();
+	bvh_out.triangle_array	= bvh_out.triangle_list.data();
+	return TRUE;
+}
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Model BVH functions
+
+// Return TRUE if bvh was built from a model with the counts of model.
+inline BOOL model_bvh_is_match(const model_bvh_s* bvh, const model_input_data_s& model)
+{
+	return bvh->version == MODEL_BVH_VERSION && bvh->vertex_count == model.vertex_count && bvh->triangle_count == model.index_count / 7;
+}
+
+// Return the BVH of the model (is_cage FALSE) or cage (TRUE) of input input_index of map map_id. model is the input from
+// mp_get_input_model(). The BVH is taken from the node cache or built, setting progress, and added to it. Returns 0 if
+// cancelled or out of memory. Release the BVH with model_bvh_release().
+// Two maps that ask for a BVH not yet cached at the same time both build it and the first one added is used.
+// The cache name has the counts of the model, so a model that changed without a cache clear gets a new name. Its old
+// BVH may be shared with other plugins and is left for ShaderMap to clear.
+const model_bvh_s* model_bvh_get(unsigned int map_id, unsigned int input_index, BOOL is_cage, const model_input_data_s& model, const parallel_progress_s& progress)
+{
+	// Local data
+	std::wstring								cache_name;
+	unsigned int								cache_type	= is_cage ? CACHE_TYPE_CAGE : CACHE_TYPE_MODEL;
+	unsigned int								node_id;
+	const model_bvh_s*							bvh;
+	model_bvh_s*								new_bvh;
+
+
+	try
+	{	cache_name = std::wstring(is_cage ? MODEL_BVH_CAGE_CACHE_NAME : MODEL_BVH_MODEL_CACHE_NAME) + L"_v" + std::to_wstring(MODEL_BVH_VERSION) + L"_" +
+					 std::to_wstring(model.vertex_count) + L"_" + std::to_wstring(model.index_count / 7);
+	}
+	catch(...)
+	{	return 0;
+	}
+	node_id = mp_get_input_id ? mp_get_input_id(map_id, input_index) : 0;
+
+	// Built by this plugin.
+	bvh = (const model_bvh_s*)node_cache_get(node_id, cache_name.c_str());
+	if(bvh)
+	{	return bvh;
+	}
+
+	// Built by another plugin. It is not in this plugin's cache, so node_cache_release() does nothing for it.
+	if(mp_get_node_cache)
+	{	bvh = (const model_bvh_s*)mp_get_node_cache(node_id, cache_name.c_str());
+		if(bvh && model_bvh_is_match(bvh, model))
+		{	return bvh;
+		}
+	}
+
+	new_bvh = new (std::nothrow) model_bvh_s;
+	if(!new_bvh)
+	{	return 0;
+	}
+	if(!model_bvh_build(model, *new_bvh, progress))
+	{	delete new_bvh;
+		return 0;
+	}
+	return node_cache_add_object(node_id, cache_type, cache_name.c_str(), new_bvh, new_bvh->get_byte_count(), TRUE);
+}
+
+// Release a BVH returned by model_bvh_get().
+void model_bvh_release(const model_bvh_s* bvh)
+{
+	node_cache_release(bvh);
+}
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Model BVH ray functions
+
+// Return the distance along a ray to where it enters the bounds of a node, or FLT_MAX if it misses them before t_max.
+inline float model_bvh_enter_node(const model_bvh_node_s& node, const float* origin, const float* inverse_direction, float t_min, float t_max)
+{
+	float t_0, t_1, t_enter = t_min, t_exit = t_max;
+
+	t_0 = (node.bounds_min.x - origin[0]) * inverse_direction[0]; t_1 = (node.bounds_max.x - origin[0]) * inverse_direction[0];
+	t_enter = std::max(t_enter, std::min(t_0, t_1)); t_exit = std::min(t_exit, std::max(t_0, t_1));
+	t_0 = (node.bounds_min.y - origin[1]) * inverse_direction[1]; t_1 = (node.bounds_max.y - origin[1]) * inverse_direction[1];
+	t_enter = std::max(t_enter, std::min(t_0, t_1)); t_exit = std::min(t_exit, std::max(t_0, t_1));
+	t_0 = (node.bounds_min.z - origin[2]) * inverse_direction[2]; t_1 = (node.bounds_max.z - origin[2]) * inverse_direction[2];
+	t_enter = std::max(t_enter, std::min(t_0, t_1)); t_exit = std::min(t_exit, std::max(t_0, t_1));
+	return t_enter <= t_exit ? t_enter : FLT_MAX;
+}
+
+// Test a ray against a triangle with the Moller-Trumbore test. Sets hit_in_out and returns TRUE if it is hit closer
+// than hit_in_out.t and not before t_min. Both sides are hit.
+inline BOOL model_bvh_intersect_triangle(const model_input_data_s& model, unsigned int triangle, const float* origin, const float* direction,
+										 float t_min, model_bvh_hit_s& hit_in_out)
+{
+	// Local data
+	const unsigned int*							index = model.index_array + (size_t)triangle * 7;
+	const model_input_vector3_s&				a = model.vertex_array[index[0]].position;
+	const model_input_vector3_s&				b = model.vertex_array[index[1]].position;
+	const model_input_vector3_s&				c = model.vertex_array[index[2]].position;
+	float										edge_0[3], edge_1[3], p[3], s[3], q[3], determinant, inverse, u, v, t;
+
+
+	edge_0[0] = b.x - a.x; edge_0[1] = b.y - a.y; edge_0[2] = b.z - a.z;
+	edge_1[0] = c.x - a.x; edge_1[1] = c.y - a.y; edge_1[2] = c.z - a.z;
+	p[0] = direction[1] * edge_1[2] - direction[2] * edge_1[1];
+	p[1] = direction[2] * edge_1[0] - direction[0] * edge_1[2];
+	p[2] = direction[0] * edge_1[1] - direction[1] * edge_1[0];
+	determinant = edge_0[0] * p[0] + edge_0[1] * p[1] + edge_0[2] * p[2];
+	if(determinant == 0.0f)
+	{	return FALSE;
+	}
+	inverse = 1.0f / determinant;
+	s[0] = origin[0] - a.x; s[1] = origin[1] - a.y; s[2] = origin[2] - a.z;
+	u = (s[0] * p[0] + s[1] * p[1] + s[2] * p[2]) * inverse;
+	if(u < 0.0f || u > 1.0f)
+	{	return FALSE;
+	}
+	q[0] = s[1] * edge_0[2] - s[2] * edge_0[1];
+	q[1] = s[2] * edge_0[0] - s[0] * edge_0[2];
+	q[2] = s[0] * edge_0[1] - s[1] * edge_0[0];
+	v = (direction[0] * q[0] + direction[1] * q[1] + direction[2] * q[2]) * inverse;
+	if(v < 0.0f || u + v > 1.0f)
+	{	return FALSE;
+	}
+	t = (edge_1[0] * q[0] + edge_1[1] * q[1] + edge_1[2] * q[2]) * inverse;
+	if(!(t >= t_min && t < hit_in_out.t))
+	{	return FALSE;
+	}
+	hit_in_out.triangle	= triangle;
+	hit_in_out.t		= t;
+	hit_in_out.u		= u;
+	hit_in_out.v		= v;
+	return TRUE;
+}
+
+// Find the closest triangle of model hit by the ray origin + t * direction between t_min and t_max. model must be the
+// model the BVH was built from. Returns FALSE if none is hit.
+BOOL model_bvh_intersect(const model_bvh_s& bvh, const model_input_data_s& model, const float* origin, const float* direction,
+						 float t_min, float t_max, model_bvh_hit_s& hit_out)
+{
+	// Local data
+	unsigned int								stack[MODEL_BVH_STACK_SIZE];
+	unsigned int								stack_count, node_index;
+	float										inverse_direction[3], t_near, t_far;
+	BOOL										is_hit;
+
+
+	if(!bvh.node_count)
+	{	return FALSE;
+	}
+	for(unsigned int i=0; i<3; i++)
+	{	inverse_direction[i] = direction[i] != 0.0f ? 1.0f / direction[i] : (direction[i] < 0.0f ? -FLT_MAX : FLT_MAX);
+	}
+	hit_out.t	= t_max;
+	is_hit		= FALSE;
+	if(model_bvh_enter_node(bvh.node_array[0], origin, inverse_direction, t_min, t_max) == FLT_MAX)
+	{	return FALSE;
+	}
+
+	// Visit the nearer child first and skip nodes entered after the closest hit.
+	stack_count	= 0;
+	node_index	= 0;
+	for(;;)
+	{	const model_bvh_node_s& node = bvh.node_array[node_index];
+		if(node.count)
+		{	for(unsigned int i=node.first; i<node.first + node.count; i++)
+			{	is_hit |= model_bvh_intersect_triangle(model, bvh.triangle_array[i], origin, direction, t_min, hit_out);
+			}
+		}
+		else
+		{	t_near	= model_bvh_enter_node(bvh.node_array[node.first], origin, inverse_direction, t_min, hit_out.t);
+			t_far	= model_bvh_enter_node(bvh.node_array[node.first + 1], origin, inverse_direction, t_min, hit_out.t);
+			if(t_near != FLT_MAX || t_far != FLT_MAX)
+			{	node_index = t_near <= t_far ? node.first : node.first + 1;
+				if(t_near != FLT_MAX && t_far != FLT_MAX)
+				{	stack[stack_count++] = t_near <= t_far ? node.first + 1 : node.first;
+				}
+				continue;
+			}
+		}
+		if(!stack_count)
+		{	break;
+		}
+		node_index = stack[--stack_count];
+	}
+	return is_hit;
+}
+
+#endif // MAP_MODEL_BVH_CPP
@@ -0,0 +1,654 @@
+/*
+	===============================================================
+
+	SHADERMAP MAP MODEL RASTER SOURCE FILE
+
+	Finds the triangle of a model input that covers each texel of
+	a map in UV space, and where on the triangle the texel is, for
+	plugins that bake maps from models.
+
+	The texture coordinates of each triangle, from uv_array
+	through indices 3 to 5 of its 7 indices, are scaled to texels.
+	Triangles are binned into tiles of MODEL_RASTER_TILE_SIZE
+	texels and the tiles are rasterized in parallel with edge
+	functions. Without is_conservative a texel is covered if its
+	center is in the triangle or on an edge. With is_conservative
+	a texel is covered if any part of it is, and the weights of a
+	texel whose center is outside are moved onto the triangle.
+	Where triangles overlap the last in index_array is used, a
+	triangle covering the center is used over one that does not.
+
+	Only covered texels are kept. The texels of each tile are
+	together, in groups of 4 x 4 texels, so a run of them is close
+	in UV space. Each has its position in the tile, its triangle
+	and the weights of the triangle's corners b and c.
+
+	UDIM tiles are baked one map at a time. UDIM 1001 is UV 0 to 1,
+	each tile to the right adds 1 and each row up adds 10. UVs of
+	model inputs have V down from the upper left of the map, so
+	row r covers V from -r to 1 - r.
+
+	model_raster_get() finds the raster of the model of an input
+	for the size and UDIM in the node cache, or builds it and adds
+	it as a shared entry so all maps baked from the model at that
+	size use one raster.
+
+	Include this source code file in a map plugin after the plugin
+	core file. #include "../../map_model_raster.cpp"
+
+	--
+
+	Example:
+
+	mp_get_input_model(map_id, 0, FALSE, model);
+	raster = model_raster_get(map_id, 0, model, width, height, MODEL_RASTER_UDIM_FIRST, FALSE, parallel_get_progress(map_id, 0, 10));
+	if(!raster)
+	{	return FALSE;		// Cancelled or out of memory.
+	}
+	for(unsigned int i=raster->tile_start_array[tile]; i<raster->tile_start_array[tile + 1]; i++)
+	{	model_raster_get_texel_position(*raster, tile, i, x, y);
+		... raster->triangle_array[i], raster->weight_array[i * 2], raster->weight_array[i * 2 + 1] ...
+	}
+	model_raster_release(raster);
+
+	Call the node cache functions from the plugin callbacks as
+	shown in "map_node_cache.cpp", node_cache_clear() and
+	parallel_shutdown() from on_shutdown().
+
+
+	SHADERMAP SDK LICENSE
+
+	The ShaderMap SDK is released under The MIT License (MIT)
+	http://opensource.org/licenses/MIT
+
+	Copyright (c) 2007-2019 Rendering Systems Inc.
+
+	Permission is hereby granted, free of charge, to any person
+	obtaining a copy of this software and associated documentation
+	files (the "Software"), to deal	in the Software without
+	restriction, including without limitation the rights to use,
+	copy, modify, merge, publish, distribute, sublicense, and/or
+	sell copies of the Software, and to permit persons to whom the
+	Software is	furnished to do so, subject to the following
+	conditions:
+
+	The above copyright notice and this permission notice shall be
+	included in	all copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+	OF MERCHANTABILITY,	FITNESS FOR A PARTICULAR PURPOSE AND
+	NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+	OTHER DEALINGS IN THE SOFTWARE.
+
+	Developed by: Neil Kemp at Rendering Systems Inc.
+
+	Online:		http://shadermap.com
+	Corporate:	http://renderingsystems.com
+
+	===============================================================
+*/
+
+#ifndef MAP_MODEL_RASTER_CPP
+#define MAP_MODEL_RASTER_CPP
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Model raster includes
+
+#include "../common/plugin_thread_pool.cpp"
+#include "map_node_cache.cpp"
+#include <limits.h>
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+#include <new>
+#include <string>
+#include <vector>
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Model raster defines
+
+// Changed when the members of model_raster_s before its lists change, so a raster shared by an older plugin is not used.
+#define MODEL_RASTER_VERSION					1
+
+// Width and height in texels of the tiles triangles are binned into and rasterized by one task.
+#define MODEL_RASTER_TILE_SIZE					32
+
+// Width and height in texels of the groups the texels of a tile are ordered in.
+#define MODEL_RASTER_GROUP_SIZE					4
+
+// The UDIM tile of UV 0 to 1.
+#define MODEL_RASTER_UDIM_FIRST					1001
+
+// Name of the rasters in the node cache, followed by the size and UDIM.
+#define MODEL_RASTER_CACHE_NAME					L"sdk_model_raster"
+
+// Coverage of a texel while a tile is rasterized.
+#define MODEL_RASTER_COVERAGE_NONE				0
+#define MODEL_RASTER_COVERAGE_CONSERVATIVE		1			// Only a part of the texel away from its center is covered.
+#define MODEL_RASTER_COVERAGE_CENTER			2
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Model raster structs
+
+// The covered texels of a map, tile by tile. Tiles are in rows from the upper left.
+struct model_raster_s
+{
+	unsigned int								version;					// MODEL_RASTER_VERSION
+	unsigned int								vertex_count;				// Of the model it was built from.
+	unsigned int								uv_count;
+	unsigned int								triangle_count;
+	unsigned int								width, height;				// Of the map.
+	unsigned int								udim;
+	BOOL										is_conservative;
+	unsigned int								tile_column_count;
+	unsigned int								tile_row_count;
+	unsigned int								texel_count;
+	const unsigned int*							tile_start_array;			// Start of each tile's texels, one more than the tile count.
+	const unsigned short*						texel_array;				// Position in its tile, y * MODEL_RASTER_TILE_SIZE + x.
+	const unsigned int*							triangle_array;				// Position in index_array / 7.
+	const float*								weight_array;				// 2 per texel, the weights of corners b and c. See model_bvh_hit_s.
+
+	// Owned by the plugin that built the raster. Other plugins only use the members above.
+	std::vector<unsigned int>					tile_start_list;
+	std::vector<unsigned short>					texel_list;
+	std::vector<unsigned int>					triangle_list;
+	std::vector<float>							weight_list;
+
+	// c()
+	model_raster_s(void)
+	{	version = MODEL_RASTER_VERSION; vertex_count = 0; uv_count = 0; triangle_count = 0; width = 0; height = 0;
+		udim = MODEL_RASTER_UDIM_FIRST; is_conservative = FALSE; tile_column_count = 0; tile_row_count = 0; texel_count = 0;
+		tile_start_array = 0; texel_array = 0; triangle_array = 0; weight_array = 0;
+	}
+
+	// Return the bytes of the raster.
+	unsigned long long get_byte_count(void) const
+	{	return sizeof(model_raster_s) + (unsigned long long)tile_start_list.capacity() * sizeof(unsigned int) +
+			   (unsigned long long)texel_list.capacity() * sizeof(unsigned short) + (unsigned long long)triangle_list.capacity() * sizeof(unsigned int) +
+			   (unsigned long long)weight_list.capacity() * sizeof(float);
+	}
+};
+
+// The texel rectangle x_start to x_end - 1, y_start to y_end - 1 a triangle can cover. Empty if x_start == x_end.
+struct model_raster_rect_s
+{
+	int											x_start, y_start, x_end, y_end;
+};
+
+// A covered texel while a tile is rasterized.
+struct model_raster_texel_s
+{
+	unsigned short								texel;
+	unsigned int								triangle;
+	float										u, v;
+};
+
+// Shared by the loop bodies of a raster build.
+struct model_raster_build_s
+{
+	const model_input_data_s*					model;
+	model_raster_s*								raster;
+	float										u_offset, v_offset;			// Added to the UVs before they are scaled to texels.
+	std::vector<model_raster_rect_s>			rect_list;					// Of each triangle.
+	std::vector<unsigned int>					bin_start_list;				// Start of each tile's triangles in bin_triangle_list, one more than the tile count.
+	std::vector<unsigned int>					bin_triangle_list;
+	std::vector< std::vector<model_raster_texel_s> >	tile_texel_list;		// Covered texels of each tile until they are gathered.
+};
+
+// Finds the texel rectangle of each triangle.
+struct model_raster_rect_body_s
+{
+	model_raster_build_s*						build;
+
+	BOOL operator()(unsigned int triangle_start, unsigned int triangle_end) const;
+};
+
+// Rasterizes tiles.
+struct model_raster_tile_body_s
+{
+	model_raster_build_s*						build;
+
+	BOOL operator()(unsigned int tile_start, unsigned int tile_end) const;
+};
+
+// Gathers the covered texels of the tiles into the raster.
+struct model_raster_gather_body_s
+{
+	model_raster_build_s*						build;
+
+	BOOL operator()(unsigned int tile_start, unsigned int tile_end) const;
+};
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Model raster local functions
+
+// Get the texel position of the corners of a triangle.
+inline void model_raster_get_triangle(const model_raster_build_s& build, unsigned int triangle, float* x_out, float* y_out)
+{
+	const unsigned int* index = build.model->index_array + (size_t)triangle * 7;
+
+	for(unsigned int i=0; i<3; i++)
+	{	x_out[i] = (build.model->uv_array[index[3 + i]].x + build.u_offset) * build.raster->width;
+		y_out[i] = (build.model->uv_array[index[3 + i]].y + build.v_offset) * build.raster->height;
+	}
+}
+
+// Find the texels a triangle can cover. Zero area triangles and triangles with uv indices past uv_count cover none.
+BOOL model_raster_rect_body_s::operator()(unsigned int triangle_start, unsigned int triangle_end) const
+{
+	// Local data
+	const unsigned int*							index;
+	float										x[3], y[3], x_min, y_min, x_max, y_max, area;
+	float										width	= (float)build->raster->width;
+	float										height	= (float)build->raster->height;
+
+
+	for(unsigned int i=triangle_start; i<triangle_end; i++)
+	{
+		model_raster_rect_s& rect = build->rect_list[i];
+		rect.x_start = rect.y_start = rect.x_end = rect.y_end = 0;
+
+		index = build->model->index_array + (size_t)i * 7;
+		if(index[3] >= build->model->uv_count || index[4] >= build->model->uv_count || index[5] >= build->model->uv_count)
+		{	continue;
+		}
+		model_raster_get_triangle(*build, i, x, y);
+		area = (x[1] - x[0]) * (y[2] - y[0]) - (y[1] - y[0]) * (x[2] - x[0]);
+		if(!(fabsf(area) > 0.0f))
+		{	continue;
+		}
+		x_min = std::min(x[0], std::min(x[1], x[2]));
+		y_min = std::min(y[0], std::min(y[1], y[2]));
+		x_max = std::max(x[0], std::max(x[1], x[2]));
+		y_max = std::max(y[0], std::max(y[1], y[2]));
+		if(!(x_max >= 0.0f && y_max >= 0.0f && x_min < width && y_min < height))
+		{	continue;
+		}
+
+		// Texels with a center in the bounds, or conservative any texel the bounds overlap.
+		x_min = std::max(x_min, 0.0f);
+		y_min = std::max(y_min, 0.0f);
+		x_max = std::min(x_max, width);
+		y_max = std::min(y_max, height);
+		if(build->raster->is_conservative)
+		{	rect.x_start	= (int)floorf(x_min);
+			rect.y_start	= (int)floorf(y_min);
+			rect.x_end		= std::max(rect.x_start + 1, (int)ceilf(x_max));
+			rect.y_end		= std::max(rect.y_start + 1, (int)ceilf(y_max));
+		}
+		else
+		{	rect.x_start	= (int)ceilf(x_min - 0.5f);
+			rect.y_start	= (int)ceilf(y_min - 0.5f);
+			rect.x_end		= (int)floorf(x_max - 0.5f) + 1;
+			rect.y_end		= (int)floorf(y_max - 0.5f) + 1;
+		}
+		rect.x_start	= std::max(rect.x_start, 0);
+		rect.y_start	= std::max(rect.y_start, 0);
+		rect.x_end		= std::min(rect.x_end, (int)build->raster->width);
+		rect.y_end		= std::min(rect.y_end, (int)build->raster->height);
+		if(rect.x_start >= rect.x_end || rect.y_start >= rect.y_end)
+		{	rect.x_start = rect.y_start = rect.x_end = rect.y_end = 0;
+		}
+	}
+	return TRUE;
+}
+
+// Rasterize the triangles binned into each tile in order and keep the covered texels in groups.
+BOOL model_raster_tile_body_s::operator()(unsigned int tile_start, unsigned int tile_end) const
+{
+	// Local data
+	unsigned int								triangle_array[MODEL_RASTER_TILE_SIZE * MODEL_RASTER_TILE_SIZE];
+	float										weight_array[MODEL_RASTER_TILE_SIZE * MODEL_RASTER_TILE_SIZE][2];
+	unsigned char								coverage_array[MODEL_RASTER_TILE_SIZE * MODEL_RASTER_TILE_SIZE];
+	float										x[3], y[3], edge[3], extent[3], weight[3], area, sign, px, py, total;
+	int											x_start, y_start, x_end, y_end;
+	unsigned int								texel, triangle, coverage, count;
+	model_raster_rect_s							rect;
+	model_raster_texel_s						covered;
+	const model_raster_s*						raster = build->raster;
+
+
+	for(unsigned int tile=tile_start; tile<tile_end; tile++)
+	{
+		x_start	= (int)(tile % raster->tile_column_count * MODEL_RASTER_TILE_SIZE);
+		y_start	= (int)(tile / raster->tile_column_count * MODEL_RASTER_TILE_SIZE);
+		x_end	= std::min<int>(x_start + MODEL_RASTER_TILE_SIZE, (int)raster->width);
+		y_end	= std::min<int>(y_start + MODEL_RASTER_TILE_SIZE, (int)raster->height);
+		memset(coverage_array, MODEL_RASTER_COVERAGE_NONE, sizeof(coverage_array));
+
+		for(unsigned int i=build->bin_start_list[tile]; i<build->bin_start_list[tile + 1]; i++)
+		{
+			triangle	= build->bin_triangle_list[i];
+			rect		= build->rect_list[triangle];
+			rect.x_start	= std::max(rect.x_start, x_start);
+			rect.y_start	= std::max(rect.y_start, y_start);
+			rect.x_end		= std::min(rect.x_end, x_end);
+			rect.y_end		= std::min(rect.y_end, y_end);
+
+			// Edge i is across from corner i. Divided by the area it is the weight of corner i. extent is how much the edge
+			// function can grow from the center to a corner of the texel, used to test if any of the texel is inside.
+			model_raster_get_triangle(*build, triangle, x, y);
+			area	= (x[1] - x[0]) * (y[2] - y[0]) - (y[1] - y[0]) * (x[2] - x[0]);
+			sign	= area < 0.0f ? -1.0f : 1.0f;
+			for(unsigned int j=0; j<3; j++)
+			{	extent[j] = 0.5f * (fabsf(x[(j + 2) % 3] - x[(j + 1) % 3]) + fabsf(y[(j + 2) % 3] - y[(j + 1) % 3]));
+			}
+			for(int ty=rect.y_start; ty<rect.y_end; ty++)
+			{	py = ty + 0.5f;
+				for(int tx=rect.x_start; tx<rect.x_end; tx++)
+				{
+					px = tx + 0.5f;
+					for(unsigned int j=0; j<3; j++)
+					{	const unsigned int a = (j + 1) % 3, b = (j + 2) % 3;
+						edge[j] = ((x[b] - x[a]) * (py - y[a]) - (y[b] - y[a]) * (px - x[a])) * sign;
+					}
+					if(edge[0] >= 0.0f && edge[1] >= 0.0f && edge[2] >= 0.0f)
+					{	coverage = MODEL_RASTER_COVERAGE_CENTER;
+					}
+					else if(raster->is_conservative && edge[0] + extent[0] >= 0.0f && edge[1] + extent[1] >= 0.0f && edge[2] + extent[2] >= 0.0f)
+					{	coverage = MODEL_RASTER_COVERAGE_CONSERVATIVE;
+					}
+					else
+					{	continue;
+					}
+					texel = (ty - y_start) * MODEL_RASTER_TILE_SIZE + (tx - x_start);
+					if(coverage < coverage_array[texel])
+					{	continue;
+					}
+
+					// Weights of a texel center outside the triangle are clamped onto it.
+					total = 0.0f;
+					for(unsigned int j=0; j<3; j++)
+					{	weight[j]	= std::max(edge[j], 0.0f);
+						total		+= weight[j];
+					}
+					coverage_array[texel]	= (unsigned char)coverage;
+					triangle_array[texel]	= triangle;
+					weight_array[texel][0]	= weight[1] / total;
+					weight_array[texel][1]	= weight[2] / total;
+				}
+			}
+		}
+
+		// Keep the covered texels a group at a time.
+		count = 0;
+		for(unsigned int j=0; j<MODEL_RASTER_TILE_SIZE * MODEL_RASTER_TILE_SIZE; j++)
+		{	count += coverage_array[j] != MODEL_RASTER_COVERAGE_NONE ? 1 : 0;
+		}
+		std::vector<model_raster_texel_s>& texel_list = build->tile_texel_list[tile];
+		try
+		{	texel_list.reserve(count);
+		}
+		catch(...)
+		{	return FALSE;
+		}
+		for(int gy=0; gy<MODEL_RASTER_TILE_SIZE; gy+=MODEL_RASTER_GROUP_SIZE)
+		{	for(int gx=0; gx<MODEL_RASTER_TILE_SIZE; gx+=MODEL_RASTER_GROUP_SIZE)
+			{	for(int ty=gy; ty<gy + MODEL_RASTER_GROUP_SIZE; ty++)
+				{	for(int tx=gx; tx<gx + MODEL_RASTER_GROUP_SIZE; tx++)
+					{	texel = ty * MODEL_RASTER_TILE_SIZE + tx;
+						if(coverage_array[texel] != MODEL_RASTER_COVERAGE_NONE)
+						{	covered.texel		= (unsigned short)texel;
+							covered.triangle	= triangle_array[texel];
+							covered.u			= weight_array[texel][0];
+							covered.v			= weight_array[texel][1];
+							texel_list.push_back(covered);
+						}
+					}
+				}
+			}
+		}
+	}
+	return TRUE;
+}
+
+// Copy the covered texels of each tile to the raster and free the tile's list.
+BOOL model_raster_gather_body_s::operator()(unsigned int tile_start, unsigned int tile_end) const
+{
+	// Local data
+	model_raster_s*								raster = build->raster;
+	unsigned int								position;
+
+
+	for(unsigned int tile=tile_start; tile<tile_end; tile++)
+	{	std::vector<model_raster_texel_s>& texel_list = build->tile_texel_list[tile];
+		position = raster->tile_start_list[tile];
+		for(size_t i=0; i<texel_list.size(); i++, position++)
+		{	raster->texel_list[position]			= texel_list[i].texel;
+			raster->triangle_list[position]			= texel_list[i].triangle;
+			raster->weight_list[position * 2]		= texel_list[i].u;
+			raster->weight_list[position * 2 + 1]	= texel_list[i].v;
+		}
+		std::vector<model_raster_texel_s>().swap(texel_list);
+	}
+	return TRUE;
+}
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Model raster build
+
+// Rasterize the triangles of a model for a map of width x height texels in the UDIM tile udim, setting progress. Returns
+// FALSE if cancelled or out of memory.
+BOOL model_raster_build(const model_input_data_s& model, unsigned int width, unsigned int height, unsigned int udim, BOOL is_conservative,
+						model_raster_s& raster_out, const parallel_progress_s& progress)
+{
+	// Local data
+	model_raster_build_s						build;
+	model_raster_rect_body_s					rect_body;
+	model_raster_tile_body_s					tile_body;
+	model_raster_gather_body_s					gather_body;
+	unsigned int								tile_count;
+	unsigned long long							texel_count;
+	std::vector<unsigned int>					fill_list;
+
+
+	udim							= std::max<unsigned int>(udim, MODEL_RASTER_UDIM_FIRST);
+	raster_out						= model_raster_s();
+	raster_out.vertex_count			= model.vertex_count;
+	raster_out.uv_count				= model.uv_count;
+	raster_out.triangle_count		= model.index_count / 7;
+	raster_out.width				= width;
+	raster_out.height				= height;
+	raster_out.udim					= udim;
+	raster_out.is_conservative		= is_conservative;
+	raster_out.tile_column_count	= (width + MODEL_RASTER_TILE_SIZE - 1) / MODEL_RASTER_TILE_SIZE;
+	raster_out.tile_row_count		= (height + MODEL_RASTER_TILE_SIZE - 1) / MODEL_RASTER_TILE_SIZE;
+	tile_count						= raster_out.tile_column_count * raster_out.tile_row_count;
+	build.model						= &model;
+	build.raster					= &raster_out;
+	build.u_offset					= -(float)((udim - MODEL_RASTER_UDIM_FIRST) % 10);
+	build.v_offset					= (float)((udim - MODEL_RASTER_UDIM_FIRST) / 10);
+	try
+	{	raster_out.tile_start_list.assign(tile_count + 1, 0);
+		if(model.uv_array && model.index_array)
+		{	build.rect_list.resize(raster_out.triangle_count);
+			build.bin_start_list.assign(tile_count + 1, 0);
+			build.tile_texel_list.resize(tile_count);
+		}
+	}
+	catch(...)
+	{	raster_out = model_raster_s();
+		return FALSE;
+	}
+	if(!model.uv_array || !model.index_array)
+	{	raster_out.tile_start_array = raster_out.tile_start_list.data();
+		return TRUE;
+	}
+
+	// Find the texels each triangle can cover.
+	rect_body.build = &build;
+	if(!parallel_for(raster_out.triangle_count, 4096, rect_body, parallel_progress_s()))
+	{	raster_out = model_raster_s();
+		return FALSE;
+	}
+
+	// Sort the triangles into the tiles their rectangles overlap with a counting sort. Each tile keeps index_array order.
+	try
+	{	for(unsigned int pass=0; pass<2; pass++)
+		{
+			if(pass == 1)
+			{	for(unsigned int i=0; i<tile_count; i++)
+				{	build.bin_start_list[i + 1] += build.bin_start_list[i];
+				}
+				build.bin_triangle_list.resize(build.bin_start_list[tile_count]);
+				fill_list.assign(build.bin_start_list.begin(), build.bin_start_list.end() - 1);
+			}
+			for(unsigned int i=0; i<raster_out.triangle_count; i++)
+			{
+				const model_raster_rect_s& rect = build.rect_list[i];
+				if(rect.x_start == rect.x_end)
+				{	continue;
+				}
+				for(int ty=rect.y_start / MODEL_RASTER_TILE_SIZE; ty<=(rect.y_end - 1) / MODEL_RASTER_TILE_SIZE; ty++)
+				{	for(int tx=rect.x_start / MODEL_RASTER_TILE_SIZE; tx<=(rect.x_end - 1) / MODEL_RASTER_TILE_SIZE; tx++)
+					{	if(pass == 0)
+						{	build.bin_start_list[ty * raster_out.tile_column_count + tx + 1]++;
+						}
+						else
+						{	build.bin_triangle_list[fill_list[ty * raster_out.tile_column_count + tx]++] = i;
+						}
+					}
+				}
+			}
+		}
+	}
+	catch(...)
+	{	raster_out = model_raster_s();
+		return FALSE;
+	}
+
+	// Rasterize the tiles. Each keeps its texels until they are counted.
+	tile_body.build = &build;
+	if(!parallel_for(tile_count, 4, tile_body, progress))
+	{	raster_out = model_raster_s();
+		return FALSE;
+	}
+	std::vector<model_raster_rect_s>().swap(build.rect_list);
+	std::vector<unsigned int>().swap(build.bin_triangle_list);
+
+	// Gather the texels of all tiles.
+	texel_count = 0;
+	for(unsigned int i=0; i<tile_count; i++)
+	{	raster_out.tile_start_list[i]	= (unsigned int)texel_count;
+		texel_count						+= build.tile_texel_list[i].size();
+	}
+	raster_out.tile_start_list[tile_count] = (unsigned int)texel_count;
+	if(texel_count > UINT_MAX / 2)
+	{	raster_out = model_raster_s();
+		return FALSE;
+	}
+	try
+	{	raster_out.texel_list.resize((size_t)texel_count);
+		raster_out.triangle_list.resize((size_t)texel_count);
+		raster_out.weight_list.resize((size_t)texel_count * 2);
+	}
+	catch(...)
+	{	raster_out = model_raster_s();
+		return FALSE;
+	}
+	gather_body.build = &build;
+	if(!parallel_for(tile_count, 16, gather_body, parallel_progress_s()))
+	{	raster_out = model_raster_s();
+		return FALSE;
+	}
+
+	raster_out.texel_count		= (unsigned int)texel_count;
+	raster_out.tile_start_array	= raster_out.tile_start_list.data();
+	raster_out.texel_array		= raster_out.texel_list.data();
+	raster_out.triangle_array	= raster_out.triangle_list.data();
+	raster_out.weight_array		= raster_out.weight_list.data();
+	return TRUE;
+}
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Model raster functions
+
+// Return TRUE if raster was built from a model with the counts of model.
+inline BOOL model_raster_is_match(const model_raster_s* raster, const model_input_data_s& model)
+{
+	return raster->version == MODEL_RASTER_VERSION && raster->vertex_count == model.vertex_count && raster->uv_count == model.uv_count &&
+		   raster->triangle_count == model.index_count / 7;
+}
+
+// Return the raster of the model of input input_index of map map_id for a map of width x height texels in the UDIM tile
+// udim. model is the input from mp_get_input_model(). The raster is taken from the node cache or built, setting progress,
+// and added to it. Returns 0 if cancelled or out of memory. Release it with model_raster_release().
+// The cache name has the counts of the model, so a model that changed without a cache clear gets a new name. Its old
+// raster may be shared with other plugins and is left for ShaderMap to clear.
+const model_raster_s* model_raster_get(unsigned int map_id, unsigned int input_index, const model_input_data_s& model, unsigned int width,
+									   unsigned int height, unsigned int udim, BOOL is_conservative, const parallel_progress_s& progress)
+{
+	// Local data
+	std::wstring								cache_name;
+	unsigned int								node_id;
+	const model_raster_s*						raster;
+	model_raster_s*								new_raster;
+
+
+	// Each size, UDIM and coverage rule has its own name.
+	udim = std::max<unsigned int>(udim, MODEL_RASTER_UDIM_FIRST);
+	try
+	{	cache_name = std::wstring(MODEL_RASTER_CACHE_NAME) + L"_" + std::to_wstring(width) + L"x" + std::to_wstring(height) + L"_" +
+					 std::to_wstring(udim) + (is_conservative ? L"_conservative" : L"") + L"_v" + std::to_wstring(MODEL_RASTER_VERSION) + L"_" +
+					 std::to_wstring(model.vertex_count) + L"_" + std::to_wstring(model.uv_count) + L"_" + std::to_wstring(model.index_count / 7);
+	}
+	catch(...)
+	{	return 0;
+	}
+	node_id = mp_get_input_id ? mp_get_input_id(map_id, input_index) : 0;
+
+	// Built by this plugin.
+	raster = (const model_raster_s*)node_cache_get(node_id, cache_name.c_str());
+	if(raster)
+	{	return raster;
+	}
+
+	// Built by another plugin.
+	if(mp_get_node_cache)
+	{	raster = (const model_raster_s*)mp_get_node_cache(node_id, cache_name.c_str());
+		if(raster && model_raster_is_match(raster, model))
+		{	return raster;
+		}
+	}
+
+	new_raster = new (std::nothrow) model_raster_s;
+	if(!new_raster)
+	{	return 0;
+	}
+	if(!model_raster_build(model, width, height, udim, is_conservative, *new_raster, progress))
+	{	delete new_raster;
+		return 0;
+	}
+	return node_cache_add_object(node_id, CACHE_TYPE_MODEL, cache_name.c_str(), new_raster, new_raster->get_byte_count(), TRUE);
+}
+
+// Release a raster returned by model_raster_get().
+void model_raster_release(const model_raster_s* raster)
+{
+	node_cache_release(raster);
+}
+
+// Get the map position of texel texel_index of tile tile.
+inline void model_raster_get_texel_position(const model_raster_s& raster, unsigned int tile, unsigned int texel_index, unsigned int& x_out, unsigned int& y_out)
+{
+	x_out = tile % raster.tile_column_count * MODEL_RASTER_TILE_SIZE + raster.texel_array[texel_index] % MODEL_RASTER_TILE_SIZE;
+	y_out = tile / raster.tile_column_count * MODEL_RASTER_TILE_SIZE + raster.texel_array[texel_index] / MODEL_RASTER_TILE_SIZE;
+}
+
+#endif // MAP_MODEL_RASTER_CPP
@@ -0,0 +1,901 @@
+/*
+	===============================================================
+
+	SHADERMAP MAP MODEL RAY SOURCE FILE
+
+	Casts rays against the triangles of a model input with SIMD
+	triangle tests, one ray at a time or in packets of
+	MODEL_RAY_PACKET_SIZE rays. It is built on the BVH of
+	"map_model_bvh.cpp".
+
+	A ray mesh is a copy of the BVH where the triangles of each
+	leaf are stored as blocks of LANE_COUNT triangles with each
+	corner coordinate in its own array (structure of arrays).
+	Subtrees with no more than LANE_COUNT triangles become one
+	leaf so that blocks are full. A ray is tested against all the
+	triangles of a block at once. A packet of rays that start near
+	each other, such as the rays of texels next to each other in
+	UV space, goes down the tree together and is tested against
+	one triangle at a time, LANE_COUNT rays at once.
+
+	The path, and with it LANE_COUNT, is selected the first time a
+	ray mesh is asked for:
+
+	AVX-512	- 16 lanes. Needs AVX-512F, and Visual Studio 2017, GCC 5
+			  or Clang 4 to build. Older compilers leave it out.
+	AVX2	- 8 lanes.
+	SSE2	- 4 lanes.
+	Scalar	- 4 lanes one at a time. Non x86 builds.
+
+	Each path gives the same hits up to floating point rounding.
+	Two triangle tests are offered:
+
+	MODEL_RAY_TEST_MOLLER_TRUMBORE	- The test of map_model_bvh.cpp.
+	MODEL_RAY_TEST_WATERTIGHT		- Woop, Benthin and Wald 2013.
+	A ray through an edge or corner shared by triangles hits one
+	of them, there are no cracks. Costs a little more. There is no
+	double precision fallback for rays exactly on an edge.
+
+	Both have closest hit and any hit (shadow and occlusion)
+	entry points. Both sides of triangles are hit.
+
+	model_ray_get() finds the ray mesh of the model or the cage of
+	an input in the node cache, or builds it from the BVH of
+	model_bvh_get() and adds it as a shared entry, as the BVH is.
+	The ray mesh has copies of the triangle corners, the model is
+	not needed to trace rays.
+
+	Include this source code file in a map plugin after the plugin
+	core file. #include "../../map_model_ray.cpp"
+	It includes "map_model_ray_lanes.cpp" which must be in the
+	same folder.
+
+	Example:
+
+	mp_get_input_model(map_id, 0, FALSE, model);
+	mesh = model_ray_get(map_id, 0, FALSE, model, parallel_get_progress(map_id, 0, 20));
+	if(!mesh)
+	{	return FALSE;		// Cancelled or out of memory.
+	}
+	if(model_ray_intersect(*mesh, origin, direction, 0.0f, FLT_MAX, MODEL_RAY_TEST_WATERTIGHT, hit))
+	{	... hit.triangle, hit.t, hit.u, hit.v ...
+	}
+
+	packet.clear();
+	for(each texel of a 4 x 4 group)
+	{	packet.add(origin, direction, 0.0f, FLT_MAX);
+	}
+	model_ray_intersect_packet(*mesh, packet, MODEL_RAY_TEST_WATERTIGHT, packet_hit);
+	model_ray_release(mesh);
+
+	Call the node cache functions from the plugin callbacks as
+	shown in "map_node_cache.cpp", node_cache_clear() and
+	parallel_shutdown() from on_shutdown().
+
+
+	SHADERMAP SDK LICENSE
+
+	The ShaderMap SDK is released under The MIT License (MIT)
+	http://opensource.org/licenses/MIT
+
+	Copyright (c) 2007-2019 Rendering Systems Inc.
+
+	Permission is hereby granted, free of charge, to any person
+	obtaining a copy of this software and associated documentation
+	files (the "Software"), to deal	in the Software without
+	restriction, including without limitation the rights to use,
+	copy, modify, merge, publish, distribute, sublicense, and/or
+	sell copies of the Software, and to permit persons to whom the
+	Software is	furnished to do so, subject to the following
+	conditions:
+
+	The above copyright notice and this permission notice shall be
+	included in	all copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+	OF MERCHANTABILITY,	FITNESS FOR A PARTICULAR PURPOSE AND
+	NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+	OTHER DEALINGS IN THE SOFTWARE.
+
+	Developed by: Neil Kemp at Rendering Systems Inc.
+
+	Online:		http://shadermap.com
+	Corporate:	http://renderingsystems.com
+
+	===============================================================
+*/
+
+#ifndef MAP_MODEL_RAY_CPP
+#define MAP_MODEL_RAY_CPP
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Model ray includes
+
+#include "map_model_bvh.cpp"
+#include <float.h>
+#include <limits.h>
+#include <algorithm>
+#include <limits>
+#include <mutex>
+#include <new>
+#include <string>
+#include <vector>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+	#define MODEL_RAY_X86
+	#include <emmintrin.h>
+	#include <immintrin.h>
+	#ifdef _MSC_VER
+		#include <intrin.h>
+	#else
+		#include <cpuid.h>
+	#endif
+
+	// AVX-512 intrinsics need Visual Studio 2017, GCC 5 or Clang 4. CPUs with AVX-512 use the AVX2 path otherwise.
+	#if (defined(__clang__) && __clang_major__ >= 4) || (defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 5) || \
+		(defined(_MSC_VER) && !defined(__clang__) && _MSC_VER >= 1910)
+		#define MODEL_RAY_AVX512
+	#endif
+#endif
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Model ray defines
+
+// Changed when the members of model_ray_mesh_s before its lists change, so a ray mesh shared by an older plugin is not used.
+#define MODEL_RAY_VERSION						1
+
+// Paths
+#define MODEL_RAY_PATH_AUTO						0					// Select the fastest path the CPU supports.
+#define MODEL_RAY_PATH_SCALAR					1
+#define MODEL_RAY_PATH_SSE2						2
+#define MODEL_RAY_PATH_AVX2						3
+#define MODEL_RAY_PATH_AVX512					4
+
+// Triangle tests
+#define MODEL_RAY_TEST_MOLLER_TRUMBORE			0
+#define MODEL_RAY_TEST_WATERTIGHT				1
+
+// Rays in a packet. A multiple of the lanes of every path.
+#define MODEL_RAY_PACKET_SIZE					16
+
+// Marks an empty lane of a block and a ray of a packet that hit nothing.
+#define MODEL_RAY_NONE							UINT_MAX
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Model ray structs
+
+// A copy of a BVH with the triangles of its leaves in blocks. Node 0 is the root.
+struct model_ray_mesh_s
+{
+	unsigned int								version;					// MODEL_RAY_VERSION
+	unsigned int								vertex_count;				// Of the model it was built from.
+	unsigned int								triangle_count;
+	unsigned int								lane_count;					// Triangles in a block.
+	unsigned int								node_count;
+	unsigned int								block_count;
+	const model_bvh_node_s*						node_array;					// Leaf - first is its first block, count its triangles.
+	const float*								block_array;				// 9 * lane_count floats per block. For corner a, b and c, the x, y and z of each lane.
+	const unsigned int*							block_triangle_array;		// lane_count per block. Position in index_array / 7, or MODEL_RAY_NONE.
+
+	// Owned by the plugin that built the ray mesh. Other plugins only use the members above.
+	std::vector<model_bvh_node_s>				node_list;
+	std::vector<float>							block_list;
+	std::vector<unsigned int>					block_triangle_list;
+
+	// c()
+	model_ray_mesh_s(void)
+	{	version = MODEL_RAY_VERSION; vertex_count = 0; triangle_count = 0; lane_count = 0; node_count = 0; block_count = 0;
+		node_array = 0; block_array = 0; block_triangle_array = 0;
+	}
+
+	// Return the bytes of the ray mesh.
+	unsigned long long get_byte_count(void) const
+	{	return sizeof(model_ray_mesh_s) + (unsigned long long)node_list.capacity() * sizeof(model_bvh_node_s) +
+			   (unsigned long long)block_list.capacity() * sizeof(float) + (unsigned long long)block_triangle_list.capacity() * sizeof(unsigned int);
+	}
+};
+
+// Rays traced together. Each array has a ray in each of its first count entries.
+struct model_ray_packet_s
+{
+	float										origin[3][MODEL_RAY_PACKET_SIZE];		// X, Y and Z of the rays.
+	float										direction[3][MODEL_RAY_PACKET_SIZE];
+	float										t_min[MODEL_RAY_PACKET_SIZE];
+	float										t_max[MODEL_RAY_PACKET_SIZE];
+	unsigned int								count;
+
+	// c()
+	model_ray_packet_s(void)
+	{	clear();
+	}
+
+	// Remove the rays. Unused entries are set so the lanes they fill are well defined.
+	void clear(void)
+	{	for(unsigned int i=0; i<MODEL_RAY_PACKET_SIZE; i++)
+		{	origin[0][i] = origin[1][i] = origin[2][i] = 0.0f;
+			direction[0][i] = direction[1][i] = 0.0f;
+			direction[2][i] = 1.0f;
+			t_min[i] = 1.0f;
+			t_max[i] = 0.0f;
+		}
+		count = 0;
+	}
+
+	// Add a ray and return its index. The packet must not be full.
+	unsigned int add(const float* ray_origin, const float* ray_direction, float ray_t_min, float ray_t_max)
+	{	for(unsigned int i=0; i<3; i++)
+		{	origin[i][count]	= ray_origin[i];
+			direction[i][count]	= ray_direction[i];
+		}
+		t_min[count] = ray_t_min;
+		t_max[count] = ray_t_max;
+		return count++;
+	}
+};
+
+// What each ray of a packet hit. triangle is MODEL_RAY_NONE for rays that hit nothing. See model_bvh_hit_s.
+struct model_ray_packet_hit_s
+{
+	unsigned int								triangle[MODEL_RAY_PACKET_SIZE];
+	float										t[MODEL_RAY_PACKET_SIZE];
+	float										u[MODEL_RAY_PACKET_SIZE];
+	float										v[MODEL_RAY_PACKET_SIZE];
+};
+
+// A ray set up for the watertight test. axis is the order the axes of the corners are taken in, the ray is along the
+// last. shear moves the corners so the ray is the z axis.
+struct model_ray_watertight_s
+{
+	unsigned int								axis[3];
+	float										shear[3];
+};
+
+// Builds the blocks of the ray mesh leaves in parallel.
+struct model_ray_block_body_s
+{
+	const model_bvh_s*							bvh;
+	const model_input_data_s*					model;
+	model_ray_mesh_s*							mesh;
+	const unsigned int*							leaf_array;					// Pairs of a ray mesh leaf and its BVH node.
+
+	BOOL operator()(unsigned int leaf_start, unsigned int leaf_end) const;
+};
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Model ray function types
+
+typedef BOOL (*model_ray_intersect_type)(const model_ray_mesh_s& mesh, const float* origin, const float* direction, float t_min, float t_max,
+										 unsigned int test, BOOL is_any, model_bvh_hit_s& hit_out);
+typedef void (*model_ray_intersect_packet_type)(const model_ray_mesh_s& mesh, const model_ray_packet_s& packet, unsigned int test, BOOL is_any,
+												model_ray_packet_hit_s& hit_out);
+
+static model_ray_intersect_type					model_ray_intersect_function		= 0;
+static model_ray_intersect_packet_type			model_ray_intersect_packet_function	= 0;
+static unsigned int								model_ray_path						= MODEL_RAY_PATH_AUTO;
+static unsigned int								model_ray_lane_count				= 0;
+static std::once_flag							model_ray_path_once;
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Model ray local functions
+
+// Set up a ray for the watertight test. The axis the ray is longest on is last, the other two are swapped if the ray
+// goes toward negative on it so the winding of triangles is kept.
+inline void model_ray_get_watertight(const float* direction, model_ray_watertight_s& watertight_out)
+{
+	// Local data
+	unsigned int								kx, ky, kz;
+	float										size[3];
+
+
+	for(unsigned int i=0; i<3; i++)
+	{	size[i] = direction[i] < 0.0f ? -direction[i] : direction[i];
+	}
+	kz = size[0] > size[1] ? (size[0] > size[2] ? 0 : 2) : (size[1] > size[2] ? 1 : 2);
+	kx = kz == 2 ? 0 : kz + 1;
+	ky = kx == 2 ? 0 : kx + 1;
+	if(direction[kz] < 0.0f)
+	{	std::swap(kx, ky);
+	}
+	watertight_out.axis[0]	= kx;
+	watertight_out.axis[1]	= ky;
+	watertight_out.axis[2]	= kz;
+	watertight_out.shear[0]	= direction[kx] / direction[kz];
+	watertight_out.shear[1]	= direction[ky] / direction[kz];
+	watertight_out.shear[2]	= 1.0f / direction[kz];
+}
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Scalar path - 4 lanes one at a time.
+
+// A multiply and add must not be fused in the tests, the paths would differ and the watertight test would have cracks.
+// AVX-512 has fused multiply and add, so GCC would fuse them in that path.
+#if defined(__GNUC__) && !defined(__clang__)
+	#pragma GCC push_options
+	#pragma GCC optimize("fp-contract=off")
+#endif
+
+namespace model_ray_scalar
+{
+	struct lanes_s	{ float v[4]; };
+	struct mask_s	{ unsigned int bits; };
+
+	static const unsigned int LANE_COUNT = 4;
+
+	#define MODEL_RAY_SCALAR_LANES(EXPRESSION)		lanes_s r; for(unsigned int i=0; i<4; i++) { r.v[i] = (EXPRESSION); } return r;
+	#define MODEL_RAY_SCALAR_MASK(EXPRESSION)		mask_s r; r.bits = 0; for(unsigned int i=0; i<4; i++) { r.bits |= (EXPRESSION) ? 1u << i : 0; } return r;
+
+	inline lanes_s		lanes_set(float f)								{ MODEL_RAY_SCALAR_LANES(f) }
+	inline lanes_s		lanes_load(const float* p)						{ MODEL_RAY_SCALAR_LANES(p[i]) }
+	inline void			lanes_store(float* p, lanes_s a)				{ for(unsigned int i=0; i<4; i++) { p[i] = a.v[i]; } }
+	inline lanes_s		operator+(lanes_s a, lanes_s b)					{ MODEL_RAY_SCALAR_LANES(a.v[i] + b.v[i]) }
+	inline lanes_s		operator-(lanes_s a, lanes_s b)					{ MODEL_RAY_SCALAR_LANES(a.v[i] - b.v[i]) }
+	inline lanes_s		operator*(lanes_s a, lanes_s b)					{ MODEL_RAY_SCALAR_LANES(a.v[i] * b.v[i]) }
+	inline lanes_s		operator/(lanes_s a, lanes_s b)					{ MODEL_RAY_SCALAR_LANES(a.v[i] / b.v[i]) }
+	inline lanes_s		lanes_min(lanes_s a, lanes_s b)					{ MODEL_RAY_SCALAR_LANES(a.v[i] < b.v[i] ? a.v[i] : b.v[i]) }
+	inline lanes_s		lanes_max(lanes_s a, lanes_s b)					{ MODEL_RAY_SCALAR_LANES(a.v[i] > b.v[i] ? a.v[i] : b.v[i]) }
+	inline lanes_s		lanes_select(mask_s m, lanes_s a, lanes_s b)	{ MODEL_RAY_SCALAR_LANES((m.bits & (1u << i)) ? a.v[i] : b.v[i]) }
+	inline mask_s		operator<(lanes_s a, lanes_s b)					{ MODEL_RAY_SCALAR_MASK(a.v[i] < b.v[i]) }
+	inline mask_s		operator<=(lanes_s a, lanes_s b)				{ MODEL_RAY_SCALAR_MASK(a.v[i] <= b.v[i]) }
+	inline mask_s		operator>=(lanes_s a, lanes_s b)				{ MODEL_RAY_SCALAR_MASK(a.v[i] >= b.v[i]) }
+	inline mask_s		operator==(lanes_s a, lanes_s b)				{ MODEL_RAY_SCALAR_MASK(a.v[i] == b.v[i]) }
+	inline mask_s		operator!=(lanes_s a, lanes_s b)				{ MODEL_RAY_SCALAR_MASK(a.v[i] < b.v[i] || a.v[i] > b.v[i]) }
+	inline mask_s		operator&(mask_s a, mask_s b)					{ a.bits &= b.bits; return a; }
+	inline mask_s		operator|(mask_s a, mask_s b)					{ a.bits |= b.bits; return a; }
+	inline unsigned int	mask_get_bits(mask_s m)							{ return m.bits; }
+
+	#undef MODEL_RAY_SCALAR_LANES
+	#undef MODEL_RAY_SCALAR_MASK
+
+	#include "map_model_ray_lanes.cpp"
+}
+
+
+#ifdef MODEL_RAY_X86
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// SSE2 path - 4 lanes.
+
+namespace model_ray_sse2
+{
+	struct lanes_s	{ __m128 v; };
+	struct mask_s	{ __m128 v; };
+
+	static const unsigned int LANE_COUNT = 4;
+
+	inline lanes_s		lanes_make(__m128 v)							{ lanes_s r; r.v = v; return r; }
+	inline mask_s		mask_make(__m128 v)								{ mask_s r; r.v = v; return r; }
+	inline lanes_s		lanes_set(float f)								{ return lanes_make(_mm_set1_ps(f)); }
+	inline lanes_s		lanes_load(const float* p)						{ return lanes_make(_mm_loadu_ps(p)); }
+	inline void			lanes_store(float* p, lanes_s a)				{ _mm_storeu_ps(p, a.v); }
+	inline lanes_s		operator+(lanes_s a, lanes_s b)					{ return lanes_make(_mm_add_ps(a.v, b.v)); }
+	inline lanes_s		operator-(lanes_s a, lanes_s b)					{ return lanes_make(_mm_sub_ps(a.v, b.v)); }
+	inline lanes_s		operator*(lanes_s a, lanes_s b)					{ return lanes_make(_mm_mul_ps(a.v, b.v)); }
+	inline lanes_s		operator/(lanes_s a, lanes_s b)					{ return lanes_make(_mm_div_ps(a.v, b.v)); }
+	inline lanes_s		lanes_min(lanes_s a, lanes_s b)					{ return lanes_make(_mm_min_ps(a.v, b.v)); }
+	inline lanes_s		lanes_max(lanes_s a, lanes_s b)					{ return lanes_make(_mm_max_ps(a.v, b.v)); }
+	inline lanes_s		lanes_select(mask_s m, lanes_s a, lanes_s b)	{ return lanes_make(_mm_or_ps(_mm_and_ps(m.v, a.v), _mm_andnot_ps(m.v, b.v))); }
+	inline mask_s		operator<(lanes_s a, lanes_s b)					{ return mask_make(_mm_cmplt_ps(a.v, b.v)); }
+	inline mask_s		operator<=(lanes_s a, lanes_s b)				{ return mask_make(_mm_cmple_ps(a.v, b.v)); }
+	inline mask_s		operator>=(lanes_s a, lanes_s b)				{ return mask_make(_mm_cmpge_ps(a.v, b.v)); }
+	inline mask_s		operator==(lanes_s a, lanes_s b)				{ return mask_make(_mm_cmpeq_ps(a.v, b.v)); }
+	inline mask_s		operator!=(lanes_s a, lanes_s b)				{ return mask_make(_mm_or_ps(_mm_cmplt_ps(a.v, b.v), _mm_cmpgt_ps(a.v, b.v))); }
+	inline mask_s		operator&(mask_s a, mask_s b)					{ return mask_make(_mm_and_ps(a.v, b.v)); }
+	inline mask_s		operator|(mask_s a, mask_s b)					{ return mask_make(_mm_or_ps(a.v, b.v)); }
+	inline unsigned int	mask_get_bits(mask_s m)							{ return (unsigned int)_mm_movemask_ps(m.v); }
+
+	#include "map_model_ray_lanes.cpp"
+}
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// AVX2 path - 8 lanes. Compiled for AVX2 whatever the compiler options, only called if the CPU has it.
+
+#if defined(__clang__)
+	#pragma clang attribute push(__attribute__((target("avx2"))), apply_to = function)
+#elif defined(__GNUC__)
+	#pragma GCC push_options
+	#pragma GCC target("avx2")
+#endif
+
+namespace model_ray_avx2
+{
+	struct lanes_s	{ __m256 v; };
+	struct mask_s	{ __m256 v; };
+
+	static const unsigned int LANE_COUNT = 8;
+
+	inline lanes_s		lanes_make(__m256 v)							{ lanes_s r; r.v = v; return r; }
+	inline mask_s		mask_make(__m256 v)								{ mask_s r; r.v = v; return r; }
+	inline lanes_s		lanes_set(float f)								{ return lanes_make(_mm256_set1_ps(f)); }
+	inline lanes_s		lanes_load(const float* p)						{ return lanes_make(_mm256_loadu_ps(p)); }
+	inline void			lanes_store(float* p, lanes_s a)				{ _mm256_storeu_ps(p, a.v); }
+	inline lanes_s		operator+(lanes_s a, lanes_s b)					{ return lanes_make(_mm256_add_ps(a.v, b.v)); }
+	inline lanes_s		operator-(lanes_s a, lanes_s b)					{ return lanes_make(_mm256_sub_ps(a.v, b.v)); }
+	inline lanes_s		operator*(lanes_s a, lanes_s b)					{ return lanes_make(_mm256_mul_ps(a.v, b.v)); }
+	inline lanes_s		operator/(lanes_s a, lanes_s b)					{ return lanes_make(_mm256_div_ps(a.v, b.v)); }
+	inline lanes_s		lanes_min(lanes_s a, lanes_s b)					{ return lanes_make(_mm256_min_ps(a.v, b.v)); }
+	inline lanes_s		lanes_max(lanes_s a, lanes_s b)					{ return lanes_make(_mm256_max_ps(a.v, b.v)); }
+	inline lanes_s		lanes_select(mask_s m, lanes_s a, lanes_s b)	{ return lanes_make(_mm256_blendv_ps(b.v, a.v, m.v)); }
+	inline mask_s		operator<(lanes_s a, lanes_s b)					{ return mask_make(_mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ)); }
+	inline mask_s		operator<=(lanes_s a, lanes_s b)				{ return mask_make(_mm256_cmp_ps(a.v, b.v, _CMP_LE_OQ)); }
+	inline mask_s		operator>=(lanes_s a, lanes_s b)				{ return mask_make(_mm256_cmp_ps(a.v, b.v, _CMP_GE_OQ)); }
+	inline mask_s		operator==(lanes_s a, lanes_s b)				{ return mask_make(_mm256_cmp_ps(a.v, b.v, _CMP_EQ_OQ)); }
+	inline mask_s		operator!=(lanes_s a, lanes_s b)				{ return mask_make(_mm256_cmp_ps(a.v, b.v, _CMP_NEQ_OQ)); }
+	inline mask_s		operator&(mask_s a, mask_s b)					{ return mask_make(_mm256_and_ps(a.v, b.v)); }
+	inline mask_s		operator|(mask_s a, mask_s b)					{ return mask_make(_mm256_or_ps(a.v, b.v)); }
+	inline unsigned int	mask_get_bits(mask_s m)							{ return (unsigned int)_mm256_movemask_ps(m.v); }
+
+	#include "map_model_ray_lanes.cpp"
+}
+
+
+#ifdef MODEL_RAY_AVX512
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// AVX-512 path - 16 lanes. Compiled for AVX-512F whatever the compiler options, only called if the CPU has it.
+
+#if defined(__clang__)
+	#pragma clang attribute pop
+	#pragma clang attribute push(__attribute__((target("avx512f"))), apply_to = function)
+#elif defined(__GNUC__)
+	#pragma GCC pop_options
+	#pragma GCC push_options
+	#pragma GCC target("avx512f")
+#endif
+
+namespace model_ray_avx512
+{
+	struct lanes_s	{ __m512 v; };
+	struct mask_s	{ __mmask16 k; };
+
+	static const unsigned int LANE_COUNT = 16;
+
+	inline lanes_s		lanes_make(__m512 v)							{ lanes_s r; r.v = v; return r; }
+	inline mask_s		mask_make(__mmask16 k)							{ mask_s r; r.k = k; return r; }
+	inline lanes_s		lanes_set(float f)								{ return lanes_make(_mm512_set1_ps(f)); }
+	inline lanes_s		lanes_load(const float* p)						{ return lanes_make(_mm512_loadu_ps(p)); }
+	inline void			lanes_store(float* p, lanes_s a)				{ _mm512_storeu_ps(p, a.v); }
+	inline lanes_s		operator+(lanes_s a, lanes_s b)					{ return lanes_make(_mm512_add_ps(a.v, b.v)); }
+	inline lanes_s		operator-(lanes_s a, lanes_s b)					{ return lanes_make(_mm512_sub_ps(a.v, b.v)); }
+	inline lanes_s		operator*(lanes_s a, lanes_s b)					{ return lanes_make(_mm512_mul_ps(a.v, b.v)); }
+	inline lanes_s		operator/(lanes_s a, lanes_s b)					{ return lanes_make(_mm512_div_ps(a.v, b.v)); }
+	// Min and max are masked, the unmasked forms pass GCC an undefined source that -Wall warns about.
+	inline lanes_s		lanes_min(lanes_s a, lanes_s b)					{ return lanes_make(_mm512_mask_min_ps(a.v, 0xFFFF, a.v, b.v)); }
+	inline lanes_s		lanes_max(lanes_s a, lanes_s b)					{ return lanes_make(_mm512_mask_max_ps(a.v, 0xFFFF, a.v, b.v)); }
+	inline lanes_s		lanes_select(mask_s m, lanes_s a, lanes_s b)	{ return lanes_make(_mm512_mask_blend_ps(m.k, b.v, a.v)); }
+	inline mask_s		operator<(lanes_s a, lanes_s b)					{ return mask_make(_mm512_cmp_ps_mask(a.v, b.v, _CMP_LT_OQ)); }
+	inline mask_s		operator<=(lanes_s a, lanes_s b)				{ return mask_make(_mm512_cmp_ps_mask(a.v, b.v, _CMP_LE_OQ)); }
+	inline mask_s		operator>=(lanes_s a, lanes_s b)				{ return mask_make(_mm512_cmp_ps_mask(a.v, b.v, _CMP_GE_OQ)); }
+	inline mask_s		operator==(lanes_s a, lanes_s b)				{ return mask_make(_mm512_cmp_ps_mask(a.v, b.v, _CMP_EQ_OQ)); }
+	inline mask_s		operator!=(lanes_s a, lanes_s b)				{ return mask_make(_mm512_cmp_ps_mask(a.v, b.v, _CMP_NEQ_OQ)); }
+	inline mask_s		operator&(mask_s a, mask_s b)					{ return mask_make((__mmask16)(a.k & b.k)); }
+	inline mask_s		operator|(mask_s a, mask_s b)					{ return mask_make((__mmask16)(a.k | b.k)); }
+	inline unsigned int	mask_get_bits(mask_s m)							{ return (unsigned int)m.k; }
+
+	#include "map_model_ray_lanes.cpp"
+}
+
+#endif // MODEL_RAY_AVX512
+
+#if defined(__clang__)
+	#pragma clang attribute pop
+#elif defined(__GNUC__)
+	#pragma GCC pop_options
+#endif
+
+#endif // MODEL_RAY_X86
+
+#if defined(__GNUC__) && !defined(__clang__)
+	#pragma GCC pop_options
+#endif
+
+#ifdef MODEL_RAY_X86
+
+// Return the fastest path the CPU and the OS support.
+unsigned int model_ray_get_supported_path(void)
+{
+	// Local data
+	unsigned int								reg[4], extended_reg[4], xcr0;
+
+
+#ifdef _MSC_VER
+	__cpuid((int*)reg, 0);
+	if(reg[0] < 7)
+	{	return MODEL_RAY_PATH_SSE2;
+	}
+	__cpuid((int*)reg, 1);
+	__cpuidex((int*)extended_reg, 7, 0);
+#else
+	if(__get_cpuid_max(0, 0) < 7 || !__get_cpuid(1, &reg[0], &reg[1], &reg[2], &reg[3]))
+	{	return MODEL_RAY_PATH_SSE2;
+	}
+	__cpuid_count(7, 0, extended_reg[0], extended_reg[1], extended_reg[2], extended_reg[3]);
+#endif
+
+	// ECX bit 28 AVX, bit 27 OSXSAVE. The OS must save the registers used.
+	if((reg[2] & ((1u << 28) | (1u << 27))) != ((1u << 28) | (1u << 27)))
+	{	return MODEL_RAY_PATH_SSE2;
+	}
+#ifdef _MSC_VER
+	xcr0 = (unsigned int)_xgetbv(0);
+#else
+	unsigned int edx;
+	__asm__ __volatile__("xgetbv" : "=a"(xcr0), "=d"(edx) : "c"(0));
+#endif
+
+	// Leaf 7 EBX bit 16 AVX-512F with the opmask and upper ZMM registers saved, bit 5 AVX2 with the YMM registers saved.
+#ifdef MODEL_RAY_AVX512
+	if((extended_reg[1] & (1u << 16)) && (xcr0 & 0xE6) == 0xE6)
+	{	return MODEL_RAY_PATH_AVX512;
+	}
+#endif
+	if((extended_reg[1] & (1u << 5)) && (xcr0 & 6) == 6)
+	{	return MODEL_RAY_PATH_AVX2;
+	}
+	return MODEL_RAY_PATH_SSE2;
+}
+
+#endif // MODEL_RAY_X86
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Model ray path functions
+
+// Select the path. MODEL_RAY_PATH_AUTO picks the fastest supported path, a path the CPU does not support falls back to the
+// next fastest. Returns the path selected. Not thread safe, call from on_initialize() when forcing a path. Ray meshes are
+// built for the lanes of the path, so select it before any are built.
+unsigned int model_ray_select_path(unsigned int path)
+{
+#ifdef MODEL_RAY_X86
+	unsigned int supported_path = model_ray_get_supported_path();
+
+	if(path == MODEL_RAY_PATH_AUTO || path > supported_path)
+	{	path = supported_path;
+	}
+#ifdef MODEL_RAY_AVX512
+	if(path == MODEL_RAY_PATH_AVX512)
+	{	model_ray_intersect_function		= model_ray_avx512::intersect;
+		model_ray_intersect_packet_function	= model_ray_avx512::intersect_packet;
+		model_ray_lane_count				= model_ray_avx512::LANE_COUNT;
+	}
+	else
+#endif
+	if(path == MODEL_RAY_PATH_AVX2)
+	{	model_ray_intersect_function		= model_ray_avx2::intersect;
+		model_ray_intersect_packet_function	= model_ray_avx2::intersect_packet;
+		model_ray_lane_count				= model_ray_avx2::LANE_COUNT;
+	}
+	else if(path == MODEL_RAY_PATH_SSE2)
+	{	model_ray_intersect_function		= model_ray_sse2::intersect;
+		model_ray_intersect_packet_function	= model_ray_sse2::intersect_packet;
+		model_ray_lane_count				= model_ray_sse2::LANE_COUNT;
+	}
+	else
+#endif
+	{	path								= MODEL_RAY_PATH_SCALAR;
+		model_ray_intersect_function		= model_ray_scalar::intersect;
+		model_ray_intersect_packet_function	= model_ray_scalar::intersect_packet;
+		model_ray_lane_count				= model_ray_scalar::LANE_COUNT;
+	}
+	model_ray_path = path;
+	return model_ray_path;
+}
+
+// Select the fastest path if model_ray_select_path() was not called. Called once by model_ray_select_default_path().
+void model_ray_select_auto_path(void)
+{
+	if(!model_ray_intersect_function)
+	{	model_ray_select_path(MODEL_RAY_PATH_AUTO);
+	}
+}
+
+// Select the fastest path the first time a path is needed. Maps can ask for it on several threads at once, the path and
+// its lanes are set by one of them before any returns.
+inline void model_ray_select_default_path(void)
+{
+	std::call_once(model_ray_path_once, model_ray_select_auto_path);
+}
+
+// Return the name of the selected path.
+const char* model_ray_get_path_name(void)
+{
+	static const char* name_array[5] = { "auto", "scalar", "sse2", "avx2", "avx512" };
+
+	model_ray_select_default_path();
+	return name_array[model_ray_path];
+}
+
+// Return the triangles in a block of the selected path.
+unsigned int model_ray_get_lane_count(void)
+{
+	model_ray_select_default_path();
+	return model_ray_lane_count;
+}
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Model ray build
+
+// Copy the triangles of each leaf into its blocks. Empty lanes are left with NaN corners no test hits.
+BOOL model_ray_block_body_s::operator()(unsigned int leaf_start, unsigned int leaf_end) const
+{
+	// Local data
+	unsigned int								stack[MODEL_BVH_STACK_SIZE];
+	unsigned int								stack_count, lane_count, block, lane, position, triangle;
+	const unsigned int*							index;
+	float*										block_data;
+
+
+	lane_count = mesh->lane_count;
+	for(unsigned int i=leaf_start; i<leaf_end; i++)
+	{
+		const model_bvh_node_s& leaf = mesh->node_list[leaf_array[i * 2]];
+
+		// Walk the BVH subtree of the leaf.
+		position	= 0;
+		stack_count	= 0;
+		stack[stack_count++] = leaf_array[i * 2 + 1];
+		while(stack_count)
+		{	const model_bvh_node_s& node = bvh->node_array[stack[--stack_count]];
+			if(!node.count)
+			{	stack[stack_count++] = node.first + 1;
+				stack[stack_count++] = node.first;
+				continue;
+			}
+			for(unsigned int j=node.first; j<node.first + node.count; j++, position++)
+			{	triangle	= bvh->triangle_array[j];
+				index		= model->index_array + (size_t)triangle * 7;
+				block		= leaf.first + position / lane_count;
+				lane		= position % lane_count;
+				block_data	= mesh->block_list.data() + (size_t)block * 9 * lane_count + lane;
+				for(unsigned int k=0; k<3; k++)
+				{	const model_input_vector3_s& corner = model->vertex_array[index[k]].position;
+					block_data[(k * 3 + 0) * lane_count] = corner.x;
+					block_data[(k * 3 + 1) * lane_count] = corner.y;
+					block_data[(k * 3 + 2) * lane_count] = corner.z;
+				}
+				mesh->block_triangle_list[(size_t)block * lane_count + lane] = triangle;
+			}
+		}
+	}
+	return TRUE;
+}
+
+// Build a ray mesh from a BVH and the model it was built from for the lanes of the selected path. Returns FALSE if
+// cancelled or out of memory.
+BOOL model_ray_build(const model_bvh_s& bvh, const model_input_data_s& model, model_ray_mesh_s& mesh_out, const parallel_progress_s& progress)
+{
+	// Local data
+	std::vector<unsigned int>					order_list, count_list, source_list, pending_list, leaf_list;
+	unsigned int								lane_count, node_index, source;
+	unsigned long long							block_count;
+	model_ray_block_body_s						block_body;
+
+
+	mesh_out				= model_ray_mesh_s();
+	lane_count				= model_ray_get_lane_count();
+	mesh_out.vertex_count	= bvh.vertex_count;
+	mesh_out.triangle_count	= bvh.triangle_count;
+	mesh_out.lane_count		= lane_count;
+	if(!bvh.node_count)
+	{	return TRUE;
+	}
+	try
+	{
+		// Triangles under each BVH node. Parents come before their children in the walk, so its reverse counts children first.
+		count_list.resize(bvh.node_count);
+		order_list.reserve(bvh.node_count);
+		pending_list.push_back(0);
+		while(!pending_list.empty())
+		{	node_index = pending_list.back();
+			pending_list.pop_back();
+			order_list.push_back(node_index);
+			if(!bvh.node_array[node_index].count)
+			{	pending_list.push_back(bvh.node_array[node_index].first);
+				pending_list.push_back(bvh.node_array[node_index].first + 1);
+			}
+		}
+		for(size_t i=order_list.size(); i-->0; )
+		{	const model_bvh_node_s& node = bvh.node_array[order_list[i]];
+			count_list[order_list[i]] = node.count ? node.count : count_list[node.first] + count_list[node.first + 1];
+		}
+
+		// Copy the nodes. Leaves and inner nodes with no more than lane_count triangles become leaves with blocks.
+		block_count = 0;
+		mesh_out.node_list.reserve(bvh.node_count);
+		mesh_out.node_list.push_back(bvh.node_array[0]);
+		source_list.push_back(0);
+		pending_list.push_back(0);
+		while(!pending_list.empty())
+		{	node_index	= pending_list.back();
+			source		= source_list[node_index];
+			pending_list.pop_back();
+			const model_bvh_node_s& node = bvh.node_array[source];
+			if(node.count || count_list[source] <= lane_count)
+			{	mesh_out.node_list[node_index].first	= (unsigned int)block_count;
+				mesh_out.node_list[node_index].count	= count_list[source];
+				block_count								+= (count_list[source] + lane_count - 1) / lane_count;
+				leaf_list.push_back(node_index);
+				leaf_list.push_back(source);
+			}
+			else
+			{	mesh_out.node_list[node_index].first	= (unsigned int)mesh_out.node_list.size();
+				mesh_out.node_list[node_index].count	= 0;
+				pending_list.push_back((unsigned int)mesh_out.node_list.size() + 1);
+				pending_list.push_back((unsigned int)mesh_out.node_list.size());
+				mesh_out.node_list.push_back(bvh.node_array[node.first]);
+				mesh_out.node_list.push_back(bvh.node_array[node.first + 1]);
+				source_list.push_back(node.first);
+				source_list.push_back(node.first + 1);
+			}
+		}
+		if(block_count * lane_count > UINT_MAX)
+		{	mesh_out = model_ray_mesh_s();
+			return FALSE;
+		}
+		mesh_out.block_list.assign((size_t)block_count * 9 * lane_count, std::numeric_limits<float>::quiet_NaN());
+		mesh_out.block_triangle_list.assign((size_t)block_count * lane_count, MODEL_RAY_NONE);
+	}
+	catch(...)
+	{	mesh_out = model_ray_mesh_s();
+		return FALSE;
+	}
+
+	block_body.bvh			= &bvh;
+	block_body.model		= &model;
+	block_body.mesh			= &mesh_out;
+	block_body.leaf_array	= leaf_list.data();
+	if(!parallel_for((unsigned int)(leaf_list.size() / 2), 1024, block_body, progress))
+	{	mesh_out = model_ray_mesh_s();
+		return FALSE;
+	}
+
+	mesh_out.node_count				= (unsigned int)mesh_out.node_list.size();
+	mesh_out.block_count			= (unsigned int)block_count;
+	mesh_out.node_array				= mesh_out.node_list.data();
+	mesh_out.block_array			= mesh_out.block_list.data();
+	mesh_out.block_triangle_array	= mesh_out.block_triangle_list.data();
+	return TRUE;
+}
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Model ray functions
+
+// Return TRUE if mesh was built from a model with the counts of model for the lanes of the selected path.
+inline BOOL model_ray_is_match(const model_ray_mesh_s* mesh, const model_input_data_s& model)
+{
+	return mesh->version == MODEL_RAY_VERSION && mesh->vertex_count == model.vertex_count && mesh->triangle_count == model.index_count / 7 &&
+		   mesh->lane_count == model_ray_get_lane_count();
+}
+
+// Return the ray mesh of the model (is_cage FALSE) or cage (TRUE) of input input_index of map map_id. model is the input
+// from mp_get_input_model(). The ray mesh is taken from the node cache or built from the BVH of the model, setting
+// progress, and added to it. Returns 0 if cancelled or out of memory. Release it with model_ray_release().
+// The cache name has the lanes of the path and the counts of the model, so a model that changed without a cache clear
+// gets a new name. Its old ray mesh may be shared with other plugins and is left for ShaderMap to clear.
+const model_ray_mesh_s* model_ray_get(unsigned int map_id, unsigned int input_index, BOOL is_cage, const model_input_data_s& model, const parallel_progress_s& progress)
+{
+	// Local data
+	std::wstring								cache_name;
+	unsigned int								cache_type	= is_cage ? CACHE_TYPE_CAGE : CACHE_TYPE_MODEL;
+	unsigned int								node_id;
+	const model_ray_mesh_s*						mesh;
+	const model_bvh_s*							bvh;
+	model_ray_mesh_s*							new_mesh;
+	parallel_progress_s							bvh_progress, build_progress;
+	BOOL										is_success;
+
+
+	try
+	{	cache_name = std::wstring(is_cage ? L"sdk_cage_ray_" : L"sdk_model_ray_") + std::to_wstring(model_ray_get_lane_count()) + L"_v" +
+					 std::to_wstring(MODEL_RAY_VERSION) + L"_" + std::to_wstring(model.vertex_count) + L"_" + std::to_wstring(model.index_count / 7);
+	}
+	catch(...)
+	{	return 0;
+	}
+	node_id = mp_get_input_id ? mp_get_input_id(map_id, input_index) : 0;
+
+	// Built by this plugin.
+	mesh = (const model_ray_mesh_s*)node_cache_get(node_id, cache_name.c_str());
+	if(mesh)
+	{	return mesh;
+	}
+
+	// Built by another plugin.
+	if(mp_get_node_cache)
+	{	mesh = (const model_ray_mesh_s*)mp_get_node_cache(node_id, cache_name.c_str());
+		if(mesh && model_ray_is_match(mesh, model))
+		{	return mesh;
+		}
+	}
+
+	// The BVH takes most of the build time, so it gets the first 3 / 4 of the progress.
+	bvh_progress					= progress;
+	build_progress					= progress;
+	bvh_progress.progress_end		= progress.progress_start + (progress.progress_end - progress.progress_start) * 3 / 4;
+	build_progress.progress_start	= bvh_progress.progress_end;
+
+	bvh = model_bvh_get(map_id, input_index, is_cage, model, bvh_progress);
+	if(!bvh)
+	{	return 0;
+	}
+	new_mesh = new (std::nothrow) model_ray_mesh_s;
+	is_success = new_mesh && model_ray_build(*bvh, model, *new_mesh, build_progress);
+	model_bvh_release(bvh);
+	if(!is_success)
+	{	delete new_mesh;
+		return 0;
+	}
+	return node_cache_add_object(node_id, cache_type, cache_name.c_str(), new_mesh, new_mesh->get_byte_count(), TRUE);
+}
+
+// Release a ray mesh returned by model_ray_get().
+void model_ray_release(const model_ray_mesh_s* mesh)
+{
+	node_cache_release(mesh);
+}
+
+// Find the closest triangle hit by the ray origin + t * direction from t_min up to t_max. test is a MODEL_RAY_TEST_ value.
+// Returns FALSE if none is hit.
+inline BOOL model_ray_intersect(const model_ray_mesh_s& mesh, const float* origin, const float* direction, float t_min, float t_max,
+								unsigned int test, model_bvh_hit_s& hit_out)
+{
+	return model_ray_intersect_function(mesh, origin, direction, t_min, t_max, test, FALSE, hit_out);
+}
+
+// Return TRUE if the ray origin + t * direction hits any triangle from t_min up to t_max. Stops at the first hit found.
+inline BOOL model_ray_occluded(const model_ray_mesh_s& mesh, const float* origin, const float* direction, float t_min, float t_max, unsigned int test)
+{
+	// Local data
+	model_bvh_hit_s								hit;
+
+
+	return model_ray_intersect_function(mesh, origin, direction, t_min, t_max, test, TRUE, hit);
+}
+
+// Find the closest triangle hit by each ray of a packet. Rays that start near each other and go the same way are fastest.
+inline void model_ray_intersect_packet(const model_ray_mesh_s& mesh, const model_ray_packet_s& packet, unsigned int test, model_ray_packet_hit_s& hit_out)
+{
+	model_ray_intersect_packet_function(mesh, packet, test, FALSE, hit_out);
+}
+
+// Find the rays of a packet that hit any triangle. Sets hit_out.triangle to MODEL_RAY_NONE for the rays that do not and
+// returns a bit for each ray that does.
+inline unsigned int model_ray_occluded_packet(const model_ray_mesh_s& mesh, const model_ray_packet_s& packet, unsigned int test, model_ray_packet_hit_s& hit_out)
+{
+	// Local data
+	unsigned int								bits;
+
+
+	model_ray_intersect_packet_function(mesh, packet, test, TRUE, hit_out);
+	bits = 0;
+	for(unsigned int i=0; i<packet.count; i++)
+	{	bits |= hit_out.triangle[i] != MODEL_RAY_NONE ? 1u << i : 0;
+	}
+	return bits;
+}
+
+#endif // MAP_MODEL_RAY_CPP
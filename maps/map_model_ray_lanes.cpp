@@ -0,0 +1,485 @@
+/*
+	===============================================================
+
+	SHADERMAP MODEL RAY LANES SOURCE FILE
+
+	The traversal and triangle tests of one path of
+	"map_model_ray.cpp", written once for any lane width.
+
+	Do not include this file from a plugin. "map_model_ray.cpp"
+	includes it once for each path inside the namespace of that
+	path, after the lanes_s and mask_s types of the path, their
+	functions and LANE_COUNT. The functions of each path are
+	compiled for its instruction set. That is why this file has
+	no include guard, includes nothing and must not call
+	templates from other headers.
+
+
+	SHADERMAP SDK LICENSE
+
+	The ShaderMap SDK is released under The MIT License (MIT)
+	http://opensource.org/licenses/MIT
+
+	Copyright (c) 2007-2019 Rendering Systems Inc.
+
+	Permission is hereby granted, free of charge, to any person
+	obtaining a copy of this software and associated documentation
+	files (the "Software"), to deal	in the Software without
+	restriction, including without limitation the rights to use,
+	copy, modify, merge, publish, distribute, sublicense, and/or
+	sell copies of the Software, and to permit persons to whom the
+	Software is	furnished to do so, subject to the following
+	conditions:
+
+	The above copyright notice and this permission notice shall be
+	included in	all copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+	OF MERCHANTABILITY,	FITNESS FOR A PARTICULAR PURPOSE AND
+	NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+	OTHER DEALINGS IN THE SOFTWARE.
+
+	Developed by: Neil Kemp at Rendering Systems Inc.
+
+	Online:		http://shadermap.com
+	Corporate:	http://renderingsystems.com
+
+	===============================================================
+*/
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Lanes defines
+
+// Chunks of LANE_COUNT rays in a packet.
+static const unsigned int						CHUNK_COUNT = MODEL_RAY_PACKET_SIZE / LANE_COUNT;
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Lanes triangle tests - a ray and a triangle in each lane
+
+// Moller-Trumbore test of the triangles a, b, c. Sets t, and u and v the weights of b and c. Returns the lanes hit
+// from t_min up to but not at t_max. Both sides are hit.
+inline mask_s test_moller_trumbore(const lanes_s* a, const lanes_s* b, const lanes_s* c, const lanes_s* origin, const lanes_s* direction,
+								   lanes_s t_min, lanes_s t_max, lanes_s& t_out, lanes_s& u_out, lanes_s& v_out)
+{
+	// Local data
+	lanes_s										edge_0[3], edge_1[3], p[3], s[3], q[3], determinant, inverse;
+	lanes_s										zero = lanes_set(0.0f), one = lanes_set(1.0f);
+
+
+	for(unsigned int i=0; i<3; i++)
+	{	edge_0[i]	= b[i] - a[i];
+		edge_1[i]	= c[i] - a[i];
+		s[i]		= origin[i] - a[i];
+	}
+	p[0]		= direction[1] * edge_1[2] - direction[2] * edge_1[1];
+	p[1]		= direction[2] * edge_1[0] - direction[0] * edge_1[2];
+	p[2]		= direction[0] * edge_1[1] - direction[1] * edge_1[0];
+	q[0]		= s[1] * edge_0[2] - s[2] * edge_0[1];
+	q[1]		= s[2] * edge_0[0] - s[0] * edge_0[2];
+	q[2]		= s[0] * edge_0[1] - s[1] * edge_0[0];
+	determinant	= edge_0[0] * p[0] + edge_0[1] * p[1] + edge_0[2] * p[2];
+	inverse		= one / determinant;
+	u_out		= (s[0] * p[0] + s[1] * p[1] + s[2] * p[2]) * inverse;
+	v_out		= (direction[0] * q[0] + direction[1] * q[1] + direction[2] * q[2]) * inverse;
+	t_out		= (edge_1[0] * q[0] + edge_1[1] * q[1] + edge_1[2] * q[2]) * inverse;
+	return (determinant != zero) & (u_out >= zero) & (v_out >= zero) & (u_out + v_out <= one) & (t_out >= t_min) & (t_out < t_max);
+}
+
+// Watertight test of the triangles a, b, c. The corners are relative to the ray origin with their axes in the order of
+// model_ray_watertight_s.axis, shear is model_ray_watertight_s.shear. Sets t, and u and v the weights of b and c.
+// Returns the lanes hit from t_min up to but not at t_max. Both sides are hit.
+inline mask_s test_watertight(const lanes_s* a, const lanes_s* b, const lanes_s* c, const lanes_s* shear,
+							  lanes_s t_min, lanes_s t_max, lanes_s& t_out, lanes_s& u_out, lanes_s& v_out)
+{
+	// Local data
+	lanes_s										ax, ay, bx, by, cx, cy, u, v, w, determinant, inverse;
+	lanes_s										zero = lanes_set(0.0f), one = lanes_set(1.0f);
+	mask_s										is_inside;
+
+
+	// Shear the corners so the ray is the z axis, then the signed areas of the edges seen from the ray.
+	ax			= a[0] - shear[0] * a[2];
+	ay			= a[1] - shear[1] * a[2];
+	bx			= b[0] - shear[0] * b[2];
+	by			= b[1] - shear[1] * b[2];
+	cx			= c[0] - shear[0] * c[2];
+	cy			= c[1] - shear[1] * c[2];
+	u			= cx * by - cy * bx;
+	v			= ax * cy - ay * cx;
+	w			= bx * ay - by * ax;
+	is_inside	= ((u >= zero) & (v >= zero) & (w >= zero)) | ((u <= zero) & (v <= zero) & (w <= zero));
+	determinant	= u + v + w;
+	inverse		= one / determinant;
+	t_out		= (u * a[2] + v * b[2] + w * c[2]) * shear[2] * inverse;
+	u_out		= v * inverse;
+	v_out		= w * inverse;
+	return is_inside & (determinant != zero) & (t_out >= t_min) & (t_out < t_max);
+}
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Lanes single ray - one ray against the LANE_COUNT triangles of a block
+
+// Find the closest triangle hit by a ray, or with IS_ANY any triangle. See model_ray_intersect().
+template<bool IS_WATERTIGHT, bool IS_ANY>
+BOOL intersect_ray(const model_ray_mesh_s& mesh, const float* origin, const float* direction, float t_min, float t_max, model_bvh_hit_s& hit_out)
+{
+	// Local data
+	unsigned int								stack[MODEL_BVH_STACK_SIZE];
+	unsigned int								stack_count, node_index, block_end, bits;
+	float										inverse_direction[3], t_near, t_far;
+	float										t_array[LANE_COUNT], u_array[LANE_COUNT], v_array[LANE_COUNT];
+	lanes_s										ray_origin[3], ray_direction[3], shear[3], a[3], b[3], c[3], t, u, v, lane_t_min;
+	const float*								block;
+	model_ray_watertight_s						watertight;
+	BOOL										is_hit;
+
+
+	if(!mesh.node_count)
+	{	return FALSE;
+	}
+	for(unsigned int i=0; i<3; i++)
+	{	inverse_direction[i]	= direction[i] != 0.0f ? 1.0f / direction[i] : (direction[i] < 0.0f ? -FLT_MAX : FLT_MAX);
+		ray_origin[i]			= lanes_set(origin[i]);
+		ray_direction[i]		= lanes_set(direction[i]);
+	}
+	if(IS_WATERTIGHT)
+	{	model_ray_get_watertight(direction, watertight);
+		for(unsigned int i=0; i<3; i++)
+		{	shear[i]		= lanes_set(watertight.shear[i]);
+			ray_origin[i]	= lanes_set(origin[watertight.axis[i]]);
+		}
+	}
+	lane_t_min	= lanes_set(t_min);
+	hit_out.t	= t_max;
+	is_hit		= FALSE;
+	if(model_bvh_enter_node(mesh.node_array[0], origin, inverse_direction, t_min, t_max) == FLT_MAX)
+	{	return FALSE;
+	}
+
+	// Visit the nearer child first and skip nodes entered after the closest hit.
+	stack_count	= 0;
+	node_index	= 0;
+	for(;;)
+	{	const model_bvh_node_s& node = mesh.node_array[node_index];
+		if(node.count)
+		{	block_end = node.first + (node.count + LANE_COUNT - 1) / LANE_COUNT;
+			for(unsigned int i=node.first; i<block_end; i++)
+			{
+				block = mesh.block_array + (size_t)i * 9 * LANE_COUNT;
+				if(IS_WATERTIGHT)
+				{	for(unsigned int j=0; j<3; j++)
+					{	a[j] = lanes_load(block + (0 + watertight.axis[j]) * LANE_COUNT) - ray_origin[j];
+						b[j] = lanes_load(block + (3 + watertight.axis[j]) * LANE_COUNT) - ray_origin[j];
+						c[j] = lanes_load(block + (6 + watertight.axis[j]) * LANE_COUNT) - ray_origin[j];
+					}
+					bits = mask_get_bits(test_watertight(a, b, c, shear, lane_t_min, lanes_set(hit_out.t), t, u, v));
+				}
+				else
+				{	for(unsigned int j=0; j<3; j++)
+					{	a[j] = lanes_load(block + (0 + j) * LANE_COUNT);
+						b[j] = lanes_load(block + (3 + j) * LANE_COUNT);
+						c[j] = lanes_load(block + (6 + j) * LANE_COUNT);
+					}
+					bits = mask_get_bits(test_moller_trumbore(a, b, c, ray_origin, ray_direction, lane_t_min, lanes_set(hit_out.t), t, u, v));
+				}
+				if(!bits)
+				{	continue;
+				}
+				lanes_store(t_array, t);
+				lanes_store(u_array, u);
+				lanes_store(v_array, v);
+				for(unsigned int j=0; j<LANE_COUNT; j++)
+				{	if((bits & (1u << j)) && t_array[j] < hit_out.t)
+					{	hit_out.triangle	= mesh.block_triangle_array[(size_t)i * LANE_COUNT + j];
+						hit_out.t			= t_array[j];
+						hit_out.u			= u_array[j];
+						hit_out.v			= v_array[j];
+					}
+				}
+				if(IS_ANY)
+				{	return TRUE;
+				}
+				is_hit = TRUE;
+			}
+		}
+		else
+		{	t_near	= model_bvh_enter_node(mesh.node_array[node.first], origin, inverse_direction, t_min, hit_out.t);
+			t_far	= model_bvh_enter_node(mesh.node_array[node.first + 1], origin, inverse_direction, t_min, hit_out.t);
+			if(t_near != FLT_MAX || t_far != FLT_MAX)
+			{	node_index = t_near <= t_far ? node.first : node.first + 1;
+				if(t_near != FLT_MAX && t_far != FLT_MAX)
+				{	stack[stack_count++] = t_near <= t_far ? node.first + 1 : node.first;
+				}
+				continue;
+			}
+		}
+		if(!stack_count)
+		{	break;
+		}
+		node_index = stack[--stack_count];
+	}
+	return is_hit;
+}
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Lanes packet - the rays of a packet, LANE_COUNT at a time, against one triangle
+
+// The rays of a packet in lanes.
+struct packet_lanes_s
+{
+	lanes_s										origin[CHUNK_COUNT][3];
+	lanes_s										direction[CHUNK_COUNT][3];
+	lanes_s										inverse_direction[CHUNK_COUNT][3];
+	lanes_s										t_min[CHUNK_COUNT];
+	unsigned int								active_bits[CHUNK_COUNT];	// Rays still traced in each chunk.
+
+	// Watertight only. axis_is_0 and axis_is_1 select the axis of the ray in each lane for each of the 3 sheared axes.
+	lanes_s										shear[CHUNK_COUNT][3];
+	mask_s										axis_is_0[CHUNK_COUNT][3];
+	mask_s										axis_is_1[CHUNK_COUNT][3];
+};
+
+// Return TRUE if any active ray of a packet enters the bounds of a node before its closest hit.
+inline BOOL is_packet_enter_node(const model_bvh_node_s& node, const packet_lanes_s& lanes, const model_ray_packet_hit_s& hit)
+{
+	// Local data
+	lanes_s										t_0, t_1, t_enter, t_exit;
+
+
+	for(unsigned int i=0; i<CHUNK_COUNT; i++)
+	{	if(!lanes.active_bits[i])
+		{	continue;
+		}
+		t_0		= (lanes_set(node.bounds_min.x) - lanes.origin[i][0]) * lanes.inverse_direction[i][0];
+		t_1		= (lanes_set(node.bounds_max.x) - lanes.origin[i][0]) * lanes.inverse_direction[i][0];
+		t_enter	= lanes_max(lanes.t_min[i], lanes_min(t_0, t_1));
+		t_exit	= lanes_min(lanes_load(hit.t + i * LANE_COUNT), lanes_max(t_0, t_1));
+		t_0		= (lanes_set(node.bounds_min.y) - lanes.origin[i][1]) * lanes.inverse_direction[i][1];
+		t_1		= (lanes_set(node.bounds_max.y) - lanes.origin[i][1]) * lanes.inverse_direction[i][1];
+		t_enter	= lanes_max(t_enter, lanes_min(t_0, t_1));
+		t_exit	= lanes_min(t_exit, lanes_max(t_0, t_1));
+		t_0		= (lanes_set(node.bounds_min.z) - lanes.origin[i][2]) * lanes.inverse_direction[i][2];
+		t_1		= (lanes_set(node.bounds_max.z) - lanes.origin[i][2]) * lanes.inverse_direction[i][2];
+		t_enter	= lanes_max(t_enter, lanes_min(t_0, t_1));
+		t_exit	= lanes_min(t_exit, lanes_max(t_0, t_1));
+		if(mask_get_bits(t_enter <= t_exit) & lanes.active_bits[i])
+		{	return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+// Trace the rays of a packet, finding the closest triangle hit by each or with IS_ANY any triangle. See model_ray_intersect_packet().
+template<bool IS_WATERTIGHT, bool IS_ANY>
+void intersect_packet(const model_ray_mesh_s& mesh, const model_ray_packet_s& packet, model_ray_packet_hit_s& hit_out)
+{
+	// Local data
+	unsigned int								stack[MODEL_BVH_STACK_SIZE];
+	unsigned int								stack_count, node_index, lead_ray, axis, triangle, bits, k;
+	float										corner_array[3][3], t_array[LANE_COUNT], u_array[LANE_COUNT], v_array[LANE_COUNT];
+	float										inverse_array[3][MODEL_RAY_PACKET_SIZE], shear_array[3][MODEL_RAY_PACKET_SIZE], axis_array[3][MODEL_RAY_PACKET_SIZE];
+	float										difference, largest;
+	lanes_s										a[3], b[3], c[3], corner[3][3], t, u, v;
+	const float*								block;
+	model_ray_watertight_s						watertight;
+	packet_lanes_s								lanes;
+
+
+	// Rays past packet.count and rays with an empty range are not traced.
+	for(unsigned int i=0; i<MODEL_RAY_PACKET_SIZE; i++)
+	{	hit_out.triangle[i]	= MODEL_RAY_NONE;
+		hit_out.t[i]		= packet.t_max[i];
+		hit_out.u[i]		= 0.0f;
+		hit_out.v[i]		= 0.0f;
+		for(unsigned int j=0; j<3; j++)
+		{	inverse_array[j][i] = packet.direction[j][i] != 0.0f ? 1.0f / packet.direction[j][i] : (packet.direction[j][i] < 0.0f ? -FLT_MAX : FLT_MAX);
+		}
+		if(IS_WATERTIGHT)
+		{	float direction[3] = { packet.direction[0][i], packet.direction[1][i], packet.direction[2][i] };
+			model_ray_get_watertight(direction, watertight);
+			for(unsigned int j=0; j<3; j++)
+			{	shear_array[j][i]	= watertight.shear[j];
+				axis_array[j][i]	= (float)watertight.axis[j];
+			}
+		}
+	}
+	lead_ray = MODEL_RAY_NONE;
+	for(unsigned int i=0; i<CHUNK_COUNT; i++)
+	{	lanes.active_bits[i] = 0;
+		for(unsigned int j=0; j<LANE_COUNT; j++)
+		{	k = i * LANE_COUNT + j;
+			if(k < packet.count && packet.t_min[k] <= packet.t_max[k])
+			{	lanes.active_bits[i] |= 1u << j;
+				lead_ray = lead_ray == MODEL_RAY_NONE ? k : lead_ray;
+			}
+		}
+		for(unsigned int j=0; j<3; j++)
+		{	lanes.origin[i][j]				= lanes_load(packet.origin[j] + i * LANE_COUNT);
+			lanes.direction[i][j]			= lanes_load(packet.direction[j] + i * LANE_COUNT);
+			lanes.inverse_direction[i][j]	= lanes_load(inverse_array[j] + i * LANE_COUNT);
+			if(IS_WATERTIGHT)
+			{	lanes.shear[i][j]			= lanes_load(shear_array[j] + i * LANE_COUNT);
+				lanes.axis_is_0[i][j]		= lanes_load(axis_array[j] + i * LANE_COUNT) == lanes_set(0.0f);
+				lanes.axis_is_1[i][j]		= lanes_load(axis_array[j] + i * LANE_COUNT) == lanes_set(1.0f);
+			}
+		}
+		lanes.t_min[i] = lanes_load(packet.t_min + i * LANE_COUNT);
+	}
+	if(!mesh.node_count || lead_ray == MODEL_RAY_NONE || !is_packet_enter_node(mesh.node_array[0], lanes, hit_out))
+	{	return;
+	}
+
+	// Visit the child nearer along the lead ray first. Nodes are entered if any active ray enters them.
+	stack_count	= 0;
+	node_index	= 0;
+	for(;;)
+	{	const model_bvh_node_s& node = mesh.node_array[node_index];
+		if(node.count)
+		{	for(unsigned int i=0; i<node.count; i++)
+			{
+				block		= mesh.block_array + (size_t)(node.first + i / LANE_COUNT) * 9 * LANE_COUNT + i % LANE_COUNT;
+				triangle	= mesh.block_triangle_array[(size_t)(node.first + i / LANE_COUNT) * LANE_COUNT + i % LANE_COUNT];
+				for(unsigned int j=0; j<3; j++)
+				{	for(unsigned int l=0; l<3; l++)
+					{	corner_array[j][l] = block[(j * 3 + l) * LANE_COUNT];
+					}
+				}
+				for(unsigned int j=0; j<CHUNK_COUNT; j++)
+				{
+					if(!lanes.active_bits[j])
+					{	continue;
+					}
+					if(IS_WATERTIGHT)
+					{	for(unsigned int l=0; l<3; l++)
+						{	corner[0][l] = lanes_set(corner_array[0][l]) - lanes.origin[j][l];
+							corner[1][l] = lanes_set(corner_array[1][l]) - lanes.origin[j][l];
+							corner[2][l] = lanes_set(corner_array[2][l]) - lanes.origin[j][l];
+						}
+						for(unsigned int l=0; l<3; l++)
+						{	a[l] = lanes_select(lanes.axis_is_0[j][l], corner[0][0], lanes_select(lanes.axis_is_1[j][l], corner[0][1], corner[0][2]));
+							b[l] = lanes_select(lanes.axis_is_0[j][l], corner[1][0], lanes_select(lanes.axis_is_1[j][l], corner[1][1], corner[1][2]));
+							c[l] = lanes_select(lanes.axis_is_0[j][l], corner[2][0], lanes_select(lanes.axis_is_1[j][l], corner[2][1], corner[2][2]));
+						}
+						bits = mask_get_bits(test_watertight(a, b, c, lanes.shear[j], lanes.t_min[j], lanes_load(hit_out.t + j * LANE_COUNT), t, u, v));
+					}
+					else
+					{	for(unsigned int l=0; l<3; l++)
+						{	a[l] = lanes_set(corner_array[0][l]);
+							b[l] = lanes_set(corner_array[1][l]);
+							c[l] = lanes_set(corner_array[2][l]);
+						}
+						bits = mask_get_bits(test_moller_trumbore(a, b, c, lanes.origin[j], lanes.direction[j], lanes.t_min[j], lanes_load(hit_out.t + j * LANE_COUNT), t, u, v));
+					}
+					bits &= lanes.active_bits[j];
+					if(!bits)
+					{	continue;
+					}
+					lanes_store(t_array, t);
+					lanes_store(u_array, u);
+					lanes_store(v_array, v);
+					for(unsigned int l=0; l<LANE_COUNT; l++)
+					{	if(bits & (1u << l))
+						{	k						= j * LANE_COUNT + l;
+							hit_out.triangle[k]		= triangle;
+							hit_out.t[k]			= t_array[l];
+							hit_out.u[k]			= u_array[l];
+							hit_out.v[k]			= v_array[l];
+						}
+					}
+					if(IS_ANY)
+					{	lanes.active_bits[j] &= ~bits;
+					}
+				}
+				if(IS_ANY)
+				{	bits = 0;
+					for(unsigned int j=0; j<CHUNK_COUNT; j++)
+					{	bits |= lanes.active_bits[j];
+					}
+					if(!bits)
+					{	return;
+					}
+				}
+			}
+		}
+		else
+		{	const model_bvh_node_s& near_node	= mesh.node_array[node.first];
+			const model_bvh_node_s& far_node	= mesh.node_array[node.first + 1];
+			BOOL is_near, is_far;
+
+			// The axis the centers of the children are furthest apart on and the lead ray's direction on it.
+			axis	= 0;
+			largest	= -1.0f;
+			for(unsigned int i=0; i<3; i++)
+			{	difference = (&far_node.bounds_min.x)[i] + (&far_node.bounds_max.x)[i] - (&near_node.bounds_min.x)[i] - (&near_node.bounds_max.x)[i];
+				difference = difference < 0.0f ? -difference : difference;
+				if(difference > largest)
+				{	largest	= difference;
+					axis	= i;
+				}
+			}
+			k = (packet.direction[axis][lead_ray] < 0.0f) == ((&far_node.bounds_min.x)[axis] + (&far_node.bounds_max.x)[axis] <
+															  (&near_node.bounds_min.x)[axis] + (&near_node.bounds_max.x)[axis]) ? 0 : 1;
+			is_near	= is_packet_enter_node(mesh.node_array[node.first + k], lanes, hit_out);
+			is_far	= is_packet_enter_node(mesh.node_array[node.first + 1 - k], lanes, hit_out);
+			if(is_near || is_far)
+			{	node_index = is_near ? node.first + k : node.first + 1 - k;
+				if(is_near && is_far)
+				{	stack[stack_count++] = node.first + 1 - k;
+				}
+				continue;
+			}
+		}
+		if(!stack_count)
+		{	break;
+		}
+		node_index = stack[--stack_count];
+	}
+}
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Lanes entry points - see the model_ray_ functions of "map_model_ray.cpp".
+
+// Trace one ray.
+BOOL intersect(const model_ray_mesh_s& mesh, const float* origin, const float* direction, float t_min, float t_max,
+			   unsigned int test, BOOL is_any, model_bvh_hit_s& hit_out)
+{
+	if(test == MODEL_RAY_TEST_WATERTIGHT)
+	{	return is_any ? intersect_ray<true, true>(mesh, origin, direction, t_min, t_max, hit_out) :
+						intersect_ray<true, false>(mesh, origin, direction, t_min, t_max, hit_out);
+	}
+	return is_any ? intersect_ray<false, true>(mesh, origin, direction, t_min, t_max, hit_out) :
+					intersect_ray<false, false>(mesh, origin, direction, t_min, t_max, hit_out);
+}
+
+// Trace a packet of rays.
+void intersect_packet(const model_ray_mesh_s& mesh, const model_ray_packet_s& packet, unsigned int test, BOOL is_any, model_ray_packet_hit_s& hit_out)
+{
+	if(test == MODEL_RAY_TEST_WATERTIGHT)
+	{	if(is_any)
+		{	intersect_packet<true, true>(mesh, packet, hit_out);
+		}
+		else
+		{	intersect_packet<true, false>(mesh, packet, hit_out);
+		}
+	}
+	else if(is_any)
+	{	intersect_packet<false, true>(mesh, packet, hit_out);
+	}
+	else
+	{	intersect_packet<false, false>(mesh, packet, hit_out);
+	}
+}
@@ -0,0 +1,1150 @@
+/*
+	===============================================================
+
+	SHADERMAP MAP MODEL TANGENT SPACE SOURCE FILE
+
+	Creates smooth vertex normals and tangents for a model in the
+	layout of model_input_data_s: vertices with a position and a
+	normal, a list of uvs and 7 indices per triangle (vertex a, b,
+	c, uv a, b, c and the start index).
+
+	model_create_normals() makes the normal of each triangle corner
+	the average of the normals of the triangles around its position,
+	each weighted by the angle of its corner or by its area. The
+	normal of a triangle with corners a, b and c is along
+	cross(b - a, c - a). Only triangles that meet the corner's
+	triangle at less than the crease angle are averaged, so hard
+	edges stay hard. Vertices are welded by position first and
+	split again where the corner normals differ, and the vertex
+	indices of the triangles are rewritten.
+
+	model_create_tangents() makes a tangent and handedness for each
+	triangle corner by the steps of genTangSpaceDefault() of Morten
+	Mikkelsen's mikktspace.c, the tangent space used by most bakers
+	and engines. It is written to match mikktspace.c but has not
+	been compared with its output, mikktspace.c is not part of the
+	SDK. Corners with the same position, normal and uv are one
+	vertex. At each vertex the triangles joined by edges and with
+	the same uv orientation are a group and share one tangent, the
+	angle weighted average of their uv tangents. w is 1.0 or -1.0
+	so that the bi-normal is cross(N, T.xyz) * T.w.
+
+	mikktspace.c runs on one thread and its sort of all corners and
+	all edges is most of its time. Here corners are welded by
+	hashing in partitions and edges are paired at their lowest
+	vertex, both on all cores. Triangle tangents and the tangent of
+	each group are found on all cores too. Only the walk that
+	builds the groups runs on one thread, as in mikktspace.c the
+	orientation of a triangle with no uv area depends on the group
+	that reaches it first. The order of all sums is kept so the
+	results do not depend on the thread count.
+
+	Include this source code file in a map plugin after the plugin
+	core file. #include "../../map_model_tangent_space.cpp"
+
+	--
+
+	Example:
+
+	if(!model_create_normals(vertex_list, index_list.data(), (unsigned int)index_list.size(), 60.0f, MODEL_NORMALS_WEIGHT_ANGLE))
+	{	... out of memory ...
+	}
+	tangent_list.resize(index_list.size() / 7 * 3);
+	if(!model_create_tangents(vertex_list.data(), (unsigned int)vertex_list.size(), uv_list.data(), (unsigned int)uv_list.size(),
+							  index_list.data(), (unsigned int)index_list.size(), tangent_list.data()))
+	{	... out of memory ...
+	}
+
+	The indices must be in range. Loops run within the map thread
+	limit and are not cancelled. Call parallel_shutdown() from
+	on_shutdown().
+
+
+	SHADERMAP SDK LICENSE
+
+	The ShaderMap SDK is released under The MIT License (MIT)
+	http://opensource.org/licenses/MIT
+
+	Copyright (c) 2007-2019 Rendering Systems Inc.
+
+	Permission is hereby granted, free of charge, to any person
+	obtaining a copy of this software and associated documentation
+	files (the "Software"), to deal	in the Software without
+	restriction, including without limitation the rights to use,
+	copy, modify, merge, publish, distribute, sublicense, and/or
+	sell copies of the Software, and to permit persons to whom the
+	Software is	furnished to do so, subject to the following
+	conditions:
+
+	The above copyright notice and this permission notice shall be
+	included in	all copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+	OF MERCHANTABILITY,	FITNESS FOR A PARTICULAR PURPOSE AND
+	NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+	OTHER DEALINGS IN THE SOFTWARE.
+
+	Developed by: Neil Kemp at Rendering Systems Inc.
+
+	Online:		http://shadermap.com
+	Corporate:	http://renderingsystems.com
+
+	===============================================================
+*/
+
+#ifndef MAP_MODEL_TANGENT_SPACE_CPP
+#define MAP_MODEL_TANGENT_SPACE_CPP
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Model tangent space includes
+
+#include "../common/plugin_thread_pool.cpp"
+#include <float.h>
+#include <limits.h>
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Model tangent space defines
+
+// Weights of the triangle normals averaged by model_create_normals().
+#define MODEL_NORMALS_WEIGHT_ANGLE				0			// The angle of the triangle at the corner.
+#define MODEL_NORMALS_WEIGHT_AREA				1			// The area of the triangle.
+
+// Partitions the values of a weld are split into by the high bits of their hash.
+#define MODEL_WELD_PARTITION_BITS				6
+#define MODEL_WELD_PARTITION_COUNT				(1u << MODEL_WELD_PARTITION_BITS)
+
+// Items in each chunk given to a thread.
+#define MODEL_TS_CHUNK_SIZE						16384
+
+// Positions or groups in each chunk given to a thread.
+#define MODEL_TS_GROUP_CHUNK_SIZE				1024
+
+// No index.
+#define MODEL_TS_NONE							UINT_MAX
+
+// Triangle flags, as in mikktspace.c.
+#define MODEL_TS_ORIENT_PRESERVING				1			// The uvs are not mirrored.
+#define MODEL_TS_GROUP_WITH_ANY					2			// The uvs have no area, the triangle joins any group.
+
+// Cosine of the angle two triangles of a group can be apart and still share a tangent. genTangSpaceDefault() uses
+// 180 degrees.
+#define MODEL_TS_THRESHOLD_COS					-1.0f
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Model tangent space structs
+
+// Welds values that are equal. Item i is component_count floats at value_array + i * stride.
+struct model_weld_s
+{
+	const float*								value_array;
+	unsigned int								stride;
+	unsigned int								component_count;
+	unsigned int								count;
+	unsigned int*								first_array;				// The first item equal to each item.
+	std::vector<unsigned int>					hash_list;
+	std::vector<unsigned int>					item_list;					// Items by partition in item order.
+	std::vector<unsigned int>					chunk_count_list;			// Items of each chunk in each partition, then their item_list offsets.
+	unsigned int								partition_start_array[MODEL_WELD_PARTITION_COUNT + 1];
+};
+
+// The state of model_create_normals().
+struct model_normals_s
+{
+	const model_input_vertex_s*					vertex_array;				// The vertices before they are split.
+	unsigned int*								index_array;
+	unsigned int								triangle_count;
+	std::vector<unsigned int>					first_list;					// The first vertex at the position of each vertex.
+	std::vector<unsigned int>					corner_start_list;			// First entry of each position in corner_list, by first vertex.
+	std::vector<unsigned int>					corner_list;				// Corners (triangle * 3 + corner) by position in corner order.
+	std::vector<float>							face_normal_list;			// 4 per triangle, its unit normal and twice its area.
+	std::vector<float>							normal_list;				// 3 per corner_list entry, the normal of the corner.
+	std::vector<unsigned int>					vertex_list;				// Per corner_list entry, its new vertex counted from 0 at each position.
+	std::vector<unsigned int>					vertex_start_list;			// New vertices at each position, then the first of them.
+	float										crease_cos;
+	BOOL										is_crease;
+	unsigned int								weight_type;
+};
+
+// The state of model_create_tangents(). Good triangles are the ones with three different positions, numbered in order.
+// A vertex is a corner's (first vertex with its position and normal, first uv with its uv).
+struct model_tangents_s
+{
+	const model_input_vertex_s*					vertex_array;
+	const model_input_vector2_s*				uv_array;
+	const unsigned int*							index_array;
+	model_input_tangent_s*						tangent_array;
+	unsigned int								triangle_count;
+	unsigned int								good_count;
+	std::vector<unsigned int>					vertex_first_list;
+	std::vector<unsigned int>					uv_first_list;
+	std::vector<unsigned int>					triangle_list;				// Triangle of each good triangle, then the others.
+	std::vector<float>							os_list;					// 3 per good triangle, the uv tangent.
+	std::vector<float>							ot_list;					// 3 per good triangle, the uv bi-tangent.
+	std::vector<unsigned char>					flag_list;					// Per good triangle.
+	std::vector<unsigned int>					edge_start_list;			// First entry of each vertex in edge_list.
+	std::vector<unsigned int>					edge_list;					// Edges (good triangle * 3 + edge) by the vertex of their lowest end.
+	std::vector<unsigned int>					neighbor_list;				// 3 per good triangle, the good triangle across edge i to i + 1.
+	std::vector<unsigned int>					group_list;					// 3 per good triangle, the group of each corner.
+	std::vector<unsigned int>					group_start_list;			// First entry of each group in member_list, and the end.
+	std::vector<unsigned long long>				group_vertex_list;
+	std::vector<unsigned char>					group_orient_list;
+	std::vector<unsigned int>					member_list;				// Good triangles of each group in the order they joined.
+};
+
+// An edge ready to be paired.
+struct model_tangents_edge_s
+{
+	unsigned long long							low;						// The vertices at its ends, lowest first.
+	unsigned long long							high;
+	unsigned int								edge;						// Good triangle * 3 + edge
+
+	bool operator<(const model_tangents_edge_s& other) const
+	{	return low != other.low ? low < other.low : (high != other.high ? high < other.high : edge < other.edge);
+	}
+};
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Model tangent space vector functions
+
+inline float model_ts_dot(const float* a, const float* b)
+{
+	return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+// The same as NotZero() of mikktspace.c.
+inline BOOL model_ts_is_not_zero(float value)
+{
+	return fabsf(value) > FLT_MIN;
+}
+
+inline BOOL model_ts_is_not_zero(const float* v)
+{
+	return model_ts_is_not_zero(v[0]) || model_ts_is_not_zero(v[1]) || model_ts_is_not_zero(v[2]);
+}
+
+// Scale v to unit length the way mikktspace.c does.
+inline void model_ts_normalize(float* v)
+{
+	float scale = 1 / sqrtf(model_ts_dot(v, v));
+
+	v[0] = scale * v[0]; v[1] = scale * v[1]; v[2] = scale * v[2];
+}
+
+// Set v_out to v less its part along unit vector n, made unit length if it is not 0.
+inline void model_ts_project(const float* v, const float* n, float* v_out)
+{
+	float d = model_ts_dot(n, v);
+
+	v_out[0] = v[0] - d * n[0]; v_out[1] = v[1] - d * n[1]; v_out[2] = v[2] - d * n[2];
+	if(model_ts_is_not_zero(v_out))
+	{	model_ts_normalize(v_out);
+	}
+}
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Model weld functions
+
+// Return the hash of an item. -0 hashes as 0 as they are equal.
+inline unsigned int model_weld_hash(const float* value, unsigned int component_count)
+{
+	// Local data
+	unsigned long long							hash;
+	unsigned int								bits;
+	float										component;
+
+
+	hash = 0x9E3779B97F4A7C15ull;
+	for(unsigned int i=0; i<component_count; i++)
+	{	component = value[i] + 0.0f;
+		memcpy(&bits, &component, 4);
+		hash = (hash ^ bits) * 0xC2B2AE3D27D4EB4Full;
+	}
+	hash ^= hash >> 29;
+	hash *= 0xFF51AFD7ED558CCDull;
+	return (unsigned int)(hash >> 32);
+}
+
+// Hash each item and count the items of each chunk in each partition.
+struct model_weld_hash_body_s
+{
+	model_weld_s*								weld;
+
+	BOOL operator()(unsigned int chunk_start, unsigned int chunk_end) const
+	{	for(unsigned int chunk=chunk_start; chunk<chunk_end; chunk++)
+		{	unsigned int*	count_array	= &weld->chunk_count_list[(size_t)chunk * MODEL_WELD_PARTITION_COUNT];
+			unsigned int	end			= std::min<unsigned int>((chunk + 1) * MODEL_TS_CHUNK_SIZE, weld->count);
+			memset(count_array, 0, MODEL_WELD_PARTITION_COUNT * sizeof(unsigned int));
+			for(unsigned int i=chunk*MODEL_TS_CHUNK_SIZE; i<end; i++)
+			{	weld->hash_list[i] = model_weld_hash(weld->value_array + (size_t)i * weld->stride, weld->component_count);
+				count_array[weld->hash_list[i] >> (32 - MODEL_WELD_PARTITION_BITS)]++;
+			}
+		}
+		return TRUE;
+	}
+};
+
+// Write the items of each chunk to their partitions in item order.
+struct model_weld_scatter_body_s
+{
+	model_weld_s*								weld;
+
+	BOOL operator()(unsigned int chunk_start, unsigned int chunk_end) const
+	{	for(unsigned int chunk=chunk_start; chunk<chunk_end; chunk++)
+		{	unsigned int*	offset_array	= &weld->chunk_count_list[(size_t)chunk * MODEL_WELD_PARTITION_COUNT];
+			unsigned int	end				= std::min<unsigned int>((chunk + 1) * MODEL_TS_CHUNK_SIZE, weld->count);
+			for(unsigned int i=chunk*MODEL_TS_CHUNK_SIZE; i<end; i++)
+			{	weld->item_list[offset_array[weld->hash_list[i] >> (32 - MODEL_WELD_PARTITION_BITS)]++] = i;
+			}
+		}
+		return TRUE;
+	}
+};
+
+// Find the first equal item of each item of a partition with a hash table of the items seen.
+struct model_weld_insert_body_s
+{
+	model_weld_s*								weld;
+
+	BOOL operator()(unsigned int partition_start, unsigned int partition_end) const
+	{	for(unsigned int partition=partition_start; partition<partition_end; partition++)
+		{	unsigned int	start	= weld->partition_start_array[partition];
+			unsigned int	end		= weld->partition_start_array[partition + 1];
+			size_t			mask	= 1023;
+			while(mask < (size_t)(end - start) * 2)
+			{	mask = mask * 2 + 1;
+			}
+			try
+			{	std::vector<unsigned int> table(mask + 1, MODEL_TS_NONE);
+				for(unsigned int i=start; i<end; i++)
+				{	unsigned int	item	= weld->item_list[i];
+					unsigned int	hash	= weld->hash_list[item];
+					const float*	value	= weld->value_array + (size_t)item * weld->stride;
+					size_t			slot;
+					weld->first_array[item] = item;
+					for(slot=hash&mask; table[slot]!=MODEL_TS_NONE; slot=(slot + 1) & mask)
+					{	const float*	other		= weld->value_array + (size_t)table[slot] * weld->stride;
+						BOOL			is_equal	= weld->hash_list[table[slot]] == hash;
+						for(unsigned int j=0; is_equal && j<weld->component_count; j++)
+						{	is_equal = value[j] == other[j];
+						}
+						if(is_equal)
+						{	weld->first_array[item] = table[slot];
+							break;
+						}
+					}
+					if(table[slot] == MODEL_TS_NONE)
+					{	table[slot] = item;
+					}
+				}
+			}
+			catch(...)
+			{	return FALSE;
+			}
+		}
+		return TRUE;
+	}
+};
+
+// Set first_array_out[i] to the lowest item equal to item i. Item i is component_count floats at value_array + i * stride.
+// Floats are compared with == so 0 and -0 are equal and NaN is equal to nothing. Runs on all cores. Returns FALSE if
+// out of memory.
+BOOL model_weld_values(const float* value_array, unsigned int stride, unsigned int component_count, unsigned int count, unsigned int* first_array_out)
+{
+	// Local data
+	model_weld_s								weld;
+	model_weld_hash_body_s						hash_body;
+	model_weld_scatter_body_s					scatter_body;
+	model_weld_insert_body_s					insert_body;
+	unsigned int								chunk_count, offset;
+
+
+	weld.value_array		= value_array;
+	weld.stride				= stride;
+	weld.component_count	= component_count;
+	weld.count				= count;
+	weld.first_array		= first_array_out;
+	chunk_count				= (unsigned int)(((unsigned long long)count + MODEL_TS_CHUNK_SIZE - 1) / MODEL_TS_CHUNK_SIZE);
+	try
+	{	weld.hash_list.resize(count);
+		weld.item_list.resize(count);
+		weld.chunk_count_list.resize((size_t)chunk_count * MODEL_WELD_PARTITION_COUNT);
+	}
+	catch(...)
+	{	return FALSE;
+	}
+
+	// Hash, then split the items into partitions in item order so the first item of each value is found first.
+	hash_body.weld = &weld;
+	parallel_for(chunk_count, 1, hash_body, parallel_progress_s());
+
+	offset = 0;
+	for(unsigned int partition=0; partition<MODEL_WELD_PARTITION_COUNT; partition++)
+	{	weld.partition_start_array[partition] = offset;
+		for(unsigned int chunk=0; chunk<chunk_count; chunk++)
+		{	unsigned int& chunk_count_value = weld.chunk_count_list[(size_t)chunk * MODEL_WELD_PARTITION_COUNT + partition];
+			unsigned int chunk_offset = offset;
+			offset += chunk_count_value;
+			chunk_count_value = chunk_offset;
+		}
+	}
+	weld.partition_start_array[MODEL_WELD_PARTITION_COUNT] = offset;
+
+	scatter_body.weld = &weld;
+	parallel_for(chunk_count, 1, scatter_body, parallel_progress_s());
+
+	insert_body.weld = &weld;
+	return parallel_for(MODEL_WELD_PARTITION_COUNT, 1, insert_body, parallel_progress_s());
+}
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Model normals functions
+
+// Sets the unit normal and area of each triangle.
+struct model_normals_face_body_s
+{
+	model_normals_s*							normals;
+
+	BOOL operator()(unsigned int triangle_start, unsigned int triangle_end) const
+	{	for(unsigned int i=triangle_start; i<triangle_end; i++)
+		{	const unsigned int*				index	= normals->index_array + (size_t)i * 7;
+			const model_input_vector3_s&	a		= normals->vertex_array[index[0]].position;
+			const model_input_vector3_s&	b		= normals->vertex_array[index[1]].position;
+			const model_input_vector3_s&	c		= normals->vertex_array[index[2]].position;
+			float							edge_0[3]	= {b.x - a.x, b.y - a.y, b.z - a.z};
+			float							edge_1[3]	= {c.x - a.x, c.y - a.y, c.z - a.z};
+			float*							normal		= &normals->face_normal_list[(size_t)i * 4];
+			normal[0] = edge_0[1] * edge_1[2] - edge_0[2] * edge_1[1];
+			normal[1] = edge_0[2] * edge_1[0] - edge_0[0] * edge_1[2];
+			normal[2] = edge_0[0] * edge_1[1] - edge_0[1] * edge_1[0];
+			normal[3] = sqrtf(model_ts_dot(normal, normal));
+			for(unsigned int j=0; j<3; j++)
+			{	normal[j] = normal[3] > 0.0f ? normal[j] / normal[3] : 0.0f;
+			}
+		}
+		return TRUE;
+	}
+};
+
+// Return the weight of the normal of the triangle of a corner.
+inline float model_normals_get_weight(const model_normals_s& normals, unsigned int corner)
+{
+	// Local data
+	const unsigned int*							index;
+	float										edge_0[3], edge_1[3], length, cosine;
+
+
+	if(normals.weight_type == MODEL_NORMALS_WEIGHT_AREA)
+	{	return normals.face_normal_list[(size_t)(corner / 3) * 4 + 3];
+	}
+
+	index = normals.index_array + (size_t)(corner / 3) * 7;
+	const model_input_vector3_s& p = normals.vertex_array[index[corner % 3]].position;
+	const model_input_vector3_s& a = normals.vertex_array[index[(corner + 1) % 3]].position;
+	const model_input_vector3_s& b = normals.vertex_array[index[(corner + 2) % 3]].position;
+	edge_0[0] = a.x - p.x; edge_0[1] = a.y - p.y; edge_0[2] = a.z - p.z;
+	edge_1[0] = b.x - p.x; edge_1[1] = b.y - p.y; edge_1[2] = b.z - p.z;
+	length = sqrtf(model_ts_dot(edge_0, edge_0) * model_ts_dot(edge_1, edge_1));
+	if(!(length > 0.0f))
+	{	return 0.0f;
+	}
+	cosine = model_ts_dot(edge_0, edge_1) / length;
+	return acosf(std::min(std::max(cosine, -1.0f), 1.0f));
+}
+
+// Finds the normal of each corner at a position and numbers the vertices they make, corners with the same normal
+// share a vertex.
+struct model_normals_vertex_body_s
+{
+	model_normals_s*							normals;
+
+	BOOL operator()(unsigned int position_start, unsigned int position_end) const
+	{	try
+		{	std::vector<float>			weight_list;
+			float						normal[3];
+			unsigned int				vertex_count;
+
+			for(unsigned int position=position_start; position<position_end; position++)
+			{	unsigned int		start			= normals->corner_start_list[position];
+				unsigned int		corner_count	= normals->corner_start_list[position + 1] - start;
+				const unsigned int*	corner_array	= normals->corner_list.data() + start;
+				float*				normal_array	= normals->normal_list.data() + (size_t)start * 3;
+				unsigned int*		vertex_array	= normals->vertex_list.data() + start;
+				if(!corner_count)
+				{	continue;
+				}
+				weight_list.resize(corner_count);
+				for(unsigned int i=0; i<corner_count; i++)
+				{	weight_list[i] = model_normals_get_weight(*normals, corner_array[i]);
+				}
+
+				// Sum the weighted normals of the triangles within the crease angle. A triangle with no area is smooth
+				// with all. With no crease all corners have the same normal.
+				for(unsigned int i=0; i<corner_count; i++)
+				{	const float* unit = &normals->face_normal_list[(size_t)(corner_array[i] / 3) * 4];
+					if(i > 0 && !normals->is_crease)
+					{	memcpy(normal_array + (size_t)i * 3, normal_array, sizeof(normal));
+						continue;
+					}
+					normal[0] = normal[1] = normal[2] = 0.0f;
+					for(unsigned int j=0; j<corner_count; j++)
+					{	const float* other = &normals->face_normal_list[(size_t)(corner_array[j] / 3) * 4];
+						if(!normals->is_crease || !(unit[3] > 0.0f) || model_ts_dot(unit, other) >= normals->crease_cos)
+						{	normal[0] += weight_list[j] * other[0];
+							normal[1] += weight_list[j] * other[1];
+							normal[2] += weight_list[j] * other[2];
+						}
+					}
+					float length = sqrtf(model_ts_dot(normal, normal));
+					for(unsigned int k=0; k<3; k++)
+					{	normal_array[(size_t)i * 3 + k] = length > 0.0f ? normal[k] / length : 0.0f;
+					}
+				}
+
+				// Number the different normals in corner order.
+				vertex_count = 0;
+				for(unsigned int i=0; i<corner_count; i++)
+				{	vertex_array[i] = normals->is_crease ? vertex_count : 0;
+					for(unsigned int j=0; j<i && normals->is_crease; j++)
+					{	if(!memcmp(normal_array + (size_t)i * 3, normal_array + (size_t)j * 3, sizeof(normal)))
+						{	vertex_array[i] = vertex_array[j];
+							break;
+						}
+					}
+					if(vertex_array[i] == vertex_count)
+					{	vertex_count++;
+					}
+				}
+				normals->vertex_start_list[position] = vertex_count;
+			}
+		}
+		catch(...)
+		{	return FALSE;
+		}
+		return TRUE;
+	}
+};
+
+// Writes the new vertices of each position and the vertex indices of its corners.
+struct model_normals_write_body_s
+{
+	model_normals_s*							normals;
+	model_input_vertex_s*						vertex_array;
+
+	BOOL operator()(unsigned int position_start, unsigned int position_end) const
+	{	for(unsigned int position=position_start; position<position_end; position++)
+		{	unsigned int					first	= normals->vertex_start_list[position];
+			const model_input_vector3_s&	p		= normals->vertex_array[position].position;
+			for(unsigned int i=normals->corner_start_list[position]; i<normals->corner_start_list[position + 1]; i++)
+			{	unsigned int			corner	= normals->corner_list[i];
+				model_input_vertex_s&	vertex	= vertex_array[first + normals->vertex_list[i]];
+				vertex.position		= p;
+				vertex.normal.x		= normals->normal_list[(size_t)i * 3];
+				vertex.normal.y		= normals->normal_list[(size_t)i * 3 + 1];
+				vertex.normal.z		= normals->normal_list[(size_t)i * 3 + 2];
+				normals->index_array[(size_t)(corner / 3) * 7 + corner % 3] = first + normals->vertex_list[i];
+			}
+		}
+		return TRUE;
+	}
+};
+
+// Replace the normals of a model with smooth normals. Triangles that meet at more than crease_angle_degree keep
+// their own normals, 180 or more makes all smooth. weight_type is MODEL_NORMALS_WEIGHT_ANGLE or _AREA. The vertex list
+// is rebuilt: vertices with the same position are welded then split where the normals of their corners differ,
+// unused vertices are dropped and the vertex indices of index_array are rewritten. Uvs are unchanged. Runs on all
+// cores. Returns FALSE if out of memory, the model is then unchanged.
+BOOL model_create_normals(std::vector<model_input_vertex_s>& vertex_list_in_out, unsigned int* index_array, unsigned int index_count, float crease_angle_degree, unsigned int weight_type)
+{
+	// Local data
+	model_normals_s								normals;
+	model_normals_face_body_s					face_body;
+	model_normals_vertex_body_s					vertex_body;
+	model_normals_write_body_s					write_body;
+	std::vector<model_input_vertex_s>			vertex_list;
+	unsigned int								vertex_count, position_count, offset, corner_count;
+
+
+	vertex_count			= (unsigned int)vertex_list_in_out.size();
+	normals.vertex_array	= vertex_list_in_out.data();
+	normals.index_array		= index_array;
+	normals.triangle_count	= index_count / 7;
+	normals.is_crease		= crease_angle_degree < 180.0f;
+	normals.crease_cos		= (float)cos(std::max(crease_angle_degree, 0.0f) * 3.14159265358979323846 / 180.0);
+	normals.weight_type		= weight_type;
+	if(!vertex_count || !normals.triangle_count)
+	{	return TRUE;
+	}
+
+	// Weld the vertices by position, then list the corners at each position in corner order.
+	try
+	{	normals.first_list.resize(vertex_count);
+		normals.corner_start_list.assign((size_t)vertex_count + 1, 0);
+		normals.corner_list.resize((size_t)normals.triangle_count * 3);
+		normals.face_normal_list.resize((size_t)normals.triangle_count * 4);
+		normals.normal_list.resize((size_t)normals.triangle_count * 9);
+		normals.vertex_list.resize((size_t)normals.triangle_count * 3);
+		normals.vertex_start_list.assign((size_t)vertex_count + 1, 0);
+	}
+	catch(...)
+	{	return FALSE;
+	}
+	if(!model_weld_values(&vertex_list_in_out[0].position.x, sizeof(model_input_vertex_s) / sizeof(float), 3, vertex_count, normals.first_list.data()))
+	{	return FALSE;
+	}
+	for(unsigned int i=0; i<normals.triangle_count; i++)
+	{	for(unsigned int j=0; j<3; j++)
+		{	normals.corner_start_list[normals.first_list[index_array[(size_t)i * 7 + j]]]++;
+		}
+	}
+	offset = 0;
+	for(unsigned int i=0; i<=vertex_count; i++)
+	{	corner_count = normals.corner_start_list[i];
+		normals.corner_start_list[i] = offset;
+		offset += corner_count;
+	}
+	for(unsigned int i=0; i<normals.triangle_count; i++)
+	{	for(unsigned int j=0; j<3; j++)
+		{	normals.corner_list[normals.corner_start_list[normals.first_list[index_array[(size_t)i * 7 + j]]]++] = i * 3 + j;
+		}
+	}
+	memmove(&normals.corner_start_list[1], &normals.corner_start_list[0], (size_t)vertex_count * sizeof(unsigned int));
+	normals.corner_start_list[0] = 0;
+
+	face_body.normals = &normals;
+	parallel_for(normals.triangle_count, MODEL_TS_CHUNK_SIZE, face_body, parallel_progress_s());
+
+	// Number the new vertices of each position, then write them. Positions are in the order of their first vertex.
+	vertex_body.normals = &normals;
+	if(!parallel_for(vertex_count, MODEL_TS_GROUP_CHUNK_SIZE, vertex_body, parallel_progress_s()))
+	{	return FALSE;
+	}
+	position_count = 0;
+	for(unsigned int i=0; i<vertex_count; i++)
+	{	offset = normals.vertex_start_list[i];
+		normals.vertex_start_list[i] = position_count;
+		position_count += offset;
+	}
+	try
+	{	vertex_list.resize(position_count);
+	}
+	catch(...)
+	{	return FALSE;
+	}
+	write_body.normals		= &normals;
+	write_body.vertex_array	= vertex_list.data();
+	parallel_for(vertex_count, MODEL_TS_GROUP_CHUNK_SIZE, write_body, parallel_progress_s());
+
+	vertex_list_in_out.swap(vertex_list);
+	return TRUE;
+}
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Model tangents functions
+
+// Return the vertex of a corner of a good triangle.
+inline unsigned long long model_tangents_get_vertex(const model_tangents_s& tangents, unsigned int good_triangle, unsigned int corner)
+{
+	const unsigned int* index = tangents.index_array + (size_t)tangents.triangle_list[good_triangle] * 7;
+
+	return (unsigned long long)tangents.vertex_first_list[index[corner]] << 32 | tangents.uv_first_list[index[3 + corner]];
+}
+
+// Return the corner of a good triangle at vertex.
+inline unsigned int model_tangents_find_corner(const model_tangents_s& tangents, unsigned int good_triangle, unsigned long long vertex)
+{
+	return model_tangents_get_vertex(tangents, good_triangle, 0) == vertex ? 0 : (model_tangents_get_vertex(tangents, good_triangle, 1) == vertex ? 1 : 2);
+}
+
+// Marks the triangles with two corners at the same position.
+struct model_tangents_degenerate_body_s
+{
+	model_tangents_s*							tangents;
+	unsigned char*								is_degenerate_array;
+
+	BOOL operator()(unsigned int triangle_start, unsigned int triangle_end) const
+	{	for(unsigned int i=triangle_start; i<triangle_end; i++)
+		{	const unsigned int*				index	= tangents->index_array + (size_t)i * 7;
+			const model_input_vector3_s&	a		= tangents->vertex_array[index[0]].position;
+			const model_input_vector3_s&	b		= tangents->vertex_array[index[1]].position;
+			const model_input_vector3_s&	c		= tangents->vertex_array[index[2]].position;
+			is_degenerate_array[i] = (a.x == b.x && a.y == b.y && a.z == b.z) || (a.x == c.x && a.y == c.y && a.z == c.z) || (b.x == c.x && b.y == c.y && b.z == c.z);
+		}
+		return TRUE;
+	}
+};
+
+// Sets the uv tangent, bi-tangent and flags of each good triangle. InitTriInfo() of mikktspace.c.
+struct model_tangents_triangle_body_s
+{
+	model_tangents_s*							tangents;
+
+	BOOL operator()(unsigned int good_start, unsigned int good_end) const
+	{	for(unsigned int f=good_start; f<good_end; f++)
+		{	const unsigned int*				index	= tangents->index_array + (size_t)tangents->triangle_list[f] * 7;
+			const model_input_vector3_s&	v1		= tangents->vertex_array[index[0]].position;
+			const model_input_vector3_s&	v2		= tangents->vertex_array[index[1]].position;
+			const model_input_vector3_s&	v3		= tangents->vertex_array[index[2]].position;
+			const model_input_vector2_s&	t1		= tangents->uv_array[index[3]];
+			const model_input_vector2_s&	t2		= tangents->uv_array[index[4]];
+			const model_input_vector2_s&	t3		= tangents->uv_array[index[5]];
+			float*							os		= &tangents->os_list[(size_t)f * 3];
+			float*							ot		= &tangents->ot_list[(size_t)f * 3];
+			unsigned char&					flag	= tangents->flag_list[f];
+
+			float t21x = t2.x - t1.x, t21y = t2.y - t1.y, t31x = t3.x - t1.x, t31y = t3.y - t1.y;
+			float d1[3] = {v2.x - v1.x, v2.y - v1.y, v2.z - v1.z};
+			float d2[3] = {v3.x - v1.x, v3.y - v1.y, v3.z - v1.z};
+			float signed_area = t21x * t31y - t21y * t31x;
+			float vos[3] = {t31y * d1[0] - t21y * d2[0], t31y * d1[1] - t21y * d2[1], t31y * d1[2] - t21y * d2[2]};
+			float vot[3] = {-t31x * d1[0] + t21x * d2[0], -t31x * d1[1] + t21x * d2[1], -t31x * d1[2] + t21x * d2[2]};
+
+			os[0] = os[1] = os[2] = 0.0f;
+			ot[0] = ot[1] = ot[2] = 0.0f;
+			flag = MODEL_TS_GROUP_WITH_ANY | (signed_area > 0 ? MODEL_TS_ORIENT_PRESERVING : 0);
+			if(model_ts_is_not_zero(signed_area))
+			{	float abs_area		= fabsf(signed_area);
+				float length_os		= sqrtf(model_ts_dot(vos, vos));
+				float length_ot		= sqrtf(model_ts_dot(vot, vot));
+				float sign			= (flag & MODEL_TS_ORIENT_PRESERVING) == 0 ? (-1.0f) : 1.0f;
+				if(model_ts_is_not_zero(length_os))
+				{	float scale = sign / length_os;
+					os[0] = scale * vos[0]; os[1] = scale * vos[1]; os[2] = scale * vos[2];
+				}
+				if(model_ts_is_not_zero(length_ot))
+				{	float scale = sign / length_ot;
+					ot[0] = scale * vot[0]; ot[1] = scale * vot[1]; ot[2] = scale * vot[2];
+				}
+				if(model_ts_is_not_zero(length_os / abs_area) && model_ts_is_not_zero(length_ot / abs_area))
+				{	flag &= ~MODEL_TS_GROUP_WITH_ANY;
+				}
+			}
+		}
+		return TRUE;
+	}
+};
+
+// Pairs the edges at each vertex. Edges are paired with the next unpaired edge the other way in triangle order, as
+// BuildNeighborsFast() of mikktspace.c does. Only edges whose lowest end is at the vertex are paired there, so no two
+// threads write the same entry.
+struct model_tangents_neighbor_body_s
+{
+	model_tangents_s*							tangents;
+
+	BOOL operator()(unsigned int vertex_start, unsigned int vertex_end) const
+	{	try
+		{	std::vector<model_tangents_edge_s> edge_list;
+			for(unsigned int vertex=vertex_start; vertex<vertex_end; vertex++)
+			{	unsigned int start	= tangents->edge_start_list[vertex];
+				unsigned int end	= tangents->edge_start_list[vertex + 1];
+				if(end - start < 2)
+				{	continue;
+				}
+				edge_list.resize(end - start);
+				for(unsigned int i=start; i<end; i++)
+				{	model_tangents_edge_s&	edge	= edge_list[i - start];
+					unsigned int			f		= tangents->edge_list[i] / 3;
+					unsigned int			e		= tangents->edge_list[i] % 3;
+					unsigned long long		a		= model_tangents_get_vertex(*tangents, f, e);
+					unsigned long long		b		= model_tangents_get_vertex(*tangents, f, e < 2 ? e + 1 : 0);
+					edge.low	= std::min(a, b);
+					edge.high	= std::max(a, b);
+					edge.edge	= tangents->edge_list[i];
+				}
+				std::sort(edge_list.begin(), edge_list.end());
+
+				for(size_t i=0; i<edge_list.size(); i++)
+				{	unsigned int f = edge_list[i].edge / 3, e = edge_list[i].edge % 3;
+					if(tangents->neighbor_list[edge_list[i].edge] != MODEL_TS_NONE)
+					{	continue;
+					}
+					unsigned long long a_0 = model_tangents_get_vertex(*tangents, f, e);
+					unsigned long long a_1 = model_tangents_get_vertex(*tangents, f, e < 2 ? e + 1 : 0);
+					for(size_t j=i+1; j<edge_list.size() && edge_list[j].low == edge_list[i].low && edge_list[j].high == edge_list[i].high; j++)
+					{	unsigned int t = edge_list[j].edge / 3, g = edge_list[j].edge % 3;
+						if(tangents->neighbor_list[edge_list[j].edge] == MODEL_TS_NONE &&
+						   model_tangents_get_vertex(*tangents, t, g) == a_1 && model_tangents_get_vertex(*tangents, t, g < 2 ? g + 1 : 0) == a_0)
+						{	tangents->neighbor_list[edge_list[i].edge] = t;
+							tangents->neighbor_list[edge_list[j].edge] = f;
+							break;
+						}
+					}
+				}
+			}
+		}
+		catch(...)
+		{	return FALSE;
+		}
+		return TRUE;
+	}
+};
+
+// Join the good triangles that share an edge at each vertex and have the same uv orientation into groups.
+// Build4RuleGroups() and AssignRecur() of mikktspace.c, with a stack in place of recursion. Throws std::bad_alloc.
+void model_tangents_build_groups(model_tangents_s& tangents)
+{
+	// Local data
+	std::vector<unsigned int>					stack_list;
+	unsigned long long							vertex;
+	unsigned int								group, t, i;
+	bool										is_orient;
+
+
+	tangents.group_list.assign((size_t)tangents.good_count * 3, MODEL_TS_NONE);
+	tangents.member_list.reserve((size_t)tangents.good_count * 3);
+	tangents.group_start_list.push_back(0);
+	for(unsigned int f=0; f<tangents.good_count; f++)
+	{	for(unsigned int c=0; c<3; c++)
+		{	if((tangents.flag_list[f] & MODEL_TS_GROUP_WITH_ANY) || tangents.group_list[(size_t)f * 3 + c] != MODEL_TS_NONE)
+			{	continue;
+			}
+
+			// Start a group at the corner and walk to its neighbors on both edges at the vertex, left side first.
+			group		= (unsigned int)tangents.group_vertex_list.size();
+			vertex		= model_tangents_get_vertex(tangents, f, c);
+			is_orient	= (tangents.flag_list[f] & MODEL_TS_ORIENT_PRESERVING) != 0;
+			tangents.group_vertex_list.push_back(vertex);
+			tangents.group_orient_list.push_back(is_orient);
+			tangents.group_list[(size_t)f * 3 + c] = group;
+			tangents.member_list.push_back(f);
+			stack_list.push_back(tangents.neighbor_list[(size_t)f * 3 + (c > 0 ? c - 1 : 2)]);
+			stack_list.push_back(tangents.neighbor_list[(size_t)f * 3 + c]);
+
+			while(!stack_list.empty())
+			{	t = stack_list.back();
+				stack_list.pop_back();
+				if(t == MODEL_TS_NONE)
+				{	continue;
+				}
+				i = model_tangents_find_corner(tangents, t, vertex);
+				if(tangents.group_list[(size_t)t * 3 + i] != MODEL_TS_NONE)
+				{	continue;
+				}
+
+				// The first group to reach a triangle with no uv area sets its orientation.
+				unsigned char& flag = tangents.flag_list[t];
+				if((flag & MODEL_TS_GROUP_WITH_ANY) && tangents.group_list[(size_t)t * 3] == MODEL_TS_NONE &&
+				   tangents.group_list[(size_t)t * 3 + 1] == MODEL_TS_NONE && tangents.group_list[(size_t)t * 3 + 2] == MODEL_TS_NONE)
+				{	flag = (unsigned char)((flag & ~MODEL_TS_ORIENT_PRESERVING) | (is_orient ? MODEL_TS_ORIENT_PRESERVING : 0));
+				}
+				if(((flag & MODEL_TS_ORIENT_PRESERVING) != 0) != is_orient)
+				{	continue;
+				}
+
+				tangents.group_list[(size_t)t * 3 + i] = group;
+				tangents.member_list.push_back(t);
+				stack_list.push_back(tangents.neighbor_list[(size_t)t * 3 + (i > 0 ? i - 1 : 2)]);
+				stack_list.push_back(tangents.neighbor_list[(size_t)t * 3 + i]);
+			}
+			tangents.group_start_list.push_back((unsigned int)tangents.member_list.size());
+		}
+	}
+}
+
+// Orders members of a group by triangle.
+struct model_tangents_member_less_s
+{
+	const unsigned int*							member_array;
+
+	model_tangents_member_less_s(const unsigned int* member_array_in) : member_array(member_array_in) {}
+
+	bool operator()(unsigned int a, unsigned int b) const
+	{	return member_array[a] < member_array[b];
+	}
+};
+
+// Tests if a member of a group is a triangle.
+struct model_tangents_member_equal_s
+{
+	const unsigned int*							member_array;
+
+	model_tangents_member_equal_s(const unsigned int* member_array_in) : member_array(member_array_in) {}
+
+	bool operator()(unsigned int member, unsigned int triangle) const
+	{	return member_array[member] == triangle;
+	}
+};
+
+// Sets the tangent of each corner of each group. Triangles whose uv tangents are within the threshold of a triangle
+// share a tangent, the angle weighted average of theirs. GenerateTSpaces() and EvalTspace() of mikktspace.c.
+struct model_tangents_space_body_s
+{
+	model_tangents_s*							tangents;
+
+	BOOL operator()(unsigned int group_start, unsigned int group_end) const
+	{	try
+		{	std::vector<float>					project_list;					// 6 per member, its uv tangent and bi-tangent at the vertex.
+			std::vector<unsigned int>			subgroup_list;					// Members of each subgroup, sorted.
+			std::vector<unsigned int>			subgroup_start_list;
+			std::vector<float>					subgroup_tangent_list;
+			std::vector<unsigned int>			candidate_list;					// Members within the threshold, by triangle.
+
+			for(unsigned int group=group_start; group<group_end; group++)
+			{	const unsigned int*				member_array	= tangents->member_list.data() + tangents->group_start_list[group];
+				unsigned int					member_count	= tangents->group_start_list[group + 1] - tangents->group_start_list[group];
+				unsigned long long				vertex			= tangents->group_vertex_list[group];
+				const model_input_vector3_s&	normal			= tangents->vertex_array[(unsigned int)(vertex >> 32)].normal;
+				float							n[3]			= {normal.x, normal.y, normal.z};
+
+				project_list.resize((size_t)member_count * 6);
+				for(unsigned int i=0; i<member_count; i++)
+				{	model_ts_project(&tangents->os_list[(size_t)member_array[i] * 3], n, &project_list[(size_t)i * 6]);
+					model_ts_project(&tangents->ot_list[(size_t)member_array[i] * 3], n, &project_list[(size_t)i * 6 + 3]);
+				}
+				subgroup_list.clear();
+				subgroup_start_list.assign(1, 0);
+				subgroup_tangent_list.clear();
+
+				for(unsigned int i=0; i<member_count; i++)
+				{	unsigned int f = member_array[i];
+
+					// The members within the threshold of this one, sorted.
+					candidate_list.clear();
+					for(unsigned int j=0; j<member_count; j++)
+					{	unsigned int t = member_array[j];
+						if(((tangents->flag_list[f] | tangents->flag_list[t]) & MODEL_TS_GROUP_WITH_ANY) || f == t ||
+						   (model_ts_dot(&project_list[(size_t)i * 6], &project_list[(size_t)j * 6]) > MODEL_TS_THRESHOLD_COS &&
+							model_ts_dot(&project_list[(size_t)i * 6 + 3], &project_list[(size_t)j * 6 + 3]) > MODEL_TS_THRESHOLD_COS))
+						{	candidate_list.push_back(j);
+						}
+					}
+					std::sort(candidate_list.begin(), candidate_list.end(), model_tangents_member_less_s(member_array));
+
+					// Use the tangent of the same subgroup if it was made, or make it.
+					size_t subgroup = 0;
+					for(; subgroup<subgroup_start_list.size()-1; subgroup++)
+					{	if(subgroup_start_list[subgroup + 1] - subgroup_start_list[subgroup] == candidate_list.size() &&
+						   std::equal(candidate_list.begin(), candidate_list.end(), subgroup_list.begin() + subgroup_start_list[subgroup], model_tangents_member_equal_s(member_array)))
+						{	break;
+						}
+					}
+					if(subgroup == subgroup_start_list.size() - 1)
+					{	float tangent[3] = {0.0f, 0.0f, 0.0f};
+						for(size_t j=0; j<candidate_list.size(); j++)
+						{	unsigned int t = member_array[candidate_list[j]];
+							if(tangents->flag_list[t] & MODEL_TS_GROUP_WITH_ANY)
+							{	continue;
+							}
+
+							// Weight by the angle of the triangle at the vertex in the plane of the normal.
+							unsigned int					c		= tangents->group_list[(size_t)t * 3] == group ? 0 : (tangents->group_list[(size_t)t * 3 + 1] == group ? 1 : 2);
+							const unsigned int*				index	= tangents->index_array + (size_t)tangents->triangle_list[t] * 7;
+							const model_input_vector3_s&	p0		= tangents->vertex_array[index[c > 0 ? c - 1 : 2]].position;
+							const model_input_vector3_s&	p1		= tangents->vertex_array[index[c]].position;
+							const model_input_vector3_s&	p2		= tangents->vertex_array[index[c < 2 ? c + 1 : 0]].position;
+							const float*					os		= &project_list[(size_t)candidate_list[j] * 6];
+							float							v1[3], v2[3];
+							float							e1[3]	= {p0.x - p1.x, p0.y - p1.y, p0.z - p1.z};
+							float							e2[3]	= {p2.x - p1.x, p2.y - p1.y, p2.z - p1.z};
+							model_ts_project(e1, n, v1);
+							model_ts_project(e2, n, v2);
+							float cosine	= model_ts_dot(v1, v2);
+							cosine			= cosine > 1 ? 1 : (cosine < (-1) ? (-1) : cosine);
+							float angle		= (float)acos(cosine);
+							tangent[0] = tangent[0] + angle * os[0];
+							tangent[1] = tangent[1] + angle * os[1];
+							tangent[2] = tangent[2] + angle * os[2];
+						}
+						if(model_ts_is_not_zero(tangent))
+						{	model_ts_normalize(tangent);
+						}
+						for(size_t j=0; j<candidate_list.size(); j++)
+						{	subgroup_list.push_back(member_array[candidate_list[j]]);
+						}
+						subgroup_start_list.push_back((unsigned int)subgroup_list.size());
+						subgroup_tangent_list.insert(subgroup_tangent_list.end(), tangent, tangent + 3);
+					}
+
+					// Each corner is in one group so no other thread writes its tangent.
+					unsigned int c = tangents->group_list[(size_t)f * 3] == group ? 0 : (tangents->group_list[(size_t)f * 3 + 1] == group ? 1 : 2);
+					model_input_tangent_s& tangent_out = tangents->tangent_array[(size_t)tangents->triangle_list[f] * 3 + c];
+					tangent_out.tangent.x	= subgroup_tangent_list[subgroup * 3];
+					tangent_out.tangent.y	= subgroup_tangent_list[subgroup * 3 + 1];
+					tangent_out.tangent.z	= subgroup_tangent_list[subgroup * 3 + 2];
+					tangent_out.w			= tangents->group_orient_list[group] ? 1.0f : (-1.0f);
+				}
+			}
+		}
+		catch(...)
+		{	return FALSE;
+		}
+		return TRUE;
+	}
+};
+
+// Give each corner of a degenerate triangle the tangent of the first corner of a good triangle at its vertex.
+// DegenEpilogue() of mikktspace.c. Throws std::bad_alloc.
+void model_tangents_copy_degenerate(model_tangents_s& tangents)
+{
+	// Local data
+	std::vector<unsigned long long>				vertex_table;
+	std::vector<unsigned int>					source_table;				// The first good corner at each vertex of vertex_table.
+	size_t										mask, slot;
+	unsigned long long							vertex;
+
+
+	// A table of the vertices of the degenerate triangles.
+	mask = 1023;
+	while(mask < (size_t)(tangents.triangle_count - tangents.good_count) * 6)
+	{	mask = mask * 2 + 1;
+	}
+	vertex_table.assign(mask + 1, ULLONG_MAX);
+	source_table.assign(mask + 1, MODEL_TS_NONE);
+	for(unsigned int f=tangents.good_count; f<tangents.triangle_count; f++)
+	{	for(unsigned int c=0; c<3; c++)
+		{	vertex = model_tangents_get_vertex(tangents, f, c);
+			for(slot=(size_t)(vertex * 0x9E3779B97F4A7C15ull >> 32)&mask; vertex_table[slot]!=ULLONG_MAX && vertex_table[slot]!=vertex; slot=(slot + 1) & mask);
+			vertex_table[slot] = vertex;
+		}
+	}
+
+	for(unsigned int f=0; f<tangents.good_count; f++)
+	{	for(unsigned int c=0; c<3; c++)
+		{	vertex = model_tangents_get_vertex(tangents, f, c);
+			for(slot=(size_t)(vertex * 0x9E3779B97F4A7C15ull >> 32)&mask; vertex_table[slot]!=ULLONG_MAX && vertex_table[slot]!=vertex; slot=(slot + 1) & mask);
+			if(vertex_table[slot] == vertex && source_table[slot] == MODEL_TS_NONE)
+			{	source_table[slot] = tangents.triangle_list[f] * 3 + c;
+			}
+		}
+	}
+
+	for(unsigned int f=tangents.good_count; f<tangents.triangle_count; f++)
+	{	for(unsigned int c=0; c<3; c++)
+		{	vertex = model_tangents_get_vertex(tangents, f, c);
+			for(slot=(size_t)(vertex * 0x9E3779B97F4A7C15ull >> 32)&mask; vertex_table[slot]!=vertex; slot=(slot + 1) & mask);
+			if(source_table[slot] != MODEL_TS_NONE)
+			{	tangents.tangent_array[(size_t)tangents.triangle_list[f] * 3 + c] = tangents.tangent_array[source_table[slot]];
+			}
+		}
+	}
+}
+
+// Set the 3 tangents of each triangle in tangent_array_out by the steps of genTangSpaceDefault() of mikktspace.c. A corner
+// that is in no group, such as one of a triangle with no uv area and no neighbors, has the tangent 1, 0, 0 and w -1.0.
+// Runs on all cores. Returns FALSE if out of memory.
+BOOL model_create_tangents(const model_input_vertex_s* vertex_array, unsigned int vertex_count, const model_input_vector2_s* uv_array, unsigned int uv_count,
+						   const unsigned int* index_array, unsigned int index_count, model_input_tangent_s* tangent_array_out)
+{
+	// Local data
+	model_tangents_s							tangents;
+	model_tangents_degenerate_body_s			degenerate_body;
+	model_tangents_triangle_body_s				triangle_body;
+	model_tangents_neighbor_body_s				neighbor_body;
+	model_tangents_space_body_s					space_body;
+	std::vector<unsigned char>					is_degenerate_list;
+	unsigned int								good_index, bad_index, offset, edge_count;
+
+
+	tangents.vertex_array	= vertex_array;
+	tangents.uv_array		= uv_array;
+	tangents.index_array	= index_array;
+	tangents.tangent_array	= tangent_array_out;
+	tangents.triangle_count	= index_count / 7;
+	for(size_t i=0; i<(size_t)tangents.triangle_count * 3; i++)
+	{	tangent_array_out[i].tangent.x	= 1.0f;
+		tangent_array_out[i].tangent.y	= 0.0f;
+		tangent_array_out[i].tangent.z	= 0.0f;
+		tangent_array_out[i].w			= -1.0f;
+	}
+	if(!tangents.triangle_count)
+	{	return TRUE;
+	}
+
+	try
+	{	// Corners with the same position, normal and uv are the same vertex.
+		tangents.vertex_first_list.resize(vertex_count);
+		tangents.uv_first_list.resize(uv_count);
+		if(!model_weld_values(&vertex_array[0].position.x, sizeof(model_input_vertex_s) / sizeof(float), 6, vertex_count, tangents.vertex_first_list.data()) ||
+		   !model_weld_values(&uv_array[0].x, sizeof(model_input_vector2_s) / sizeof(float), 2, uv_count, tangents.uv_first_list.data()))
+		{	return FALSE;
+		}
+
+		// Good triangles in order, then the degenerate ones.
+		is_degenerate_list.resize(tangents.triangle_count);
+		degenerate_body.tangents			= &tangents;
+		degenerate_body.is_degenerate_array	= is_degenerate_list.data();
+		parallel_for(tangents.triangle_count, MODEL_TS_CHUNK_SIZE, degenerate_body, parallel_progress_s());
+		tangents.good_count = 0;
+		for(unsigned int i=0; i<tangents.triangle_count; i++)
+		{	tangents.good_count += !is_degenerate_list[i];
+		}
+		tangents.triangle_list.resize(tangents.triangle_count);
+		good_index	= 0;
+		bad_index	= tangents.good_count;
+		for(unsigned int i=0; i<tangents.triangle_count; i++)
+		{	tangents.triangle_list[is_degenerate_list[i] ? bad_index++ : good_index++] = i;
+		}
+		std::vector<unsigned char>().swap(is_degenerate_list);
+
+		tangents.os_list.resize((size_t)tangents.good_count * 3);
+		tangents.ot_list.resize((size_t)tangents.good_count * 3);
+		tangents.flag_list.resize(tangents.good_count);
+		triangle_body.tangents = &tangents;
+		parallel_for(tangents.good_count, MODEL_TS_CHUNK_SIZE, triangle_body, parallel_progress_s());
+
+		// List the edges by the position and normal of their lowest end, in triangle order, and pair them.
+		edge_count = tangents.good_count * 3;
+		tangents.edge_start_list.assign((size_t)vertex_count + 1, 0);
+		tangents.edge_list.resize(edge_count);
+		tangents.neighbor_list.assign(edge_count, MODEL_TS_NONE);
+		for(unsigned int i=0; i<edge_count; i++)
+		{	tangents.edge_start_list[(unsigned int)(std::min(model_tangents_get_vertex(tangents, i / 3, i % 3), model_tangents_get_vertex(tangents, i / 3, (i + 1) % 3)) >> 32)]++;
+		}
+		offset = 0;
+		for(unsigned int i=0; i<=vertex_count; i++)
+		{	unsigned int count = tangents.edge_start_list[i];
+			tangents.edge_start_list[i] = offset;
+			offset += count;
+		}
+		for(unsigned int i=0; i<edge_count; i++)
+		{	tangents.edge_list[tangents.edge_start_list[(unsigned int)(std::min(model_tangents_get_vertex(tangents, i / 3, i % 3), model_tangents_get_vertex(tangents, i / 3, (i + 1) % 3)) >> 32)]++] = i;
+		}
+		memmove(&tangents.edge_start_list[1], &tangents.edge_start_list[0], (size_t)vertex_count * sizeof(unsigned int));
+		tangents.edge_start_list[0] = 0;
+		neighbor_body.tangents = &tangents;
+		if(!parallel_for(vertex_count, MODEL_TS_GROUP_CHUNK_SIZE, neighbor_body, parallel_progress_s()))
+		{	return FALSE;
+		}
+		std::vector<unsigned int>().swap(tangents.edge_start_list);
+		std::vector<unsigned int>().swap(tangents.edge_list);
+
+		model_tangents_build_groups(tangents);
+		std::vector<unsigned int>().swap(tangents.neighbor_list);
+
+		space_body.tangents = &tangents;
+		if(!parallel_for((unsigned int)tangents.group_vertex_list.size(), MODEL_TS_GROUP_CHUNK_SIZE, space_body, parallel_progress_s()))
+		{	return FALSE;
+		}
+
+		if(tangents.good_count < tangents.triangle_count)
+		{	model_tangents_copy_degenerate(tangents);
+		}
+	}
+	catch(...)
+	{	return FALSE;
+	}
+	return TRUE;
+}
+
+#endif // MAP_MODEL_TANGENT_SPACE_CPP
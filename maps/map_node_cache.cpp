@@ -0,0 +1,434 @@
+/*
+	===============================================================
+
+	SHADERMAP MAP NODE CACHE SOURCE FILE
+
+	Keeps data derived from a node, such as a resized mask, an
+	image pyramid or a BVH of a model, so the next process of the
+	map can use it instead of building it again.
+
+	The node cache functions of the map plugin core only store a
+	pointer. mp_register_node_cache() does not copy the data and
+	the plugin must free it when ShaderMap calls
+	on_node_cache_clear() or on_node_cache_clear_single(), and
+	renumber it when ShaderMap calls on_input_id_change(). This
+	file owns the data, counts its bytes and does all of that.
+
+	Entries are found by node id and name. An entry is local or
+	shared. A local entry is only seen by this plugin and is
+	released, least recently used first, when the cache is larger
+	than its byte limit (see node_cache_set_byte_limit()). A shared
+	entry is also registered with mp_register_node_cache() so other
+	plugins can get it with mp_get_node_cache(). There is no way to
+	unregister data, so a shared entry counts toward the limit but
+	is only released when ShaderMap clears it.
+
+	Include this source code file in a map plugin after the plugin
+	core file. #include "../../map_node_cache.cpp"
+
+	--
+
+	Example:
+
+	pyramid = (const pyramid_s*)node_cache_get(input_id, _T("example_pyramid"));
+	if(!pyramid)
+	{	pyramid_s* new_pyramid = new pyramid_s;
+		... build it ...
+		pyramid = (const pyramid_s*)node_cache_add_object(input_id, CACHE_TYPE_MAP, _T("example_pyramid"),
+														  new_pyramid, new_pyramid->get_byte_count(), FALSE);
+	}
+	... use pyramid ...
+	node_cache_release(pyramid);
+
+	The data returned stays valid until it is released. Each get
+	and add must be matched by a release. Maps can be processed on
+	several threads at once, the cache is locked while it is
+	searched. An entry cleared while in use is released by its
+	last node_cache_release().
+
+	Call the node cache functions from the plugin callbacks:
+
+	void on_input_id_change(unsigned int above_input_id)
+	{	node_cache_on_input_id_change(above_input_id);
+	}
+
+	void on_node_cache_clear(unsigned int input_id, unsigned int type)
+	{	node_cache_on_clear(input_id, type);
+	}
+
+	void on_node_cache_clear_single(const void* data_pointer)
+	{	node_cache_on_clear_single(data_pointer);
+	}
+
+	Call node_cache_clear() from on_shutdown().
+
+
+	SHADERMAP SDK LICENSE
+
+	The ShaderMap SDK is released under The MIT License (MIT)
+	http://opensource.org/licenses/MIT
+
+	Copyright (c) 2007-2019 Rendering Systems Inc.
+
+	Permission is hereby granted, free of charge, to any person
+	obtaining a copy of this software and associated documentation
+	files (the "Software"), to deal	in the Software without
+	restriction, including without limitation the rights to use,
+	copy, modify, merge, publish, distribute, sublicense, and/or
+	sell copies of the Software, and to permit persons to whom the
+	Software is	furnished to do so, subject to the following
+	conditions:
+
+	The above copyright notice and this permission notice shall be
+	included in	all copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+	OF MERCHANTABILITY,	FITNESS FOR A PARTICULAR PURPOSE AND
+	NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+	OTHER DEALINGS IN THE SOFTWARE.
+
+	Developed by: Neil Kemp at Rendering Systems Inc.
+
+	Online:		http://shadermap.com
+	Corporate:	http://renderingsystems.com
+
+	===============================================================
+*/
+
+#ifndef MAP_NODE_CACHE_CPP
+#define MAP_NODE_CACHE_CPP
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Node cache includes
+
+#include <mutex>
+#include <new>
+#include <string>
+#include <vector>
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Node cache defines
+
+// Default byte limit of the cache. Local entries not in use are released, least recently used first, above it.
+#ifndef MAP_NODE_CACHE_BYTE_LIMIT
+#define MAP_NODE_CACHE_BYTE_LIMIT				(512ull * 1024 * 1024)
+#endif
+
+// Node id of shared entries whose node was removed. They wait for ShaderMap to clear them.
+#define NODE_CACHE_REMOVED_ID					0xFFFFFFFF
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Node cache structs
+
+// Frees the data of an entry.
+typedef void									(*node_cache_release_function_type)(void* /*data_pointer*/);
+
+// A cached entry.
+struct node_cache_entry_s
+{
+	unsigned int								node_id;
+	unsigned int								cache_type;					// CACHE_TYPE_MAP, _MODEL or _CAGE.
+	std::wstring								cache_name;
+	void*										data_pointer;
+	unsigned long long							data_size;
+	node_cache_release_function_type			release_function;
+	BOOL										is_shared;					// Registered with mp_register_node_cache().
+	unsigned int								use_count;					// Gets and adds not released yet.
+	unsigned long long							last_use;
+};
+
+static std::vector<node_cache_entry_s*>			node_cache_list;
+static std::vector<node_cache_entry_s*>			node_cache_dropped_list;	// Out of the cache and still in use.
+static std::recursive_mutex						node_cache_mutex;			// ShaderMap can call the clear callbacks from mp_register_node_cache().
+static unsigned long long						node_cache_use_clock = 0;
+static unsigned long long						node_cache_byte_limit = MAP_NODE_CACHE_BYTE_LIMIT;
+
+
+// ----------------------------------------------------------------
+// ----------------------------------------------------------------
+// Node cache functions
+
+// Delete an object added with node_cache_add_object().
+template<class T>
+void node_cache_delete_object(void* data_pointer)
+{
+	delete (T*)data_pointer;
+}
+
+// Free the data of an entry and delete it.
+void node_cache_delete_entry(node_cache_entry_s* entry)
+{
+	if(entry->release_function)
+	{	entry->release_function(entry->data_pointer);
+	}
+	delete entry;
+}
+
+// Take an entry out of the cache. It is deleted now or by its last release. Called with the cache locked.
+void node_cache_drop(size_t index)
+{
+	node_cache_entry_s* entry = node_cache_list[index];
+
+	node_cache_list.erase(node_cache_list.begin() + index);
+	if(entry->use_count)
+	{	node_cache_dropped_list.push_back(entry);
+	}
+	else
+	{	node_cache_delete_entry(entry);
+	}
+}
+
+// Release local entries not in use, least recently used first, until the cache is under its byte limit. Called with the cache locked.
+void node_cache_trim(void)
+{
+	// Local data
+	unsigned long long							byte_count = 0;
+
+
+	for(size_t i=0; i<node_cache_list.size(); i++)
+	{	byte_count += node_cache_list[i]->data_size;
+	}
+	while(byte_count > node_cache_byte_limit)
+	{	size_t oldest = node_cache_list.size();
+		for(size_t i=0; i<node_cache_list.size(); i++)
+		{	if(!node_cache_list[i]->use_count && !node_cache_list[i]->is_shared &&
+			   (oldest == node_cache_list.size() || node_cache_list[i]->last_use < node_cache_list[oldest]->last_use))
+			{	oldest = i;
+			}
+		}
+		if(oldest == node_cache_list.size())
+		{	return;
+		}
+		byte_count -= node_cache_list[oldest]->data_size;
+		node_cache_drop(oldest);
+	}
+}
+
+// Set the byte limit of the cache. Local entries not in use are released until the cache is under it.
+void node_cache_set_byte_limit(unsigned long long byte_limit)
+{
+	std::lock_guard<std::recursive_mutex> lock(node_cache_mutex);
+
+	node_cache_byte_limit = byte_limit;
+	node_cache_trim();
+}
+
+// Return the bytes of data in the cache.
+unsigned long long node_cache_get_byte_count(void)
+{
+	std::lock_guard<std::recursive_mutex>	lock(node_cache_mutex);
+	unsigned long long			byte_count = 0;
+
+	for(size_t i=0; i<node_cache_list.size(); i++)
+	{	byte_count += node_cache_list[i]->data_size;
+	}
+	return byte_count;
+}
+
+// Return the data cached for node_id as cache_name, or 0 if not cached. Release it with node_cache_release().
+const void* node_cache_get(unsigned int node_id, const wchar_t* cache_name)
+{
+	std::lock_guard<std::recursive_mutex> lock(node_cache_mutex);
+
+	if(!cache_name)
+	{	return 0;
+	}
+	for(size_t i=0; i<node_cache_list.size(); i++)
+	{	node_cache_entry_s* entry = node_cache_list[i];
+		if(entry->node_id == node_id && entry->cache_name == cache_name)
+		{	entry->use_count++;
+			entry->last_use = ++node_cache_use_clock;
+			return entry->data_pointer;
+		}
+	}
+	return 0;
+}
+
+// Add data_pointer to the cache for node_id as cache_name. The cache owns the data and frees it with release_function.
+// data_size is in bytes. If is_shared the data is also registered with mp_register_node_cache() for other plugins.
+// Returns the data to use, which is the data already cached if another thread added cache_name first. Release it with
+// node_cache_release(). If the data can not be cached it is still returned and is freed by the release.
+// Returns 0 and frees the data if out of memory.
+const void* node_cache_add(unsigned int node_id, unsigned int cache_type, const wchar_t* cache_name, void* data_pointer,
+						   unsigned long long data_size, node_cache_release_function_type release_function, BOOL is_shared)
+{
+	// Local data
+	node_cache_entry_s*							entry;
+	BOOL										is_cache_enabled;
+
+
+	if(!data_pointer)
+	{	return 0;
+	}
+	entry = new (std::nothrow) node_cache_entry_s;
+	if(!entry)
+	{	if(release_function)
+		{	release_function(data_pointer);
+		}
+		return 0;
+	}
+	entry->node_id			= node_id;
+	entry->cache_type		= cache_type;
+	entry->data_pointer		= data_pointer;
+	entry->data_size		= data_size;
+	entry->release_function	= release_function;
+	entry->is_shared		= FALSE;
+	entry->use_count		= 1;
+	entry->last_use			= 0;
+
+	is_cache_enabled = !mp_is_cache_enabled || mp_is_cache_enabled();
+
+	std::lock_guard<std::recursive_mutex> lock(node_cache_mutex);
+
+	// Allocate up front so the entry can always be put in a list.
+	try
+	{	entry->cache_name = cache_name ? cache_name : L"";
+		node_cache_list.reserve(node_cache_list.size() + 1);
+		node_cache_dropped_list.reserve(node_cache_dropped_list.size() + 1);
+	}
+	catch(...)
+	{	node_cache_delete_entry(entry);
+		return 0;
+	}
+
+	if(!cache_name || !is_cache_enabled || cache_type > CACHE_TYPE_CAGE)
+	{	node_cache_dropped_list.push_back(entry);
+		return entry->data_pointer;
+	}
+
+	// Use the data another thread cached first.
+	for(size_t i=0; i<node_cache_list.size(); i++)
+	{	if(node_cache_list[i]->node_id == node_id && node_cache_list[i]->cache_name == cache_name)
+		{	node_cache_delete_entry(entry);
+			entry = node_cache_list[i];
+			entry->use_count++;
+			entry->last_use = ++node_cache_use_clock;
+			return entry->data_pointer;
+		}
+	}
+
+	// Kept local if ShaderMap does not take it, for example when another plugin registered the same name.
+	if(is_shared && mp_register_node_cache)
+	{	entry->is_shared = mp_register_node_cache(node_id, cache_type, cache_name, data_pointer, data_size);
+	}
+	node_cache_list.push_back(entry);
+	entry->last_use = ++node_cache_use_clock;
+	node_cache_trim();
+	return entry->data_pointer;
+}
+
+// Add an object allocated with new to the cache. See node_cache_add().
+template<class T>
+const T* node_cache_add_object(unsigned int node_id, unsigned int cache_type, const wchar_t* cache_name, T* object,
+							   unsigned long long data_size, BOOL is_shared)
+{
+	return (const T*)node_cache_add(node_id, cache_type, cache_name, object, data_size, node_cache_delete_object<T>, is_shared);
+}
+
+// Release data returned by node_cache_get() or node_cache_add(). It stays in the cache unless it was cleared.
+void node_cache_release(const void* data_pointer)
+{
+	std::lock_guard<std::recursive_mutex> lock(node_cache_mutex);
+
+	if(!data_pointer)
+	{	return;
+	}
+	for(size_t i=0; i<node_cache_list.size(); i++)
+	{	if(node_cache_list[i]->data_pointer == data_pointer && node_cache_list[i]->use_count)
+		{	node_cache_list[i]->use_count--;
+			node_cache_trim();
+			return;
+		}
+	}
+	for(size_t i=0; i<node_cache_dropped_list.size(); i++)
+	{	if(node_cache_dropped_list[i]->data_pointer == data_pointer)
+		{	if(!--node_cache_dropped_list[i]->use_count)
+			{	node_cache_delete_entry(node_cache_dropped_list[i]);
+				node_cache_dropped_list.erase(node_cache_dropped_list.begin() + i);
+			}
+			return;
+		}
+	}
+}
+
+// Release the entries of node_id with cache_type, or every type if CACHE_TYPE_ANY. Call from on_node_cache_clear().
+void node_cache_on_clear(unsigned int node_id, unsigned int cache_type)
+{
+	std::lock_guard<std::recursive_mutex> lock(node_cache_mutex);
+
+	for(size_t i=0; i<node_cache_list.size(); )
+	{	if(node_cache_list[i]->node_id == node_id && (cache_type == CACHE_TYPE_ANY || node_cache_list[i]->cache_type == cache_type))
+		{	node_cache_drop(i);
+			continue;
+		}
+		i++;
+	}
+}
+
+// Release the shared entry ShaderMap is deleting. Call from on_node_cache_clear_single().
+void node_cache_on_clear_single(const void* data_pointer)
+{
+	std::lock_guard<std::recursive_mutex> lock(node_cache_mutex);
+
+	for(size_t i=0; i<node_cache_list.size(); i++)
+	{	if(node_cache_list[i]->data_pointer == data_pointer)
+		{	node_cache_drop(i);
+			return;
+		}
+	}
+}
+
+// Renumber the entries after a node was removed. Entries of node ids above above_input_id move down by one and local
+// entries of above_input_id itself are released. ShaderMap still holds the shared entries of above_input_id, so they
+// are kept under NODE_CACHE_REMOVED_ID, where no get finds them, until ShaderMap clears them. Call from on_input_id_change().
+void node_cache_on_input_id_change(unsigned int above_input_id)
+{
+	std::lock_guard<std::recursive_mutex> lock(node_cache_mutex);
+
+	for(size_t i=0; i<node_cache_list.size(); )
+	{	if(node_cache_list[i]->node_id == above_input_id)
+		{	if(node_cache_list[i]->is_shared)
+			{	node_cache_list[i]->node_id = NODE_CACHE_REMOVED_ID;
+				i++;
+				continue;
+			}
+			node_cache_drop(i);
+			continue;
+		}
+		if(node_cache_list[i]->node_id == NODE_CACHE_REMOVED_ID)
+		{	i++;
+			continue;
+		}
+		if(node_cache_list[i]->node_id > above_input_id)
+		{	node_cache_list[i]->node_id--;
+		}
+		i++;
+	}
+}
+
+// Release every entry. Call from on_shutdown() with no map processing.
+void node_cache_clear(void)
+{
+	std::lock_guard<std::recursive_mutex> lock(node_cache_mutex);
+
+	for(size_t i=0; i<node_cache_list.size(); i++)
+	{	node_cache_delete_entry(node_cache_list[i]);
+	}
+	node_cache_list.clear();
+	for(size_t i=0; i<node_cache_dropped_list.size(); i++)
+	{	node_cache_delete_entry(node_cache_dropped_list[i]);
+	}
+	node_cache_dropped_list.clear();
+}
+
+#endif // MAP_NODE_CACHE_CPP
@@ -177,6 +177,16 @@ High Dynamic Range				.hdr							RGB_32F
 // Example: LOG_ERROR_MSG(map_id, filter_position, _T("Error description");
 #define											LOG_ERROR_MSG(map_id, error) mp_log_map_error(map_id, error, _T(__FUNCTION__), _T(__FILE__), __LINE__);
 
+// Function pointers set by "plugin_initialize()". A host that includes this file with SMSDK_HOST defined never sets or
+// calls them, so they are marked unused there to keep the host build free of warnings.
+#ifndef SMSDK_POINTER
+#if defined(SMSDK_HOST) && defined(__GNUC__)
+#define SMSDK_POINTER							static __attribute__((unused))
+#else
+#define SMSDK_POINTER							static
+#endif
+#endif
+
 
 // ------------------------------------------------------------------
 // ------------------------------------------------------------------
@@ -199,7 +209,7 @@ struct map_plugin_info_s
 	BOOL										is_using_input_filter;		// If TRUE then the input filter will be displayed in the map properties, it is expected that the plugin will get the values and apply them.
 
 	// c()
-	map_plugin_info_s::map_plugin_info_s(void)
+	map_plugin_info_s(void)
 	{
 		version									= 0;
 		is_legacy								= FALSE;
@@ -225,12 +235,12 @@ struct map_input_filter_data_s
 	float									saturation;						// Range -100 to 100
 
 	// c()
-	map_input_filter_data_s::map_input_filter_data_s(void)
+	map_input_filter_data_s(void)
 	{	this->reset();
 	}
 
 	// Reset members
-	void map_input_filter_data_s::reset(void)
+	void reset(void)
 	{	r = y = g = c = b = m = 100.0f;
 		input_range[0]		= 0;
 		input_range[1]		= 1;
@@ -241,12 +251,12 @@ struct map_input_filter_data_s
 	}
 
 	// Setup values for default color to grayscale conversion
-	void map_input_filter_data_s::set_weights_for_convert_grayscale(void)
+	void set_weights_for_convert_grayscale(void)
 	{	r = 40.0f; y = 60.0f; g = 40.0f; c = 60.0f; b = 20.0f; m = 80.0f;
 	}
 
 	// Setup values for default color adjustment
-	void map_input_filter_data_s::set_weights_for_adjust_color(void)
+	void set_weights_for_adjust_color(void)
 	{	r = y = g = c = b = m = 100.0f;
 	}
 };
@@ -269,7 +279,7 @@ struct map_create_info_s
 																			// Color is (Red, Green, Blue, Alpha) in the range 0.0f - 1.0f. 
 																			// If the map is_normal_map == TRUE then the half floats will be (X, Y, Z, Alpha) where X, Y, and Z are in the range -1.0f to 1.0f and the Alpha is 0.0f - 1.0f. 																			
 	// c()
-	map_create_info_s::map_create_info_s(void)
+	map_create_info_s(void)
 	{
 		width									= 0;
 		height									= 0;
@@ -332,14 +342,14 @@ struct model_input_data_s
 	const unsigned int*							triangle_color_array;		// An array with 1 32 bit color per triangle. Will have index_count / 7 entries.
 
 	// c()
-	model_input_data_s::model_input_data_s(void)
+	model_input_data_s(void)
 	{	vertex_count = uv_count = index_count = subset_count = 0;
 		vertex_array = 0; uv_array = 0; tangent_array = 0; index_array = 0;
 		subset_lookup_table = 0; triangle_color_array = 0;
 	}
 
 	// Return if valid
-	BOOL model_input_data_s::is_valid(void) const
+	BOOL is_valid(void) const
 	{
 		if(vertex_count == 0 || uv_count == 0 || index_count == 0 || subset_count == 0)
 		{	return FALSE;
@@ -364,7 +374,7 @@ struct light_scan_input_data_s
 	const wchar_t*								image_filename_list[64];	// An array of image filenames
 
 	// c()
-	light_scan_input_data_s::light_scan_input_data_s(void)
+	light_scan_input_data_s(void)
 	{	start_angle_degree		= 0.0f;
 		directory_path			= 0;
 		image_count				= 0;
@@ -430,18 +440,18 @@ mp_get_option_udim_postfix_format_type			mp_get_option_udim_postfix_format = 0;
 // This should be called in "on_initialize()" between "mp_begin_initialize()" and "mp_end_initialize()"
 typedef void									(*mp_add_input_type)(const wchar_t* /*input_name*/, const wchar_t* /*input_description*/, int /*input_type*/, 
 																	 BOOL /*is_input_filter_grayscale*/, map_input_filter_data_s* /*default_input_filter_data*/);
-static mp_add_input_type						mp_add_input = 0;
+SMSDK_POINTER mp_add_input_type					mp_add_input = 0;
 
 // Define settings for an input filter used with a source map - Use only with maps that set is_using_input_filter to TRUE in the map_plugin_info_s.
 // Set a map_input_filter_data_s pointer or 0 (zero) for base default values.
 // This is only used with source maps.
 typedef void									(*mp_setup_source_input_filter_type)(BOOL /*is_input_filter_grayscale*/, map_input_filter_data_s* /*default_input_filter_data*/);
-static mp_setup_source_input_filter_type		mp_setup_source_input_filter = 0;
+SMSDK_POINTER mp_setup_source_input_filter_type	mp_setup_source_input_filter = 0;
 
 // Set the plugin info by passing a "filter_plugin_info_s" struct to ShaderMap.
 // This should be called in "on_initialize()" between "mp_begin_initialize()" and "mp_end_initialize()"
 typedef void									(*mp_set_plugin_info_type)(const map_plugin_info_s& /*plugin_info*/);
-static mp_set_plugin_info_type					mp_set_plugin_info = 0;
+SMSDK_POINTER mp_set_plugin_info_type			mp_set_plugin_info = 0;
 												
 // ** 
 // Functions to add property controls to the map - added in order called - first will have index of 0 (zero).
@@ -466,47 +476,47 @@ static mp_set_plugin_info_type					mp_set_plugin_info = 0;
 
 // The page list property (if used) must be the first property added, it defines the number of property pages - see above example.
 typedef void									(*mp_add_property_pagelist_type)(const wchar_t* /*caption*/, const wchar_t** /*string_array*/, unsigned int /*string_count*/, unsigned int /*cur_select*/);
-static mp_add_property_pagelist_type			mp_add_property_pagelist = 0;
+SMSDK_POINTER mp_add_property_pagelist_type		mp_add_property_pagelist = 0;
 
 // Add a file property. Set caption, an initial drive path, and extension filter. Allows the user to set a filepath control to the map.
 typedef void									(*mp_add_property_file_type)(const wchar_t* /*caption*/, const wchar_t* /*initial_path*/, const wchar_t* /*extension_filter_pointer*/, unsigned int /*page_index*/);
-static mp_add_property_file_type				mp_add_property_file = 0;
+SMSDK_POINTER mp_add_property_file_type			mp_add_property_file = 0;
 
 // Add a checkbox property. Set caption and initial check state.
 typedef void									(*mp_add_property_checkbox_type)(const wchar_t* /*caption*/, BOOL /*is_checked*/, unsigned int /*page_index*/);
-static mp_add_property_checkbox_type			mp_add_property_checkbox = 0;
+SMSDK_POINTER mp_add_property_checkbox_type		mp_add_property_checkbox = 0;
 
 // Add a list property. Set caption, string array and count, as well as initial selected item.
 typedef void									(*mp_add_property_list_type)(const wchar_t* /*caption*/, const wchar_t** /*string_array*/, unsigned int /*string_count*/, unsigned int /*cur_select*/, unsigned int /*page_index*/);
-static mp_add_property_list_type				mp_add_property_list = 0;
+SMSDK_POINTER mp_add_property_list_type			mp_add_property_list = 0;
 
 // Add integer numberbox property. Set the caption, min and max integers, and initial value.
 typedef void									(*mp_add_property_numberbox_int_type)(const wchar_t* /*caption*/, int /*min*/, int /*max*/, int /*value*/, unsigned int /*page_index*/);
-static mp_add_property_numberbox_int_type		mp_add_property_numberbox_int = 0;
+SMSDK_POINTER mp_add_property_numberbox_int_type	mp_add_property_numberbox_int = 0;
 
 // Add floating point numberbox property. Set the caption, min and max floats, and initial value.
 typedef void									(*mp_add_property_numberbox_float_type)(const wchar_t* /*caption*/, float /*min*/, float /*max*/, float /*value*/, unsigned int /*page_index*/);
-static mp_add_property_numberbox_float_type		mp_add_property_numberbox_float = 0;
+SMSDK_POINTER mp_add_property_numberbox_float_type	mp_add_property_numberbox_float = 0;
 
 // Add a colorbox property. Set the caption and initial color (use Windows RGB() macro).
 typedef void									(*mp_add_property_colorbox_type)(const wchar_t* /*caption*/, COLORREF /*color*/, unsigned int /*page_index*/);
-static mp_add_property_colorbox_type			mp_add_property_colorbox = 0;
+SMSDK_POINTER mp_add_property_colorbox_type		mp_add_property_colorbox = 0;
 
 // Add a slider property. Set the caption, min and max integers, initial position. Also can enable forced center to be at a set integer.
 // Forced center can be useful, for example, when the min is -10 and the max is 100 but you want the center to be 0.
 typedef void									(*mp_add_property_slider_type)(const wchar_t* /*caption*/, int /*min*/, int /*max*/, int /*position*/, unsigned int /*page_index*/, BOOL /*is_forced_center*/, int /*forced_center*/);
-static mp_add_property_slider_type				mp_add_property_slider = 0;
+SMSDK_POINTER mp_add_property_slider_type		mp_add_property_slider = 0;
 
 // Add a range slider property. Set the 3 optional captions, min and max integers, initial min and max position.
 typedef void									(*mp_add_property_range_slider_type)(const wchar_t* /*caption_low*/, const wchar_t* /*caption_mid*/, const wchar_t* /*caption_high*/,
 																					 int /*min*/, int /*max*/, int /*position_min*/, int /*position_max*/, unsigned int /*page_index*/);
-static mp_add_property_range_slider_type		mp_add_property_range_slider = 0;
+SMSDK_POINTER mp_add_property_range_slider_type	mp_add_property_range_slider = 0;
 
 // Add a coordinate system property. Set the caption and coordinate system.
 // The coordinate system should be defined by OR-ing 3 coordinate system defines found above in this file.
 // An example: (MAP_COORDSYS_X_POS_LEFT | MAP_COORDSYS_Y_POS_UP | MAP_COORDSYS_Z_POS_NEAR)
 typedef void									(*mp_add_property_coordsys_type)(const wchar_t* /*caption*/, unsigned int /*coordinate_system*/, unsigned int /*page_index*/);
-static mp_add_property_coordsys_type			mp_add_property_coordsys = 0;
+SMSDK_POINTER mp_add_property_coordsys_type		mp_add_property_coordsys = 0;
 
 
 // **
@@ -516,27 +526,27 @@ static mp_add_property_coordsys_type			mp_add_property_coordsys = 0;
 
 // Returns the source map width and height.
 typedef unsigned int							(*mp_get_source_width_type)(unsigned int /*map_id*/);
-static mp_get_source_width_type					mp_get_source_width = 0;
+SMSDK_POINTER mp_get_source_width_type			mp_get_source_width = 0;
 typedef unsigned int							(*mp_get_source_height_type)(unsigned int /*map_id*/);
-static mp_get_source_height_type				mp_get_source_height = 0;
+SMSDK_POINTER mp_get_source_height_type			mp_get_source_height = 0;
 
 // Determine if the source pixels are in grayscale format (2 half floats per pixel vs 4 half floats per pixel).
 typedef BOOL									(*mp_is_source_grayscale_type)(unsigned int /*map_id*/);
-static mp_is_source_grayscale_type				mp_is_source_grayscale = 0;
+SMSDK_POINTER mp_is_source_grayscale_type		mp_is_source_grayscale = 0;
 
 // Returns if source pixel channels are all in the range 0.0f - 1.0f.
 typedef BOOL									(*mp_is_source_rasterized_type)(unsigned int /*map_id*/);
-static mp_is_source_rasterized_type				mp_is_source_rasterized = 0;
+SMSDK_POINTER mp_is_source_rasterized_type		mp_is_source_rasterized = 0;
 
 // Returns if source pixels are in sRGB or linear color space
 typedef BOOL									(*mp_is_source_sRGB_type)(unsigned int /*map_id*/);
-static mp_is_source_sRGB_type					mp_is_source_sRGB = 0;	
+SMSDK_POINTER mp_is_source_sRGB_type			mp_is_source_sRGB = 0;	
 
 // Returns source pixels. 
 // Pixels are 4 channels (color images RGBA or vector maps XYZA) or 2 channel (grayscale CA) format 16 bit half float per channel.
 // Origin is always UPPER LEFT.
 typedef const void*								(*mp_get_source_pixel_array_type)(unsigned int /*map_id*/);
-static mp_get_source_pixel_array_type			mp_get_source_pixel_array = 0;
+SMSDK_POINTER mp_get_source_pixel_array_type	mp_get_source_pixel_array = 0;
 
 
 // **
@@ -547,36 +557,36 @@ static mp_get_source_pixel_array_type			mp_get_source_pixel_array = 0;
 
 // Returns an input id given the input index. This can be used to identify the map_id of an input map.
 typedef unsigned int							(*mp_get_input_id_type)(unsigned int /*map_id*/, unsigned int /*input_index*/);
-static mp_get_input_id_type						mp_get_input_id = 0;
+SMSDK_POINTER mp_get_input_id_type				mp_get_input_id = 0;
 
 // -- 
 // Map Type Input
 
 // Returns the Map input's width and height.
 typedef unsigned int							(*mp_get_input_width_type)(unsigned int /*map_id*/, unsigned int /*input_index*/);
-static mp_get_input_width_type					mp_get_input_width = 0;
+SMSDK_POINTER mp_get_input_width_type			mp_get_input_width = 0;
 typedef unsigned int							(*mp_get_input_height_type)(unsigned int /*map_id*/, unsigned int /*input_index*/);
-static mp_get_input_height_type					mp_get_input_height = 0;
+SMSDK_POINTER mp_get_input_height_type			mp_get_input_height = 0;
 typedef unsigned int							(*mp_get_input_coordsys_type)(unsigned int /*map_id*/, unsigned int /*input_index*/);
 
 // Returns the Map input's coordinate system. Useful if the input is supposed to be a normal map.
-static mp_get_input_coordsys_type				mp_get_input_coordsys = 0;
+SMSDK_POINTER mp_get_input_coordsys_type		mp_get_input_coordsys = 0;
 typedef unsigned int							(*mp_get_input_tile_type_type)(unsigned int /*map_id*/, unsigned int /*input_index*/);
-static mp_get_input_tile_type_type				mp_get_input_tile_type = 0;
+SMSDK_POINTER mp_get_input_tile_type_type		mp_get_input_tile_type = 0;
 
 // Returns if an Map input's pixels are in grayscale format (2 half floats per pixel vs 4 half floats per pixel).
 typedef BOOL									(*mp_is_input_grayscale_type)(unsigned int /*map_id*/, unsigned int /*input_index*/);
-static mp_is_input_grayscale_type				mp_is_input_grayscale = 0;
+SMSDK_POINTER mp_is_input_grayscale_type		mp_is_input_grayscale = 0;
 
 // Returns if Map input's pixels are in sRGB or linear color space.
 typedef BOOL									(*mp_is_input_sRGB_type)(unsigned int /*map_id*/, unsigned int /*input_index*/);
-static mp_is_input_sRGB_type					mp_is_input_sRGB = 0;	
+SMSDK_POINTER mp_is_input_sRGB_type				mp_is_input_sRGB = 0;	
 
 // Returns the Map input's pixels. 
 // Pixels are 4 channels (color images RGBA or vector maps XYZA) or 2 channel (grayscale CA) format 16 bit half float per channel.
 // Origin is always UPPER LEFT
 typedef const void*								(*mp_get_input_pixel_array_type)(unsigned int /*map_id*/, unsigned int /*input_index*/);
-static mp_get_input_pixel_array_type			mp_get_input_pixel_array = 0;
+SMSDK_POINTER mp_get_input_pixel_array_type		mp_get_input_pixel_array = 0;
 
 // --
 // 3D Model Type Input
@@ -584,25 +594,25 @@ static mp_get_input_pixel_array_type			mp_get_input_pixel_array = 0;
 // Fills the 3D Model type input data parameter. 
 // If is_cage == TRUE then the cage model data is returned else the base model data is set.
 typedef void									(*mp_get_input_model_type)(unsigned int /*map_id*/, unsigned int /*input_index*/, BOOL /*is_cage*/, model_input_data_s& /*model_data_out*/);
-static mp_get_input_model_type					mp_get_input_model = 0;
+SMSDK_POINTER mp_get_input_model_type			mp_get_input_model = 0;
 
 // Get a 3D Model input's subset list for a specific material id. subset_list_out must be an allocated array of at least subset_list_count_out. 
 // If subset_list_out is NULL then only subset_list_count_out is returned.
 // First call for getting the count, second for getting the list.
 // If the material_id_in_out is invalid then the material_id_in_out 0 is returned which contains all subsets of the model.
 typedef BOOL									(*mp_get_input_model_subset_list_type)(unsigned int /*map_id*/, unsigned int /*input_index*/, BOOL /*is_cage*/, unsigned int& /*material_id_in_out*/, unsigned int* /*subset_list_out*/, unsigned int* /*subset_list_count_out*/);
-static mp_get_input_model_subset_list_type		mp_get_input_model_subset_list = 0;	
+SMSDK_POINTER mp_get_input_model_subset_list_type	mp_get_input_model_subset_list = 0;	
 
 // Return if an input model has UVs loaded - used for error checking
 typedef BOOL									(*mp_is_input_model_uvs_type)(unsigned int /*map_id*/, unsigned int /*input_index*/, BOOL /*is_cage*/);
-static mp_is_input_model_uvs_type				mp_is_input_model_uvs = 0;
+SMSDK_POINTER mp_is_input_model_uvs_type		mp_is_input_model_uvs = 0;
 
 // --
 // Light Scan Type Input
 
 // Return a Light Scan input's data 
 typedef void									(*mp_get_input_light_scan_type)(unsigned int /*map_id*/, unsigned int /*input_index*/, light_scan_input_data_s& /*light_scan_data_out*/);
-static mp_get_input_light_scan_type				mp_get_input_light_scan = 0;
+SMSDK_POINTER mp_get_input_light_scan_type		mp_get_input_light_scan = 0;
 
 
 // --
@@ -610,18 +620,18 @@ static mp_get_input_light_scan_type				mp_get_input_light_scan = 0;
 
 // Return an input's input filter data as a parameter
 typedef void									(*mp_get_input_filter_data_type)(unsigned int /*map_id*/, unsigned int /*input_index*/, map_input_filter_data_s& /*input_filter_data_out*/);
-static mp_get_input_filter_data_type			mp_get_input_filter_data = 0;
+SMSDK_POINTER mp_get_input_filter_data_type		mp_get_input_filter_data = 0;
 
 // Return an source map's input filter data as a parameter - used only with source map type maps.
 typedef void									(*mp_get_source_input_filter_data_type)(unsigned int /*map_id*/, map_input_filter_data_s& /*input_filter_data_out*/);
-static mp_get_source_input_filter_data_type		mp_get_source_input_filter_data = 0;
+SMSDK_POINTER mp_get_source_input_filter_data_type	mp_get_source_input_filter_data = 0;
 
 // **
 // Functions for caching node data.
 
 // Return if caching is enabled in the ShaderMap options.
 typedef BOOL									(*mp_is_cache_enabled_type)(void);
-static mp_is_cache_enabled_type					mp_is_cache_enabled = 0;
+SMSDK_POINTER mp_is_cache_enabled_type			mp_is_cache_enabled = 0;
 
 // Register data to the node cache registry. Data should be input specific and use a unique name to identify it.
 // Registering data to the cache allows the read-only data to be shared across map plugins if they have access to the node id (input id).
@@ -631,13 +641,13 @@ static mp_is_cache_enabled_type					mp_is_cache_enabled = 0;
 // Use mp_get_input_id() for node_id of an input, or use map_id for node_id of current map.
 // data_size should be in bytes
 typedef BOOL									(*mp_register_node_cache_type)(unsigned int /*node_id*/, unsigned int /*cache_type*/, const wchar_t* /*cache_name*/, const void* /*data_pointer*/, unsigned long long /*data_size*/);
-static mp_register_node_cache_type				mp_register_node_cache = 0;
+SMSDK_POINTER mp_register_node_cache_type		mp_register_node_cache = 0;
 
 // Return a pointer to specific cached data that was stored with mp_register_node_cache.
 // Returns 0 if node_id is invalid or cache_name was not found.
 // Use this to check if data is already cached before registering it.
 typedef const void*								(*mp_get_node_cache_type)(unsigned int /*node_id*/, const wchar_t* /*cache_name*/);
-static mp_get_node_cache_type					mp_get_node_cache = 0;
+SMSDK_POINTER mp_get_node_cache_type			mp_get_node_cache = 0;
 
 
 // **
@@ -647,43 +657,43 @@ static mp_get_node_cache_type					mp_get_node_cache = 0;
 		
 // Get page list (if used) will always be at property index 0 (zero)
 typedef unsigned int							(*mp_get_property_pagelist_type)(unsigned int /*map_id*/, unsigned int /*property_index*/);
-static mp_get_property_pagelist_type			mp_get_property_pagelist = 0;
+SMSDK_POINTER mp_get_property_pagelist_type		mp_get_property_pagelist = 0;
 
 // Get a file path from a file property.
 typedef const wchar_t*							(*mp_get_property_file_type)(unsigned int /*map_id*/, unsigned int /*property_index*/);
-static mp_get_property_file_type				mp_get_property_file = 0;
+SMSDK_POINTER mp_get_property_file_type			mp_get_property_file = 0;
 
 // Get the state of a checkbox property.
 typedef BOOL									(*mp_get_property_checkbox_type)(unsigned int /*map_id*/, unsigned int /*property_index*/);
-static mp_get_property_checkbox_type			mp_get_property_checkbox = 0;
+SMSDK_POINTER mp_get_property_checkbox_type		mp_get_property_checkbox = 0;
 
 // Get the selected index of a list property.
 typedef unsigned int							(*mp_get_property_list_type)(unsigned int /*map_id*/, unsigned int /*property_index*/);
-static mp_get_property_list_type				mp_get_property_list = 0;
+SMSDK_POINTER mp_get_property_list_type			mp_get_property_list = 0;
 
 // Get the integer value of a numberbox property.
 typedef int										(*mp_get_property_numberbox_int_type)(unsigned int /*map_id*/, unsigned int /*property_index*/);
-static mp_get_property_numberbox_int_type		mp_get_property_numberbox_int = 0;
+SMSDK_POINTER mp_get_property_numberbox_int_type	mp_get_property_numberbox_int = 0;
 
 // Get the floating point value of a numberbox property.
 typedef float									(*mp_get_property_numberbox_float_type)(unsigned int /*map_id*/, unsigned int /*property_index*/);
-static mp_get_property_numberbox_float_type		mp_get_property_numberbox_float = 0;
+SMSDK_POINTER mp_get_property_numberbox_float_type	mp_get_property_numberbox_float = 0;
 
 // Get the color of a colorbox property.
 typedef COLORREF								(*mp_get_property_colorbox_type)(unsigned int /*map_id*/, unsigned int /*property_index*/);
-static mp_get_property_colorbox_type			mp_get_property_colorbox = 0;
+SMSDK_POINTER mp_get_property_colorbox_type		mp_get_property_colorbox = 0;
 
 // Get the integer position of a slider property.
 typedef int										(*mp_get_property_slider_type)(unsigned int /*map_id*/, unsigned int /*property_index*/);
-static mp_get_property_slider_type				mp_get_property_slider = 0;
+SMSDK_POINTER mp_get_property_slider_type		mp_get_property_slider = 0;
 
 // Get the integer positions of a range slider property as parameters.
 typedef void									(*mp_get_property_range_slider_type)(unsigned int /*map_id*/, unsigned int /*property_index*/, int& /*position_min_out*/, int& /*position_max_out*/);
-static mp_get_property_range_slider_type		mp_get_property_range_slider = 0;
+SMSDK_POINTER mp_get_property_range_slider_type	mp_get_property_range_slider = 0;
 
 // Get the coordinate system of a coordinate system property.
 typedef unsigned int							(*mp_get_property_coordsys_type)(unsigned int /*map_id*/, unsigned int /*property_index*/);
-static mp_get_property_coordsys_type			mp_get_property_coordsys = 0;
+SMSDK_POINTER mp_get_property_coordsys_type		mp_get_property_coordsys = 0;
 
 
 // **
@@ -693,35 +703,35 @@ static mp_get_property_coordsys_type			mp_get_property_coordsys = 0;
 
 // Set the state of a checkbox property.
 typedef void									(*mp_set_property_checkbox_type)(unsigned int /*map_id*/, unsigned int /*property_index*/, BOOL /*check_state*/);
-static mp_set_property_checkbox_type			mp_set_property_checkbox = 0;
+SMSDK_POINTER mp_set_property_checkbox_type		mp_set_property_checkbox = 0;
 
 // Set the selected index of a list property.
 typedef void									(*mp_set_property_list_type)(unsigned int /*map_id*/, unsigned int /*property_index*/, unsigned int /*cur_sel*/);
-static mp_set_property_list_type				mp_set_property_list = 0;
+SMSDK_POINTER mp_set_property_list_type			mp_set_property_list = 0;
 
 // Set an integer to a numberbox property.
 typedef void									(*mp_set_property_numberbox_int_type)(unsigned int /*map_id*/, unsigned int /*property_index*/, int /*value*/);
-static mp_set_property_numberbox_int_type		mp_set_property_numberbox_int = 0;
+SMSDK_POINTER mp_set_property_numberbox_int_type	mp_set_property_numberbox_int = 0;
 
 // Set a floating point value to a numberbox property.
 typedef void									(*mp_set_property_numberbox_float_type)(unsigned int /*map_id*/, unsigned int /*property_index*/, float /*value*/);
-static mp_set_property_numberbox_float_type		mp_set_property_numberbox_float = 0;
+SMSDK_POINTER mp_set_property_numberbox_float_type	mp_set_property_numberbox_float = 0;
 
 // Set a color to a colorbox property.
 typedef void									(*mp_set_property_colorbox_type)(unsigned int /*map_id*/, unsigned int /*property_index*/, COLORREF /*color*/);
-static mp_set_property_colorbox_type			mp_set_property_colorbox = 0;
+SMSDK_POINTER mp_set_property_colorbox_type		mp_set_property_colorbox = 0;
 
 // Set a position to a slider property.
 typedef void									(*mp_set_property_slider_type)(unsigned int /*map_id*/, unsigned int /*property_index*/, int /*position*/);
-static mp_set_property_slider_type				mp_set_property_slider = 0;
+SMSDK_POINTER mp_set_property_slider_type		mp_set_property_slider = 0;
 
 // Set a positions to a range slider property.
 typedef void									(*mp_set_property_range_slider_type)(unsigned int /*map_id*/, unsigned int /*property_index*/, int /*position_min*/, int /*position_max*/);
-static mp_set_property_range_slider_type		mp_set_property_range_slider = 0;
+SMSDK_POINTER mp_set_property_range_slider_type	mp_set_property_range_slider = 0;
 
 // Set a coordinate system to a coordinate system property.
 typedef void									(*mp_set_property_coordsys_type)(unsigned int /*map_id*/, unsigned int /*property_index*/, unsigned int /*coordsys*/);
-static mp_set_property_coordsys_type			mp_set_property_coordsys = 0;
+SMSDK_POINTER mp_set_property_coordsys_type		mp_set_property_coordsys = 0;
 
 
 // **
@@ -729,54 +739,54 @@ static mp_set_property_coordsys_type			mp_set_property_coordsys = 0;
 
 // Determine if map render has been canceled - check often.
 typedef BOOL									(*mp_is_cancel_process_type)(void);
-static mp_is_cancel_process_type				mp_is_cancel_process = 0;
+SMSDK_POINTER mp_is_cancel_process_type			mp_is_cancel_process = 0;
 
 // Set the progress of processing - at minimum should call once at start with 0 and once at end with 100.
 // Requires map id and a progress integer between 0-100.
 typedef void									(*mp_set_map_progress_type)(unsigned int /*map_id*/, unsigned int /*progress*/);
-static mp_set_map_progress_type					mp_set_map_progress = 0;
+SMSDK_POINTER mp_set_map_progress_type			mp_set_map_progress = 0;
 
 // Set the an animating progress of processing - The progress bar will be updated from min to max until the next call of mp_set_map_progress()
 // Requires map id and min and max progress integers between 0-100.
 typedef void									(*mp_set_map_progress_animation_type)(unsigned int /*map_id*/, unsigned int /*progress_min*/, unsigned int /*progress_max*/);
-static mp_set_map_progress_animation_type		mp_set_map_progress_animation = 0;
+SMSDK_POINTER mp_set_map_progress_animation_type	mp_set_map_progress_animation = 0;
 
 // Log a filter error to the ShaderMap log file located: "C:\Users\<USERNAME>\AppData\Roaming\SM3\log".
 // Use the "LOG_ERROR_MSG()" macro to simplify calling this function.
 typedef void									(*mp_log_map_error_type)(unsigned int /*map_id*/, const wchar_t* /*error_message*/, const wchar_t* /*function*/, const wchar_t* /*source_filepath*/, int /*source_line_number*/);
-static mp_log_map_error_type					mp_log_map_error = 0;
+SMSDK_POINTER mp_log_map_error_type				mp_log_map_error = 0;
 
 // Get the thread limit imposed by ShaderMap for map usage.
 typedef unsigned int							(*mp_get_map_thread_limit_type)(void);
-static mp_get_map_thread_limit_type				mp_get_map_thread_limit = 0;
+SMSDK_POINTER mp_get_map_thread_limit_type		mp_get_map_thread_limit = 0;
 
 // Set a status string which is displayed to the user in ShaderMap in the Map Preview section.
 typedef void									(*mp_set_map_status_type)(unsigned int /*map_id*/, wchar_t* /*status_string*/);
-static mp_set_map_status_type					mp_set_map_status = 0;
+SMSDK_POINTER mp_set_map_status_type			mp_set_map_status = 0;
 
 // Get the map's mask data. Requires map id, and returns, as parameters, the width and height of the mask as well as a pixel array with the mask data.
 // pixel_array_out must be allocated by the plugin and be of at least size: sizof(unsigned short) * with * height.
 // pixel_array_out can be set to 0 and only the width and height are returned. In this way the developer can determine the size of the pixel array to allocate before making the second call.
 // Masks are single channel images. Each unsigned short represents a single pixel value. The origin of the Mask image is UPPER LEFT
 typedef void									(*mp_get_map_mask_type)(unsigned int /*map_id*/, unsigned int& /*width_out*/, unsigned int& /*height_out*/, unsigned short** /*pixel_array_out*/);
-static mp_get_map_mask_type						mp_get_map_mask = 0;
+SMSDK_POINTER mp_get_map_mask_type				mp_get_map_mask = 0;
 
 // Get / Set map output filename. The plugin can modify the filename if one exists. "mp_get_map_output_filename()" can return NULL (0) which means the output filename is not set.
 // "mp_set_map_output_filename()" should not be called if "mp_get_map_output_filename()" returns 0.
 typedef const wchar_t*							(*mp_get_map_output_filename_type)(unsigned int /*map_id*/);
-static mp_get_map_output_filename_type			mp_get_map_output_filename = 0;
+SMSDK_POINTER mp_get_map_output_filename_type	mp_get_map_output_filename = 0;
 typedef void									(*mp_set_map_output_filename_type)(unsigned int /*map_id*/, const wchar_t* /*new_filename*/);
-static mp_set_map_output_filename_type			mp_set_map_output_filename = 0;
+SMSDK_POINTER mp_set_map_output_filename_type	mp_set_map_output_filename = 0;
 
 // Create the final map. Map info is defined by settings in the "map_create_info_s" struct.
 // If pixel_array_out is set then it will return a pointer to the map pixel data created. This is useful when you want to create the map at start of processing and
 // use "mp_update_map_region()" to show a realtime progress of image creation. All maps from 3d model plugins that ship with ShaderMap use this method.
 typedef BOOL									(*mp_create_map_type)(unsigned int /*map_id*/, const map_create_info_s& /*create_info*/, void** /*pixel_array_out*/);
-static mp_create_map_type						mp_create_map = 0;
+SMSDK_POINTER mp_create_map_type				mp_create_map = 0;
 
 // Update the map pixels, created with "mp_create_map()", to the display textures in ShaderMap. Takes a RECT region on the image.
 typedef void									(*mp_update_map_region_type)(unsigned int /*map_id*/, const RECT& /*region*/);
-static mp_update_map_region_type				mp_update_map_region = 0;
+SMSDK_POINTER mp_update_map_region_type			mp_update_map_region = 0;
 
 
 // ------------------------------------------------------------------
@@ -858,7 +868,14 @@ void											on_node_cache_clear_single(const void* data_pointer);
 // "plugin_process()", "plugin_shutdown()", and "plugin_custom_0()" each call the user defined "on_process()", "on_shutdown()", and "on_arrange_load_data()" functions.
 // "plugin_custom_1()", "plugin_custom_2()", and "plugin_custom_3()" each call the user defined "on_input_id_change()", "on_input_cache_clear()", and "on_node_cache_clear_single()" functions.
 
+#ifdef _WIN32
 #define DLL_EXPORT								__declspec(dllexport)
+#else
+#define DLL_EXPORT								__attribute__((visibility("default")))		// Linux shared object build - see "host/compat/windows.h".
+#endif
+
+// A host that includes this file for the structs and function types defines SMSDK_HOST so the plugin exports are left out.
+#ifndef SMSDK_HOST
 
 extern "C" {
 
@@ -1004,4 +1021,6 @@ extern "C" {
 	{	on_node_cache_clear_single((const void*)param_0);
 		return TRUE;
 	}
-}
\ No newline at end of file
+}
+
+#endif // SMSDK_HOST